@@ -11,11 +11,19 @@
 #ifndef CODELIBRARY_BASE_BITS_H_
 #define CODELIBRARY_BASE_BITS_H_
 
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 
 #include "codelibrary/base/log.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 namespace cl {
 namespace bits {
 
@@ -116,6 +124,96 @@ inline int CountOnes(uint8_t n) {
 
     return table[n >> 4] + table[n & 0x0F];
 }
+inline int CountOnes(uint32_t n) {
+#if defined(__GNUC__)
+    return __builtin_popcount(n);
+#else
+    n -= (n >> 1) & 0x55555555U;
+    n  = (n & 0x33333333U) + ((n >> 2) & 0x33333333U);
+    n  = (n + (n >> 4)) & 0x0F0F0F0FU;
+    return static_cast<int>((n * 0x01010101U) >> 24);
+#endif
+}
+inline int CountOnes(uint64_t n) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(n);
+#else
+    n -= (n >> 1) & 0x5555555555555555ULL;
+    n  = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+    n  = (n + (n >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((n * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * Return the number of trailing zero bits of 'n', i.e., the index of its
+ * lowest set bit. 'n' must not be zero.
+ */
+inline int CountTrailingZeros(uint64_t n) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(n);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, n);
+    return static_cast<int>(index);
+#else
+    int count = 0;
+    while ((n & 1) == 0) {
+        n >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Return the number of leading zero bits of 'n', i.e., 63 minus the index of
+ * its highest set bit. 'n' must not be zero.
+ */
+inline int CountLeadingZeros(uint64_t n) {
+#if defined(__GNUC__)
+    return __builtin_clzll(n);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, n);
+    return 63 - static_cast<int>(index);
+#else
+    int count = 0;
+    while ((n >> 63) == 0) {
+        n <<= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Return the position of the k-th (0-based) set bit of 'n'. 'n' must have
+ * more than k set bits.
+ */
+inline int SelectBit(uint64_t n, int k) {
+#if defined(__BMI2__)
+    return CountTrailingZeros(_pdep_u64(uint64_t(1) << k, n));
+#else
+    // Find the byte by the prefix sums of the byte counts, then the bit.
+    uint64_t s = n - ((n >> 1) & 0x5555555555555555ULL);
+    s = (s & 0x3333333333333333ULL) + ((s >> 2) & 0x3333333333333333ULL);
+    s = (s + (s >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    s *= 0x0101010101010101ULL;
+
+    int shift = 0;
+    while (static_cast<int>((s >> shift) & 0xFF) <= k) {
+        shift += 8;
+    }
+    if (shift > 0) k -= static_cast<int>((s >> (shift - 8)) & 0xFF);
+
+    uint64_t byte = (n >> shift) & 0xFF;
+    for (; k > 0; --k) {
+        byte &= byte - 1;
+    }
+    return shift + CountTrailingZeros(byte);
+#endif
+}
 
 } // namespace bits
 } // namespace cl
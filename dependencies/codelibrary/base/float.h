@@ -10,6 +10,7 @@
 #define CODELIBRARY_BASE_FLOAT_H_
 
 #include <cstdint>
+#include <cstring>
 #include <numeric>
 
 namespace cl {
@@ -83,6 +84,97 @@ private:
     Float64 u_;
 };
 
+/**
+ * IEEE 754 half precision (binary16) storage type.
+ *
+ * It only stores and converts values; arithmetic should be done in float. The
+ * layout is the same as CUDA's __half, so arrays of Half can be uploaded to the
+ * device directly.
+ */
+class Half {
+public:
+    Half() = default;
+
+    /**
+     * Convert from float, rounding to nearest even. Values that are too large
+     * become infinity.
+     */
+    explicit Half(float x) {
+        const uint32_t f16_max = (127 + 16) << 23;
+        const uint32_t f32_inf = 255 << 23;
+        // Adding this constant aligns the subnormal half mantissa to the low
+        // bits of the float mantissa, and lets the FPU do the rounding.
+        const uint32_t denorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+        uint32_t u;
+        std::memcpy(&u, &x, sizeof(u));
+        const uint32_t sign = (u >> 16) & 0x8000;
+        u &= 0x7FFFFFFF;
+
+        uint32_t h;
+        if (u >= f16_max) {
+            // Overflow, infinity or NaN.
+            h = u > f32_inf ? 0x7E00 : 0x7C00;
+        } else if (u < (113 << 23)) {
+            // Subnormal or zero.
+            float f, magic;
+            std::memcpy(&f, &u, sizeof(f));
+            std::memcpy(&magic, &denorm_magic, sizeof(magic));
+            f += magic;
+            std::memcpy(&u, &f, sizeof(u));
+            h = u - denorm_magic;
+        } else {
+            const uint32_t mantissa_odd = (u >> 13) & 1;
+            // Rebias the exponent from 127 to 15, and round to nearest even.
+            u -= 112u << 23;
+            u += 0xFFF + mantissa_odd;
+            h = u >> 13;
+        }
+        bits_ = static_cast<uint16_t>(h | sign);
+    }
+
+    explicit operator float() const {
+        const uint32_t sign = static_cast<uint32_t>(bits_ & 0x8000) << 16;
+        const uint32_t exponent = (bits_ >> 10) & 0x1F;
+        const uint32_t mantissa = bits_ & 0x3FF;
+
+        uint32_t u;
+        if (exponent == 0) {
+            // Subnormal or zero: mantissa * 2^-24.
+            float f = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+            std::memcpy(&u, &f, sizeof(u));
+            u |= sign;
+        } else if (exponent == 31) {
+            u = sign | 0x7F800000 | (mantissa << 13);
+        } else {
+            u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+
+    /**
+     * Construct from the raw binary16 bits.
+     */
+    static Half FromBits(uint16_t bits) {
+        Half h;
+        h.bits_ = bits;
+        return h;
+    }
+
+    /**
+     * Return the raw binary16 bits.
+     */
+    uint16_t bits() const {
+        return bits_;
+    }
+
+private:
+    uint16_t bits_ = 0;
+};
+
 } // namespace cl
 
 #endif // CODELIBRARY_BASE_FLOAT_H_
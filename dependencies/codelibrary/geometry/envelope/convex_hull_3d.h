@@ -9,10 +9,15 @@
 #ifndef CODELIBRARY_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_H_
 #define CODELIBRARY_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_H_
 
+#include <algorithm>
+#include <array>
 #include <cfloat>
+#include <cmath>
+#include <cstdint>
 #include <queue>
 
 #include "codelibrary/base/array.h"
+#include "codelibrary/geometry/envelope/convex_hull_2d.h"
 #include "codelibrary/geometry/mesh/halfedge_list.h"
 #include "codelibrary/geometry/predicate_2d.h"
 #include "codelibrary/geometry/predicate_3d.h"
@@ -23,11 +28,28 @@ namespace geometry {
 /**
  * 3D convex hull.
  *
- * This class adopts quickhull algorithm of Barber et al.
+ * This class adopts quickhull algorithm of Barber et al. All visibility tests
+ * use the exact Orientation() predicate, so the hull is correct for
+ * degenerate inputs, e.g., many coplanar or duplicated points: every point is
+ * on or below every face. Coplanar faces are not merged, so for such inputs a
+ * point on a hull face or edge can still be a vertex of the triangulation
+ * (this is more likely after Insert()). If all points are coplanar, the hull
+ * is empty.
+ *
+ * Before the quickhull, the points strictly inside the polytope of the
+ * extreme points along 13 directions are discarded (Akl-Toussaint
+ * heuristic). The filter and the assignment of points to the outside sets of
+ * new faces run in parallel.
+ *
+ * Points can be added in batches by Insert(), and the hulls of two point sets
+ * (e.g., two adjacent chunks of a point cloud) can be merged by Merge(),
+ * which only uses the hull vertices.
  *
  * Reference:
  *   Barber C B, Dobkin D P, Huhdanpaa H. The quickhull algorithm for convex
  *   hulls [J]. ACM Transactions on Mathematical Software, 1996, 22(4): 469-483.
+ *   Akl S G, Toussaint G T. A fast convex hull algorithm [J]. Information
+ *   Processing Letters, 1978, 7(5): 219-222.
  */
 template <typename T>
 class ConvexHull3D {
@@ -45,19 +67,25 @@ class ConvexHull3D {
 
     using FaceList = IndexedList<BaseFace>;
 
+    // Inputs with at most this number of points are not filtered.
+    static const int MIN_FILTER_SIZE = 256;
+
+    // Point sets larger than this are processed in parallel.
+    static const int MIN_PARALLEL_SIZE = 4096;
+
+    // Insert() rebuilds the hull if the number of new points times the number
+    // of faces exceeds this factor times their sum.
+    static const int MAX_INSERT_COST = 32;
+
 public:
     using Face = typename FaceList::Node;
 
     ConvexHull3D() {
-        face_ = mesh_.AddHalfedgeProperty("face", (Face*)nullptr);
-        outside_sets_ = faces_.AddProperty("outside_sets", Array<int>());
-        farthest_point_ = faces_.AddProperty("farthest_point", -1);
+        InitializeProperties();
     }
 
     explicit ConvexHull3D(const Array<Point3D<T>>& points) {
-        face_ = mesh_.AddHalfedgeProperty("face", (Face*)nullptr);
-        outside_sets_ = faces_.AddProperty("outside_sets", Array<int>());
-        farthest_point_ = faces_.AddProperty("farthest_point", -1);
+        InitializeProperties();
 
         Reset(points);
     }
@@ -67,18 +95,90 @@ public:
      */
     void Reset(const Array<Point3D<T>>& points) {
         this->clear();
-        points_ = points;
+        if (points.size() > MIN_FILTER_SIZE) {
+            AklToussaintFilter(points, &points_);
+        } else {
+            points_ = points;
+        }
         Build();
     }
 
+    /**
+     * Add a batch of points to the convex hull.
+     *
+     * The new points are assigned to the faces they see, and the hull is
+     * expanded from there. This tests each point against up to all faces, so
+     * unless the batch is small compared to the hull, the hull is rebuilt
+     * from its vertices and the batch instead.
+     */
+    void Insert(const Array<Point3D<T>>& points) {
+        if (points.empty()) return;
+
+        const int64_t m = points.size(), n_faces = faces_.n_available();
+        if (this->empty() || m * n_faces > MAX_INSERT_COST * (m + n_faces)) {
+            // If there is no hull yet (less than four points, or all points
+            // coplanar), all points are kept.
+            Array<Point> all;
+            if (this->empty()) {
+                all = points_;
+            } else {
+                GetVertices(&all);
+            }
+            all.insert(points.begin(), points.end());
+            Reset(all);
+            return;
+        }
+
+        int first = points_.size();
+        points_.insert(points.begin(), points.end());
+
+        Array<int> indices(points.size());
+        for (int i = 0; i < indices.size(); ++i) {
+            indices[i] = first + i;
+        }
+        Array<Face*> faces(faces_.nodes());
+        ComputeOutsideSets(faces, indices);
+        Expand();
+    }
+
+    /**
+     * Merge the convex hull of another point set into this hull. Only the
+     * hull vertices of both hulls are used.
+     */
+    void Merge(const ConvexHull3D& hull) {
+        Array<Point> points;
+        GetVertices(&points);
+        Array<Point> points1;
+        hull.GetVertices(&points1);
+        if (hull.empty()) points1 = hull.points_;
+        if (this->empty()) points = points_;
+        points.insert(points1.begin(), points1.end());
+        Reset(points);
+    }
+
+    /**
+     * Get the vertices of the convex hull.
+     */
+    void GetVertices(Array<Point>* vertices) const {
+        CHECK(vertices);
+
+        vertices->clear();
+        vertices->reserve(mesh_.n_vertices());
+        for (const Vertex* v : mesh_.vertices()) {
+            vertices->push_back(v->point());
+        }
+    }
+
     void clear() {
         points_.clear();
         mesh_.clear();
         faces_.clear();
+        available_faces_ = std::queue<Face*>();
+        stamp_ = 0;
     }
 
     bool empty() const {
-        return faces_.empty();
+        return faces_.n_available() == 0;
     }
 
     const Mesh& mesh() const {
@@ -90,12 +190,123 @@ public:
     }
 
 private:
+    void InitializeProperties() {
+        face_ = mesh_.AddHalfedgeProperty("face", (Face*)nullptr);
+        outside_sets_ = faces_.AddProperty("outside_sets", Array<int>());
+        farthest_point_ = faces_.AddProperty("farthest_point", -1);
+        visible_ = faces_.AddProperty("visible", 0);
+    }
+
+    /**
+     * Keep only the points that are not strictly inside the convex hull of
+     * the extreme points along the axes and the diagonals.
+     */
+    void AklToussaintFilter(const Array<Point>& points,
+                            Array<Point>* result) const {
+        const int n_directions = 13;
+        const int directions[n_directions][3] = {
+            {1, 0, 0},  {0, 1, 0},  {0, 0, 1},  {1, 1, 0},  {1, -1, 0},
+            {1, 0, 1},  {1, 0, -1}, {0, 1, 1},  {0, 1, -1}, {1, 1, 1},
+            {1, 1, -1}, {1, -1, 1}, {-1, 1, 1}
+        };
+
+        // Indices of the minimal and maximal points along each direction.
+        int extremes[2 * n_directions];
+        for (int& e : extremes) {
+            e = 0;
+        }
+        auto projection = [&](int i, int d) {
+            const Point& p = points[i];
+            return directions[d][0] * static_cast<double>(p.x) +
+                   directions[d][1] * static_cast<double>(p.y) +
+                   directions[d][2] * static_cast<double>(p.z);
+        };
+        for (int i = 1; i < points.size(); ++i) {
+            for (int d = 0; d < n_directions; ++d) {
+                double t = projection(i, d);
+                if (t < projection(extremes[2 * d], d)) extremes[2 * d] = i;
+                if (t > projection(extremes[2 * d + 1], d)) {
+                    extremes[2 * d + 1] = i;
+                }
+            }
+        }
+
+        Array<Point> extreme_points;
+        for (int e : extremes) {
+            extreme_points.push_back(points[e]);
+        }
+        ConvexHull3D<T> hull(extreme_points);
+        if (hull.empty()) {
+            *result = points;
+            return;
+        }
+
+        // Plane of each face, relative to the origin o: a * x + b * y + c * z
+        // + d, positive above. A point is discarded only if it is below every
+        // plane by more than the rounding error bound, so the filter never
+        // drops a hull vertex.
+        const double ox = extreme_points[0].x;
+        const double oy = extreme_points[0].y;
+        const double oz = extreme_points[0].z;
+        double extent = 0.0;
+        for (const Point& p : extreme_points) {
+            extent = std::max(extent, std::fabs(p.x - ox));
+            extent = std::max(extent, std::fabs(p.y - oy));
+            extent = std::max(extent, std::fabs(p.z - oz));
+        }
+        const double eps = 1e-12 * extent * extent * extent;
+
+        Array<std::array<double, 4>> planes;
+        for (const Face* face : hull.faces()) {
+            const Halfedge* e = face->halfedge;
+            const Point& p1 = e->source_point();
+            const Point& p2 = e->target_point();
+            const Point& p3 = e->next()->target_point();
+            double x1 = p1.x - ox, y1 = p1.y - oy, z1 = p1.z - oz;
+            double ux = p2.x - ox - x1, uy = p2.y - oy - y1;
+            double uz = p2.z - oz - z1;
+            double vx = p3.x - ox - x1, vy = p3.y - oy - y1;
+            double vz = p3.z - oz - z1;
+            double a = uy * vz - uz * vy;
+            double b = uz * vx - ux * vz;
+            double c = ux * vy - uy * vx;
+            double d = -(a * x1 + b * y1 + c * z1);
+            planes.push_back({a, b, c, d});
+        }
+
+        const int n = points.size();
+        Array<char> keep(n);
+        #pragma omp parallel for if (n > MIN_PARALLEL_SIZE)
+        for (int i = 0; i < n; ++i) {
+            double x = points[i].x - ox;
+            double y = points[i].y - oy;
+            double z = points[i].z - oz;
+            keep[i] = 0;
+            for (const std::array<double, 4>& plane : planes) {
+                double t = plane[0] * x + plane[1] * y + plane[2] * z +
+                           plane[3];
+                if (t >= -eps) {
+                    keep[i] = 1;
+                    break;
+                }
+            }
+        }
+
+        result->clear();
+        for (int i = 0; i < n; ++i) {
+            if (keep[i]) result->push_back(points[i]);
+        }
+    }
+
     /**
      * Building convex hull.
      */
     void Build() {
         // Initialize a initial tetrahedron.
-        if (!InitializeTetrahedron()) return;
+        if (!InitializeTetrahedron()) {
+            ReduceCoplanarPoints();
+            return;
+        }
 
         // Initialize outside sets for faces.
         Array<int> indices(points_.size());
@@ -105,6 +316,68 @@ private:
 
         Array<Face*> faces(faces_.begin(), faces_.end());
         ComputeOutsideSets(faces, indices);
+        Expand();
+    }
+
+    /**
+     * Keep only the extreme points of coplanar points, so that a hull that is
+     * still empty does not keep all points inserted so far.
+     */
+    void ReduceCoplanarPoints() {
+        if (points_.size() < 3) return;
+
+        // The projection to a coordinate plane is one-to-one if the 2D hull
+        // is not degenerate.
+        Array<Point2D<T>> projections(points_.size());
+        for (int k = 0; k < 3; ++k) {
+            for (int i = 0; i < points_.size(); ++i) {
+                const Point& p = points_[i];
+                projections[i] = k == 0 ? Point2D<T>(p.x, p.y)
+                               : k == 1 ? Point2D<T>(p.y, p.z)
+                                        : Point2D<T>(p.z, p.x);
+            }
+            ConvexHull2D<T> hull(projections);
+            if (hull.vertices().size() < 3) continue;
+
+            Array<Point2D<T>> vertices = hull.vertices();
+            std::sort(vertices.begin(), vertices.end());
+            Array<char> used(vertices.size(), 0);
+            Array<Point> points;
+            for (int i = 0; i < points_.size(); ++i) {
+                int j = std::lower_bound(vertices.begin(), vertices.end(),
+                                         projections[i]) - vertices.begin();
+                if (j < vertices.size() && vertices[j] == projections[i] &&
+                    !used[j]) {
+                    used[j] = 1;
+                    points.push_back(points_[i]);
+                }
+            }
+            points_.swap(points);
+            return;
+        }
+
+        // All points are collinear, keep the two end points.
+        int a = 0, b = 0;
+        for (int i = 1; i < points_.size(); ++i) {
+            if (points_[i] < points_[a]) a = i;
+            if (points_[b] < points_[i]) b = i;
+        }
+        Array<Point> points;
+        points.push_back(points_[a]);
+        if (points_[b] != points_[a]) points.push_back(points_[b]);
+        points_.swap(points);
+    }
+
+    /**
+     * Add the farthest outside points until all outside sets are empty.
+     */
+    void Expand() {
+        Array<Face*> visible_faces;
+        Array<int> outside_set;
+        Array<Halfedge*> delete_edges;
+        Array<Halfedge*> boundary;
+        Array<Halfedge*> edges;
+        Array<Face*> new_faces;
 
         while (!available_faces_.empty()) {
             Face* cur_face = available_faces_.front();
@@ -119,18 +392,28 @@ private:
             // Find visible faces from point 'p'.
             int farthest = farthest_point_[cur_face];
             const Point& p = points_[farthest];
-            Array<Face*> visible_faces;
             FindVisibleFaces(cur_face, p, &visible_faces);
 
-            Array<int> outside_set;
+            // A halfedge of a visible face whose twin face is not visible is
+            // on the horizon.
+            Halfedge* start = nullptr;
+            outside_set.clear();
             for (Face* face : visible_faces) {
-                for (int v : outside_sets_[face]) {
-                    outside_set.push_back(v);
+                // 'p' becomes a vertex, skip it.
+                for (int i : outside_sets_[face]) {
+                    if (i != farthest) outside_set.push_back(i);
+                }
+
+                for (Halfedge* e : mesh_.circular_list(face->halfedge)) {
+                    if (visible_[face_[e->twin()]] != stamp_) {
+                        start = e;
+                    }
                 }
             }
+            CHECK(start);
 
             // Remove the visible faces.
-            Array<Halfedge*> delete_edges;
+            delete_edges.clear();
             for (Face* face : visible_faces) {
                 Halfedge* e = face->halfedge;
 
@@ -149,31 +432,22 @@ private:
                 mesh_.EraseEdge(e);
             }
 
-            // Compute boundary halfedges.
-            Halfedge* start = nullptr;
-            for (Halfedge* e : mesh_) {
-                if (!face_[e]) {
-                    start = e;
-                    break;
-                }
-            }
-            CHECK(start);
-
-            Array<Halfedge*> boundary;
+            // The horizon halfedges form the boundary of the hole.
+            boundary.clear();
             for (Halfedge* e : mesh_.circular_list(start)) {
                 boundary.push_back(e);
             }
 
             // Add new faces.
             Vertex* v = mesh_.AddVertex(p);
-            Array<Halfedge*> edges(boundary.size() * 2);
+            edges.resize(boundary.size() * 2);
             for (int i = 0; i < boundary.size(); ++i) {
                 Halfedge* e = mesh_.AddEdge(boundary[i]->source(), v);
                 edges[i << 1] = e;
                 edges[(i << 1) + 1] = e->twin();
             }
 
-            Array<Face*> new_faces;
+            new_faces.clear();
             for (int i = 0; i < boundary.size(); ++i) {
                 int next = i + 1 < boundary.size() ? i + 1 : 0;
                 Face* face = InsertTriangle(boundary[i], edges[next << 1],
@@ -186,64 +460,93 @@ private:
         }
 
         // Remove useless vertices.
+        Array<Vertex*> isolated_vertices;
         for (Vertex* v : mesh_.vertices()) {
-            if (v->is_isolated()) {
-                mesh_.EraseVertex(v);
-            }
+            if (v->is_isolated()) isolated_vertices.push_back(v);
+        }
+        for (Vertex* v : isolated_vertices) {
+            mesh_.EraseVertex(v);
         }
     }
 
     /**
      * Initialize a tetrahedron.
      *
+     * The four points are hull vertices: the lexicographically smallest and
+     * largest points, the farthest point from the line through them, and the
+     * farthest point from the plane through the three. Ties are broken by the
+     * lexicographical order, so that points in the middle of a hull edge or
+     * face are never chosen.
+     *
      * Return false if all points are on the same plane.
      */
     bool InitializeTetrahedron() {
         // The size of points must at least 4.
         if (points_.size() < 4) return false;
 
-        int a = 0, b = -1, c = -1;
+        int a = 0, b = 0;
         for (int i = 1; i < points_.size(); ++i) {
-            if (points_[a].x != points_[i].x || points_[a].y != points_[i].y) {
-                b = i;
-                break;
-            }
+            if (points_[i] < points_[a]) a = i;
+            if (points_[b] < points_[i]) b = i;
         }
 
-        // All the points are the same in X and Y coordinates.
-        if (b == -1) return false;
-
+        // All the points are the same.
+        if (points_[a] == points_[b]) return false;
+
+        // Find the farthest point away from the line ab.
+        const Point& pa = points_[a];
+        const Point& pb = points_[b];
+        double ux = static_cast<double>(pb.x) - pa.x;
+        double uy = static_cast<double>(pb.y) - pa.y;
+        double uz = static_cast<double>(pb.z) - pa.z;
+        double max_area = 0.0;
+        int c = -1;
         for (int i = 0; i < points_.size(); ++i) {
-            if (i == a || i == b) continue;
-
-            Point2D<T> p1(points_[a].x, points_[a].y);
-            Point2D<T> p2(points_[b].x, points_[b].y);
-            Point2D<T> p3(points_[i].x, points_[i].y);
+            const Point& p = points_[i];
+
+            // Three points are collinear if and only if their projections on
+            // the three coordinate planes are collinear.
+            if (Orientation(Point2D<T>(pa.x, pa.y), Point2D<T>(pb.x, pb.y),
+                            Point2D<T>(p.x, p.y)) == 0 &&
+                Orientation(Point2D<T>(pa.y, pa.z), Point2D<T>(pb.y, pb.z),
+                            Point2D<T>(p.y, p.z)) == 0 &&
+                Orientation(Point2D<T>(pa.z, pa.x), Point2D<T>(pb.z, pb.x),
+                            Point2D<T>(p.z, p.x)) == 0) {
+                continue;
+            }
 
-            int o = Orientation(p1, p2, p3);
-            if (o != 0) {
+            double vx = static_cast<double>(p.x) - pa.x;
+            double vy = static_cast<double>(p.y) - pa.y;
+            double vz = static_cast<double>(p.z) - pa.z;
+            double nx = uy * vz - uz * vy;
+            double ny = uz * vx - ux * vz;
+            double nz = ux * vy - uy * vx;
+            double area = nx * nx + ny * ny + nz * nz;
+            if (c == -1 || area > max_area ||
+                (area == max_area && p < points_[c])) {
+                max_area = area;
                 c = i;
-                break;
             }
         }
 
-        // All the points are coplanar.
+        // All the points are collinear.
         if (c == -1) return false;
 
-        // Find the farthest point away from the plane defined by a, b, c.
+        // Find the farthest point away from the plane defined by a, b, c. The
+        // side is decided by the exact predicate, not by the distance.
         double max_dis = 0.0;
-        int d = -1;
+        int d = -1, side = 0;
         for (int i = 0; i < points_.size(); ++i) {
-            if (i == a || i == b || i == c) continue;
-
             int o = Orientation(points_[a], points_[b], points_[c], points_[i]);
-            if (o != 0) {
-                double dis = SignedDistance(points_[a], points_[b], points_[c],
-                                            points_[i]);
-                if (std::fabs(dis) > std::fabs(max_dis)) {
-                    max_dis = dis;
-                    d = i;
-                }
+            if (o == 0) continue;
+
+            double dis = std::fabs(SignedDistance(points_[a], points_[b],
+                                                  points_[c], points_[i]));
+            if (d == -1 || dis > max_dis ||
+                (dis == max_dis && points_[i] < points_[d])) {
+                max_dis = dis;
+                d = i;
+                side = o;
             }
         }
 
@@ -262,88 +565,93 @@ private:
                 edges[j][i] = edges[i][j]->twin();
             }
         }
-        if (max_dis > 0) {
+        if (side > 0) {
             InsertTriangle(edges[2][1], edges[1][0], edges[0][2]);
             InsertTriangle(edges[0][1], edges[1][3], edges[3][0]);
             InsertTriangle(edges[1][2], edges[2][3], edges[3][1]);
             InsertTriangle(edges[2][0], edges[0][3], edges[3][2]);
-        }  else if (max_dis < 0) {
+        } else {
             InsertTriangle(edges[0][1], edges[1][2], edges[2][0]);
             InsertTriangle(edges[2][1], edges[1][3], edges[3][2]);
             InsertTriangle(edges[1][0], edges[0][3], edges[3][1]);
             InsertTriangle(edges[0][2], edges[2][3], edges[3][0]);
-        } else {
-            // The maximum distance from point to the plane is zero.
-            return false;
         }
 
         return true;
     }
 
     /**
-     * Compute the outside sets for the given faces.
+     * Compute the outside sets for the given faces. Each point is assigned to
+     * the first face that it lies above.
      */
     void ComputeOutsideSets(const Array<Face*>& faces,
-                            const Array<int>& sequences) {
-        Array<int> indices(sequences);
-
-        for (Face* face : faces) {
-            int farthest = -1;
-            double dis_max = -DBL_MAX;
-            Array<int> outside_set;
-            for (int j = 0; j < indices.size(); ) {
-                const Point& p = points_[indices[j]];
-
-                int o = FaceOrientation(p, face);
-                if (o > 0) {
-                    double dis = SignedDistance(p, face);
-                    outside_set.push_back(indices[j]);
-                    if (dis > dis_max) {
-                        dis_max = dis;
-                        farthest = indices[j];
-                    }
-                    indices[j] = indices.back();
-                    indices.pop_back();
-                } else {
-                    ++j;
+                            const Array<int>& indices) {
+        const int n = indices.size();
+        Array<int> assignment(n);
+        Array<double> distances(n);
+        #pragma omp parallel for if (n > MIN_PARALLEL_SIZE)
+        for (int j = 0; j < n; ++j) {
+            const Point& p = points_[indices[j]];
+            assignment[j] = -1;
+            for (int k = 0; k < faces.size(); ++k) {
+                if (FaceOrientation(p, faces[k]) > 0) {
+                    assignment[j] = k;
+                    distances[j] = SignedDistance(p, faces[k]);
+                    break;
                 }
             }
+        }
+
+        Array<double> dis_max(faces.size(), -DBL_MAX);
+        for (int j = 0; j < n; ++j) {
+            int k = assignment[j];
+            if (k < 0) continue;
+
+            Face* face = faces[k];
+            outside_sets_[face].push_back(indices[j]);
+            // Ties are broken by the lexicographical order, as in
+            // InitializeTetrahedron().
+            if (distances[j] > dis_max[k] ||
+                (distances[j] == dis_max[k] &&
+                 points_[indices[j]] < points_[farthest_point_[face]])) {
+                dis_max[k] = distances[j];
+                farthest_point_[face] = indices[j];
+            }
+        }
 
-            if (!outside_set.empty()) {
-                outside_sets_[face] = outside_set;
-                farthest_point_[face] = farthest;
+        for (Face* face : faces) {
+            if (!outside_sets_[face].empty()) {
                 available_faces_.push(face);
             }
         }
     }
 
     /**
-     * Find the visible faces from point 'p'.
+     * Find the visible faces from point 'p'. The visible faces are marked by
+     * the current stamp.
      */
     void FindVisibleFaces(Face* face, const Point& p,
-                          Array<Face*>* visible_faces) const {
+                          Array<Face*>* visible_faces) {
+        visible_faces->clear();
+
         // BFS to found the new boundary of current convex hull.
-        std::queue<Face*> queue;
-        queue.push(face);
-        auto is_visited = faces_.AddProperty(false);
-        is_visited[face] = true;
+        ++stamp_;
+        visible_[face] = stamp_;
+        visible_faces->push_back(face);
 
-        while (!queue.empty()) {
-            Face* face = queue.front();
-            queue.pop();
-            visible_faces->push_back(face);
+        for (int i = 0; i < visible_faces->size(); ++i) {
+            Halfedge* e = (*visible_faces)[i]->halfedge;
 
             Face* faces[3];
-            Halfedge* e = face->halfedge;
             faces[0] = face_[e->twin()];
             faces[1] = face_[e->next()->twin()];
             faces[2] = face_[e->prev()->twin()];
 
-            for (Face* face : faces) {
-                if (face && !is_visited[face]) {
-                    if (FaceOrientation(p, face) > 0) {
-                        is_visited[face] = true;
-                        queue.push(face);
+            for (Face* f : faces) {
+                if (f && visible_[f] != stamp_) {
+                    if (FaceOrientation(p, f) > 0) {
+                        visible_[f] = stamp_;
+                        visible_faces->push_back(f);
                     }
                 }
             }
@@ -417,6 +725,10 @@ private:
     // Farthest point away from the face.
     typename FaceList::template Property<int> farthest_point_;
 
+    // The faces visible from the current point are marked by stamp_.
+    typename FaceList::template Property<int> visible_;
+    int stamp_ = 0;
+
     // Current available faces for building convex hull.
     std::queue<Face*> available_faces_;
 
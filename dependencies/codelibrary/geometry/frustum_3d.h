@@ -0,0 +1,145 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GEOMETRY_FRUSTUM_3D_H_
+#define CODELIBRARY_GEOMETRY_FRUSTUM_3D_H_
+
+#include <cmath>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/box_3d.h"
+#include "codelibrary/geometry/plane_3d.h"
+#include "codelibrary/geometry/point_3d.h"
+
+namespace cl {
+
+/**
+ * 3D view frustum, bounded by six planes.
+ *
+ * Each plane is stored as (a, b, c, d) such that a point (x, y, z) is at the
+ * inner side if a * x + b * y + c * z + d > 0.
+ */
+template <typename T>
+class Frustum3D {
+    static_assert(std::is_floating_point<T>::value,
+                  "We only allow floating point type for 3D frustum.");
+
+public:
+    using value_type = T;
+
+    /**
+     * Relation between a box and the frustum.
+     */
+    enum Relation {
+        OUTSIDE,
+        INTERSECT,
+        INSIDE
+    };
+
+    // The mask of a box that is inside all planes.
+    static const int INSIDE_MASK = (1 << 6) - 1;
+
+    Frustum3D() = default;
+
+    /**
+     * Construct the frustum by its eight vertices, in the order of
+     * gl::Camera::GetFrustum(): the near rectangle (left-bottom,
+     * right-bottom, right-top, left-top), then the far rectangle.
+     */
+    explicit Frustum3D(const Array<Point3D<T>>& vertices) {
+        CHECK(vertices.size() == 8);
+
+        const int faces[6][3] = {
+            {0, 2, 1}, {4, 5, 6}, {1, 2, 5}, {0, 4, 3}, {0, 1, 5}, {3, 6, 2}
+        };
+        for (int i = 0; i < 6; ++i) {
+            Plane3D<T> plane(vertices[faces[i][0]], vertices[faces[i][1]],
+                             vertices[faces[i][2]]);
+            planes_[i][0] = plane.normal().x;
+            planes_[i][1] = plane.normal().y;
+            planes_[i][2] = plane.normal().z;
+            planes_[i][3] = -planes_[i][0] * plane.point().x -
+                             planes_[i][1] * plane.point().y -
+                             planes_[i][2] * plane.point().z;
+        }
+    }
+
+    /**
+     * Return the relation between the box and the frustum.
+     *
+     * The plane-coherency optimizations for hierarchical culling:
+     *  - 'mask' (optional): the i-th bit is set if the box is known to be
+     *    inside the i-th plane, e.g., because its parent box is. These planes
+     *    are skipped, and the bits of the planes that contain the box are
+     *    added on return, to be passed to the children.
+     *  - 'start_plane' (optional): the plane tested first, e.g., the plane
+     *    that culled the box in the last frame. On return, it is set to the
+     *    plane that culls the box, if any.
+     *
+     * The box is OUTSIDE if it is not strictly at the inner side of some
+     * plane, INSIDE if it is strictly at the inner side of all planes.
+     */
+    Relation Classify(const Box3D<T>& box, int* mask = nullptr,
+                      int* start_plane = nullptr) const {
+        int m = mask ? *mask : 0;
+        int first = start_plane ? *start_plane : 0;
+
+        T cx = (box.x_min() + box.x_max()) / 2;
+        T cy = (box.y_min() + box.y_max()) / 2;
+        T cz = (box.z_min() + box.z_max()) / 2;
+        T ex = box.x_max() - cx, ey = box.y_max() - cy, ez = box.z_max() - cz;
+        for (int k = 0; k < 6; ++k) {
+            int i = (first + k) % 6;
+            if (m & (1 << i)) continue;
+
+            const T* p = planes_[i];
+            T s = p[0] * cx + p[1] * cy + p[2] * cz + p[3];
+            T r = std::fabs(p[0]) * ex + std::fabs(p[1]) * ey +
+                  std::fabs(p[2]) * ez;
+            if (s + r <= 0) {
+                if (start_plane) *start_plane = i;
+                return OUTSIDE;
+            }
+            if (s - r > 0) m |= 1 << i;
+        }
+
+        if (mask) *mask = m;
+        return m == INSIDE_MASK ? INSIDE : INTERSECT;
+    }
+
+    /**
+     * Return true if the point is strictly inside the frustum.
+     */
+    bool Contains(const Point3D<T>& p) const {
+        for (int i = 0; i < 6; ++i) {
+            const T* q = planes_[i];
+            if (q[0] * p.x + q[1] * p.y + q[2] * p.z + q[3] <= 0) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Return the i-th plane as (a, b, c, d).
+     */
+    const T* plane(int i) const {
+        CHECK(i >= 0 && i < 6);
+        return planes_[i];
+    }
+
+private:
+    // Near, far, right, left, bottom and top planes.
+    T planes_[6][4] = {};
+};
+
+using FFrustum3D = Frustum3D<float>;
+using RFrustum3D = Frustum3D<double>;
+
+} // namespace cl
+
+#endif // CODELIBRARY_GEOMETRY_FRUSTUM_3D_H_
@@ -0,0 +1,621 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GEOMETRY_MESH_BLOCK_MESH_STITCHER_H_
+#define CODELIBRARY_GEOMETRY_MESH_BLOCK_MESH_STITCHER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/box_3d.h"
+#include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/geometry/vector_3d.h"
+#include "codelibrary/util/set/disjoint_set.h"
+
+namespace cl {
+namespace geometry {
+
+/**
+ * Stitch the triangle meshes of overlapping blocks (e.g., the meshes extracted
+ * from the block NeRFs of a street) into a single indexed mesh.
+ *
+ * Each block owns the Voronoi cell of its site, and its mesh is clipped to the
+ * cell by the bisector planes of the neighboring sites, so the overlapping
+ * parts are kept only once, and the meshes of two neighbors end on the same
+ * plane. Their boundaries along this seam are two different polylines that
+ * approximate the same curve. To close the seam:
+ *  1) each seam edge of a block is split at the seam vertices of the other
+ *     blocks that are within 'weld_distance' of it, but not of its ends;
+ *  2) the seam vertices of different blocks within 'weld_distance' of each
+ *     other are welded, found by a spatial hash.
+ * After that, both sides of a seam have the same vertices, and the seams are
+ * closed if the two polylines are closer than 'weld_distance' and their edges
+ * are longer than it.
+ *
+ * The blocks are clipped and split in parallel.
+ */
+template <typename T>
+class BlockMeshStitcher {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    using Point = Point3D<T>;
+    using Vector = Vector3D<T>;
+
+public:
+    struct Options {
+        // Maximum distance of the vertices welded across seams.
+        double weld_distance = 0.01;
+    };
+
+    /**
+     * Triangle mesh of a block, in the normalized frame of the block: the
+     * world position of a vertex v is (v - offset) / scale.
+     */
+    struct BlockMesh {
+        Array<Point> vertices;
+
+        // Three vertex indices per triangle.
+        Array<int> triangles;
+
+        double scale = 1.0;
+        Vector offset;
+
+        // The center of the ownership region, in the world frame.
+        Point site;
+    };
+
+    struct Mesh {
+        Array<Point> vertices;
+        Array<int> triangles;
+
+        // The block of each triangle.
+        Array<int> blocks;
+    };
+
+    struct Summary {
+        int n_input_triangles = 0;
+
+        // Number of triangles cut by the ownership regions.
+        int n_cut_triangles = 0;
+
+        int n_seam_vertices = 0;
+
+        // Number of seam edges split at the vertices of the other side.
+        int n_split_edges = 0;
+
+        int n_welded_vertices = 0;
+    };
+
+    BlockMeshStitcher() = default;
+
+    explicit BlockMeshStitcher(const Options& options)
+        : options_(options) {
+        CHECK(options.weld_distance > 0.0);
+    }
+
+    /**
+     * Stitch the meshes of the blocks.
+     */
+    void Stitch(const Array<BlockMesh>& blocks, Mesh* mesh,
+                Summary* summary = nullptr) const {
+        CHECK(mesh);
+
+        mesh->vertices.clear();
+        mesh->triangles.clear();
+        mesh->blocks.clear();
+        Summary s;
+
+        const int n_blocks = blocks.size();
+        for (int i = 0; i < n_blocks; ++i) {
+            const BlockMesh& b = blocks[i];
+            CHECK(b.scale > 0.0);
+            CHECK(b.triangles.size() % 3 == 0);
+            for (int v : b.triangles) {
+                CHECK(v >= 0 && v < b.vertices.size());
+            }
+            for (int j = 0; j < i; ++j) {
+                CHECK(b.site != blocks[j].site) << "Duplicate sites.";
+            }
+            s.n_input_triangles += b.triangles.size() / 3;
+        }
+
+        // Clip the meshes to the ownership regions.
+        Array<Piece> pieces(n_blocks);
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < n_blocks; ++i) {
+            Clip(blocks, i, &pieces[i]);
+        }
+
+        // Gather the vertices.
+        Array<int> offsets(n_blocks + 1, 0);
+        for (int i = 0; i < n_blocks; ++i) {
+            offsets[i + 1] = offsets[i] + pieces[i].vertices.size();
+            s.n_cut_triangles += pieces[i].n_cut;
+        }
+        const int n_vertices = offsets[n_blocks];
+        Array<Point> vertices(n_vertices);
+        Array<int> owners(n_vertices);
+        Array<int> seam_vertices;
+        for (int i = 0; i < n_blocks; ++i) {
+            const Piece& piece = pieces[i];
+            for (int j = 0; j < piece.vertices.size(); ++j) {
+                vertices[offsets[i] + j] = piece.vertices[j];
+                owners[offsets[i] + j] = i;
+                if (piece.seam[j]) seam_vertices.push_back(offsets[i] + j);
+            }
+        }
+        s.n_seam_vertices = seam_vertices.size();
+
+        // Find the seam edges, i.e., the boundary edges on the cells.
+        double max_length = 0.0;
+        #pragma omp parallel for schedule(dynamic) reduction(max:max_length)
+        for (int i = 0; i < n_blocks; ++i) {
+            max_length = std::max(max_length, FindSeamEdges(&pieces[i]));
+        }
+
+        // Hash the seam vertices into cells that are large enough for the
+        // queries around seam edges to visit at most 3 cells per axis.
+        SpatialHash hash(vertices, seam_vertices,
+                         std::max(options_.weld_distance, max_length));
+
+        // Split the seam edges, and replace the local vertex indices by the
+        // global ones.
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < n_blocks; ++i) {
+            Split(vertices, owners, hash, offsets[i], i, &pieces[i]);
+        }
+
+        // New vertices are appended after the gathered ones.
+        int n_total = n_vertices;
+        for (int i = 0; i < n_blocks; ++i) {
+            for (int& v : pieces[i].triangles) {
+                if (v < 0) v = n_total - v - 1;
+            }
+            n_total += pieces[i].centers.size();
+            s.n_split_edges += pieces[i].n_split;
+        }
+        for (int i = 0; i < n_blocks; ++i) {
+            vertices.insert(pieces[i].centers.begin(),
+                            pieces[i].centers.end());
+        }
+
+        // Weld the seam vertices of different blocks.
+        DisjointSet set(n_total);
+        const double weld2 = options_.weld_distance * options_.weld_distance;
+        Array<int> neighbors;
+        for (int u : seam_vertices) {
+            hash.Query(vertices[u], vertices[u], options_.weld_distance,
+                       &neighbors);
+            for (int v : neighbors) {
+                if (v <= u || owners[v] == owners[u]) continue;
+                if (SquaredDistance(vertices[u], vertices[v]) <= weld2) {
+                    set.Union(u, v);
+                }
+            }
+        }
+
+        // The lowest index of a cluster represents it.
+        Array<int> representatives(n_total, -1);
+        for (int i = 0; i < n_total; ++i) {
+            int& r = representatives[set.Find(i)];
+            if (r == -1) r = i;
+        }
+        Array<int> map(n_total);
+        for (int i = 0; i < n_total; ++i) {
+            map[i] = representatives[set.Find(i)];
+            if (map[i] != i) ++s.n_welded_vertices;
+        }
+
+        // Emit the triangles, and compact the vertices.
+        Array<int> triangles;
+        for (int i = 0; i < n_blocks; ++i) {
+            const Array<int>& t = pieces[i].triangles;
+            for (int j = 0; j < t.size(); j += 3) {
+                int a = map[t[j]], b = map[t[j + 1]], c = map[t[j + 2]];
+                if (a == b || b == c || c == a) continue;
+                triangles.push_back(a);
+                triangles.push_back(b);
+                triangles.push_back(c);
+                mesh->blocks.push_back(i);
+            }
+        }
+        Array<int> indices(n_total, -1);
+        for (int v : triangles) {
+            indices[v] = 0;
+        }
+        for (int i = 0; i < n_total; ++i) {
+            if (indices[i] == -1) continue;
+            indices[i] = mesh->vertices.size();
+            mesh->vertices.push_back(vertices[i]);
+        }
+        mesh->triangles.resize(triangles.size());
+        for (int i = 0; i < triangles.size(); ++i) {
+            mesh->triangles[i] = indices[triangles[i]];
+        }
+
+        if (summary) *summary = s;
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+    /**
+     * The mesh of a block during the stitching.
+     */
+    struct Piece {
+        Array<Point> vertices;
+        Array<int> triangles;
+
+        // True for the vertices on the boundary of the cell.
+        Array<bool> seam;
+
+        // Seam edges, as triangle * 3 + k for the edge from the k-th vertex
+        // of the triangle to the next one.
+        Array<int> seam_edges;
+
+        // New vertices at the centers of the triangles split on several
+        // edges, referred to as -1, -2, ... in the triangles.
+        Array<Point> centers;
+
+        int n_cut = 0;
+        int n_split = 0;
+    };
+
+    /**
+     * Spatial hash of the seam vertices.
+     */
+    class SpatialHash {
+    public:
+        SpatialHash(const Array<Point>& points, const Array<int>& indices,
+                    double cell_size)
+            : points_(points), inv_(1.0 / cell_size) {
+            for (int i : indices) {
+                const Point& p = points[i];
+                cells_[Key(Cell(p.x), Cell(p.y), Cell(p.z))].push_back(i);
+            }
+        }
+
+        /**
+         * Get the points in the cells that overlap the box of the segment
+         * (a, b) enlarged by 'margin'.
+         */
+        void Query(const Point& a, const Point& b, double margin,
+                   Array<int>* indices) const {
+            indices->clear();
+            int64_t x0 = Cell(std::min(a.x, b.x) - margin);
+            int64_t x1 = Cell(std::max(a.x, b.x) + margin);
+            int64_t y0 = Cell(std::min(a.y, b.y) - margin);
+            int64_t y1 = Cell(std::max(a.y, b.y) + margin);
+            int64_t z0 = Cell(std::min(a.z, b.z) - margin);
+            int64_t z1 = Cell(std::max(a.z, b.z) + margin);
+            for (int64_t x = x0; x <= x1; ++x) {
+                for (int64_t y = y0; y <= y1; ++y) {
+                    for (int64_t z = z0; z <= z1; ++z) {
+                        auto i = cells_.find(Key(x, y, z));
+                        if (i == cells_.end()) continue;
+                        indices->insert(i->second.begin(), i->second.end());
+                    }
+                }
+            }
+        }
+
+    private:
+        int64_t Cell(double v) const {
+            return static_cast<int64_t>(std::floor(v * inv_));
+        }
+
+        static uint64_t Key(int64_t x, int64_t y, int64_t z) {
+            const uint64_t mask = (uint64_t(1) << 21) - 1;
+            return (uint64_t(x) & mask) | ((uint64_t(y) & mask) << 21) |
+                   ((uint64_t(z) & mask) << 42);
+        }
+
+        const Array<Point>& points_;
+        double inv_;
+        std::unordered_map<uint64_t, Array<int>> cells_;
+    };
+
+    /**
+     * Map the mesh of block b to the world frame, and clip it to the cell of
+     * its site.
+     */
+    void Clip(const Array<BlockMesh>& blocks, int b, Piece* piece) const {
+        const BlockMesh& block = blocks[b];
+        const double inv_scale = 1.0 / block.scale;
+        const int n = block.vertices.size();
+        piece->vertices.resize(n);
+        for (int i = 0; i < n; ++i) {
+            const Point& v = block.vertices[i];
+            piece->vertices[i] = Point((v.x - block.offset.x) * inv_scale,
+                                       (v.y - block.offset.y) * inv_scale,
+                                       (v.z - block.offset.z) * inv_scale);
+        }
+        piece->triangles = block.triangles;
+        piece->seam.assign(n, false);
+        if (n == 0) return;
+
+        const Box3D<T> box(piece->vertices.begin(), piece->vertices.end());
+        const double diagonal = std::sqrt(box.x_length() * box.x_length() +
+                                          box.y_length() * box.y_length() +
+                                          box.z_length() * box.z_length());
+        for (int c = 0; c < blocks.size(); ++c) {
+            if (c == b) continue;
+
+            // The bisector of the two sites, computed in the same way for
+            // both blocks, signed to be positive out of the cell of b.
+            const Point& lo = blocks[std::min(b, c)].site;
+            const Point& hi = blocks[std::max(b, c)].site;
+            const Vector normal = hi - lo;
+            const Point mid = lo + normal * T(0.5);
+            const double sign = b < c ? 1.0 : -1.0;
+            auto distance = [&](const Point& p) {
+                return sign * (normal.x * (p.x - mid.x) +
+                               normal.y * (p.y - mid.y) +
+                               normal.z * (p.z - mid.z));
+            };
+
+            // Skip the planes that do not cut the mesh.
+            double max_distance = -1.0;
+            for (int i = 0; i < 8; ++i) {
+                Point corner(i & 1 ? box.x_max() : box.x_min(),
+                             i & 2 ? box.y_max() : box.y_min(),
+                             i & 4 ? box.z_max() : box.z_min());
+                max_distance = std::max(max_distance, distance(corner));
+            }
+            // Vertices closer to the plane than the rounding errors are on
+            // it, otherwise they would give nearly duplicate cut points.
+            const double epsilon = 1e-9 * normal.norm() * diagonal;
+            if (max_distance <= epsilon) continue;
+
+            ClipByPlane(distance, epsilon, piece);
+        }
+
+        // Remove the vertices out of the cell.
+        Array<int> indices(piece->vertices.size(), -1);
+        for (int v : piece->triangles) {
+            indices[v] = 0;
+        }
+        int n_kept = 0;
+        for (int i = 0; i < indices.size(); ++i) {
+            if (indices[i] == -1) continue;
+            piece->vertices[n_kept] = piece->vertices[i];
+            piece->seam[n_kept] = piece->seam[i];
+            indices[i] = n_kept++;
+        }
+        piece->vertices.resize(n_kept);
+        piece->seam.resize(n_kept);
+        for (int& v : piece->triangles) {
+            v = indices[v];
+        }
+    }
+
+    /**
+     * Keep the part of the mesh where distance(p) <= 0, where the distances
+     * within epsilon are zero. The cut points are shared by the triangles of
+     * an edge.
+     */
+    template <typename Distance>
+    static void ClipByPlane(const Distance& distance, double epsilon,
+                            Piece* piece) {
+        Array<Point>& vertices = piece->vertices;
+        Array<double> d(vertices.size());
+        for (int i = 0; i < d.size(); ++i) {
+            d[i] = distance(vertices[i]);
+            if (std::fabs(d[i]) <= epsilon) {
+                d[i] = 0.0;
+                piece->seam[i] = true;
+            }
+        }
+
+        std::unordered_map<uint64_t, int> cuts;
+        // Return the point where the edge from the inside vertex a to the
+        // outside vertex b crosses the plane.
+        auto cut = [&](int a, int b) {
+            if (d[a] == 0.0) return a;
+
+            uint64_t key = a < b ? (uint64_t(a) << 32) | uint64_t(b)
+                                 : (uint64_t(b) << 32) | uint64_t(a);
+            auto i = cuts.find(key);
+            if (i != cuts.end()) return i->second;
+
+            double t = d[a] / (d[a] - d[b]);
+            int v = vertices.size();
+            vertices.push_back(vertices[a] + (vertices[b] - vertices[a]) *
+                                             static_cast<T>(t));
+            piece->seam.push_back(true);
+            cuts[key] = v;
+            return v;
+        };
+
+        const Array<int>& triangles = piece->triangles;
+        Array<int> result;
+        Array<int> polygon;
+        for (int i = 0; i < triangles.size(); i += 3) {
+            int n_inside = 0;
+            for (int k = 0; k < 3; ++k) {
+                if (d[triangles[i + k]] <= 0.0) ++n_inside;
+            }
+            if (n_inside == 0) continue;
+            if (n_inside == 3) {
+                result.insert(triangles.begin() + i, triangles.begin() + i + 3);
+                continue;
+            }
+
+            // The cut points of the vertices on the plane are themselves, so
+            // skip the repeated vertices.
+            polygon.clear();
+            auto push = [&](int v) {
+                if (polygon.empty() || polygon.back() != v) {
+                    polygon.push_back(v);
+                }
+            };
+            for (int k = 0; k < 3; ++k) {
+                int a = triangles[i + k], b = triangles[i + (k + 1) % 3];
+                bool in_a = d[a] <= 0.0, in_b = d[b] <= 0.0;
+                if (in_a) push(a);
+                if (in_a != in_b) push(in_a ? cut(a, b) : cut(b, a));
+            }
+            if (polygon.size() > 1 && polygon.front() == polygon.back()) {
+                polygon.pop_back();
+            }
+            for (int k = 1; k + 1 < polygon.size(); ++k) {
+                result.push_back(polygon[0]);
+                result.push_back(polygon[k]);
+                result.push_back(polygon[k + 1]);
+            }
+            ++piece->n_cut;
+        }
+        piece->triangles.swap(result);
+    }
+
+    /**
+     * Find the boundary edges of the piece between seam vertices. Return the
+     * maximum length of these edges.
+     */
+    static double FindSeamEdges(Piece* piece) {
+        const Array<int>& triangles = piece->triangles;
+        std::unordered_map<uint64_t, int> edges;
+        for (int i = 0; i < triangles.size(); ++i) {
+            int a = triangles[i], b = triangles[i % 3 == 2 ? i - 2 : i + 1];
+            edges[(uint64_t(a) << 32) | uint64_t(b)] = i;
+        }
+
+        double max_length = 0.0;
+        piece->seam_edges.clear();
+        for (int i = 0; i < triangles.size(); ++i) {
+            int a = triangles[i], b = triangles[i % 3 == 2 ? i - 2 : i + 1];
+            if (!piece->seam[a] || !piece->seam[b]) continue;
+            if (edges.count((uint64_t(b) << 32) | uint64_t(a))) continue;
+            piece->seam_edges.push_back(i);
+            max_length = std::max(max_length, Distance(piece->vertices[a],
+                                                       piece->vertices[b]));
+        }
+        return max_length;
+    }
+
+    /**
+     * Split the seam edges of block b at the seam vertices of the other
+     * blocks, and make the vertex indices global.
+     */
+    void Split(const Array<Point>& vertices, const Array<int>& owners,
+               const SpatialHash& hash, int offset, int b,
+               Piece* piece) const {
+        Array<int>& triangles = piece->triangles;
+        for (int& v : triangles) {
+            v += offset;
+        }
+
+        // The split points of each seam edge, sorted along the edge.
+        const double weld = options_.weld_distance;
+        std::unordered_map<int, Array<std::pair<double, int>>> splits;
+        Array<int> candidates;
+        for (int e : piece->seam_edges) {
+            int a = triangles[e], c = triangles[e % 3 == 2 ? e - 2 : e + 1];
+            const Point& p = vertices[a];
+            const Point& q = vertices[c];
+            hash.Query(p, q, weld, &candidates);
+
+            const Vector pq = q - p;
+            const double length2 = pq.squared_norm();
+            Array<std::pair<double, int>> points;
+            for (int v : candidates) {
+                if (owners[v] == b) continue;
+                const Point& x = vertices[v];
+                if (Distance(x, p) <= weld || Distance(x, q) <= weld) continue;
+
+                double t = DotProduct(x - p, pq) / length2;
+                if (t <= 0.0 || t >= 1.0) continue;
+                if (Distance(x, p + pq * static_cast<T>(t)) > weld) continue;
+                points.emplace_back(t, v);
+            }
+            if (points.empty()) continue;
+
+            std::sort(points.begin(), points.end());
+            splits[e].swap(points);
+            ++piece->n_split;
+        }
+        if (splits.empty()) return;
+
+        // Triangulate the split triangles: a fan from the opposite vertex if
+        // only one edge is split, or from a new center vertex otherwise.
+        Array<int> result;
+        Array<int> polygon;
+        for (int i = 0; i < triangles.size(); i += 3) {
+            int n_split = 0, split = -1;
+            for (int k = 0; k < 3; ++k) {
+                if (splits.count(i + k)) {
+                    ++n_split;
+                    split = k;
+                }
+            }
+            if (n_split == 0) {
+                result.insert(triangles.begin() + i, triangles.begin() + i + 3);
+                continue;
+            }
+
+            polygon.clear();
+            int first = n_split == 1 ? split : 0;
+            for (int j = 0; j < 3; ++j) {
+                int k = (first + j) % 3;
+                polygon.push_back(triangles[i + k]);
+                auto s = splits.find(i + k);
+                if (s == splits.end()) continue;
+                for (const std::pair<double, int>& point : s->second) {
+                    polygon.push_back(point.second);
+                }
+            }
+
+            if (n_split == 1) {
+                // The polygon starts at the split edge and ends at the
+                // opposite vertex.
+                int apex = polygon.back();
+                for (int k = 0; k + 2 < polygon.size(); ++k) {
+                    result.push_back(polygon[k]);
+                    result.push_back(polygon[k + 1]);
+                    result.push_back(apex);
+                }
+            } else {
+                const Point& a = vertices[triangles[i]];
+                const Point& c = vertices[triangles[i + 1]];
+                const Point& d = vertices[triangles[i + 2]];
+                piece->centers.emplace_back((a.x + c.x + d.x) / 3,
+                                            (a.y + c.y + d.y) / 3,
+                                            (a.z + c.z + d.z) / 3);
+                int center = -piece->centers.size();
+                for (int k = 0; k < polygon.size(); ++k) {
+                    result.push_back(polygon[k]);
+                    result.push_back(polygon[(k + 1) % polygon.size()]);
+                    result.push_back(center);
+                }
+            }
+        }
+        triangles.swap(result);
+    }
+
+    static double SquaredDistance(const Point& a, const Point& b) {
+        return (a - b).squared_norm();
+    }
+
+    static double Distance(const Point& a, const Point& b) {
+        return std::sqrt(SquaredDistance(a, b));
+    }
+
+    Options options_;
+};
+
+} // namespace geometry
+} // namespace cl
+
+#endif // CODELIBRARY_GEOMETRY_MESH_BLOCK_MESH_STITCHER_H_
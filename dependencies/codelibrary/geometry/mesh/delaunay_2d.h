@@ -10,10 +10,16 @@
 #define CODELIBRARY_GEOMETRY_MESH_DELAUNAY_2D_H_
 
 #include <cfloat>
+#include <cstdint>
+#include <memory>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "codelibrary/base/array.h"
 #include "codelibrary/base/equal.h"
 #include "codelibrary/geometry/distance_2d.h"
@@ -21,6 +27,7 @@
 #include "codelibrary/geometry/mesh/halfedge_list.h"
 #include "codelibrary/geometry/predicate_2d.h"
 #include "codelibrary/geometry/segment_2d.h"
+#include "codelibrary/geometry/util/hilbert_sort_2d.h"
 
 namespace cl {
 namespace geometry {
@@ -35,12 +42,18 @@ namespace geometry {
  * triangles in the triangulation; they tend to avoid skinny triangles.
  *
  * This class supports the following operations:
- *  1) Divide and conquer algorithm for static Delaunay traingulation.
- *  2) Insertion and flip algorithm for dynamic Delunay (slower than 1).
+ *  1) Divide and conquer algorithm for static Delaunay traingulation. With
+ *     OpenMP, the lower levels of the recursion run in parallel on separate
+ *     meshes, which are then appended and merged.
+ *  2) Insertion and flip algorithm for dynamic Delunay (slower than 1). A
+ *     batch of points is inserted in the BRIO order (see BRIOSort()), and
+ *     each point is located by a walk from the last inserted vertex.
  *  3) Search the approximate nearest vertex of the given query point.
  *  4) Constrained Delaunay triangulation of line segments.
  *
  * The triangulation result is stored in the HalfedgeList.
+ *
+ * See StreamingDelaunay2D for point sets that do not fit in memory.
  */
 template <typename T>
 class Delaunay2D {
@@ -54,6 +67,10 @@ public:
     using EdgePropertyInt  = typename Mesh::template HalfedgeProperty<int>;
 
 private:
+    // Ranges of less than this number of vertices are not divided in
+    // parallel.
+    static const int MIN_PARALLEL_SIZE = 1 << 14;
+
     /**
      * Used to divide points in the horizontal and vertical directions.
      */
@@ -94,6 +111,7 @@ public:
         clear();
         if (points.empty()) return;
 
+        vertex_map_.reserve(points.size());
         for (const Point& p : points)
             AddVertex(p);
 
@@ -101,7 +119,14 @@ public:
 
         // Divide the points, using the strategy similar to the KD tree.
         vertices_ = mesh_.vertices();
-        Halfedge* e = Divide(0, mesh_.n_vertices());
+        int n_threads = 1;
+#ifdef _OPENMP
+        n_threads = omp_get_max_threads();
+#endif
+        Halfedge* e = n_threads > 1 &&
+                      mesh_.n_vertices() >= 2 * MIN_PARALLEL_SIZE
+                    ? ParallelDivide(n_threads)
+                    : Divide(0, mesh_.n_vertices());
 
         // Set the outer edges.
         for (auto e1 : mesh_.circular_list(e)) {
@@ -128,16 +153,31 @@ public:
         Halfedge* e = Locate(p, s);
 
         // Vertex is already exists.
-        if (e->source_point() == p) return e->source();
+        if (e->source_point() == p) return hint_ = e->source();
 
         // Vertex is on the edge.
-        if (OnEdge(e, p)) return Split(e, p);
+        if (OnEdge(e, p)) return hint_ = Split(e, p);
 
         // The new point is outside the current boundary.
-        if (is_outer_[e]) return InsertOuterVertex(p, e);
+        if (is_outer_[e]) return hint_ = InsertOuterVertex(p, e);
 
         // The new point is inside a triangle.
-        return InsertInnerVertex(p, e);
+        return hint_ = InsertInnerVertex(p, e);
+    }
+
+    /**
+     * Insert a batch of points in the BRIO order.
+     *
+     * It is much faster than inserting the points one by one in a random
+     * order, but Reset() is still faster for an empty triangulation.
+     */
+    void Insert(const Array<Point>& points) {
+        Array<int> order;
+        BRIOSort(points, &order);
+        for (int i : order) {
+            // Consecutive points are close, start from the last one.
+            Insert(points[i], hint_ ? hint_->halfedge() : nullptr);
+        }
     }
 
     /**
@@ -153,6 +193,7 @@ public:
         CHECK(vertex_map_.find(v->point()) != vertex_map_.end());
 
         vertex_map_.erase(v->point());
+        if (hint_ == v) hint_ = nullptr;
         if (mesh_.n_vertices() <= 2) {
             mesh_.EraseVertex(v);
             return;
@@ -443,7 +484,9 @@ public:
      * It takes time O(n) in the worst case, but only O(sqrt(n)) on average if
      * the vertices are distributed uniformly at random.
      *
-     * Users can specify the starting edge to speed up location.
+     * Users can specify the starting edge to speed up location. Otherwise, it
+     * starts from the nearest vertex to 'p' among the last inserted vertex
+     * and about n^(1/3) sampled vertices (jump and walk).
      */
     Halfedge* Locate(const Point& p, Halfedge* s = nullptr) const {
         if (mesh_.n_vertices() < 2) return nullptr;
@@ -452,12 +495,15 @@ public:
         auto i = vertex_map_.find(p);
         if (i != vertex_map_.end()) return i->second->halfedge();
 
+        if (!s) s = SampleNearestVertex(p)->halfedge();
+        Halfedge* result = Walk(p, s);
+        if (result) return result;
+
         // Do not use HalfedgeProperty. It will allocate an array of size |V|,
         // which is too slow.
         std::unordered_set<int> hash;
         std::queue<Halfedge*> queue;
 
-        if (!s) s = ApproximateNearestVertex(p)->halfedge();
         queue.push(s);
         hash.insert(s->id());
 
@@ -511,6 +557,27 @@ public:
         return nullptr;
     }
 
+    /**
+     * Return the nearest vertex to 'p' among the last inserted vertex and
+     * about n^(1/3) vertices sampled evenly from the vertex list.
+     */
+    Vertex* SampleNearestVertex(const Point& p) const {
+        const Array<Vertex*>& vertices = mesh_.vertices();
+        Vertex* v = hint_ ? hint_ : vertices.back();
+        double dis = SquaredDistance(v->point(), p);
+
+        int n_samples = static_cast<int>(std::cbrt(vertices.size()));
+        int step = std::max(1, vertices.size() / std::max(1, n_samples));
+        for (int i = step / 2; i < vertices.size(); i += step) {
+            double d = SquaredDistance(vertices[i]->point(), p);
+            if (d < dis) {
+                dis = d;
+                v = vertices[i];
+            }
+        }
+        return v;
+    }
+
     /**
      * Find the vertex of the given point in the triangulation.
      */
@@ -553,6 +620,7 @@ public:
     void clear() {
         mesh_.clear();
         vertex_map_.clear();
+        hint_ = nullptr;
     }
 
     /**
@@ -932,6 +1000,141 @@ protected:
         return tangent;
     }
 
+    /**
+     * Divide the points as Divide(), but build the triangulations of the
+     * lower levels in parallel, each on a separate mesh. The meshes are then
+     * appended to 'mesh_' and merged serially at the upper levels.
+     */
+    Halfedge* ParallelDivide(int n_threads) {
+        // Split the upper levels, until there are about four ranges per
+        // thread.
+        const int n_ranges = 4 * n_threads;
+        Array<int> leaves;      // Begin and end index of each leaf range.
+        Array<int> dimensions;  // Cut dimensions of the upper levels.
+        SplitUpperLevels(0, mesh_.n_vertices(), n_ranges, &leaves,
+                         &dimensions);
+
+        const int n_leaves = leaves.size() / 2;
+        Array<std::unique_ptr<Delaunay2D>> triangulations(n_leaves);
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < n_leaves; ++i) {
+            triangulations[i].reset(new Delaunay2D);
+            Delaunay2D* t = triangulations[i].get();
+            for (int j = leaves[2 * i]; j < leaves[2 * i + 1]; ++j) {
+                t->mesh_.AddVertex(vertices_[j]->point());
+            }
+            t->vertices_ = t->mesh_.vertices();
+            t->Divide(0, t->vertices_.size());
+            t->vertices_.clear();
+        }
+
+        for (int i = 0; i < n_leaves; ++i) {
+            Array<Vertex*> vertices(vertices_.begin() + leaves[2 * i],
+                                    vertices_.begin() + leaves[2 * i + 1]);
+            mesh_.Append(triangulations[i]->mesh_, vertices);
+            triangulations[i].reset();
+        }
+
+        int index = 0;
+        return MergeUpperLevels(0, mesh_.n_vertices(), n_ranges, dimensions,
+                                &index);
+    }
+
+    /**
+     * Split the vertices in [l, r) as Divide() until each range has at most
+     * about 1/n_ranges of the vertices, or MIN_PARALLEL_SIZE vertices. The
+     * leaf ranges and the cut dimensions are recorded in the preorder.
+     */
+    void SplitUpperLevels(int l, int r, int n_ranges, Array<int>* leaves,
+                          Array<int>* dimensions) {
+        if (n_ranges <= 1 || r - l < 2 * MIN_PARALLEL_SIZE) {
+            leaves->push_back(l);
+            leaves->push_back(r);
+            return;
+        }
+
+        int cut_dimension;
+        int cut_index = MiddleSplit(l, r, &cut_dimension);
+        dimensions->push_back(cut_dimension);
+        SplitUpperLevels(l, cut_index, (n_ranges + 1) / 2, leaves,
+                         dimensions);
+        SplitUpperLevels(cut_index, r, (n_ranges + 1) / 2, leaves,
+                         dimensions);
+    }
+
+    /**
+     * Merge the triangulations of the leaf ranges, in the same recursion as
+     * SplitUpperLevels().
+     */
+    Halfedge* MergeUpperLevels(int l, int r, int n_ranges,
+                               const Array<int>& dimensions, int* index) {
+        // Leaf range, it has been triangulated.
+        if (n_ranges <= 1 || r - l < 2 * MIN_PARALLEL_SIZE) return nullptr;
+
+        int cut_dimension = dimensions[(*index)++];
+        int cut_index = l + (r - l) / 2;
+        MergeUpperLevels(l, cut_index, (n_ranges + 1) / 2, dimensions, index);
+        MergeUpperLevels(cut_index, r, (n_ranges + 1) / 2, dimensions, index);
+
+        return Merge(l, cut_index, r, cut_dimension);
+    }
+
+    /**
+     * Locate 'p' by a remembering stochastic walk from the halfedge 's'.
+     *
+     * The walk visits the triangles towards 'p', crossing an edge that
+     * separates the current triangle from 'p', where the edges are tested in
+     * a random order (so that it terminates in any triangulation).
+     *
+     * Return nullptr if the walk fails, e.g., the triangulation has no
+     * triangle, then the caller falls back to the breadth first search.
+     */
+    Halfedge* Walk(const Point& p, Halfedge* s) const {
+        if (is_outer_[s]) s = s->twin();
+        if (is_outer_[s]) return nullptr;
+
+        uint32_t random = 2463534242u;
+        Halfedge* from = nullptr;
+        Halfedge* e = s;
+        const int max_steps = mesh_.n_halfedges();
+        for (int step = 0; step < max_steps; ++step) {
+            // Xorshift.
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+
+            Halfedge* edges[3] = { e, e->next(), e->prev() };
+            Halfedge* next = nullptr;
+            int first = random % 3;
+            for (int k = 0; k < 3; ++k) {
+                Halfedge* e1 = edges[(first + k) % 3];
+                if (e1 == from) continue;
+
+                if (Orientation(e1->source_point(), e1->target_point(),
+                                p) < 0) {
+                    next = e1->twin();
+                    break;
+                }
+            }
+
+            if (!next) {
+                // 'p' is inside or on the boundary of the triangle.
+                for (Halfedge* e1 : edges) {
+                    if (OnEdge(e1, p)) return e1;
+                }
+                return e;
+            }
+
+            // 'p' is outside of the triangulation.
+            if (is_outer_[next]) return next;
+
+            from = next;
+            e = next;
+        }
+
+        return nullptr;
+    }
+
     /**
      * Split halfedge 'e' at point 'p'.
      *
@@ -1195,6 +1398,9 @@ protected:
     // Temporary used.
     Array<Vertex*> vertices_;
 
+    // The last inserted vertex, where the location starts by default.
+    Vertex* hint_ = nullptr;
+
     // Used to divide points in the horizontal and vertical directions.
     CompareXY compare_xy_;
     CompareYX compare_yx_;
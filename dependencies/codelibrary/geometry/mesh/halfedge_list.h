@@ -412,6 +412,46 @@ public:
         }
     }
 
+    /**
+     * Append the halfedges of 'list' to this HalfedgeList. The i-th vertex of
+     * 'list' is mapped to vertices[i], a vertex of this list. It is used to
+     * stitch the meshes that are built separately, e.g., in parallel.
+     *
+     * Note that the properties of 'list' are not copied.
+     */
+    void Append(const HalfedgeList& list, const Array<Vertex*>& vertices) {
+        CHECK(this != &list);
+        CHECK(vertices.size() == list.n_vertices());
+
+        Array<Vertex*> vertex_map(list.n_allocated_vertices(), nullptr);
+        for (int i = 0; i < vertices.size(); ++i) {
+            vertex_map[list.vertices()[i]->id()] = vertices[i];
+        }
+
+        Array<Halfedge*> halfedge_map(list.n_allocated_halfedges(), nullptr);
+        for (const Halfedge* e : list.halfedges()) {
+            if (halfedge_map[e->id()]) continue;
+
+            Halfedge* e1 = CreateEdge();
+            halfedge_map[e->id()] = e1;
+            halfedge_map[e->twin_->id()] = e1->twin_;
+        }
+
+        for (const Halfedge* e : list.halfedges()) {
+            Halfedge* e1 = halfedge_map[e->id()];
+            e1->vertex_ = vertex_map[e->vertex_->id()];
+            e1->next_   = halfedge_map[e->next_->id()];
+            e1->prev_   = halfedge_map[e->prev_->id()];
+        }
+
+        for (int i = 0; i < vertices.size(); ++i) {
+            const Vertex* v = list.vertices()[i];
+            if (v->halfedge_) {
+                vertices[i]->halfedge_ = halfedge_map[v->halfedge_->id()];
+            }
+        }
+    }
+
     /**
      * set e1->next = e2, and e2->prev = e1.
      */
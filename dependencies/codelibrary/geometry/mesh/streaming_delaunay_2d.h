@@ -0,0 +1,558 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GEOMETRY_MESH_STREAMING_DELAUNAY_2D_H_
+#define CODELIBRARY_GEOMETRY_MESH_STREAMING_DELAUNAY_2D_H_
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/point_2d.h"
+#include "codelibrary/geometry/predicate_2d.h"
+#include "codelibrary/geometry/util/hilbert_sort_2d.h"
+
+namespace cl {
+namespace geometry {
+
+/**
+ * Streaming 2D Delaunay triangulation.
+ *
+ * The points arrive in (roughly) increasing x order, e.g., LiDAR scans along
+ * a road. The user moves a sweepline with Sweep(x) and promises that all the
+ * points inserted after it are not at the left of x. A triangle whose
+ * circumcircle is completely at the left of the sweepline can not be in
+ * conflict with any future point, so it is finalized: it is written to the
+ * output and removed from memory, together with the vertices that are no
+ * longer used. The memory is proportional to the width of the front, not to
+ * the number of points.
+ *
+ * The points are inserted by the Bowyer-Watson algorithm with the exact
+ * predicates. The convex hull is closed by the triangles incident to an
+ * infinite vertex.
+ *
+ * The output triangles are given by the ids of their vertices in CCW order.
+ * The id of a point is the number of points inserted before it. Duplicated
+ * points are ignored, i.e., their ids never appear in the output.
+ *
+ * Usage:
+ *
+ *   StreamingDelaunay2D<double> delaunay;
+ *   Array<int> triangles;
+ *   for (each slab of points sorted by x) {
+ *       delaunay.Insert(slab);
+ *       delaunay.Sweep(x_min of the next slab, &triangles);
+ *       // Consume and clear 'triangles'.
+ *   }
+ *   delaunay.Finish(&triangles);
+ */
+template <typename T>
+class StreamingDelaunay2D {
+    /**
+     * Triangle of the triangulation, the vertex 0 is the infinite vertex.
+     */
+    struct Triangle {
+        int vertices[3];  // In CCW order.
+        int neighbors[3]; // neighbors[i] is opposite to vertices[i], -1 if it
+                          // is finalized.
+        int stamp;        // Creation stamp, to skip the stale events.
+        bool alive;
+    };
+
+    /**
+     * A triangle can be finalized once the sweepline passes its 'reach'.
+     */
+    struct Event {
+        double reach;
+        int triangle;
+        int stamp;
+
+        bool operator <(const Event& rhs) const {
+            return reach > rhs.reach;
+        }
+    };
+
+    /**
+     * Edge on the boundary of the cavity, with the triangle outside.
+     */
+    struct BoundaryEdge {
+        int source, target, neighbor;
+    };
+
+public:
+    using Point = Point2D<T>;
+
+    StreamingDelaunay2D() {
+        clear();
+    }
+
+    StreamingDelaunay2D(const StreamingDelaunay2D&) = delete;
+
+    StreamingDelaunay2D& operator=(const StreamingDelaunay2D&) = delete;
+
+    /**
+     * Insert a point. Its x coordinate must not be less than the sweepline.
+     */
+    void Insert(const Point& p) {
+        CHECK(p.x >= sweep_) << "The point is behind the sweepline.";
+
+        InsertPoint(p, n_points_++);
+    }
+
+    /**
+     * Insert a batch of points. They are inserted along a Hilbert curve, but
+     * their ids follow the order in the array.
+     */
+    void Insert(const Array<Point>& points) {
+        Array<int> order;
+        HilbertSort(points, &order);
+        for (int i : order) {
+            CHECK(points[i].x >= sweep_);
+            InsertPoint(points[i], n_points_ + i);
+        }
+        n_points_ += points.size();
+    }
+
+    /**
+     * Move the sweepline to x and append the triangles that are finalized to
+     * 'triangles' (three vertex ids for each).
+     */
+    void Sweep(T x, Array<int>* triangles) {
+        CHECK(triangles);
+        CHECK(x >= sweep_);
+
+        sweep_ = x;
+        while (!events_.empty() && events_.top().reach < sweep_) {
+            Event event = events_.top();
+            events_.pop();
+
+            const Triangle& t = triangles_[event.triangle];
+            if (!t.alive || t.stamp != event.stamp) continue;
+
+            for (int v : t.vertices) {
+                triangles->push_back(ids_[v]);
+            }
+            EraseTriangle(event.triangle);
+        }
+    }
+
+    /**
+     * Append all the remaining triangles to 'triangles' and clear the
+     * triangulation.
+     */
+    void Finish(Array<int>* triangles) {
+        CHECK(triangles);
+
+        for (const Triangle& t : triangles_) {
+            if (!t.alive || IsInfinite(t)) continue;
+
+            for (int v : t.vertices) {
+                triangles->push_back(ids_[v]);
+            }
+        }
+        clear();
+    }
+
+    void clear() {
+        points_.clear();
+        ids_.clear();
+        n_references_.clear();
+        free_vertices_.clear();
+        triangles_.clear();
+        free_triangles_.clear();
+        events_ = std::priority_queue<Event>();
+        pending_points_.clear();
+        pending_ids_.clear();
+        marks_.clear();
+        links_.clear();
+
+        // The infinite vertex.
+        points_.push_back(Point());
+        ids_.push_back(-1);
+        n_references_.push_back(0);
+
+        n_points_ = 0;
+        n_triangles_ = 0;
+        last_ = -1;
+        stamp_ = 0;
+        mark_ = 0;
+        random_ = 1;
+        sweep_ = -std::numeric_limits<T>::max();
+    }
+
+    /**
+     * Return the number of inserted points (including the duplicated ones).
+     */
+    int n_points() const {
+        return n_points_;
+    }
+
+    /**
+     * Return the number of points kept in memory.
+     */
+    int n_active_vertices() const {
+        return points_.size() - 1 - free_vertices_.size() +
+               pending_points_.size();
+    }
+
+    /**
+     * Return the number of triangles kept in memory (including the infinite
+     * ones).
+     */
+    int n_active_triangles() const {
+        return n_triangles_;
+    }
+
+    T sweep() const {
+        return sweep_;
+    }
+
+private:
+    void InsertPoint(const Point& p, int id) {
+        if (last_ == -1) {
+            pending_points_.push_back(p);
+            pending_ids_.push_back(id);
+            Initialize();
+            return;
+        }
+
+        int seed = Locate(p);
+        if (seed == -1) return; // Duplicated point.
+
+        // Collect the triangles in conflict with p (the cavity) by BFS.
+        ++mark_;
+        marks_.resize(triangles_.size(), 0);
+        cavity_.clear();
+        boundary_.clear();
+        marks_[seed] = mark_;
+        cavity_.push_back(seed);
+        for (int k = 0; k < cavity_.size(); ++k) {
+            const Triangle& t = triangles_[cavity_[k]];
+            for (int i = 0; i < 3; ++i) {
+                int n = t.neighbors[i];
+                if (n != -1 && marks_[n] == mark_) continue;
+
+                if (n != -1 && InConflict(triangles_[n], p)) {
+                    marks_[n] = mark_;
+                    cavity_.push_back(n);
+                } else {
+                    BoundaryEdge e;
+                    e.source = t.vertices[(i + 1) % 3];
+                    e.target = t.vertices[(i + 2) % 3];
+                    e.neighbor = n;
+                    boundary_.push_back(e);
+                }
+            }
+        }
+
+        // Connect p to the boundary of the cavity.
+        int v = AddVertex(p, id);
+        links_.resize(points_.size(), -1);
+        for (const BoundaryEdge& e : boundary_) {
+            int t = AddTriangle(e.source, e.target, v);
+            links_[e.source] = t;
+            triangles_[t].neighbors[2] = e.neighbor;
+            if (e.neighbor != -1) {
+                Triangle& n = triangles_[e.neighbor];
+                n.neighbors[EdgeIndex(n, e.target, e.source)] = t;
+            }
+        }
+        for (const BoundaryEdge& e : boundary_) {
+            int t = links_[e.source], t1 = links_[e.target];
+            triangles_[t].neighbors[0] = t1;
+            triangles_[t1].neighbors[1] = t;
+        }
+        last_ = links_[boundary_.front().source];
+
+        for (int t : cavity_) {
+            EraseTriangle(t);
+        }
+    }
+
+    /**
+     * Build the first triangle once three non-collinear points are pending.
+     */
+    void Initialize() {
+        const Array<Point>& points = pending_points_;
+        const Point& a = points.front();
+        int j = 1;
+        while (j < points.size() && points[j] == a) ++j;
+        if (j == points.size()) return;
+
+        int k = j + 1;
+        int o = 0;
+        while (k < points.size() &&
+               (o = Orientation(a, points[j], points[k])) == 0) {
+            ++k;
+        }
+        if (k == points.size()) return;
+
+        int v1 = AddVertex(a, pending_ids_.front());
+        int v2 = AddVertex(points[j], pending_ids_[j]);
+        int v3 = AddVertex(points[k], pending_ids_[k]);
+        if (o < 0) std::swap(v2, v3);
+
+        int t[4] = { AddTriangle(v1, v2, v3), AddTriangle(v2, v1, 0),
+                     AddTriangle(v3, v2, 0),  AddTriangle(v1, v3, 0) };
+        for (int i = 0; i < 4; ++i) {
+            Triangle& t1 = triangles_[t[i]];
+            for (int m = 0; m < 3; ++m) {
+                for (int n = 0; n < 4; ++n) {
+                    if (n == i) continue;
+
+                    int l = EdgeIndex(triangles_[t[n]],
+                                      t1.vertices[(m + 2) % 3],
+                                      t1.vertices[(m + 1) % 3]);
+                    if (l != -1) t1.neighbors[m] = t[n];
+                }
+            }
+        }
+        last_ = t[0];
+
+        Array<Point> points1;
+        Array<int> ids1;
+        points1.swap(pending_points_);
+        ids1.swap(pending_ids_);
+        for (int i = 1; i < points1.size(); ++i) {
+            if (i != j && i != k) InsertPoint(points1[i], ids1[i]);
+        }
+    }
+
+    /**
+     * Find a triangle in conflict with p by a visibility walk from the last
+     * created triangle. Return -1 if p is a vertex of the triangulation.
+     *
+     * If the walk reaches a finalized triangle, it falls back to the linear
+     * scan of the active triangles.
+     */
+    int Locate(const Point& p) {
+        int t = last_;
+        if (!triangles_[t].alive) t = -1;
+
+        for (int step = 0; t != -1 && step <= n_triangles_; ++step) {
+            const Triangle& tri = triangles_[t];
+            int k = InfiniteIndex(tri);
+            if (k != -1) {
+                if (InConflict(tri, p)) return t;
+                t = tri.neighbors[k];
+                continue;
+            }
+
+            // Remembering stochastic walk.
+            random_ ^= random_ << 13;
+            random_ ^= random_ >> 17;
+            random_ ^= random_ << 5;
+            int r = random_ % 3;
+            int next = -2;
+            for (int j = 0; j < 3; ++j) {
+                int i = (r + j) % 3;
+                if (Orientation(points_[tri.vertices[(i + 1) % 3]],
+                                points_[tri.vertices[(i + 2) % 3]], p) < 0) {
+                    next = tri.neighbors[i];
+                    break;
+                }
+            }
+            if (next == -2) {
+                // p is inside the closed triangle.
+                for (int v : tri.vertices) {
+                    if (points_[v] == p) return -1;
+                }
+                return t;
+            }
+            t = next;
+        }
+
+        // Any triangle in conflict with p is fine, since the cavity is
+        // connected. There is no such triangle if p is duplicated.
+        for (int i = 0; i < triangles_.size(); ++i) {
+            if (triangles_[i].alive && InConflict(triangles_[i], p)) return i;
+        }
+        return -1;
+    }
+
+    /**
+     * Check if p is strictly inside the circumcircle of the triangle. For an
+     * infinite triangle, the circumcircle is the open half-plane outside its
+     * hull edge, plus the interior of the edge.
+     */
+    bool InConflict(const Triangle& t, const Point& p) const {
+        int k = InfiniteIndex(t);
+        if (k == -1) {
+            return InCircle(points_[t.vertices[0]], points_[t.vertices[1]],
+                            points_[t.vertices[2]], p) > 0;
+        }
+
+        const Point& a = points_[t.vertices[(k + 1) % 3]];
+        const Point& b = points_[t.vertices[(k + 2) % 3]];
+        int o = Orientation(a, b, p);
+        if (o != 0) return o > 0;
+        return a < b ? a < p && p < b : b < p && p < a;
+    }
+
+    /**
+     * Return the x coordinate beyond which no point can be inside the
+     * circumcircle of the finite triangle t. It includes a bound of the
+     * rounding error, and is +infinity for the nearly degenerate triangles.
+     */
+    double Reach(const Triangle& t) const {
+        const Point& a = points_[t.vertices[0]];
+        const Point& b = points_[t.vertices[1]];
+        const Point& c = points_[t.vertices[2]];
+        double bx = static_cast<double>(b.x) - a.x;
+        double by = static_cast<double>(b.y) - a.y;
+        double cx = static_cast<double>(c.x) - a.x;
+        double cy = static_cast<double>(c.y) - a.y;
+        double d = 2.0 * (bx * cy - by * cx);
+        double condition = 2.0 * (std::fabs(bx * cy) + std::fabs(by * cx)) /
+                           std::fabs(d);
+        if (!(condition < 1e6)) return std::numeric_limits<double>::max();
+
+        double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+        double ux = (cy * b2 - by * c2) / d;
+        double uy = (bx * c2 - cx * b2) / d;
+        double r = std::sqrt(ux * ux + uy * uy);
+        double error = 64.0 * DBL_EPSILON * condition *
+                       (std::fabs(ux) + std::fabs(uy) + r) +
+                       4.0 * DBL_EPSILON * std::fabs(a.x);
+        return a.x + ux + r + error;
+    }
+
+    int AddVertex(const Point& p, int id) {
+        int v;
+        if (free_vertices_.empty()) {
+            v = points_.size();
+            points_.push_back(p);
+            ids_.push_back(id);
+            n_references_.push_back(0);
+        } else {
+            v = free_vertices_.back();
+            free_vertices_.pop_back();
+            points_[v] = p;
+            ids_[v] = id;
+        }
+        return v;
+    }
+
+    int AddTriangle(int v1, int v2, int v3) {
+        int t;
+        if (free_triangles_.empty()) {
+            t = triangles_.size();
+            triangles_.emplace_back();
+        } else {
+            t = free_triangles_.back();
+            free_triangles_.pop_back();
+        }
+
+        Triangle& tri = triangles_[t];
+        tri.vertices[0] = v1;
+        tri.vertices[1] = v2;
+        tri.vertices[2] = v3;
+        tri.neighbors[0] = tri.neighbors[1] = tri.neighbors[2] = -1;
+        tri.stamp = ++stamp_;
+        tri.alive = true;
+        ++n_triangles_;
+
+        for (int v : tri.vertices) {
+            ++n_references_[v];
+        }
+        if (!IsInfinite(tri)) {
+            Event event;
+            event.reach = Reach(tri);
+            event.triangle = t;
+            event.stamp = tri.stamp;
+            events_.push(event);
+        }
+        return t;
+    }
+
+    /**
+     * Remove the triangle t, and the vertices that are no longer used.
+     */
+    void EraseTriangle(int t) {
+        Triangle& tri = triangles_[t];
+        for (int n : tri.neighbors) {
+            if (n == -1) continue;
+
+            Triangle& t1 = triangles_[n];
+            for (int& n1 : t1.neighbors) {
+                if (n1 == t) n1 = -1;
+            }
+        }
+        for (int v : tri.vertices) {
+            if (--n_references_[v] == 0 && v != 0) free_vertices_.push_back(v);
+        }
+        tri.alive = false;
+        free_triangles_.push_back(t);
+        --n_triangles_;
+    }
+
+    /**
+     * Return the index i of the edge (source -> target) of t, i.e., the edge
+     * opposite to t.vertices[i], or -1 if not found.
+     */
+    static int EdgeIndex(const Triangle& t, int source, int target) {
+        for (int i = 0; i < 3; ++i) {
+            if (t.vertices[(i + 1) % 3] == source &&
+                t.vertices[(i + 2) % 3] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    static int InfiniteIndex(const Triangle& t) {
+        if (t.vertices[0] == 0) return 0;
+        if (t.vertices[1] == 0) return 1;
+        if (t.vertices[2] == 0) return 2;
+        return -1;
+    }
+
+    static bool IsInfinite(const Triangle& t) {
+        return InfiniteIndex(t) != -1;
+    }
+
+    // Active vertices, 0 is the infinite vertex.
+    Array<Point> points_;
+    Array<int> ids_;
+    Array<int> n_references_;
+    Array<int> free_vertices_;
+
+    // Active triangles.
+    Array<Triangle> triangles_;
+    Array<int> free_triangles_;
+    int n_triangles_ = 0;
+
+    // Finite triangles ordered by their reach.
+    std::priority_queue<Event> events_;
+
+    // Points waiting for the first non-degenerate triangle.
+    Array<Point> pending_points_;
+    Array<int> pending_ids_;
+
+    // Buffers for the insertion.
+    Array<int> marks_;
+    Array<int> links_;
+    Array<int> cavity_;
+    Array<BoundaryEdge> boundary_;
+
+    int n_points_ = 0;
+    int last_ = -1;
+    int stamp_ = 0;
+    int mark_ = 0;
+    uint32_t random_ = 1;
+    T sweep_;
+};
+
+} // namespace geometry
+} // namespace cl
+
+#endif // CODELIBRARY_GEOMETRY_MESH_STREAMING_DELAUNAY_2D_H_
@@ -53,7 +53,7 @@ private:
     static int DotProductCompare(const Point2D<T>& p, const Point2D<T>& q,
                                  const Point2D<T>& s, const Point2D<T>& r) {
         // Interval filter.
-        if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
+        UpwardRounding rounding;
 
         IntervalFloat det1 = DotProduct(IntervalFloat(p.x), IntervalFloat(p.y),
                                         IntervalFloat(q.x), IntervalFloat(q.y),
@@ -101,7 +101,7 @@ private:
     static int CrossProductCompare(const Point2D<T>& p, const Point2D<T>& q,
                                    const Point2D<T>& s, const Point2D<T>& r) {
         // Interval filter.
-        if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
+        UpwardRounding rounding;
 
         IntervalFloat det1 =
                 OrientationDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
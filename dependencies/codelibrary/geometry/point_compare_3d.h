@@ -48,7 +48,7 @@ private:
     static int DotProductCompare(const Point3D<T>& p, const Point3D<T>& q,
                                  const Point3D<T>& s, const Point3D<T>& r) {
         // Interval filter.
-        if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
+        UpwardRounding rounding;
 
         IntervalFloat det1 = DotProduct(IntervalFloat(p.x), IntervalFloat(p.y),
                                         IntervalFloat(p.z),
@@ -10,11 +10,12 @@
 #define CODELIBRARY_GEOMETRY_PREDICATE_2D_H_
 
 #include <algorithm>
-#include <cfenv>
 
 #include "codelibrary/geometry/point_2d.h"
+#include "codelibrary/geometry/predicate_filter.h"
 #include "codelibrary/math/number/determinant.h"
 #include "codelibrary/math/number/exact_float.h"
+#include "codelibrary/math/number/float_expansion.h"
 #include "codelibrary/math/number/interval_float.h"
 
 namespace cl {
@@ -50,6 +51,10 @@ T OrientationDeterminant(const T& px, const T& py, const T& qx, const T& qy,
  */
 template <typename T>
 int Orientation(const Point2D<T>& p, const Point2D<T>& q, const Point2D<T>& r) {
+    PredicateCounter& counter =
+            GetPredicateCounter(PredicateType::kOrientation2D);
+    ++counter.n_calls;
+
     // Static filter, adapted from CGAL.
     double pqx = static_cast<double>(q.x) - p.x;
     double pqy = static_cast<double>(q.y) - p.y;
@@ -78,16 +83,33 @@ int Orientation(const Point2D<T>& p, const Point2D<T>& q, const Point2D<T>& r) {
     }
 
     // Interval filter.
-    if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
-    IntervalFloat det1 =
-            OrientationDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
-                                   IntervalFloat(q.x), IntervalFloat(q.y),
-                                   IntervalFloat(r.x), IntervalFloat(r.y));
-    if (det1.lower() > 0.0) return +1;
-    if (det1.upper() < 0.0) return -1;
-    if (det1.lower() == 0.0 && det1.upper() == 0.0) return 0;
-
-    // Exact computation.
+    ++counter.n_interval;
+    {
+        UpwardRounding rounding;
+        IntervalFloat det1 =
+                OrientationDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
+                                       IntervalFloat(q.x), IntervalFloat(q.y),
+                                       IntervalFloat(r.x), IntervalFloat(r.y));
+        if (det1.lower() > 0.0) return +1;
+        if (det1.upper() < 0.0) return -1;
+        if (det1.lower() == 0.0 && det1.upper() == 0.0) return 0;
+    }
+
+    // Exact computation by floating-point expansions.
+    const double v[] = { static_cast<double>(p.x), static_cast<double>(p.y),
+                         static_cast<double>(q.x), static_cast<double>(q.y),
+                         static_cast<double>(r.x), static_cast<double>(r.y) };
+    if (InExpansionRange(v, 6, 2)) {
+        ++counter.n_expansion;
+        FloatExpansion det2 =
+                OrientationDeterminant(FloatExpansion(p.x), FloatExpansion(p.y),
+                                       FloatExpansion(q.x), FloatExpansion(q.y),
+                                       FloatExpansion(r.x), FloatExpansion(r.y));
+        return det2.sign();
+    }
+
+    // Exact computation for the extreme exponents.
+    ++counter.n_exact;
     ExactFloat det2 = OrientationDeterminant(ExactFloat(p.x), ExactFloat(p.y),
                                              ExactFloat(q.x), ExactFloat(q.y),
                                              ExactFloat(r.x), ExactFloat(r.y));
@@ -134,6 +156,9 @@ T IncircleDeterminant(const T& px, const T& py, const T& qx, const T& qy,
 template <typename T>
 int InCircle(const Point2D<T>& p, const Point2D<T>& q,
              const Point2D<T>& r, const Point2D<T>& t) {
+    PredicateCounter& counter = GetPredicateCounter(PredicateType::kInCircle);
+    ++counter.n_calls;
+
     if (p == t || q == t || r == t) return 0;
 
     // Static filter, adapted from CGAL.
@@ -183,17 +208,36 @@ int InCircle(const Point2D<T>& p, const Point2D<T>& q,
     }
 
     // Interval filter.
-    if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
-    IntervalFloat det1 =
-            IncircleDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
-                                IntervalFloat(q.x), IntervalFloat(q.y),
-                                IntervalFloat(r.x), IntervalFloat(r.y),
-                                IntervalFloat(t.x), IntervalFloat(t.y));
-    if (det1.lower() > 0.0) return +1;
-    if (det1.upper() < 0.0) return -1;
-    if (det1.lower() == 0.0 && det1.upper() == 0.0) return 0;
-
-    // Exact computation.
+    ++counter.n_interval;
+    {
+        UpwardRounding rounding;
+        IntervalFloat det1 =
+                IncircleDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
+                                    IntervalFloat(q.x), IntervalFloat(q.y),
+                                    IntervalFloat(r.x), IntervalFloat(r.y),
+                                    IntervalFloat(t.x), IntervalFloat(t.y));
+        if (det1.lower() > 0.0) return +1;
+        if (det1.upper() < 0.0) return -1;
+        if (det1.lower() == 0.0 && det1.upper() == 0.0) return 0;
+    }
+
+    // Exact computation by floating-point expansions.
+    const double v[] = { static_cast<double>(p.x), static_cast<double>(p.y),
+                         static_cast<double>(q.x), static_cast<double>(q.y),
+                         static_cast<double>(r.x), static_cast<double>(r.y),
+                         static_cast<double>(t.x), static_cast<double>(t.y) };
+    if (InExpansionRange(v, 8, 4)) {
+        ++counter.n_expansion;
+        FloatExpansion det1 =
+                IncircleDeterminant(FloatExpansion(p.x), FloatExpansion(p.y),
+                                    FloatExpansion(q.x), FloatExpansion(q.y),
+                                    FloatExpansion(r.x), FloatExpansion(r.y),
+                                    FloatExpansion(t.x), FloatExpansion(t.y));
+        return det1.sign();
+    }
+
+    // Exact computation for the extreme exponents.
+    ++counter.n_exact;
     ExactFloat det = IncircleDeterminant(ExactFloat(p.x), ExactFloat(p.y),
                                          ExactFloat(q.x), ExactFloat(q.y),
                                          ExactFloat(r.x), ExactFloat(r.y),
@@ -10,12 +10,13 @@
 #define CODELIBRARY_GEOMETRY_PREDICATE_3D_H_
 
 #include <algorithm>
-#include <cfenv>
 
 #include "codelibrary/geometry/predicate_2d.h"
 #include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/geometry/predicate_filter.h"
 #include "codelibrary/math/number/determinant.h"
 #include "codelibrary/math/number/exact_float.h"
+#include "codelibrary/math/number/float_expansion.h"
 #include "codelibrary/math/number/interval_float.h"
 
 namespace cl {
@@ -51,6 +52,10 @@ T OrientationDeterminant(const T& px, const T& py, const T& pz,
 template <typename T>
 int Orientation(const Point3D<T>& p, const Point3D<T>& q,
                 const Point3D<T>& r, const Point3D<T>& s) {
+    PredicateCounter& counter =
+            GetPredicateCounter(PredicateType::kOrientation3D);
+    ++counter.n_calls;
+
     // Static filter, adapted from CGAL.
     double px = static_cast<double>(p.x);
     double py = static_cast<double>(p.y);
@@ -113,21 +118,41 @@ int Orientation(const Point3D<T>& p, const Point3D<T>& q,
     }
 
     // Interval filter.
-    if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
-    IntervalFloat det1 =
-            OrientationDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
-                                   IntervalFloat(p.z),
-                                   IntervalFloat(q.x), IntervalFloat(q.y),
-                                   IntervalFloat(q.z),
-                                   IntervalFloat(r.x), IntervalFloat(r.y),
-                                   IntervalFloat(r.z),
-                                   IntervalFloat(s.x), IntervalFloat(s.y),
-                                   IntervalFloat(s.z));
-    if (det1.lower() > 0.0) return 1;
-    if (det1.upper() < 0.0) return -1;
-    if (det1.upper() == 0.0 && det1.lower() == 0.0) return 0;
-
-    // Exact computation.
+    ++counter.n_interval;
+    {
+        UpwardRounding rounding;
+        IntervalFloat det1 =
+                OrientationDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
+                                       IntervalFloat(p.z),
+                                       IntervalFloat(q.x), IntervalFloat(q.y),
+                                       IntervalFloat(q.z),
+                                       IntervalFloat(r.x), IntervalFloat(r.y),
+                                       IntervalFloat(r.z),
+                                       IntervalFloat(s.x), IntervalFloat(s.y),
+                                       IntervalFloat(s.z));
+        if (det1.lower() > 0.0) return 1;
+        if (det1.upper() < 0.0) return -1;
+        if (det1.upper() == 0.0 && det1.lower() == 0.0) return 0;
+    }
+
+    // Exact computation by floating-point expansions.
+    const double v[] = { px, py, pz, qx, qy, qz, rx, ry, rz, sx, sy, sz };
+    if (InExpansionRange(v, 12, 3)) {
+        ++counter.n_expansion;
+        FloatExpansion det2 =
+                OrientationDeterminant(FloatExpansion(p.x), FloatExpansion(p.y),
+                                       FloatExpansion(p.z),
+                                       FloatExpansion(q.x), FloatExpansion(q.y),
+                                       FloatExpansion(q.z),
+                                       FloatExpansion(r.x), FloatExpansion(r.y),
+                                       FloatExpansion(r.z),
+                                       FloatExpansion(s.x), FloatExpansion(s.y),
+                                       FloatExpansion(s.z));
+        return det2.sign();
+    }
+
+    // Exact computation for the extreme exponents.
+    ++counter.n_exact;
     ExactFloat det2 =
             OrientationDeterminant(ExactFloat(p.x), ExactFloat(p.y),
                                    ExactFloat(p.z),
@@ -186,6 +211,9 @@ template <typename T>
 int InShpere(const Point3D<T>& p, const Point3D<T>& q,
              const Point3D<T>& r, const Point3D<T>& s,
              const Point3D<T>& t) {
+    PredicateCounter& counter = GetPredicateCounter(PredicateType::kInSphere);
+    ++counter.n_calls;
+
     // Static filter, adapted from CGAL.
     double px = static_cast<double>(p.x);
     double py = static_cast<double>(p.y);
@@ -266,23 +294,46 @@ int InShpere(const Point3D<T>& p, const Point3D<T>& q,
     }
 
     // Interval filter.
-    if (fegetround() != FE_UPWARD) fesetround(FE_UPWARD);
-    IntervalFloat det1 =
-            InSphereDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
-                                IntervalFloat(p.z),
-                                IntervalFloat(q.x), IntervalFloat(q.y),
-                                IntervalFloat(q.z),
-                                IntervalFloat(r.x), IntervalFloat(r.y),
-                                IntervalFloat(r.z),
-                                IntervalFloat(s.x), IntervalFloat(s.y),
-                                IntervalFloat(s.z),
-                                IntervalFloat(t.x), IntervalFloat(t.y),
-                                IntervalFloat(t.z));
-    if (det1.lower() > 0.0) return 1;
-    if (det1.upper() < 0.0) return -1;
-    if (det1.upper() == 0.0 && det1.lower() == 0.0) return 0;
-
-    // Exact computation.
+    ++counter.n_interval;
+    {
+        UpwardRounding rounding;
+        IntervalFloat det1 =
+                InSphereDeterminant(IntervalFloat(p.x), IntervalFloat(p.y),
+                                    IntervalFloat(p.z),
+                                    IntervalFloat(q.x), IntervalFloat(q.y),
+                                    IntervalFloat(q.z),
+                                    IntervalFloat(r.x), IntervalFloat(r.y),
+                                    IntervalFloat(r.z),
+                                    IntervalFloat(s.x), IntervalFloat(s.y),
+                                    IntervalFloat(s.z),
+                                    IntervalFloat(t.x), IntervalFloat(t.y),
+                                    IntervalFloat(t.z));
+        if (det1.lower() > 0.0) return 1;
+        if (det1.upper() < 0.0) return -1;
+        if (det1.upper() == 0.0 && det1.lower() == 0.0) return 0;
+    }
+
+    // Exact computation by floating-point expansions.
+    const double v[] = { px, py, pz, qx, qy, qz, rx, ry, rz, sx, sy, sz,
+                         tx, ty, tz };
+    if (InExpansionRange(v, 15, 5)) {
+        ++counter.n_expansion;
+        FloatExpansion det1 =
+                InSphereDeterminant(FloatExpansion(p.x), FloatExpansion(p.y),
+                                    FloatExpansion(p.z),
+                                    FloatExpansion(q.x), FloatExpansion(q.y),
+                                    FloatExpansion(q.z),
+                                    FloatExpansion(r.x), FloatExpansion(r.y),
+                                    FloatExpansion(r.z),
+                                    FloatExpansion(s.x), FloatExpansion(s.y),
+                                    FloatExpansion(s.z),
+                                    FloatExpansion(t.x), FloatExpansion(t.y),
+                                    FloatExpansion(t.z));
+        return det1.sign();
+    }
+
+    // Exact computation for the extreme exponents.
+    ++counter.n_exact;
     ExactFloat det =
             InSphereDeterminant(ExactFloat(p.x), ExactFloat(p.y),
                                 ExactFloat(p.z),
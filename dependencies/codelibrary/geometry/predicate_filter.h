@@ -0,0 +1,129 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GEOMETRY_PREDICATE_FILTER_H_
+#define CODELIBRARY_GEOMETRY_PREDICATE_FILTER_H_
+
+#include <cfenv>
+#include <cmath>
+#include <cstdint>
+
+namespace cl {
+namespace geometry {
+
+/**
+ * The geometric predicates that report their filter statistics.
+ */
+enum class PredicateType {
+    kOrientation2D,
+    kInCircle,
+    kOrientation3D,
+    kInSphere
+};
+
+/**
+ * Counters of the filter stages of a geometric predicate.
+ *
+ * A predicate is evaluated by
+ *   1. the semi-static filter in double precision,
+ *   2. interval arithmetic (IntervalFloat) if 1 is uncertain,
+ *   3. exact floating-point expansions (FloatExpansion) if 2 is uncertain,
+ *   4. ExactFloat if the inputs are out of the range of expansions.
+ */
+struct PredicateCounter {
+    uint64_t n_calls = 0;     // All calls.
+    uint64_t n_interval = 0;  // Calls that reach the interval stage.
+    uint64_t n_expansion = 0; // Calls resolved by expansions.
+    uint64_t n_exact = 0;     // Calls resolved by ExactFloat.
+
+    /**
+     * Return the fraction of calls resolved by the semi-static filter.
+     */
+    double static_hit_rate() const {
+        return n_calls == 0 ? 1.0 : 1.0 - double(n_interval) / n_calls;
+    }
+
+    /**
+     * Return the fraction of calls resolved by the interval filter.
+     */
+    double interval_hit_rate() const {
+        return n_calls == 0 ? 0.0
+                            : double(n_interval - n_expansion - n_exact) /
+                              n_calls;
+    }
+};
+
+/**
+ * Return the counters of the given predicate. The counters are per thread, so
+ * they cost no synchronization in parallel code.
+ */
+inline PredicateCounter& GetPredicateCounter(PredicateType type) {
+    static thread_local PredicateCounter counters[4];
+    return counters[static_cast<int>(type)];
+}
+
+/**
+ * Reset the counters of all predicates of the current thread.
+ */
+inline void ResetPredicateCounters() {
+    GetPredicateCounter(PredicateType::kOrientation2D) = PredicateCounter();
+    GetPredicateCounter(PredicateType::kInCircle) = PredicateCounter();
+    GetPredicateCounter(PredicateType::kOrientation3D) = PredicateCounter();
+    GetPredicateCounter(PredicateType::kInSphere) = PredicateCounter();
+}
+
+/**
+ * Set the FP rounding to FE_UPWARD for IntervalFloat in the current scope, and
+ * restore the previous rounding on exit.
+ *
+ * The semi-static filters and FloatExpansion assume FE_TONEAREST, so the
+ * rounding mode must not leak out of the interval stage.
+ */
+class UpwardRounding {
+public:
+    UpwardRounding()
+        : mode_(std::fegetround()) {
+        if (mode_ != FE_UPWARD) std::fesetround(FE_UPWARD);
+    }
+
+    UpwardRounding(const UpwardRounding&) = delete;
+
+    UpwardRounding& operator=(const UpwardRounding&) = delete;
+
+    ~UpwardRounding() {
+        if (mode_ != FE_UPWARD) std::fesetround(mode_);
+    }
+
+private:
+    int mode_;
+};
+
+/**
+ * Check if a polynomial of the given degree in the n values can be evaluated
+ * exactly by FloatExpansion, i.e., every nonzero |v| is in [2^-k, 2^k] for the
+ * largest k such that no intermediate value overflows or underflows.
+ *
+ * Nonzero values of at least 2^-k are multiples of 2^(-k-52), and so is their
+ * difference; a product of 'degree' such factors never underflows if
+ * degree * (k + 52) <= 1074.
+ */
+inline bool InExpansionRange(const double* values, int n, int degree) {
+    const int k = 1074 / degree - 52 - 2;
+    const double lower = std::ldexp(1.0, -k);
+    const double upper = std::ldexp(1.0, k);
+    for (int i = 0; i < n; ++i) {
+        const double v = std::fabs(values[i]);
+        if (v != 0.0 && (v < lower || v > upper)) return false;
+    }
+    return true;
+}
+
+} // namespace geometry
+} // namespace cl
+
+#endif // CODELIBRARY_GEOMETRY_PREDICATE_FILTER_H_
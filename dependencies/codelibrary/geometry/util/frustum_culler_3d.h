@@ -0,0 +1,143 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_H_
+#define CODELIBRARY_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_H_
+
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/frustum_3d.h"
+#include "codelibrary/util/tree/aabb_tree.h"
+
+namespace cl {
+namespace geometry {
+
+/**
+ * Hierarchical frustum culling of the objects in an AABBTree.
+ *
+ * The tree is traversed from the root. A subtree is skipped once its box is
+ * outside the frustum, and all its objects are accepted without more tests
+ * once its box is inside. The tests use plane-coherency:
+ *  - Masking: the planes that contain a box are not tested for its children.
+ *  - Temporal coherency: the plane that culled a node in the last call is
+ *    tested first for this node, since the camera moves smoothly.
+ *
+ * An optional occlusion hook, 'occluded(box)', is called for each visited
+ * node that is not culled by the frustum; it returns true to skip the whole
+ * subtree (e.g., by a hierarchical depth buffer test). The subtrees inside the
+ * frustum are accepted without visiting their nodes, so the result is
+ * conservative.
+ *
+ * It does not depend on OpenGL, so it can run headlessly.
+ */
+template <typename T, typename Value>
+class FrustumCuller3D {
+public:
+    using Tree = AABBTree<T, Value>;
+    using Frustum = Frustum3D<T>;
+
+    /**
+     * Default occlusion hook, nothing is occluded.
+     */
+    struct NoOcclusion {
+        bool operator() (const Box3D<T>&) const {
+            return false;
+        }
+    };
+
+    FrustumCuller3D() = default;
+
+    /**
+     * Get the values of the objects that may be visible.
+     */
+    void Cull(const Tree& tree, const Frustum& frustum,
+              Array<Value>* values) {
+        Cull(tree, frustum, NoOcclusion(), values);
+    }
+
+    template <typename Occlusion>
+    void Cull(const Tree& tree, const Frustum& frustum,
+              const Occlusion& occluded, Array<Value>* values) {
+        CHECK(values);
+
+        values->clear();
+        n_visited_nodes_ = 0;
+        if (tree.empty()) return;
+
+        // Planes that culled the nodes in the last call.
+        start_planes_.resize(tree.capacity(), 0);
+
+        // Pairs of the node and the mask of the planes containing it.
+        stack_.clear();
+        stack_.emplace_back(tree.root(), 0);
+        while (!stack_.empty()) {
+            int id = stack_.back().first;
+            int mask = stack_.back().second;
+            stack_.pop_back();
+            ++n_visited_nodes_;
+
+            const auto& node = tree.node(id);
+            typename Frustum::Relation relation =
+                    frustum.Classify(node.box, &mask, &start_planes_[id]);
+            if (relation == Frustum::OUTSIDE) continue;
+            if (occluded(node.box)) continue;
+
+            if (relation == Frustum::INSIDE) {
+                CollectLeaves(tree, id, values);
+            } else if (node.is_leaf()) {
+                // The fat box intersects the frustum, test the object box.
+                int object_mask = mask;
+                if (frustum.Classify(node.object_box, &object_mask) !=
+                    Frustum::OUTSIDE) {
+                    values->push_back(node.value);
+                }
+            } else {
+                stack_.emplace_back(node.children[0], mask);
+                stack_.emplace_back(node.children[1], mask);
+            }
+        }
+    }
+
+    /**
+     * Return the number of visited tree nodes in the last call.
+     */
+    int n_visited_nodes() const {
+        return n_visited_nodes_;
+    }
+
+private:
+    /**
+     * Collect the values of all leaves in the subtree.
+     */
+    void CollectLeaves(const Tree& tree, int root, Array<Value>* values) {
+        leaf_stack_.clear();
+        leaf_stack_.push_back(root);
+        while (!leaf_stack_.empty()) {
+            const auto& node = tree.node(leaf_stack_.back());
+            leaf_stack_.pop_back();
+            if (node.is_leaf()) {
+                values->push_back(node.value);
+            } else {
+                leaf_stack_.push_back(node.children[0]);
+                leaf_stack_.push_back(node.children[1]);
+            }
+        }
+    }
+
+    Array<int> start_planes_;
+    Array<std::pair<int, int>> stack_;
+    Array<int> leaf_stack_;
+    int n_visited_nodes_ = 0;
+};
+
+} // namespace geometry
+} // namespace cl
+
+#endif // CODELIBRARY_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_H_
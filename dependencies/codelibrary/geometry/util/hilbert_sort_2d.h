@@ -0,0 +1,155 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GEOMETRY_UTIL_HILBERT_SORT_2D_H_
+#define CODELIBRARY_GEOMETRY_UTIL_HILBERT_SORT_2D_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/point_2d.h"
+
+namespace cl {
+namespace geometry {
+
+namespace hilbert_sort_2d_internal {
+
+/**
+ * Compute the keys of the points along the Hilbert curve over a 2^16 x 2^16
+ * grid of their bounding box. keys[i] is (hilbert index << 32) | i.
+ */
+template <typename T>
+void HilbertKeys(const Array<Point2D<T>>& points, Array<uint64_t>* keys) {
+    const int n = points.size();
+    keys->resize(n);
+    if (n == 0) return;
+
+    double x_min = points[0].x, x_max = points[0].x;
+    double y_min = points[0].y, y_max = points[0].y;
+    for (const Point2D<T>& p : points) {
+        x_min = std::min(x_min, static_cast<double>(p.x));
+        x_max = std::max(x_max, static_cast<double>(p.x));
+        y_min = std::min(y_min, static_cast<double>(p.y));
+        y_max = std::max(y_max, static_cast<double>(p.y));
+    }
+
+    // Use the same scale on both axes, so that the cells are square.
+    const int order = 16;
+    const uint32_t side = 1u << order;
+    double length = std::max(x_max - x_min, y_max - y_min);
+    double scale = length > 0.0 ? (side - 1) / length : 0.0;
+
+    #pragma omp parallel for if (n > 65536)
+    for (int i = 0; i < n; ++i) {
+        uint32_t x = static_cast<uint32_t>((points[i].x - x_min) * scale);
+        uint32_t y = static_cast<uint32_t>((points[i].y - y_min) * scale);
+        x = std::min(x, side - 1);
+        y = std::min(y, side - 1);
+
+        uint64_t d = 0;
+        for (uint32_t s = side >> 1; s > 0; s >>= 1) {
+            uint32_t rx = (x & s) ? 1 : 0;
+            uint32_t ry = (y & s) ? 1 : 0;
+            d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+            // Rotate the quadrant.
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        (*keys)[i] = (d << 32) | static_cast<uint32_t>(i);
+    }
+}
+
+} // namespace hilbert_sort_2d_internal
+
+/**
+ * Sort the points along a Hilbert curve, so that points close in the order
+ * are close in the plane.
+ *
+ * Output:
+ *   order - order[i] is the index of the i-th point in the Hilbert order.
+ */
+template <typename T>
+void HilbertSort(const Array<Point2D<T>>& points, Array<int>* order) {
+    CHECK(order);
+
+    Array<uint64_t> keys;
+    hilbert_sort_2d_internal::HilbertKeys(points, &keys);
+    std::sort(keys.begin(), keys.end());
+
+    order->resize(points.size());
+    for (int i = 0; i < keys.size(); ++i) {
+        (*order)[i] = static_cast<int>(keys[i] & 0xffffffffu);
+    }
+}
+
+/**
+ * Biased randomized insertion order (BRIO) of the points.
+ *
+ * The points are shuffled and split into rounds of doubling sizes; the points
+ * of each round are sorted along a Hilbert curve. Incremental constructions
+ * (e.g., Delaunay triangulation) inserting the points in this order keep the
+ * expected complexity of a random order, while consecutive points are close,
+ * so the point location walks are short and cache friendly.
+ *
+ * Reference:
+ *   Amenta N, Choi S, Rote G. Incremental constructions con BRIO [C].
+ *   Proceedings of the Symposium on Computational Geometry, 2003: 211-219.
+ */
+template <typename T, typename RandomEngine>
+void BRIOSort(const Array<Point2D<T>>& points, RandomEngine* random,
+              Array<int>* order) {
+    CHECK(random);
+    CHECK(order);
+
+    const int n = points.size();
+    Array<uint64_t> keys;
+    hilbert_sort_2d_internal::HilbertKeys(points, &keys);
+    std::shuffle(keys.begin(), keys.end(), *random);
+
+    // The last round has half of the points, the one before a quarter, ...
+    // Rounds with less than 'min_round' points are merged into the first.
+    const int min_round = 64;
+    Array<int> ends;
+    for (int end = n; end > min_round; end /= 2) {
+        ends.push_back(end);
+    }
+    ends.push_back(std::min(n, min_round));
+    std::reverse(ends.begin(), ends.end());
+
+    int begin = 0;
+    for (int end : ends) {
+        std::sort(keys.begin() + begin, keys.begin() + end);
+        begin = end;
+    }
+
+    order->resize(n);
+    for (int i = 0; i < n; ++i) {
+        (*order)[i] = static_cast<int>(keys[i] & 0xffffffffu);
+    }
+}
+
+template <typename T>
+void BRIOSort(const Array<Point2D<T>>& points, Array<int>* order) {
+    std::mt19937 random;
+    BRIOSort(points, &random, order);
+}
+
+} // namespace geometry
+} // namespace cl
+
+#endif // CODELIBRARY_GEOMETRY_UTIL_HILBERT_SORT_2D_H_
@@ -103,7 +103,8 @@ public:
         CHECK(y_resolution_ != 0);
         CHECK(z_resolution_ != 0);
 
-        return Insert(GetXIndex(p.x), GetYIndex(p.y), GetZIndex(p.z), true);
+        return this->Insert(GetXIndex(p.x), GetYIndex(p.y), GetZIndex(p.z),
+                            true);
     }
 
     /**
@@ -229,6 +230,29 @@ public:
         }
     }
 
+    /**
+     * Rasterize the voxels into a dense resolution^3 grid, indexed by
+     * (k * resolution + j) * resolution + i for voxel (i, j, k). Occupied
+     * voxels are set to 1, the others to 0.
+     *
+     * The grid can be passed to image::EuclideanDistanceTransformND (with
+     * shape {resolution, resolution, resolution}) to get a distance field.
+     */
+    void ToOccupancyGrid(Array<uint8_t>* grid) const {
+        CHECK(grid);
+
+        const int n = this->resolution_;
+        grid->assign(n * n * n, 0);
+        for (const auto& pair : this->nodes_) {
+            const Node* node = pair.second;
+            if (!this->is_leaf(node)) continue;
+
+            int x, y, z, d;
+            node->get_position(&x, &y, &z, &d);
+            (*grid)[(z * n + y) * n + x] = 1;
+        }
+    }
+
     const Box3D<T>& box() const {
         return box_;
     }
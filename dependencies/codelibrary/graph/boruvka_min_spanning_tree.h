@@ -0,0 +1,142 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GRAPH_BORUVKA_MIN_SPANNING_TREE_H_
+#define CODELIBRARY_GRAPH_BORUVKA_MIN_SPANNING_TREE_H_
+
+#include <algorithm>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/util/set/disjoint_set.h"
+
+namespace cl {
+namespace graph {
+
+/**
+ * Parallel Boruvka algorithm to get the minimum spanning forest of a CSRGraph.
+ *
+ * In each round, every vertex finds in parallel its cheapest arc to another
+ * component; the cheapest arc of each component is then added to the forest,
+ * which at least halves the number of components. Ties are broken by the
+ * edge id min(arc, twin), so all arcs are totally ordered and the chosen arcs
+ * never form a cycle. Arcs inside a component are dropped from the scan, so
+ * later rounds are cheaper.
+ *
+ * The time complexity is O(E log(V)) work in O(log(V)) rounds.
+ *
+ * Parameters:
+ *   graph    - the graph, every arc must have a twin of the same weight.
+ *   weight   - the weight of each arc.
+ *   mst_arcs - the output arcs (one per edge) of the minimum spanning forest.
+ *
+ * Return:
+ *   the sum of the weights of the minimum spanning forest.
+ */
+template <typename T>
+T BoruvkaMinSpanningTree(const CSRGraph& graph,
+                         const Array<T>& weight,
+                         Array<int>* mst_arcs = nullptr) {
+    CHECK(weight.size() == graph.n_arcs());
+
+    const int n = graph.n_vertices();
+    if (mst_arcs) {
+        mst_arcs->clear();
+        mst_arcs->reserve(n > 0 ? n - 1 : 0);
+    }
+
+    // Whether arc a is better than arc b (b may be -1).
+    auto less = [&](int a, int b) {
+        if (b < 0) return true;
+        if (weight[a] != weight[b]) return weight[a] < weight[b];
+        return std::min(a, graph.twin(a)) < std::min(b, graph.twin(b));
+    };
+
+    Array<int> component(n);
+    for (int v = 0; v < n; ++v) {
+        component[v] = v;
+    }
+
+    // The arcs of v still to scan are [arc_begin[v], arc_end[v]); arcs inside
+    // a component are moved out of this range.
+    Array<int> arcs(n > 0 ? graph.arcs_end(n - 1) : 0);
+    Array<int> arc_begin(n), arc_end(n);
+    for (int v = 0; v < n; ++v) {
+        arc_begin[v] = graph.arcs_begin(v);
+        arc_end[v] = graph.arcs_end(v);
+        for (int a = arc_begin[v]; a < arc_end[v]; ++a) {
+            int t = graph.twin(a);
+            CHECK(t >= 0 && weight[a] == weight[t]) <<
+                "The twin arcs must have the same weight.";
+            arcs[a] = a;
+        }
+    }
+
+    Array<int> cheapest(n), best(n, -1);
+    Array<int> roots;
+    DisjointSet disjoint_set(n);
+    T sum = T(0);
+
+    while (true) {
+        // Find the cheapest out-going arc of each vertex.
+        #pragma omp parallel for schedule(dynamic, 256) if (n > 4096)
+        for (int v = 0; v < n; ++v) {
+            int c = component[v];
+            int result = -1;
+            int i = arc_begin[v];
+            while (i < arc_end[v]) {
+                int a = arcs[i];
+                if (component[graph.target(a)] == c) {
+                    // Internal arcs stay internal.
+                    arcs[i] = arcs[--arc_end[v]];
+                    continue;
+                }
+                if (less(a, result)) result = a;
+                ++i;
+            }
+            cheapest[v] = result;
+        }
+
+        // Reduce to the cheapest arc of each component.
+        roots.clear();
+        for (int v = 0; v < n; ++v) {
+            int a = cheapest[v];
+            if (a < 0) continue;
+
+            int c = component[v];
+            if (best[c] < 0) roots.push_back(c);
+            if (less(a, best[c])) best[c] = a;
+        }
+        if (roots.empty()) break;
+
+        // Merge. Two components may choose the same edge from both sides.
+        for (int c : roots) {
+            int a = best[c];
+            best[c] = -1;
+
+            int u = graph.target(graph.twin(a)), w = graph.target(a);
+            if (disjoint_set.Find(u) == disjoint_set.Find(w)) continue;
+
+            disjoint_set.Union(u, w);
+            sum += weight[a];
+            if (mst_arcs) mst_arcs->push_back(a);
+        }
+
+        for (int v = 0; v < n; ++v) {
+            component[v] = disjoint_set.Find(v);
+        }
+    }
+
+    return sum;
+}
+
+} // namespace graph
+} // namespace cl
+
+#endif // CODELIBRARY_GRAPH_BORUVKA_MIN_SPANNING_TREE_H_
@@ -0,0 +1,196 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GRAPH_CSR_GRAPH_H_
+#define CODELIBRARY_GRAPH_CSR_GRAPH_H_
+
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/graph/graph.h"
+
+namespace cl {
+
+/**
+ * Immutable graph in compressed sparse row (CSR) form.
+ *
+ * The out-going arcs of vertex v are the contiguous ids [arcs_begin(v),
+ * arcs_end(v)), and the targets and twins of all arcs are stored in two flat
+ * arrays. Arc properties such as capacities are plain arrays indexed by arc
+ * id (structure of arrays) instead of per-edge objects, so traversals stream
+ * through memory instead of chasing list pointers.
+ *
+ * Both CSRGraph and GridGraph provide the arc interface used by the array
+ * based algorithms (see ParallelPushRelabelMaxFlow):
+ *
+ *   int n_vertices() const;
+ *   int n_arcs() const;
+ *   void ForEachArc(int v, f) const; // Call f(arc, target, twin).
+ */
+class CSRGraph {
+public:
+    CSRGraph() = default;
+
+    CSRGraph(int n_vertices, const Array<std::pair<int, int>>& edges) {
+        Reset(n_vertices, edges);
+    }
+
+    explicit CSRGraph(const Graph& graph) {
+        Reset(graph);
+    }
+
+    /**
+     * Build the graph from two-way edges. Edge i = (u, v) creates the arc
+     * u -> v, whose id is edge_arc(i), and its twin v -> u.
+     */
+    void Reset(int n_vertices, const Array<std::pair<int, int>>& edges) {
+        CHECK(n_vertices >= 0);
+
+        n_vertices_ = n_vertices;
+        int n_edges = edges.size();
+        n_arcs_ = 2 * n_edges;
+
+        // Counting sort of the arcs by source.
+        offsets_.assign(n_vertices_ + 1, 0);
+        for (const std::pair<int, int>& e : edges) {
+            CHECK(e.first >= 0 && e.first < n_vertices_);
+            CHECK(e.second >= 0 && e.second < n_vertices_);
+
+            ++offsets_[e.first + 1];
+            ++offsets_[e.second + 1];
+        }
+        for (int v = 0; v < n_vertices_; ++v) {
+            offsets_[v + 1] += offsets_[v];
+        }
+
+        Array<int> position(offsets_.begin(), offsets_.end() - 1);
+        targets_.resize(n_arcs_);
+        twins_.resize(n_arcs_);
+        edge_arcs_.resize(n_edges);
+        for (int i = 0; i < n_edges; ++i) {
+            int u = edges[i].first, v = edges[i].second;
+            int a = position[u]++;
+            int b = position[v]++;
+            targets_[a] = v;
+            targets_[b] = u;
+            twins_[a] = b;
+            twins_[b] = a;
+            edge_arcs_[i] = a;
+        }
+    }
+
+    /**
+     * Build the graph from an adjacency list graph. The arcs of each vertex
+     * keep the order of graph.edges_from(v), and edge e becomes the arc
+     * edge_arc(e->id()). Edges without twin get twin -1.
+     */
+    void Reset(const Graph& graph) {
+        n_vertices_ = graph.n_vertices();
+        n_arcs_ = graph.n_edges();
+
+        offsets_.resize(n_vertices_ + 1);
+        targets_.resize(n_arcs_);
+        twins_.resize(n_arcs_);
+        edge_arcs_.assign(graph.n_allocated_edges(), -1);
+
+        int a = 0;
+        for (int v = 0; v < n_vertices_; ++v) {
+            offsets_[v] = a;
+            for (const Graph::Edge* e : graph.edges_from(v)) {
+                targets_[a] = e->target();
+                edge_arcs_[e->id()] = a++;
+            }
+        }
+        offsets_[n_vertices_] = a;
+
+        for (int v = 0; v < n_vertices_; ++v) {
+            for (const Graph::Edge* e : graph.edges_from(v)) {
+                twins_[edge_arcs_[e->id()]] = e->twin() ?
+                        edge_arcs_[e->twin()->id()] : -1;
+            }
+        }
+    }
+
+    /**
+     * Copy an edge property of the graph that built this CSRGraph into an
+     * array indexed by arc.
+     */
+    template <typename T>
+    void GetArcProperty(const Graph& graph,
+                        const Graph::EdgeProperty<T>& property,
+                        Array<T>* values) const {
+        CHECK(values);
+        CHECK(graph.n_vertices() == n_vertices_);
+
+        values->resize(n_arcs_);
+        for (int v = 0; v < n_vertices_; ++v) {
+            for (const Graph::Edge* e : graph.edges_from(v)) {
+                (*values)[edge_arcs_[e->id()]] = property[e];
+            }
+        }
+    }
+
+    /**
+     * Call f(arc, target, twin) for every out-going arc of v.
+     */
+    template <typename Function>
+    void ForEachArc(int v, Function f) const {
+        for (int a = offsets_[v]; a < offsets_[v + 1]; ++a) {
+            f(a, targets_[a], twins_[a]);
+        }
+    }
+
+    int n_vertices() const {
+        return n_vertices_;
+    }
+
+    int n_arcs() const {
+        return n_arcs_;
+    }
+
+    int arcs_begin(int v) const {
+        return offsets_[v];
+    }
+
+    int arcs_end(int v) const {
+        return offsets_[v + 1];
+    }
+
+    int degree(int v) const {
+        return offsets_[v + 1] - offsets_[v];
+    }
+
+    int target(int arc) const {
+        return targets_[arc];
+    }
+
+    int twin(int arc) const {
+        return twins_[arc];
+    }
+
+    /**
+     * Return the arc of the i-th input edge (or of the edge with id i, if the
+     * graph was built from a Graph).
+     */
+    int edge_arc(int i) const {
+        return edge_arcs_[i];
+    }
+
+private:
+    int n_vertices_ = 0;
+    int n_arcs_ = 0;
+    Array<int> offsets_;   // Arcs of v are [offsets_[v], offsets_[v + 1]).
+    Array<int> targets_;   // Target vertex of each arc.
+    Array<int> twins_;     // Reverse arc of each arc, or -1.
+    Array<int> edge_arcs_; // Arc of each input edge.
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_GRAPH_CSR_GRAPH_H_
@@ -0,0 +1,347 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GRAPH_DELTA_STEPPING_SHORTEST_PATHS_H_
+#define CODELIBRARY_GRAPH_DELTA_STEPPING_SHORTEST_PATHS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+namespace graph {
+
+/**
+ * Parallel delta-stepping single-source shortest paths (Meyer and Sanders,
+ * 2003) with non-negative weights over CSRGraph or GridGraph.
+ *
+ * Vertices are kept in buckets of width delta by tentative distance. The
+ * smallest bucket is emptied in phases: all its vertices relax their light
+ * arcs (weight <= delta) in parallel, which may refill the bucket; then the
+ * vertices removed from the bucket relax their heavy arcs once. A large delta
+ * gives more parallelism and fewer phases, but more re-relaxations; delta = 0
+ * selects the average arc weight, which keeps the number of phases small on
+ * geometric graphs, whose weights are similar.
+ *
+ * To run without atomic compare-and-swap, the vertices are split into
+ * N_PARTITIONS contiguous ranges, each with its own buckets. Every phase has
+ * two parallel steps: each partition scans its own frontier and writes the
+ * relaxation requests (target, distance, predecessor) into one list per
+ * target partition; then each partition applies the requests addressed to
+ * it. So every distance, predecessor and bucket is written by one thread.
+ * The requests are applied in partition order, so the result does not depend
+ * on the number of threads.
+ *
+ * Unreachable vertices get distance std::numeric_limits<T>::max() and
+ * predecessor -1.
+ *
+ * Usage:
+ *
+ *   DeltaSteppingShortestPaths<double> shortest_paths;
+ *   shortest_paths(graph, weight, source, &predecessors, &distances);
+ */
+template <typename T>
+class DeltaSteppingShortestPaths {
+    static_assert(std::is_arithmetic<T>::value, "");
+
+    // The number of vertex partitions.
+    static const int N_PARTITIONS = 64;
+
+    // The maximal number of cyclic buckets. A smaller delta is enlarged.
+    static const int MAX_BUCKETS = 1 << 16;
+
+    struct Request {
+        int target;
+        int predecessor;
+        T distance;
+    };
+
+public:
+    /**
+     * Input delta is the bucket width, or 0 to select it from the graph.
+     */
+    explicit DeltaSteppingShortestPaths(T delta = T(0))
+        : delta_(delta) {
+        CHECK(delta >= T(0));
+    }
+
+    /**
+     * Compute the shortest paths from 'source'.
+     *
+     * Input:
+     *  graph        - CSRGraph or GridGraph.
+     *  weight       - the non-negative weight of each arc.
+     *  source       - the source vertex.
+     *
+     * Output:
+     *  predecessors - predecessors[v] is the previous vertex on the shortest
+     *                 path to v, or -1.
+     *  distances    - distances[v] is the shortest distance to v.
+     */
+    template <typename ArcGraph>
+    void operator() (const ArcGraph& graph,
+                     const Array<T>& weight,
+                     int source,
+                     Array<int>* predecessors,
+                     Array<T>* distances) {
+        Array<int> sources(1, source);
+        (*this)(graph, weight, sources, predecessors, distances);
+    }
+
+    /**
+     * Compute the shortest paths from the nearest of several sources.
+     */
+    template <typename ArcGraph>
+    void operator() (const ArcGraph& graph,
+                     const Array<T>& weight,
+                     const Array<int>& sources,
+                     Array<int>* predecessors,
+                     Array<T>* distances) {
+        CHECK(predecessors && distances);
+        CHECK(weight.size() == graph.n_arcs());
+
+        const int n = graph.n_vertices();
+        predecessors->assign(n, -1);
+        distances->assign(n, std::numeric_limits<T>::max());
+        pred_ = predecessors->data();
+        dist_ = distances->data();
+        if (n == 0) return;
+
+        T max_weight = T(0);
+        double sum_weight = 0.0;
+        for (const T& w : weight) {
+            CHECK(w >= T(0));
+            max_weight = std::max(max_weight, w);
+            sum_weight += static_cast<double>(w);
+        }
+        T average_weight = weight.empty() ? T(0) :
+                static_cast<T>(sum_weight / weight.size());
+        InitializeBuckets(n, max_weight, average_weight);
+
+        queued_.assign(n, 0);
+        settled_.assign(n, 0);
+        for (int s : sources) {
+            CHECK(0 <= s && s < n);
+
+            if (queued_[s]) continue;
+            dist_[s] = T(0);
+            queued_[s] = 1;
+            buckets_[Owner(s)][0].push_back(s);
+        }
+
+        int64_t current = 0;
+        while (NextBucket(&current)) {
+            int slot = static_cast<int>(current % n_buckets_);
+
+            // Light phases, until the current bucket stays empty.
+            for (int p = 0; p < N_PARTITIONS; ++p) {
+                removed_[p].clear();
+            }
+            while (true) {
+                bool has_vertex = false;
+                for (int p = 0; p < N_PARTITIONS; ++p) {
+                    if (!buckets_[p][slot].empty()) has_vertex = true;
+                }
+                if (!has_vertex) break;
+
+                #pragma omp parallel for schedule(dynamic)
+                for (int p = 0; p < N_PARTITIONS; ++p) {
+                    ScanFrontier(graph, weight, p, slot, current);
+                }
+                ApplyRequests();
+            }
+
+            // Heavy phase.
+            #pragma omp parallel for schedule(dynamic)
+            for (int p = 0; p < N_PARTITIONS; ++p) {
+                for (int v : removed_[p]) {
+                    settled_[v] = 0;
+                    RelaxArcs(graph, weight, p, v, false);
+                }
+            }
+            ApplyRequests();
+
+            ++current;
+        }
+    }
+
+    /**
+     * Return the bucket width used by the last call.
+     */
+    T delta() const {
+        return used_delta_;
+    }
+
+private:
+    /**
+     * Select the bucket width and clear the buckets.
+     */
+    void InitializeBuckets(int n, T max_weight, T average_weight) {
+        T delta = delta_ == T(0) ? average_weight : delta_;
+        delta = std::max(delta, static_cast<T>(max_weight / (MAX_BUCKETS - 3)));
+        if (delta <= T(0)) delta = T(1);
+        used_delta_ = delta;
+
+        // A relaxation from bucket i lands at most in bucket
+        // i + max_weight / delta + 1, so the buckets can be reused cyclically.
+        // One more bucket absorbs the rounding of floating point distances.
+        n_buckets_ = static_cast<int>(max_weight / delta) + 3;
+        partition_size_ = (n + N_PARTITIONS - 1) / N_PARTITIONS;
+
+        buckets_.resize(N_PARTITIONS);
+        requests_.resize(N_PARTITIONS * N_PARTITIONS);
+        removed_.resize(N_PARTITIONS);
+        frontiers_.resize(N_PARTITIONS);
+
+        for (int p = 0; p < N_PARTITIONS; ++p) {
+            buckets_[p].resize(n_buckets_);
+            for (Array<int>& bucket : buckets_[p]) {
+                bucket.clear();
+            }
+            for (int q = 0; q < N_PARTITIONS; ++q) {
+                requests_[p * N_PARTITIONS + q].clear();
+            }
+        }
+    }
+
+    /**
+     * Find the first bucket at or after 'current' with any vertex. Return
+     * false if all buckets are empty.
+     */
+    bool NextBucket(int64_t* current) const {
+        for (int i = 0; i < n_buckets_; ++i) {
+            int slot = static_cast<int>((*current + i) % n_buckets_);
+            for (int p = 0; p < N_PARTITIONS; ++p) {
+                if (!buckets_[p][slot].empty()) {
+                    *current += i;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Remove the vertices of partition p from the current bucket and relax
+     * their light arcs. Stale entries, whose vertex has moved to a smaller
+     * bucket, are dropped.
+     */
+    template <typename ArcGraph>
+    void ScanFrontier(const ArcGraph& graph, const Array<T>& weight, int p,
+                      int slot, int64_t current) {
+        Array<int>& frontier = frontiers_[p];
+        frontier.clear();
+        frontier.swap(buckets_[p][slot]);
+
+        for (int v : frontier) {
+            if (!queued_[v] || Bucket(dist_[v]) != current) continue;
+
+            queued_[v] = 0;
+            if (!settled_[v]) {
+                settled_[v] = 1;
+                removed_[p].push_back(v);
+            }
+            RelaxArcs(graph, weight, p, v, true);
+        }
+    }
+
+    /**
+     * Write the relaxation requests of the light or heavy arcs of v, a vertex
+     * of partition p. Distances are only read here.
+     */
+    template <typename ArcGraph>
+    void RelaxArcs(const ArcGraph& graph, const Array<T>& weight, int p, int v,
+                   bool light) {
+        const T d = dist_[v];
+        const T delta = used_delta_;
+        graph.ForEachArc(v, [&](int a, int w, int t) {
+            (void)t;
+            if ((weight[a] <= delta) != light) return;
+
+            T nd = d + weight[a];
+            if (nd < dist_[w]) {
+                Request request;
+                request.target = w;
+                request.predecessor = v;
+                request.distance = nd;
+                requests_[p * N_PARTITIONS + Owner(w)].push_back(request);
+            }
+        });
+    }
+
+    /**
+     * Apply all requests in parallel, each partition applying the requests of
+     * its own vertices.
+     */
+    void ApplyRequests() {
+        #pragma omp parallel for schedule(dynamic)
+        for (int q = 0; q < N_PARTITIONS; ++q) {
+            for (int p = 0; p < N_PARTITIONS; ++p) {
+                Array<Request>& requests = requests_[p * N_PARTITIONS + q];
+                for (const Request& r : requests) {
+                    int w = r.target;
+                    if (r.distance >= dist_[w]) continue;
+
+                    // Keep the entry if w is already queued in the same
+                    // bucket.
+                    int64_t b = Bucket(r.distance);
+                    bool same_bucket = queued_[w] && Bucket(dist_[w]) == b;
+                    dist_[w] = r.distance;
+                    pred_[w] = r.predecessor;
+                    if (!same_bucket) {
+                        queued_[w] = 1;
+                        buckets_[q][static_cast<int>(b % n_buckets_)]
+                                .push_back(w);
+                    }
+                }
+                requests.clear();
+            }
+        }
+    }
+
+    int64_t Bucket(T distance) const {
+        return static_cast<int64_t>(distance / used_delta_);
+    }
+
+    int Owner(int v) const {
+        return v / partition_size_;
+    }
+
+    T delta_;                // Bucket width given by the user, or 0.
+    T used_delta_ = T(0);    // Bucket width of the last call.
+    int n_buckets_ = 0;      // Number of cyclic buckets.
+    int partition_size_ = 1; // Number of vertices of each partition.
+
+    int* pred_ = nullptr;
+    T* dist_ = nullptr;
+
+    Array<char> queued_;  // Whether the vertex has a valid bucket entry.
+    Array<char> settled_; // Whether the vertex is in removed_ of this bucket.
+
+    // buckets_[p][i] is the i-th cyclic bucket of partition p.
+    Array<Array<Array<int>>> buckets_;
+
+    // requests_[p * N_PARTITIONS + q] are the requests from partition p to
+    // partition q.
+    Array<Array<Request>> requests_;
+
+    // Vertices removed from the current bucket, per partition.
+    Array<Array<int>> removed_;
+
+    // Scan buffer of each partition.
+    Array<Array<int>> frontiers_;
+};
+
+} // namespace graph
+} // namespace cl
+
+#endif // CODELIBRARY_GRAPH_DELTA_STEPPING_SHORTEST_PATHS_H_
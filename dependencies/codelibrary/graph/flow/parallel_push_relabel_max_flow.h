@@ -0,0 +1,378 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GRAPH_FLOW_PARALLEL_PUSH_RELABEL_MAX_FLOW_H_
+#define CODELIBRARY_GRAPH_FLOW_PARALLEL_PUSH_RELABEL_MAX_FLOW_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/graph/grid_graph.h"
+
+namespace cl {
+namespace graph {
+
+/**
+ * Synchronous parallel push-relabel max flow for graph cuts over CSRGraph or
+ * GridGraph.
+ *
+ * The network is the usual graph-cut form: every vertex v may have an arc from
+ * the source terminal with capacity source_capacity[v], and an arc to the sink
+ * terminal with capacity sink_capacity[v]; the other arcs have capacity
+ * capacity[arc]. The terminals are not vertices of the graph.
+ *
+ * The algorithm works in rounds. In each round, all active vertices (those
+ * with excess and a label below the maximum) are discharged in parallel
+ * against the labels of the previous round: a vertex pushes to its lowest
+ * residual neighbor if that neighbor is lower, and otherwise relabels once
+ * and waits for the next round (Hong and He, 2011; Baumstark, Blelloch and
+ * Shun, 2015). With frozen labels, two vertices never push over the same
+ * edge pair in one round, so every arc is written by a single thread. But a
+ * vertex scans its arcs while its neighbors push to it and add to the same
+ * arcs, so the residual capacities are read and written with OpenMP atomics,
+ * as is the excess received by a vertex.
+ *
+ * A global relabeling (breadth-first search from the sink over the residual
+ * graph) runs after O(V + E) work and whenever no vertex is active. It sets
+ * exact distance labels, so the algorithm stops only when no vertex with
+ * excess can reach the sink. Then the preflow is maximal, and the vertices
+ * that cannot reach the sink are the source side of a minimum cut.
+ *
+ * Only the flow value and the cut are computed; the remaining excess is not
+ * returned to the source.
+ *
+ * Usage:
+ *
+ *   GridGraph grid(width, height, 4);
+ *   Array<int> capacity(grid.n_arcs(), 0), source_cap(n), sink_cap(n);
+ *   ... // Fill capacity[grid.arc(v, k)] and the terminal capacities.
+ *   ParallelPushRelabelMaxFlow<int> max_flow;
+ *   int flow = max_flow(grid, capacity, source_cap, sink_cap);
+ *   bool foreground = max_flow.IsSourceSide(v);
+ */
+template <typename T>
+class ParallelPushRelabelMaxFlow {
+    static_assert(std::is_arithmetic<T>::value, "");
+
+public:
+    /**
+     * Compute the maximum flow from the source terminal to the sink terminal.
+     *
+     * Input:
+     *  graph           - CSRGraph or GridGraph. The twin of every arc with
+     *                    positive capacity must exist.
+     *  capacity        - The capacity of each arc, size graph.n_arcs().
+     *  source_capacity - The capacity from the source to each vertex.
+     *  sink_capacity   - The capacity from each vertex to the sink.
+     *
+     * Return:
+     *  the maximal flow.
+     */
+    template <typename ArcGraph>
+    T operator() (const ArcGraph& graph,
+                  const Array<T>& capacity,
+                  const Array<T>& source_capacity,
+                  const Array<T>& sink_capacity) {
+        const int n = graph.n_vertices();
+        CHECK(capacity.size() == graph.n_arcs());
+        CHECK(source_capacity.size() == n);
+        CHECK(sink_capacity.size() == n);
+
+        for (int i = 0; i < capacity.size(); ++i) {
+            CHECK(capacity[i] >= T(0)) <<
+                "The capacity of graph's edge must be greater than 0.";
+        }
+
+        n_vertices_ = n;
+        max_label_ = n + 1;
+        residual_ = capacity;
+        sink_residual_ = sink_capacity;
+        excess_ = source_capacity;
+        label_.assign(n, 0);
+        new_label_.assign(n, 0);
+        incoming_.assign(n, T(0));
+        in_list_.assign(n, 0);
+        active_.clear();
+        candidates_.clear();
+
+        // Route the flow of source -> v -> sink directly.
+        flow_ = T(0);
+        for (int v = 0; v < n; ++v) {
+            CHECK(source_capacity[v] >= T(0) && sink_capacity[v] >= T(0));
+
+            T d = std::min(excess_[v], sink_residual_[v]);
+            excess_[v] -= d;
+            sink_residual_[v] -= d;
+            flow_ += d;
+        }
+
+        const int64_t global_update_work = 6 * static_cast<int64_t>(n) +
+                                           graph.n_arcs();
+        GlobalRelabel(graph);
+        CollectActiveVertices();
+
+        int64_t work = 0;
+        while (!active_.empty()) {
+            work += Round(graph);
+            if (active_.empty() || work > global_update_work) {
+                GlobalRelabel(graph);
+                CollectActiveVertices();
+                work = 0;
+            }
+        }
+
+        return flow_;
+    }
+
+    /**
+     * Compute the maximum flow from vertex 'source' to vertex 'target' of a
+     * graph whose arcs all have twins.
+     */
+    T operator() (const CSRGraph& graph,
+                  const Array<T>& capacity,
+                  int source,
+                  int target) {
+        const int n = graph.n_vertices();
+        CHECK(0 <= source && source < n);
+        CHECK(0 <= target && target < n);
+
+        if (source == target) return T(0);
+
+        // The source may send everything it can push, and the target may
+        // accept everything it can receive.
+        Array<T> source_capacity(n, T(0)), sink_capacity(n, T(0));
+        graph.ForEachArc(source, [&](int a, int w, int t) {
+            (void)t;
+            if (w != source) source_capacity[source] += capacity[a];
+        });
+        graph.ForEachArc(target, [&](int a, int w, int t) {
+            (void)a;
+            CHECK(t >= 0);
+            if (w != target) sink_capacity[target] += capacity[t];
+        });
+        return (*this)(graph, capacity, source_capacity, sink_capacity);
+    }
+
+    /**
+     * Return true if vertex v is on the source side of the minimum cut found
+     * by the last call.
+     */
+    bool IsSourceSide(int v) const {
+        return label_[v] >= max_label_;
+    }
+
+    /**
+     * Return the residual capacity of each arc after the last call.
+     */
+    const Array<T>& residual_capacity() const {
+        return residual_;
+    }
+
+    /**
+     * Return the residual capacity of the arc from each vertex to the sink
+     * after the last call.
+     */
+    const Array<T>& sink_residual_capacity() const {
+        return sink_residual_;
+    }
+
+private:
+    /**
+     * Discharge all active vertices once, in parallel. Return the number of
+     * scanned arcs.
+     */
+    template <typename ArcGraph>
+    int64_t Round(const ArcGraph& graph) {
+        const int n_active = active_.size();
+        T to_sink = T(0);
+        int64_t work = 0;
+
+        #pragma omp parallel if (n_active > 512) reduction(+ : to_sink, work)
+        {
+            Array<int> targets;
+
+            #pragma omp for schedule(dynamic, 64)
+            for (int i = 0; i < n_active; ++i) {
+                Discharge(graph, active_[i], &targets, &to_sink, &work);
+            }
+
+            #pragma omp critical
+            candidates_.insert(targets.begin(), targets.end());
+        }
+        flow_ += to_sink;
+
+        // Publish the new labels and the received excess, and collect the
+        // vertices that are active in the next round.
+        for (int u : active_) {
+            label_[u] = new_label_[u];
+        }
+        for (int v : candidates_) {
+            excess_[v] += incoming_[v];
+            incoming_[v] = T(0);
+        }
+        next_active_.clear();
+        for (int u : active_) {
+            AddIfActive(u);
+        }
+        for (int v : candidates_) {
+            AddIfActive(v);
+        }
+        for (int v : next_active_) {
+            in_list_[v] = 0;
+        }
+        active_.swap(next_active_);
+        candidates_.clear();
+
+        return work;
+    }
+
+    /**
+     * Push the excess of u to lower neighbors until it is gone, or relabel u
+     * once. Labels of other vertices are read from the previous round.
+     */
+    template <typename ArcGraph>
+    void Discharge(const ArcGraph& graph, int u, Array<int>* targets,
+                   T* to_sink, int64_t* work) {
+        T e = excess_[u];
+        int h = label_[u];
+
+        // The sink has label 0, so it is always admissible.
+        if (sink_residual_[u] > T(0)) {
+            T d = std::min(e, sink_residual_[u]);
+            sink_residual_[u] -= d;
+            e -= d;
+            *to_sink += d;
+        }
+
+        while (e > T(0)) {
+            int best_arc = -1, best_target = -1, best_twin = -1;
+            int best_label = max_label_;
+            T best_residual = T(0);
+            int64_t n_scanned = 0;
+            graph.ForEachArc(u, [&](int a, int w, int t) {
+                ++n_scanned;
+                T r;
+                #pragma omp atomic read
+                r = residual_[a];
+                if (r > T(0) && label_[w] < best_label) {
+                    best_label = label_[w];
+                    best_arc = a;
+                    best_target = w;
+                    best_twin = t;
+                    best_residual = r;
+                }
+            });
+            *work += n_scanned;
+
+            if (best_arc < 0 || best_label + 1 >= max_label_) {
+                // The sink is unreachable from u.
+                h = max_label_;
+                break;
+            }
+            if (h <= best_label) {
+                h = best_label + 1;
+                break;
+            }
+
+            // Push. The target has a lower label, so it does not push back
+            // over this arc pair in the same round, and u is the only writer
+            // of both arcs. The target may be scanning the twin arc.
+            T d = std::min(e, best_residual);
+            #pragma omp atomic write
+            residual_[best_arc] = best_residual - d;
+            #pragma omp atomic
+            residual_[best_twin] += d;
+            #pragma omp atomic
+            incoming_[best_target] += d;
+            e -= d;
+            targets->push_back(best_target);
+        }
+
+        excess_[u] = e;
+        new_label_[u] = h;
+    }
+
+    /**
+     * Set the labels to the exact distances to the sink in the residual graph
+     * by a breadth-first search. Unreachable vertices get the maximum label.
+     */
+    template <typename ArcGraph>
+    void GlobalRelabel(const ArcGraph& graph) {
+        std::fill(label_.begin(), label_.end(), max_label_);
+
+        Array<int>& queue = next_active_;
+        queue.clear();
+        for (int v = 0; v < n_vertices_; ++v) {
+            if (sink_residual_[v] > T(0)) {
+                label_[v] = 1;
+                queue.push_back(v);
+            }
+        }
+        for (int i = 0; i < queue.size(); ++i) {
+            int u = queue[i];
+            int d = label_[u] + 1;
+            if (d >= max_label_) continue;
+
+            graph.ForEachArc(u, [&](int a, int w, int t) {
+                (void)a;
+                if (label_[w] == max_label_ && t >= 0 && residual_[t] > T(0)) {
+                    label_[w] = d;
+                    queue.push_back(w);
+                }
+            });
+        }
+        std::copy(label_.begin(), label_.end(), new_label_.begin());
+    }
+
+    /**
+     * Collect all active vertices.
+     */
+    void CollectActiveVertices() {
+        active_.clear();
+        for (int v = 0; v < n_vertices_; ++v) {
+            if (excess_[v] > T(0) && label_[v] < max_label_) {
+                active_.push_back(v);
+            }
+        }
+    }
+
+    /**
+     * Add v to the next active list if it is active and not yet added.
+     */
+    void AddIfActive(int v) {
+        if (!in_list_[v] && excess_[v] > T(0) && label_[v] < max_label_) {
+            in_list_[v] = 1;
+            next_active_.push_back(v);
+        }
+    }
+
+    int n_vertices_ = 0;
+    int max_label_ = 0;  // Label of the vertices that cannot reach the sink.
+    T flow_ = T(0);      // Flow into the sink.
+
+    Array<T> residual_;      // Residual capacity of each arc.
+    Array<T> sink_residual_; // Residual capacity from each vertex to the sink.
+    Array<T> excess_;        // Excess of each vertex.
+    Array<T> incoming_;      // Excess received in the current round.
+    Array<int> label_;       // Distance label of each vertex.
+    Array<int> new_label_;   // Labels of the next round.
+
+    Array<int> active_;      // Active vertices of the current round.
+    Array<int> next_active_; // Active vertices of the next round.
+    Array<int> candidates_;  // Vertices that received excess (duplicated).
+    Array<char> in_list_;    // Whether a vertex is in next_active_.
+};
+
+} // namespace graph
+} // namespace cl
+
+#endif // CODELIBRARY_GRAPH_FLOW_PARALLEL_PUSH_RELABEL_MAX_FLOW_H_
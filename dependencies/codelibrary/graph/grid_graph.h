@@ -0,0 +1,175 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GRAPH_GRID_GRAPH_H_
+#define CODELIBRARY_GRAPH_GRID_GRAPH_H_
+
+#include <climits>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+
+/**
+ * Implicit graph of the pixels (or voxels) of a regular grid, connected to
+ * their 4 or 8 neighbors in 2D, or to their 6 or 26 neighbors in 3D.
+ *
+ * No edge is stored. The vertex of (x, y, z) is (z * size_y + y) * size_x + x
+ * and its k-th neighbor arc has id vertex * K + k, where K is the size of the
+ * neighborhood. The neighbor offsets are ordered so that offset K - 1 - k is
+ * the opposite of offset k, which gives the twin of every arc directly. Arcs
+ * that would leave the grid exist as ids (so that arc arrays stay regular) but
+ * are never visited by ForEachArc().
+ *
+ * GridGraph provides the same arc interface as CSRGraph.
+ */
+class GridGraph {
+public:
+    GridGraph() = default;
+
+    /**
+     * 2D grid with the 4- or 8-neighborhood.
+     */
+    GridGraph(int size_x, int size_y, int n_neighbors)
+        : GridGraph(size_x, size_y, 1, n_neighbors) {}
+
+    /**
+     * 3D grid with the 6- or 26-neighborhood. A grid with size_z == 1 may also
+     * use the 2D neighborhoods.
+     */
+    GridGraph(int size_x, int size_y, int size_z, int n_neighbors)
+        : size_x_(size_x), size_y_(size_y), size_z_(size_z) {
+        CHECK(size_x > 0 && size_y > 0 && size_z > 0);
+        CHECK(static_cast<int64_t>(size_x) * size_y * size_z * n_neighbors <=
+              INT_MAX);
+        CHECK(n_neighbors == 4 || n_neighbors == 8 || n_neighbors == 6 ||
+              n_neighbors == 26) << "Unsupported neighborhood: "
+                                 << n_neighbors;
+
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int n_nonzero = (dx != 0) + (dy != 0) + (dz != 0);
+                    bool keep = false;
+                    switch (n_neighbors) {
+                    case 4:
+                        keep = dz == 0 && n_nonzero == 1;
+                        break;
+                    case 8:
+                        keep = dz == 0 && n_nonzero > 0;
+                        break;
+                    case 6:
+                        keep = n_nonzero == 1;
+                        break;
+                    case 26:
+                        keep = n_nonzero > 0;
+                        break;
+                    }
+                    if (!keep) continue;
+
+                    // Lexicographic order is symmetric around (0, 0, 0), so
+                    // offset K - 1 - k is the negation of offset k.
+                    dx_[n_neighbors_] = dx;
+                    dy_[n_neighbors_] = dy;
+                    dz_[n_neighbors_] = dz;
+                    offsets_[n_neighbors_] = (dz * size_y + dy) * size_x + dx;
+                    ++n_neighbors_;
+                }
+            }
+        }
+    }
+
+    /**
+     * Call f(arc, target, twin) for every arc of v that stays in the grid.
+     */
+    template <typename Function>
+    void ForEachArc(int v, Function f) const {
+        int x = v % size_x_;
+        int t = v / size_x_;
+        int y = t % size_y_;
+        int z = t / size_y_;
+        int base = v * n_neighbors_;
+
+        // Interior vertices skip the bound checks.
+        bool interior = x > 0 && x + 1 < size_x_ &&
+                        y > 0 && y + 1 < size_y_ &&
+                        ((z > 0 && z + 1 < size_z_) || size_z_ == 1);
+        for (int k = 0; k < n_neighbors_; ++k) {
+            if (!interior) {
+                int nx = x + dx_[k], ny = y + dy_[k], nz = z + dz_[k];
+                if (nx < 0 || nx >= size_x_ || ny < 0 || ny >= size_y_ ||
+                    nz < 0 || nz >= size_z_) {
+                    continue;
+                }
+            }
+            int w = v + offsets_[k];
+            f(base + k, w, w * n_neighbors_ + n_neighbors_ - 1 - k);
+        }
+    }
+
+    /**
+     * Return the vertex of (x, y, z).
+     */
+    int vertex(int x, int y, int z = 0) const {
+        return (z * size_y_ + y) * size_x_ + x;
+    }
+
+    /**
+     * Return the arc from vertex v to its neighbor at (v + offset k).
+     */
+    int arc(int v, int k) const {
+        return v * n_neighbors_ + k;
+    }
+
+    /**
+     * Return the offset of the k-th neighbor.
+     */
+    void neighbor_offset(int k, int* dx, int* dy, int* dz) const {
+        *dx = dx_[k];
+        *dy = dy_[k];
+        *dz = dz_[k];
+    }
+
+    int n_vertices() const {
+        return size_x_ * size_y_ * size_z_;
+    }
+
+    int n_arcs() const {
+        return n_vertices() * n_neighbors_;
+    }
+
+    int n_neighbors() const {
+        return n_neighbors_;
+    }
+
+    int size_x() const {
+        return size_x_;
+    }
+
+    int size_y() const {
+        return size_y_;
+    }
+
+    int size_z() const {
+        return size_z_;
+    }
+
+private:
+    int size_x_ = 0, size_y_ = 0, size_z_ = 0;
+
+    // Neighborhood.
+    int n_neighbors_ = 0;
+    int dx_[26] = {}, dy_[26] = {}, dz_[26] = {};
+    int offsets_[26] = {};
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_GRAPH_GRID_GRAPH_H_
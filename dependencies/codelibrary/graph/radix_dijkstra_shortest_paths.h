@@ -0,0 +1,207 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_GRAPH_RADIX_DIJKSTRA_SHORTEST_PATHS_H_
+#define CODELIBRARY_GRAPH_RADIX_DIJKSTRA_SHORTEST_PATHS_H_
+
+#include <limits>
+#include <type_traits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/util/heap/radix_heap.h"
+
+namespace cl {
+namespace graph {
+
+/**
+ * Dijkstra shortest paths with non-negative integer weights over CSRGraph or
+ * GridGraph, using a radix heap (see RadixHeap).
+ *
+ * The arc weights are a plain array indexed by arc. The heap is kept between
+ * calls, so one object answers many queries without allocation. Batch() runs
+ * independent queries in parallel with one heap and one predecessor buffer
+ * per thread, which the object also keeps between calls.
+ *
+ * Unreachable vertices get distance std::numeric_limits<T>::max() and
+ * predecessor -1. The sum of weights along any path must fit in T.
+ *
+ * The time complexity is O(E + V log(C)), where C is the maximal distance.
+ *
+ * Usage:
+ *
+ *   CSRGraph graph(n, edges);
+ *   Array<int> weight(graph.n_arcs());
+ *   ...
+ *   RadixDijkstraShortestPaths<int> shortest_paths;
+ *   shortest_paths(graph, weight, source, &predecessors, &distances);
+ */
+template <typename T>
+class RadixDijkstraShortestPaths {
+    static_assert(std::is_integral<T>::value, "");
+
+    using Key = typename std::make_unsigned<T>::type;
+
+public:
+    /**
+     * Compute the shortest paths from 'source'.
+     *
+     * Input:
+     *  graph        - CSRGraph or GridGraph.
+     *  weight       - the non-negative weight of each arc.
+     *  source       - the source vertex.
+     *
+     * Output:
+     *  predecessors - predecessors[v] is the previous vertex on the shortest
+     *                 path to v, or -1.
+     *  distances    - distances[v] is the shortest distance to v.
+     */
+    template <typename ArcGraph>
+    void operator() (const ArcGraph& graph,
+                     const Array<T>& weight,
+                     int source,
+                     Array<int>* predecessors,
+                     Array<T>* distances) {
+        CHECK(predecessors && distances);
+
+        Run(graph, weight, &source, &source + 1, &heap_, predecessors,
+            distances);
+    }
+
+    /**
+     * Compute the shortest paths from the nearest of several sources, e.g.,
+     * the geodesic distance to a set of seeds. The predecessor chains end at
+     * the sources.
+     */
+    template <typename ArcGraph>
+    void operator() (const ArcGraph& graph,
+                     const Array<T>& weight,
+                     const Array<int>& sources,
+                     Array<int>* predecessors,
+                     Array<T>* distances) {
+        CHECK(predecessors && distances);
+
+        Run(graph, weight, sources.begin(), sources.end(), &heap_,
+            predecessors, distances);
+    }
+
+    /**
+     * Compute the distances from every source of 'sources' separately, in
+     * parallel. (*distances)[i] receives the distances from sources[i].
+     *
+     * The per-thread heaps and predecessor buffers are members, so once they
+     * have grown, calling Batch() again with the same 'distances' and at
+     * most as many sources does not allocate.
+     */
+    template <typename ArcGraph>
+    void Batch(const ArcGraph& graph,
+               const Array<T>& weight,
+               const Array<int>& sources,
+               Array<Array<T>>* distances) {
+        CHECK(distances);
+
+        const int n_sources = sources.size();
+        distances->resize(n_sources);
+
+        int n_threads = 1;
+#ifdef _OPENMP
+        if (n_sources > 1) n_threads = omp_get_max_threads();
+#endif
+        if (thread_heaps_.size() < n_threads) {
+            thread_heaps_.resize(n_threads);
+            thread_predecessors_.resize(n_threads);
+        }
+
+        #pragma omp parallel num_threads(n_threads) if (n_threads > 1)
+        {
+            int thread = 0;
+#ifdef _OPENMP
+            thread = omp_get_thread_num();
+#endif
+            Heap* heap = &thread_heaps_[thread];
+            Array<int>* predecessors = &thread_predecessors_[thread];
+
+            #pragma omp for schedule(dynamic)
+            for (int i = 0; i < n_sources; ++i) {
+                Run(graph, weight, &sources[i], &sources[i] + 1, heap,
+                    predecessors, &(*distances)[i]);
+            }
+        }
+    }
+
+private:
+    using Heap = RadixHeap<Key, int>;
+
+    /**
+     * Search from the sources in [first, last) with the given heap.
+     */
+    template <typename ArcGraph>
+    static void Run(const ArcGraph& graph,
+                    const Array<T>& weight,
+                    const int* first,
+                    const int* last,
+                    Heap* heap,
+                    Array<int>* predecessors,
+                    Array<T>* distances) {
+        CHECK(weight.size() == graph.n_arcs());
+
+        const int n = graph.n_vertices();
+        predecessors->assign(n, -1);
+        distances->assign(n, std::numeric_limits<T>::max());
+        int* pred = predecessors->data();
+        T* dist = distances->data();
+
+        heap->clear();
+        for (const int* source = first; source != last; ++source) {
+            const int s = *source;
+            CHECK(0 <= s && s < n);
+
+            if (dist[s] != T(0)) {
+                dist[s] = T(0);
+                heap->Push(Key(0), s);
+            }
+        }
+
+        while (!heap->empty()) {
+            Key key;
+            int u;
+            heap->Pop(&key, &u);
+
+            // Skip the stale copies of u.
+            T d = static_cast<T>(key);
+            if (d != dist[u]) continue;
+
+            graph.ForEachArc(u, [&](int a, int w, int t) {
+                (void)t;
+                CHECK(weight[a] >= T(0));
+
+                T nd = d + weight[a];
+                if (nd < dist[w]) {
+                    dist[w] = nd;
+                    pred[w] = u;
+                    heap->Push(static_cast<Key>(nd), w);
+                }
+            });
+        }
+    }
+
+    Heap heap_;
+
+    // The heap and the predecessors of each thread of Batch().
+    Array<Heap> thread_heaps_;
+    Array<Array<int>> thread_predecessors_;
+};
+
+} // namespace graph
+} // namespace cl
+
+#endif // CODELIBRARY_GRAPH_RADIX_DIJKSTRA_SHORTEST_PATHS_H_
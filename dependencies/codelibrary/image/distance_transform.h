@@ -9,10 +9,15 @@
 #ifndef CODELIBRARY_IMAGE_DISTANCE_TRANSFORM_H_
 #define CODELIBRARY_IMAGE_DISTANCE_TRANSFORM_H_
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 #include "codelibrary/base/clamp.h"
+#include "codelibrary/base/float.h"
 #include "codelibrary/image/image.h"
 
 namespace cl {
@@ -375,6 +380,416 @@ using ManhattanDistanceTransform =
 using ChebyshevDistanceTransform =
       DistanceTransform<ChebyshevDistanceTransform1D>;
 
+namespace distance_transform_internal {
+
+// Number of neighboring lines that are gathered together when a pass runs
+// along a strided axis, so that every loaded cache line is fully used.
+const int LINE_BATCH = 16;
+
+/**
+ * Squared Euclidean distance transform of a single line, see
+ * SquaredEuclideanDistanceTransform1D. Infinite samples do not contribute a
+ * parabola, so a line without finite samples stays infinite (instead of NaN).
+ *
+ * The intersection of the parabolas from p and q is kept as the fraction
+ * (g(q) - g(p)) / (2(q - p)), where g(p) = f(p) + p^2, and compared by cross
+ * multiplication. It avoids all divisions, and the comparisons are exact for
+ * integer inputs.
+ *
+ * 'f' and 'd' must not overlap. 'v', 'g', 'z_num' and 'z_den' are scratch
+ * arrays of size n.
+ */
+template <typename T>
+void SquaredTransformLine(const T* f, int n, T* d, int* v, double* g,
+                          double* z_num, double* z_den) {
+    const T inf = std::numeric_limits<T>::infinity();
+
+    // Compute lower envelope. The parabola v[k] is the lowest one from the
+    // intersection z[k] (exclusive for k = 0) to z[k + 1].
+    int k = -1;
+    for (int q = 0; q < n; ++q) {
+        if (f[q] == inf) continue;
+
+        const double gq = static_cast<double>(f[q]) +
+                          static_cast<double>(q) * q;
+        double num = 0.0, den = 1.0;
+        while (k >= 0) {
+            num = gq - g[k];
+            den = 2.0 * (q - v[k]);
+            if (k == 0 || num * z_den[k] > z_num[k] * den) break;
+            --k;
+        }
+        ++k;
+        v[k] = q;
+        g[k] = gq;
+        z_num[k] = num;
+        z_den[k] = den;
+    }
+
+    if (k < 0) {
+        std::fill(d, d + n, inf);
+        return;
+    }
+
+    // Fill in values of distance transform.
+    for (int q = 0, j = 0; q < n; ++q) {
+        while (j < k && z_num[j + 1] < q * z_den[j + 1])
+            ++j;
+        const double t = q - v[j];
+        d[q] = static_cast<T>(t * t + f[v[j]]);
+    }
+}
+
+/**
+ * Run the 1D squared transform along 'axis' of a row-major grid. The lines are
+ * read from 'src' and every result is passed to 'write(index, value)'. 'write'
+ * may store into 'src' itself, because each line is gathered before any of
+ * its values is written back.
+ *
+ * Lines are distributed over threads; every thread owns its scratch buffers.
+ */
+template <typename T, typename Writer>
+void TransformAxis(const Array<int>& shape, int axis, const T* src,
+                   const Writer& write) {
+    const int n = shape[axis];
+    int64_t stride = 1, n_outer = 1;
+    for (int i = axis + 1; i < shape.size(); ++i) {
+        stride *= shape[i];
+    }
+    for (int i = 0; i < axis; ++i) {
+        n_outer *= shape[i];
+    }
+    if (n == 0 || stride == 0 || n_outer == 0) return;
+
+    // Lines along the contiguous axis are read directly; the others are
+    // gathered in batches of neighbors.
+    const int batch = stride == 1 ? 1 : LINE_BATCH;
+    const int64_t n_inner_blocks = (stride + batch - 1) / batch;
+    const int64_t n_blocks64 = n_outer * n_inner_blocks;
+    CHECK(n_blocks64 <= INT_MAX);
+    const int n_blocks = static_cast<int>(n_blocks64);
+
+    #pragma omp parallel if (static_cast<double>(n) * stride * n_outer > 65536)
+    {
+        Array<T> f(batch * n), d(batch * n);
+        Array<int> v(n);
+        Array<double> g(n), z_num(n), z_den(n);
+
+        #pragma omp for schedule(static)
+        for (int block = 0; block < n_blocks; ++block) {
+            const int64_t outer = block / n_inner_blocks;
+            const int64_t inner = (block % n_inner_blocks) * batch;
+            const int n_lines = static_cast<int>(
+                std::min<int64_t>(batch, stride - inner));
+            const int64_t base = outer * n * stride + inner;
+
+            for (int q = 0; q < n; ++q) {
+                const T* s = src + base + q * stride;
+                for (int b = 0; b < n_lines; ++b) {
+                    f[b * n + q] = s[b];
+                }
+            }
+            for (int b = 0; b < n_lines; ++b) {
+                SquaredTransformLine(f.data() + b * n, n, d.data() + b * n,
+                                     v.data(), g.data(), z_num.data(),
+                                     z_den.data());
+            }
+            for (int q = 0; q < n; ++q) {
+                const int64_t index = base + q * stride;
+                for (int b = 0; b < n_lines; ++b) {
+                    write(index + b, d[b * n + q]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Squared distance along the last (contiguous) axis from each cell to the
+ * nearest cell that satisfies 'is_feature(index)'. Two linear sweeps per line
+ * replace the lower envelope for binary inputs.
+ */
+template <typename Predicate>
+void FeatureDistanceLastAxis(const Array<int>& shape,
+                             const Predicate& is_feature, float* out) {
+    const float inf = std::numeric_limits<float>::infinity();
+    const int n = shape.back();
+    int64_t n_lines64 = 1;
+    for (int i = 0; i + 1 < shape.size(); ++i) {
+        n_lines64 *= shape[i];
+    }
+    CHECK(n_lines64 <= INT_MAX);
+    const int n_lines = static_cast<int>(n_lines64);
+
+    #pragma omp parallel for if (static_cast<double>(n) * n_lines > 65536)
+    for (int line = 0; line < n_lines; ++line) {
+        const int64_t base = static_cast<int64_t>(line) * n;
+        float* o = out + base;
+
+        int last = -1;
+        for (int q = 0; q < n; ++q) {
+            if (is_feature(base + q)) last = q;
+            o[q] = last < 0 ? inf : static_cast<float>(q - last);
+        }
+        last = -1;
+        for (int q = n - 1; q >= 0; --q) {
+            if (o[q] == 0.0f) last = q;
+            float t = o[q];
+            if (last >= 0) t = std::min(t, static_cast<float>(last - q));
+            o[q] = t * t;
+        }
+    }
+}
+
+/**
+ * Exact squared Euclidean distance from each cell to the nearest feature
+ * cell. All passes but the last store into 'work'; the last pass hands its
+ * results to 'write(index, squared_distance)'.
+ */
+template <typename Predicate, typename Writer>
+void FeatureTransform(const Array<int>& shape, const Predicate& is_feature,
+                      float* work, const Writer& write) {
+    const int last = shape.size() - 1;
+    FeatureDistanceLastAxis(shape, is_feature, work);
+
+    if (last == 0) {
+        const int n = shape[0];
+        for (int i = 0; i < n; ++i) {
+            write(i, work[i]);
+        }
+        return;
+    }
+
+    auto store = [work](int64_t i, float v) { work[i] = v; };
+    for (int axis = last - 1; axis > 0; --axis) {
+        TransformAxis(shape, axis, work, store);
+    }
+    TransformAxis(shape, 0, work, write);
+}
+
+/**
+ * Return the float buffer used for the intermediate passes: the output itself
+ * when it is a float array, otherwise 'buffer' resized to 'size'.
+ */
+template <typename Output>
+float* WorkBuffer(Output*, int64_t size, Array<float>* buffer) {
+    CHECK(size <= INT_MAX);
+    buffer->resize(static_cast<int>(size));
+    return buffer->data();
+}
+inline float* WorkBuffer(float* output, int64_t, Array<float>*) {
+    return output;
+}
+
+/**
+ * Return the number of cells of the grid.
+ */
+inline int64_t GridSize(const Array<int>& shape) {
+    CHECK(!shape.empty());
+
+    int64_t size = 1;
+    for (int s : shape) {
+        CHECK(s >= 0);
+        size *= s;
+    }
+    return size;
+}
+
+/**
+ * Euclidean distance transform of a Morton ordered cubic grid, whose occupancy
+ * is given by 'is_occupied(morton_code)'.
+ */
+template <typename Predicate, typename Output>
+void MortonTransform(int resolution, const Predicate& is_occupied,
+                     Output* distance) {
+    CHECK(resolution > 0 && resolution <= 1024);
+    CHECK((resolution & (resolution - 1)) == 0);
+    CHECK(distance);
+
+    int log_resolution = 0;
+    while ((1 << log_resolution) < resolution) ++log_resolution;
+    const int mask = resolution - 1;
+
+    // Bits of x spread three positions apart.
+    Array<uint32_t> expand(resolution);
+    for (int i = 0; i < resolution; ++i) {
+        uint32_t code = 0;
+        for (int b = 0; b < log_resolution; ++b) {
+            code |= static_cast<uint32_t>((i >> b) & 1) << (3 * b);
+        }
+        expand[i] = code;
+    }
+    auto morton = [&](int64_t index) {
+        const int x = static_cast<int>(index) & mask;
+        const int y = static_cast<int>(index >> log_resolution) & mask;
+        const int z = static_cast<int>(index >> (2 * log_resolution));
+        return expand[x] | expand[y] << 1 | expand[z] << 2;
+    };
+
+    const Array<int> shape = {resolution, resolution, resolution};
+    Array<float> work(resolution * resolution * resolution);
+    FeatureTransform(shape,
+                     [&](int64_t i) { return is_occupied(morton(i)); },
+                     work.data(),
+                     [&](int64_t i, float d2) {
+        distance[morton(i)] = static_cast<Output>(std::sqrt(d2));
+    });
+}
+
+} // namespace distance_transform_internal
+
+/**
+ * Exact squared Euclidean distance transform of a sampled function on an
+ * N-dimensional grid, computed in place:
+ *
+ *     Df(p) =   min   ((p - q)^2 + f(q)).
+ *             q \in G
+ *
+ * Set f to 0 at the feature cells and to +infinity elsewhere to get the
+ * squared distance to the nearest feature cell. The transform is separable, so
+ * it runs one 1D pass per axis, each in parallel over the lines of the grid.
+ *
+ * Input:
+ *  shape - the number of cells along each axis, row-major (the last axis is
+ *          contiguous in memory).
+ *  f     - the sampled function (float or double).
+ *
+ * Output:
+ *  f     - the squared distance transform of f.
+ */
+template <typename T>
+void SquaredEuclideanDistanceTransformND(const Array<int>& shape, T* f) {
+    static_assert(std::is_floating_point<T>::value, "");
+    CHECK(f);
+
+    distance_transform_internal::GridSize(shape);
+    auto store = [f](int64_t i, T v) { f[i] = v; };
+    for (int axis = shape.size() - 1; axis >= 0; --axis) {
+        distance_transform_internal::TransformAxis(shape, axis, f, store);
+    }
+}
+
+/**
+ * Exact Euclidean distance (in cells) from each cell of an N-dimensional
+ * binary grid to the nearest feature (non-zero) cell. Cells are infinitely far
+ * away if the grid has no feature cells.
+ *
+ * The first pass scans the binary input directly, and the last one writes the
+ * distances to the output, so no extra memory is used for float output.
+ *
+ * Input:
+ *  shape    - the number of cells along each axis, row-major.
+ *  feature  - binary grid, non-zero for the feature cells.
+ *
+ * Output:
+ *  distance - float, double or Half distances.
+ */
+template <typename Output>
+void EuclideanDistanceTransformND(const Array<int>& shape,
+                                  const uint8_t* feature, Output* distance) {
+    CHECK(feature && distance);
+
+    const int64_t size = distance_transform_internal::GridSize(shape);
+    if (size == 0) return;
+
+    Array<float> buffer;
+    float* work = distance_transform_internal::WorkBuffer(distance, size,
+                                                          &buffer);
+    distance_transform_internal::FeatureTransform(shape,
+        [feature](int64_t i) { return feature[i] != 0; },
+        work,
+        [distance](int64_t i, float d2) {
+            distance[i] = static_cast<Output>(std::sqrt(d2));
+        });
+}
+
+/**
+ * Signed Euclidean distance field of an N-dimensional binary grid.
+ *
+ * The surface is assumed to lie halfway between inside and outside cells.
+ * Outside cells get their distance to the nearest inside cell minus 1/2, and
+ * inside cells get the negated distance to the nearest outside cell minus 1/2.
+ *
+ * Input:
+ *  shape    - the number of cells along each axis, row-major.
+ *  inside   - binary grid, non-zero for the inside (occupied) cells.
+ *
+ * Output:
+ *  distance - float, double or Half signed distances, negative inside.
+ */
+template <typename Output>
+void SignedEuclideanDistanceTransformND(const Array<int>& shape,
+                                        const uint8_t* inside,
+                                        Output* distance) {
+    CHECK(inside && distance);
+
+    const int64_t size = distance_transform_internal::GridSize(shape);
+    if (size == 0) return;
+
+    // Squared distances to the inside cells. They can live in the output,
+    // because the last pass below reads each of them once, right before
+    // overwriting it.
+    Array<float> buffer;
+    float* outside = distance_transform_internal::WorkBuffer(distance, size,
+                                                             &buffer);
+    distance_transform_internal::FeatureTransform(shape,
+        [inside](int64_t i) { return inside[i] != 0; },
+        outside,
+        [outside](int64_t i, float d2) { outside[i] = d2; });
+
+    Array<float> work(static_cast<int>(size));
+    distance_transform_internal::FeatureTransform(shape,
+        [inside](int64_t i) { return inside[i] == 0; },
+        work.data(),
+        [inside, outside, distance](int64_t i, float d2) {
+            const float d = inside[i] ? -(std::sqrt(d2) - 0.5f)
+                                      : std::sqrt(outside[i]) - 0.5f;
+            distance[i] = static_cast<Output>(d);
+        });
+}
+
+/**
+ * Euclidean distance transform of a cubic occupancy bitfield in Morton order,
+ * the layout of a NeRF density grid cascade: cell (x, y, z) has the Morton
+ * code c with the bits of x, y and z interleaved (x in the lowest bit), and is
+ * occupied if bit (c % 8) of byte (c / 8) is set.
+ *
+ * The distances (in cells) to the nearest occupied cell are written in the
+ * same Morton order, so they can be indexed like the density grid. For
+ * several cascades, call it once per cascade, the bitfield of each cascade
+ * takes resolution^3 / 8 bytes.
+ *
+ * Input:
+ *  resolution - the number of cells along each axis, a power of two.
+ *  bitfield   - resolution^3 / 8 bytes (at least one byte).
+ *
+ * Output:
+ *  distance   - resolution^3 float, double or Half distances.
+ */
+template <typename Output>
+void EuclideanDistanceTransformMorton(int resolution, const uint8_t* bitfield,
+                                      Output* distance) {
+    CHECK(bitfield);
+
+    distance_transform_internal::MortonTransform(resolution,
+        [bitfield](uint32_t c) { return (bitfield[c >> 3] >> (c & 7)) & 1; },
+        distance);
+}
+
+/**
+ * Same as above, but the occupancy is given by a Morton ordered density grid:
+ * a cell is occupied if its density is greater than 'threshold'.
+ */
+template <typename Output>
+void EuclideanDistanceTransformMorton(int resolution, const float* density,
+                                      float threshold, Output* distance) {
+    CHECK(density);
+
+    distance_transform_internal::MortonTransform(resolution,
+        [density, threshold](uint32_t c) { return density[c] > threshold; },
+        distance);
+}
+
 } // namespace image
 } // namespace cl
 
@@ -0,0 +1,585 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_IMAGE_ENVIRONMENT_MAP_H_
+#define CODELIBRARY_IMAGE_ENVIRONMENT_MAP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/clamp.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/vector_3d.h"
+#include "codelibrary/image/image.h"
+
+namespace cl {
+namespace image {
+
+/**
+ * Piecewise-constant distribution on [0, 1]^2, given by a non-negative
+ * function on a (width x height) grid. Points are drawn by the marginal CDF of
+ * the rows and the conditional CDF of the chosen row, so that the density is
+ * proportional to the function. Rows (or grids) whose function is zero are
+ * sampled uniformly.
+ *
+ * The CDFs are stored in the layout that GPU kernels can consume directly:
+ * 'marginal_cdf' has height + 1 entries and 'conditional_cdf' has
+ * height x (width + 1) entries, both starting at 0 and ending at 1.
+ */
+class Distribution2D {
+public:
+    Distribution2D() = default;
+
+    Distribution2D(int width, int height, const float* f) {
+        Reset(width, height, f);
+    }
+
+    /**
+     * Build the distribution of the row-major function 'f'. Negative and NaN
+     * values are treated as zero. The rows are processed in parallel.
+     */
+    void Reset(int width, int height, const float* f) {
+        CHECK(width > 0 && height > 0);
+        CHECK(height <= INT_MAX / (width + 1));
+        CHECK(f);
+
+        width_ = width;
+        height_ = height;
+        conditional_cdf_.resize(height * (width + 1));
+        marginal_cdf_.resize(height + 1);
+        Array<double> row_sums(height);
+
+        #pragma omp parallel for if (static_cast<int64_t>(width) * height > \
+                                     65536)
+        for (int i = 0; i < height; ++i) {
+            row_sums[i] = BuildCDF(f + static_cast<int64_t>(i) * width, width,
+                                   conditional_cdf_.data() + i * (width + 1));
+        }
+        const double sum = BuildCDF(row_sums.data(), height,
+                                    marginal_cdf_.data());
+        integral_ = sum / (static_cast<double>(width) * height);
+    }
+
+    /**
+     * Map the uniform random numbers (u1, u2) in [0, 1)^2 to a point (x, y)
+     * of the distribution, and return its density in 'pdf' (optional).
+     */
+    void Sample(float u1, float u2, float* x, float* y,
+                float* pdf = nullptr) const {
+        CHECK(!empty());
+
+        int i, j;
+        float dx, dy;
+        SampleCDF(marginal_cdf_.data(), height_, u2, &i, &dy);
+        SampleCDF(conditional_cdf_.data() + i * (width_ + 1), width_, u1, &j,
+                  &dx);
+        *x = (j + dx) / width_;
+        *y = (i + dy) / height_;
+        if (pdf) *pdf = CellPdf(i, j);
+    }
+
+    /**
+     * Density of the point (x, y) in [0, 1]^2.
+     */
+    float Pdf(float x, float y) const {
+        CHECK(!empty());
+
+        const int j = Clamp(static_cast<int>(x * width_), 0, width_ - 1);
+        const int i = Clamp(static_cast<int>(y * height_), 0, height_ - 1);
+        return CellPdf(i, j);
+    }
+
+    /**
+     * Density of the cell in the i-th row and j-th column.
+     */
+    float CellPdf(int i, int j) const {
+        const float* cdf = conditional_cdf_.data() + i * (width_ + 1);
+        return (marginal_cdf_[i + 1] - marginal_cdf_[i]) * height_ *
+               (cdf[j + 1] - cdf[j]) * width_;
+    }
+
+    bool empty()       const { return width_ == 0; }
+    int width()        const { return width_;      }
+    int height()       const { return height_;     }
+    double integral()  const { return integral_;   }
+
+    const Array<float>& marginal_cdf() const {
+        return marginal_cdf_;
+    }
+
+    const Array<float>& conditional_cdf() const {
+        return conditional_cdf_;
+    }
+
+private:
+    /**
+     * Build the normalized CDF of n values into cdf[0..n], and return the sum
+     * of the values.
+     */
+    template <typename T>
+    static double BuildCDF(const T* f, int n, float* cdf) {
+        double sum = 0.0;
+        for (int k = 0; k < n; ++k) {
+            sum += f[k] > 0 ? static_cast<double>(f[k]) : 0.0;
+        }
+
+        cdf[0] = 0.0f;
+        if (sum > 0.0) {
+            const double inv_sum = 1.0 / sum;
+            double partial = 0.0;
+            for (int k = 0; k < n; ++k) {
+                partial += f[k] > 0 ? static_cast<double>(f[k]) : 0.0;
+                cdf[k + 1] = static_cast<float>(partial * inv_sum);
+            }
+        } else {
+            for (int k = 1; k <= n; ++k) {
+                cdf[k] = static_cast<float>(k) / n;
+            }
+        }
+        cdf[n] = 1.0f;
+        return sum;
+    }
+
+    /**
+     * Find the cell k with cdf[k] <= u < cdf[k + 1] and the offset of u in it.
+     */
+    static void SampleCDF(const float* cdf, int n, float u, int* k,
+                          float* offset) {
+        u = Clamp(u, 0.0f, 0.99999994f);
+        *k = Clamp(static_cast<int>(std::upper_bound(cdf, cdf + n + 1, u) -
+                                    cdf) - 1, 0, n - 1);
+        const float width = cdf[*k + 1] - cdf[*k];
+        *offset = width > 0.0f ? std::min((u - cdf[*k]) / width, 0.99999994f)
+                               : 0.5f;
+    }
+
+    int width_ = 0;
+    int height_ = 0;
+    double integral_ = 0.0;
+    Array<float> marginal_cdf_;
+    Array<float> conditional_cdf_;
+};
+
+/**
+ * Equirectangular (latitude-longitude) maps use the convention of the HDR
+ * loader of world::Cubemap: z is up, u = atan2(y, x) / 2pi + 0.5 and
+ * v = asin(z) / pi + 0.5, where the row i of the image is at
+ * v = (i + 0.5) / height.
+ */
+inline FVector3D EquirectangularToDirection(float u, float v) {
+    const double phi = 2.0 * M_PI * (u - 0.5);
+    const double elevation = M_PI * (v - 0.5);
+    const double c = std::cos(elevation);
+    return FVector3D(static_cast<float>(c * std::cos(phi)),
+                     static_cast<float>(c * std::sin(phi)),
+                     static_cast<float>(std::sin(elevation)));
+}
+
+inline void DirectionToEquirectangular(const FVector3D& d, float* u,
+                                       float* v) {
+    const double norm = std::sqrt(static_cast<double>(d.x) * d.x +
+                                  static_cast<double>(d.y) * d.y +
+                                  static_cast<double>(d.z) * d.z);
+    CHECK(norm > 0.0);
+
+    *u = static_cast<float>(std::atan2(d.y, d.x) / (2.0 * M_PI) + 0.5);
+    *v = static_cast<float>(std::asin(Clamp(d.z / norm, -1.0, 1.0)) / M_PI +
+                            0.5);
+}
+
+/**
+ * Direction of the point (s, t) in [0, 1]^2 of a cubemap face, with the face
+ * order and orientation of OpenGL (+X, -X, +Y, -Y, +Z, -Z) that
+ * world::Cubemap renders. The row i of a face is at t = (i + 0.5) / size. The
+ * returned direction is not normalized.
+ */
+inline FVector3D CubemapToDirection(int face, float s, float t) {
+    const float sc = 2.0f * s - 1.0f, tc = 2.0f * t - 1.0f;
+    switch (face) {
+    case 0:  return FVector3D( 1.0f,  -tc,   -sc);
+    case 1:  return FVector3D(-1.0f,  -tc,    sc);
+    case 2:  return FVector3D(   sc, 1.0f,    tc);
+    case 3:  return FVector3D(   sc, -1.0f,  -tc);
+    case 4:  return FVector3D(   sc,  -tc,  1.0f);
+    case 5:  return FVector3D(  -sc,  -tc, -1.0f);
+    default: CHECK(false) << "Invalid cubemap face: " << face;
+    }
+    return FVector3D();
+}
+
+/**
+ * Inverse of CubemapToDirection(): return the face of the direction 'd'.
+ */
+inline int DirectionToCubemap(const FVector3D& d, float* s, float* t) {
+    const float ax = std::fabs(d.x), ay = std::fabs(d.y), az = std::fabs(d.z);
+    int face;
+    float sc, tc, ma;
+    if (ax >= ay && ax >= az) {
+        face = d.x >= 0.0f ? 0 : 1;
+        ma = ax;
+        sc = d.x >= 0.0f ? -d.z : d.z;
+        tc = -d.y;
+    } else if (ay >= az) {
+        face = d.y >= 0.0f ? 2 : 3;
+        ma = ay;
+        sc = d.x;
+        tc = d.y >= 0.0f ? d.z : -d.z;
+    } else {
+        face = d.z >= 0.0f ? 4 : 5;
+        ma = az;
+        sc = d.z >= 0.0f ? d.x : -d.x;
+        tc = -d.y;
+    }
+    CHECK(ma > 0.0f);
+
+    *s = Clamp(0.5f * (sc / ma + 1.0f), 0.0f, 1.0f);
+    *t = Clamp(0.5f * (tc / ma + 1.0f), 0.0f, 1.0f);
+    return face;
+}
+
+namespace environment_map_internal {
+
+/**
+ * Bilinear interpolation of the image at the continuous pixel position
+ * (x, y), where pixel centers are at integers. Columns wrap around if
+ * 'wrap_x', otherwise they are clamped, rows are always clamped.
+ */
+inline void Bilinear(const ImageF& image, float x, float y, bool wrap_x,
+                     float* out) {
+    const int w = image.width(), h = image.height(), c = image.n_channels();
+    const float fx = std::floor(x), fy = std::floor(y);
+    const float wx = x - fx, wy = y - fy;
+
+    int x0 = static_cast<int>(fx), x1 = x0 + 1;
+    if (wrap_x) {
+        x0 = (x0 % w + w) % w;
+        x1 = (x1 % w + w) % w;
+    } else {
+        x0 = Clamp(x0, 0, w - 1);
+        x1 = Clamp(x1, 0, w - 1);
+    }
+    const int y0 = Clamp(static_cast<int>(fy), 0, h - 1);
+    const int y1 = Clamp(static_cast<int>(fy) + 1, 0, h - 1);
+
+    for (int k = 0; k < c; ++k) {
+        out[k] = (1.0f - wy) * ((1.0f - wx) * image(y0, x0, k) +
+                                wx * image(y0, x1, k)) +
+                 wy * ((1.0f - wx) * image(y1, x0, k) +
+                       wx * image(y1, x1, k));
+    }
+}
+
+/**
+ * Cosine of the elevation of the row i of an equirectangular map, which is
+ * proportional to the solid angle of its texels.
+ */
+inline float RowWeight(int i, int height) {
+    return static_cast<float>(std::sin(M_PI * (i + 0.5) / height));
+}
+
+} // namespace environment_map_internal
+
+/**
+ * Bilinear lookup of an equirectangular image at (u, v).
+ */
+inline void SampleEquirectangular(const ImageF& image, float u, float v,
+                                  float* out) {
+    CHECK(!image.empty());
+
+    environment_map_internal::Bilinear(image, u * image.width() - 0.5f,
+                                       v * image.height() - 0.5f, true, out);
+}
+
+/**
+ * Bilinear lookup of a cubemap (six faces of the same size) in the direction
+ * 'd', with the edges of the faces clamped.
+ */
+inline void SampleCubemap(const Array<ImageF>& faces, const FVector3D& d,
+                          float* out) {
+    CHECK(faces.size() == 6);
+
+    float s, t;
+    const ImageF& face = faces[DirectionToCubemap(d, &s, &t)];
+    environment_map_internal::Bilinear(face, s * face.width() - 0.5f,
+                                       t * face.height() - 0.5f, false, out);
+}
+
+/**
+ * Fill the six (size x size) faces of a cubemap with lookup(d, out), which
+ * writes the 'n_channels' values in the normalized direction 'd'. Each texel
+ * averages n_samples x n_samples stratified lookups. Faces are filled in
+ * parallel.
+ */
+template <typename Lookup>
+void RenderCubemap(int size, int n_channels, int n_samples,
+                   const Lookup& lookup, Array<ImageF>* faces) {
+    CHECK(size > 0);
+    CHECK(n_channels > 0 && n_channels <= 4);
+    CHECK(n_samples > 0);
+    CHECK(faces);
+
+    faces->resize(6);
+    for (ImageF& face : *faces) {
+        face.Reset(size, size, n_channels);
+    }
+
+    const float norm = 1.0f / (n_samples * n_samples);
+    #pragma omp parallel for
+    for (int row = 0; row < 6 * size; ++row) {
+        const int f = row / size, i = row % size;
+        ImageF& face = (*faces)[f];
+        float value[4], sum[4];
+        for (int j = 0; j < size; ++j) {
+            std::fill(sum, sum + 4, 0.0f);
+            for (int a = 0; a < n_samples; ++a) {
+                for (int b = 0; b < n_samples; ++b) {
+                    const float s = (j + (b + 0.5f) / n_samples) / size;
+                    const float t = (i + (a + 0.5f) / n_samples) / size;
+                    lookup(Normalize(CubemapToDirection(f, s, t)), value);
+                    for (int k = 0; k < n_channels; ++k) {
+                        sum[k] += value[k];
+                    }
+                }
+            }
+            for (int k = 0; k < n_channels; ++k) {
+                face(i, j, k) = sum[k] * norm;
+            }
+        }
+    }
+}
+
+/**
+ * Fill a (width x height) equirectangular image with lookup(d, out), see
+ * RenderCubemap(). Rows are filled in parallel.
+ */
+template <typename Lookup>
+void RenderEquirectangular(int width, int height, int n_channels,
+                           int n_samples, const Lookup& lookup,
+                           ImageF* image) {
+    CHECK(width > 0 && height > 0);
+    CHECK(n_channels > 0 && n_channels <= 4);
+    CHECK(n_samples > 0);
+    CHECK(image);
+
+    image->Reset(height, width, n_channels);
+
+    const float norm = 1.0f / (n_samples * n_samples);
+    #pragma omp parallel for
+    for (int i = 0; i < height; ++i) {
+        float value[4], sum[4];
+        for (int j = 0; j < width; ++j) {
+            std::fill(sum, sum + 4, 0.0f);
+            for (int a = 0; a < n_samples; ++a) {
+                for (int b = 0; b < n_samples; ++b) {
+                    const float u = (j + (b + 0.5f) / n_samples) / width;
+                    const float v = (i + (a + 0.5f) / n_samples) / height;
+                    lookup(EquirectangularToDirection(u, v), value);
+                    for (int k = 0; k < n_channels; ++k) {
+                        sum[k] += value[k];
+                    }
+                }
+            }
+            for (int k = 0; k < n_channels; ++k) {
+                (*image)(i, j, k) = sum[k] * norm;
+            }
+        }
+    }
+}
+
+/**
+ * Convert an equirectangular image to a cubemap with faces of the given size.
+ * When the faces are coarser than the image, texels are supersampled to avoid
+ * aliasing.
+ */
+inline void EquirectangularToCubemap(const ImageF& image, int size,
+                                     Array<ImageF>* faces) {
+    CHECK(!image.empty());
+
+    // A face spans a quarter of the longitudes.
+    const int n_samples = Clamp(static_cast<int>(std::ceil(
+        image.width() / (4.0 * size))), 1, 8);
+    RenderCubemap(size, image.n_channels(), n_samples,
+                  [&](const FVector3D& d, float* out) {
+        float u, v;
+        DirectionToEquirectangular(d, &u, &v);
+        SampleEquirectangular(image, u, v, out);
+    }, faces);
+}
+
+/**
+ * Convert a cubemap to a (width x height) equirectangular image.
+ */
+inline void CubemapToEquirectangular(const Array<ImageF>& faces, int width,
+                                     int height, ImageF* image) {
+    CHECK(faces.size() == 6);
+
+    const int n_samples = Clamp(static_cast<int>(std::ceil(
+        4.0 * faces[0].width() / width)), 1, 8);
+    RenderEquirectangular(width, height, faces[0].n_channels(), n_samples,
+                          [&](const FVector3D& d, float* out) {
+        SampleCubemap(faces, d, out);
+    }, image);
+}
+
+/**
+ * Build the mip levels of an equirectangular image. Level 0 is the image and
+ * each next level halves the resolution (rounding down, at least 1). A texel
+ * is the solid-angle weighted mean of the texels that it covers in the
+ * previous level, so that the poles do not bleed into the rest of the map.
+ */
+inline void BuildEquirectangularMipmaps(const ImageF& image,
+                                        Array<ImageF>* levels) {
+    CHECK(!image.empty());
+    CHECK(levels);
+
+    levels->clear();
+    levels->push_back(image);
+    while (levels->back().width() > 1 || levels->back().height() > 1) {
+        const ImageF& src = levels->back();
+        const int w = src.width(), h = src.height(), c = src.n_channels();
+        const int w1 = std::max(w / 2, 1), h1 = std::max(h / 2, 1);
+        ImageF dst(h1, w1, c);
+
+        #pragma omp parallel for if (static_cast<int64_t>(w) * h > 65536)
+        for (int i = 0; i < h1; ++i) {
+            const int r0 = i * h / h1, r1 = (i + 1) * h / h1;
+            for (int j = 0; j < w1; ++j) {
+                const int c0 = j * w / w1, c1 = (j + 1) * w / w1;
+                double sum[4] = { 0.0, 0.0, 0.0, 0.0 }, weight_sum = 0.0;
+                for (int r = r0; r < r1; ++r) {
+                    const double weight =
+                        environment_map_internal::RowWeight(r, h);
+                    for (int col = c0; col < c1; ++col) {
+                        for (int k = 0; k < c; ++k) {
+                            sum[k] += weight * src(r, col, k);
+                        }
+                        weight_sum += weight;
+                    }
+                }
+                for (int k = 0; k < c; ++k) {
+                    dst(i, j, k) = static_cast<float>(sum[k] / weight_sum);
+                }
+            }
+        }
+        levels->push_back(std::move(dst));
+    }
+}
+
+/**
+ * Trilinear lookup of the mip levels at (u, v) and a fractional level.
+ */
+inline void SampleEquirectangularMipmaps(const Array<ImageF>& levels, float u,
+                                         float v, float level, float* out) {
+    CHECK(!levels.empty());
+
+    level = Clamp(level, 0.0f, static_cast<float>(levels.size() - 1));
+    const int l0 = static_cast<int>(level);
+    const int l1 = std::min(l0 + 1, levels.size() - 1);
+    const float t = level - l0;
+
+    float a[4], b[4];
+    SampleEquirectangular(levels[l0], u, v, a);
+    SampleEquirectangular(levels[l1], u, v, b);
+    for (int k = 0; k < levels[l0].n_channels(); ++k) {
+        out[k] = (1.0f - t) * a[k] + t * b[k];
+    }
+}
+
+/**
+ * Mip level whose texels at the equator subtend the given solid angle, for a
+ * (width x height) level 0, e.g. the solid angle of a pixel footprint.
+ */
+inline float EquirectangularMipLevel(int width, int height,
+                                     double solid_angle) {
+    CHECK(width > 0 && height > 0);
+
+    const double texel = 2.0 * M_PI * M_PI / (static_cast<double>(width) *
+                                              height);
+    return solid_angle > texel
+         ? static_cast<float>(0.5 * std::log2(solid_angle / texel)) : 0.0f;
+}
+
+/**
+ * Importance sampling of directions by the luminance of an equirectangular
+ * image, times the solid angle of the texels.
+ */
+class EnvironmentSampler {
+public:
+    EnvironmentSampler() = default;
+
+    explicit EnvironmentSampler(const ImageF& image) {
+        Reset(image);
+    }
+
+    void Reset(const ImageF& image) {
+        CHECK(!image.empty());
+
+        const int w = image.width(), h = image.height();
+        Array<float> weights(w * h);
+        #pragma omp parallel for if (static_cast<int64_t>(w) * h > 65536)
+        for (int i = 0; i < h; ++i) {
+            const float row_weight = environment_map_internal::RowWeight(i, h);
+            for (int j = 0; j < w; ++j) {
+                const float luminance = image.n_channels() >= 3
+                                      ? 0.2126f * image(i, j, 0) +
+                                        0.7152f * image(i, j, 1) +
+                                        0.0722f * image(i, j, 2)
+                                      : image(i, j, 0);
+                weights[i * w + j] = luminance * row_weight;
+            }
+        }
+        distribution_.Reset(w, h, weights.data());
+    }
+
+    /**
+     * Map (u1, u2) in [0, 1)^2 to a unit direction, and return its density
+     * with respect to the solid angle in 'pdf' (optional).
+     */
+    FVector3D Sample(float u1, float u2, float* pdf = nullptr) const {
+        float u, v, pdf_uv;
+        distribution_.Sample(u1, u2, &u, &v, &pdf_uv);
+        const FVector3D d = EquirectangularToDirection(u, v);
+        if (pdf) *pdf = SolidAnglePdf(pdf_uv, d);
+        return d;
+    }
+
+    /**
+     * Density of the unit direction 'd' with respect to the solid angle.
+     */
+    float Pdf(const FVector3D& d) const {
+        float u, v;
+        DirectionToEquirectangular(d, &u, &v);
+        return SolidAnglePdf(distribution_.Pdf(u, v), d);
+    }
+
+    const Distribution2D& distribution() const {
+        return distribution_;
+    }
+
+private:
+    /**
+     * dw = cos(elevation) * 2pi du * pi dv. The cosine is computed from x and
+     * y, which keeps its precision near the poles.
+     */
+    static float SolidAnglePdf(float pdf_uv, const FVector3D& d) {
+        const double r = std::hypot(static_cast<double>(d.x), d.y);
+        const double cos_elevation = r / std::hypot(r, d.z);
+        return cos_elevation > 0.0
+             ? static_cast<float>(pdf_uv / (2.0 * M_PI * M_PI * cos_elevation))
+             : 0.0f;
+    }
+
+    Distribution2D distribution_;
+};
+
+} // namespace image
+} // namespace cl
+
+#endif // CODELIBRARY_IMAGE_ENVIRONMENT_MAP_H_
@@ -211,7 +211,7 @@ public:
         std::swap(width_, image->width_);
         std::swap(height_, image->height_);
         std::swap(n_channels_, image->n_channels_);
-        data_.swap(image->data());
+        data_.swap(image->data_);
     }
 
     /**
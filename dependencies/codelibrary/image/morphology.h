@@ -9,7 +9,9 @@
 #ifndef CODELIBRARY_IMAGE_MORPHOLOGY_H_
 #define CODELIBRARY_IMAGE_MORPHOLOGY_H_
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <queue>
 
 #include "codelibrary/base/array_nd.h"
@@ -130,8 +132,222 @@ inline void GetBoundary(const Image& image, int content_pixel,
     GetBoundary(image, content_pixel, Square(3), boundary);
 }
 
+namespace internal {
+
+template <typename T>
+struct MaxOp {
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    T operator()(T a, T b) const { return a < b ? b : a; }
+};
+
+template <typename T>
+struct MinOp {
+    static T identity() { return std::numeric_limits<T>::max(); }
+    T operator()(T a, T b) const { return b < a ? b : a; }
+};
+
+/**
+ * Van Herk/Gil-Werman running max (or min) over every window of 'k'
+ * consecutive samples of the sequence 'p'. Each sample is a vector of 'm'
+ * lanes, stored contiguously:
+ *
+ *   out[x] = op(p[x], p[x + 1], ..., p[x + k - 1]),  0 <= x < n_out.
+ *
+ * 'p' is split into blocks of k samples, 'g' stores the prefix op inside each
+ * block and 'h' the suffix op, so that every window is op(h[x], g[x + k - 1]).
+ * It costs three operations per sample, whatever the window size is.
+ *
+ * 'length' must be a multiple of k and at least n_out + k - 1. 'g' and 'h' are
+ * scratch buffers of length * m samples; out[x] is written at x * out_stride.
+ */
+template <typename T, typename Op>
+void VanHerkGilWerman(const T* p, int length, int k, int m, int n_out,
+                      int out_stride, T* g, T* h, T* out) {
+    const Op op;
+    for (int start = 0; start < length; start += k) {
+        const int end = start + k - 1;
+
+        std::copy(p + start * m, p + (start + 1) * m, g + start * m);
+        for (int i = start + 1; i <= end; ++i) {
+            const T* a = g + (i - 1) * m;
+            const T* b = p + i * m;
+            T* o = g + i * m;
+            for (int l = 0; l < m; ++l) {
+                o[l] = op(a[l], b[l]);
+            }
+        }
+
+        std::copy(p + end * m, p + (end + 1) * m, h + end * m);
+        for (int i = end - 1; i >= start; --i) {
+            const T* a = h + (i + 1) * m;
+            const T* b = p + i * m;
+            T* o = h + i * m;
+            for (int l = 0; l < m; ++l) {
+                o[l] = op(a[l], b[l]);
+            }
+        }
+    }
+
+    for (int x = 0; x < n_out; ++x) {
+        const T* a = h + x * m;
+        const T* b = g + (x + k - 1) * m;
+        T* o = out + x * out_stride;
+        for (int l = 0; l < m; ++l) {
+            o[l] = op(a[l], b[l]);
+        }
+    }
+}
+
+/**
+ * Rectangle max (or min) filter, i.e., flat dilation (or erosion). The kernel
+ * covers the offsets [-(k - 1) / 2, k / 2] along each axis, the same as
+ * Square(k). Pixels outside the image are ignored.
+ *
+ * It runs a horizontal pass over rows, and a vertical pass over strips of
+ * columns, where all the operations are between whole row segments and can be
+ * vectorized. Both passes are parallel.
+ */
+template <typename T, typename Op>
+void RectangleFilter(const BaseImage<T>& image, int kernel_width,
+                     int kernel_height, BaseImage<T>* result) {
+    CHECK(kernel_width > 0 && kernel_height > 0);
+    CHECK(result);
+
+    const int w = image.width(), h = image.height(), c = image.n_channels();
+    const T identity = Op::identity();
+
+    BaseImage<T> tmp;
+    tmp.Reset(h, w, c);
+
+    // Horizontal pass. Each padded row holds a = (k - 1) / 2 identity samples
+    // on the left, so output x reads the window starting at x.
+    {
+        const int k = kernel_width;
+        const int a = (k - 1) / 2;
+        const int length = (w + k - 1 + k - 1) / k * k;
+        const T* src = image.data();
+        T* dst = tmp.data();
+
+        #pragma omp parallel if (static_cast<double>(w) * h * c > 65536)
+        {
+            Array<T> p(length * c, identity), g(length * c), hs(length * c);
+
+            #pragma omp for schedule(static)
+            for (int y = 0; y < h; ++y) {
+                std::copy(src + y * w * c, src + (y + 1) * w * c,
+                          p.data() + a * c);
+                VanHerkGilWerman<T, Op>(p.data(), length, k, c, w, c,
+                                        g.data(), hs.data(), dst + y * w * c);
+            }
+        }
+    }
+
+    result->Reset(h, w, c);
+
+    // Vertical pass over strips of columns.
+    {
+        const int k = kernel_height;
+        const int a = (k - 1) / 2;
+        const int length = (h + k - 1 + k - 1) / k * k;
+        const int line = w * c;
+        const int strip = 256;
+        const int n_strips = (line + strip - 1) / strip;
+        const T* src = tmp.data();
+        T* dst = result->data();
+
+        #pragma omp parallel if (static_cast<double>(w) * h * c > 65536)
+        {
+            Array<T> p(length * strip), g(length * strip), hs(length * strip);
+
+            #pragma omp for schedule(static)
+            for (int s = 0; s < n_strips; ++s) {
+                const int x0 = s * strip;
+                const int m = std::min(strip, line - x0);
+                for (int i = 0; i < length; ++i) {
+                    const int y = i - a;
+                    T* pi = p.data() + i * m;
+                    if (y >= 0 && y < h) {
+                        std::copy(src + y * line + x0, src + y * line + x0 + m,
+                                  pi);
+                    } else {
+                        std::fill(pi, pi + m, identity);
+                    }
+                }
+                VanHerkGilWerman<T, Op>(p.data(), length, k, m, h, line,
+                                        g.data(), hs.data(), dst + x0);
+            }
+        }
+    }
+}
+
+/**
+ * Threshold the L1 (city block) distance from each pixel to the nearest
+ * 'feature_pixel' pixel:
+ *
+ *   result(x, y) = distance <= radius ? feature_pixel : other_pixel.
+ *
+ * The distance is computed by two sweeps along rows and two sweeps along
+ * columns on integers saturated at radius + 1. The column sweeps operate on
+ * whole rows so that they vectorize.
+ */
+inline void ThresholdManhattanDistance(const Image& image, int radius,
+                                       int feature_pixel, int other_pixel,
+                                       Image* result) {
+    const int w = image.width(), h = image.height();
+    const int cap = std::min(radius, w + h) + 1;
+    const Image::Byte* data = image.data();
+
+    Array<int> dist(w * h);
+
+    #pragma omp parallel for if (static_cast<double>(w) * h > 65536)
+    for (int y = 0; y < h; ++y) {
+        const Image::Byte* src = data + y * w;
+        int* d = dist.data() + y * w;
+        int prev = cap;
+        for (int x = 0; x < w; ++x) {
+            prev = src[x] == feature_pixel ? 0 : std::min(prev + 1, cap);
+            d[x] = prev;
+        }
+        for (int x = w - 2; x >= 0; --x) {
+            d[x] = std::min(d[x], d[x + 1] + 1);
+        }
+    }
+
+    const int strip = 1024;
+    const int n_strips = (w + strip - 1) / strip;
+
+    #pragma omp parallel for if (static_cast<double>(w) * h > 65536)
+    for (int s = 0; s < n_strips; ++s) {
+        const int x0 = s * strip;
+        const int x1 = std::min(w, x0 + strip);
+        for (int y = 1; y < h; ++y) {
+            const int* a = dist.data() + (y - 1) * w;
+            int* b = dist.data() + y * w;
+            for (int x = x0; x < x1; ++x) {
+                b[x] = std::min(b[x], a[x] + 1);
+            }
+        }
+        for (int y = h - 2; y >= 0; --y) {
+            const int* a = dist.data() + (y + 1) * w;
+            int* b = dist.data() + y * w;
+            for (int x = x0; x < x1; ++x) {
+                b[x] = std::min(b[x], a[x] + 1);
+            }
+        }
+    }
+
+    Image::Byte* out = result->data();
+    #pragma omp parallel for if (static_cast<double>(w) * h > 65536)
+    for (int i = 0; i < w * h; ++i) {
+        out[i] = dist[i] <= radius ? feature_pixel : other_pixel;
+    }
+}
+
+} // namespace internal
+
 /**
- * Compute morphological dilation of an image using square kernel.
+ * Compute morphological dilation of an image using a rectangle kernel of size
+ * kernel_width x kernel_height.
  *
  * Morphological dilation sets a pixel at (x,y) to the maximum over all pixels
  * in the neighborhood centered at (x,y):
@@ -139,6 +355,45 @@ inline void GetBoundary(const Image& image, int content_pixel,
  *   dst(x, y) =        max          src(x + x', y + y')
  *              (x',y') \in N(x, y)
  *
+ * The neighborhood is the same as Square(k) for a k x k kernel, pixels
+ * outside the image are ignored. Every channel is filtered independently.
+ *
+ * It uses the van Herk/Gil-Werman algorithm, which costs O(1) per pixel for
+ * any kernel size.
+ */
+template <typename T>
+void Dilate(const BaseImage<T>& image, int kernel_width, int kernel_height,
+            BaseImage<T>* result) {
+    internal::RectangleFilter<T, internal::MaxOp<T>>(image, kernel_width,
+                                                     kernel_height, result);
+}
+
+/**
+ * Compute morphological erosion of an image using a rectangle kernel of size
+ * kernel_width x kernel_height.
+ *
+ * Morphological erosion sets a pixel at (x,y) to the minimum over all pixels
+ * in the neighborhood centered at (x,y):
+ *
+ *   dst(x, y) =        min          src(x + x', y + y')
+ *              (x',y') \in N(x, y)
+ *
+ * See Dilate() for the neighborhood and the algorithm.
+ */
+template <typename T>
+void Erode(const BaseImage<T>& image, int kernel_width, int kernel_height,
+           BaseImage<T>* result) {
+    internal::RectangleFilter<T, internal::MinOp<T>>(image, kernel_width,
+                                                     kernel_height, result);
+}
+
+/**
+ * Compute morphological dilation of a binary image using a diamond kernel.
+ *
+ * A pixel is set to 255 if its city block (Manhattan) distance to the nearest
+ * 255 pixel is no greater than radius, and to 0 otherwise. Use Dilate() for
+ * rectangle kernels.
+ *
  * Here, we assume that the given image is a binary image, the pixel value is
  * either 0 or 255.
  */
@@ -150,22 +405,15 @@ inline void BinaryDilate(const Image& image, int radius, Image* result) {
     *result = image;
     if (radius == 0) return;
 
-    ManhattanDistanceTransform dt(image, 255);
-    const Array<double>& dis = dt.distance_map();
-    Image::Byte* data = result->data();
-    for (int i = 0; i < dis.size(); ++i) {
-        data[i] = (dis[i] <= radius) ? 255 : 0;
-    }
+    internal::ThresholdManhattanDistance(image, radius, 255, 0, result);
 }
 
 /**
- * Compute morphological erosion of an image using square kernel.
+ * Compute morphological erosion of a binary image using a diamond kernel.
  *
- * Morphological dilation sets a pixel at (x,y) to the maximum over all pixels
- * in the neighborhood centered at (x,y):
- *
- *   dst(x, y) =        max          src(x + x', y + y')
- *              (x',y') \in N(x, y)
+ * A pixel is set to 0 if its city block (Manhattan) distance to the nearest 0
+ * pixel is no greater than radius, and to 255 otherwise. Use Erode() for
+ * rectangle kernels.
  *
  * Here, we assume that the given image is a binary image, the pixel value is
  * either 0 or 255.
@@ -178,12 +426,7 @@ inline void BinaryErode(const Image& image, int radius, Image* result) {
     *result = image;
     if (radius == 0) return;
 
-    ManhattanDistanceTransform dt(image, 0);
-    const Array<double>& dis = dt.distance_map();
-    Image::Byte* data = result->data();
-    for (int i = 0; i < dis.size(); ++i) {
-        data[i] = (dis[i] <= radius) ? 0 : 255;
-    }
+    internal::ThresholdManhattanDistance(image, radius, 0, 255, result);
 }
 
 /**
@@ -247,6 +490,15 @@ void Flood(const Image& image, const Pixel& seed_point,
  * Compute a label image so that all connected regions are assigned the same
  * integer value.
  *
+ * Two pixels are connected if they have the same value (in the first channel)
+ * and one is in the neighborhood of the other. The neighborhood is treated as
+ * symmetric. Labels are numbered in the raster order of the first pixel of
+ * each region.
+ *
+ * The image is split into stripes of rows that are labeled in parallel with a
+ * union-find, where each set is represented by its smallest pixel index. The
+ * stripes are then merged along their borders.
+ *
  * return the number of labels.
  */
 template <typename StructuringElement>
@@ -255,27 +507,130 @@ int GetLabelImage(const Image& image,
                   ArrayND<int>* labels) {
     CHECK(labels);
 
-    int n_labels = 0;
-    int w = image.width(), h = image.height();
+    const int w = image.width(), h = image.height(), c = image.n_channels();
     labels->reshape(h, w);
+    if (w == 0 || h == 0) return 0;
+
+    // Offsets to the neighbors that come earlier in raster order.
+    Array<Pixel> offsets;
+    int max_dy = 0;
+    for (const Pixel& q : neighbors) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            Pixel p(sign * q.x, sign * q.y);
+            if (p.y < 0 || (p.y == 0 && p.x < 0)) {
+                if (std::find(offsets.begin(), offsets.end(), p) ==
+                    offsets.end()) {
+                    offsets.push_back(p);
+                    max_dy = std::max(max_dy, -p.y);
+                }
+            }
+        }
+    }
+
+    const Image::Byte* data = image.data();
+    Array<int> parent(w * h);
+    auto find = [&](int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    auto unite = [&](int i, int j) {
+        i = find(i);
+        j = find(j);
+        if (i < j) {
+            parent[j] = i;
+        } else if (j < i) {
+            parent[i] = j;
+        }
+    };
+
+    // Only pixels in rows [first_row, y] are united with pixel (x, y).
+    auto unite_neighbors = [&](int x, int y, int first_row) {
+        const int i = y * w + x;
+        for (const Pixel& p : offsets) {
+            const int x1 = x + p.x, y1 = y + p.y;
+            if (y1 < first_row || x1 < 0 || x1 >= w) continue;
 
-    ArrayND<bool> is_visited(h, w);
-    is_visited.fill(false);
-
-    Array<Pixel> pixels;
-    for (int i = 0; i < h; ++i) {
-        for (int j = 0; j < w; ++j) {
-            if (is_visited(i, j)) continue;
-            
-            Flood(image, Pixel(j, i), neighbors, &pixels);
-            for (auto pixel : pixels) {
-                is_visited(pixel.y, pixel.x) = true;
-                (*labels)(pixel.y, pixel.x) = n_labels;
+            const int j = y1 * w + x1;
+            if (data[j * c] == data[i * c]) unite(i, j);
+        }
+    };
+
+    const int stripe = std::max(64, max_dy);
+    const int n_stripes = (h + stripe - 1) / stripe;
+
+    // Stripes only link pixels inside themselves, so they are independent.
+    #pragma omp parallel for schedule(dynamic) \
+            if (static_cast<double>(w) * h > 65536)
+    for (int s = 0; s < n_stripes; ++s) {
+        const int y0 = s * stripe, y1 = std::min(h, y0 + stripe);
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < w; ++x) {
+                parent[y * w + x] = y * w + x;
+                unite_neighbors(x, y, y0);
             }
-            n_labels++;
         }
     }
-    return n_labels;
+
+    // Merge the stripes along their borders.
+    for (int s = 1; s < n_stripes; ++s) {
+        const int y0 = s * stripe;
+        const int y1 = std::min(h, y0 + max_dy);
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < w; ++x) {
+                const int i = y * w + x;
+                for (const Pixel& p : offsets) {
+                    const int xj = x + p.x, yj = y + p.y;
+                    if (yj >= y0 || yj < 0 || xj < 0 || xj >= w) continue;
+
+                    const int j = yj * w + xj;
+                    if (data[j * c] == data[i * c]) unite(i, j);
+                }
+            }
+        }
+    }
+
+    // Resolve the roots and count them per stripe. Nothing is written to
+    // 'parent' here, so the stripes can be processed in parallel.
+    int* label = labels->data();
+    Array<int> n_roots(n_stripes + 1, 0);
+
+    #pragma omp parallel for schedule(dynamic) \
+            if (static_cast<double>(w) * h > 65536)
+    for (int s = 0; s < n_stripes; ++s) {
+        const int begin = s * stripe * w;
+        const int end = std::min(h, (s + 1) * stripe) * w;
+        for (int i = begin; i < end; ++i) {
+            int r = i;
+            while (parent[r] != r) r = parent[r];
+            label[i] = r;
+            if (r == i) ++n_roots[s + 1];
+        }
+    }
+    for (int s = 0; s < n_stripes; ++s) {
+        n_roots[s + 1] += n_roots[s];
+    }
+
+    // Number the roots in raster order, and store each number at its root.
+    #pragma omp parallel for schedule(dynamic) \
+            if (static_cast<double>(w) * h > 65536)
+    for (int s = 0; s < n_stripes; ++s) {
+        const int begin = s * stripe * w;
+        const int end = std::min(h, (s + 1) * stripe) * w;
+        int n = n_roots[s];
+        for (int i = begin; i < end; ++i) {
+            if (label[i] == i) parent[i] = n++;
+        }
+    }
+
+    #pragma omp parallel for if (static_cast<double>(w) * h > 65536)
+    for (int i = 0; i < w * h; ++i) {
+        label[i] = parent[label[i]];
+    }
+
+    return n_roots[n_stripes];
 }
 
 } // namespace morphology
@@ -0,0 +1,675 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_IMAGE_TONEMAPPER_H_
+#define CODELIBRARY_IMAGE_TONEMAPPER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "codelibrary/base/float.h"
+#include "codelibrary/base/log.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CL_TONEMAP_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace cl {
+namespace image {
+
+/**
+ * Color space of a render buffer. VisPosNeg stores a signed value as a
+ * positive red and a negative green part.
+ */
+enum class ColorSpace {
+    kLinear,
+    kSRGB,
+    kVisPosNeg
+};
+
+/**
+ * Tone mapping curves, applied in linear space after the exposure.
+ */
+enum class ToneCurve {
+    kIdentity,
+    kACES,
+    kHable,
+    kReinhard
+};
+
+/**
+ * sRGB transfer functions, with the same constants as the renderer.
+ */
+inline float SRGBToLinear(float srgb) {
+    return srgb <= 0.04045f ? srgb / 12.92f
+                            : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float LinearToSRGB(float linear) {
+    return linear < 0.0031308f ? 12.92f * linear
+                               : 1.055f * std::pow(linear, 0.41666f) - 0.055f;
+}
+
+namespace tonemap_internal {
+
+/**
+ * Coefficients of the rational curves nom(x) / denom(x), where
+ *   nom(x)   = k0 x^2 + k1 x + k2,
+ *   denom(x) = k3 x^2 + k4 x + k5.
+ */
+struct RationalCurve {
+    float k[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+};
+
+inline RationalCurve GetRationalCurve(ToneCurve curve) {
+    RationalCurve c;
+    float* k = c.k;
+    if (curve == ToneCurve::kACES) {
+        // ACES approximation by Krzysztof Narkowicz, with the pre-exposure
+        // cancelation included in the constants.
+        k[0] = 0.6f * 0.6f * 2.51f;
+        k[1] = 0.6f * 0.03f;
+        k[2] = 0.0f;
+        k[3] = 0.6f * 0.6f * 2.43f;
+        k[4] = 0.6f * 0.59f;
+        k[5] = 0.14f;
+    } else if (curve == ToneCurve::kHable) {
+        // Uncharted 2 curve by John Hable, with the white scale and exposure
+        // bias included in the constants.
+        const float A = 0.15f, B = 0.50f, C = 0.10f;
+        const float D = 0.20f, E = 0.02f, F = 0.30f;
+        k[0] = A * F - A * E;
+        k[1] = C * B * F - B * E;
+        k[2] = 0.0f;
+        k[3] = A * F;
+        k[4] = B * F;
+        k[5] = D * F * F;
+
+        const float W = 11.2f;
+        const float nom = k[0] * (W * W) + k[1] * W + k[2];
+        const float denom = k[3] * (W * W) + k[4] * W + k[5];
+        const float white_scale = denom / nom;
+
+        k[0] = 4.0f * k[0] * white_scale;
+        k[1] = 2.0f * k[1] * white_scale;
+        k[2] = k[2] * white_scale;
+        k[3] = 4.0f * k[3];
+        k[4] = 2.0f * k[4];
+    }
+    return c;
+}
+
+#if defined(CL_TONEMAP_X86_DISPATCH)
+
+#define CL_TONEMAP_TARGET __attribute__((target("avx2,fma,f16c")))
+
+/**
+ * Whether the running CPU supports the AVX2 kernels (checked once).
+ */
+inline bool HasAVX2() {
+    static const bool has_avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("fma") &&
+               __builtin_cpu_supports("f16c");
+    }();
+    return has_avx2;
+}
+
+/**
+ * 2^x for 8 floats, by a polynomial on [-0.5, 0.5] (Cephes exp2f). The
+ * relative error is about 2e-7.
+ */
+CL_TONEMAP_TARGET inline __m256 Exp2(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)),
+                      _mm256_set1_ps(126.0f));
+    const __m256 n = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT |
+                                        _MM_FROUND_NO_EXC);
+    const __m256 f = _mm256_sub_ps(x, n);
+
+    __m256 p = _mm256_set1_ps(1.535336188319500e-4f);
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.339887440266574e-3f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(9.618437357674640e-3f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(5.550332471162809e-2f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(2.402264791363012e-1f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(6.931472028550421e-1f));
+    p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n),
+                                 _mm256_set1_epi32(127));
+    e = _mm256_slli_epi32(e, 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+}
+
+/**
+ * log2(x) for 8 positive normal floats (Cephes log2f). The absolute error is
+ * about 1e-7.
+ */
+CL_TONEMAP_TARGET inline __m256 Log2(__m256 x) {
+    const __m256i bits = _mm256_castps_si256(x);
+    // x = m * 2^e with m in [0.5, 1).
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(
+        _mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+        _mm256_set1_epi32(0x3F000000)));
+
+    // Move m to [sqrt(0.5) - 1, sqrt(2) - 1).
+    const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f),
+                                       _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1.0f)));
+    m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)),
+                      _mm256_set1_ps(1.0f));
+
+    const __m256 z = _mm256_mul_ps(m, m);
+    __m256 p = _mm256_set1_ps(7.0376836292e-2f);
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.1514610310e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(1.1676998740e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.2420140846e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(1.4249322787e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.6668057665e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(2.0000714765e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-2.4999993993e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(3.3333331174e-1f));
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+    y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, y);
+
+    // log2(1 + m) = (y + m) * log2(e), with log2(e) split as 1 + log2ea.
+    const __m256 log2ea = _mm256_set1_ps(0.44269504088896340736f);
+    __m256 r = _mm256_mul_ps(y, log2ea);
+    r = _mm256_fmadd_ps(m, log2ea, r);
+    r = _mm256_add_ps(r, y);
+    r = _mm256_add_ps(r, m);
+    return _mm256_add_ps(r, e);
+}
+
+CL_TONEMAP_TARGET inline __m256 SRGBToLinear(__m256 x) {
+    const __m256 base = _mm256_mul_ps(_mm256_add_ps(x, _mm256_set1_ps(0.055f)),
+                                      _mm256_set1_ps(1.0f / 1.055f));
+    const __m256 curve = Exp2(_mm256_mul_ps(
+        Log2(_mm256_max_ps(base, _mm256_set1_ps(1e-30f))),
+        _mm256_set1_ps(2.4f)));
+    const __m256 linear = _mm256_div_ps(x, _mm256_set1_ps(12.92f));
+    const __m256 low = _mm256_cmp_ps(x, _mm256_set1_ps(0.04045f), _CMP_LE_OQ);
+    return _mm256_blendv_ps(curve, linear, low);
+}
+
+CL_TONEMAP_TARGET inline __m256 LinearToSRGB(__m256 x) {
+    const __m256 power = Exp2(_mm256_mul_ps(
+        Log2(_mm256_max_ps(x, _mm256_set1_ps(1e-30f))),
+        _mm256_set1_ps(0.41666f)));
+    const __m256 curve = _mm256_fmsub_ps(_mm256_set1_ps(1.055f), power,
+                                         _mm256_set1_ps(0.055f));
+    const __m256 linear = _mm256_mul_ps(x, _mm256_set1_ps(12.92f));
+    const __m256 low = _mm256_cmp_ps(x, _mm256_set1_ps(0.0031308f),
+                                     _CMP_LT_OQ);
+    return _mm256_blendv_ps(curve, linear, low);
+}
+
+/**
+ * Load 8 RGBA pixels into one register per channel. The pixels are in the
+ * order 0, 2, 4, 6, 1, 3, 5, 7, which is undone by Store().
+ */
+CL_TONEMAP_TARGET inline void Load(const float* rgba, __m256 channels[4]) {
+    const __m256 p0 = _mm256_loadu_ps(rgba);
+    const __m256 p1 = _mm256_loadu_ps(rgba + 8);
+    const __m256 p2 = _mm256_loadu_ps(rgba + 16);
+    const __m256 p3 = _mm256_loadu_ps(rgba + 24);
+    const __m256 t0 = _mm256_unpacklo_ps(p0, p1);
+    const __m256 t1 = _mm256_unpackhi_ps(p0, p1);
+    const __m256 t2 = _mm256_unpacklo_ps(p2, p3);
+    const __m256 t3 = _mm256_unpackhi_ps(p2, p3);
+    channels[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    channels[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    channels[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    channels[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+/**
+ * Inverse of Load(): pixels[k] holds the RGBA values of pixels 2k and 2k + 1.
+ */
+CL_TONEMAP_TARGET inline void Interleave(const __m256 channels[4],
+                                         __m256 pixels[4]) {
+    const __m256 t0 = _mm256_unpacklo_ps(channels[0], channels[1]);
+    const __m256 t1 = _mm256_unpacklo_ps(channels[2], channels[3]);
+    const __m256 t2 = _mm256_unpackhi_ps(channels[0], channels[1]);
+    const __m256 t3 = _mm256_unpackhi_ps(channels[2], channels[3]);
+    pixels[0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    pixels[1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    pixels[2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    pixels[3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+CL_TONEMAP_TARGET inline void Store(const __m256 channels[4], float* out) {
+    __m256 pixels[4];
+    Interleave(channels, pixels);
+    for (int k = 0; k < 4; ++k) {
+        _mm256_storeu_ps(out + 8 * k, pixels[k]);
+    }
+}
+
+CL_TONEMAP_TARGET inline void Store(const __m256 channels[4], Half* out) {
+    static_assert(sizeof(Half) == 2, "");
+    __m256 pixels[4];
+    Interleave(channels, pixels);
+    for (int k = 0; k < 4; ++k) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8 * k),
+                         _mm256_cvtps_ph(pixels[k], _MM_FROUND_TO_NEAREST_INT));
+    }
+}
+
+/**
+ * Quantize to [0, max_value], rounding half up as the scalar code does.
+ */
+CL_TONEMAP_TARGET inline __m256i Quantize(__m256 x, float max_value) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()),
+                      _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_fmadd_ps(x, _mm256_set1_ps(max_value),
+                                               _mm256_set1_ps(0.5f)));
+}
+
+/**
+ * Pack pixels 0..3 of 'pixels' to 16 bits, in order.
+ */
+CL_TONEMAP_TARGET inline __m256i Pack16(const __m256 pixels[2],
+                                        float max_value) {
+    const __m256i q = _mm256_packus_epi32(Quantize(pixels[0], max_value),
+                                          Quantize(pixels[1], max_value));
+    return _mm256_permute4x64_epi64(q, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+CL_TONEMAP_TARGET inline void Store(const __m256 channels[4], uint16_t* out) {
+    __m256 pixels[4];
+    Interleave(channels, pixels);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        Pack16(pixels, 65535.0f));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16),
+                        Pack16(pixels + 2, 65535.0f));
+}
+
+CL_TONEMAP_TARGET inline void Store(const __m256 channels[4], uint8_t* out) {
+    __m256 pixels[4];
+    Interleave(channels, pixels);
+    const __m256i q = _mm256_packus_epi16(Pack16(pixels, 255.0f),
+                                          Pack16(pixels + 2, 255.0f));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_permute4x64_epi64(q, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+/**
+ * Accumulate the pixels of a row in groups of eight for the linear and sRGB
+ * color spaces, and return the number of processed pixels.
+ */
+CL_TONEMAP_TARGET inline int AccumulateRow(int width, const float* frame,
+                                           float sample_count,
+                                           ColorSpace color_space,
+                                           float* accumulation) {
+    const __m256 count = _mm256_set1_ps(sample_count);
+    const __m256 next_count = _mm256_set1_ps(sample_count + 1.0f);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256 color[4], tmp[4];
+        Load(frame + 4 * x, color);
+        Load(accumulation + 4 * x, tmp);
+        for (int c = 0; c < 4; ++c) {
+            if (c < 3 && color_space == ColorSpace::kSRGB) {
+                color[c] = LinearToSRGB(color[c]);
+            }
+            tmp[c] = _mm256_div_ps(_mm256_fmadd_ps(tmp[c], count, color[c]),
+                                   next_count);
+        }
+        Store(tmp, accumulation + 4 * x);
+    }
+    return x;
+}
+
+#endif // CL_TONEMAP_X86_DISPATCH
+
+/**
+ * Scalar output conversions, matching the AVX2 ones.
+ */
+inline void StorePixel(const float rgba[4], float* out) {
+    std::memcpy(out, rgba, 4 * sizeof(float));
+}
+
+inline void StorePixel(const float rgba[4], Half* out) {
+    for (int c = 0; c < 4; ++c) {
+        out[c] = Half(rgba[c]);
+    }
+}
+
+template <typename T>
+void QuantizePixel(const float rgba[4], float max_value, T* out) {
+    for (int c = 0; c < 4; ++c) {
+        const float x = std::min(std::max(rgba[c], 0.0f), 1.0f);
+        out[c] = static_cast<T>(static_cast<int>(x * max_value + 0.5f));
+    }
+}
+
+inline void StorePixel(const float rgba[4], uint16_t* out) {
+    QuantizePixel(rgba, 65535.0f, out);
+}
+
+inline void StorePixel(const float rgba[4], uint8_t* out) {
+    QuantizePixel(rgba, 255.0f, out);
+}
+
+} // namespace tonemap_internal
+
+/**
+ * Progressive accumulation of RGBA frames, as done by the renderer:
+ *
+ *   accumulation = (accumulation * sample_count + frame) / (sample_count + 1)
+ *
+ * In the sRGB color space, the (linear) rgb of the frame is converted to sRGB
+ * first. In the VisPosNeg color space, the difference of red and green is
+ * accumulated. The frames have 'width' x 'height' RGBA floats, row-major.
+ */
+inline void Accumulate(int width, int height, const float* frame,
+                       int sample_count, ColorSpace color_space,
+                       float* accumulation) {
+    CHECK(width >= 0 && height >= 0);
+    CHECK(sample_count >= 0);
+    CHECK(frame && accumulation);
+
+    const float count = static_cast<float>(sample_count);
+    const float next_count = count + 1.0f;
+    auto accumulate_pixel = [&](const float* color, float* tmp) {
+        if (color_space == ColorSpace::kVisPosNeg) {
+            float tmp_val = tmp[0] - tmp[1];
+            tmp_val = (tmp_val * count + (color[0] - color[1])) /
+                      next_count;
+            tmp[0] = std::max(tmp_val, 0.0f);
+            tmp[1] = std::max(-tmp_val, 0.0f);
+        } else {
+            for (int c = 0; c < 3; ++c) {
+                const float v = color_space == ColorSpace::kSRGB
+                              ? LinearToSRGB(color[c]) : color[c];
+                tmp[c] = (tmp[c] * count + v) / next_count;
+            }
+        }
+        tmp[3] = (tmp[3] * count + color[3]) / next_count;
+    };
+
+#if defined(CL_TONEMAP_X86_DISPATCH)
+    const bool simd = color_space != ColorSpace::kVisPosNeg &&
+                      tonemap_internal::HasAVX2();
+#else
+    const bool simd = false;
+#endif
+
+    #pragma omp parallel for if (static_cast<int64_t>(width) * height > 65536)
+    for (int y = 0; y < height; ++y) {
+        const float* in = frame + static_cast<int64_t>(y) * width * 4;
+        float* out = accumulation + static_cast<int64_t>(y) * width * 4;
+        int x = 0;
+#if defined(CL_TONEMAP_X86_DISPATCH)
+        if (simd) {
+            x = tonemap_internal::AccumulateRow(width, in, count,
+                                                color_space, out);
+        }
+#endif
+        for (; x < width; ++x) {
+            accumulate_pixel(in + 4 * x, out + 4 * x);
+        }
+    }
+}
+
+/**
+ * Tonemapper converts accumulated RGBA buffers to displayable images, with
+ * the same steps as the renderer:
+ *
+ *  1. Blend the background (given in sRGB) behind the premultiplied color.
+ *  2. Convert to linear space if the buffer is in sRGB.
+ *  3. Multiply by 2^exposure.
+ *  4. Apply the tone curve.
+ *  5. Convert to the output color space.
+ *  6. Optionally unmultiply alpha and clamp to [0, 1].
+ *
+ * The output can be float, Half, or 8-bit and 16-bit unsigned integers, which
+ * are always clamped to [0, 1] and rounded to nearest.
+ *
+ * Rows are processed in parallel. On x86 CPUs with AVX2, eight pixels are
+ * processed at once and the sRGB power functions are evaluated by polynomials
+ * whose relative error is about 1e-6, so results may differ from the scalar
+ * path by one unit in the last place of 8-bit or 16-bit outputs.
+ */
+class Tonemapper {
+public:
+    struct Options {
+        float exposure = 0.0f;
+
+        // Color space of the input buffer.
+        ColorSpace color_space = ColorSpace::kLinear;
+
+        // Color space of the output.
+        ColorSpace output_color_space = ColorSpace::kSRGB;
+
+        ToneCurve curve = ToneCurve::kIdentity;
+
+        // Background RGBA, with the rgb in sRGB.
+        float background[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+        bool unmultiply_alpha = false;
+        bool clamp_output = false;
+    };
+
+    Tonemapper() : Tonemapper(Options()) {}
+
+    explicit Tonemapper(const Options& options)
+        : options_(options) {
+        exposure_scale_ = std::pow(2.0f, options.exposure);
+        for (int c = 0; c < 3; ++c) {
+            background_[c] = options.color_space == ColorSpace::kSRGB
+                           ? options.background[c]
+                           : SRGBToLinear(options.background[c]);
+        }
+        background_[3] = options.background[3];
+        rational_ = tonemap_internal::GetRationalCurve(options.curve);
+    }
+
+    /**
+     * Tonemap one RGBA pixel with the scalar code.
+     */
+    void TonemapPixel(const float in[4], float out[4]) const {
+        float c[4] = { in[0], in[1], in[2], in[3] };
+        const float weight = (1.0f - c[3]) * background_[3];
+        for (int i = 0; i < 3; ++i) {
+            c[i] += background_[i] * weight;
+        }
+        c[3] += weight;
+
+        for (int i = 0; i < 3; ++i) {
+            if (options_.color_space == ColorSpace::kSRGB) {
+                c[i] = SRGBToLinear(c[i]);
+            }
+            c[i] *= exposure_scale_;
+        }
+
+        if (options_.curve != ToneCurve::kIdentity) {
+            for (int i = 0; i < 3; ++i) {
+                c[i] = std::max(c[i], 0.0f);
+            }
+            if (options_.curve == ToneCurve::kReinhard) {
+                const float y = 0.2126f * c[0] + 0.7152f * c[1] +
+                                0.0722f * c[2];
+                const float s = 1.0f / (y + 1.0f);
+                for (int i = 0; i < 3; ++i) {
+                    c[i] *= s;
+                }
+            } else {
+                const float* k = rational_.k;
+                for (int i = 0; i < 3; ++i) {
+                    const float x2 = c[i] * c[i];
+                    const float nom = x2 * k[0] + k[1] * c[i] + k[2];
+                    const float denom = k[3] * x2 + k[4] * c[i] + k[5];
+                    c[i] = nom / denom;
+                }
+            }
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if (options_.output_color_space == ColorSpace::kSRGB) {
+                c[i] = LinearToSRGB(c[i]);
+            }
+            if (options_.unmultiply_alpha && c[3] > 0.0f) {
+                c[i] /= c[3];
+            }
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            out[i] = options_.clamp_output
+                   ? std::min(std::max(c[i], 0.0f), 1.0f) : c[i];
+        }
+    }
+
+    /**
+     * Tonemap 'width' x 'height' RGBA floats (row-major) to 'output', which
+     * has the same layout. T is float, Half, uint16_t or uint8_t.
+     */
+    template <typename T>
+    void Tonemap(int width, int height, const float* rgba, T* output) const {
+        static_assert(std::is_same<T, float>::value ||
+                      std::is_same<T, Half>::value ||
+                      std::is_same<T, uint16_t>::value ||
+                      std::is_same<T, uint8_t>::value,
+                      "Unsupported output type.");
+        CHECK(width >= 0 && height >= 0);
+        CHECK(rgba && output);
+
+#if defined(CL_TONEMAP_X86_DISPATCH)
+        const bool simd = tonemap_internal::HasAVX2();
+#endif
+
+        #pragma omp parallel for if (static_cast<int64_t>(width) * height > \
+                                     65536)
+        for (int y = 0; y < height; ++y) {
+            const int64_t offset = static_cast<int64_t>(y) * width * 4;
+            int x = 0;
+#if defined(CL_TONEMAP_X86_DISPATCH)
+            if (simd) {
+                x = TonemapRow(width, rgba + offset, output + offset);
+            }
+#endif
+            for (; x < width; ++x) {
+                float c[4];
+                TonemapPixel(rgba + offset + 4 * x, c);
+                tonemap_internal::StorePixel(c, output + offset + 4 * x);
+            }
+        }
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+#if defined(CL_TONEMAP_X86_DISPATCH)
+    /**
+     * Tonemap the pixels of a row in groups of eight, and return the number of
+     * processed pixels.
+     */
+    template <typename T>
+    CL_TONEMAP_TARGET int TonemapRow(int width, const float* rgba,
+                                     T* output) const {
+        using namespace tonemap_internal;
+
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 exposure = _mm256_set1_ps(exposure_scale_);
+        const __m256 bg_alpha = _mm256_set1_ps(background_[3]);
+        __m256 k[6];
+        for (int i = 0; i < 6; ++i) {
+            k[i] = _mm256_set1_ps(rational_.k[i]);
+        }
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            __m256 c[4];
+            Load(rgba + 4 * x, c);
+
+            const __m256 weight = _mm256_mul_ps(_mm256_sub_ps(one, c[3]),
+                                                bg_alpha);
+            for (int i = 0; i < 3; ++i) {
+                c[i] = _mm256_fmadd_ps(_mm256_set1_ps(background_[i]), weight,
+                                       c[i]);
+                if (options_.color_space == ColorSpace::kSRGB) {
+                    c[i] = SRGBToLinear(c[i]);
+                }
+                c[i] = _mm256_mul_ps(c[i], exposure);
+            }
+            c[3] = _mm256_add_ps(c[3], weight);
+
+            if (options_.curve != ToneCurve::kIdentity) {
+                for (int i = 0; i < 3; ++i) {
+                    c[i] = _mm256_max_ps(c[i], zero);
+                }
+                if (options_.curve == ToneCurve::kReinhard) {
+                    __m256 y = _mm256_mul_ps(c[0], _mm256_set1_ps(0.2126f));
+                    y = _mm256_fmadd_ps(c[1], _mm256_set1_ps(0.7152f), y);
+                    y = _mm256_fmadd_ps(c[2], _mm256_set1_ps(0.0722f), y);
+                    const __m256 s = _mm256_div_ps(one, _mm256_add_ps(y, one));
+                    for (int i = 0; i < 3; ++i) {
+                        c[i] = _mm256_mul_ps(c[i], s);
+                    }
+                } else {
+                    for (int i = 0; i < 3; ++i) {
+                        const __m256 x2 = _mm256_mul_ps(c[i], c[i]);
+                        const __m256 nom = _mm256_fmadd_ps(x2, k[0],
+                            _mm256_fmadd_ps(k[1], c[i], k[2]));
+                        const __m256 denom = _mm256_fmadd_ps(k[3], x2,
+                            _mm256_fmadd_ps(k[4], c[i], k[5]));
+                        c[i] = _mm256_div_ps(nom, denom);
+                    }
+                }
+            }
+
+            const __m256 positive_alpha = _mm256_cmp_ps(c[3], zero,
+                                                        _CMP_GT_OQ);
+            for (int i = 0; i < 3; ++i) {
+                if (options_.output_color_space == ColorSpace::kSRGB) {
+                    c[i] = LinearToSRGB(c[i]);
+                }
+                if (options_.unmultiply_alpha) {
+                    c[i] = _mm256_blendv_ps(c[i], _mm256_div_ps(c[i], c[3]),
+                                            positive_alpha);
+                }
+            }
+
+            if (options_.clamp_output) {
+                for (int i = 0; i < 4; ++i) {
+                    c[i] = _mm256_min_ps(_mm256_max_ps(c[i], zero), one);
+                }
+            }
+
+            Store(c, output + 4 * x);
+        }
+        return x;
+    }
+#endif // CL_TONEMAP_X86_DISPATCH
+
+    Options options_;
+
+    // 2^exposure.
+    float exposure_scale_ = 1.0f;
+
+    // Background in the color space of the input.
+    float background_[4];
+
+    tonemap_internal::RationalCurve rational_;
+};
+
+} // namespace image
+} // namespace cl
+
+#endif // CODELIBRARY_IMAGE_TONEMAPPER_H_
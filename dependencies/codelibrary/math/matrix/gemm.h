@@ -11,6 +11,10 @@
 
 #include <algorithm>
 #include <cstring>
+#include <type_traits>
+
+#include "codelibrary/base/log.h"
+#include "codelibrary/math/matrix/gemm_kernel.h"
 
 namespace cl {
 namespace blas {
@@ -20,6 +24,10 @@ namespace blas {
  *
  *   c = a * b
  *
+ * Small products use a simple row-streaming loop. Larger ones are computed by
+ * packing a and b into cache-sized panels and sweeping a register-tiled SIMD
+ * micro-kernel over them (see gemm_kernel.h), in parallel over row blocks.
+ *
  * Input:
  *  m - The number of rows of the matrix a.
  *  n - The number of columns of the matrix a.
@@ -36,54 +44,90 @@ void GEMM(int m, int n, int k, const T* a, const T* b, T* c) {
     static_assert(std::is_floating_point<T>::value, "");
     CHECK(c != a && c != b);
 
-    const int block_size = 128;
-    T sum;
-
     std::memset(c, 0, sizeof(T) * m * k);
-    if (m <= block_size && n <= block_size && k <= block_size) {
-        int p;
+    if (m == 0 || n == 0 || k == 0) return;
+
+    // Packing does not pay off for tiny products.
+    if (static_cast<double>(m) * n * k <= 32.0 * 32.0 * 32.0) {
         for (int i = 0; i < m; ++i) {
-            for (int j = 0; j < k; ++j) {
-                sum = T(0);
-                for (p = 0; p + 4 < n; p += 4) {
-                    sum += a[i * n + p]     * b[ p      * k + j];
-                    sum += a[i * n + p + 1] * b[(p + 1) * k + j];
-                    sum += a[i * n + p + 2] * b[(p + 2) * k + j];
-                    sum += a[i * n + p + 3] * b[(p + 3) * k + j];
+            T* ci = c + i * k;
+            for (int p = 0; p < n; ++p) {
+                const T aip = a[i * n + p];
+                const T* bp = b + p * k;
+                for (int j = 0; j < k; ++j) {
+                    ci[j] += aip * bp[j];
                 }
-                for (; p < n; ++p) {
-                    sum += a[i * n + p] * b[p * k + j];
-                }
-                c[i * k + j] += sum;
             }
         }
-    } else {
-        int i, j, p, block_m, block_n, block_k;
-        #pragma omp parallel for private(sum)
-        for (int ii = 0; ii < m; ii += block_size) {
-            for (int jj = 0; jj < k; jj += block_size) {
-                for (int pp = 0; pp < n; pp += block_size) {
-                    block_m = (ii + block_size <= m) ? block_size : (m - ii);
-                    block_n = (pp + block_size <= n) ? block_size : (n - pp);
-                    block_k = (jj + block_size <= k) ? block_size : (k - jj);
-                    for (i = ii; i < ii + block_m; ++i) {
-                        for (j = jj; j < jj + block_k; ++j) {
-                            sum = T(0);
-                            for (p = pp; p + 4 < pp + block_n; p += 4) {
-                                sum += a[i * n + p]     * b[ p      * k + j];
-                                sum += a[i * n + p + 1] * b[(p + 1) * k + j];
-                                sum += a[i * n + p + 2] * b[(p + 2) * k + j];
-                                sum += a[i * n + p + 3] * b[(p + 3) * k + j];
-                            }
-                            for (; p < pp + block_n; ++p) {
-                                sum += a[i * n + p] * b[p * k + j];
-                            }
-                            c[i * k + j] += sum;
-                        }
-                    }
+        return;
+    }
+
+    gemm_internal::DispatchGEMM(m, n, k, a, b, c);
+}
+
+/**
+ * Computes 'batch_size' independent small matrix-matrix products:
+ *
+ *   c[t] = a[t] * b[t]
+ *
+ * where a[t] is M x N, b[t] is N x K and c[t] is M x K, stored contiguously
+ * and row-major. The sizes are known at compile time, so each product is
+ * fully unrolled; this is the fast path for batches of 3x3 or 4x4 matrices.
+ */
+template <int M, int N, int K, typename T>
+void GEMMBatched(int batch_size, const T* a, const T* b, T* c) {
+    static_assert(std::is_floating_point<T>::value, "");
+    static_assert(M > 0 && N > 0 && K > 0, "");
+    CHECK(batch_size >= 0);
+
+    #pragma omp parallel for if (batch_size > 4096)
+    for (int t = 0; t < batch_size; ++t) {
+        const T* at = a + t * (M * N);
+        const T* bt = b + t * (N * K);
+        T* ct = c + t * (M * K);
+
+        T sum[M * K] = {};
+        for (int i = 0; i < M; ++i) {
+            for (int p = 0; p < N; ++p) {
+                for (int j = 0; j < K; ++j) {
+                    sum[i * K + j] += at[i * N + p] * bt[p * K + j];
                 }
             }
         }
+        std::memcpy(ct, sum, sizeof(sum));
+    }
+}
+
+/**
+ * Batched products with sizes known only at runtime. Common square sizes are
+ * forwarded to the unrolled version.
+ */
+template <typename T>
+void GEMMBatched(int batch_size, int m, int n, int k, const T* a, const T* b,
+                 T* c) {
+    static_assert(std::is_floating_point<T>::value, "");
+    CHECK(batch_size >= 0);
+
+    if (m == 3 && n == 3 && k == 3) {
+        GEMMBatched<3, 3, 3>(batch_size, a, b, c);
+        return;
+    }
+    if (m == 4 && n == 4 && k == 4) {
+        GEMMBatched<4, 4, 4>(batch_size, a, b, c);
+        return;
+    }
+    if (m == 3 && n == 3 && k == 1) {
+        GEMMBatched<3, 3, 1>(batch_size, a, b, c);
+        return;
+    }
+    if (m == 4 && n == 4 && k == 1) {
+        GEMMBatched<4, 4, 1>(batch_size, a, b, c);
+        return;
+    }
+
+    #pragma omp parallel for if (batch_size > 1024)
+    for (int t = 0; t < batch_size; ++t) {
+        GEMM(m, n, k, a + t * m * n, b + t * n * k, c + t * m * k);
     }
 }
 
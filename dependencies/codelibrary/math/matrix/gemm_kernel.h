@@ -0,0 +1,481 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+// Register-tiled micro-kernels and panel packing for GEMM, in the style of
+// GotoBLAS/BLIS.
+//
+// A micro-kernel computes an MR x NR block of C from a packed MR x kc panel of
+// A and a packed kc x NR panel of B:
+//
+//   C[0:MR, 0:NR] += A_panel * B_panel
+//
+// Kernels are provided for AVX2+FMA and AVX-512 (selected at runtime on x86
+// with GCC or Clang, or at compile time elsewhere), NEON on AArch64, and a
+// portable fallback.
+//
+
+#ifndef CODELIBRARY_MATH_MATRIX_GEMM_KERNEL_H_
+#define CODELIBRARY_MATH_MATRIX_GEMM_KERNEL_H_
+
+#include <algorithm>
+#include <cstring>
+
+#include "codelibrary/base/array.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CL_GEMM_X86_DISPATCH
+#include <immintrin.h>
+#define CL_GEMM_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(__AVX2__) || defined(__AVX512F__))
+#include <immintrin.h>
+#define CL_GEMM_TARGET(isa)
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define CL_GEMM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace cl {
+namespace blas {
+namespace gemm_internal {
+
+/**
+ * Instruction set used by the GEMM micro-kernels.
+ */
+enum class SIMDLevel {
+    kGeneric,
+    kNEON,
+    kAVX2,
+    kAVX512
+};
+
+/**
+ * Detect the best instruction set supported by the running CPU (once).
+ */
+inline SIMDLevel DetectSIMDLevel() {
+    static const SIMDLevel level = [] {
+#if defined(CL_GEMM_X86_DISPATCH)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SIMDLevel::kAVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return SIMDLevel::kAVX2;
+        }
+        return SIMDLevel::kGeneric;
+#elif defined(_MSC_VER) && defined(__AVX512F__)
+        return SIMDLevel::kAVX512;
+#elif defined(_MSC_VER) && defined(__AVX2__)
+        return SIMDLevel::kAVX2;
+#elif defined(CL_GEMM_NEON)
+        return SIMDLevel::kNEON;
+#else
+        return SIMDLevel::kGeneric;
+#endif
+    }();
+    return level;
+}
+
+/**
+ * Add the MR x NR tile 'tile' to C, only the top-left mr x nr part is written.
+ */
+template <typename T>
+void AddTile(int mr, int nr, int tile_ldc, const T* tile, T* c, int ldc) {
+    for (int i = 0; i < mr; ++i) {
+        for (int j = 0; j < nr; ++j) {
+            c[i * ldc + j] += tile[i * tile_ldc + j];
+        }
+    }
+}
+
+/**
+ * Portable micro-kernel. The fixed-size accumulator is usually vectorized by
+ * the compiler.
+ */
+template <typename T>
+struct GenericKernel {
+    static const int MR = 4;
+    static const int NR = 8;
+
+    static void Run(int kc, const T* a, const T* b, T* c, int ldc,
+                    int mr, int nr) {
+        T acc[MR][NR] = {};
+        for (int p = 0; p < kc; ++p) {
+            for (int i = 0; i < MR; ++i) {
+                const T ai = a[i];
+                for (int j = 0; j < NR; ++j) {
+                    acc[i][j] += ai * b[j];
+                }
+            }
+            a += MR;
+            b += NR;
+        }
+        AddTile(mr, nr, NR, &acc[0][0], c, ldc);
+    }
+};
+
+#if defined(CL_GEMM_TARGET)
+
+/**
+ * AVX2 + FMA micro-kernels: 6 x 2 vector registers of accumulators.
+ */
+template <typename T>
+struct AVX2Kernel;
+
+template <>
+struct AVX2Kernel<float> {
+    static const int MR = 6;
+    static const int NR = 16;
+
+    CL_GEMM_TARGET("avx2,fma")
+    static void Run(int kc, const float* a, const float* b, float* c, int ldc,
+                    int mr, int nr) {
+        __m256 acc[MR][2];
+        for (int i = 0; i < MR; ++i) {
+            acc[i][0] = _mm256_setzero_ps();
+            acc[i][1] = _mm256_setzero_ps();
+        }
+        for (int p = 0; p < kc; ++p) {
+            const __m256 b0 = _mm256_loadu_ps(b);
+            const __m256 b1 = _mm256_loadu_ps(b + 8);
+            for (int i = 0; i < MR; ++i) {
+                const __m256 ai = _mm256_broadcast_ss(a + i);
+                acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        if (mr == MR && nr == NR) {
+            for (int i = 0; i < MR; ++i) {
+                float* ci = c + i * ldc;
+                _mm256_storeu_ps(ci, _mm256_add_ps(_mm256_loadu_ps(ci),
+                                                   acc[i][0]));
+                _mm256_storeu_ps(ci + 8, _mm256_add_ps(_mm256_loadu_ps(ci + 8),
+                                                       acc[i][1]));
+            }
+        } else {
+            float tile[MR * NR];
+            for (int i = 0; i < MR; ++i) {
+                _mm256_storeu_ps(tile + i * NR, acc[i][0]);
+                _mm256_storeu_ps(tile + i * NR + 8, acc[i][1]);
+            }
+            AddTile(mr, nr, NR, tile, c, ldc);
+        }
+    }
+};
+
+template <>
+struct AVX2Kernel<double> {
+    static const int MR = 6;
+    static const int NR = 8;
+
+    CL_GEMM_TARGET("avx2,fma")
+    static void Run(int kc, const double* a, const double* b, double* c,
+                    int ldc, int mr, int nr) {
+        __m256d acc[MR][2];
+        for (int i = 0; i < MR; ++i) {
+            acc[i][0] = _mm256_setzero_pd();
+            acc[i][1] = _mm256_setzero_pd();
+        }
+        for (int p = 0; p < kc; ++p) {
+            const __m256d b0 = _mm256_loadu_pd(b);
+            const __m256d b1 = _mm256_loadu_pd(b + 4);
+            for (int i = 0; i < MR; ++i) {
+                const __m256d ai = _mm256_broadcast_sd(a + i);
+                acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        if (mr == MR && nr == NR) {
+            for (int i = 0; i < MR; ++i) {
+                double* ci = c + i * ldc;
+                _mm256_storeu_pd(ci, _mm256_add_pd(_mm256_loadu_pd(ci),
+                                                   acc[i][0]));
+                _mm256_storeu_pd(ci + 4, _mm256_add_pd(_mm256_loadu_pd(ci + 4),
+                                                       acc[i][1]));
+            }
+        } else {
+            double tile[MR * NR];
+            for (int i = 0; i < MR; ++i) {
+                _mm256_storeu_pd(tile + i * NR, acc[i][0]);
+                _mm256_storeu_pd(tile + i * NR + 4, acc[i][1]);
+            }
+            AddTile(mr, nr, NR, tile, c, ldc);
+        }
+    }
+};
+
+/**
+ * AVX-512 micro-kernels: 6 x 2 vector registers of accumulators.
+ */
+template <typename T>
+struct AVX512Kernel;
+
+template <>
+struct AVX512Kernel<float> {
+    static const int MR = 6;
+    static const int NR = 32;
+
+    CL_GEMM_TARGET("avx512f")
+    static void Run(int kc, const float* a, const float* b, float* c, int ldc,
+                    int mr, int nr) {
+        __m512 acc[MR][2];
+        for (int i = 0; i < MR; ++i) {
+            acc[i][0] = _mm512_setzero_ps();
+            acc[i][1] = _mm512_setzero_ps();
+        }
+        for (int p = 0; p < kc; ++p) {
+            const __m512 b0 = _mm512_loadu_ps(b);
+            const __m512 b1 = _mm512_loadu_ps(b + 16);
+            for (int i = 0; i < MR; ++i) {
+                const __m512 ai = _mm512_set1_ps(a[i]);
+                acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        if (mr == MR && nr == NR) {
+            for (int i = 0; i < MR; ++i) {
+                float* ci = c + i * ldc;
+                _mm512_storeu_ps(ci, _mm512_add_ps(_mm512_loadu_ps(ci),
+                                                   acc[i][0]));
+                _mm512_storeu_ps(ci + 16,
+                                 _mm512_add_ps(_mm512_loadu_ps(ci + 16),
+                                               acc[i][1]));
+            }
+        } else {
+            float tile[MR * NR];
+            for (int i = 0; i < MR; ++i) {
+                _mm512_storeu_ps(tile + i * NR, acc[i][0]);
+                _mm512_storeu_ps(tile + i * NR + 16, acc[i][1]);
+            }
+            AddTile(mr, nr, NR, tile, c, ldc);
+        }
+    }
+};
+
+template <>
+struct AVX512Kernel<double> {
+    static const int MR = 6;
+    static const int NR = 16;
+
+    CL_GEMM_TARGET("avx512f")
+    static void Run(int kc, const double* a, const double* b, double* c,
+                    int ldc, int mr, int nr) {
+        __m512d acc[MR][2];
+        for (int i = 0; i < MR; ++i) {
+            acc[i][0] = _mm512_setzero_pd();
+            acc[i][1] = _mm512_setzero_pd();
+        }
+        for (int p = 0; p < kc; ++p) {
+            const __m512d b0 = _mm512_loadu_pd(b);
+            const __m512d b1 = _mm512_loadu_pd(b + 8);
+            for (int i = 0; i < MR; ++i) {
+                const __m512d ai = _mm512_set1_pd(a[i]);
+                acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        if (mr == MR && nr == NR) {
+            for (int i = 0; i < MR; ++i) {
+                double* ci = c + i * ldc;
+                _mm512_storeu_pd(ci, _mm512_add_pd(_mm512_loadu_pd(ci),
+                                                   acc[i][0]));
+                _mm512_storeu_pd(ci + 8, _mm512_add_pd(_mm512_loadu_pd(ci + 8),
+                                                       acc[i][1]));
+            }
+        } else {
+            double tile[MR * NR];
+            for (int i = 0; i < MR; ++i) {
+                _mm512_storeu_pd(tile + i * NR, acc[i][0]);
+                _mm512_storeu_pd(tile + i * NR + 8, acc[i][1]);
+            }
+            AddTile(mr, nr, NR, tile, c, ldc);
+        }
+    }
+};
+
+#endif // CL_GEMM_TARGET
+
+#if defined(CL_GEMM_NEON)
+
+/**
+ * NEON micro-kernel (single precision): 6 x 2 vector registers.
+ */
+struct NEONKernel {
+    static const int MR = 6;
+    static const int NR = 8;
+
+    static void Run(int kc, const float* a, const float* b, float* c, int ldc,
+                    int mr, int nr) {
+        float32x4_t acc[MR][2];
+        for (int i = 0; i < MR; ++i) {
+            acc[i][0] = vdupq_n_f32(0.0f);
+            acc[i][1] = vdupq_n_f32(0.0f);
+        }
+        for (int p = 0; p < kc; ++p) {
+            const float32x4_t b0 = vld1q_f32(b);
+            const float32x4_t b1 = vld1q_f32(b + 4);
+            for (int i = 0; i < MR; ++i) {
+                acc[i][0] = vfmaq_n_f32(acc[i][0], b0, a[i]);
+                acc[i][1] = vfmaq_n_f32(acc[i][1], b1, a[i]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        float tile[MR * NR];
+        for (int i = 0; i < MR; ++i) {
+            vst1q_f32(tile + i * NR, acc[i][0]);
+            vst1q_f32(tile + i * NR + 4, acc[i][1]);
+        }
+        AddTile(mr, nr, NR, tile, c, ldc);
+    }
+};
+
+#endif // CL_GEMM_NEON
+
+/**
+ * Pack the mc x kc block of row-major A (leading dimension lda) into
+ * consecutive MR x kc panels. Each panel stores MR values per column, rows
+ * beyond mc are padded with zeros.
+ */
+template <int MR, typename T>
+void PackA(int mc, int kc, const T* a, int lda, T* packed) {
+    for (int i = 0; i < mc; i += MR) {
+        const int mr = std::min(MR, mc - i);
+        for (int p = 0; p < kc; ++p) {
+            int r = 0;
+            for (; r < mr; ++r) {
+                packed[r] = a[(i + r) * lda + p];
+            }
+            for (; r < MR; ++r) {
+                packed[r] = T(0);
+            }
+            packed += MR;
+        }
+    }
+}
+
+/**
+ * Pack the kc x nc block of row-major B (leading dimension ldb) into
+ * consecutive kc x NR panels. Each panel stores NR values per row, columns
+ * beyond nc are padded with zeros.
+ */
+template <int NR, typename T>
+void PackB(int kc, int nc, const T* b, int ldb, T* packed) {
+    for (int j = 0; j < nc; j += NR) {
+        const int nr = std::min(NR, nc - j);
+        for (int p = 0; p < kc; ++p) {
+            const T* row = b + p * ldb + j;
+            if (nr == NR) {
+                std::memcpy(packed, row, sizeof(T) * NR);
+            } else {
+                int r = 0;
+                for (; r < nr; ++r) {
+                    packed[r] = row[r];
+                }
+                for (; r < NR; ++r) {
+                    packed[r] = T(0);
+                }
+            }
+            packed += NR;
+        }
+    }
+}
+
+/**
+ * Blocked GEMM driver: c (m x k) += a (m x n) * b (n x k), all row-major.
+ *
+ * The loops follow the GotoBLAS scheme: a KC x NC block of B is packed once
+ * and shared by all threads, each thread packs its own MC x KC block of A and
+ * sweeps the micro-kernel over it.
+ */
+template <typename T, typename Kernel>
+void PackedGEMM(int m, int n, int k, const T* a, const T* b, T* c) {
+    const int MR = Kernel::MR;
+    const int NR = Kernel::NR;
+    const int MC = MR * 24;
+    const int KC = 256;
+    const int NC = NR * 128;
+
+    Array<T> packed_b(KC * NC);
+
+    for (int jc = 0; jc < k; jc += NC) {
+        const int nc = std::min(NC, k - jc);
+        for (int pc = 0; pc < n; pc += KC) {
+            const int kc = std::min(KC, n - pc);
+            PackB<NR>(kc, nc, b + pc * k + jc, k, packed_b.data());
+
+            const int n_blocks = (m + MC - 1) / MC;
+
+            #pragma omp parallel if (n_blocks > 1)
+            {
+                Array<T> packed_a(MC * KC);
+
+                #pragma omp for schedule(dynamic)
+                for (int block = 0; block < n_blocks; ++block) {
+                    const int ic = block * MC;
+                    const int mc = std::min(MC, m - ic);
+                    PackA<MR>(mc, kc, a + ic * n + pc, n, packed_a.data());
+
+                    for (int jr = 0; jr < nc; jr += NR) {
+                        const int nr = std::min(NR, nc - jr);
+                        const T* panel_b = packed_b.data() + jr * kc;
+                        for (int ir = 0; ir < mc; ir += MR) {
+                            const int mr = std::min(MR, mc - ir);
+                            Kernel::Run(kc, packed_a.data() + ir * kc, panel_b,
+                                        c + (ic + ir) * k + jc + jr, k, mr, nr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Dispatch the blocked GEMM to the best micro-kernel of the running CPU.
+ */
+template <typename T>
+void DispatchGEMM(int m, int n, int k, const T* a, const T* b, T* c) {
+    switch (DetectSIMDLevel()) {
+#if defined(CL_GEMM_TARGET)
+    case SIMDLevel::kAVX512:
+        PackedGEMM<T, AVX512Kernel<T>>(m, n, k, a, b, c);
+        return;
+    case SIMDLevel::kAVX2:
+        PackedGEMM<T, AVX2Kernel<T>>(m, n, k, a, b, c);
+        return;
+#endif
+    default:
+        PackedGEMM<T, GenericKernel<T>>(m, n, k, a, b, c);
+    }
+}
+
+#if defined(CL_GEMM_NEON)
+template <>
+inline void DispatchGEMM<float>(int m, int n, int k, const float* a,
+                                const float* b, float* c) {
+    PackedGEMM<float, NEONKernel>(m, n, k, a, b, c);
+}
+#endif
+
+} // namespace gemm_internal
+} // namespace blas
+} // namespace cl
+
+#endif // CODELIBRARY_MATH_MATRIX_GEMM_KERNEL_H_
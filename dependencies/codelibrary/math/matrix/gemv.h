@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <type_traits>
 
 namespace cl {
 namespace blas {
@@ -20,6 +21,10 @@ namespace blas {
  *
  *   c = Ab
  *
+ * Four rows are processed at once so that every load of b is shared, and each
+ * row keeps independent partial sums that the compiler can vectorize. Large
+ * matrices are split over threads by rows.
+ *
  * Input:
  *  m - The number of rows of the matrix a.
  *  n - The number of columns of the matrix a.
@@ -34,18 +39,44 @@ template <typename T>
 void GEMV(int m, int n, const T* a, const T* b, T* c) {
     static_assert(std::is_floating_point<T>::value, "");
 
-    std::memset(c, 0, sizeof(T) * m);
-    for (int i = 0; i < m; ++i) {
-        // Using cache size 4 to accelerate.
+    // Number of independent partial sums per row, wide enough for one SIMD
+    // register, so that the dot products vectorize without reassociation.
+    const int L = 8;
+    const int n_row_blocks = (m + 3) / 4;
+
+    #pragma omp parallel for if (static_cast<double>(m) * n > 1 << 18)
+    for (int block = 0; block < n_row_blocks; ++block) {
+        const int i = block * 4;
+        const int n_rows = std::min(4, m - i);
+
+        T acc[4][L] = {};
         int j = 0;
-        for (; j + 3 < n; j += 4) {
-            c[i] += a[i * n + j]     * b[j] +
-                    a[i * n + j + 1] * b[j + 1] +
-                    a[i * n + j + 2] * b[j + 2] +
-                    a[i * n + j + 3] * b[j + 3];
+        if (n_rows == 4) {
+            const T* a0 = a + i * n;
+            const T* a1 = a0 + n;
+            const T* a2 = a1 + n;
+            const T* a3 = a2 + n;
+            for (; j + L <= n; j += L) {
+                for (int l = 0; l < L; ++l) {
+                    const T bj = b[j + l];
+                    acc[0][l] += a0[j + l] * bj;
+                    acc[1][l] += a1[j + l] * bj;
+                    acc[2][l] += a2[j + l] * bj;
+                    acc[3][l] += a3[j + l] * bj;
+                }
+            }
         }
-        for (; j < n; ++j) {
-            c[i] += a[i * n + j] * b[j];
+
+        for (int r = 0; r < n_rows; ++r) {
+            const T* ar = a + (i + r) * n;
+            T sum = T(0);
+            for (int l = 0; l < L; ++l) {
+                sum += acc[r][l];
+            }
+            for (int p = j; p < n; ++p) {
+                sum += ar[p] * b[p];
+            }
+            c[i + r] = sum;
         }
     }
 }
@@ -55,6 +86,9 @@ void GEMV(int m, int n, const T* a, const T* b, T* c) {
  *
  *   c = A'b
  *
+ * Rows of a are accumulated into c four at a time, so c is streamed once per
+ * four rows. Large matrices are split over threads by column ranges.
+ *
  * Input:
  *  m - The number of rows of the matrix a.
  *  n - The number of columns of the matrix a.
@@ -67,20 +101,35 @@ void GEMV(int m, int n, const T* a, const T* b, T* c) {
  */
 template <typename T>
 void GEMVTrans(int m, int n, const T* a, const T* b, T* c) {
-    static_assert(std::is_floating_point<T>::value);
+    static_assert(std::is_floating_point<T>::value, "");
 
     std::memset(c, 0, sizeof(T) * n);
-    for (int i = 0; i < m; ++i) {
-        // Using cache size 4 to accelerate.
-        int j = 0;
-        for (; j + 3 < n; j += 4) {
-            c[j]     += a[i * n + j]     * b[i];
-            c[j + 1] += a[i * n + j + 1] * b[i];
-            c[j + 2] += a[i * n + j + 2] * b[i];
-            c[j + 3] += a[i * n + j + 3] * b[i];
+
+    // Each column range is a contiguous slice of c, owned by one thread.
+    const int column_block = 512;
+    const int n_column_blocks = (n + column_block - 1) / column_block;
+
+    #pragma omp parallel for if (static_cast<double>(m) * n > 1 << 18)
+    for (int block = 0; block < n_column_blocks; ++block) {
+        const int j0 = block * column_block;
+        const int j1 = std::min(n, j0 + column_block);
+        int i = 0;
+        for (; i + 3 < m; i += 4) {
+            const T* a0 = a + i * n;
+            const T* a1 = a0 + n;
+            const T* a2 = a1 + n;
+            const T* a3 = a2 + n;
+            const T b0 = b[i], b1 = b[i + 1], b2 = b[i + 2], b3 = b[i + 3];
+            for (int j = j0; j < j1; ++j) {
+                c[j] += a0[j] * b0 + a1[j] * b1 + a2[j] * b2 + a3[j] * b3;
+            }
         }
-        for (; j < n; ++j) {
-            c[j] += a[i * n + j] * b[i];
+        for (; i < m; ++i) {
+            const T* ai = a + i * n;
+            const T bi = b[i];
+            for (int j = j0; j < j1; ++j) {
+                c[j] += ai[j] * bi;
+            }
         }
     }
 }
@@ -149,12 +149,15 @@ public:
      */
     Matrix3 Transpose() const {
         Matrix3 t;
+        t.data_[0] = data_[0];
         t.data_[1] = data_[3];
         t.data_[2] = data_[6];
         t.data_[3] = data_[1];
+        t.data_[4] = data_[4];
         t.data_[5] = data_[7];
         t.data_[6] = data_[2];
         t.data_[7] = data_[5];
+        t.data_[8] = data_[8];
         return t;
     }
 
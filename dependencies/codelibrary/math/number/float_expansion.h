@@ -0,0 +1,276 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_MATH_NUMBER_FLOAT_EXPANSION_H_
+#define CODELIBRARY_MATH_NUMBER_FLOAT_EXPANSION_H_
+
+#include <cmath>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+
+/**
+ * FloatExpansion represents a number exactly as the unevaluated sum of
+ * nonoverlapping doubles, ordered by increasing magnitude (Shewchuk, 1997).
+ *
+ * It supports exact addition, subtraction and multiplication, and is much
+ * cheaper than ExactFloat when the operands have few significant bits, which
+ * is the common case in the last stage of the geometric predicates.
+ *
+ * It requires FP rounding set to FE_TONEAREST, and that no intermediate result
+ * overflows or underflows. The caller is responsible for checking the range of
+ * the inputs (see geometry::InExpansionRange()).
+ *
+ * Reference:
+ *   Shewchuk, J. R. (1997). Adaptive precision floating-point arithmetic and
+ *   fast robust geometric predicates. Discrete & Computational Geometry,
+ *   18(3), 305-363.
+ */
+class FloatExpansion {
+public:
+    FloatExpansion() = default;
+
+    explicit FloatExpansion(int32_t n)
+        : FloatExpansion(static_cast<double>(n)) {}
+
+    explicit FloatExpansion(float n)
+        : FloatExpansion(static_cast<double>(n)) {}
+
+    explicit FloatExpansion(double n) {
+        CHECK(std::isfinite(n));
+
+        if (n != 0.0) components_.push_back(n);
+    }
+
+    FloatExpansion(const FloatExpansion&) = default;
+
+    FloatExpansion(FloatExpansion&&) = default;
+
+    FloatExpansion& operator=(const FloatExpansion&) = default;
+
+    FloatExpansion& operator=(FloatExpansion&&) = default;
+
+    /**
+     * Return the nonzero components, from the smallest to the largest.
+     */
+    const Array<double>& components() const {
+        return components_;
+    }
+
+    /**
+     * Return the approximate value of this expansion.
+     */
+    double estimate() const {
+        double sum = 0.0;
+        for (double c : components_) {
+            sum += c;
+        }
+        return sum;
+    }
+
+    /**
+     * The sign is the sign of the largest component.
+     */
+    int sign() const {
+        if (components_.empty()) return 0;
+        return components_.back() > 0.0 ? 1 : -1;
+    }
+
+    FloatExpansion& operator +=(const FloatExpansion& a) {
+        Array<double> h;
+        Sum(components_, a.components_, false, &h);
+        components_.swap(h);
+        return *this;
+    }
+
+    FloatExpansion& operator -=(const FloatExpansion& a) {
+        Array<double> h;
+        Sum(components_, a.components_, true, &h);
+        components_.swap(h);
+        return *this;
+    }
+
+    FloatExpansion& operator *=(const FloatExpansion& a) {
+        Array<double> h;
+        Multiply(components_, a.components_, &h);
+        components_.swap(h);
+        return *this;
+    }
+
+    friend FloatExpansion operator -(const FloatExpansion& a) {
+        FloatExpansion r = a;
+        for (double& c : r.components_) {
+            c = -c;
+        }
+        return r;
+    }
+
+    friend FloatExpansion operator +(const FloatExpansion& a,
+                                     const FloatExpansion& b) {
+        FloatExpansion r;
+        Sum(a.components_, b.components_, false, &r.components_);
+        return r;
+    }
+
+    friend FloatExpansion operator -(const FloatExpansion& a,
+                                     const FloatExpansion& b) {
+        FloatExpansion r;
+        Sum(a.components_, b.components_, true, &r.components_);
+        return r;
+    }
+
+    friend FloatExpansion operator *(const FloatExpansion& a,
+                                     const FloatExpansion& b) {
+        FloatExpansion r;
+        Multiply(a.components_, b.components_, &r.components_);
+        return r;
+    }
+
+private:
+    /**
+     * x + y = a + b exactly, where x = fl(a + b), requires |a| >= |b|.
+     */
+    static void FastTwoSum(double a, double b, double* x, double* y) {
+        *x = a + b;
+        *y = b - (*x - a);
+    }
+
+    /**
+     * x + y = a + b exactly, where x = fl(a + b).
+     */
+    static void TwoSum(double a, double b, double* x, double* y) {
+        *x = a + b;
+        const double b_virtual = *x - a;
+        const double a_virtual = *x - b_virtual;
+        *y = (a - a_virtual) + (b - b_virtual);
+    }
+
+    /**
+     * x + y = a * b exactly, where x = fl(a * b).
+     */
+    static void TwoProduct(double a, double b, double* x, double* y) {
+        *x = a * b;
+#if defined(FP_FAST_FMA)
+        *y = std::fma(a, b, -*x);
+#else
+        // Dekker's split into two 26-bit halves.
+        const double splitter = 134217729.0; // 2^27 + 1.
+        double c = splitter * a;
+        const double a_hi = c - (c - a);
+        const double a_lo = a - a_hi;
+        c = splitter * b;
+        const double b_hi = c - (c - b);
+        const double b_lo = b - b_hi;
+        const double err1 = *x - a_hi * b_hi;
+        const double err2 = err1 - a_lo * b_hi;
+        const double err3 = err2 - a_hi * b_lo;
+        *y = a_lo * b_lo - err3;
+#endif
+    }
+
+    /**
+     * h = e + f (or e - f if 'negate'), with zero elimination.
+     *
+     * It merges the components by magnitude, and then propagates the sum from
+     * the smallest component (FAST-EXPANSION-SUM-ZEROELIM).
+     */
+    static void Sum(const Array<double>& e, const Array<double>& f,
+                    bool negate, Array<double>* h) {
+        h->clear();
+        const double s = negate ? -1.0 : 1.0;
+        const int m = e.size(), n = f.size();
+        if (n == 0) {
+            h->insert(e.begin(), e.end());
+            return;
+        }
+        if (m == 0) {
+            h->resize(n);
+            for (int i = 0; i < n; ++i) {
+                (*h)[i] = s * f[i];
+            }
+            return;
+        }
+        h->reserve(m + n);
+
+        int i = 0, j = 0;
+        auto next = [&]() {
+            // Take the smaller component of e[i] and s * f[j].
+            if (j == n || (i < m && std::fabs(e[i]) < std::fabs(f[j]))) {
+                return e[i++];
+            }
+            return s * f[j++];
+        };
+
+        double q = next();
+        double x, y;
+        if (i + j < m + n) {
+            FastTwoSum(next(), q, &x, &y);
+            q = x;
+            if (y != 0.0) h->push_back(y);
+        }
+        while (i + j < m + n) {
+            TwoSum(q, next(), &x, &y);
+            q = x;
+            if (y != 0.0) h->push_back(y);
+        }
+        if (q != 0.0) h->push_back(q);
+    }
+
+    /**
+     * h = e * b, with zero elimination (SCALE-EXPANSION-ZEROELIM).
+     */
+    static void Scale(const Array<double>& e, double b, Array<double>* h) {
+        h->clear();
+        if (e.empty() || b == 0.0) return;
+        h->reserve(2 * e.size());
+
+        double q, y;
+        TwoProduct(e[0], b, &q, &y);
+        if (y != 0.0) h->push_back(y);
+        for (int i = 1; i < e.size(); ++i) {
+            double p1, p0, sum;
+            TwoProduct(e[i], b, &p1, &p0);
+            TwoSum(q, p0, &sum, &y);
+            if (y != 0.0) h->push_back(y);
+            FastTwoSum(p1, sum, &q, &y);
+            if (y != 0.0) h->push_back(y);
+        }
+        if (q != 0.0) h->push_back(q);
+    }
+
+    /**
+     * h = e * f, the sum of e scaled by each component of f.
+     */
+    static void Multiply(const Array<double>& e, const Array<double>& f,
+                         Array<double>* h) {
+        h->clear();
+        if (e.empty() || f.empty()) return;
+        if (e.size() < f.size()) {
+            Multiply(f, e, h);
+            return;
+        }
+
+        Scale(e, f[0], h);
+        Array<double> t, sum;
+        for (int i = 1; i < f.size(); ++i) {
+            Scale(e, f[i], &t);
+            Sum(*h, t, false, &sum);
+            h->swap(sum);
+        }
+    }
+
+    // The nonoverlapping components in increasing magnitude, without zeros.
+    Array<double> components_;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_MATH_NUMBER_FLOAT_EXPANSION_H_
@@ -0,0 +1,923 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_POINT_CLOUD_BLOCK_ALIGNER_H_
+#define CODELIBRARY_POINT_CLOUD_BLOCK_ALIGNER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/geometry/vector_3d.h"
+#include "codelibrary/math/matrix/matrix3.h"
+
+namespace cl {
+namespace point_cloud {
+
+namespace block_aligner_internal {
+
+template <typename T>
+Matrix3<T> Skew(const Vector3D<T>& v) {
+    return Matrix3<T>(0, -v.z, v.y,
+                      v.z, 0, -v.x,
+                      -v.y, v.x, 0);
+}
+
+/**
+ * The rotation of angle |w| around w (Rodrigues' formula).
+ */
+template <typename T>
+Matrix3<T> RotationExp(const Vector3D<T>& w) {
+    T theta2 = w.squared_norm();
+    T theta = std::sqrt(theta2);
+    T a, b;
+    if (theta < T(1e-6)) {
+        a = 1 - theta2 / 6;
+        b = T(0.5) - theta2 / 24;
+    } else {
+        a = std::sin(theta) / theta;
+        b = (1 - std::cos(theta)) / theta2;
+    }
+    Matrix3<T> k = Skew(w);
+    return Matrix3<T>::Identity() + k * a + (k * k) * b;
+}
+
+/**
+ * The inverse of RotationExp(), with the angle in [0, pi].
+ */
+template <typename T>
+Vector3D<T> RotationLog(const Matrix3<T>& r) {
+    T c = (r(0, 0) + r(1, 1) + r(2, 2) - 1) / 2;
+    c = std::min(std::max(c, T(-1)), T(1));
+
+    // v = 2 sin(theta) * axis.
+    Vector3D<T> v(r(2, 1) - r(1, 2), r(0, 2) - r(2, 0), r(1, 0) - r(0, 1));
+    T s = v.norm() / 2;
+    T theta = std::atan2(s, c);
+    if (s < T(1e-6) && c > 0) return v * T(0.5);
+    if (c > T(-0.9)) return v * (theta / (2 * s));
+
+    // Near pi, the axis is taken from the symmetric part:
+    //   (r + r^T) / 2 = c * I + (1 - c) * axis * axis^T.
+    int k = 0;
+    for (int i = 1; i < 3; ++i) {
+        if (r(i, i) > r(k, k)) k = i;
+    }
+    Vector3D<T> axis;
+    axis[k] = std::sqrt(std::max(T(0), (r(k, k) - c) / (1 - c)));
+    for (int i = 0; i < 3; ++i) {
+        if (i != k) axis[i] = (r(i, k) + r(k, i)) / (2 * (1 - c) * axis[k]);
+    }
+    axis *= 1 / axis.norm();
+    if (DotProduct(axis, v) < 0) axis = -axis;
+    return axis * theta;
+}
+
+/**
+ * Dense 7 x 7 block of the normal equations, in row-major order.
+ */
+template <typename T>
+struct Block7 {
+    T a[49] = {};
+};
+
+/**
+ * a = a - b * c^T.
+ */
+template <typename T>
+void SubtractABt(const T* b, const T* c, T* a) {
+    for (int i = 0; i < 7; ++i) {
+        for (int j = 0; j < 7; ++j) {
+            T sum = 0;
+            for (int k = 0; k < 7; ++k) {
+                sum += b[i * 7 + k] * c[j * 7 + k];
+            }
+            a[i * 7 + j] -= sum;
+        }
+    }
+}
+
+} // namespace block_aligner_internal
+
+/**
+ * Global alignment of the blocks of a large capture, e.g., the block NeRFs of
+ * a street-view capture, which refine the camera poses independently.
+ *
+ * Each block b gets a similarity transform
+ *
+ *   S_b(x) = s_b * R_b * x + t_b
+ *
+ * from its world frame to a common frame. The frames shared by several blocks
+ * tie them together: for every shared frame f of blocks a and b, with the
+ * refined camera-to-world poses (c_a, Q_a) and (c_b, Q_b), the camera centers
+ * S_a(c_a) and S_b(c_b) and the orientations R_a Q_a and R_b Q_b should agree.
+ *
+ * The transforms minimize the sum of the robust losses (Huber, then Cauchy)
+ * of the residuals whitened by the given sigmas, by Levenberg-Marquardt. The
+ * normal equations have one 7 x 7 block per block, and a nonzero off-diagonal
+ * block per pair of overlapping blocks. They are reordered by reverse
+ * Cuthill-McKee and solved by a block sparse Cholesky factorization in the
+ * envelope (skyline) of the matrix, which costs O(n) for the chains of blocks
+ * along a trajectory.
+ *
+ * The gauge is fixed by keeping the first block of each connected group of
+ * blocks at the identity. The other blocks start from the relative
+ * similarities of the overlapping blocks, chained from the fixed ones.
+ */
+template <typename T>
+class BlockAligner {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    using Point = Point3D<T>;
+    using Vector = Vector3D<T>;
+    using Matrix = Matrix3<T>;
+    using Block7 = block_aligner_internal::Block7<T>;
+
+public:
+    enum class Loss {
+        kHuber,
+        kCauchy
+    };
+
+    struct Options {
+        // Expected error of the camera centers, in world units.
+        T position_sigma = T(0.05);
+
+        // Expected error of the camera orientations, in radians.
+        T rotation_sigma = T(0.01);
+
+        // The robust loss of the whitened residuals.
+        Loss loss = Loss::kCauchy;
+
+        // Residuals larger than it (in sigmas) are down-weighted.
+        T loss_threshold = 3;
+
+        int max_iterations = 50;
+
+        // Stop if the cost decreases less than tolerance * cost.
+        T tolerance = T(1e-6);
+    };
+
+    /**
+     * The refined pose of a frame in the world frame of a block.
+     */
+    struct Observation {
+        int block = 0;
+        int frame = 0;
+        Point center;
+
+        // Camera-to-world rotation.
+        Matrix rotation = Matrix::Identity();
+    };
+
+    /**
+     * x -> scale * rotation * x + translation.
+     */
+    struct Similarity {
+        T scale = 1;
+        Matrix rotation = Matrix::Identity();
+        Vector translation;
+
+        Point operator()(const Point& p) const {
+            Vector v = rotation * Vector(p.x, p.y, p.z) * scale + translation;
+            return Point(v.x, v.y, v.z);
+        }
+
+        Similarity Inverse() const {
+            Similarity s;
+            s.scale = 1 / scale;
+            s.rotation = rotation.Transpose();
+            s.translation = s.rotation * translation * (-s.scale);
+            return s;
+        }
+    };
+
+    struct Summary {
+        int n_iterations = 0;
+
+        // Pairs of observations of the same frame in different blocks.
+        int n_constraints = 0;
+
+        // Constraints beyond the loss threshold after the alignment.
+        int n_outliers = 0;
+
+        // Root mean squared distances of the camera centers and the angles of
+        // the orientations of the constraints, before and after.
+        T initial_position_rmse = 0, final_position_rmse = 0;
+        T initial_rotation_rmse = 0, final_rotation_rmse = 0;
+    };
+
+    BlockAligner() = default;
+
+    explicit BlockAligner(const Options& options)
+        : options_(options) {
+        CHECK(options.position_sigma > 0);
+        CHECK(options.rotation_sigma > 0);
+        CHECK(options.loss_threshold > 0);
+        CHECK(options.max_iterations >= 0);
+    }
+
+    /**
+     * Compute the transforms of the n blocks. The blocks without shared frames
+     * keep the identity.
+     */
+    void Align(int n_blocks, const Array<Observation>& observations,
+               Array<Similarity>* transforms,
+               Summary* summary = nullptr) const {
+        CHECK(n_blocks >= 0);
+        CHECK(transforms);
+
+        transforms->clear();
+        transforms->resize(n_blocks);
+        Summary s;
+
+        // The blocks are solved about the centroids of their cameras, which
+        // decouples the scale and the rotation from the translation:
+        //   S_b(x) = s_b * R_b * (x - centroid_b) + t'_b.
+        Array<Vector> centroids(n_blocks);
+        Array<int> counts(n_blocks, 0);
+        for (const Observation& o : observations) {
+            CHECK(o.block >= 0 && o.block < n_blocks);
+            centroids[o.block] += o.center.ToVector();
+            ++counts[o.block];
+        }
+        for (int b = 0; b < n_blocks; ++b) {
+            if (counts[b] > 0) centroids[b] *= T(1) / counts[b];
+            (*transforms)[b].translation = centroids[b];
+        }
+
+        Array<Constraint> constraints;
+        MakeConstraints(observations, centroids, &constraints);
+        s.n_constraints = constraints.size();
+
+        Problem problem;
+        FixGauge(n_blocks, constraints, &problem.fixed);
+        Array<int> order;
+        Envelope(n_blocks, constraints, &order, &problem.first,
+                 &problem.offsets);
+        problem.position.resize(n_blocks);
+        for (int i = 0; i < n_blocks; ++i) {
+            problem.position[order[i]] = i;
+        }
+
+        Errors(constraints, *transforms, &s.initial_position_rmse,
+               &s.initial_rotation_rmse);
+        Initialize(constraints, problem.fixed, transforms);
+
+        // Huber is convex in the residuals and tolerates a rough start. The
+        // redescending Cauchy loss then rejects the outliers, which still pull
+        // the Huber solution with a bounded force.
+        s.n_iterations = Optimize(constraints, problem, Loss::kHuber,
+                                  transforms);
+        if (options_.loss == Loss::kCauchy) {
+            s.n_iterations += Optimize(constraints, problem, Loss::kCauchy,
+                                       transforms);
+        }
+
+        Array<T> errors;
+        Cost(constraints, *transforms, options_.loss, &errors);
+        Errors(constraints, *transforms, &s.final_position_rmse,
+               &s.final_rotation_rmse);
+        for (T e : errors) {
+            if (e > options_.loss_threshold) ++s.n_outliers;
+        }
+        for (int b = 0; b < n_blocks; ++b) {
+            Similarity& t = (*transforms)[b];
+            t.translation -= t.rotation * centroids[b] * t.scale;
+        }
+        if (summary) *summary = s;
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+    struct Constraint {
+        int a, b;
+        Vector ca, cb;
+        Matrix qa, qb;
+    };
+
+    /**
+     * The structure of the normal equations.
+     */
+    struct Problem {
+        // The first block of each connected group.
+        Array<bool> fixed;
+
+        // The position of each block in the reverse Cuthill-McKee order.
+        Array<int> position;
+
+        // Row i (in the new order) stores the blocks of the columns
+        // [first[i], i] at offsets[i].
+        Array<int> first, offsets;
+    };
+
+    /**
+     * Levenberg-Marquardt with the given loss. Return the number of
+     * iterations.
+     */
+    int Optimize(const Array<Constraint>& constraints, const Problem& problem,
+                 Loss loss, Array<Similarity>* transforms) const {
+        const int n_blocks = transforms->size();
+
+        Array<T> errors;
+        T cost = Cost(constraints, *transforms, loss, &errors);
+
+        Array<Block7> h(problem.offsets.back());
+        Array<T> g(7 * n_blocks), step(7 * n_blocks);
+        Array<Similarity> candidate(n_blocks);
+
+        // The damping is updated from the ratio of the actual and the
+        // predicted decrease of the cost (Nielsen).
+        T lambda = T(1e-6), nu = 2;
+        int iteration = 0;
+        while (iteration < options_.max_iterations) {
+            ++iteration;
+            Linearize(constraints, *transforms, errors, loss, problem, &h, &g);
+
+            bool improved = false;
+            T new_cost = cost;
+            for (int attempt = 0; attempt < 10; ++attempt) {
+                if (!Solve(h, g, problem, lambda, &step)) {
+                    lambda *= nu;
+                    nu *= 2;
+                    continue;
+                }
+                for (int b = 0; b < n_blocks; ++b) {
+                    const T* x = step.data() + 7 * problem.position[b];
+                    candidate[b] = Update((*transforms)[b], x);
+                }
+                new_cost = Cost(constraints, candidate, loss, nullptr);
+
+                // (H + lambda * D) * step = -g, so the decrease of the
+                // quadratic model is -g^T * step + lambda * step^T * D * step.
+                T predicted = 0;
+                for (int i = 0; i < n_blocks; ++i) {
+                    const T* d = h[problem.offsets[i + 1] - 1].a;
+                    const T* x = step.data() + 7 * i;
+                    for (int k = 0; k < 7; ++k) {
+                        predicted += x[k] * (lambda * d[k * 8] * x[k] -
+                                             g[7 * i + k]);
+                    }
+                }
+
+                if (new_cost < cost && predicted > 0) {
+                    T rho = (cost - new_cost) / predicted;
+                    T r = 2 * rho - 1;
+                    lambda *= std::max(T(1) / 3, 1 - r * r * r);
+                    lambda = std::max(lambda, T(1e-15));
+                    nu = 2;
+                    improved = true;
+                    break;
+                }
+                lambda *= nu;
+                nu *= 2;
+            }
+            if (!improved) break;
+
+            transforms->swap(candidate);
+            T decrease = cost - new_cost;
+            cost = Cost(constraints, *transforms, loss, &errors);
+            if (decrease <= options_.tolerance * new_cost) break;
+        }
+        return iteration;
+    }
+
+    /**
+     * Pair the observations of each frame by different blocks, with the camera
+     * centers relative to the centroids of the blocks.
+     */
+    static void MakeConstraints(const Array<Observation>& observations,
+                                const Array<Vector>& centroids,
+                                Array<Constraint>* constraints) {
+        Array<int> seq(observations.size());
+        std::iota(seq.begin(), seq.end(), 0);
+        std::stable_sort(seq.begin(), seq.end(), [&](int i, int j) {
+            return observations[i].frame < observations[j].frame;
+        });
+
+        constraints->clear();
+        for (int i = 0, j = 0; i < seq.size(); i = j) {
+            int frame = observations[seq[i]].frame;
+            for (j = i; j < seq.size() &&
+                        observations[seq[j]].frame == frame; ++j) {}
+            for (int k = i; k < j; ++k) {
+                for (int l = k + 1; l < j; ++l) {
+                    const Observation* o1 = &observations[seq[k]];
+                    const Observation* o2 = &observations[seq[l]];
+                    if (o1->block == o2->block) continue;
+                    if (o1->block > o2->block) std::swap(o1, o2);
+
+                    Constraint c;
+                    c.a = o1->block;
+                    c.b = o2->block;
+                    c.ca = o1->center.ToVector() - centroids[c.a];
+                    c.cb = o2->center.ToVector() - centroids[c.b];
+                    c.qa = o1->rotation;
+                    c.qb = o2->rotation;
+                    constraints->push_back(c);
+                }
+            }
+        }
+    }
+
+    /**
+     * Initialize the transforms by chaining the relative similarities of the
+     * overlapping blocks along breadth-first trees from the fixed blocks.
+     *
+     * Starting from the identity, Gauss-Newton would have to unroll the drift
+     * of a long chain of blocks along its weak bending modes, which takes
+     * many iterations.
+     */
+    static void Initialize(const Array<Constraint>& constraints,
+                           const Array<bool>& fixed,
+                           Array<Similarity>* transforms) {
+        using block_aligner_internal::RotationExp;
+        using block_aligner_internal::RotationLog;
+
+        struct Edge {
+            int block;
+
+            // Maps the frame of 'block' to the frame of the other block.
+            Similarity transform;
+        };
+
+        const int n_blocks = transforms->size();
+        Array<int> seq(constraints.size());
+        std::iota(seq.begin(), seq.end(), 0);
+        std::stable_sort(seq.begin(), seq.end(), [&](int i, int j) {
+            return constraints[i].a < constraints[j].a ||
+                   (constraints[i].a == constraints[j].a &&
+                    constraints[i].b < constraints[j].b);
+        });
+
+        // The relative similarity of each pair of overlapping blocks: the mean
+        // relative rotation, the ratio of the spreads of the shared cameras,
+        // and the translation between their centroids.
+        Array<Array<Edge>> edges(n_blocks);
+        for (int i = 0, j = 0; i < seq.size(); i = j) {
+            const Constraint& c0 = constraints[seq[i]];
+            for (j = i; j < seq.size() && constraints[seq[j]].a == c0.a &&
+                        constraints[seq[j]].b == c0.b; ++j) {}
+            const int n = j - i;
+
+            Matrix r0 = c0.qa * c0.qb.Transpose();
+            Vector w, ma, mb;
+            for (int k = i; k < j; ++k) {
+                const Constraint& c = constraints[seq[k]];
+                w += RotationLog(r0.Transpose() * c.qa * c.qb.Transpose());
+                ma += c.ca;
+                mb += c.cb;
+            }
+            w *= T(1) / n;
+            ma *= T(1) / n;
+            mb *= T(1) / n;
+
+            T sa = 0, sb = 0;
+            for (int k = i; k < j; ++k) {
+                const Constraint& c = constraints[seq[k]];
+                sa += (c.ca - ma).squared_norm();
+                sb += (c.cb - mb).squared_norm();
+            }
+
+            Similarity t;
+            t.scale = sa > 0 && sb > 0 ? std::sqrt(sa / sb) : T(1);
+            t.rotation = r0 * RotationExp(w);
+            t.translation = ma - t.rotation * mb * t.scale;
+            edges[c0.a].push_back({ c0.b, t });
+            edges[c0.b].push_back({ c0.a, t.Inverse() });
+        }
+
+        Array<bool> visited(n_blocks, false);
+        Array<int> queue;
+        for (int root = 0; root < n_blocks; ++root) {
+            if (!fixed[root]) continue;
+            int head = queue.size();
+            queue.push_back(root);
+            visited[root] = true;
+            while (head < queue.size()) {
+                int u = queue[head++];
+                for (const Edge& e : edges[u]) {
+                    if (visited[e.block]) continue;
+                    visited[e.block] = true;
+                    (*transforms)[e.block] = Compose((*transforms)[u],
+                                                     e.transform);
+                    queue.push_back(e.block);
+                }
+            }
+        }
+    }
+
+    /**
+     * Return a * b.
+     */
+    static Similarity Compose(const Similarity& a, const Similarity& b) {
+        Similarity s;
+        s.scale = a.scale * b.scale;
+        s.rotation = a.rotation * b.rotation;
+        s.translation = a.rotation * b.translation * a.scale + a.translation;
+        return s;
+    }
+
+    /**
+     * Fix the first block of each connected group, by union-find.
+     */
+    static void FixGauge(int n_blocks, const Array<Constraint>& constraints,
+                         Array<bool>* fixed) {
+        Array<int> parent(n_blocks);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int x) {
+            while (parent[x] != x) {
+                parent[x] = parent[parent[x]];
+                x = parent[x];
+            }
+            return x;
+        };
+        for (const Constraint& c : constraints) {
+            int a = find(c.a), b = find(c.b);
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);
+        }
+
+        fixed->assign(n_blocks, false);
+        for (int b = 0; b < n_blocks; ++b) {
+            if (find(b) == b) (*fixed)[b] = true;
+        }
+    }
+
+    /**
+     * Order the blocks by reverse Cuthill-McKee, and compute the envelope:
+     * row i (in the new order) stores the blocks of the columns
+     * [first[i], i] at offsets[i].
+     */
+    static void Envelope(int n_blocks, const Array<Constraint>& constraints,
+                         Array<int>* order, Array<int>* first,
+                         Array<int>* offsets) {
+        Array<Array<int>> neighbors(n_blocks);
+        for (const Constraint& c : constraints) {
+            neighbors[c.a].push_back(c.b);
+            neighbors[c.b].push_back(c.a);
+        }
+        for (Array<int>& list : neighbors) {
+            std::sort(list.begin(), list.end());
+            list.resize(static_cast<int>(std::unique(list.begin(), list.end()) -
+                                         list.begin()));
+        }
+
+        Array<int> seq(n_blocks);
+        std::iota(seq.begin(), seq.end(), 0);
+        std::stable_sort(seq.begin(), seq.end(), [&](int i, int j) {
+            return neighbors[i].size() < neighbors[j].size();
+        });
+
+        // Breadth-first search from the unvisited block of lowest degree,
+        // visiting the neighbors by increasing degree.
+        order->clear();
+        Array<bool> visited(n_blocks, false);
+        Array<int> next;
+        for (int start : seq) {
+            if (visited[start]) continue;
+            int head = order->size();
+            order->push_back(start);
+            visited[start] = true;
+            while (head < order->size()) {
+                int u = (*order)[head++];
+                next.clear();
+                for (int v : neighbors[u]) {
+                    if (!visited[v]) {
+                        visited[v] = true;
+                        next.push_back(v);
+                    }
+                }
+                std::stable_sort(next.begin(), next.end(), [&](int i, int j) {
+                    return neighbors[i].size() < neighbors[j].size();
+                });
+                order->insert(next.begin(), next.end());
+            }
+        }
+        std::reverse(order->begin(), order->end());
+
+        Array<int> position(n_blocks);
+        for (int i = 0; i < n_blocks; ++i) {
+            position[(*order)[i]] = i;
+        }
+        first->resize(n_blocks);
+        offsets->resize(n_blocks + 1);
+        (*offsets)[0] = 0;
+        for (int i = 0; i < n_blocks; ++i) {
+            int f = i;
+            for (int v : neighbors[(*order)[i]]) {
+                f = std::min(f, position[v]);
+            }
+            (*first)[i] = f;
+            (*offsets)[i + 1] = (*offsets)[i] + i - f + 1;
+        }
+    }
+
+    /**
+     * Residuals of a constraint, unwhitened: the difference of the camera
+     * centers and the rotation between the orientations.
+     */
+    static void Residual(const Constraint& c, const Similarity& sa,
+                         const Similarity& sb, Vector* ua, Vector* ub,
+                         Matrix* e, Vector* rp, Vector* rr) {
+        *ua = sa.rotation * c.ca * sa.scale;
+        *ub = sb.rotation * c.cb * sb.scale;
+        *rp = (*ua + sa.translation) - (*ub + sb.translation);
+        *e = (sa.rotation * c.qa) * (sb.rotation * c.qb).Transpose();
+        *rr = block_aligner_internal::RotationLog(*e);
+    }
+
+    /**
+     * Return the whitened norm of the residuals of a constraint.
+     */
+    T WhitenedError(const Vector& rp, const Vector& rr) const {
+        T p = 1 / options_.position_sigma, r = 1 / options_.rotation_sigma;
+        return std::sqrt(rp.squared_norm() * p * p +
+                         rr.squared_norm() * r * r);
+    }
+
+    /**
+     * Return the total loss, and the whitened errors.
+     */
+    T Cost(const Array<Constraint>& constraints,
+           const Array<Similarity>& transforms, Loss loss,
+           Array<T>* errors) const {
+        const T k = options_.loss_threshold;
+        if (errors) errors->resize(constraints.size());
+        T cost = 0;
+        Vector ua, ub, rp, rr;
+        Matrix e;
+        for (int i = 0; i < constraints.size(); ++i) {
+            const Constraint& c = constraints[i];
+            Residual(c, transforms[c.a], transforms[c.b], &ua, &ub, &e, &rp,
+                     &rr);
+            T error = WhitenedError(rp, rr);
+            if (loss == Loss::kHuber) {
+                cost += error <= k ? error * error : 2 * k * error - k * k;
+            } else {
+                cost += k * k * std::log1p(error * error / (k * k));
+            }
+            if (errors) (*errors)[i] = error;
+        }
+        return cost;
+    }
+
+    /**
+     * Return the IRLS weight of a whitened error, i.e., rho'(e^2).
+     */
+    T Weight(T error, Loss loss) const {
+        const T k = options_.loss_threshold;
+        if (loss == Loss::kHuber) return error <= k ? T(1) : k / error;
+        return 1 / (1 + error * error / (k * k));
+    }
+
+    static void Errors(const Array<Constraint>& constraints,
+                       const Array<Similarity>& transforms,
+                       T* position_rmse, T* rotation_rmse) {
+        T p = 0, r = 0;
+        Vector ua, ub, rp, rr;
+        Matrix e;
+        for (const Constraint& c : constraints) {
+            Residual(c, transforms[c.a], transforms[c.b], &ua, &ub, &e, &rp,
+                     &rr);
+            p += rp.squared_norm();
+            r += rr.squared_norm();
+        }
+        int n = std::max(1, constraints.size());
+        *position_rmse = std::sqrt(p / n);
+        *rotation_rmse = std::sqrt(r / n);
+    }
+
+    /**
+     * Build the Gauss-Newton normal equations H * x = -g in the envelope,
+     * with the weights of the current errors (IRLS).
+     *
+     * The parameters of a block are (log scale, rotation, translation), with
+     * the updates s * exp(ds), exp([dw]) * R and t + dt.
+     */
+    void Linearize(const Array<Constraint>& constraints,
+                   const Array<Similarity>& transforms, const Array<T>& errors,
+                   Loss loss, const Problem& problem, Array<Block7>* h,
+                   Array<T>* g) const {
+        using block_aligner_internal::Skew;
+
+        const Array<bool>& fixed = problem.fixed;
+        const Array<int>& position = problem.position;
+        const Array<int>& first = problem.first;
+        const Array<int>& offsets = problem.offsets;
+
+        std::fill(h->begin(), h->end(), Block7());
+        std::fill(g->begin(), g->end(), T(0));
+
+        const T wp = 1 / options_.position_sigma;
+        const T wr = 1 / options_.rotation_sigma;
+        Vector ua, ub, rp, rr;
+        Matrix e;
+        for (int i = 0; i < constraints.size(); ++i) {
+            const Constraint& c = constraints[i];
+            Residual(c, transforms[c.a], transforms[c.b], &ua, &ub, &e, &rp,
+                     &rr);
+            T w = Weight(errors[i], loss);
+
+            // Whitened 6 x 7 Jacobians and the 6 residuals.
+            T ja[42] = {}, jb[42] = {}, r[6];
+            Matrix sa = Skew(ua), sb = Skew(ub);
+            for (int row = 0; row < 3; ++row) {
+                ja[row * 7] = ua[row] * wp;
+                jb[row * 7] = -ub[row] * wp;
+                for (int col = 0; col < 3; ++col) {
+                    ja[row * 7 + 1 + col] = -sa(row, col) * wp;
+                    jb[row * 7 + 1 + col] = sb(row, col) * wp;
+                    ja[(row + 3) * 7 + 1 + col] = (row == col) * wr;
+                    jb[(row + 3) * 7 + 1 + col] = -e(row, col) * wr;
+                }
+                ja[row * 7 + 4 + row] = wp;
+                jb[row * 7 + 4 + row] = -wp;
+                r[row] = rp[row] * wp;
+                r[row + 3] = rr[row] * wr;
+            }
+
+            const int blocks[2] = { c.a, c.b };
+            const T* jacobians[2] = { ja, jb };
+            for (int m = 0; m < 2; ++m) {
+                int bm = blocks[m];
+                if (fixed[bm]) continue;
+                int pm = position[bm];
+                T* gm = g->data() + 7 * pm;
+                for (int x = 0; x < 7; ++x) {
+                    T sum = 0;
+                    for (int y = 0; y < 6; ++y) {
+                        sum += jacobians[m][y * 7 + x] * r[y];
+                    }
+                    gm[x] += w * sum;
+                }
+
+                for (int l = 0; l < 2; ++l) {
+                    int bl = blocks[l];
+                    int pl = position[bl];
+                    if (fixed[bl] || pl > pm) continue;
+
+                    // Block (pm, pl) of the lower triangle.
+                    T* a = (*h)[offsets[pm] + pl - first[pm]].a;
+                    for (int x = 0; x < 7; ++x) {
+                        for (int y = 0; y < 7; ++y) {
+                            T sum = 0;
+                            for (int z = 0; z < 6; ++z) {
+                                sum += jacobians[m][z * 7 + x] *
+                                       jacobians[l][z * 7 + y];
+                            }
+                            a[x * 7 + y] += w * sum;
+                        }
+                    }
+                }
+            }
+        }
+
+        // The fixed blocks solve to a zero step.
+        for (int b = 0; b < fixed.size(); ++b) {
+            if (!fixed[b]) continue;
+            T* a = (*h)[offsets[position[b] + 1] - 1].a;
+            for (int x = 0; x < 7; ++x) {
+                a[x * 8] = 1;
+            }
+        }
+    }
+
+    /**
+     * Solve (H + lambda * diag(H)) * step = -g by the block Cholesky
+     * factorization in the envelope. Return false if it is not positive
+     * definite.
+     */
+    static bool Solve(const Array<Block7>& h, const Array<T>& g,
+                      const Problem& problem, T lambda, Array<T>* step) {
+        using block_aligner_internal::SubtractABt;
+
+        const Array<int>& first = problem.first;
+        const Array<int>& offsets = problem.offsets;
+
+        const int n = first.size();
+        Array<Block7> l = h;
+        for (int i = 0; i < n; ++i) {
+            T* d = l[offsets[i + 1] - 1].a;
+            for (int x = 0; x < 7; ++x) {
+                d[x * 8] += lambda * d[x * 8] + T(1e-12);
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            for (int j = first[i]; j <= i; ++j) {
+                T* a = l[offsets[i] + j - first[i]].a;
+                for (int k = std::max(first[i], first[j]); k < j; ++k) {
+                    SubtractABt(l[offsets[i] + k - first[i]].a,
+                                l[offsets[j] + k - first[j]].a, a);
+                }
+                if (j < i) {
+                    // L_ij = A_ij * L_jj^-T.
+                    const T* d = l[offsets[j + 1] - 1].a;
+                    for (int x = 0; x < 7; ++x) {
+                        for (int y = 0; y < 7; ++y) {
+                            T sum = a[x * 7 + y];
+                            for (int z = 0; z < y; ++z) {
+                                sum -= a[x * 7 + z] * d[y * 7 + z];
+                            }
+                            a[x * 7 + y] = sum / d[y * 8];
+                        }
+                    }
+                } else {
+                    // Dense Cholesky of the diagonal block.
+                    for (int x = 0; x < 7; ++x) {
+                        for (int y = 0; y <= x; ++y) {
+                            T sum = a[x * 7 + y];
+                            for (int z = 0; z < y; ++z) {
+                                sum -= a[x * 7 + z] * a[y * 7 + z];
+                            }
+                            if (x == y) {
+                                if (!(sum > 0)) return false;
+                                a[x * 8] = std::sqrt(sum);
+                            } else {
+                                a[x * 7 + y] = sum / a[y * 8];
+                            }
+                        }
+                        for (int y = x + 1; y < 7; ++y) {
+                            a[x * 7 + y] = 0;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Forward substitution L * y = -g.
+        Array<T>& x = *step;
+        for (int i = 0; i < 7 * n; ++i) {
+            x[i] = -g[i];
+        }
+        for (int i = 0; i < n; ++i) {
+            T* xi = x.data() + 7 * i;
+            for (int j = first[i]; j < i; ++j) {
+                const T* a = l[offsets[i] + j - first[i]].a;
+                const T* xj = x.data() + 7 * j;
+                for (int r = 0; r < 7; ++r) {
+                    for (int c = 0; c < 7; ++c) {
+                        xi[r] -= a[r * 7 + c] * xj[c];
+                    }
+                }
+            }
+            const T* d = l[offsets[i + 1] - 1].a;
+            for (int r = 0; r < 7; ++r) {
+                for (int c = 0; c < r; ++c) {
+                    xi[r] -= d[r * 7 + c] * xi[c];
+                }
+                xi[r] /= d[r * 8];
+            }
+        }
+
+        // Backward substitution L^T * x = y.
+        for (int i = n - 1; i >= 0; --i) {
+            T* xi = x.data() + 7 * i;
+            const T* d = l[offsets[i + 1] - 1].a;
+            for (int r = 6; r >= 0; --r) {
+                for (int c = r + 1; c < 7; ++c) {
+                    xi[r] -= d[c * 7 + r] * xi[c];
+                }
+                xi[r] /= d[r * 8];
+            }
+            for (int j = first[i]; j < i; ++j) {
+                const T* a = l[offsets[i] + j - first[i]].a;
+                T* xj = x.data() + 7 * j;
+                for (int r = 0; r < 7; ++r) {
+                    for (int c = 0; c < 7; ++c) {
+                        xj[c] -= a[r * 7 + c] * xi[r];
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    static Similarity Update(const Similarity& s, const T* step) {
+        Similarity r;
+        r.scale = s.scale * std::exp(step[0]);
+        r.rotation = block_aligner_internal::RotationExp(
+                    Vector(step[1], step[2], step[3])) * s.rotation;
+        r.translation = s.translation + Vector(step[4], step[5], step[6]);
+        return r;
+    }
+
+    Options options_;
+};
+
+} // namespace point_cloud
+} // namespace cl
+
+#endif // CODELIBRARY_POINT_CLOUD_BLOCK_ALIGNER_H_
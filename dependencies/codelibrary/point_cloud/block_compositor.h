@@ -0,0 +1,438 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_POINT_CLOUD_BLOCK_COMPOSITOR_H_
+#define CODELIBRARY_POINT_CLOUD_BLOCK_COMPOSITOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/box_3d.h"
+#include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/util/tree/aabb_tree.h"
+
+namespace cl {
+namespace point_cloud {
+
+/**
+ * Plan the blocks that are rendered and composited at each frame of a camera
+ * moving through a scene split into blocks (e.g., the block NeRFs of a
+ * street), so that the camera passes from one block to the next without a
+ * visible pop.
+ *
+ * The candidates of a frame are the visible blocks whose scene box contains
+ * the camera. A candidate has the inverse-distance weight
+ *
+ *   w = visibility / max(d, min_distance) ^ power,
+ *
+ * where d is the distance from the camera to the center of the camera box of
+ * the block (its origin). The blocks of the previous frame get a bonus of
+ * (1 + hysteresis) when the candidates are ranked, so that a block enters the
+ * set only when it is clearly better than the one it replaces. The best
+ * 'max_blocks' candidates are kept, their weights are normalized, and the
+ * ones lighter than 'min_weight' are dropped.
+ *
+ * The composited weights then move towards these targets by at most
+ * 'max_step' per frame: a leaving block fades out before its slot is given to
+ * a new block, which fades in. Only when every slot is held by a leaving
+ * block is the lightest one evicted at once, e.g., with a single slot or
+ * after the camera jumps. If the camera is in no candidate, the blocks
+ * of the previous frame are kept (or the block with the nearest origin at the
+ * first frame).
+ *
+ * Finally, the render budget of the frame, in full-resolution frames, is
+ * split between the blocks by their weights, and each block gets at least
+ * 'min_budget' and at most one frame.
+ *
+ * The planner only depends on the sequence of camera positions, so a replay
+ * gives the same frames.
+ */
+template <typename T>
+class BlockCompositor {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    using Point = Point3D<T>;
+    using Box = Box3D<T>;
+
+public:
+    struct Options {
+        // Maximum number of blocks composited in a frame.
+        int max_blocks = 2;
+
+        // Exponent of the inverse distance weights.
+        double power = 4.0;
+
+        // Lower bound of the distance to the block origins.
+        double min_distance = 1e-3;
+
+        // Blocks less visible than it are never rendered.
+        double min_visibility = 0.05;
+
+        // Normalized weight below which a block is not worth rendering.
+        double min_weight = 0.05;
+
+        // Relative bonus of the blocks that are already composited.
+        double hysteresis = 0.2;
+
+        // Maximum change of a weight per frame.
+        double max_step = 0.1;
+
+        // Render budget per frame, in full-resolution frames.
+        double budget = 1.5;
+
+        // Minimum budget of a rendered block, in full-resolution frames.
+        double min_budget = 0.25;
+    };
+
+    struct Block {
+        Block() = default;
+
+        Block(const Box& camera_box, const Box& scene_box,
+              double visibility = 1.0)
+            : camera_box(camera_box),
+              scene_box(scene_box),
+              visibility(visibility) {}
+
+        // Bounding box of the training cameras.
+        Box camera_box;
+
+        // Bounding box of the scene that the block can render.
+        Box scene_box;
+
+        // Visibility estimate in [0, 1], e.g., the occupancy of the density
+        // grid of the block.
+        double visibility = 1.0;
+    };
+
+    /**
+     * Plan of a frame. The blocks are sorted by decreasing weights, so the
+     * first one is the primary block.
+     */
+    struct Frame {
+        Array<int> blocks;
+
+        // Composition weights, summing to one.
+        Array<double> weights;
+
+        // Render budgets, in full-resolution frames.
+        Array<double> budgets;
+    };
+
+    BlockCompositor() = default;
+
+    explicit BlockCompositor(const Options& options)
+        : options_(options) {
+        CHECK(options.max_blocks > 0);
+        CHECK(options.power > 0.0);
+        CHECK(options.min_distance > 0.0);
+        CHECK(options.min_visibility >= 0.0);
+        CHECK(options.min_weight >= 0.0 && options.min_weight < 1.0);
+        CHECK(options.hysteresis >= 0.0);
+        CHECK(options.max_step > 0.0 && options.max_step <= 1.0);
+        CHECK(options.min_budget >= 0.0 && options.min_budget <= 1.0);
+        CHECK(options.min_budget * options.max_blocks <= options.budget);
+    }
+
+    /**
+     * Set the blocks, and forget the previous frames.
+     */
+    void Reset(const Array<Block>& blocks) {
+        blocks_ = blocks;
+        tree_.clear();
+        for (int i = 0; i < blocks_.size(); ++i) {
+            const Block& b = blocks_[i];
+            CHECK(!b.camera_box.empty() && !b.scene_box.empty());
+            CHECK(b.visibility >= 0.0 && b.visibility <= 1.0);
+            tree_.Insert(b.scene_box, i);
+        }
+        Restart();
+    }
+
+    /**
+     * Forget the previous frames, e.g., when the camera jumps.
+     */
+    void Restart() {
+        active_.clear();
+        active_weights_.clear();
+    }
+
+    /**
+     * Plan the frame of the given camera position.
+     */
+    void Plan(const Point& position, Frame* frame) {
+        CHECK(frame);
+
+        frame->blocks.clear();
+        frame->weights.clear();
+        frame->budgets.clear();
+        if (blocks_.empty()) return;
+
+        SelectTargets(position);
+        Step();
+
+        // Sort by decreasing weights, then by ids.
+        Array<int> order(active_.size());
+        for (int i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            if (active_weights_[a] != active_weights_[b]) {
+                return active_weights_[a] > active_weights_[b];
+            }
+            return active_[a] < active_[b];
+        });
+        for (int i : order) {
+            frame->blocks.push_back(active_[i]);
+            frame->weights.push_back(active_weights_[i]);
+        }
+        active_ = frame->blocks;
+        active_weights_ = frame->weights;
+
+        Allocate(frame->weights, &frame->budgets);
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+    const Array<Block>& blocks() const {
+        return blocks_;
+    }
+
+private:
+    /**
+     * Compute the target weights of the frame.
+     */
+    void SelectTargets(const Point& position) {
+        targets_.clear();
+        target_weights_.clear();
+
+        tree_.Query(Box(position.x, position.x, position.y, position.y,
+                        position.z, position.z), &candidates_);
+        std::sort(candidates_.begin(), candidates_.end());
+
+        scores_.clear();
+        raw_weights_.clear();
+        for (int c : candidates_) {
+            const Block& b = blocks_[c];
+            if (b.visibility < options_.min_visibility ||
+                b.visibility == 0.0) {
+                continue;
+            }
+
+            double d = std::max(DistanceToOrigin(position, b.camera_box),
+                                options_.min_distance);
+            double w = b.visibility / std::pow(d, options_.power);
+            double bonus = IsActive(c) ? 1.0 + options_.hysteresis : 1.0;
+            targets_.push_back(c);
+            raw_weights_.push_back(w);
+            scores_.push_back(w * bonus);
+        }
+
+        if (targets_.empty()) {
+            if (active_.empty()) {
+                // Start from the block with the nearest origin.
+                int nearest = 0;
+                double min_d = std::numeric_limits<double>::max();
+                for (int i = 0; i < blocks_.size(); ++i) {
+                    double d = DistanceToOrigin(position,
+                                                blocks_[i].camera_box);
+                    if (d < min_d) {
+                        min_d = d;
+                        nearest = i;
+                    }
+                }
+                targets_.push_back(nearest);
+                target_weights_.push_back(1.0);
+            } else {
+                targets_ = active_;
+                target_weights_ = active_weights_;
+            }
+            return;
+        }
+
+        // Keep the best candidates, ties broken by ids.
+        Array<int> order(targets_.size());
+        for (int i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return scores_[a] > scores_[b];
+        });
+        int n = std::min(options_.max_blocks, order.size());
+
+        double sum = 0.0;
+        for (int k = 0; k < n; ++k) {
+            sum += raw_weights_[order[k]];
+        }
+
+        // The best candidate is always kept.
+        Array<int> targets;
+        double kept = 0.0;
+        for (int k = 0; k < n; ++k) {
+            int i = order[k];
+            if (k > 0 && raw_weights_[i] < options_.min_weight * sum) {
+                continue;
+            }
+            targets.push_back(targets_[i]);
+            target_weights_.push_back(raw_weights_[i]);
+            kept += raw_weights_[i];
+        }
+        for (double& w : target_weights_) {
+            w /= kept;
+        }
+        targets_ = targets;
+    }
+
+    /**
+     * Move the composited weights towards the targets.
+     */
+    void Step() {
+        const double step = options_.max_step;
+
+        // The composited blocks keep their slots until they fade out. A
+        // leaving block (whose target is zero) is dropped at zero weight.
+        Array<int> blocks;
+        Array<double> weights;
+        Array<bool> leaving;
+        for (int i = 0; i < active_.size(); ++i) {
+            double w = active_weights_[i];
+            double target = TargetWeight(active_[i]);
+            w += std::max(-step, std::min(step, target - w));
+            if (w > 0.0) {
+                blocks.push_back(active_[i]);
+                weights.push_back(w);
+                leaving.push_back(target == 0.0);
+            }
+        }
+
+        // New blocks fade in from zero, in the order of the targets. If all
+        // slots are taken by leaving blocks, the lightest one is evicted, so
+        // that the target blocks enter even with a single slot.
+        for (int i = 0; i < targets_.size(); ++i) {
+            if (IsActive(targets_[i])) continue;
+            if (blocks.size() == options_.max_blocks) {
+                if (std::find(leaving.begin(), leaving.end(), false) !=
+                    leaving.end()) {
+                    break;
+                }
+                int lightest = 0;
+                for (int k = 1; k < blocks.size(); ++k) {
+                    if (weights[k] <= weights[lightest]) lightest = k;
+                }
+                blocks.erase(blocks.begin() + lightest);
+                weights.erase(weights.begin() + lightest);
+                leaving.erase(leaving.begin() + lightest);
+            }
+            blocks.push_back(targets_[i]);
+            weights.push_back(std::min(step, target_weights_[i]));
+            leaving.push_back(false);
+        }
+
+        // The leaving blocks keep their decayed weights, and the others
+        // share the rest. Scaling the leaving blocks back up would keep them
+        // from ever fading out.
+        double leaving_sum = 0.0, staying_sum = 0.0;
+        for (int i = 0; i < blocks.size(); ++i) {
+            (leaving[i] ? leaving_sum : staying_sum) += weights[i];
+        }
+        if (staying_sum > 0.0 && leaving_sum < 1.0) {
+            double scale = (1.0 - leaving_sum) / staying_sum;
+            for (int i = 0; i < blocks.size(); ++i) {
+                if (!leaving[i]) weights[i] *= scale;
+            }
+        } else {
+            double sum = leaving_sum + staying_sum;
+            for (double& w : weights) {
+                w /= sum;
+            }
+        }
+        active_ = blocks;
+        active_weights_ = weights;
+    }
+
+    /**
+     * Split the render budget between the blocks: each block gets
+     * 'min_budget', and the rest is shared in proportion to the weights,
+     * without giving a block more than one frame.
+     */
+    void Allocate(const Array<double>& weights, Array<double>* budgets) const {
+        int n = weights.size();
+        budgets->assign(n, std::min(1.0, options_.min_budget));
+        double rest = options_.budget - options_.min_budget * n;
+
+        Array<bool> full(n, false);
+        for (int iter = 0; iter < n && rest > 0.0; ++iter) {
+            double sum = 0.0;
+            for (int i = 0; i < n; ++i) {
+                if (!full[i]) sum += weights[i];
+            }
+            if (sum == 0.0) break;
+
+            double overflow = 0.0;
+            for (int i = 0; i < n; ++i) {
+                if (full[i]) continue;
+                double& b = (*budgets)[i];
+                b += rest * weights[i] / sum;
+                if (b >= 1.0) {
+                    overflow += b - 1.0;
+                    b = 1.0;
+                    full[i] = true;
+                }
+            }
+            rest = overflow;
+        }
+    }
+
+    /**
+     * Return the distance from the point to the center of the box.
+     */
+    static double DistanceToOrigin(const Point& p, const Box& box) {
+        double dx = p.x - 0.5 * (box.x_min() + box.x_max());
+        double dy = p.y - 0.5 * (box.y_min() + box.y_max());
+        double dz = p.z - 0.5 * (box.z_min() + box.z_max());
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    bool IsActive(int block) const {
+        return std::find(active_.begin(), active_.end(), block) !=
+               active_.end();
+    }
+
+    double TargetWeight(int block) const {
+        for (int i = 0; i < targets_.size(); ++i) {
+            if (targets_[i] == block) return target_weights_[i];
+        }
+        return 0.0;
+    }
+
+    Options options_;
+    Array<Block> blocks_;
+
+    // Index of the scene boxes.
+    AABBTree<T, int> tree_;
+
+    // Composited blocks of the last frame and their weights.
+    Array<int> active_;
+    Array<double> active_weights_;
+
+    // Buffers of SelectTargets().
+    Array<int> candidates_;
+    Array<int> targets_;
+    Array<double> target_weights_;
+    Array<double> raw_weights_;
+    Array<double> scores_;
+};
+
+} // namespace point_cloud
+} // namespace cl
+
+#endif // CODELIBRARY_POINT_CLOUD_BLOCK_COMPOSITOR_H_
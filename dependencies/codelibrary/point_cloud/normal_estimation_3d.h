@@ -0,0 +1,537 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_POINT_CLOUD_NORMAL_ESTIMATION_3D_H_
+#define CODELIBRARY_POINT_CLOUD_NORMAL_ESTIMATION_3D_H_
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/geometry/vector_3d.h"
+#include "codelibrary/graph/boruvka_min_spanning_tree.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/util/tree/kd_tree.h"
+
+namespace cl {
+namespace point_cloud {
+
+namespace normal_estimation_internal {
+
+/**
+ * Eigenvalues of the symmetric 3x3 matrix
+ *
+ *   [ a[0] a[1] a[2] ]
+ *   [ a[1] a[3] a[4] ]
+ *   [ a[2] a[4] a[5] ]
+ *
+ * in ascending order, by the trigonometric solution of the characteristic
+ * equation (Smith, 1961).
+ */
+inline void SymmetricEigenvalues(const double a[6], double w[3]) {
+    const double p1 = a[1] * a[1] + a[2] * a[2] + a[4] * a[4];
+    const double q = (a[0] + a[3] + a[5]) / 3.0;
+    if (p1 == 0.0) {
+        w[0] = a[0];
+        w[1] = a[3];
+        w[2] = a[5];
+        std::sort(w, w + 3);
+        return;
+    }
+
+    const double b00 = a[0] - q, b11 = a[3] - q, b22 = a[5] - q;
+    const double p2 = b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * p1;
+    const double p = std::sqrt(p2 / 6.0);
+
+    // r = det((A - qI) / p) / 2.
+    const double det = b00 * (b11 * b22 - a[4] * a[4]) -
+                       a[1] * (a[1] * b22 - a[4] * a[2]) +
+                       a[2] * (a[1] * a[4] - b11 * a[2]);
+    const double r = std::min(std::max(det / (2.0 * p * p * p), -1.0), 1.0);
+    const double phi = std::acos(r) / 3.0;
+
+    w[2] = q + 2.0 * p * std::cos(phi);
+    w[0] = q + 2.0 * p * std::cos(phi + 2.0 * M_PI / 3.0);
+    w[1] = 3.0 * q - w[0] - w[2];
+}
+
+/**
+ * Unit eigenvector of the symmetric matrix 'a' (see SymmetricEigenvalues())
+ * for its eigenvalue 'lambda'.
+ *
+ * It is the largest cross product of two rows of (A - lambda I). If lambda is
+ * a double eigenvalue, the rows are parallel and any vector orthogonal to them
+ * is returned.
+ */
+inline void SymmetricEigenvector(const double a[6], double lambda,
+                                 double v[3]) {
+    const double r[3][3] = { { a[0] - lambda, a[1], a[2] },
+                             { a[1], a[3] - lambda, a[4] },
+                             { a[2], a[4], a[5] - lambda } };
+
+    double best = 0.0, max_row = 0.0;
+    int row = 0;
+    for (int i = 0; i < 3; ++i) {
+        const double* u = r[i];
+        const double* w = r[(i + 1) % 3];
+        const double c[3] = { u[1] * w[2] - u[2] * w[1],
+                              u[2] * w[0] - u[0] * w[2],
+                              u[0] * w[1] - u[1] * w[0] };
+        const double d = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+        if (d > best) {
+            best = d;
+            v[0] = c[0];
+            v[1] = c[1];
+            v[2] = c[2];
+        }
+
+        const double n = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+        if (n > max_row) {
+            max_row = n;
+            row = i;
+        }
+    }
+
+    if (max_row == 0.0) {
+        // A = lambda I, every vector is an eigenvector.
+        v[0] = 0.0;
+        v[1] = 0.0;
+        v[2] = 1.0;
+        return;
+    }
+
+    if (best <= 1e-20 * max_row * max_row) {
+        // Rank one, take a vector orthogonal to the largest row.
+        const double* u = r[row];
+        const double ax = std::fabs(u[0]), ay = std::fabs(u[1]),
+                     az = std::fabs(u[2]);
+        if (ax <= ay && ax <= az) {
+            v[0] = 0.0;   v[1] = u[2]; v[2] = -u[1];
+        } else if (ay <= az) {
+            v[0] = -u[2]; v[1] = 0.0;  v[2] = u[0];
+        } else {
+            v[0] = u[1];  v[1] = -u[0]; v[2] = 0.0;
+        }
+        best = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    }
+
+    const double s = 1.0 / std::sqrt(best);
+    v[0] *= s;
+    v[1] *= s;
+    v[2] *= s;
+}
+
+/**
+ * Eigenvalues 'w' (ascending) and the least unit eigenvector 'v' of the
+ * symmetric matrix 'a' (see SymmetricEigenvalues()).
+ *
+ * The trigonometric solution loses half of the digits of the two eigenvalues
+ * that are close to each other (e.g., l0 and l1 of points on a line). So only
+ * the isolated eigenvalue and its eigenvector are taken from it, and the other
+ * two are solved as a 2x2 problem in the orthogonal complement (Eberly, 2014).
+ */
+inline void SymmetricEigensystem(const double a[6], double w[3], double v[3]) {
+    SymmetricEigenvalues(a, w);
+
+    // The isolated eigenvalue is the one farther from the middle.
+    const bool largest = w[2] - w[1] >= w[1] - w[0];
+    double e[3];
+    SymmetricEigenvector(a, largest ? w[2] : w[0], e);
+
+    // Orthonormal basis (u, t) of the complement of e.
+    double u[3];
+    if (std::fabs(e[0]) > std::fabs(e[1])) {
+        const double s = 1.0 / std::sqrt(e[0] * e[0] + e[2] * e[2]);
+        u[0] = -e[2] * s; u[1] = 0.0; u[2] = e[0] * s;
+    } else {
+        const double s = 1.0 / std::sqrt(e[1] * e[1] + e[2] * e[2]);
+        u[0] = 0.0; u[1] = e[2] * s; u[2] = -e[1] * s;
+    }
+    const double t[3] = { e[1] * u[2] - e[2] * u[1],
+                          e[2] * u[0] - e[0] * u[2],
+                          e[0] * u[1] - e[1] * u[0] };
+
+    auto multiply = [&](const double* x, double* y) {
+        y[0] = a[0] * x[0] + a[1] * x[1] + a[2] * x[2];
+        y[1] = a[1] * x[0] + a[3] * x[1] + a[4] * x[2];
+        y[2] = a[2] * x[0] + a[4] * x[1] + a[5] * x[2];
+    };
+    double au[3], at[3], ae[3];
+    multiply(u, au);
+    multiply(t, at);
+    multiply(e, ae);
+    const double m00 = u[0] * au[0] + u[1] * au[1] + u[2] * au[2];
+    const double m01 = u[0] * at[0] + u[1] * at[1] + u[2] * at[2];
+    const double m11 = t[0] * at[0] + t[1] * at[1] + t[2] * at[2];
+    const double lambda = e[0] * ae[0] + e[1] * ae[1] + e[2] * ae[2];
+
+    // Eigenvalues of [m00 m01; m01 m11] are mean -/+ h.
+    const double mean = 0.5 * (m00 + m11);
+    const double d = 0.5 * (m00 - m11);
+    const double h = std::sqrt(d * d + m01 * m01);
+    if (largest) {
+        w[0] = mean - h;
+        w[1] = mean + h;
+        w[2] = lambda;
+
+        // The eigenvector of (mean - h) is orthogonal to both rows of
+        // [d + h, m01; m01, h - d], use the row with the larger diagonal.
+        double c, s;
+        if (d <= 0.0) {
+            c = h - d;
+            s = -m01;
+        } else {
+            c = m01;
+            s = -d - h;
+        }
+        const double n = std::sqrt(c * c + s * s);
+        if (n == 0.0) {
+            c = 1.0;
+            s = 0.0;
+        } else {
+            c /= n;
+            s /= n;
+        }
+        for (int i = 0; i < 3; ++i) {
+            v[i] = c * u[i] + s * t[i];
+        }
+    } else {
+        w[0] = lambda;
+        w[1] = mean - h;
+        w[2] = mean + h;
+        v[0] = e[0];
+        v[1] = e[1];
+        v[2] = e[2];
+    }
+}
+
+/**
+ * Find the k nearest neighbors (including itself) of every point of the tree
+ * in parallel. The neighbors of point i are knn[i * k, i * k + k).
+ */
+template <typename T>
+void KNearestNeighbors(const KDTree<Point3D<T>>& kd_tree, int k,
+                       Array<int>* knn) {
+    const int n = kd_tree.size();
+    const Array<Point3D<T>>& points = kd_tree.points();
+    CHECK(n <= INT_MAX / k) << "Too many neighbors.";
+    knn->resize(n * k);
+
+    #pragma omp parallel if (n > 1000)
+    {
+        Array<int> neighbors;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for (int i = 0; i < n; ++i) {
+            kd_tree.FindKNearestNeighbors(points[i], k, &neighbors);
+            std::copy(neighbors.begin(), neighbors.end(),
+                      knn->begin() + i * k);
+        }
+    }
+}
+
+} // namespace normal_estimation_internal
+
+/**
+ * Multi-threaded PCA normal estimation over the k nearest neighbors.
+ *
+ * Unlike PCANormals() in pca_normals_3d.h, the covariance matrices are
+ * accumulated in double precision relative to the query point, and their least
+ * eigenvector is computed in closed form without any allocation. Every thread
+ * reuses its own neighbor buffer.
+ *
+ * The output normals have unit length and a random orientation, see
+ * MSTOrientNormals() and SensorOrientNormals().
+ *
+ * Parameters:
+ *   kd_tree     - the input points are stored in the KD tree.
+ *   k           - used to define the k-nearest neighbors.
+ *   normals     - the output normals.
+ *   curvatures  - (optional) the surface variation l0 / (l0 + l1 + l2) of
+ *                 each point, where l0 <= l1 <= l2 are the eigenvalues of the
+ *                 covariance matrix. It is 0 on a plane and 1/3 for isotropic
+ *                 neighborhoods.
+ *   confidences - (optional) the relative eigengap (l1 - l0) / l1 in [0, 1].
+ *                 It is close to 1 when the normal is well defined (e.g., a
+ *                 plane with little noise), and close to 0 on lines, corners
+ *                 and isotropic noise, where the least eigenvector is
+ *                 ambiguous.
+ */
+template <typename T>
+void ParallelPCANormals(const KDTree<Point3D<T>>& kd_tree, int k,
+                        Array<Vector3D<T>>* normals,
+                        Array<T>* curvatures = nullptr,
+                        Array<T>* confidences = nullptr) {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    CHECK(!kd_tree.empty());
+    CHECK(k > 0);
+    CHECK(normals);
+
+    const int n = kd_tree.size();
+    k = std::min(k, n);
+
+    normals->resize(n);
+    if (curvatures) curvatures->resize(n);
+    if (confidences) confidences->resize(n);
+
+    const Array<Point3D<T>>& points = kd_tree.points();
+
+    #pragma omp parallel if (n > 1000)
+    {
+        Array<int> neighbors;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for (int i = 0; i < n; ++i) {
+            kd_tree.FindKNearestNeighbors(points[i], k, &neighbors);
+
+            // Covariance about the centroid, shifted to the query point.
+            const Point3D<T>& o = points[i];
+            double sx = 0.0, sy = 0.0, sz = 0.0;
+            double sxx = 0.0, sxy = 0.0, sxz = 0.0;
+            double syy = 0.0, syz = 0.0, szz = 0.0;
+            for (int j : neighbors) {
+                const double x = static_cast<double>(points[j].x) - o.x;
+                const double y = static_cast<double>(points[j].y) - o.y;
+                const double z = static_cast<double>(points[j].z) - o.z;
+                sx += x;
+                sy += y;
+                sz += z;
+                sxx += x * x;
+                sxy += x * y;
+                sxz += x * z;
+                syy += y * y;
+                syz += y * z;
+                szz += z * z;
+            }
+            const double t = 1.0 / k;
+            sx *= t;
+            sy *= t;
+            sz *= t;
+            const double a[6] = { sxx * t - sx * sx, sxy * t - sx * sy,
+                                  sxz * t - sx * sz, syy * t - sy * sy,
+                                  syz * t - sy * sz, szz * t - sz * sz };
+
+            double w[3], v[3];
+            normal_estimation_internal::SymmetricEigensystem(a, w, v);
+            (*normals)[i] = Vector3D<T>(static_cast<T>(v[0]),
+                                        static_cast<T>(v[1]),
+                                        static_cast<T>(v[2]));
+
+            const double l0 = std::max(w[0], 0.0);
+            const double l1 = std::max(w[1], 0.0);
+            const double l2 = std::max(w[2], 0.0);
+            if (curvatures) {
+                const double sum = l0 + l1 + l2;
+                (*curvatures)[i] = sum > 0.0 ? static_cast<T>(l0 / sum) : 0;
+            }
+            if (confidences) {
+                // Eigenvalues below 1e-9 l2 are round-off, e.g., on lines.
+                const double d = l1 + 1e-9 * l2;
+                (*confidences)[i] = d > 0.0 ? static_cast<T>((l1 - l0) / d)
+                                            : 0;
+            }
+        }
+    }
+}
+
+/**
+ * Similar to the previous one.
+ */
+template <typename T>
+void ParallelPCANormals(const Array<Point3D<T>>& points, int k,
+                        Array<Vector3D<T>>* normals,
+                        Array<T>* curvatures = nullptr,
+                        Array<T>* confidences = nullptr) {
+    KDTree<Point3D<T>> kd_tree(points);
+    ParallelPCANormals(kd_tree, k, normals, curvatures, confidences);
+}
+
+/**
+ * Globally consistent normal orientation by propagation along the minimum
+ * spanning tree of the Riemannian graph (Hoppe et al., 1992).
+ *
+ * The Riemannian graph connects every point to its k nearest neighbors, and
+ * the edge (i, j) costs 1 - |n_i * n_j|, so the orientation is propagated
+ * across nearly parallel normals first. The spanning forest is computed by the
+ * parallel BoruvkaMinSpanningTree(). In each connected component, the normal
+ * of the highest point (largest z) is made to point upwards, and every other
+ * normal is flipped to agree with its parent in the tree.
+ *
+ * Parameters:
+ *   kd_tree - the input points are stored in the KD tree.
+ *   k       - the number of neighbors of each point in the Riemannian graph.
+ *   normals - the unit normals to orient.
+ */
+template <typename T>
+void MSTOrientNormals(const KDTree<Point3D<T>>& kd_tree, int k,
+                      Array<Vector3D<T>>* normals) {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    CHECK(!kd_tree.empty());
+    CHECK(k > 0);
+    CHECK(normals);
+    CHECK(normals->size() == kd_tree.size());
+
+    const int n = kd_tree.size();
+    k = std::min(k + 1, n);
+    const Array<Point3D<T>>& points = kd_tree.points();
+    Array<Vector3D<T>>& ns = *normals;
+
+    Array<int> knn;
+    normal_estimation_internal::KNearestNeighbors(kd_tree, k, &knn);
+
+    // Symmetrize the k-NN relation: keep (i, j) from the side of i if i < j,
+    // or if i is not a neighbor of j.
+    auto keep = [&](int i, int j) {
+        if (i == j) return false;
+        if (i < j) return true;
+        const int* b = knn.data() + j * k;
+        return std::find(b, b + k, i) == b + k;
+    };
+
+    Array<int> offsets(n + 1, 0);
+    #pragma omp parallel for if (n > 10000)
+    for (int i = 0; i < n; ++i) {
+        int count = 0;
+        for (int a = 0; a < k; ++a) {
+            if (keep(i, knn[i * k + a])) ++count;
+        }
+        offsets[i + 1] = count;
+    }
+    for (int i = 0; i < n; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    Array<std::pair<int, int>> edges(offsets[n]);
+    #pragma omp parallel for if (n > 10000)
+    for (int i = 0; i < n; ++i) {
+        int e = offsets[i];
+        for (int a = 0; a < k; ++a) {
+            const int j = knn[i * k + a];
+            if (keep(i, j)) edges[e++] = std::make_pair(i, j);
+        }
+    }
+    Array<int>().swap(knn);
+
+    const CSRGraph graph(n, edges);
+    Array<T> weights(graph.n_arcs());
+    #pragma omp parallel for if (edges.size() > 10000)
+    for (int e = 0; e < edges.size(); ++e) {
+        const int a = graph.edge_arc(e);
+        const Vector3D<T>& u = ns[edges[e].first];
+        const Vector3D<T>& v = ns[edges[e].second];
+        weights[a] = weights[graph.twin(a)] = 1 -
+                std::fabs(u.x * v.x + u.y * v.y + u.z * v.z);
+    }
+
+    Array<int> mst_arcs;
+    graph::BoruvkaMinSpanningTree(graph, weights, &mst_arcs);
+
+    Array<std::pair<int, int>> tree_edges(mst_arcs.size());
+    for (int i = 0; i < mst_arcs.size(); ++i) {
+        const int a = mst_arcs[i];
+        tree_edges[i] = std::make_pair(graph.target(graph.twin(a)),
+                                       graph.target(a));
+    }
+    const CSRGraph tree(n, tree_edges);
+
+    // Breadth first propagation in each tree of the forest. 'queue' holds the
+    // vertices of the current component from 'begin'.
+    Array<bool> visited(n, false);
+    Array<int> queue;
+    queue.reserve(n);
+    for (int s = 0; s < n; ++s) {
+        if (visited[s]) continue;
+
+        const int begin = queue.size();
+        int top = s;
+        visited[s] = true;
+        queue.push_back(s);
+        for (int head = begin; head < queue.size(); ++head) {
+            const int u = queue[head];
+            if (points[u].z > points[top].z) top = u;
+
+            tree.ForEachArc(u, [&](int, int v, int) {
+                if (visited[v]) return;
+
+                visited[v] = true;
+                if (DotProduct(ns[u], ns[v]) < 0) ns[v] = -ns[v];
+                queue.push_back(v);
+            });
+        }
+
+        if (ns[top].z < 0) {
+            for (int i = begin; i < queue.size(); ++i) {
+                ns[queue[i]] = -ns[queue[i]];
+            }
+        }
+    }
+}
+
+/**
+ * Similar to the previous one.
+ */
+template <typename T>
+void MSTOrientNormals(const Array<Point3D<T>>& points, int k,
+                      Array<Vector3D<T>>* normals) {
+    KDTree<Point3D<T>> kd_tree(points);
+    MSTOrientNormals(kd_tree, k, normals);
+}
+
+/**
+ * Orient each normal towards the position of the sensor that captured its
+ * point, e.g., the camera or the LiDAR origin of the scan.
+ *
+ * Parameters:
+ *   points  - the input points.
+ *   origins - the sensor position of each point.
+ *   normals - the normals to orient.
+ */
+template <typename T>
+void SensorOrientNormals(const Array<Point3D<T>>& points,
+                         const Array<Point3D<T>>& origins,
+                         Array<Vector3D<T>>* normals) {
+    CHECK(normals);
+    CHECK(points.size() == origins.size());
+    CHECK(points.size() == normals->size());
+
+    const int n = points.size();
+    #pragma omp parallel for if (n > 100000)
+    for (int i = 0; i < n; ++i) {
+        Vector3D<T>& normal = (*normals)[i];
+        if (DotProduct(normal, origins[i] - points[i]) < 0) normal = -normal;
+    }
+}
+
+/**
+ * Orient all normals towards a single viewpoint.
+ */
+template <typename T>
+void SensorOrientNormals(const Array<Point3D<T>>& points,
+                         const Point3D<T>& origin,
+                         Array<Vector3D<T>>* normals) {
+    CHECK(normals);
+    CHECK(points.size() == normals->size());
+
+    const int n = points.size();
+    #pragma omp parallel for if (n > 100000)
+    for (int i = 0; i < n; ++i) {
+        Vector3D<T>& normal = (*normals)[i];
+        if (DotProduct(normal, origin - points[i]) < 0) normal = -normal;
+    }
+}
+
+} // namespace point_cloud
+} // namespace cl
+
+#endif // CODELIBRARY_POINT_CLOUD_NORMAL_ESTIMATION_3D_H_
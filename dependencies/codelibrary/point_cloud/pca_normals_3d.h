@@ -26,66 +26,14 @@ namespace point_cloud {
 template <typename Point, typename T>
 void PCANormal(const Array<Point>& points, const Array<T>& weights,
                Vector3D<T>* normal) {
-  static_assert(std::is_floating_point<T>::value, "");
-
-  PrincipalComponentAnalysis3D<T> pca(points, weights);
-  *normal = pca.eigenvectors()[0];
-
-  CHECK(!points.empty());
-  CHECK(points.size() == weights.size());
-  CHECK(normal);
-
-  Point centroid = Center(points, weights);
-  T a = 0, b = 0, c = 0;
-  T sum = 0;
-  for (int i = 0; i < points.size(); ++i) {
-      T x = points[i].x - centroid.x;
-      T y = points[i].y - centroid.y;
-      T w = weights[i];
-
-      a += w * x * x;
-      b += w * x * y;
-      c += w * y * y;
-      sum += w;
-  }
-
-  if (sum == 0) {
-      *normal = Vector2D<T>(0, 1);
-      return;
-  }
-
-  T t = T(1) / sum;
-  a *= t;
-  b *= t;
-  c *= t;
-
-  // Compute the least eigenvector of the covariance matrix.
-  // [ A  B ]  =  [ cs  -sn ] [ rt1   0 ] [  cs  sn ]
-  // [ B  C ]     [ sn   cs ] [  0   rT ] [ -sn  cs ]
-  T df = a - c;
-  T rt = std::sqrt(df * df + b * b * T(4));
-  T cs = df > 0 ? df + rt : df - rt;
-  T sn = 0;
-  if (std::fabs(cs) > std::fabs(b) * T(2)) {
-      t = -b * T(2) / cs;
-      sn = T(1) / std::sqrt(t * t + T(1));
-      cs = t * sn;
-  } else if (std::fabs(b) == 0) {
-      cs = 1;
-      sn = 0;
-  } else {
-      t = - cs / b / 2;
-      cs = T(1) / std::sqrt(t * t + T(1));
-      sn = t * cs;
-  }
-
-  if (df > 0) {
-      t = cs;
-      cs = -sn;
-      sn = t;
-  }
-
-  *normal = Vector2D<T>(-sn, cs);
+    static_assert(std::is_floating_point<T>::value, "");
+
+    CHECK(!points.empty());
+    CHECK(points.size() == weights.size());
+    CHECK(normal);
+
+    PrincipalComponentAnalysis3D<T> pca(points, weights);
+    *normal = pca.eigenvectors()[0];
 }
 
 /**
@@ -209,24 +157,6 @@ void OrientationAwarePCANormals(const Point& points, int k,
 }
 
 
-/**
- * Estimate normal direction by weighted PCA method.
- *
- * The output normal is normalize to the unit length. Its orientation is
- * randomly assigned.
- *
- * Note that, we only need to compute the least eigenvector of the covariance
- * matrix.
- */
-template <typename Point, typename T>
-void PCANormal(const Array<Point3D<T>>& points, const Array<T>& weights,
-               Vector3D<T>* normal) {
-    static_assert(std::is_floating_point<T>::value, "");
-
-    PrincipalComponentAnalysis3D<T> pca(points, weights);
-    *normal = pca.eigenvectors()[0];
-}
-
 /**
  * Estimate normal vector by PCA method.
  *
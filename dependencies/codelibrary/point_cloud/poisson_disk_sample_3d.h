@@ -0,0 +1,276 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_H_
+#define CODELIBRARY_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/clamp.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/box_3d.h"
+#include "codelibrary/geometry/point_3d.h"
+
+namespace cl {
+namespace point_cloud {
+
+namespace poisson_disk_internal {
+
+/**
+ * SplitMix64 finalizer, used to derive the random priority of each point from
+ * the seed and its index.
+ */
+inline uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace poisson_disk_internal
+
+/**
+ * Poisson-disk decimation of a 3D point cloud with a radius for each point.
+ *
+ * It selects a subset of the input points such that any two samples p and q
+ * satisfy |p - q| >= max(r_p, r_q), and every removed point is closer than
+ * that to some sample (i.e., the subset is maximal).
+ *
+ * The points are bucketed into a hashed grid whose cell size is the largest
+ * radius, so a point can only conflict with the 3x3x3 cells around it. The
+ * cells are colored by (x % 3, y % 3, z % 3) into 27 phases. Cells of the same
+ * phase are at least 3 cells apart and never read each other's samples, so
+ * they are processed concurrently. In each cell, points are visited in a random
+ * order derived from 'seed'; the output only depends on the seed, not on the
+ * number of threads.
+ *
+ * Parameters:
+ *   points  - the input points.
+ *   radii   - the non-negative exclusion radius of each point.
+ *   seed    - the seed of the random visiting order.
+ *   samples - the indices of the selected points, in ascending order.
+ */
+template <typename T>
+void PoissonDiskSample3D(const Array<Point3D<T>>& points,
+                         const Array<T>& radii, uint64_t seed,
+                         Array<int>* samples) {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    CHECK(points.size() == radii.size());
+    CHECK(samples);
+
+    samples->clear();
+    const int n = points.size();
+    if (n == 0) return;
+
+    double r_max = 0.0;
+    for (T r : radii) {
+        CHECK(r >= 0);
+        r_max = std::max(r_max, static_cast<double>(r));
+    }
+    if (r_max == 0.0) {
+        samples->resize(n);
+        for (int i = 0; i < n; ++i) {
+            (*samples)[i] = i;
+        }
+        return;
+    }
+
+    const Box3D<T> box(points.begin(), points.end());
+    const double size = 1 << 21;
+    CHECK(box.x_length() / r_max < size - 1 &&
+          box.y_length() / r_max < size - 1 &&
+          box.z_length() / r_max < size - 1) << "The radius is too small.";
+
+    // Cell key of each point: 21 bits for each coordinate.
+    const double inv = 1.0 / r_max;
+    auto cell = [&](const Point3D<T>& p) {
+        const uint64_t x = static_cast<uint64_t>((p.x - box.x_min()) * inv);
+        const uint64_t y = static_cast<uint64_t>((p.y - box.y_min()) * inv);
+        const uint64_t z = static_cast<uint64_t>((p.z - box.z_min()) * inv);
+        return x | (y << 21) | (z << 42);
+    };
+
+    // Sort the points by (cell, priority).
+    struct Entry {
+        uint64_t key;
+        uint64_t priority;
+        int index;
+
+        bool operator <(const Entry& rhs) const {
+            return key < rhs.key || (key == rhs.key &&
+                                     priority < rhs.priority);
+        }
+    };
+    Array<Entry> entries(n);
+    const uint64_t hashed_seed = poisson_disk_internal::Mix(seed);
+    #pragma omp parallel for if (n > 100000)
+    for (int i = 0; i < n; ++i) {
+        entries[i].key = cell(points[i]);
+        entries[i].priority = poisson_disk_internal::Mix(
+                    hashed_seed ^ static_cast<uint64_t>(i));
+        entries[i].index = i;
+    }
+    std::sort(entries.begin(), entries.end());
+
+    Array<int> order(n);
+    Array<uint64_t> cell_keys;
+    Array<int> cell_begin;
+    for (int i = 0; i < n; ++i) {
+        order[i] = entries[i].index;
+        if (i == 0 || entries[i].key != entries[i - 1].key) {
+            cell_keys.push_back(entries[i].key);
+            cell_begin.push_back(i);
+        }
+    }
+    Array<Entry>().swap(entries);
+    const int n_cells = cell_keys.size();
+    cell_begin.push_back(n);
+
+    // The accepted samples of cell c are moved to the front of its range, that
+    // is, order[cell_begin[c], cell_begin[c] + n_accepted[c]).
+    Array<int> n_accepted(n_cells, 0);
+
+    Array<int> phases[27];
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    for (int c = 0; c < n_cells; ++c) {
+        const uint64_t key = cell_keys[c];
+        const int phase = (key & mask) % 3 + (key >> 21 & mask) % 3 * 3 +
+                          (key >> 42) % 3 * 9;
+        phases[phase].push_back(c);
+    }
+
+    for (const Array<int>& phase : phases) {
+        #pragma omp parallel for schedule(dynamic, 64) if (phase.size() > 64)
+        for (int t = 0; t < phase.size(); ++t) {
+            const int c = phase[t];
+            const uint64_t key = cell_keys[c];
+            const int64_t x = key & mask, y = key >> 21 & mask, z = key >> 42;
+
+            // The neighbor cells, the cell itself is the last one.
+            int neighbors[27];
+            int n_neighbors = 0;
+            for (int64_t dz = -1; dz <= 1; ++dz) {
+                for (int64_t dy = -1; dy <= 1; ++dy) {
+                    for (int64_t dx = -1; dx <= 1; ++dx) {
+                        if (dx == 0 && dy == 0 && dz == 0) continue;
+                        if (x + dx < 0 || y + dy < 0 || z + dz < 0) continue;
+                        const uint64_t k = uint64_t(x + dx) |
+                                           uint64_t(y + dy) << 21 |
+                                           uint64_t(z + dz) << 42;
+                        auto iter = std::lower_bound(cell_keys.begin(),
+                                                     cell_keys.end(), k);
+                        if (iter != cell_keys.end() && *iter == k) {
+                            const int d = iter - cell_keys.begin();
+                            if (n_accepted[d] > 0) {
+                                neighbors[n_neighbors++] = d;
+                            }
+                        }
+                    }
+                }
+            }
+            neighbors[n_neighbors++] = c;
+
+            int& accepted = n_accepted[c];
+            for (int i = cell_begin[c]; i < cell_begin[c + 1]; ++i) {
+                const int a = order[i];
+                const Point3D<T>& p = points[a];
+                const double ra = radii[a];
+
+                bool conflict = false;
+                for (int j = 0; j < n_neighbors && !conflict; ++j) {
+                    const int d = neighbors[j];
+                    const int end = cell_begin[d] + n_accepted[d];
+                    for (int l = cell_begin[d]; l < end; ++l) {
+                        const int b = order[l];
+                        const Point3D<T>& q = points[b];
+                        const double r = std::max(ra, double(radii[b]));
+                        const double dx = static_cast<double>(p.x) - q.x;
+                        const double dy = static_cast<double>(p.y) - q.y;
+                        const double dz = static_cast<double>(p.z) - q.z;
+                        if (dx * dx + dy * dy + dz * dz < r * r) {
+                            conflict = true;
+                            break;
+                        }
+                    }
+                }
+
+                if (!conflict) {
+                    order[i] = order[cell_begin[c] + accepted];
+                    order[cell_begin[c] + accepted] = a;
+                    ++accepted;
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < n_cells; ++c) {
+        samples->insert(order.begin() + cell_begin[c],
+                        order.begin() + cell_begin[c] + n_accepted[c]);
+    }
+    std::sort(samples->begin(), samples->end());
+}
+
+/**
+ * Uniform Poisson-disk decimation, no two samples are closer than 'radius'.
+ */
+template <typename T>
+void PoissonDiskSample3D(const Array<Point3D<T>>& points, double radius,
+                         uint64_t seed, Array<int>* samples) {
+    CHECK(radius >= 0.0);
+
+    PoissonDiskSample3D(points, Array<T>(points.size(), T(radius)), seed,
+                        samples);
+}
+
+/**
+ * Adaptive Poisson-disk decimation driven by a per-point importance in [0, 1].
+ *
+ * The radius of each point is linearly interpolated from 'max_radius' (for
+ * importance 0) to 'min_radius' (for importance 1), so the important regions
+ * (e.g., high curvature or close to the cameras) keep more points.
+ */
+template <typename T>
+void PoissonDiskSample3D(const Array<Point3D<T>>& points,
+                         const Array<T>& importance, double min_radius,
+                         double max_radius, uint64_t seed,
+                         Array<int>* samples) {
+    CHECK(points.size() == importance.size());
+    CHECK(0.0 <= min_radius && min_radius <= max_radius);
+
+    Array<T> radii(points.size());
+    for (int i = 0; i < points.size(); ++i) {
+        const double t = Clamp(static_cast<double>(importance[i]), 0.0, 1.0);
+        radii[i] = static_cast<T>(max_radius - (max_radius - min_radius) * t);
+    }
+    PoissonDiskSample3D(points, radii, seed, samples);
+}
+
+/**
+ * Similar to the previous one, but output the sample points.
+ */
+template <typename T>
+void PoissonDiskSample3D(const Array<Point3D<T>>& points, double radius,
+                         uint64_t seed, Array<Point3D<T>>* samples) {
+    CHECK(samples);
+
+    Array<int> indices;
+    PoissonDiskSample3D(points, radius, seed, &indices);
+    samples->resize(indices.size());
+    for (int i = 0; i < indices.size(); ++i) {
+        (*samples)[i] = points[indices[i]];
+    }
+}
+
+} // namespace point_cloud
+} // namespace cl
+
+#endif // CODELIBRARY_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_H_
@@ -33,7 +33,7 @@ void OctreeSample(const Array<Point>& points, int depth,
     using T = typename Point::value_type;
     geometry::VoxelOctree<T, uint64_t> octree;
     Box3D<T> box(points.begin(), points.end());
-    octree.Reset(box, depth);
+    octree.ResetBox(box, depth);
 
     for (int i = 0; i < points.size(); ++i) {
         const Point& p = points[i];
@@ -0,0 +1,245 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_POINT_CLOUD_TRAJECTORY_PARTITIONER_H_
+#define CODELIBRARY_POINT_CLOUD_TRAJECTORY_PARTITIONER_H_
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/box_3d.h"
+#include "codelibrary/geometry/distance_3d.h"
+#include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/util/tree/kd_tree.h"
+
+namespace cl {
+namespace point_cloud {
+
+/**
+ * Split a capture trajectory into overlapping blocks, e.g., to train one NeRF
+ * per block of a street-view capture.
+ *
+ * The input is the sequence of stations along the trajectory (one position
+ * per capture, e.g., the center of a camera rig) and the point cloud of the
+ * scene. Each point is assigned to its nearest station, and each station costs
+ *
+ *   1 + point_weight * (its number of points) / (mean number of points),
+ *
+ * so that the dense parts of the scene, which take longer to train, get
+ * shorter blocks.
+ *
+ * The trajectory is first cut where successive stations are farther apart
+ * than max_gap (different streets). Each piece of n stations is then split
+ * into ceil(n / target_size) consecutive cores of balanced cost. Every block
+ * consists of its core extended by 'overlap' stations into each neighbor of
+ * the same piece. Hence:
+ *  1) the cores partition the stations in order;
+ *  2) the 'overlap' stations on each side of a cut inside a piece (fewer at
+ *     the ends of the piece) belong to both blocks of the cut;
+ *  3) no block spans a gap.
+ *
+ * The box of a block bounds its stations and the points assigned to them; its
+ * center is its middle station.
+ */
+template <typename T>
+class TrajectoryPartitioner {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    using Point = Point3D<T>;
+
+public:
+    struct Options {
+        // Target number of stations per block core.
+        int target_size = 100;
+
+        // Number of stations that each block takes from each neighbor.
+        int overlap = 10;
+
+        // Weight of the point density against the number of stations.
+        double point_weight = 1.0;
+
+        // Points farther than it from every station are ignored.
+        double point_radius = DBL_MAX;
+
+        // Distance between successive stations where the trajectory is cut.
+        // Zero or negative means no cut.
+        double max_gap = 0.0;
+    };
+
+    struct Block {
+        // Stations of the block [first, last), including the overlap.
+        int first = 0, last = 0;
+
+        // Stations owned by the block [core_first, core_last).
+        int core_first = 0, core_last = 0;
+
+        // Bounding box of the stations and their points.
+        Box3D<T> box;
+
+        // The middle station.
+        Point center;
+
+        // Number of points assigned to the stations of the block.
+        int n_points = 0;
+
+        // Total cost of the core stations.
+        double cost = 0.0;
+    };
+
+    TrajectoryPartitioner() = default;
+
+    explicit TrajectoryPartitioner(const Options& options)
+        : options_(options) {
+        CHECK(options.target_size > 0);
+        CHECK(options.overlap >= 0);
+        CHECK(options.point_weight >= 0.0);
+        CHECK(options.point_radius >= 0.0);
+    }
+
+    /**
+     * Partition the stations into blocks, in trajectory order.
+     */
+    void Partition(const Array<Point>& stations, const Array<Point>& points,
+                   Array<Block>* blocks) const {
+        CHECK(blocks);
+
+        blocks->clear();
+        int n = stations.size();
+        if (n == 0) return;
+
+        // Assign the points to their nearest stations.
+        Array<int> owners;
+        AssignPoints(stations, points, &owners);
+
+        Array<int> counts(n, 0);
+        Array<Box3D<T>> station_boxes(n);
+        for (int i = 0; i < n; ++i) {
+            station_boxes[i] = Box3D<T>(&stations[i], &stations[i] + 1);
+        }
+        int n_assigned = 0;
+        for (int i = 0; i < points.size(); ++i) {
+            int s = owners[i];
+            if (s < 0) continue;
+            ++counts[s];
+            ++n_assigned;
+            station_boxes[s].Join(Box3D<T>(&points[i], &points[i] + 1));
+        }
+
+        // Prefix sums of the station costs.
+        double mean_count = static_cast<double>(n_assigned) / n;
+        Array<double> prefix(n + 1, 0.0);
+        for (int i = 0; i < n; ++i) {
+            double density = mean_count > 0.0 ? counts[i] / mean_count : 0.0;
+            prefix[i + 1] = prefix[i] + 1.0 + options_.point_weight * density;
+        }
+
+        // Cut the trajectory at the gaps, and split each piece.
+        int piece_first = 0;
+        for (int i = 1; i <= n; ++i) {
+            if (i == n || (options_.max_gap > 0.0 &&
+                Distance(stations[i - 1], stations[i]) > options_.max_gap)) {
+                SplitPiece(piece_first, i, prefix, blocks);
+                piece_first = i;
+            }
+        }
+
+        // Bounds and point counts.
+        Array<int> count_prefix(n + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            count_prefix[i + 1] = count_prefix[i] + counts[i];
+        }
+        for (Block& block : *blocks) {
+            block.box = Box3D<T>();
+            for (int i = block.first; i < block.last; ++i) {
+                block.box.Join(station_boxes[i]);
+            }
+            block.center = stations[block.first +
+                                    (block.last - block.first) / 2];
+            block.n_points = count_prefix[block.last] -
+                             count_prefix[block.first];
+        }
+    }
+
+    /**
+     * Return the index of the nearest station of each point, or -1 if it is
+     * farther than point_radius.
+     */
+    void AssignPoints(const Array<Point>& stations, const Array<Point>& points,
+                      Array<int>* owners) const {
+        CHECK(owners);
+
+        owners->resize(points.size());
+        if (stations.empty()) {
+            std::fill(owners->begin(), owners->end(), -1);
+            return;
+        }
+
+        KDTree<Point> kd_tree(stations);
+        double radius = options_.point_radius;
+
+        #pragma omp parallel for if (points.size() > 10000)
+        for (int i = 0; i < points.size(); ++i) {
+            int s = kd_tree.FindNearestIndex(points[i]);
+            (*owners)[i] = Distance(points[i], stations[s]) <= radius ? s : -1;
+        }
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+    /**
+     * Split the stations [first, last) into blocks of balanced cost.
+     */
+    void SplitPiece(int first, int last, const Array<double>& prefix,
+                    Array<Block>* blocks) const {
+        int n = last - first;
+        int n_blocks = (n + options_.target_size - 1) / options_.target_size;
+        double base = prefix[first];
+        double total = prefix[last] - base;
+
+        // Cut k is where the prefix cost is closest to k / n_blocks of the
+        // total, leaving at least one station to each core.
+        Array<int> cuts(n_blocks + 1);
+        cuts[0] = first;
+        cuts[n_blocks] = last;
+        for (int k = 1; k < n_blocks; ++k) {
+            double target = base + total * k / n_blocks;
+            int lo = cuts[k - 1] + 1, hi = last - (n_blocks - k);
+            int cut = static_cast<int>(
+                std::lower_bound(prefix.begin() + lo, prefix.begin() + hi + 1,
+                                 target) - prefix.begin());
+            cut = std::min(cut, hi);
+            if (cut > lo && target - prefix[cut - 1] < prefix[cut] - target) {
+                --cut;
+            }
+            cuts[k] = cut;
+        }
+
+        for (int k = 0; k < n_blocks; ++k) {
+            Block block;
+            block.core_first = cuts[k];
+            block.core_last = cuts[k + 1];
+            block.first = std::max(first, block.core_first - options_.overlap);
+            block.last = std::min(last, block.core_last + options_.overlap);
+            block.cost = prefix[block.core_last] - prefix[block.core_first];
+            blocks->push_back(block);
+        }
+    }
+
+    Options options_;
+};
+
+} // namespace point_cloud
+} // namespace cl
+
+#endif // CODELIBRARY_POINT_CLOUD_TRAJECTORY_PARTITIONER_H_
@@ -0,0 +1,376 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_POINT_CLOUD_VIEW_SELECTOR_H_
+#define CODELIBRARY_POINT_CLOUD_VIEW_SELECTOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/angle.h"
+#include "codelibrary/geometry/box_3d.h"
+#include "codelibrary/geometry/distance_3d.h"
+#include "codelibrary/geometry/frustum_3d.h"
+#include "codelibrary/geometry/point_3d.h"
+#include "codelibrary/geometry/util/frustum_culler_3d.h"
+#include "codelibrary/geometry/vector_3d.h"
+#include "codelibrary/util/tree/aabb_tree.h"
+
+namespace cl {
+namespace point_cloud {
+
+/**
+ * Select a subset of views (keyframes) that covers a point cloud, e.g., to
+ * drop the near-duplicate frames of a video capture before training a NeRF.
+ *
+ * The point cloud is voxelized, and a view sees the voxels that intersect its
+ * frustum (occlusions are ignored). Each voxel should be seen by
+ * 'views_per_voxel' selected views, or by all views that see it if fewer. The
+ * views are selected greedily by the gain
+ *
+ *   quality * novelty * sum of 1 / (1 + c) over its voxels that need more
+ *                       views, where c is the number of selected views of the
+ *                       voxel,
+ *
+ * where quality = (sharpness / mean sharpness) ^ sharpness_weight, and novelty
+ * is the pose distance to the nearest selected view, in units of
+ * novelty_distance (or novelty_angle), clamped to 1. Views less novel than
+ * min_novelty are never selected. If no view sees a voxel, only the novelty
+ * and quality are used.
+ *
+ * The gains only decrease as views are selected, so the selection is lazy: a
+ * stale gain is an upper bound, and only the top of the queue is updated.
+ *
+ * The selection stops when the budget is used, or when the selected views
+ * satisfy 'target_coverage' of the seen voxels, or when no view has a gain.
+ */
+template <typename T>
+class ViewSelector {
+    static_assert(std::is_floating_point<T>::value, "");
+
+    using Point = Point3D<T>;
+    using Vector = Vector3D<T>;
+
+public:
+    struct Options {
+        // Edge length of the voxels.
+        double voxel_size = 1.0;
+
+        // Maximum number of selected views. Zero or negative means no limit.
+        int budget = 0;
+
+        // Fraction of the seen voxels that must be satisfied.
+        double target_coverage = 1.0;
+
+        // Number of selected views that should see each voxel.
+        int views_per_voxel = 2;
+
+        // Pose distance of a fully novel view, in position and in viewing
+        // direction (radians). Zero disables the term; novelty is 1 if both
+        // are disabled.
+        double novelty_distance = 0.0;
+        double novelty_angle = 0.0;
+
+        // Views whose novelty is below it are not selected.
+        double min_novelty = 0.0;
+
+        // Exponent of the relative sharpness in the gain.
+        double sharpness_weight = 1.0;
+    };
+
+    struct View {
+        View() = default;
+
+        /**
+         * Construct a pinhole view from the camera pose and the bounds of the
+         * image at unit depth, i.e., x in [x_min, x_max] along 'right' and y
+         * in [y_min, y_max] along 'up'. The axes must be orthonormal.
+         */
+        View(const Point& position, const Vector& right, const Vector& up,
+             const Vector& forward, T x_min, T x_max, T y_min, T y_max,
+             T near, T far, double sharpness = 1.0)
+            : position(position),
+              direction(forward),
+              sharpness(sharpness) {
+            CHECK(x_min < x_max && y_min < y_max);
+            CHECK(near > 0 && near < far);
+
+            // In the order of Frustum3D: left-bottom, right-bottom,
+            // right-top, left-top of the near, then of the far rectangle.
+            const T xs[4] = { x_min, x_max, x_max, x_min };
+            const T ys[4] = { y_min, y_min, y_max, y_max };
+            Array<Point> vertices;
+            for (T depth : { near, far }) {
+                for (int i = 0; i < 4; ++i) {
+                    vertices.push_back(position + depth * (forward +
+                                       xs[i] * right + ys[i] * up));
+                }
+            }
+            frustum = Frustum3D<T>(vertices);
+        }
+
+        // Viewing frustum.
+        Frustum3D<T> frustum;
+
+        // Camera position and unit viewing direction.
+        Point position;
+        Vector direction;
+
+        // Sharpness of the image, e.g., the variance of its Laplacian.
+        double sharpness = 1.0;
+    };
+
+    ViewSelector() = default;
+
+    explicit ViewSelector(const Options& options)
+        : options_(options) {
+        CHECK(options.voxel_size > 0.0);
+        CHECK(options.target_coverage >= 0.0);
+        CHECK(options.views_per_voxel > 0);
+        CHECK(options.novelty_distance >= 0.0);
+        CHECK(options.novelty_angle >= 0.0);
+        CHECK(options.min_novelty >= 0.0 && options.min_novelty <= 1.0);
+        CHECK(options.sharpness_weight >= 0.0);
+    }
+
+    /**
+     * Select the views, return their sorted indices.
+     */
+    void Select(const Array<View>& views, const Array<Point>& points,
+                Array<int>* selected) {
+        CHECK(selected);
+
+        selected->clear();
+        n_views_ = views.size();
+        n_voxels_ = n_visible_voxels_ = n_covered_voxels_ = 0;
+        if (views.empty()) return;
+
+        Array<Box3D<T>> voxels;
+        Voxelize(points, &voxels);
+        n_voxels_ = voxels.size();
+
+        Array<Array<int>> visible;
+        ComputeVisibility(views, voxels, &visible);
+
+        // The number of selected views needed by each voxel.
+        Array<int> demands(n_voxels_, 0);
+        for (const Array<int>& list : visible) {
+            for (int u : list) {
+                ++demands[u];
+            }
+        }
+        for (int& d : demands) {
+            if (d > 0) ++n_visible_voxels_;
+            d = std::min(d, options_.views_per_voxel);
+        }
+        int target = static_cast<int>(std::ceil(options_.target_coverage *
+                                                n_visible_voxels_));
+
+        // Relative sharpness.
+        double mean_sharpness = 0.0;
+        for (const View& view : views) {
+            CHECK(view.sharpness >= 0.0);
+            mean_sharpness += view.sharpness;
+        }
+        mean_sharpness /= n_views_;
+        Array<double> qualities(n_views_, 1.0);
+        if (mean_sharpness > 0.0 && options_.sharpness_weight > 0.0) {
+            for (int i = 0; i < n_views_; ++i) {
+                qualities[i] = std::pow(views[i].sharpness / mean_sharpness,
+                                        options_.sharpness_weight);
+            }
+        }
+
+        Array<double> novelties(n_views_, 1.0);
+        Array<int> counts(n_voxels_, 0);
+        auto gain = [&](int i) {
+            if (novelties[i] < options_.min_novelty) return 0.0;
+
+            double coverage = n_visible_voxels_ == 0 ? 1.0 : 0.0;
+            for (int u : visible[i]) {
+                if (counts[u] < demands[u]) coverage += 1.0 / (1 + counts[u]);
+            }
+            return qualities[i] * novelties[i] * coverage;
+        };
+
+        // Pairs of the (maybe stale) gain and the negative index, so that the
+        // smaller index wins the ties.
+        Array<double> gains(n_views_);
+        #pragma omp parallel for if (n_views_ > 256)
+        for (int i = 0; i < n_views_; ++i) {
+            gains[i] = gain(i);
+        }
+        std::priority_queue<std::pair<double, int>> queue;
+        for (int i = 0; i < n_views_; ++i) {
+            if (gains[i] > 0.0) queue.emplace(gains[i], -i);
+        }
+
+        int budget = options_.budget > 0 ? options_.budget : n_views_;
+        int n_satisfied = 0;
+        while (!queue.empty() && selected->size() < budget &&
+               (n_visible_voxels_ == 0 || n_satisfied < target)) {
+            int i = -queue.top().second;
+            queue.pop();
+            double g = gain(i);
+            if (g <= 0.0) continue;
+            if (!queue.empty() && g < queue.top().first) {
+                queue.emplace(g, -i);
+                continue;
+            }
+
+            selected->push_back(i);
+            for (int u : visible[i]) {
+                if (counts[u] == 0) ++n_covered_voxels_;
+                if (++counts[u] == demands[u]) ++n_satisfied;
+            }
+            UpdateNovelties(views, i, &novelties);
+        }
+
+        std::sort(selected->begin(), selected->end());
+    }
+
+    /**
+     * Statistics of the last selection.
+     */
+    int n_views() const {
+        return n_views_;
+    }
+
+    int n_voxels() const {
+        return n_voxels_;
+    }
+
+    /**
+     * Number of voxels seen by some view.
+     */
+    int n_visible_voxels() const {
+        return n_visible_voxels_;
+    }
+
+    /**
+     * Number of voxels seen by some selected view.
+     */
+    int n_covered_voxels() const {
+        return n_covered_voxels_;
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+    /**
+     * Get the boxes of the non-empty voxels.
+     */
+    void Voxelize(const Array<Point>& points, Array<Box3D<T>>* voxels) const {
+        voxels->clear();
+        if (points.empty()) return;
+
+        Box3D<T> box(points.begin(), points.end());
+        double size = options_.voxel_size;
+        int64_t nx = static_cast<int64_t>(box.x_length() / size) + 1;
+        int64_t ny = static_cast<int64_t>(box.y_length() / size) + 1;
+        int64_t nz = static_cast<int64_t>(box.z_length() / size) + 1;
+        CHECK(nx <= INT64_MAX / ny / nz) << "The voxel size is too small.";
+
+        Array<int64_t> keys(points.size());
+        #pragma omp parallel for if (points.size() > 100000)
+        for (int i = 0; i < points.size(); ++i) {
+            const Point& p = points[i];
+            int64_t x = std::min(nx - 1, static_cast<int64_t>(
+                                 (p.x - box.x_min()) / size));
+            int64_t y = std::min(ny - 1, static_cast<int64_t>(
+                                 (p.y - box.y_min()) / size));
+            int64_t z = std::min(nz - 1, static_cast<int64_t>(
+                                 (p.z - box.z_min()) / size));
+            keys[i] = (x * ny + y) * nz + z;
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.resize(static_cast<int>(std::unique(keys.begin(), keys.end()) -
+                                     keys.begin()));
+
+        voxels->resize(keys.size());
+        for (int i = 0; i < keys.size(); ++i) {
+            int64_t z = keys[i] % nz;
+            int64_t y = keys[i] / nz % ny;
+            int64_t x = keys[i] / nz / ny;
+            T x0 = static_cast<T>(box.x_min() + x * size);
+            T y0 = static_cast<T>(box.y_min() + y * size);
+            T z0 = static_cast<T>(box.z_min() + z * size);
+            (*voxels)[i] = Box3D<T>(x0, x0 + size, y0, y0 + size,
+                                    z0, z0 + size);
+        }
+    }
+
+    /**
+     * Get the sorted voxels seen by each view.
+     */
+    void ComputeVisibility(const Array<View>& views,
+                           const Array<Box3D<T>>& voxels,
+                           Array<Array<int>>* visible) const {
+        AABBTree<T, int> tree;
+        for (int u = 0; u < voxels.size(); ++u) {
+            tree.Insert(voxels[u], u);
+        }
+
+        const int n = views.size();
+        visible->resize(n);
+        #pragma omp parallel if (n > 1)
+        {
+            geometry::FrustumCuller3D<T, int> culler;
+
+            #pragma omp for schedule(dynamic)
+            for (int i = 0; i < n; ++i) {
+                Array<int>& list = (*visible)[i];
+                culler.Cull(tree, views[i].frustum, &list);
+                std::sort(list.begin(), list.end());
+            }
+        }
+    }
+
+    /**
+     * Update the novelties after selecting the view 's'.
+     */
+    void UpdateNovelties(const Array<View>& views, int s,
+                         Array<double>* novelties) const {
+        double d0 = options_.novelty_distance, a0 = options_.novelty_angle;
+        if (d0 <= 0.0 && a0 <= 0.0) return;
+
+        const View& v = views[s];
+        #pragma omp parallel for if (n_views_ > 4096)
+        for (int i = 0; i < n_views_; ++i) {
+            double d = 0.0;
+            if (d0 > 0.0) {
+                d = Distance(views[i].position, v.position) / d0;
+            }
+            if (a0 > 0.0) {
+                d = std::max(d, static_cast<double>(
+                        Radian(views[i].direction, v.direction)) / a0);
+            }
+            (*novelties)[i] = std::min((*novelties)[i], std::min(1.0, d));
+        }
+    }
+
+    Options options_;
+
+    // Statistics of the last selection.
+    int n_views_ = 0;
+    int n_voxels_ = 0;
+    int n_visible_voxels_ = 0;
+    int n_covered_voxels_ = 0;
+};
+
+} // namespace point_cloud
+} // namespace cl
+
+#endif // CODELIBRARY_POINT_CLOUD_VIEW_SELECTOR_H_
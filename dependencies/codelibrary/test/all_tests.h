@@ -18,11 +18,42 @@
 #include "codelibrary/test/base/message_test.h"
 #include "codelibrary/test/geometry_tests.h"
 #include "codelibrary/test/graph_tests.h"
+#include "codelibrary/test/image/box_blur_test.h"
+#include "codelibrary/test/image/distance_transform_performance_test.h"
+#include "codelibrary/test/image/distance_transform_test.h"
+#include "codelibrary/test/image/environment_map_test.h"
+#include "codelibrary/test/image/morphology_performance_test.h"
+#include "codelibrary/test/image/morphology_test.h"
+#include "codelibrary/test/image/tonemapper_performance_test.h"
+#include "codelibrary/test/image/tonemapper_test.h"
 #include "codelibrary/test/math_tests.h"
+#include "codelibrary/test/point_cloud/block_aligner_performance_test.h"
+#include "codelibrary/test/point_cloud/block_aligner_test.h"
+#include "codelibrary/test/point_cloud/block_compositor_performance_test.h"
+#include "codelibrary/test/point_cloud/block_compositor_test.h"
+#include "codelibrary/test/point_cloud/normal_estimation_3d_performance_test.h"
+#include "codelibrary/test/point_cloud/normal_estimation_3d_test.h"
+#include "codelibrary/test/point_cloud/poisson_disk_sample_3d_performance_test.h"
+#include "codelibrary/test/point_cloud/poisson_disk_sample_3d_test.h"
+#include "codelibrary/test/point_cloud/trajectory_partitioner_test.h"
+#include "codelibrary/test/point_cloud/view_selector_test.h"
 #include "codelibrary/test/string/string_split_test.h"
+#include "codelibrary/test/util/codec/linear_quantizer_test.h"
+#include "codelibrary/test/util/codec/quantized_array_codec_performance_test.h"
+#include "codelibrary/test/util/codec/quantized_array_codec_test.h"
+#include "codelibrary/test/util/codec/rans_coder_test.h"
+#include "codelibrary/test/util/heap/radix_heap_test.h"
 #include "codelibrary/test/util/interval/interval_set_test.h"
 #include "codelibrary/test/util/interval/interval_test.h"
 #include "codelibrary/test/util/list/indexed_list_test.h"
+#include "codelibrary/test/util/memory/memory_planner_test.h"
+#include "codelibrary/test/util/set/compressed_bitset_test.h"
+#include "codelibrary/test/util/set/dynamic_bitset_performance_test.h"
+#include "codelibrary/test/util/set/dynamic_set_test.h"
+#include "codelibrary/test/util/set/rank_select_test.h"
+#include "codelibrary/test/util/statistics/parameter_statistics_performance_test.h"
+#include "codelibrary/test/util/statistics/parameter_statistics_test.h"
+#include "codelibrary/test/util/tree/aabb_tree_test.h"
 #include "codelibrary/test/util/tree/kd_tree_test.h"
 #include "codelibrary/test/util/tree/octree_test.h"
 #include "codelibrary/test/util/color/color_tests.h"
@@ -9,6 +9,9 @@
 #ifndef CODELIBRARY_TEST_BASE_BITS_TEST_H_
 #define CODELIBRARY_TEST_BASE_BITS_TEST_H_
 
+#include <cstdint>
+#include <random>
+
 #include "codelibrary/base/bits.h"
 #include "codelibrary/base/testing.h"
 
@@ -34,6 +37,45 @@ TEST(BitsTest, Log2Floor) {
     ASSERT_EQ(bits::Log2Floor(0xffffffffffffffffUL), 63);
 }
 
+TEST(BitsTest, CountOnes) {
+    std::mt19937_64 random;
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t n = random();
+        int count = 0;
+        for (int j = 0; j < 64; ++j) {
+            count += static_cast<int>((n >> j) & 1);
+        }
+        ASSERT_EQ(bits::CountOnes(n), count);
+        ASSERT_EQ(bits::CountOnes(static_cast<uint32_t>(n)) +
+                  bits::CountOnes(static_cast<uint32_t>(n >> 32)), count);
+    }
+    ASSERT_EQ(bits::CountOnes(uint64_t(0)), 0);
+    ASSERT_EQ(bits::CountOnes(~uint64_t(0)), 64);
+}
+
+TEST(BitsTest, SelectBit) {
+    for (int i = 0; i < 64; ++i) {
+        ASSERT_EQ(bits::CountTrailingZeros(uint64_t(1) << i), i);
+        ASSERT_EQ(bits::CountLeadingZeros(uint64_t(1) << i), 63 - i);
+    }
+
+    std::mt19937_64 random;
+    for (int i = 0; i < 1000; ++i) {
+        // Vary the density.
+        uint64_t n = random();
+        if (i % 3 == 1) n &= random();
+        if (i % 3 == 2) n |= random();
+        if (n == 0) continue;
+
+        int k = 0;
+        for (int j = 0; j < 64; ++j) {
+            if ((n >> j) & 1) {
+                ASSERT_EQ(bits::SelectBit(n, k++), j);
+            }
+        }
+    }
+}
+
 } // namespace test
 } // namespace cl
 
@@ -9,6 +9,8 @@
 #ifndef CODELIBRARY_TEST_BASE_FLOAT_TEST_H_
 #define CODELIBRARY_TEST_BASE_FLOAT_TEST_H_
 
+#include <cmath>
+
 #include "codelibrary/base/float.h"
 #include "codelibrary/base/testing.h"
 
@@ -45,6 +47,33 @@ TEST(FloatTest, TestInf) {
     ASSERT(x4.is_inf());
 }
 
+TEST(FloatTest, TestHalf) {
+    ASSERT_EQ(Half(0.0f).bits(), 0x0000);
+    ASSERT_EQ(Half(1.0f).bits(), 0x3C00);
+    ASSERT_EQ(Half(-2.0f).bits(), 0xC000);
+    ASSERT_EQ(Half(65504.0f).bits(), 0x7BFF);
+    ASSERT_EQ(Half(1e6f).bits(), 0x7C00);
+    ASSERT_EQ(Half(std::numeric_limits<float>::infinity()).bits(), 0x7C00);
+    ASSERT_EQ(Half(5.9604644775390625e-8f).bits(), 0x0001);
+
+    // Round to nearest even.
+    ASSERT_EQ(Half(1.0f + 1.0f / 2048).bits(), 0x3C00);
+    ASSERT_EQ(Half(1.0f + 3.0f / 2048).bits(), 0x3C02);
+
+    // Every finite half survives a round trip.
+    for (int i = 0; i < 0x7C00; ++i) {
+        float f = std::ldexp(static_cast<float>(i & 0x3FF), -24);
+        if (i >= 0x400) {
+            f = std::ldexp(1.0f + (i & 0x3FF) / 1024.0f, (i >> 10) - 15);
+        }
+        ASSERT_EQ(Half(f).bits(), i);
+        ASSERT_EQ(static_cast<float>(Half(f)), f);
+        ASSERT_EQ(static_cast<float>(Half::FromBits(i)), f);
+    }
+    ASSERT(std::isnan(static_cast<float>(
+        Half(std::numeric_limits<float>::quiet_NaN()))));
+}
+
 } // namespace test
 } // namespace cl
 
@@ -0,0 +1,197 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_PERFORMANCE_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/geometry/envelope/convex_hull_3d.h"
+
+namespace cl {
+namespace test {
+
+class ConvexHull3DPerformanceTest : public Test {
+protected:
+    using Hull = geometry::ConvexHull3D<double>;
+
+    /**
+     * Uniform points on the unit sphere (every point is a hull vertex).
+     */
+    void Sphere(int n, Array<RPoint3D>* points) {
+        std::normal_distribution<double> normal(0.0, 1.0);
+        points->resize(n);
+        for (RPoint3D& p : *points) {
+            double x = normal(random_), y = normal(random_);
+            double z = normal(random_);
+            double r = std::sqrt(x * x + y * y + z * z);
+            p = RPoint3D(x / r, y / r, z / r);
+        }
+    }
+
+    /**
+     * Uniform points in the unit ball.
+     */
+    void Ball(int n, Array<RPoint3D>* points) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        Sphere(n, points);
+        for (RPoint3D& p : *points) {
+            double s = std::cbrt(uniform(random_));
+            p = RPoint3D(p.x * s, p.y * s, p.z * s);
+        }
+    }
+
+    /**
+     * Random integer points on the surface of a cube. Most of them are
+     * coplanar with a hull face, and many are duplicated.
+     */
+    void CubeSurface(int n, Array<RPoint3D>* points) {
+        std::uniform_int_distribution<int> uniform(0, 100);
+        std::uniform_int_distribution<int> side(0, 5);
+        points->resize(n);
+        for (RPoint3D& p : *points) {
+            int c[3] = { uniform(random_), uniform(random_),
+                         uniform(random_) };
+            int s = side(random_);
+            c[s % 3] = s < 3 ? 0 : 100;
+            p = RPoint3D(c[0], c[1], c[2]);
+        }
+    }
+
+    /**
+     * Random points on a plane, the hull is empty.
+     */
+    void Plane(int n, Array<RPoint3D>* points) {
+        std::uniform_int_distribution<int> uniform(0, 1000);
+        points->resize(n);
+        for (RPoint3D& p : *points) {
+            int x = uniform(random_), y = uniform(random_);
+            p = RPoint3D(x, y, x + y);
+        }
+    }
+
+    /**
+     * Build the hull of each of 'n_chunks' slabs of the points in parallel,
+     * then merge the hulls.
+     */
+    void ChunkedHull(const Array<RPoint3D>& points, int n_chunks,
+                     Hull* hull) const {
+        Array<Array<RPoint3D>> chunks(n_chunks);
+        for (const RPoint3D& p : points) {
+            int i = static_cast<int>((p.x + 1.0) * 0.5 * n_chunks);
+            chunks[std::min(std::max(i, 0), n_chunks - 1)].push_back(p);
+        }
+
+        Array<Hull> hulls(n_chunks);
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < n_chunks; ++i) {
+            hulls[i].Reset(chunks[i]);
+        }
+
+        hull->clear();
+        for (int i = 0; i < n_chunks; ++i) {
+            hull->Merge(hulls[i]);
+        }
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(ConvexHull3DPerformanceTest, Build) {
+    const int n_tests = 3;
+    const int sizes[n_tests] = { 10000, 100000, 1000000 };
+    const char* names[4] = { "Sphere", "Ball", "Cube surface", "Plane" };
+
+    printf("\n");
+    printf("       Input         n    Faces        Reset       Insert\n");
+    printf("----------------------------------------------------------\n");
+    for (int k = 0; k < 4; ++k) {
+        for (int i = 0; i < n_tests; ++i) {
+            const int n = sizes[i];
+            Array<RPoint3D> points;
+            switch (k) {
+            case 0:
+                // The hull of points on the sphere has 2n faces.
+                if (n > 100000) continue;
+                Sphere(n, &points);
+                break;
+            case 1:
+                Ball(n, &points);
+                break;
+            case 2:
+                CubeSurface(n, &points);
+                break;
+            default:
+                Plane(n, &points);
+            }
+
+            Hull hull1;
+            Timer timer1;
+            timer1.Start();
+            hull1.Reset(points);
+            timer1.Stop();
+
+            // Insert in batches of 10000 points.
+            Hull hull2;
+            Timer timer2;
+            timer2.Start();
+            for (int j = 0; j < n; j += 10000) {
+                Array<RPoint3D> batch(points.begin() + j,
+                                      points.begin() + std::min(j + 10000, n));
+                hull2.Insert(batch);
+            }
+            timer2.Stop();
+            if (k < 2) {
+                // Points in general position.
+                ASSERT_EQ(hull1.faces().size(), hull2.faces().size());
+            }
+
+            printf("%12s %9d %8d %12s %12s\n", names[k], n,
+                   hull1.faces().size(), timer1.average_time(1).c_str(),
+                   timer2.average_time(1).c_str());
+        }
+    }
+    printf("----------------------------------------------------------\n");
+    printf("\n");
+}
+
+TEST_F(ConvexHull3DPerformanceTest, Merge) {
+    const int n = 1000000;
+    const int n_chunks = 16;
+    Array<RPoint3D> points;
+    Ball(n, &points);
+
+    Timer timer1;
+    timer1.Start();
+    Hull hull1(points);
+    timer1.Stop();
+
+    Hull hull2;
+    Timer timer2;
+    timer2.Start();
+    ChunkedHull(points, n_chunks, &hull2);
+    timer2.Stop();
+
+    ASSERT_EQ(hull1.faces().size(), hull2.faces().size());
+
+    printf("\n");
+    printf("        n   Chunks       Single   Chunks + Merge\n");
+    printf("------------------------------------------------\n");
+    printf("%9d %8d %12s %16s\n", n, n_chunks, timer1.average_time(1).c_str(),
+           timer2.average_time(1).c_str());
+    printf("------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_PERFORMANCE_TEST_H_
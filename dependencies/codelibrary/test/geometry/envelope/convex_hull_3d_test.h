@@ -0,0 +1,213 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/envelope/convex_hull_3d.h"
+#include "codelibrary/geometry/predicate_3d.h"
+
+namespace cl {
+namespace test {
+
+class ConvexHull3DTest : public Test {
+protected:
+    using Hull = geometry::ConvexHull3D<double>;
+
+    /**
+     * Check that 'hull' is a closed convex triangle mesh that contains all
+     * 'points', and get its sorted vertices.
+     */
+    void CheckHull(const Hull& hull, const Array<RPoint3D>& points,
+                   Array<RPoint3D>* vertices) const {
+        const auto& mesh = hull.mesh();
+        int n_faces = hull.faces().size();
+        int n_edges = mesh.n_halfedges() / 2;
+        ASSERT_EQ(mesh.n_vertices() - n_edges + n_faces, 2);
+        ASSERT_EQ(3 * n_faces, 2 * n_edges);
+
+        for (const auto* face : hull.faces()) {
+            const auto* e = face->halfedge;
+            const RPoint3D& p1 = e->source_point();
+            const RPoint3D& p2 = e->target_point();
+            const RPoint3D& p3 = e->next()->target_point();
+            for (const RPoint3D& p : points) {
+                ASSERT(geometry::Orientation(p1, p2, p3, p) <= 0);
+            }
+        }
+
+        hull.GetVertices(vertices);
+        std::sort(vertices->begin(), vertices->end());
+    }
+
+    Array<RPoint3D> RandomSphere(int n, std::mt19937* random) const {
+        std::normal_distribution<double> normal(0.0, 1.0);
+        Array<RPoint3D> points(n);
+        for (RPoint3D& p : points) {
+            double x = normal(*random), y = normal(*random);
+            double z = normal(*random);
+            double r = std::sqrt(x * x + y * y + z * z);
+            p = RPoint3D(x / r, y / r, z / r);
+        }
+        return points;
+    }
+};
+
+TEST_F(ConvexHull3DTest, DegenerateInputs) {
+    Array<RPoint3D> points;
+    Hull hull(points);
+    ASSERT(hull.empty());
+
+    points = { {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0} };
+    hull.Reset(points);
+    ASSERT(hull.empty());
+
+    // Coplanar points.
+    points.clear();
+    for (int i = 0; i < 1000; ++i) {
+        points.emplace_back(i % 10, i / 10 % 10, 1.0);
+    }
+    hull.Reset(points);
+    ASSERT(hull.empty());
+
+    // Adding a point off the plane builds the pyramid.
+    Array<RPoint3D> apex = { {4.5, 4.5, 2.0} };
+    hull.Insert(apex);
+    ASSERT(!hull.empty());
+    Array<RPoint3D> vertices;
+    CheckHull(hull, points, &vertices);
+    Array<RPoint3D> results = {
+        {0.0, 0.0, 1.0}, {0.0, 9.0, 1.0}, {4.5, 4.5, 2.0}, {9.0, 0.0, 1.0},
+        {9.0, 9.0, 1.0}
+    };
+    ASSERT_EQ_RANGE(vertices.begin(), vertices.end(),
+                    results.begin(), results.end());
+}
+
+TEST_F(ConvexHull3DTest, Cube) {
+    // Grid points on the surface and inside of a cube, with duplicates.
+    Array<RPoint3D> points;
+    for (int x = 0; x <= 10; ++x) {
+        for (int y = 0; y <= 10; ++y) {
+            for (int z = 0; z <= 10; ++z) {
+                points.emplace_back(x, y, z);
+                points.emplace_back(x, y, z);
+            }
+        }
+    }
+
+    Hull hull(points);
+    Array<RPoint3D> vertices;
+    CheckHull(hull, points, &vertices);
+    Array<RPoint3D> results;
+    for (int i = 0; i < 8; ++i) {
+        results.emplace_back(i & 4 ? 10 : 0, i & 2 ? 10 : 0, i & 1 ? 10 : 0);
+    }
+    ASSERT_EQ_RANGE(vertices.begin(), vertices.end(),
+                    results.begin(), results.end());
+    ASSERT_EQ(hull.faces().size(), 12);
+}
+
+TEST_F(ConvexHull3DTest, RandomPoints) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    Array<RPoint3D> points(2000);
+    for (RPoint3D& p : points) {
+        p = RPoint3D(uniform(random), uniform(random), uniform(random));
+    }
+
+    Hull hull(points);
+    Array<RPoint3D> vertices;
+    CheckHull(hull, points, &vertices);
+
+    // Each vertex is not inside the hull of the other points.
+    for (int i = 0; i < vertices.size(); i += 7) {
+        Array<RPoint3D> others(points);
+        others.erase(vertices[i]);
+        Hull hull1(others);
+        Array<RPoint3D> vertices1;
+        hull1.GetVertices(&vertices1);
+        ASSERT(std::find(vertices1.begin(), vertices1.end(), vertices[i]) ==
+               vertices1.end());
+
+        bool outside = false;
+        for (const auto* face : hull1.faces()) {
+            const auto* e = face->halfedge;
+            if (geometry::Orientation(e->source_point(), e->target_point(),
+                                      e->next()->target_point(),
+                                      vertices[i]) > 0) {
+                outside = true;
+            }
+        }
+        ASSERT(outside);
+    }
+}
+
+TEST_F(ConvexHull3DTest, Insert) {
+    std::mt19937 random;
+    Array<RPoint3D> points = RandomSphere(2000, &random);
+
+    Hull hull1(points);
+    Array<RPoint3D> vertices1;
+    CheckHull(hull1, points, &vertices1);
+
+    Hull hull2;
+    for (int i = 0; i < points.size(); i += 500) {
+        Array<RPoint3D> batch(points.begin() + i, points.begin() + i + 500);
+        hull2.Insert(batch);
+    }
+    Array<RPoint3D> vertices2;
+    CheckHull(hull2, points, &vertices2);
+    ASSERT_EQ_RANGE(vertices1.begin(), vertices1.end(),
+                    vertices2.begin(), vertices2.end());
+}
+
+TEST_F(ConvexHull3DTest, Merge) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Two adjacent chunks of a point cloud.
+    Array<RPoint3D> points(4000), chunk1, chunk2;
+    for (RPoint3D& p : points) {
+        p = RPoint3D(uniform(random), uniform(random), uniform(random));
+        if (p.x < 0.5) {
+            chunk1.push_back(p);
+        } else {
+            chunk2.push_back(p);
+        }
+    }
+
+    Hull hull(points);
+    Array<RPoint3D> vertices;
+    CheckHull(hull, points, &vertices);
+
+    Hull hull1(chunk1), hull2(chunk2);
+    hull1.Merge(hull2);
+    Array<RPoint3D> vertices1;
+    CheckHull(hull1, points, &vertices1);
+    ASSERT_EQ_RANGE(vertices.begin(), vertices.end(),
+                    vertices1.begin(), vertices1.end());
+
+    // Merge with an empty hull.
+    Hull hull3;
+    hull3.Merge(hull);
+    Array<RPoint3D> vertices3;
+    CheckHull(hull3, points, &vertices3);
+    ASSERT_EQ_RANGE(vertices.begin(), vertices.end(),
+                    vertices3.begin(), vertices3.end());
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_ENVELOPE_CONVEX_HULL_3D_TEST_H_
@@ -0,0 +1,198 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_MESH_BLOCK_MESH_STITCHER_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_MESH_BLOCK_MESH_STITCHER_TEST_H_
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/mesh/block_mesh_stitcher.h"
+
+namespace cl {
+namespace test {
+
+class BlockMeshStitcherTest : public Test {
+protected:
+    using Stitcher = geometry::BlockMeshStitcher<double>;
+    using BlockMesh = Stitcher::BlockMesh;
+    using Mesh = Stitcher::Mesh;
+
+    /**
+     * Triangulate the ellipsoid with semi-axes (3, 1, 1) by 'n_rings' rings
+     * of 'n_segments' vertices around the x-axis, rotated by 'phase'. The
+     * block stores the vertices as v * scale + offset.
+     */
+    static BlockMesh Ellipsoid(int n_rings, int n_segments, double phase,
+                               const RPoint3D& site, double scale = 1.0,
+                               const RVector3D& offset = RVector3D()) {
+        BlockMesh block;
+        block.site = site;
+        block.scale = scale;
+        block.offset = offset;
+
+        Array<RPoint3D>& vertices = block.vertices;
+        vertices.emplace_back(3.0, 0.0, 0.0);
+        for (int i = 1; i < n_rings; ++i) {
+            double theta = M_PI * i / n_rings;
+            for (int j = 0; j < n_segments; ++j) {
+                double phi = 2.0 * M_PI * j / n_segments + phase;
+                vertices.emplace_back(3.0 * std::cos(theta),
+                                      std::sin(theta) * std::cos(phi),
+                                      std::sin(theta) * std::sin(phi));
+            }
+        }
+        vertices.emplace_back(-3.0, 0.0, 0.0);
+        for (RPoint3D& v : vertices) {
+            v = RPoint3D(v.x * scale + offset.x, v.y * scale + offset.y,
+                         v.z * scale + offset.z);
+        }
+
+        auto ring = [&](int i, int j) {
+            return 1 + (i - 1) * n_segments + j % n_segments;
+        };
+        Array<int>& t = block.triangles;
+        const int south = vertices.size() - 1;
+        for (int j = 0; j < n_segments; ++j) {
+            t.insert({ 0, ring(1, j), ring(1, j + 1) });
+            for (int i = 1; i + 1 < n_rings; ++i) {
+                t.insert({ ring(i, j), ring(i + 1, j), ring(i + 1, j + 1) });
+                t.insert({ ring(i, j), ring(i + 1, j + 1), ring(i, j + 1) });
+            }
+            t.insert({ south, ring(n_rings - 1, j + 1),
+                       ring(n_rings - 1, j) });
+        }
+        return block;
+    }
+
+    /**
+     * Check that the mesh is closed and consistently oriented, i.e., each
+     * directed edge appears once, and so does its opposite, and that it is a
+     * topological sphere.
+     */
+    static void CheckClosed(const Array<RPoint3D>& vertices,
+                            const Array<int>& triangles) {
+        std::unordered_map<uint64_t, int> edges;
+        for (int i = 0; i < triangles.size(); ++i) {
+            int a = triangles[i], b = triangles[i % 3 == 2 ? i - 2 : i + 1];
+            ASSERT(a != b);
+            ++edges[(uint64_t(a) << 32) | uint64_t(b)];
+        }
+        for (const auto& edge : edges) {
+            uint64_t a = edge.first >> 32, b = edge.first & 0xffffffff;
+            ASSERT_EQ(edge.second, 1);
+            auto opposite = edges.find((b << 32) | a);
+            ASSERT(opposite != edges.end());
+        }
+        int euler = vertices.size() - static_cast<int>(edges.size()) / 2 +
+                    triangles.size() / 3;
+        ASSERT_EQ(euler, 2);
+    }
+};
+
+TEST_F(BlockMeshStitcherTest, TwoBlocks) {
+    Array<BlockMesh> blocks;
+    blocks.push_back(Ellipsoid(25, 48, 0.0, RPoint3D(-1.5, 0.0, 0.0)));
+    blocks.push_back(Ellipsoid(30, 40, 0.3, RPoint3D(1.5, 0.0, 0.0), 0.25,
+                               RVector3D(0.5, 0.5, 0.5)));
+    for (const BlockMesh& b : blocks) {
+        CheckClosed(b.vertices, b.triangles);
+    }
+
+    Stitcher::Options options;
+    options.weld_distance = 0.02;
+    Stitcher stitcher(options);
+    Mesh mesh;
+    Stitcher::Summary summary;
+    stitcher.Stitch(blocks, &mesh, &summary);
+
+    // The seam at x = 0 is closed.
+    CheckClosed(mesh.vertices, mesh.triangles);
+    ASSERT(summary.n_cut_triangles > 0);
+    ASSERT(summary.n_split_edges > 0);
+    ASSERT(summary.n_welded_vertices > 0);
+
+    // Each block keeps its side, in the world frame.
+    ASSERT_EQ(mesh.blocks.size() * 3, mesh.triangles.size());
+    for (int i = 0; i < mesh.blocks.size(); ++i) {
+        for (int k = 0; k < 3; ++k) {
+            const RPoint3D& p = mesh.vertices[mesh.triangles[3 * i + k]];
+            ASSERT(mesh.blocks[i] == 0 ? p.x <= 0.02 : p.x >= -0.02);
+            ASSERT(std::fabs(p.y) <= 1.0 + 1e-9);
+        }
+    }
+}
+
+TEST_F(BlockMeshStitcherTest, Chain) {
+    // Three blocks with seams at x = -1 and x = 1, and a far block that owns
+    // nothing of the ellipsoid.
+    Array<BlockMesh> blocks;
+    blocks.push_back(Ellipsoid(21, 36, 0.0, RPoint3D(-2.0, 0.0, 0.0)));
+    blocks.push_back(Ellipsoid(26, 40, 0.1, RPoint3D(0.0, 0.0, 0.0)));
+    blocks.push_back(Ellipsoid(23, 33, 0.2, RPoint3D(2.0, 0.0, 0.0)));
+    blocks.push_back(Ellipsoid(10, 10, 0.0, RPoint3D(0.0, 10.0, 0.0)));
+
+    Stitcher::Options options;
+    options.weld_distance = 0.02;
+    Stitcher stitcher(options);
+    Mesh mesh;
+    stitcher.Stitch(blocks, &mesh);
+    CheckClosed(mesh.vertices, mesh.triangles);
+
+    Array<int> n_triangles(4, 0);
+    for (int b : mesh.blocks) {
+        ++n_triangles[b];
+    }
+    ASSERT(n_triangles[0] > 0 && n_triangles[1] > 0 && n_triangles[2] > 0);
+    ASSERT_EQ(n_triangles[3], 0);
+}
+
+TEST_F(BlockMeshStitcherTest, Junction) {
+    // Four blocks whose cells meet along the z-axis. The rings of some
+    // blocks lie on the seams.
+    Array<BlockMesh> blocks;
+    blocks.push_back(Ellipsoid(21, 36, 0.0, RPoint3D(-1.5, -1.0, 0.0)));
+    blocks.push_back(Ellipsoid(26, 40, 0.1, RPoint3D(1.5, -1.0, 0.0)));
+    blocks.push_back(Ellipsoid(23, 33, 0.2, RPoint3D(-1.5, 1.0, 0.0)));
+    blocks.push_back(Ellipsoid(24, 38, 0.3, RPoint3D(1.5, 1.0, 0.0)));
+
+    Stitcher::Options options;
+    options.weld_distance = 0.02;
+    Stitcher stitcher(options);
+    Mesh mesh;
+    stitcher.Stitch(blocks, &mesh);
+    CheckClosed(mesh.vertices, mesh.triangles);
+}
+
+TEST_F(BlockMeshStitcherTest, SingleBlock) {
+    Array<BlockMesh> blocks;
+    blocks.push_back(Ellipsoid(8, 12, 0.0, RPoint3D(0.0, 0.0, 0.0), 2.0,
+                               RVector3D(1.0, 2.0, 3.0)));
+
+    Stitcher stitcher;
+    Mesh mesh;
+    Stitcher::Summary summary;
+    stitcher.Stitch(blocks, &mesh, &summary);
+    ASSERT_EQ(mesh.vertices.size(), blocks[0].vertices.size());
+    ASSERT_EQ_RANGE(mesh.triangles.begin(), mesh.triangles.end(),
+                    blocks[0].triangles.begin(), blocks[0].triangles.end());
+    ASSERT_EQ_NEAR(mesh.vertices[0].x, 3.0, 1e-12);
+    ASSERT_EQ(summary.n_seam_vertices, 0);
+
+    stitcher.Stitch(Array<BlockMesh>(), &mesh, &summary);
+    ASSERT(mesh.vertices.empty());
+    ASSERT(mesh.triangles.empty());
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_MESH_BLOCK_MESH_STITCHER_TEST_H_
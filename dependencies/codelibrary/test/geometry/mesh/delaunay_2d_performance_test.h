@@ -0,0 +1,94 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_MESH_DELAUNAY_2D_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_MESH_DELAUNAY_2D_PERFORMANCE_TEST_H_
+
+#include <algorithm>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/geometry/mesh/delaunay_2d.h"
+#include "codelibrary/geometry/mesh/streaming_delaunay_2d.h"
+
+namespace cl {
+namespace test {
+
+class Delaunay2DPerformanceTest : public Test {
+protected:
+    /**
+     * Print the number of points per second.
+     */
+    static void PrintRate(const char* name, int n, Timer* timer,
+                          int max_vertices) {
+        printf("%20s %9d %12s %14.0f %13d\n", name, n,
+               timer->average_time(1).c_str(), n / timer->elapsed_seconds(),
+               max_vertices);
+    }
+};
+
+TEST_F(Delaunay2DPerformanceTest, PointsPerSecond) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    printf("\n");
+    printf("           Algorithm         n         Time  Points/second"
+           "  Max vertices\n");
+    printf("-------------------------------------------------------------"
+           "-------------\n");
+    for (int n : { 100000, 1000000 }) {
+        // A road-like strip of ground points, 100 times longer than wide.
+        Array<RPoint2D> points(n);
+        for (RPoint2D& p : points) {
+            p.x = uniform(random) * 1000.0;
+            p.y = uniform(random) * 10.0;
+        }
+
+        geometry::Delaunay2D<double> delaunay1;
+        Timer timer1;
+        timer1.Start();
+        delaunay1.Reset(points);
+        timer1.Stop();
+        PrintRate("Divide and conquer", n, &timer1, n);
+
+        geometry::Delaunay2D<double> delaunay2;
+        Timer timer2;
+        timer2.Start();
+        delaunay2.Insert(points);
+        timer2.Stop();
+        PrintRate("BRIO insertion", n, &timer2, n);
+
+        // The points arrive sorted by x, in slabs of 1000 points.
+        std::sort(points.begin(), points.end());
+        geometry::StreamingDelaunay2D<double> delaunay3;
+        Array<int> triangles;
+        int max_active = 0;
+        Timer timer3;
+        timer3.Start();
+        for (int i = 0; i < n; i += 1000) {
+            int end = std::min(i + 1000, n);
+            delaunay3.Insert(Array<RPoint2D>(points.begin() + i,
+                                             points.begin() + end));
+            max_active = std::max(max_active, delaunay3.n_active_vertices());
+            if (end < n) delaunay3.Sweep(points[end].x, &triangles);
+            triangles.clear();
+        }
+        delaunay3.Finish(&triangles);
+        timer3.Stop();
+        PrintRate("Streaming", n, &timer3, max_active);
+    }
+    printf("-------------------------------------------------------------"
+           "-------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_MESH_DELAUNAY_2D_PERFORMANCE_TEST_H_
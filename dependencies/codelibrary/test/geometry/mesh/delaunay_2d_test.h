@@ -11,6 +11,10 @@
 
 #include <random>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "codelibrary/base/testing.h"
 #include "codelibrary/geometry/angle.h"
 #include "codelibrary/geometry/mesh/delaunay_2d.h"
@@ -58,6 +62,45 @@ public:
         }
         return true;
     }
+
+    /**
+     * Check the empty circle property of each pair of adjacent triangles
+     * (O(N)). For a triangulation without constraints, it is equivalent to
+     * IsValid().
+     */
+    template <typename T>
+    bool IsLocallyValid(const geometry::Delaunay2D<T>& dt) {
+        int n_triangles = 0;
+        for (auto e : dt.mesh()) {
+            if (dt.is_outer(e)) continue;
+            if (e->next()->next()->next() != e) return false;
+            if (geometry::Orientation(e->source_point(), e->target_point(),
+                                      e->next()->target_point()) <= 0) {
+                return false;
+            }
+            ++n_triangles;
+
+            if (dt.is_outer(e->twin())) continue;
+            if (geometry::InCircle(e->source_point(), e->target_point(),
+                                   e->next()->target_point(),
+                                   e->twin()->next()->target_point()) > 0) {
+                return false;
+            }
+        }
+        return n_triangles % 3 == 0;
+    }
+
+    /**
+     * Return the number of triangles of the triangulation.
+     */
+    template <typename T>
+    int CountTriangles(const geometry::Delaunay2D<T>& dt) {
+        int n = 0;
+        for (auto e : dt.mesh()) {
+            if (!dt.is_outer(e)) ++n;
+        }
+        return n / 3;
+    }
 };
 
 TEST_F(Delaunay2DTest, EmptyInputPoints) {
@@ -167,6 +210,98 @@ TEST_F(Delaunay2DTest, RandomEraseVertices) {
     }
 }
 
+TEST_F(Delaunay2DTest, BatchInsert) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    Array<RPoint2D> points(1000);
+    for (RPoint2D& p : points) {
+        p.x = uniform(random);
+        p.y = uniform(random);
+    }
+    geometry::Delaunay2D<double> delaunay1(points);
+
+    // Insert into an empty and a non-empty triangulation.
+    geometry::Delaunay2D<double> delaunay2;
+    delaunay2.Insert(Array<RPoint2D>(points.begin(), points.begin() + 10));
+    delaunay2.Insert(Array<RPoint2D>(points.begin() + 10, points.end()));
+    ASSERT(IsValid(delaunay2));
+    ASSERT_EQ(delaunay1.mesh().n_vertices(), delaunay2.mesh().n_vertices());
+    ASSERT_EQ(CountTriangles(delaunay1), CountTriangles(delaunay2));
+}
+
+TEST_F(Delaunay2DTest, ParallelReset) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Also use integer points, which have many cocircular points.
+    Array<RPoint2D> points1(100000), points2(100000);
+    for (int i = 0; i < points1.size(); ++i) {
+        points1[i].x = uniform(random);
+        points1[i].y = uniform(random);
+        points2[i].x = static_cast<int>(uniform(random) * 500.0);
+        points2[i].y = static_cast<int>(uniform(random) * 200.0);
+    }
+
+    for (const Array<RPoint2D>* points : { &points1, &points2 }) {
+#ifdef _OPENMP
+        int n_threads = omp_get_max_threads();
+        omp_set_num_threads(1);
+#endif
+        geometry::Delaunay2D<double> delaunay1(*points);
+#ifdef _OPENMP
+        omp_set_num_threads(4);
+#endif
+        geometry::Delaunay2D<double> delaunay2(*points);
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#endif
+
+        ASSERT(IsLocallyValid(delaunay1));
+        ASSERT(IsLocallyValid(delaunay2));
+        ASSERT_EQ(delaunay1.mesh().n_vertices(),
+                  delaunay2.mesh().n_vertices());
+        ASSERT_EQ(CountTriangles(delaunay1), CountTriangles(delaunay2));
+    }
+}
+
+TEST_F(Delaunay2DTest, RoadBoundaryConstraints) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    Array<RPoint2D> points(2000);
+    for (RPoint2D& p : points) {
+        p.x = uniform(random);
+        p.y = uniform(random);
+    }
+    geometry::Delaunay2D<double> delaunay(points);
+
+    // Two curved road boundaries.
+    Array<Array<RPoint2D>> boundaries(2);
+    for (int i = 0; i <= 50; ++i) {
+        double x = i / 50.0;
+        double y = 0.1 * std::sin(x * 2.0 * M_PI);
+        boundaries[0].emplace_back(x, 0.4 + y);
+        boundaries[1].emplace_back(x, 0.6 + y);
+    }
+    for (const Array<RPoint2D>& boundary : boundaries) {
+        for (int i = 0; i + 1 < boundary.size(); ++i) {
+            ASSERT(delaunay.InsertEdge(boundary[i], boundary[i + 1]));
+        }
+    }
+
+    for (const Array<RPoint2D>& boundary : boundaries) {
+        for (int i = 0; i + 1 < boundary.size(); ++i) {
+            auto v1 = delaunay.Find(boundary[i]);
+            auto v2 = delaunay.Find(boundary[i + 1]);
+            ASSERT(v1 && v2);
+            auto e = delaunay.mesh().FindHalfedge(v1, v2);
+            ASSERT(e);
+            ASSERT(delaunay.is_constraint(e));
+        }
+    }
+}
+
 TEST_F(Delaunay2DTest, Performance100000) {
     std::mt19937 random;
 
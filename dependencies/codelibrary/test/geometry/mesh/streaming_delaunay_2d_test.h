@@ -0,0 +1,176 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_MESH_STREAMING_DELAUNAY_2D_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_MESH_STREAMING_DELAUNAY_2D_TEST_H_
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <tuple>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/mesh/delaunay_2d.h"
+#include "codelibrary/geometry/mesh/streaming_delaunay_2d.h"
+
+namespace cl {
+namespace test {
+
+class StreamingDelaunay2DTest : public Test {
+protected:
+    using Triple = std::tuple<int, int, int>;
+
+    /**
+     * Triangulate the points (sorted by x) in slabs of 'slab_size' points,
+     * and sweep to the first point of the next slab after each one.
+     *
+     * Return the maximal number of active triangles.
+     */
+    int Triangulate(const Array<RPoint2D>& points, int slab_size,
+                    Array<int>* triangles) const {
+        geometry::StreamingDelaunay2D<double> delaunay;
+        int max_active = 0;
+        for (int i = 0; i < points.size(); i += slab_size) {
+            int end = std::min(i + slab_size, points.size());
+            delaunay.Insert(Array<RPoint2D>(points.begin() + i,
+                                            points.begin() + end));
+            max_active = std::max(max_active, delaunay.n_active_triangles());
+            if (end < points.size()) {
+                delaunay.Sweep(points[end].x, triangles);
+            }
+        }
+        delaunay.Finish(triangles);
+        return max_active;
+    }
+
+    /**
+     * Rotate each CCW triangle to start from its minimal id, sort them and
+     * remove the duplicates.
+     */
+    static void Canonicalize(const Array<int>& triangles,
+                             Array<Triple>* triples) {
+        triples->clear();
+        for (int i = 0; i < triangles.size(); i += 3) {
+            int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+            if (b < a && b < c) {
+                triples->emplace_back(b, c, a);
+            } else if (c < a && c < b) {
+                triples->emplace_back(c, a, b);
+            } else {
+                triples->emplace_back(a, b, c);
+            }
+        }
+        std::sort(triples->begin(), triples->end());
+        triples->resize(std::unique(triples->begin(), triples->end()) -
+                        triples->begin());
+    }
+
+    static double Area(const Array<RPoint2D>& points,
+                       const Array<int>& triangles) {
+        double area = 0.0;
+        for (int i = 0; i < triangles.size(); i += 3) {
+            const RPoint2D& a = points[triangles[i]];
+            const RPoint2D& b = points[triangles[i + 1]];
+            const RPoint2D& c = points[triangles[i + 2]];
+            area += 0.5 * ((b.x - a.x) * (c.y - a.y) -
+                           (b.y - a.y) * (c.x - a.x));
+        }
+        return area;
+    }
+};
+
+TEST_F(StreamingDelaunay2DTest, RandomPoints) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // A long strip, sorted by x.
+    Array<RPoint2D> points(20000);
+    for (RPoint2D& p : points) {
+        p.x = uniform(random) * 100.0;
+        p.y = uniform(random);
+    }
+    std::sort(points.begin(), points.end());
+
+    Array<int> triangles;
+    int max_active = Triangulate(points, 100, &triangles);
+    ASSERT(max_active < points.size() / 10);
+
+    Array<Triple> triples1;
+    Canonicalize(triangles, &triples1);
+
+    // Compare with the triangulation in memory.
+    std::map<RPoint2D, int> ids;
+    for (int i = 0; i < points.size(); ++i) {
+        ids[points[i]] = i;
+    }
+    geometry::Delaunay2D<double> delaunay(points);
+    Array<int> triangles2;
+    for (auto e : delaunay.mesh()) {
+        if (delaunay.is_outer(e)) continue;
+
+        triangles2.push_back(ids[e->source_point()]);
+        triangles2.push_back(ids[e->target_point()]);
+        triangles2.push_back(ids[e->next()->target_point()]);
+    }
+    Array<Triple> triples2;
+    Canonicalize(triangles2, &triples2);
+
+    ASSERT_EQ(triples1.size() * 3, triangles.size());
+    ASSERT_EQ_RANGE(triples1.begin(), triples1.end(),
+                    triples2.begin(), triples2.end());
+}
+
+TEST_F(StreamingDelaunay2DTest, Grid) {
+    // Cocircular points with duplicates, row by row.
+    Array<RPoint2D> points;
+    for (int x = 0; x < 100; ++x) {
+        for (int y = 0; y < 10; ++y) {
+            points.emplace_back(x, y);
+        }
+        points.emplace_back(x, 0);
+    }
+
+    for (int slab_size : { 1, 7, 64 }) {
+        Array<int> triangles;
+        Triangulate(points, slab_size, &triangles);
+        ASSERT_EQ(triangles.size(), 3 * 2 * 99 * 9);
+        ASSERT_EQ(Area(points, triangles), 99.0 * 9.0);
+    }
+}
+
+TEST_F(StreamingDelaunay2DTest, DegenerateInputs) {
+    geometry::StreamingDelaunay2D<double> delaunay;
+    Array<int> triangles;
+
+    // Collinear points are pending until the first triangle.
+    for (int i = 0; i < 10; ++i) {
+        delaunay.Insert(RPoint2D(i, i));
+        delaunay.Insert(RPoint2D(i, i));
+    }
+    delaunay.Sweep(5.0, &triangles);
+    ASSERT(triangles.empty());
+    ASSERT_EQ(delaunay.n_active_triangles(), 0);
+
+    delaunay.Insert(RPoint2D(9.0, 0.0));
+    delaunay.Finish(&triangles);
+    ASSERT_EQ(triangles.size(), 3 * 9);
+    ASSERT(delaunay.n_points() == 0);
+
+    // Only collinear points.
+    triangles.clear();
+    for (int i = 0; i < 10; ++i) {
+        delaunay.Insert(RPoint2D(i, 0.0));
+    }
+    delaunay.Finish(&triangles);
+    ASSERT(triangles.empty());
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_MESH_STREAMING_DELAUNAY_2D_TEST_H_
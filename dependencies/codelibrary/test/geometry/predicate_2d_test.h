@@ -9,6 +9,9 @@
 #ifndef CODELIBRARY_TEST_GEOMETRY_PREDICATE_2D_TEST_H_
 #define CODELIBRARY_TEST_GEOMETRY_PREDICATE_2D_TEST_H_
 
+#include <cfenv>
+#include <cmath>
+
 #include "codelibrary/base/testing.h"
 #include "codelibrary/geometry/predicate_2d.h"
 
@@ -33,6 +36,62 @@ TEST(Predicate2DTest, InCircle) {
     ASSERT_EQ(geometry::InCircle(p5, p6, p7, p8), -1);
 }
 
+TEST(Predicate2DTest, DegenerateGrid) {
+    // Points of the grid 0.1 * (i, j) are nearly collinear and co-circular,
+    // since 0.1 is not representable.
+    Array<RPoint2D> points;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            points.emplace_back(0.1 * i, 0.1 * j);
+        }
+    }
+
+    geometry::ResetPredicateCounters();
+    for (int a = 0; a < points.size(); a += 3) {
+        for (int b = 1; b < points.size(); b += 5) {
+            for (int c = 2; c < points.size(); c += 7) {
+                const RPoint2D& p = points[a];
+                const RPoint2D& q = points[b];
+                const RPoint2D& r = points[c];
+                ExactFloat det = geometry::OrientationDeterminant(
+                            ExactFloat(p.x), ExactFloat(p.y),
+                            ExactFloat(q.x), ExactFloat(q.y),
+                            ExactFloat(r.x), ExactFloat(r.y));
+                ASSERT_EQ(geometry::Orientation(p, q, r), det.sign());
+
+                for (int d = 3; d < points.size(); d += 11) {
+                    const RPoint2D& t = points[d];
+                    ExactFloat det1 = geometry::IncircleDeterminant(
+                                ExactFloat(p.x), ExactFloat(p.y),
+                                ExactFloat(q.x), ExactFloat(q.y),
+                                ExactFloat(r.x), ExactFloat(r.y),
+                                ExactFloat(t.x), ExactFloat(t.y));
+                    const int sign = (p == t || q == t || r == t) ? 0
+                                                                  : det1.sign();
+                    ASSERT_EQ(geometry::InCircle(p, q, r, t), sign);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(std::fegetround(), FE_TONEAREST);
+
+    const geometry::PredicateCounter& orientation =
+            geometry::GetPredicateCounter(
+                geometry::PredicateType::kOrientation2D);
+    const geometry::PredicateCounter& in_circle =
+            geometry::GetPredicateCounter(geometry::PredicateType::kInCircle);
+    ASSERT(orientation.n_expansion > 0);
+    ASSERT(in_circle.n_expansion > 0);
+    ASSERT_EQ(orientation.n_exact, uint64_t(0));
+    ASSERT_EQ(in_circle.n_exact, uint64_t(0));
+
+    // Extreme exponents fall back to ExactFloat.
+    const double e = std::ldexp(1.0, -600);
+    ASSERT_EQ(geometry::Orientation(RPoint2D(0.0, 0.0), RPoint2D(e, e),
+                                    RPoint2D(3.0 * e, 3.0 * e)), 0);
+    ASSERT_EQ(orientation.n_exact, uint64_t(1));
+}
+
 } // namespace test
 } // namespace cl
 
@@ -0,0 +1,89 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_PREDICATE_3D_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_PREDICATE_3D_TEST_H_
+
+#include <cfenv>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/predicate_3d.h"
+
+namespace cl {
+namespace test {
+
+TEST(Predicate3DTest, Orientation) {
+    RPoint3D p(0.0, 0.0, 0.0), q(1.0, 0.0, 0.0), r(0.0, 1.0, 0.0);
+    ASSERT_EQ(geometry::Orientation(p, q, r, RPoint3D(0.0, 0.0, 1.0)), 1);
+    ASSERT_EQ(geometry::Orientation(p, q, r, RPoint3D(0.0, 0.0, -1.0)), -1);
+    ASSERT_EQ(geometry::Orientation(p, q, r, RPoint3D(5.0, 7.0, 0.0)), 0);
+
+    ASSERT_EQ(geometry::InShpere(p, q, r, RPoint3D(0.0, 0.0, 1.0),
+                                 RPoint3D(0.1, 0.1, 0.1)), 1);
+    ASSERT_EQ(geometry::InShpere(p, q, r, RPoint3D(0.0, 0.0, 1.0),
+                                 RPoint3D(2.0, 2.0, 2.0)), -1);
+    ASSERT_EQ(geometry::InShpere(p, q, r, RPoint3D(0.0, 0.0, 1.0),
+                                 RPoint3D(1.0, 1.0, 1.0)), 0);
+}
+
+TEST(Predicate3DTest, DegenerateGrid) {
+    // Points of the grid 0.1 * (i, j, k) are nearly coplanar and co-spherical,
+    // since 0.1 is not representable.
+    Array<RPoint3D> points;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                points.emplace_back(0.1 * i, 0.1 * j, 0.1 * k);
+            }
+        }
+    }
+
+    std::mt19937 random;
+    std::uniform_int_distribution<int> uniform(0, points.size() - 1);
+    geometry::ResetPredicateCounters();
+    for (int t = 0; t < 5000; ++t) {
+        const RPoint3D& p = points[uniform(random)];
+        const RPoint3D& q = points[uniform(random)];
+        const RPoint3D& r = points[uniform(random)];
+        const RPoint3D& s = points[uniform(random)];
+        const RPoint3D& u = points[uniform(random)];
+
+        ExactFloat det1 = geometry::OrientationDeterminant(
+                    ExactFloat(p.x), ExactFloat(p.y), ExactFloat(p.z),
+                    ExactFloat(q.x), ExactFloat(q.y), ExactFloat(q.z),
+                    ExactFloat(r.x), ExactFloat(r.y), ExactFloat(r.z),
+                    ExactFloat(s.x), ExactFloat(s.y), ExactFloat(s.z));
+        ASSERT_EQ(geometry::Orientation(p, q, r, s), det1.sign());
+
+        ExactFloat det2 = geometry::InSphereDeterminant(
+                    ExactFloat(p.x), ExactFloat(p.y), ExactFloat(p.z),
+                    ExactFloat(q.x), ExactFloat(q.y), ExactFloat(q.z),
+                    ExactFloat(r.x), ExactFloat(r.y), ExactFloat(r.z),
+                    ExactFloat(s.x), ExactFloat(s.y), ExactFloat(s.z),
+                    ExactFloat(u.x), ExactFloat(u.y), ExactFloat(u.z));
+        ASSERT_EQ(geometry::InShpere(p, q, r, s, u), det2.sign());
+    }
+    ASSERT_EQ(std::fegetround(), FE_TONEAREST);
+
+    const geometry::PredicateCounter& orientation =
+            geometry::GetPredicateCounter(
+                geometry::PredicateType::kOrientation3D);
+    const geometry::PredicateCounter& in_sphere =
+            geometry::GetPredicateCounter(geometry::PredicateType::kInSphere);
+    ASSERT_EQ(orientation.n_calls, uint64_t(5000));
+    ASSERT_EQ(in_sphere.n_calls, uint64_t(5000));
+    ASSERT(orientation.n_expansion > 0);
+    ASSERT(in_sphere.n_expansion > 0);
+    ASSERT_EQ(orientation.n_exact + in_sphere.n_exact, uint64_t(0));
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_PREDICATE_3D_TEST_H_
@@ -0,0 +1,244 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_PREDICATE_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_PREDICATE_PERFORMANCE_TEST_H_
+
+#include <random>
+#include <string>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/geometry/predicate_2d.h"
+#include "codelibrary/geometry/predicate_3d.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the filtered predicates on random and degenerate grid points.
+ *
+ * The reference evaluates the determinants by ExactFloat, which was the stage
+ * after the interval filter before FloatExpansion.
+ */
+class PredicatePerformanceTest : public Test {
+protected:
+    static const int N_QUERIES = 200000;
+
+    /**
+     * Generate the points of a n x n x n grid with the given spacing, and
+     * random indices of the queries.
+     */
+    static void Grid(int n, double spacing, Array<RPoint3D>* points,
+                     Array<int>* queries) {
+        points->clear();
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                for (int k = 0; k < n; ++k) {
+                    points->emplace_back(spacing * i, spacing * j,
+                                         spacing * k);
+                }
+            }
+        }
+
+        std::mt19937 random;
+        std::uniform_int_distribution<int> uniform(0, points->size() - 1);
+        queries->resize(5 * N_QUERIES);
+        for (int& q : *queries) {
+            q = uniform(random);
+        }
+    }
+
+    /**
+     * Generate random points in the unit cube.
+     */
+    static void RandomPoints(Array<RPoint3D>* points, Array<int>* queries) {
+        std::mt19937 random;
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        points->resize(5 * N_QUERIES);
+        queries->resize(5 * N_QUERIES);
+        for (int i = 0; i < points->size(); ++i) {
+            (*points)[i] = RPoint3D(uniform(random), uniform(random),
+                                    uniform(random));
+            (*queries)[i] = i;
+        }
+    }
+
+    /**
+     * Return the average time of 'f' over 'n' runs.
+     */
+    template <typename Function>
+    static std::string Time(int n, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return timer.average_time(n);
+    }
+
+    /**
+     * Print the time of the four predicates on the given queries.
+     */
+    void Run(const char* name, const Array<RPoint3D>& points,
+             const Array<int>& queries) {
+        using geometry::GetPredicateCounter;
+        using geometry::PredicateType;
+
+        auto point2 = [&](int i) {
+            const RPoint3D& p = points[queries[i]];
+            return RPoint2D(p.x, p.y);
+        };
+        auto point3 = [&](int i) -> const RPoint3D& {
+            return points[queries[i]];
+        };
+
+        geometry::ResetPredicateCounters();
+        printf("%s\n", name);
+        {
+            std::string t1 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    RPoint2D p = point2(5 * i), q = point2(5 * i + 1),
+                             r = point2(5 * i + 2);
+                    sink_ += geometry::OrientationDeterminant(
+                                ExactFloat(p.x), ExactFloat(p.y),
+                                ExactFloat(q.x), ExactFloat(q.y),
+                                ExactFloat(r.x), ExactFloat(r.y)).sign();
+                }
+            });
+            std::string t2 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    sink_ += geometry::Orientation(point2(5 * i),
+                                                   point2(5 * i + 1),
+                                                   point2(5 * i + 2));
+                }
+            });
+            Print("  Orientation 2D", t1, t2,
+                  GetPredicateCounter(PredicateType::kOrientation2D));
+        }
+        {
+            std::string t1 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    RPoint2D p = point2(5 * i), q = point2(5 * i + 1),
+                             r = point2(5 * i + 2), s = point2(5 * i + 3);
+                    sink_ += geometry::IncircleDeterminant(
+                                ExactFloat(p.x), ExactFloat(p.y),
+                                ExactFloat(q.x), ExactFloat(q.y),
+                                ExactFloat(r.x), ExactFloat(r.y),
+                                ExactFloat(s.x), ExactFloat(s.y)).sign();
+                }
+            });
+            std::string t2 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    sink_ += geometry::InCircle(point2(5 * i),
+                                                point2(5 * i + 1),
+                                                point2(5 * i + 2),
+                                                point2(5 * i + 3));
+                }
+            });
+            Print("  InCircle", t1, t2,
+                  GetPredicateCounter(PredicateType::kInCircle));
+        }
+        {
+            std::string t1 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    const RPoint3D& p = point3(5 * i);
+                    const RPoint3D& q = point3(5 * i + 1);
+                    const RPoint3D& r = point3(5 * i + 2);
+                    const RPoint3D& s = point3(5 * i + 3);
+                    sink_ += geometry::OrientationDeterminant(
+                                ExactFloat(p.x), ExactFloat(p.y),
+                                ExactFloat(p.z), ExactFloat(q.x),
+                                ExactFloat(q.y), ExactFloat(q.z),
+                                ExactFloat(r.x), ExactFloat(r.y),
+                                ExactFloat(r.z), ExactFloat(s.x),
+                                ExactFloat(s.y), ExactFloat(s.z)).sign();
+                }
+            });
+            std::string t2 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    sink_ += geometry::Orientation(point3(5 * i),
+                                                   point3(5 * i + 1),
+                                                   point3(5 * i + 2),
+                                                   point3(5 * i + 3));
+                }
+            });
+            Print("  Orientation 3D", t1, t2,
+                  GetPredicateCounter(PredicateType::kOrientation3D));
+        }
+        {
+            std::string t1 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    const RPoint3D& p = point3(5 * i);
+                    const RPoint3D& q = point3(5 * i + 1);
+                    const RPoint3D& r = point3(5 * i + 2);
+                    const RPoint3D& s = point3(5 * i + 3);
+                    const RPoint3D& t = point3(5 * i + 4);
+                    sink_ += geometry::InSphereDeterminant(
+                                ExactFloat(p.x), ExactFloat(p.y),
+                                ExactFloat(p.z), ExactFloat(q.x),
+                                ExactFloat(q.y), ExactFloat(q.z),
+                                ExactFloat(r.x), ExactFloat(r.y),
+                                ExactFloat(r.z), ExactFloat(s.x),
+                                ExactFloat(s.y), ExactFloat(s.z),
+                                ExactFloat(t.x), ExactFloat(t.y),
+                                ExactFloat(t.z)).sign();
+                }
+            });
+            std::string t2 = Time(1, [&]() {
+                for (int i = 0; i < N_QUERIES; ++i) {
+                    sink_ += geometry::InShpere(point3(5 * i),
+                                                point3(5 * i + 1),
+                                                point3(5 * i + 2),
+                                                point3(5 * i + 3),
+                                                point3(5 * i + 4));
+                }
+            });
+            Print("  InSphere", t1, t2,
+                  GetPredicateCounter(PredicateType::kInSphere));
+        }
+    }
+
+    static void Print(const char* name, const std::string& t1,
+                      const std::string& t2,
+                      const geometry::PredicateCounter& counter) {
+        printf("%-16s %9s %9s %9.2f%% %9.2f%% %9.2f%%\n", name, t1.c_str(),
+               t2.c_str(), 100.0 * counter.static_hit_rate(),
+               100.0 * counter.interval_hit_rate(),
+               100.0 * counter.n_expansion / counter.n_calls);
+    }
+
+    // Prevents the compiler from dropping the measured work.
+    int64_t sink_ = 0;
+};
+
+TEST_F(PredicatePerformanceTest, Filters) {
+    Array<RPoint3D> points;
+    Array<int> queries;
+
+    printf("\n");
+    printf("%-16s %9s %9s %10s %10s %10s\n", "2x10^5 queries", "Exact",
+           "Filtered", "Static", "Interval", "Expansion");
+    printf("---------------------------------------------------------------"
+           "--------\n");
+    RandomPoints(&points, &queries);
+    Run("Random points", points, queries);
+    Grid(8, 1.0, &points, &queries);
+    Run("Integer grid 8^3", points, queries);
+    Grid(8, 0.1, &points, &queries);
+    Run("Grid 8^3, spacing 0.1", points, queries);
+    printf("---------------------------------------------------------------"
+           "--------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_PREDICATE_PERFORMANCE_TEST_H_
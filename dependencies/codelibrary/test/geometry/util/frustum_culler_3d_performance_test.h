@@ -0,0 +1,131 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_PERFORMANCE_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/geometry/util/frustum_culler_3d.h"
+
+namespace cl {
+namespace test {
+
+class FrustumCuller3DPerformanceTest : public Test {
+protected:
+    using Tree = AABBTree<float, int>;
+    using Culler = geometry::FrustumCuller3D<float, int>;
+
+    /**
+     * Perspective frustum at 'position' looking at the direction 'yaw',
+     * with 60 degrees vertical field of view.
+     */
+    static FFrustum3D MakeFrustum(const FPoint3D& position, float yaw) {
+        FVector3D direction(std::cos(yaw), std::sin(yaw), -0.2f);
+        FVector3D right = Normalize(CrossProduct(direction,
+                                                 FVector3D(0.0f, 0.0f, 1.0f)));
+        FVector3D up = Normalize(CrossProduct(right, direction));
+        direction = Normalize(direction);
+
+        float tan_fov = std::tan(static_cast<float>(M_PI) / 6.0f);
+        Array<FPoint3D> vertices;
+        for (float z : { 0.1f, 500.0f }) {
+            FPoint3D c = position + direction * z;
+            float h = tan_fov * z, w = h * 16.0f / 9.0f;
+            vertices.push_back(c - right * w - up * h);
+            vertices.push_back(c + right * w - up * h);
+            vertices.push_back(c + right * w + up * h);
+            vertices.push_back(c - right * w + up * h);
+        }
+        return FFrustum3D(vertices);
+    }
+};
+
+TEST_F(FrustumCuller3DPerformanceTest, CityFlyThrough) {
+    const int n = 100000;
+    const int n_frames = 200;
+    std::mt19937 random;
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    // Blocks, camera paths and point-cloud chunks of a 5km x 5km city.
+    Array<FBox3D> boxes(n);
+    for (FBox3D& box : boxes) {
+        float x = uniform(random) * 5000.0f, y = uniform(random) * 5000.0f;
+        float size = 1.0f + uniform(random) * 20.0f;
+        box = FBox3D(x, x + size, y, y + size, 0.0f,
+                     1.0f + uniform(random) * 60.0f);
+    }
+
+    Timer build_timer;
+    build_timer.Start();
+    Tree tree(1.0f);
+    Array<int> ids(n);
+    for (int i = 0; i < n; ++i) {
+        ids[i] = tree.Insert(boxes[i], i);
+    }
+    build_timer.Stop();
+
+    Timer linear_timer, bvh_timer, update_timer;
+    Culler culler;
+    Array<int> values;
+    long long n_visible = 0, n_visited = 0;
+    for (int frame = 0; frame < n_frames; ++frame) {
+        // The camera flies along the diagonal and turns around.
+        float t = 500.0f + 20.0f * frame;
+        FFrustum3D frustum = MakeFrustum(FPoint3D(t, t, 80.0f),
+                                         0.05f * frame);
+
+        linear_timer.Start();
+        int n_linear = 0;
+        for (const FBox3D& box : boxes) {
+            if (frustum.Classify(box) != FFrustum3D::OUTSIDE) ++n_linear;
+        }
+        linear_timer.Stop();
+
+        // 1% of the nodes move.
+        update_timer.Start();
+        for (int i = frame % 100; i < n; i += 100) {
+            const FBox3D& b = boxes[i];
+            float dx = uniform(random) - 0.5f;
+            boxes[i] = FBox3D(b.x_min() + dx, b.x_max() + dx, b.y_min(),
+                              b.y_max(), b.z_min(), b.z_max());
+            tree.Update(ids[i], boxes[i]);
+        }
+        update_timer.Stop();
+
+        bvh_timer.Start();
+        culler.Cull(tree, frustum, &values);
+        bvh_timer.Stop();
+        n_visible += values.size();
+        n_visited += culler.n_visited_nodes();
+        ASSERT(values.size() >= n_linear - n / 100);
+    }
+
+    printf("\n");
+    printf("      Nodes  Build  Linear/frame  BVH/frame  Update/frame  "
+           "Visible  Visited\n");
+    printf("----------------------------------------------------------------"
+           "-------------\n");
+    printf("%11d %6s %13s %10s %13s %8lld %8lld\n", n,
+           build_timer.average_time(1).c_str(),
+           linear_timer.average_time(n_frames).c_str(),
+           bvh_timer.average_time(n_frames).c_str(),
+           update_timer.average_time(n_frames).c_str(),
+           n_visible / n_frames, n_visited / n_frames);
+    printf("----------------------------------------------------------------"
+           "-------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_PERFORMANCE_TEST_H_
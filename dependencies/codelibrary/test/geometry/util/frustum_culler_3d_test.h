@@ -0,0 +1,181 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_TEST_H_
+#define CODELIBRARY_TEST_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/util/frustum_culler_3d.h"
+
+namespace cl {
+namespace test {
+
+class FrustumCuller3DTest : public Test {
+protected:
+    using Tree = AABBTree<double, int>;
+    using Culler = geometry::FrustumCuller3D<double, int>;
+
+    /**
+     * Perspective frustum as gl::Camera::GetFrustum(), looking at the
+     * direction given by 'yaw' and 'pitch', with the z axis up.
+     */
+    static RFrustum3D MakeFrustum(const RPoint3D& position, double yaw,
+                                  double pitch, double z_near = 0.1,
+                                  double z_far = 300.0) {
+        RVector3D direction(std::cos(pitch) * std::cos(yaw),
+                            std::cos(pitch) * std::sin(yaw),
+                            std::sin(pitch));
+        RVector3D right = Normalize(CrossProduct(direction,
+                                                 RVector3D(0.0, 0.0, 1.0)));
+        RVector3D up = CrossProduct(right, direction);
+
+        // 60 degrees vertical field of view, 16:9.
+        double tan_fov = std::tan(M_PI / 6.0), aspect = 16.0 / 9.0;
+        Array<RPoint3D> vertices;
+        for (double z : { z_near, z_far }) {
+            RPoint3D c = position + direction * z;
+            double h = tan_fov * z, w = h * aspect;
+            vertices.push_back(c - right * w - up * h);
+            vertices.push_back(c + right * w - up * h);
+            vertices.push_back(c + right * w + up * h);
+            vertices.push_back(c - right * w + up * h);
+        }
+        return RFrustum3D(vertices);
+    }
+
+    /**
+     * Random boxes of a city: buildings in [0, 1000]^2 x [0, 50].
+     */
+    Array<RBox3D> RandomCity(int n) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        Array<RBox3D> boxes(n);
+        for (RBox3D& box : boxes) {
+            double x = uniform(random_) * 1000.0;
+            double y = uniform(random_) * 1000.0;
+            double size = 1.0 + uniform(random_) * 10.0;
+            box = RBox3D(x, x + size, y, y + size, 0.0,
+                         uniform(random_) * 50.0 + 1.0);
+        }
+        return boxes;
+    }
+
+    /**
+     * The objects that are not outside of the frustum, by linear tests.
+     */
+    static void LinearCull(const RFrustum3D& frustum,
+                           const Array<RBox3D>& boxes, Array<int>* values) {
+        values->clear();
+        for (int i = 0; i < boxes.size(); ++i) {
+            if (frustum.Classify(boxes[i]) != RFrustum3D::OUTSIDE) {
+                values->push_back(i);
+            }
+        }
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(FrustumCuller3DTest, Classify) {
+    RFrustum3D frustum = MakeFrustum(RPoint3D(0.0, 0.0, 0.0), 0.0, 0.0, 1.0,
+                                     100.0);
+    ASSERT(frustum.Contains(RPoint3D(50.0, 0.0, 0.0)));
+    ASSERT(!frustum.Contains(RPoint3D(-1.0, 0.0, 0.0)));
+    ASSERT(!frustum.Contains(RPoint3D(101.0, 0.0, 0.0)));
+    ASSERT(!frustum.Contains(RPoint3D(50.0, 0.0, 40.0)));
+
+    RBox3D inside(10.0, 11.0, -1.0, 1.0, -1.0, 1.0);
+    RBox3D behind(-10.0, -5.0, -1.0, 1.0, -1.0, 1.0);
+    RBox3D crossing(50.0, 150.0, -1.0, 1.0, -1.0, 1.0);
+    ASSERT_EQ(frustum.Classify(inside), RFrustum3D::INSIDE);
+    ASSERT_EQ(frustum.Classify(behind), RFrustum3D::OUTSIDE);
+    ASSERT_EQ(frustum.Classify(crossing), RFrustum3D::INTERSECT);
+
+    // Masks skip the planes, and the culling plane is returned.
+    int mask = 0, plane = 0;
+    ASSERT_EQ(frustum.Classify(crossing, &mask, &plane),
+              RFrustum3D::INTERSECT);
+    ASSERT_EQ(mask, RFrustum3D::INSIDE_MASK & ~(1 << 1));
+    ASSERT_EQ(frustum.Classify(inside, &mask), RFrustum3D::INSIDE);
+    ASSERT_EQ(frustum.Classify(behind, nullptr, &plane),
+              RFrustum3D::OUTSIDE);
+    ASSERT_EQ(plane, 0);
+}
+
+TEST_F(FrustumCuller3DTest, MovingCamera) {
+    Array<RBox3D> boxes = RandomCity(5000);
+    Tree tree(1.0);
+    Array<int> ids(boxes.size());
+    for (int i = 0; i < boxes.size(); ++i) {
+        ids[i] = tree.Insert(boxes[i], i);
+    }
+
+    std::uniform_real_distribution<double> uniform(-2.0, 2.0);
+    Culler culler;
+    for (int frame = 0; frame < 30; ++frame) {
+        // Some objects move.
+        for (int i = frame; i < boxes.size(); i += 10) {
+            double dx = uniform(random_), dy = uniform(random_);
+            const RBox3D& b = boxes[i];
+            boxes[i] = RBox3D(b.x_min() + dx, b.x_max() + dx,
+                              b.y_min() + dy, b.y_max() + dy,
+                              b.z_min(), b.z_max());
+            tree.Update(ids[i], boxes[i]);
+        }
+
+        RFrustum3D frustum = MakeFrustum(RPoint3D(500.0, 500.0, 20.0),
+                                         frame * 0.2, -0.1);
+        Array<int> values1, values2;
+        culler.Cull(tree, frustum, &values1);
+        std::sort(values1.begin(), values1.end());
+        LinearCull(frustum, boxes, &values2);
+        ASSERT(!values2.empty());
+        ASSERT_EQ_RANGE(values1.begin(), values1.end(),
+                        values2.begin(), values2.end());
+        ASSERT(culler.n_visited_nodes() < 2 * tree.capacity());
+    }
+}
+
+TEST_F(FrustumCuller3DTest, Occlusion) {
+    Array<RBox3D> boxes = RandomCity(2000);
+    Tree tree;
+    for (int i = 0; i < boxes.size(); ++i) {
+        tree.Insert(boxes[i], i);
+    }
+
+    // Everything behind the wall x = 600 is occluded.
+    auto occluded = [](const RBox3D& box) {
+        return box.x_min() > 600.0;
+    };
+    RFrustum3D frustum = MakeFrustum(RPoint3D(-10.0, 500.0, 20.0), 0.0, 0.0,
+                                     0.1, 2000.0);
+    Culler culler;
+    Array<int> values1, values2;
+    culler.Cull(tree, frustum, occluded, &values1);
+    std::sort(values1.begin(), values1.end());
+    LinearCull(frustum, boxes, &values2);
+
+    // The culling is conservative: the subtrees inside the frustum are not
+    // tested for occlusion. But no visible object is culled.
+    ASSERT(values1.size() < values2.size());
+    ASSERT(std::includes(values2.begin(), values2.end(),
+                         values1.begin(), values1.end()));
+    for (int i : values2) {
+        if (!occluded(boxes[i])) {
+            ASSERT(std::binary_search(values1.begin(), values1.end(), i));
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GEOMETRY_UTIL_FRUSTUM_CULLER_3D_TEST_H_
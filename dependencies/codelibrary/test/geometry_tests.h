@@ -12,10 +12,19 @@
 #define CODELIBRARY_TEST_GEOMETRY_TESTS_H_
 
 #include "codelibrary/test/geometry/envelope/convex_hull_2d_test.h"
+#include "codelibrary/test/geometry/envelope/convex_hull_3d_performance_test.h"
+#include "codelibrary/test/geometry/envelope/convex_hull_3d_test.h"
 #include "codelibrary/test/geometry/intersect_3d_test.h"
+#include "codelibrary/test/geometry/mesh/block_mesh_stitcher_test.h"
+#include "codelibrary/test/geometry/mesh/delaunay_2d_performance_test.h"
 #include "codelibrary/test/geometry/mesh/delaunay_2d_test.h"
 #include "codelibrary/test/geometry/mesh/halfedge_list_test.h"
+#include "codelibrary/test/geometry/mesh/streaming_delaunay_2d_test.h"
 #include "codelibrary/test/geometry/predicate_2d_test.h"
+#include "codelibrary/test/geometry/predicate_3d_test.h"
+#include "codelibrary/test/geometry/predicate_performance_test.h"
+#include "codelibrary/test/geometry/util/frustum_culler_3d_performance_test.h"
+#include "codelibrary/test/geometry/util/frustum_culler_3d_test.h"
 
 #endif // CODELIBRARY_TEST_GEOMETRY_TESTS_H_
 
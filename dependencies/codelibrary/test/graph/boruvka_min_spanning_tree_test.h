@@ -0,0 +1,91 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GRAPH_BORUVKA_MIN_SPANNING_TREE_TEST_H_
+#define CODELIBRARY_TEST_GRAPH_BORUVKA_MIN_SPANNING_TREE_TEST_H_
+
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/graph/boruvka_min_spanning_tree.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/graph/kruskal_min_spanning_tree.h"
+#include "codelibrary/util/set/disjoint_set.h"
+
+namespace cl {
+namespace test {
+
+TEST(BoruvkaMinSpanningTreeTest, Test) {
+    Array<std::pair<int, int>> edges = { {1, 2}, {1, 3}, {2, 3}, {4, 3} };
+    Array<int> costs = {4, 9, 2, 1};
+    CSRGraph graph(5, edges);
+    Array<int> weight(graph.n_arcs());
+    for (int i = 0; i < edges.size(); ++i) {
+        int a = graph.edge_arc(i);
+        weight[a] = weight[graph.twin(a)] = costs[i];
+    }
+
+    Array<int> mst_arcs;
+    int sum = graph::BoruvkaMinSpanningTree(graph, weight, &mst_arcs);
+    ASSERT_EQ(sum, 7);
+    ASSERT_EQ(mst_arcs.size(), 3);
+}
+
+TEST(BoruvkaMinSpanningTreeTest, CompareWithKruskal) {
+    const int n = 3000, m = 10000;
+
+    std::mt19937 random;
+    std::uniform_int_distribution<int> uniform_v(0, n - 1);
+
+    // Few distinct weights, to test the tie-breaking.
+    for (int max_weight : {5, 1000000}) {
+        std::uniform_int_distribution<int> uniform_w(1, max_weight);
+
+        Graph graph(n);
+        Graph::EdgeProperty<int64_t> weight =
+                graph.AddEdgeProperty<int64_t>("weight");
+        for (int i = 0; i < m; ++i) {
+            Graph::Edge* e = graph.InsertTwoWayEdge(uniform_v(random),
+                                                    uniform_v(random));
+            weight[e] = weight[e->twin()] = uniform_w(random);
+        }
+
+        CSRGraph csr(graph);
+        Array<int64_t> arc_weight;
+        csr.GetArcProperty(graph, weight, &arc_weight);
+
+        Array<int> mst_arcs;
+        int64_t sum1 = graph::KruskalMinSpanningTree(graph, weight);
+        int64_t sum2 = graph::BoruvkaMinSpanningTree(csr, arc_weight,
+                                                     &mst_arcs);
+        ASSERT_EQ(sum1, sum2);
+
+        // The arcs form a forest with the same components as the graph.
+        DisjointSet forest(n);
+        int64_t sum3 = 0;
+        for (int a : mst_arcs) {
+            int u = csr.target(csr.twin(a)), v = csr.target(a);
+            ASSERT(forest.Find(u) != forest.Find(v));
+            forest.Union(u, v);
+            sum3 += arc_weight[a];
+        }
+        ASSERT_EQ(sum2, sum3);
+        for (int v = 0; v < n; ++v) {
+            csr.ForEachArc(v, [&](int a, int w, int t) {
+                (void)a;
+                (void)t;
+                ASSERT(forest.Find(v) == forest.Find(w));
+            });
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GRAPH_BORUVKA_MIN_SPANNING_TREE_TEST_H_
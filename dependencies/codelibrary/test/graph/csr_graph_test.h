@@ -0,0 +1,129 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GRAPH_CSR_GRAPH_TEST_H_
+#define CODELIBRARY_TEST_GRAPH_CSR_GRAPH_TEST_H_
+
+#include <set>
+#include <utility>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/graph/grid_graph.h"
+
+namespace cl {
+namespace test {
+
+TEST(CSRGraphTest, FromEdges) {
+    Array<std::pair<int, int>> edges = { {0, 1}, {1, 2}, {0, 2}, {3, 0} };
+    CSRGraph graph(4, edges);
+
+    ASSERT_EQ(graph.n_vertices(), 4);
+    ASSERT_EQ(graph.n_arcs(), 8);
+    ASSERT_EQ(graph.degree(0), 3);
+    ASSERT_EQ(graph.degree(3), 1);
+
+    for (int i = 0; i < edges.size(); ++i) {
+        int a = graph.edge_arc(i);
+        ASSERT_EQ(graph.target(a), edges[i].second);
+        ASSERT_EQ(graph.target(graph.twin(a)), edges[i].first);
+        ASSERT_EQ(graph.twin(graph.twin(a)), a);
+        ASSERT(a >= graph.arcs_begin(edges[i].first));
+        ASSERT(a < graph.arcs_end(edges[i].first));
+    }
+
+    std::set<int> neighbors;
+    graph.ForEachArc(0, [&](int a, int w, int t) {
+        ASSERT_EQ(graph.twin(a), t);
+        neighbors.insert(w);
+    });
+    ASSERT(neighbors == std::set<int>({1, 2, 3}));
+}
+
+TEST(CSRGraphTest, FromGraph) {
+    Graph graph(4);
+    Graph::Edge* e1 = graph.InsertTwoWayEdge(0, 1);
+    Graph::Edge* e2 = graph.InsertOneWayEdge(2, 3);
+    Graph::Edge* e3 = graph.InsertTwoWayEdge(1, 3);
+    Graph::EdgeProperty<int> weight = graph.AddEdgeProperty<int>("weight");
+    weight[e1] = 1;
+    weight[e1->twin()] = 2;
+    weight[e2] = 3;
+    weight[e3] = 4;
+    weight[e3->twin()] = 5;
+
+    CSRGraph csr(graph);
+    ASSERT_EQ(csr.n_arcs(), 5);
+
+    Array<int> arc_weight;
+    csr.GetArcProperty(graph, weight, &arc_weight);
+    for (int v = 0; v < 4; ++v) {
+        for (const Graph::Edge* e : graph.edges_from(v)) {
+            int a = csr.edge_arc(e->id());
+            ASSERT_EQ(csr.target(a), e->target());
+            ASSERT_EQ(arc_weight[a], weight[e]);
+            if (e->twin()) {
+                ASSERT_EQ(csr.twin(a), csr.edge_arc(e->twin()->id()));
+            } else {
+                ASSERT_EQ(csr.twin(a), -1);
+            }
+        }
+    }
+}
+
+TEST(GridGraphTest, Neighborhoods) {
+    const int sizes[4][3] = { {5, 4, 1}, {5, 4, 1}, {4, 3, 5}, {4, 3, 5} };
+    const int n_neighbors[4] = { 4, 8, 6, 26 };
+
+    for (int i = 0; i < 4; ++i) {
+        const int nx = sizes[i][0], ny = sizes[i][1], nz = sizes[i][2];
+        GridGraph grid(nx, ny, nz, n_neighbors[i]);
+        ASSERT_EQ(grid.n_vertices(), nx * ny * nz);
+        ASSERT_EQ(grid.n_arcs(), nx * ny * nz * n_neighbors[i]);
+
+        for (int z = 0; z < nz; ++z) {
+            for (int y = 0; y < ny; ++y) {
+                for (int x = 0; x < nx; ++x) {
+                    // Count the expected neighbors by brute force.
+                    int expected = 0;
+                    for (int k = 0; k < grid.n_neighbors(); ++k) {
+                        int dx, dy, dz;
+                        grid.neighbor_offset(k, &dx, &dy, &dz);
+                        if (x + dx >= 0 && x + dx < nx &&
+                            y + dy >= 0 && y + dy < ny &&
+                            z + dz >= 0 && z + dz < nz) {
+                            ++expected;
+                        }
+                    }
+
+                    int v = grid.vertex(x, y, z);
+                    int count = 0;
+                    grid.ForEachArc(v, [&](int a, int w, int t) {
+                        ++count;
+                        int k = a - grid.arc(v, 0);
+                        int dx, dy, dz;
+                        grid.neighbor_offset(k, &dx, &dy, &dz);
+                        ASSERT_EQ(w, grid.vertex(x + dx, y + dy, z + dz));
+
+                        // The twin leads back from w to v.
+                        int k2 = t - grid.arc(w, 0);
+                        int dx2, dy2, dz2;
+                        grid.neighbor_offset(k2, &dx2, &dy2, &dz2);
+                        ASSERT(dx2 == -dx && dy2 == -dy && dz2 == -dz);
+                    });
+                    ASSERT_EQ(count, expected);
+                }
+            }
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GRAPH_CSR_GRAPH_TEST_H_
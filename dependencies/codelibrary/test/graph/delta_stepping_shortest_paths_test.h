@@ -0,0 +1,98 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GRAPH_DELTA_STEPPING_SHORTEST_PATHS_TEST_H_
+#define CODELIBRARY_TEST_GRAPH_DELTA_STEPPING_SHORTEST_PATHS_TEST_H_
+
+#include <limits>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/graph/delta_stepping_shortest_paths.h"
+#include "codelibrary/graph/dijkstra_shortest_paths.h"
+
+namespace cl {
+namespace test {
+
+TEST(DeltaSteppingShortestPathsTest, Test) {
+    Array<std::pair<int, int>> edges = { {0, 1}, {0, 2}, {1, 2}, {2, 3},
+                                         {1, 3} };
+    Array<int> costs = {3, 1, 1, 2, 1};
+    CSRGraph graph(5, edges);
+    Array<int> weight(graph.n_arcs());
+    for (int i = 0; i < edges.size(); ++i) {
+        int a = graph.edge_arc(i);
+        weight[a] = weight[graph.twin(a)] = costs[i];
+    }
+
+    Array<int> predecessors, distances;
+    graph::DeltaSteppingShortestPaths<int> shortest_paths(2);
+    shortest_paths(graph, weight, 0, &predecessors, &distances);
+
+    ASSERT_EQ(distances[0], 0);
+    ASSERT_EQ(distances[1], 2);
+    ASSERT_EQ(distances[2], 1);
+    ASSERT_EQ(distances[3], 3);
+    ASSERT_EQ(distances[4], std::numeric_limits<int>::max());
+    ASSERT_EQ(predecessors[1], 2);
+    ASSERT(predecessors[3] == 1 || predecessors[3] == 2);
+    ASSERT_EQ(predecessors[4], -1);
+}
+
+TEST(DeltaSteppingShortestPathsTest, CompareWithDijkstra) {
+    const int n = 3000, m = 12000;
+
+    std::mt19937 random;
+    std::uniform_int_distribution<int> uniform_v(0, n - 1);
+    std::uniform_real_distribution<double> uniform_w(0.0, 1.0);
+
+    Graph graph(n);
+    Graph::EdgeProperty<double> weight =
+            graph.AddEdgeProperty<double>("weight");
+    for (int i = 0; i < m; ++i) {
+        Graph::Edge* e = graph.InsertTwoWayEdge(uniform_v(random),
+                                                uniform_v(random));
+        weight[e] = uniform_w(random);
+        weight[e->twin()] = uniform_w(random);
+    }
+
+    CSRGraph csr(graph);
+    Array<double> arc_weight;
+    csr.GetArcProperty(graph, weight, &arc_weight);
+
+    Array<int> predecessors1;
+    Array<double> distances1;
+    graph::DijkstraShortestPaths(graph, weight, 5, &predecessors1,
+                                 &distances1);
+
+    // Automatic, tiny and huge bucket widths.
+    for (double delta : {0.0, 0.001, 0.1, 10.0}) {
+        graph::DeltaSteppingShortestPaths<double> shortest_paths(delta);
+        Array<int> predecessors2;
+        Array<double> distances2;
+        shortest_paths(csr, arc_weight, 5, &predecessors2, &distances2);
+
+        for (int v = 0; v < n; ++v) {
+            if (v != 5 && predecessors1[v] == -1) {
+                ASSERT_EQ(predecessors2[v], -1);
+                continue;
+            }
+            ASSERT_EQ_NEAR(distances1[v], distances2[v], 1e-9);
+
+            // The predecessor is on a shortest path.
+            int u = predecessors2[v];
+            if (u >= 0) ASSERT(distances2[u] < distances2[v] + 1e-9);
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GRAPH_DELTA_STEPPING_SHORTEST_PATHS_TEST_H_
@@ -9,12 +9,14 @@
 #ifndef CODELIBRARY_TEST_GRPAH_FLOW_PERFORMANCE_TEST_H_
 #define CODELIBRARY_TEST_GRPAH_FLOW_PERFORMANCE_TEST_H_
 
+#include <cmath>
 #include <random>
 
 #include "codelibrary/base/testing.h"
 #include "codelibrary/base/timer.h"
 #include "codelibrary/graph/flow/boykov_kolmogorov_max_flow.h"
 #include "codelibrary/graph/flow/improved_sap_max_flow.h"
+#include "codelibrary/graph/flow/parallel_push_relabel_max_flow.h"
 #include "codelibrary/graph/flow/push_relable_max_flow.h"
 
 namespace cl {
@@ -74,6 +76,98 @@ protected:
         }
     }
 
+    /**
+     * Generate a graph-cut segmentation of a noisy sphere (or disk if nz is
+     * 1) on a grid: t-links from the intensity of each voxel, and n-links
+     * that are strong between similar neighbors.
+     */
+    void RandomGridCut(int nx, int ny, int nz, int n_neighbors) {
+        grid_ = GridGraph(nx, ny, nz, n_neighbors);
+        const int n = grid_.n_vertices();
+
+        std::mt19937 random;
+        std::normal_distribution<double> noise(0.0, 0.25);
+        Array<double> intensity(n);
+        for (int z = 0; z < nz; ++z) {
+            for (int y = 0; y < ny; ++y) {
+                for (int x = 0; x < nx; ++x) {
+                    double dx = (x - nx / 2) / (0.3 * nx);
+                    double dy = (y - ny / 2) / (0.3 * ny);
+                    double dz = nz == 1 ? 0.0 : (z - nz / 2) / (0.3 * nz);
+                    double inside = dx * dx + dy * dy + dz * dz < 1.0;
+                    intensity[grid_.vertex(x, y, z)] = inside + noise(random);
+                }
+            }
+        }
+
+        source_capacity_.resize(n);
+        sink_capacity_.resize(n);
+        for (int v = 0; v < n; ++v) {
+            double p = std::min(1.0, std::max(0.0, intensity[v]));
+            source_capacity_[v] = static_cast<int>(100 * p);
+            sink_capacity_[v] = static_cast<int>(100 * (1.0 - p));
+        }
+        arc_capacity_.assign(grid_.n_arcs(), 0);
+        for (int v = 0; v < n; ++v) {
+            grid_.ForEachArc(v, [&](int a, int w, int t) {
+                (void)t;
+                double d = intensity[v] - intensity[w];
+                arc_capacity_[a] = static_cast<int>(50 * std::exp(-4 * d * d));
+            });
+        }
+    }
+
+    /**
+     * Convert the grid cut into a CSR graph.
+     */
+    void GridCutToCSR(CSRGraph* csr, Array<int>* capacity) const {
+        Array<std::pair<int, int>> edges;
+        for (int v = 0; v < grid_.n_vertices(); ++v) {
+            grid_.ForEachArc(v, [&](int a, int w, int t) {
+                (void)a;
+                (void)t;
+                if (v < w) edges.emplace_back(v, w);
+            });
+        }
+        csr->Reset(grid_.n_vertices(), edges);
+
+        capacity->resize(csr->n_arcs());
+        int i = 0;
+        for (int v = 0; v < grid_.n_vertices(); ++v) {
+            grid_.ForEachArc(v, [&](int a, int w, int t) {
+                if (v < w) {
+                    int b = csr->edge_arc(i++);
+                    (*capacity)[b] = arc_capacity_[a];
+                    (*capacity)[csr->twin(b)] = arc_capacity_[t];
+                }
+            });
+        }
+    }
+
+    /**
+     * Convert the grid cut into graph_, with terminals n and n + 1.
+     */
+    void GridCutToGraph() {
+        const int n = grid_.n_vertices();
+        graph_.clear();
+        graph_.Resize(n + 2);
+        for (int v = 0; v < n; ++v) {
+            grid_.ForEachArc(v, [&](int a, int w, int t) {
+                if (v < w) {
+                    Edge* e = graph_.InsertTwoWayEdge(v, w);
+                    capacity_[e] = arc_capacity_[a];
+                    capacity_[e->twin()] = arc_capacity_[t];
+                }
+            });
+            Edge* s = graph_.InsertTwoWayEdge(n, v);
+            capacity_[s] = source_capacity_[v];
+            capacity_[s->twin()] = 0;
+            Edge* e = graph_.InsertTwoWayEdge(v, n + 1);
+            capacity_[e] = sink_capacity_[v];
+            capacity_[e->twin()] = 0;
+        }
+    }
+
     virtual void Finish() override {
         graph_.clear();
     }
@@ -81,6 +175,12 @@ protected:
     Graph graph_;
     Graph::EdgeProperty<int> capacity_;
     Graph::EdgeProperty<int> flow_;
+
+    // Grid cut instance.
+    GridGraph grid_;
+    Array<int> arc_capacity_;
+    Array<int> source_capacity_;
+    Array<int> sink_capacity_;
 };
 
 TEST_F(MaxFlowPerformanceTest, DenseGraph) {
@@ -185,6 +285,71 @@ TEST_F(MaxFlowPerformanceTest, SparseGraph) {
     max_flow(graph_, capacity_, 0, n - 1, &flow_);
 }
 
+// Graph-cut segmentation on pixel and voxel grids.
+TEST_F(MaxFlowPerformanceTest, GridGraph) {
+    const int n_tests = 5;
+    const int sizes[n_tests][4] = {
+        { 256,  256,  1,   4  },
+        { 512,  512,  1,   4  },
+        { 1024, 1024, 1,   8  },
+        { 64,   64,   64,  6  },
+        { 128,  128,  128, 6  }
+    };
+
+    printf("\n");
+    printf("        Grid    |V|    Boykov Kolmogorov  Parallel Push Relabel"
+           " (CSR)  (Grid)\n");
+    printf("-------------------------------------------------------------------"
+           "----------\n");
+    for (int i = 0; i < n_tests; ++i) {
+        const int nx = sizes[i][0], ny = sizes[i][1], nz = sizes[i][2];
+        const int n_neighbors = sizes[i][3];
+        RandomGridCut(nx, ny, nz, n_neighbors);
+        const int n = grid_.n_vertices();
+
+        // The adjacency list graph is too large for the biggest instance.
+        std::string t1 = "-";
+        int flow1 = -1;
+        if (n <= (1 << 20)) {
+            GridCutToGraph();
+            graph::BoykovKolmogorovMaxFlow<int> bk;
+            Timer timer;
+            timer.Start();
+            flow1 = bk(graph_, capacity_, n, n + 1, &flow_);
+            timer.Stop();
+            t1 = timer.average_time(1);
+            graph_.clear();
+        }
+
+        CSRGraph csr;
+        Array<int> csr_capacity;
+        GridCutToCSR(&csr, &csr_capacity);
+        graph::ParallelPushRelabelMaxFlow<int> push_relabel;
+        Timer timer2;
+        timer2.Start();
+        int flow2 = push_relabel(csr, csr_capacity, source_capacity_,
+                                 sink_capacity_);
+        timer2.Stop();
+
+        Timer timer3;
+        timer3.Start();
+        int flow3 = push_relabel(grid_, arc_capacity_, source_capacity_,
+                                 sink_capacity_);
+        timer3.Stop();
+
+        ASSERT_EQ(flow2, flow3);
+        if (flow1 >= 0) ASSERT_EQ(flow1, flow2);
+
+        char grid[32];
+        snprintf(grid, sizeof(grid), "%dx%dx%d/%d", nx, ny, nz, n_neighbors);
+        printf("%16s %8d %14s %20s %13s\n", grid, n, t1.c_str(),
+               timer2.average_time(1).c_str(), timer3.average_time(1).c_str());
+    }
+    printf("-------------------------------------------------------------------"
+           "----------\n");
+    printf("\n");
+}
+
 } // namespace test
 } // namespace cl
 
@@ -0,0 +1,183 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GRAPH_FLOW_PARALLEL_PUSH_RELABEL_MAX_FLOW_TEST_H_
+#define CODELIBRARY_TEST_GRAPH_FLOW_PARALLEL_PUSH_RELABEL_MAX_FLOW_TEST_H_
+
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/graph/flow/boykov_kolmogorov_max_flow.h"
+#include "codelibrary/graph/flow/parallel_push_relabel_max_flow.h"
+
+namespace cl {
+namespace test {
+
+class ParallelPushRelabelMaxFlowTest : public Test {
+protected:
+    /**
+     * Return the capacity of the cut found by 'max_flow'.
+     */
+    template <typename ArcGraph>
+    static int CutCapacity(
+            const ArcGraph& graph,
+            const graph::ParallelPushRelabelMaxFlow<int>& max_flow,
+            const Array<int>& capacity,
+            const Array<int>& source_capacity,
+            const Array<int>& sink_capacity) {
+        int cut = 0;
+        for (int v = 0; v < graph.n_vertices(); ++v) {
+            if (max_flow.IsSourceSide(v)) {
+                cut += sink_capacity[v];
+                graph.ForEachArc(v, [&](int a, int w, int t) {
+                    (void)t;
+                    if (!max_flow.IsSourceSide(w)) cut += capacity[a];
+                });
+            } else {
+                cut += source_capacity[v];
+            }
+        }
+        return cut;
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(ParallelPushRelabelMaxFlowTest, Simple) {
+    Graph graph(5);
+    Graph::Edge* e1 = graph.InsertTwoWayEdge(1, 2);
+    Graph::Edge* e2 = graph.InsertTwoWayEdge(1, 4);
+    Graph::Edge* e3 = graph.InsertTwoWayEdge(2, 4);
+    Graph::Edge* e4 = graph.InsertTwoWayEdge(2, 3);
+    Graph::Edge* e5 = graph.InsertTwoWayEdge(3, 4);
+
+    Graph::EdgeProperty<int> capacity = graph.AddEdgeProperty<int>("capacity");
+    capacity[e1] = 40;
+    capacity[e2] = 20;
+    capacity[e3] = 20;
+    capacity[e4] = 30;
+    capacity[e5] = 10;
+
+    CSRGraph csr(graph);
+    Array<int> arc_capacity;
+    csr.GetArcProperty(graph, capacity, &arc_capacity);
+
+    graph::ParallelPushRelabelMaxFlow<int> max_flow;
+    ASSERT_EQ(max_flow(csr, arc_capacity, 1, 4), 50);
+    ASSERT_EQ(max_flow(csr, arc_capacity, 4, 1), 0);
+}
+
+TEST_F(ParallelPushRelabelMaxFlowTest, CompareWithBoykovKolmogorov) {
+    std::uniform_int_distribution<int> uniform_cap(0, 10);
+
+    graph::BoykovKolmogorovMaxFlow<int> bk;
+    graph::ParallelPushRelabelMaxFlow<int> max_flow;
+    for (int n : {2, 10, 50, 300}) {
+        for (int m : {n, 3 * n, 10 * n}) {
+            Graph graph(n);
+            std::uniform_int_distribution<int> uniform_v(0, n - 1);
+            Graph::EdgeProperty<int> capacity =
+                    graph.AddEdgeProperty<int>("capacity");
+            Graph::EdgeProperty<int> flow = graph.AddEdgeProperty<int>("flow");
+            for (int i = 0; i < m; ++i) {
+                int a = uniform_v(random_), b = uniform_v(random_);
+                if (a == b) continue;
+                Graph::Edge* e = graph.InsertTwoWayEdge(a, b);
+                capacity[e] = uniform_cap(random_);
+                capacity[e->twin()] = uniform_cap(random_) / 2;
+            }
+
+            CSRGraph csr(graph);
+            Array<int> arc_capacity;
+            csr.GetArcProperty(graph, capacity, &arc_capacity);
+
+            int expected = bk(graph, capacity, 0, n - 1, &flow);
+            ASSERT_EQ(max_flow(csr, arc_capacity, 0, n - 1), expected);
+        }
+    }
+}
+
+TEST_F(ParallelPushRelabelMaxFlowTest, GridCut) {
+    std::uniform_int_distribution<int> uniform_t(0, 20);
+    std::uniform_int_distribution<int> uniform_n(0, 8);
+
+    graph::ParallelPushRelabelMaxFlow<int> max_flow;
+    for (int n_neighbors : {4, 8, 6, 26}) {
+        const int nz = n_neighbors == 4 || n_neighbors == 8 ? 1 : 6;
+        GridGraph grid(17, 11, nz, n_neighbors);
+        const int n = grid.n_vertices();
+
+        // Random n-links, set symmetrically on both arcs.
+        Array<int> capacity(grid.n_arcs(), 0);
+        for (int v = 0; v < n; ++v) {
+            grid.ForEachArc(v, [&](int a, int w, int t) {
+                if (v < w) capacity[a] = capacity[t] = uniform_n(random_);
+            });
+        }
+        Array<int> source_capacity(n), sink_capacity(n);
+        for (int v = 0; v < n; ++v) {
+            source_capacity[v] = uniform_t(random_);
+            sink_capacity[v] = uniform_t(random_);
+        }
+
+        // The same network as an explicit graph with terminals n and n + 1.
+        Graph graph(n + 2);
+        Graph::EdgeProperty<int> cap = graph.AddEdgeProperty<int>("capacity");
+        Graph::EdgeProperty<int> flow = graph.AddEdgeProperty<int>("flow");
+        for (int v = 0; v < n; ++v) {
+            grid.ForEachArc(v, [&](int a, int w, int t) {
+                if (v < w) {
+                    Graph::Edge* e = graph.InsertTwoWayEdge(v, w);
+                    cap[e] = capacity[a];
+                    cap[e->twin()] = capacity[t];
+                }
+            });
+            Graph::Edge* s = graph.InsertTwoWayEdge(n, v);
+            cap[s] = source_capacity[v];
+            cap[s->twin()] = 0;
+            Graph::Edge* t = graph.InsertTwoWayEdge(v, n + 1);
+            cap[t] = sink_capacity[v];
+            cap[t->twin()] = 0;
+        }
+        graph::BoykovKolmogorovMaxFlow<int> bk;
+        int expected = bk(graph, cap, n, n + 1, &flow);
+
+        int f = max_flow(grid, capacity, source_capacity, sink_capacity);
+        ASSERT_EQ(f, expected);
+        ASSERT_EQ(CutCapacity(grid, max_flow, capacity, source_capacity,
+                              sink_capacity), f);
+
+        // The same grid as a CSR graph.
+        Array<std::pair<int, int>> edges;
+        Array<int> edge_capacity, twin_capacity;
+        for (int v = 0; v < n; ++v) {
+            grid.ForEachArc(v, [&](int a, int w, int t) {
+                if (v < w) {
+                    edges.emplace_back(v, w);
+                    edge_capacity.push_back(capacity[a]);
+                    twin_capacity.push_back(capacity[t]);
+                }
+            });
+        }
+        CSRGraph csr(n, edges);
+        Array<int> arc_capacity(csr.n_arcs());
+        for (int i = 0; i < edges.size(); ++i) {
+            arc_capacity[csr.edge_arc(i)] = edge_capacity[i];
+            arc_capacity[csr.twin(csr.edge_arc(i))] = twin_capacity[i];
+        }
+        ASSERT_EQ(max_flow(csr, arc_capacity, source_capacity, sink_capacity),
+                  expected);
+        ASSERT_EQ(CutCapacity(csr, max_flow, arc_capacity, source_capacity,
+                              sink_capacity), expected);
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GRAPH_FLOW_PARALLEL_PUSH_RELABEL_MAX_FLOW_TEST_H_
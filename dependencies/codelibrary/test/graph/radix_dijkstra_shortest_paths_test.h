@@ -0,0 +1,135 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GRAPH_RADIX_DIJKSTRA_SHORTEST_PATHS_TEST_H_
+#define CODELIBRARY_TEST_GRAPH_RADIX_DIJKSTRA_SHORTEST_PATHS_TEST_H_
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/graph/dijkstra_shortest_paths.h"
+#include "codelibrary/graph/grid_graph.h"
+#include "codelibrary/graph/radix_dijkstra_shortest_paths.h"
+
+namespace cl {
+namespace test {
+
+TEST(RadixDijkstraShortestPathsTest, Test) {
+    Array<std::pair<int, int>> edges = { {0, 1}, {0, 2}, {1, 2}, {2, 3},
+                                         {1, 3} };
+    Array<int> costs = {3, 1, 1, 2, 1};
+    CSRGraph graph(5, edges);
+    Array<int> weight(graph.n_arcs());
+    for (int i = 0; i < edges.size(); ++i) {
+        int a = graph.edge_arc(i);
+        weight[a] = weight[graph.twin(a)] = costs[i];
+    }
+
+    Array<int> predecessors, distances;
+    graph::RadixDijkstraShortestPaths<int> shortest_paths;
+    shortest_paths(graph, weight, 0, &predecessors, &distances);
+
+    ASSERT_EQ(distances[0], 0);
+    ASSERT_EQ(distances[1], 2);
+    ASSERT_EQ(distances[2], 1);
+    ASSERT_EQ(distances[3], 3);
+    ASSERT_EQ(distances[4], std::numeric_limits<int>::max());
+    ASSERT_EQ(predecessors[0], -1);
+    ASSERT_EQ(predecessors[1], 2);
+    ASSERT(predecessors[3] == 1 || predecessors[3] == 2);
+    ASSERT_EQ(predecessors[4], -1);
+
+    // Multiple sources.
+    Array<int> sources = {0, 3};
+    shortest_paths(graph, weight, sources, &predecessors, &distances);
+    ASSERT_EQ(distances[1], 1);
+    ASSERT_EQ(predecessors[1], 3);
+    ASSERT_EQ(distances[2], 1);
+}
+
+TEST(RadixDijkstraShortestPathsTest, CompareWithDijkstra) {
+    const int n = 2000, m = 8000;
+
+    std::mt19937 random;
+    std::uniform_int_distribution<int> uniform_v(0, n - 1);
+    std::uniform_int_distribution<int> uniform_w(0, 1000);
+
+    Graph graph(n);
+    Graph::EdgeProperty<int64_t> weight =
+            graph.AddEdgeProperty<int64_t>("weight");
+    for (int i = 0; i < m; ++i) {
+        Graph::Edge* e = graph.InsertTwoWayEdge(uniform_v(random),
+                                                uniform_v(random));
+        weight[e] = uniform_w(random);
+        weight[e->twin()] = uniform_w(random);
+    }
+
+    CSRGraph csr(graph);
+    Array<int64_t> arc_weight;
+    csr.GetArcProperty(graph, weight, &arc_weight);
+
+    // The second batch reuses the buffers of the first one.
+    graph::RadixDijkstraShortestPaths<int64_t> shortest_paths;
+    Array<int> sources = {3, 5, 7, 11};
+    Array<Array<int64_t>> batch;
+    shortest_paths.Batch(csr, arc_weight, sources, &batch);
+    sources = {0, 17, 999, 1500};
+    shortest_paths.Batch(csr, arc_weight, sources, &batch);
+    ASSERT_EQ(batch.size(), sources.size());
+
+    for (int i = 0; i < sources.size(); ++i) {
+        Array<int> predecessors1, predecessors2;
+        Array<int64_t> distances1, distances2;
+        graph::DijkstraShortestPaths(graph, weight, sources[i],
+                                     &predecessors1, &distances1);
+        shortest_paths(csr, arc_weight, sources[i], &predecessors2,
+                       &distances2);
+
+        for (int v = 0; v < n; ++v) {
+            if (v != sources[i] && predecessors1[v] == -1) {
+                ASSERT_EQ(predecessors2[v], -1);
+                ASSERT_EQ(distances2[v], std::numeric_limits<int64_t>::max());
+                continue;
+            }
+            ASSERT_EQ(distances1[v], distances2[v]);
+            ASSERT_EQ(batch[i][v], distances2[v]);
+        }
+    }
+}
+
+TEST(RadixDijkstraShortestPathsTest, GridGraph) {
+    GridGraph grid(30, 20, 8);
+    Array<int> weight(grid.n_arcs(), 0);
+    for (int v = 0; v < grid.n_vertices(); ++v) {
+        for (int k = 0; k < grid.n_neighbors(); ++k) {
+            int dx, dy, dz;
+            grid.neighbor_offset(k, &dx, &dy, &dz);
+            weight[grid.arc(v, k)] = dx != 0 && dy != 0 ? 3 : 2;
+        }
+    }
+
+    Array<int> predecessors, distances;
+    graph::RadixDijkstraShortestPaths<int> shortest_paths;
+    shortest_paths(grid, weight, grid.vertex(0, 0), &predecessors, &distances);
+
+    // Octile distance.
+    for (int y = 0; y < 20; ++y) {
+        for (int x = 0; x < 30; ++x) {
+            int d = std::min(x, y) * 3 + (std::max(x, y) - std::min(x, y)) * 2;
+            ASSERT_EQ(distances[grid.vertex(x, y)], d);
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GRAPH_RADIX_DIJKSTRA_SHORTEST_PATHS_TEST_H_
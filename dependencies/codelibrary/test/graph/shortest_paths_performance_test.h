@@ -0,0 +1,248 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_GRAPH_SHORTEST_PATHS_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_GRAPH_SHORTEST_PATHS_PERFORMANCE_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/graph/boruvka_min_spanning_tree.h"
+#include "codelibrary/graph/csr_graph.h"
+#include "codelibrary/graph/delta_stepping_shortest_paths.h"
+#include "codelibrary/graph/radix_dijkstra_shortest_paths.h"
+#include "codelibrary/util/set/disjoint_set.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Shortest paths and minimum spanning trees on random geometric graphs: n
+ * uniform points in the unit square, each connected to the points within the
+ * radius that gives the expected degree. The weights are the Euclidean
+ * lengths in units of 1e-6.
+ */
+class ShortestPathsPerformanceTest : public Test {
+protected:
+    void RandomGeometricGraph(int n, int degree) {
+        std::mt19937 random;
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        Array<double> xs(n), ys(n);
+        for (int i = 0; i < n; ++i) {
+            xs[i] = uniform(random);
+            ys[i] = uniform(random);
+        }
+
+        // Bucket the points into cells of the radius size.
+        const double radius = std::sqrt(degree / (M_PI * n));
+        const int size = std::max(1, static_cast<int>(1.0 / radius));
+        auto cell = [&](double x) {
+            return std::min(size - 1, static_cast<int>(x * size));
+        };
+        Array<int> offsets(size * size + 1, 0), points(n);
+        for (int i = 0; i < n; ++i) {
+            ++offsets[cell(ys[i]) * size + cell(xs[i]) + 1];
+        }
+        for (int c = 0; c < size * size; ++c) {
+            offsets[c + 1] += offsets[c];
+        }
+        Array<int> position(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            points[position[cell(ys[i]) * size + cell(xs[i])]++] = i;
+        }
+
+        Array<std::pair<int, int>> edges;
+        Array<int> lengths;
+        for (int i = 0; i < n; ++i) {
+            int cx = cell(xs[i]), cy = cell(ys[i]);
+            for (int y = std::max(0, cy - 1); y <= std::min(size - 1, cy + 1);
+                 ++y) {
+                for (int x = std::max(0, cx - 1);
+                     x <= std::min(size - 1, cx + 1); ++x) {
+                    int c = y * size + x;
+                    for (int k = offsets[c]; k < offsets[c + 1]; ++k) {
+                        int j = points[k];
+                        if (j <= i) continue;
+
+                        double dx = xs[i] - xs[j], dy = ys[i] - ys[j];
+                        double d = std::sqrt(dx * dx + dy * dy);
+                        if (d > radius) continue;
+                        edges.emplace_back(i, j);
+                        lengths.push_back(static_cast<int>(d * 1e6));
+                    }
+                }
+            }
+        }
+
+        graph_.Reset(n, edges);
+        weight_.resize(graph_.n_arcs());
+        for (int i = 0; i < edges.size(); ++i) {
+            int a = graph_.edge_arc(i);
+            weight_[a] = weight_[graph_.twin(a)] = lengths[i];
+        }
+    }
+
+    /**
+     * Reference: Dijkstra with a binary heap.
+     */
+    void BinaryHeapDijkstra(int source, Array<int>* distances) const {
+        using Pair = std::pair<int, int>;
+        std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair>> q;
+
+        distances->assign(graph_.n_vertices(),
+                          std::numeric_limits<int>::max());
+        (*distances)[source] = 0;
+        q.push(Pair(0, source));
+        while (!q.empty()) {
+            Pair cur = q.top();
+            q.pop();
+            if (cur.first != (*distances)[cur.second]) continue;
+
+            graph_.ForEachArc(cur.second, [&](int a, int w, int t) {
+                (void)t;
+                int d = cur.first + weight_[a];
+                if (d < (*distances)[w]) {
+                    (*distances)[w] = d;
+                    q.push(Pair(d, w));
+                }
+            });
+        }
+    }
+
+    /**
+     * Reference: Kruskal on the arc arrays.
+     */
+    int64_t Kruskal() const {
+        Array<int> arcs;
+        for (int a = 0; a < graph_.n_arcs(); ++a) {
+            if (a < graph_.twin(a)) arcs.push_back(a);
+        }
+        std::sort(arcs.begin(), arcs.end(), [&](int a, int b) {
+            return weight_[a] < weight_[b];
+        });
+
+        DisjointSet set(graph_.n_vertices());
+        int64_t sum = 0;
+        for (int a : arcs) {
+            int u = graph_.target(graph_.twin(a)), v = graph_.target(a);
+            if (set.Find(u) != set.Find(v)) {
+                set.Union(u, v);
+                sum += weight_[a];
+            }
+        }
+        return sum;
+    }
+
+    CSRGraph graph_;
+    Array<int> weight_;
+};
+
+TEST_F(ShortestPathsPerformanceTest, ShortestPaths) {
+    const int n_tests = 3;
+    const int sizes[n_tests] = { 10000, 100000, 1000000 };
+    const int degree = 20;
+    const int n_sources = 8;
+
+    printf("\n");
+    printf("      |V|        |E|   Binary heap   Radix heap   Delta stepping"
+           "   Batch\n");
+    printf("-------------------------------------------------------------------"
+           "-------\n");
+    for (int i = 0; i < n_tests; ++i) {
+        const int n = sizes[i];
+        RandomGeometricGraph(n, degree);
+
+        Array<int> distances1, distances2, distances3, predecessors;
+        Timer timer1;
+        timer1.Start();
+        BinaryHeapDijkstra(0, &distances1);
+        timer1.Stop();
+
+        graph::RadixDijkstraShortestPaths<int> radix;
+        Timer timer2;
+        timer2.Start();
+        radix(graph_, weight_, 0, &predecessors, &distances2);
+        timer2.Stop();
+
+        graph::DeltaSteppingShortestPaths<int> delta_stepping;
+        Timer timer3;
+        timer3.Start();
+        delta_stepping(graph_, weight_, 0, &predecessors, &distances3);
+        timer3.Stop();
+
+        ASSERT_EQ_RANGE(distances1.begin(), distances1.end(),
+                        distances2.begin(), distances2.end());
+        ASSERT_EQ_RANGE(distances1.begin(), distances1.end(),
+                        distances3.begin(), distances3.end());
+
+        Array<int> sources;
+        for (int j = 0; j < n_sources; ++j) {
+            sources.push_back(j * (n / n_sources));
+        }
+        Array<Array<int>> batch;
+        Timer timer4;
+        timer4.Start();
+        radix.Batch(graph_, weight_, sources, &batch);
+        timer4.Stop();
+        ASSERT_EQ_RANGE(batch[0].begin(), batch[0].end(),
+                        distances1.begin(), distances1.end());
+
+        printf("%9d %10d %13s %12s %16s %7s\n", n, graph_.n_arcs() / 2,
+               timer1.average_time(1).c_str(), timer2.average_time(1).c_str(),
+               timer3.average_time(1).c_str(),
+               timer4.average_time(n_sources).c_str());
+    }
+    printf("-------------------------------------------------------------------"
+           "-------\n");
+    printf("\n");
+}
+
+TEST_F(ShortestPathsPerformanceTest, MinSpanningTree) {
+    const int n_tests = 3;
+    const int sizes[n_tests] = { 10000, 100000, 1000000 };
+    const int degree = 20;
+
+    printf("\n");
+    printf("      |V|        |E|      Kruskal      Boruvka\n");
+    printf("-----------------------------------------------\n");
+    for (int i = 0; i < n_tests; ++i) {
+        const int n = sizes[i];
+        RandomGeometricGraph(n, degree);
+
+        Timer timer1;
+        timer1.Start();
+        int64_t sum1 = Kruskal();
+        timer1.Stop();
+
+        Array<int64_t> weight(weight_.begin(), weight_.end());
+        Timer timer2;
+        timer2.Start();
+        int64_t sum2 = graph::BoruvkaMinSpanningTree(graph_, weight);
+        timer2.Stop();
+
+        ASSERT_EQ(sum1, sum2);
+
+        printf("%9d %10d %12s %12s\n", n, graph_.n_arcs() / 2,
+               timer1.average_time(1).c_str(), timer2.average_time(1).c_str());
+    }
+    printf("-----------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_GRAPH_SHORTEST_PATHS_PERFORMANCE_TEST_H_
@@ -12,12 +12,18 @@
 #define CODELIBRARY_TEST_GRAPH_TESTS_H_
 
 #include "codelibrary/test/graph/bellman_ford_shortest_paths_test.h"
+#include "codelibrary/test/graph/boruvka_min_spanning_tree_test.h"
+#include "codelibrary/test/graph/csr_graph_test.h"
+#include "codelibrary/test/graph/delta_stepping_shortest_paths_test.h"
 #include "codelibrary/test/graph/dijkstra_shortest_paths_test.h"
 #include "codelibrary/test/graph/graph_test.h"
 #include "codelibrary/test/graph/kruskal_minimum_spanning_tree_test.h"
+#include "codelibrary/test/graph/radix_dijkstra_shortest_paths_test.h"
+#include "codelibrary/test/graph/shortest_paths_performance_test.h"
 #include "codelibrary/test/graph/flow/boykov_kolmogorov_max_flow_test.h"
 #include "codelibrary/test/graph/flow/max_flow_performance_test.h"
 #include "codelibrary/test/graph/flow/improved_sap_max_flow_test.h"
+#include "codelibrary/test/graph/flow/parallel_push_relabel_max_flow_test.h"
 #include "codelibrary/test/graph/flow/push_relabel_max_flow_test.h"
 
 #endif // CODELIBRARY_TEST_GRAPH_TESTS_H_
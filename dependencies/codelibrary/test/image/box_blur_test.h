@@ -0,0 +1,135 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_BOX_BLUR_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_BOX_BLUR_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/image/box_blur.h"
+
+namespace cl {
+namespace test {
+
+class BoxBlurTest : public Test {
+protected:
+    template <typename T>
+    void RandomImage(int h, int w, int c, BaseImage<T>* image) {
+        std::uniform_int_distribution<int> uniform(0, 255);
+        image->Reset(h, w, c);
+        for (T& v : *image) {
+            v = static_cast<T>(uniform(random_));
+        }
+    }
+
+public:
+    /**
+     * The previous box blur, which builds an integral image.
+     */
+    template <typename T>
+    static void ReferenceBoxBlur(const BaseImage<T>& image, int kernel_radius,
+                                 BaseImage<T>* filtered_image) {
+        const int w = image.width(), h = image.height(), c = image.n_channels();
+        const int kernel_size = 2 * kernel_radius + 1;
+        const int offset = kernel_radius + 1;
+        ArrayND<double> accumulator(h + kernel_size, w + kernel_size, c);
+        accumulator.fill(0.0);
+
+        for (int i = 1; i < h + kernel_size; ++i) {
+            for (int j = 1; j < w + kernel_size; ++j) {
+                for (int k = 0; k < c; ++k) {
+                    int x = Clamp(i - offset, 0, h - 1);
+                    int y = Clamp(j - offset, 0, w - 1);
+                    accumulator(i, j, k) = accumulator(i - 1, j, k) +
+                                           accumulator(i, j - 1, k) -
+                                           accumulator(i - 1, j - 1, k) +
+                                           image(x, y, k);
+                }
+            }
+        }
+
+        bool is_integer = std::is_integral<T>::value;
+
+        filtered_image->Reset(h, w, c);
+        T* out = filtered_image->data();
+        const int r = kernel_radius;
+        double norm = 1.0 / (kernel_size * kernel_size);
+        for (int i = 0; i < h; ++i) {
+            for (int j = 0; j < w; ++j) {
+                for (int k = 0; k < c; ++k) {
+                    double t = (accumulator(offset + i + r, offset + j + r, k) -
+                                accumulator(i, offset + j + r, k) -
+                                accumulator(offset + i + r, j, k) +
+                                accumulator(i, j, k)) * norm;
+                    *out++ = is_integer ? static_cast<T>(t >= 0.0 ? t + 0.5
+                                                                  : t - 0.5)
+                                        : t;
+                }
+            }
+        }
+    }
+
+protected:
+    std::mt19937 random_;
+};
+
+TEST_F(BoxBlurTest, Parity) {
+    const int radii[] = { 1, 2, 7, 30, 200 };
+    for (int r : radii) {
+        Image image, result, expect;
+        RandomImage(131, 77, 3, &image);
+        image::BoxBlur(image, r, &result);
+        ReferenceBoxBlur(image, r, &expect);
+        ASSERT_EQ_RANGE(result.begin(), result.end(),
+                        expect.begin(), expect.end());
+
+        ImageF image_f, result_f, expect_f;
+        RandomImage(64, 200, 1, &image_f);
+        image::BoxBlur(image_f, r, &result_f);
+        ReferenceBoxBlur(image_f, r, &expect_f);
+        for (int i = 0; i < result_f.size(); ++i) {
+            ASSERT_EQ_NEAR(result_f.data()[i], expect_f.data()[i], 1e-3f);
+        }
+    }
+
+    // In place.
+    Image image, expect;
+    RandomImage(50, 60, 1, &image);
+    ReferenceBoxBlur(image, 3, &expect);
+    image::BoxBlur(image, 3, &image);
+    ASSERT_EQ_RANGE(image.begin(), image.end(),
+                    expect.begin(), expect.end());
+}
+
+TEST_F(BoxBlurTest, GaussianBlur) {
+    // The blurred impulse should have the variance of the Gaussian.
+    const int n = 201;
+    const double sigmas[] = { 2.5, 6.0, 15.0 };
+    for (double sigma : sigmas) {
+        ImageF image(n, n, 1, 0.0f), result;
+        image(n / 2, n / 2) = 1.0f;
+        image::GaussianBlur(image, sigma, &result);
+
+        double sum = 0.0, variance = 0.0;
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                sum += result(i, j);
+                variance += result(i, j) * (j - n / 2) * (j - n / 2);
+            }
+        }
+        ASSERT_EQ_NEAR(sum, 1.0, 1e-4);
+        ASSERT_EQ_NEAR(std::sqrt(variance), sigma, 0.1 * sigma);
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_BOX_BLUR_TEST_H_
@@ -0,0 +1,157 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_DISTANCE_TRANSFORM_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_DISTANCE_TRANSFORM_PERFORMANCE_TEST_H_
+
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/image/distance_transform.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the 3D Euclidean distance transforms on n^3 occupancy grids.
+ */
+class DistanceTransformPerformanceTest : public Test {
+protected:
+    /**
+     * Generate an n^3 grid with a sphere shell and some random occupied cells,
+     * which is what a density grid of a scene roughly looks like.
+     */
+    void RandomGrid(int n, Array<uint8_t>* grid) {
+        grid->assign(n * n * n, 0);
+        const double r = 0.35 * n, c = 0.5 * n;
+        for (int z = 0; z < n; ++z) {
+            for (int y = 0; y < n; ++y) {
+                for (int x = 0; x < n; ++x) {
+                    double d = std::sqrt((x - c) * (x - c) + (y - c) * (y - c) +
+                                         (z - c) * (z - c));
+                    if (std::fabs(d - r) < 1.0) {
+                        (*grid)[(z * n + y) * n + x] = 1;
+                    }
+                }
+            }
+        }
+
+        std::mt19937 random;
+        std::uniform_int_distribution<int> uniform(0, n * n * n - 1);
+        for (int i = 0; i < n * n; ++i) {
+            (*grid)[uniform(random)] = 1;
+        }
+    }
+
+    /**
+     * Single-threaded transform with the 1D functor, one Array<double> per
+     * line, for reference.
+     */
+    static void ReferenceTransform(int n, const Array<uint8_t>& grid,
+                                   Array<double>* d) {
+        image::SquaredEuclideanDistanceTransform1D transform;
+        d->resize(grid.size());
+        for (int i = 0; i < grid.size(); ++i) {
+            (*d)[i] = grid[i] ? 0.0 : transform.infinity();
+        }
+
+        Array<double> f(n), res;
+        const int strides[] = { 1, n, n * n };
+        for (int stride : strides) {
+            for (int i = 0; i < n * n * n; ++i) {
+                if ((i / stride) % n != 0) continue;
+                for (int q = 0; q < n; ++q) {
+                    f[q] = (*d)[i + q * stride];
+                }
+                transform(f, n, &res);
+                for (int q = 0; q < n; ++q) {
+                    (*d)[i + q * stride] = res[q];
+                }
+            }
+        }
+        for (double& v : *d) {
+            v = std::sqrt(v);
+        }
+    }
+};
+
+TEST_F(DistanceTransformPerformanceTest, Grid) {
+    const int n_tests = 4;
+    const int sizes[] = { 64, 128, 256, 512 };
+    const int tests[] = { 10, 10,  2,   1   };
+
+    printf("\n");
+    printf("    n^3       Reference       Float        Half      Morton\n");
+    printf("------------------------------------------------------------\n");
+    for (int i = 0; i < n_tests; ++i) {
+        const int n = sizes[i];
+        Array<int> shape = {n, n, n};
+        Array<uint8_t> grid;
+        RandomGrid(n, &grid);
+
+        std::string t0 = "-";
+        if (n <= 256) {
+            Array<double> d;
+            Timer timer;
+            timer.Start();
+            for (int j = 0; j < tests[i]; ++j) {
+                ReferenceTransform(n, grid, &d);
+            }
+            timer.Stop();
+            t0 = timer.average_time(tests[i]);
+        }
+
+        Timer timer1, timer2, timer3;
+        {
+            Array<float> d(grid.size());
+            timer1.Start();
+            for (int j = 0; j < tests[i]; ++j) {
+                image::EuclideanDistanceTransformND(shape, grid.data(),
+                                                    d.data());
+            }
+            timer1.Stop();
+        }
+        {
+            Array<Half> d(grid.size());
+            timer2.Start();
+            for (int j = 0; j < tests[i]; ++j) {
+                image::EuclideanDistanceTransformND(shape, grid.data(),
+                                                    d.data());
+            }
+            timer2.Stop();
+        }
+        {
+            // The bitfield is not Morton ordered here, which does not matter
+            // for the timing.
+            Array<uint8_t> bitfield((grid.size() + 7) / 8, 0);
+            for (int j = 0; j < grid.size(); ++j) {
+                if (grid[j]) bitfield[j / 8] |= 1 << (j % 8);
+            }
+            Array<Half> d(grid.size());
+            timer3.Start();
+            for (int j = 0; j < tests[i]; ++j) {
+                image::EuclideanDistanceTransformMorton(n, bitfield.data(),
+                                                        d.data());
+            }
+            timer3.Stop();
+        }
+
+        printf("%7d %15s %11s %11s %11s\n", n, t0.c_str(),
+               timer1.average_time(tests[i]).c_str(),
+               timer2.average_time(tests[i]).c_str(),
+               timer3.average_time(tests[i]).c_str());
+    }
+    printf("------------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_DISTANCE_TRANSFORM_PERFORMANCE_TEST_H_
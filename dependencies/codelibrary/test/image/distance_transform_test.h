@@ -0,0 +1,224 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_DISTANCE_TRANSFORM_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_DISTANCE_TRANSFORM_TEST_H_
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/image/distance_transform.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Compare the N-dimensional distance transforms against brute force.
+ */
+class DistanceTransformTest : public Test {
+protected:
+    /**
+     * Generate a random binary grid, each cell is a feature with probability
+     * p.
+     */
+    void RandomGrid(const Array<int>& shape, double p, Array<uint8_t>* grid) {
+        int size = 1;
+        for (int s : shape) {
+            size *= s;
+        }
+        std::bernoulli_distribution bernoulli(p);
+        grid->resize(size);
+        for (uint8_t& v : *grid) {
+            v = bernoulli(random_);
+        }
+    }
+
+    /**
+     * Return the coordinates of the index-th cell.
+     */
+    static Array<int> Coordinates(const Array<int>& shape, int index) {
+        Array<int> c(shape.size());
+        for (int i = shape.size() - 1; i >= 0; --i) {
+            c[i] = index % shape[i];
+            index /= shape[i];
+        }
+        return c;
+    }
+
+    /**
+     * Brute force squared distance transform of the sampled function f.
+     */
+    static void BruteForce(const Array<int>& shape, const Array<double>& f,
+                           Array<double>* d) {
+        d->assign(f.size(), std::numeric_limits<double>::infinity());
+        for (int p = 0; p < f.size(); ++p) {
+            Array<int> cp = Coordinates(shape, p);
+            for (int q = 0; q < f.size(); ++q) {
+                Array<int> cq = Coordinates(shape, q);
+                double dist = f[q];
+                for (int i = 0; i < shape.size(); ++i) {
+                    dist += static_cast<double>(cp[i] - cq[i]) *
+                            (cp[i] - cq[i]);
+                }
+                (*d)[p] = std::min((*d)[p], dist);
+            }
+        }
+    }
+
+    /**
+     * Brute force Euclidean distance to the nearest feature cell.
+     */
+    static void BruteForce(const Array<int>& shape, const Array<uint8_t>& grid,
+                           Array<double>* d) {
+        const double inf = std::numeric_limits<double>::infinity();
+        Array<double> f(grid.size());
+        for (int i = 0; i < grid.size(); ++i) {
+            f[i] = grid[i] ? 0.0 : inf;
+        }
+        BruteForce(shape, f, d);
+        for (double& v : *d) {
+            v = std::sqrt(v);
+        }
+    }
+
+    bool CheckBinary(const Array<int>& shape, double p) {
+        Array<uint8_t> grid;
+        RandomGrid(shape, p, &grid);
+
+        Array<float> d(grid.size());
+        Array<double> d1;
+        image::EuclideanDistanceTransformND(shape, grid.data(), d.data());
+        BruteForce(shape, grid, &d1);
+        for (int i = 0; i < grid.size(); ++i) {
+            if (d[i] != static_cast<float>(d1[i])) return false;
+        }
+        return true;
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(DistanceTransformTest, Binary) {
+    ASSERT(CheckBinary({37}, 0.1));
+    ASSERT(CheckBinary({13, 21}, 0.05));
+    ASSERT(CheckBinary({7, 13, 10}, 0.02));
+    ASSERT(CheckBinary({12, 12, 12}, 0.002));
+    ASSERT(CheckBinary({4, 5, 6, 7}, 0.02));
+    ASSERT(CheckBinary({9, 8, 7}, 1.0));
+
+    // Without feature cells, every cell is infinitely far.
+    ASSERT(CheckBinary({5, 6, 7}, 0.0));
+}
+
+TEST_F(DistanceTransformTest, SampledFunction) {
+    Array<int> shape = {6, 9, 11};
+    std::uniform_int_distribution<int> uniform(0, 40);
+    Array<double> f(6 * 9 * 11);
+    for (double& v : f) {
+        v = uniform(random_);
+    }
+    Array<double> d = f, d1;
+    image::SquaredEuclideanDistanceTransformND(shape, d.data());
+    BruteForce(shape, f, &d1);
+    ASSERT_EQ_RANGE(d.begin(), d.end(), d1.begin(), d1.end());
+}
+
+TEST_F(DistanceTransformTest, Half) {
+    Array<int> shape = {16, 24, 20};
+    Array<uint8_t> grid;
+    RandomGrid(shape, 0.001, &grid);
+
+    Array<float> d(grid.size());
+    Array<Half> h(grid.size());
+    image::EuclideanDistanceTransformND(shape, grid.data(), d.data());
+    image::EuclideanDistanceTransformND(shape, grid.data(), h.data());
+    for (int i = 0; i < grid.size(); ++i) {
+        ASSERT_EQ(static_cast<float>(h[i]), static_cast<float>(Half(d[i])));
+    }
+}
+
+TEST_F(DistanceTransformTest, Signed) {
+    // A ball of radius 5 in a 16^3 grid.
+    const int n = 16;
+    Array<int> shape = {n, n, n};
+    Array<uint8_t> grid(n * n * n);
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                int r2 = (x - 8) * (x - 8) + (y - 8) * (y - 8) +
+                         (z - 8) * (z - 8);
+                grid[(z * n + y) * n + x] = r2 <= 25;
+            }
+        }
+    }
+
+    Array<uint8_t> outside(grid.size());
+    for (int i = 0; i < grid.size(); ++i) {
+        outside[i] = !grid[i];
+    }
+    Array<float> sdf(grid.size()), d_in(grid.size()), d_out(grid.size());
+    image::SignedEuclideanDistanceTransformND(shape, grid.data(), sdf.data());
+    image::EuclideanDistanceTransformND(shape, grid.data(), d_in.data());
+    image::EuclideanDistanceTransformND(shape, outside.data(), d_out.data());
+    for (int i = 0; i < grid.size(); ++i) {
+        if (grid[i]) {
+            ASSERT(sdf[i] < 0.0f);
+            ASSERT_EQ(sdf[i], 0.5f - d_out[i]);
+        } else {
+            ASSERT(sdf[i] > 0.0f);
+            ASSERT_EQ(sdf[i], d_in[i] - 0.5f);
+        }
+    }
+}
+
+TEST_F(DistanceTransformTest, Morton) {
+    const int n = 32;
+    Array<int> shape = {n, n, n};
+    Array<uint8_t> grid;
+    RandomGrid(shape, 0.001, &grid);
+
+    // Pack the grid into a Morton ordered bitfield and density grid.
+    Array<uint8_t> bitfield(n * n * n / 8, 0);
+    Array<float> density(n * n * n, 0.0f);
+    Array<int> morton(n * n * n);
+    for (int z = 0; z < n; ++z) {
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                int c = 0;
+                for (int b = 0; b < 5; ++b) {
+                    c |= ((x >> b) & 1) << (3 * b);
+                    c |= ((y >> b) & 1) << (3 * b + 1);
+                    c |= ((z >> b) & 1) << (3 * b + 2);
+                }
+                int i = (z * n + y) * n + x;
+                morton[i] = c;
+                if (grid[i]) {
+                    bitfield[c / 8] |= 1 << (c % 8);
+                    density[c] = 1.0f;
+                }
+            }
+        }
+    }
+
+    Array<float> d(n * n * n), d1(n * n * n), d2(n * n * n);
+    image::EuclideanDistanceTransformND(shape, grid.data(), d.data());
+    image::EuclideanDistanceTransformMorton(n, bitfield.data(), d1.data());
+    image::EuclideanDistanceTransformMorton(n, density.data(), 0.5f,
+                                            d2.data());
+    for (int i = 0; i < n * n * n; ++i) {
+        ASSERT_EQ(d1[morton[i]], d[i]);
+        ASSERT_EQ(d2[morton[i]], d[i]);
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_DISTANCE_TRANSFORM_TEST_H_
@@ -0,0 +1,279 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_ENVIRONMENT_MAP_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_ENVIRONMENT_MAP_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/image/environment_map.h"
+
+namespace cl {
+namespace test {
+
+class EnvironmentMapTest : public Test {
+protected:
+    /**
+     * Uniformly distributed unit direction.
+     */
+    FVector3D RandomDirection() {
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        const float z = 2.0f * uniform(random_) - 1.0f;
+        const float phi = 2.0f * static_cast<float>(M_PI) * uniform(random_);
+        const float r = std::sqrt(std::max(1.0f - z * z, 0.0f));
+        return FVector3D(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    /**
+     * Render the analytic environment 'f' to a (2h x h) equirectangular image.
+     */
+    template <typename Function>
+    static void Render(int h, int n_channels, const Function& f,
+                       ImageF* image) {
+        image::RenderEquirectangular(2 * h, h, n_channels, 4,
+                                     [&](const FVector3D& d, float* out) {
+            f(d, out);
+        }, image);
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(EnvironmentMapTest, Distribution2D) {
+    // f(x, y) = x * y on a 16 x 8 grid, and a zero row.
+    const int w = 16, h = 8;
+    Array<float> f(w * h);
+    for (int i = 0; i < h; ++i) {
+        for (int j = 0; j < w; ++j) {
+            f[i * w + j] = i == 3 ? 0.0f : (j + 0.5f) * (i + 0.5f);
+        }
+    }
+    image::Distribution2D distribution(w, h, f.data());
+    ASSERT_EQ(distribution.marginal_cdf().size(), h + 1);
+    ASSERT_EQ(distribution.conditional_cdf().size(), h * (w + 1));
+    ASSERT_EQ(distribution.marginal_cdf().back(), 1.0f);
+
+    double integral = 0.0;
+    for (float v : f) integral += v;
+    integral /= w * h;
+    ASSERT_EQ_NEAR(distribution.integral(), integral, 1e-9);
+
+    // Stratified samples land in each cell in proportion to f.
+    const int n = 512;
+    Array<int> histogram(w * h, 0);
+    for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+            float x, y, pdf;
+            distribution.Sample((b + 0.5f) / n, (a + 0.5f) / n, &x, &y, &pdf);
+            ASSERT(x >= 0.0f && x < 1.0f && y >= 0.0f && y < 1.0f);
+            ASSERT_EQ(pdf, distribution.Pdf(x, y));
+
+            const int i = static_cast<int>(y * h), j = static_cast<int>(x * w);
+            const double cell_pdf = pdf;
+            ASSERT_EQ_NEAR(cell_pdf, f[i * w + j] / integral, 1e-4);
+            ++histogram[i * w + j];
+        }
+    }
+    for (int k = 0; k < w * h; ++k) {
+        const double expect = f[k] / (integral * w * h) * n * n;
+        const double count = histogram[k];
+        ASSERT_EQ_NEAR(count, expect, 0.01 * expect + 2.0);
+    }
+
+    // A zero function is sampled uniformly.
+    Array<float> zero(w * h, 0.0f);
+    distribution.Reset(w, h, zero.data());
+    float x, y, pdf;
+    distribution.Sample(0.3f, 0.6f, &x, &y, &pdf);
+    ASSERT_EQ_NEAR(x, 0.3f, 1e-6f);
+    ASSERT_EQ_NEAR(y, 0.6f, 1e-6f);
+    ASSERT_EQ_NEAR(pdf, 1.0f, 1e-5f);
+}
+
+TEST_F(EnvironmentMapTest, Mappings) {
+    for (int k = 0; k < 1000; ++k) {
+        const FVector3D d = RandomDirection();
+
+        float u, v;
+        image::DirectionToEquirectangular(d, &u, &v);
+        const FVector3D d1 = image::EquirectangularToDirection(u, v);
+        ASSERT_EQ_NEAR(d1.x, d.x, 1e-5f);
+        ASSERT_EQ_NEAR(d1.y, d.y, 1e-5f);
+        ASSERT_EQ_NEAR(d1.z, d.z, 1e-5f);
+
+        float s, t;
+        const int face = image::DirectionToCubemap(d, &s, &t);
+        const FVector3D d2 = Normalize(image::CubemapToDirection(face, s, t));
+        ASSERT_EQ_NEAR(d2.x, d.x, 1e-5f);
+        ASSERT_EQ_NEAR(d2.y, d.y, 1e-5f);
+        ASSERT_EQ_NEAR(d2.z, d.z, 1e-5f);
+    }
+
+    // Face centers are the axes, in OpenGL's order.
+    const FVector3D axes[6] = { {  1.0f,  0.0f,  0.0f }, { -1.0f, 0.0f, 0.0f },
+                                {  0.0f,  1.0f,  0.0f }, {  0.0f, -1.0f, 0.0f },
+                                {  0.0f,  0.0f,  1.0f }, {  0.0f, 0.0f, -1.0f }
+                              };
+    for (int f = 0; f < 6; ++f) {
+        ASSERT(image::CubemapToDirection(f, 0.5f, 0.5f) == axes[f]);
+    }
+}
+
+TEST_F(EnvironmentMapTest, ImportanceSampling) {
+    // A sky with a sharp lobe around +z, and a vertical gradient.
+    auto lobe = [](const FVector3D& d, float* out) {
+        const float c = std::max(d.z, 0.0f);
+        out[0] = out[1] = out[2] = c * c * c * c;
+    };
+    auto gradient = [](const FVector3D& d, float* out) {
+        out[0] = 1.0f + d.z;
+    };
+    ImageF lobe_map, gradient_map;
+    Render(256, 3, lobe, &lobe_map);
+    Render(64, 1, gradient, &gradient_map);
+
+    // Integrals over the sphere: 2pi / 5 and 4pi.
+    const ImageF* maps[2] = { &lobe_map, &gradient_map };
+    const double integrals[2] = { 2.0 * M_PI / 5.0, 4.0 * M_PI };
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    for (int m = 0; m < 2; ++m) {
+        const ImageF& map = *maps[m];
+        image::EnvironmentSampler sampler(map);
+
+        // Pdf() may see a neighbor texel for samples on texel borders.
+        const int n = 200000;
+        int n_mismatches = 0;
+        double estimate = 0.0, variance = 0.0;
+        for (int k = 0; k < n; ++k) {
+            float pdf;
+            const FVector3D d = sampler.Sample(uniform(random_),
+                                               uniform(random_), &pdf);
+            ASSERT_EQ_NEAR(d.norm(), 1.0f, 1e-5f);
+            ASSERT(pdf > 0.0f);
+            if (std::fabs(sampler.Pdf(d) - pdf) > 1e-3f * pdf) ++n_mismatches;
+
+            float u, v, value[3];
+            image::DirectionToEquirectangular(d, &u, &v);
+            image::SampleEquirectangular(map, u, v, value);
+            const double x = value[0] / pdf;
+            estimate += x;
+            variance += x * x;
+        }
+        ASSERT(n_mismatches < n / 1000);
+        estimate /= n;
+        variance = variance / n - estimate * estimate;
+        ASSERT_EQ_NEAR(estimate, integrals[m], 0.01 * integrals[m]);
+
+        // Importance sampling beats uniform sampling of the sphere.
+        double uniform_estimate = 0.0, uniform_variance = 0.0;
+        for (int k = 0; k < n; ++k) {
+            float value[3];
+            m == 0 ? lobe(RandomDirection(), value)
+                   : gradient(RandomDirection(), value);
+            const double x = value[0] * 4.0 * M_PI;
+            uniform_estimate += x;
+            uniform_variance += x * x;
+        }
+        uniform_estimate /= n;
+        uniform_variance = uniform_variance / n -
+                           uniform_estimate * uniform_estimate;
+        ASSERT(variance < 0.1 * uniform_variance);
+
+        // The density integrates to one over the sphere.
+        double total = 0.0;
+        for (int k = 0; k < n; ++k) {
+            total += sampler.Pdf(RandomDirection());
+        }
+        ASSERT_EQ_NEAR(total / n * 4.0 * M_PI, 1.0, 0.02);
+    }
+}
+
+TEST_F(EnvironmentMapTest, Cubemap) {
+    auto f = [](const FVector3D& d, float* out) {
+        out[0] = 1.0f + d.x;
+        out[1] = 1.0f + d.y;
+        out[2] = 1.0f + d.z;
+    };
+    ImageF equirect, back;
+    Render(256, 3, f, &equirect);
+
+    Array<ImageF> faces;
+    image::EquirectangularToCubemap(equirect, 64, &faces);
+    ASSERT_EQ(faces.size(), 6);
+    ASSERT_EQ(faces[0].width(), 64);
+
+    for (int k = 0; k < 1000; ++k) {
+        const FVector3D d = RandomDirection();
+        float value[3], expect[3];
+        image::SampleCubemap(faces, d, value);
+        f(d, expect);
+        for (int c = 0; c < 3; ++c) {
+            ASSERT_EQ_NEAR(value[c], expect[c], 0.02f);
+        }
+    }
+
+    image::CubemapToEquirectangular(faces, 128, 64, &back);
+    for (int i = 0; i < back.height(); ++i) {
+        for (int j = 0; j < back.width(); ++j) {
+            float expect[3];
+            f(image::EquirectangularToDirection((j + 0.5f) / back.width(),
+                                                (i + 0.5f) / back.height()),
+              expect);
+            for (int c = 0; c < 3; ++c) {
+                ASSERT_EQ_NEAR(back(i, j, c), expect[c], 0.02f);
+            }
+        }
+    }
+}
+
+TEST_F(EnvironmentMapTest, Mipmaps) {
+    auto f = [](const FVector3D& d, float* out) {
+        out[0] = 1.0f + d.z;
+        out[1] = 2.0f;
+        out[2] = 0.0f;
+    };
+    ImageF image;
+    Render(96, 3, f, &image);
+
+    Array<ImageF> levels;
+    image::BuildEquirectangularMipmaps(image, &levels);
+    ASSERT_EQ(levels.size(), 8);
+    ASSERT_EQ(levels[1].width(), 96);
+    ASSERT_EQ(levels[1].height(), 48);
+    ASSERT_EQ(levels[6].width(), 3);
+    ASSERT_EQ(levels[6].height(), 1);
+    ASSERT_EQ(levels.back().width(), 1);
+
+    // The mean of 1 + z over the sphere is 1, and constants are preserved.
+    for (const ImageF& level : levels) {
+        ASSERT_EQ_NEAR(level(level.height() - 1, 0, 1), 2.0f, 1e-5f);
+    }
+    ASSERT_EQ_NEAR(levels.back()(0, 0, 0), 1.0f, 1e-3f);
+
+    // Coarse levels are smooth versions of the fine ones.
+    float a[3], b[3], c[3];
+    image::SampleEquirectangularMipmaps(levels, 0.3f, 0.8f, 0.0f, a);
+    image::SampleEquirectangularMipmaps(levels, 0.3f, 0.8f, 1.5f, b);
+    image::SampleEquirectangularMipmaps(levels, 0.3f, 0.8f, 100.0f, c);
+    ASSERT_EQ_NEAR(a[0], 1.0f + std::sin(0.3f * static_cast<float>(M_PI)),
+                   1e-3f);
+    ASSERT_EQ_NEAR(b[0], a[0], 0.02f);
+    ASSERT_EQ_NEAR(c[0], 1.0f, 1e-3f);
+
+    ASSERT_EQ(image::EquirectangularMipLevel(192, 96, 1e-6), 0.0f);
+    ASSERT_EQ_NEAR(image::EquirectangularMipLevel(
+                   192, 96, 16.0 * 2.0 * M_PI * M_PI / (192 * 96)), 2.0f,
+                   1e-5f);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_ENVIRONMENT_MAP_TEST_H_
@@ -0,0 +1,126 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_MORPHOLOGY_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_MORPHOLOGY_PERFORMANCE_TEST_H_
+
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/image/box_blur.h"
+#include "codelibrary/image/morphology.h"
+#include "codelibrary/test/image/box_blur_test.h"
+#include "codelibrary/test/image/morphology_test.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the throughput of the morphology and blur filters on 4K masks.
+ */
+class MorphologyPerformanceTest : public Test {
+protected:
+    /**
+     * Generate a h x w mask with random blobs.
+     */
+    static void RandomMask(int h, int w, Image* image) {
+        std::mt19937 random;
+        std::uniform_int_distribution<int> uniform_x(0, w - 1);
+        std::uniform_int_distribution<int> uniform_y(0, h - 1);
+        std::uniform_int_distribution<int> uniform_r(2, 30);
+
+        image->Reset(h, w, 1);
+        image->Fill(0);
+        for (int i = 0; i < 2000; ++i) {
+            const int cx = uniform_x(random), cy = uniform_y(random);
+            const int r = uniform_r(random);
+            for (int y = std::max(0, cy - r); y <= std::min(h - 1, cy + r);
+                 ++y) {
+                for (int x = std::max(0, cx - r); x <= std::min(w - 1, cx + r);
+                     ++x) {
+                    if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= r * r) {
+                        (*image)(y, x) = 255;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Print the average time of 'f' over 'n' runs.
+     */
+    template <typename Function>
+    static std::string Time(int n, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return timer.average_time(n);
+    }
+};
+
+TEST_F(MorphologyPerformanceTest, Mask4K) {
+    const int h = 2160, w = 3840;
+    Image mask, result;
+    RandomMask(h, w, &mask);
+
+    printf("\n");
+    printf("Operation on 3840x2160 mask        Reference         New\n");
+    printf("---------------------------------------------------------\n");
+    const int radii[] = { 2, 10, 50 };
+    for (int r : radii) {
+        std::string t1 = Time(1, [&]() {
+            MorphologyTest::ReferenceBinaryFilter(mask, r, 255, &result);
+        });
+        std::string t2 = Time(3, [&]() {
+            image::morphology::BinaryDilate(mask, r, &result);
+        });
+        printf("BinaryDilate, radius %-8d %15s %11s\n", r, t1.c_str(),
+               t2.c_str());
+    }
+    for (int r : radii) {
+        std::string t = Time(3, [&]() {
+            image::morphology::Dilate(mask, 2 * r + 1, 2 * r + 1, &result);
+        });
+        printf("Dilate, %3dx%-3d %28s\n", 2 * r + 1, 2 * r + 1, t.c_str());
+    }
+    for (int r : radii) {
+        std::string t1 = Time(1, [&]() {
+            BoxBlurTest::ReferenceBoxBlur(mask, r, &result);
+        });
+        std::string t2 = Time(3, [&]() {
+            image::BoxBlur(mask, r, &result);
+        });
+        printf("BoxBlur, radius %-13d %15s %11s\n", r, t1.c_str(),
+               t2.c_str());
+    }
+    {
+        std::string t = Time(3, [&]() {
+            image::GaussianBlur(mask, 10.0, &result);
+        });
+        printf("GaussianBlur, sigma 10 %34s\n", t.c_str());
+    }
+    {
+        ArrayND<int> labels;
+        image::morphology::Square square(3);
+        std::string t = Time(3, [&]() {
+            image::morphology::GetLabelImage(mask, square, &labels);
+        });
+        printf("GetLabelImage, 8-connected %30s\n", t.c_str());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_MORPHOLOGY_PERFORMANCE_TEST_H_
@@ -0,0 +1,234 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_MORPHOLOGY_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_MORPHOLOGY_TEST_H_
+
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/image/morphology.h"
+
+namespace cl {
+namespace test {
+
+class MorphologyTest : public Test {
+protected:
+    /**
+     * Generate a random image whose pixels are drawn from [0, n_values).
+     */
+    template <typename T>
+    void RandomImage(int h, int w, int c, int n_values, BaseImage<T>* image) {
+        std::uniform_int_distribution<int> uniform(0, n_values - 1);
+        image->Reset(h, w, c);
+        for (T& v : *image) {
+            v = static_cast<T>(uniform(random_));
+        }
+    }
+
+    /**
+     * Generate a random binary image made of blobs.
+     */
+    void RandomBinaryImage(int h, int w, double p, Image* image) {
+        std::bernoulli_distribution bernoulli(p);
+        image->Reset(h, w, 1);
+        for (uint8_t& v : *image) {
+            v = bernoulli(random_) ? 255 : 0;
+        }
+    }
+
+    /**
+     * Brute force max (or min) filter over the structuring element.
+     */
+    template <typename T>
+    static void BruteForce(const BaseImage<T>& image,
+                           const image::morphology::StructuringElement& element,
+                           bool is_max, BaseImage<T>* result) {
+        const int w = image.width(), h = image.height(), c = image.n_channels();
+        result->Reset(h, w, c);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                for (int k = 0; k < c; ++k) {
+                    T v = image(y, x, k);
+                    for (const image::morphology::Pixel& p : element) {
+                        int x1 = x + p.x, y1 = y + p.y;
+                        if (x1 < 0 || x1 >= w || y1 < 0 || y1 >= h) continue;
+                        T t = image(y1, x1, k);
+                        v = is_max ? std::max(v, t) : std::min(v, t);
+                    }
+                    (*result)(y, x, k) = v;
+                }
+            }
+        }
+    }
+
+    /**
+     * Rectangle structuring element, with the same anchor as Square.
+     */
+    static image::morphology::StructuringElement Rectangle(int kw, int kh) {
+        image::morphology::StructuringElement element;
+        for (int x = -(kw - 1) / 2; x <= kw / 2; ++x) {
+            for (int y = -(kh - 1) / 2; y <= kh / 2; ++y) {
+                element.emplace_back(x, y);
+            }
+        }
+        return element;
+    }
+
+public:
+    /**
+     * The previous binary dilation, which thresholds the distance transform.
+     */
+    static void ReferenceBinaryFilter(const Image& image, int radius,
+                                      int feature_pixel, Image* result) {
+        *result = image;
+        if (radius == 0) return;
+
+        image::ManhattanDistanceTransform dt(image, feature_pixel);
+        const Array<double>& dis = dt.distance_map();
+        for (int i = 0; i < dis.size(); ++i) {
+            result->data()[i] = (dis[i] <= radius) ? feature_pixel
+                                                   : 255 - feature_pixel;
+        }
+    }
+
+    /**
+     * The previous labeling, which floods every unvisited pixel.
+     */
+    template <typename StructuringElement>
+    static int ReferenceLabelImage(const Image& image,
+                                   const StructuringElement& neighbors,
+                                   ArrayND<int>* labels) {
+        int n_labels = 0;
+        int w = image.width(), h = image.height();
+        labels->reshape(h, w);
+
+        ArrayND<bool> is_visited(h, w);
+        is_visited.fill(false);
+
+        Array<image::morphology::Pixel> pixels;
+        for (int i = 0; i < h; ++i) {
+            for (int j = 0; j < w; ++j) {
+                if (is_visited(i, j)) continue;
+
+                image::morphology::Flood(image,
+                                         image::morphology::Pixel(j, i),
+                                         neighbors, &pixels);
+                for (auto pixel : pixels) {
+                    is_visited(pixel.y, pixel.x) = true;
+                    (*labels)(pixel.y, pixel.x) = n_labels;
+                }
+                n_labels++;
+            }
+        }
+        return n_labels;
+    }
+
+protected:
+    std::mt19937 random_;
+};
+
+TEST_F(MorphologyTest, DilateErode) {
+    const int sizes[][2] = { {1, 1}, {1, 5}, {3, 3}, {4, 7}, {8, 2},
+                             {40, 40} };
+    for (auto size : sizes) {
+        const int kw = size[0], kh = size[1];
+        Image image, result, expect;
+        RandomImage(37, 53, 3, 256, &image);
+
+        image::morphology::Dilate(image, kw, kh, &result);
+        BruteForce(image, Rectangle(kw, kh), true, &expect);
+        ASSERT_EQ_RANGE(result.begin(), result.end(),
+                        expect.begin(), expect.end());
+
+        image::morphology::Erode(image, kw, kh, &result);
+        BruteForce(image, Rectangle(kw, kh), false, &expect);
+        ASSERT_EQ_RANGE(result.begin(), result.end(),
+                        expect.begin(), expect.end());
+    }
+
+    // Square(k) is the same neighborhood.
+    ImageF image, result, expect;
+    RandomImage(300, 301, 1, 1000, &image);
+    image::morphology::Dilate(image, 6, 6, &result);
+    BruteForce(image, image::morphology::Square(6), true, &expect);
+    ASSERT_EQ_RANGE(result.begin(), result.end(),
+                    expect.begin(), expect.end());
+
+    // In place.
+    Image a, b;
+    RandomImage(20, 30, 1, 256, &a);
+    BruteForce(a, Rectangle(5, 3), false, &b);
+    image::morphology::Erode(a, 5, 3, &a);
+    ASSERT_EQ_RANGE(a.begin(), a.end(), b.begin(), b.end());
+}
+
+TEST_F(MorphologyTest, BinaryDilateErode) {
+    const int radii[] = { 0, 1, 2, 5, 17, 1000 };
+    for (int radius : radii) {
+        Image image, result, expect;
+        RandomBinaryImage(257, 301, 0.01, &image);
+
+        image::morphology::BinaryDilate(image, radius, &result);
+        ReferenceBinaryFilter(image, radius, 255, &expect);
+        ASSERT_EQ_RANGE(result.begin(), result.end(),
+                        expect.begin(), expect.end());
+
+        RandomBinaryImage(257, 301, 0.99, &image);
+        image::morphology::BinaryErode(image, radius, &result);
+        ReferenceBinaryFilter(image, radius, 0, &expect);
+        ASSERT_EQ_RANGE(result.begin(), result.end(),
+                        expect.begin(), expect.end());
+    }
+
+    // No feature pixel at all.
+    Image image(10, 12, 1, 0), result, expect;
+    image::morphology::BinaryDilate(image, 3, &result);
+    ReferenceBinaryFilter(image, 3, 255, &expect);
+    ASSERT_EQ_RANGE(result.begin(), result.end(),
+                    expect.begin(), expect.end());
+}
+
+TEST_F(MorphologyTest, LabelImage) {
+    const int sizes[][2] = { {1, 1}, {1, 50}, {50, 1}, {97, 61}, {300, 280} };
+    for (auto size : sizes) {
+        Image image;
+        RandomImage(size[0], size[1], 1, 3, &image);
+
+        ArrayND<int> labels, expect;
+        image::morphology::Square square(3);
+        int n1 = image::morphology::GetLabelImage(image, square, &labels);
+        int n2 = ReferenceLabelImage(image, square, &expect);
+        ASSERT_EQ(n1, n2);
+        ASSERT_EQ_RANGE(labels.begin(), labels.end(),
+                        expect.begin(), expect.end());
+
+        image::morphology::Diamond diamond(1);
+        n1 = image::morphology::GetLabelImage(image, diamond, &labels);
+        n2 = ReferenceLabelImage(image, diamond, &expect);
+        ASSERT_EQ(n1, n2);
+        ASSERT_EQ_RANGE(labels.begin(), labels.end(),
+                        expect.begin(), expect.end());
+    }
+
+    // Large neighborhoods span several rows across the stripes.
+    Image image;
+    RandomImage(200, 150, 1, 2, &image);
+    ArrayND<int> labels, expect;
+    image::morphology::Disk disk(3.5);
+    int n1 = image::morphology::GetLabelImage(image, disk, &labels);
+    int n2 = ReferenceLabelImage(image, disk, &expect);
+    ASSERT_EQ(n1, n2);
+    ASSERT_EQ_RANGE(labels.begin(), labels.end(),
+                    expect.begin(), expect.end());
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_MORPHOLOGY_TEST_H_
@@ -0,0 +1,114 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_TONEMAPPER_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_TONEMAPPER_PERFORMANCE_TEST_H_
+
+#include <random>
+#include <vector>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/image/tonemapper.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the throughput of the tonemapper on 1080p buffers, in megapixels
+ * per second.
+ */
+class TonemapperPerformanceTest : public Test {
+protected:
+    /**
+     * Return the megapixels per second of 'f' over 'n' runs on 'n_pixels'.
+     */
+    template <typename Function>
+    static double Throughput(int n, int n_pixels, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return 1e-6 * n_pixels * n / timer.elapsed_seconds();
+    }
+
+    /**
+     * Tonemap pixel by pixel, as a baseline.
+     */
+    template <typename T>
+    static void PixelLoop(const image::Tonemapper& tonemapper, int n,
+                          const float* rgba, T* output) {
+        for (int i = 0; i < n; ++i) {
+            float c[4];
+            tonemapper.TonemapPixel(rgba + 4 * i, c);
+            image::tonemap_internal::StorePixel(c, output + 4 * i);
+        }
+    }
+
+    template <typename T>
+    void Report(const char* name, const image::Tonemapper& tonemapper) {
+        std::vector<T> output(pixels_.size());
+        const double t1 = Throughput(1, w_ * h_, [&]() {
+            PixelLoop(tonemapper, w_ * h_, pixels_.data(), output.data());
+        });
+        const double t2 = Throughput(5, w_ * h_, [&]() {
+            tonemapper.Tonemap(w_, h_, pixels_.data(), output.data());
+        });
+        printf("%-30s %12.1f %12.1f\n", name, t1, t2);
+    }
+
+    const int w_ = 1920, h_ = 1080;
+    std::vector<float> pixels_;
+};
+
+TEST_F(TonemapperPerformanceTest, Tonemap1080p) {
+    std::mt19937 random;
+    std::uniform_real_distribution<float> uniform(0.0f, 2.0f);
+    pixels_.resize(4 * w_ * h_);
+    for (float& v : pixels_) {
+        v = uniform(random);
+    }
+
+    printf("\n");
+    printf("1920x1080, MP/s                 Pixel loop     Tonemap\n");
+    printf("---------------------------------------------------------\n");
+
+    image::Tonemapper::Options options;
+    options.curve = image::ToneCurve::kACES;
+    image::Tonemapper tonemapper(options);
+    Report<float>("ACES -> sRGB, float", tonemapper);
+    Report<Half>("ACES -> sRGB, half", tonemapper);
+    Report<uint16_t>("ACES -> sRGB, 16-bit", tonemapper);
+    Report<uint8_t>("ACES -> sRGB, 8-bit", tonemapper);
+
+    options.curve = image::ToneCurve::kIdentity;
+    options.color_space = image::ColorSpace::kSRGB;
+    options.output_color_space = image::ColorSpace::kLinear;
+    Report<Half>("sRGB -> linear, half", image::Tonemapper(options));
+
+    options.curve = image::ToneCurve::kReinhard;
+    options.color_space = image::ColorSpace::kLinear;
+    options.output_color_space = image::ColorSpace::kLinear;
+    Report<uint8_t>("Reinhard, 8-bit", image::Tonemapper(options));
+
+    std::vector<float> accumulation(pixels_.size(), 0.0f);
+    const double t = Throughput(5, w_ * h_, [&]() {
+        image::Accumulate(w_, h_, pixels_.data(), 3, image::ColorSpace::kSRGB,
+                          accumulation.data());
+    });
+    printf("Accumulate, sRGB %40.1f\n", t);
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_TONEMAPPER_PERFORMANCE_TEST_H_
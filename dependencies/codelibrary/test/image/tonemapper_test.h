@@ -0,0 +1,295 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_IMAGE_TONEMAPPER_TEST_H_
+#define CODELIBRARY_TEST_IMAGE_TONEMAPPER_TEST_H_
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/image/tonemapper.h"
+
+namespace cl {
+namespace test {
+
+class TonemapperTest : public Test {
+public:
+    /**
+     * The renderer's tonemap kernel, in double precision.
+     */
+    static void ReferenceTonemap(const image::Tonemapper::Options& options,
+                                 const float* in, double* out) {
+        using image::ColorSpace;
+        using image::ToneCurve;
+
+        auto to_linear = [](double s) {
+            return s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055,
+                                                       2.4);
+        };
+        auto to_srgb = [](double l) {
+            return l < 0.0031308 ? 12.92 * l
+                                 : 1.055 * std::pow(l, 0.41666) - 0.055;
+        };
+
+        double bg[4];
+        for (int i = 0; i < 3; ++i) {
+            bg[i] = options.color_space == ColorSpace::kSRGB
+                  ? options.background[i] : to_linear(options.background[i]);
+        }
+        bg[3] = options.background[3];
+
+        double c[4] = { in[0], in[1], in[2], in[3] };
+        const double weight = (1.0 - c[3]) * bg[3];
+        for (int i = 0; i < 3; ++i) {
+            c[i] += bg[i] * weight;
+        }
+        c[3] += weight;
+
+        const double scale = std::pow(2.0, options.exposure);
+        for (int i = 0; i < 3; ++i) {
+            if (options.color_space == ColorSpace::kSRGB) {
+                c[i] = to_linear(c[i]);
+            }
+            c[i] *= scale;
+        }
+
+        if (options.curve != ToneCurve::kIdentity) {
+            for (int i = 0; i < 3; ++i) {
+                c[i] = std::max(c[i], 0.0);
+            }
+        }
+        if (options.curve == ToneCurve::kReinhard) {
+            const double y = 0.2126 * c[0] + 0.7152 * c[1] + 0.0722 * c[2];
+            for (int i = 0; i < 3; ++i) {
+                c[i] /= y + 1.0;
+            }
+        } else if (options.curve != ToneCurve::kIdentity) {
+            double k[6];
+            if (options.curve == ToneCurve::kACES) {
+                const double aces[6] = { 0.6 * 0.6 * 2.51, 0.6 * 0.03, 0.0,
+                                         0.6 * 0.6 * 2.43, 0.6 * 0.59, 0.14 };
+                std::copy(aces, aces + 6, k);
+            } else {
+                const double A = 0.15, B = 0.5, C = 0.1, D = 0.2, E = 0.02;
+                const double F = 0.3, W = 11.2;
+                k[0] = A * F - A * E;
+                k[1] = C * B * F - B * E;
+                k[2] = 0.0;
+                k[3] = A * F;
+                k[4] = B * F;
+                k[5] = D * F * F;
+                const double white_scale = (k[3] * W * W + k[4] * W + k[5]) /
+                                           (k[0] * W * W + k[1] * W + k[2]);
+                k[0] *= 4.0 * white_scale;
+                k[1] *= 2.0 * white_scale;
+                k[3] *= 4.0;
+                k[4] *= 2.0;
+            }
+            for (int i = 0; i < 3; ++i) {
+                const double x = c[i];
+                c[i] = (k[0] * x * x + k[1] * x + k[2]) /
+                       (k[3] * x * x + k[4] * x + k[5]);
+            }
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if (options.output_color_space == ColorSpace::kSRGB) {
+                c[i] = to_srgb(c[i]);
+            }
+            if (options.unmultiply_alpha && c[3] > 0.0) {
+                c[i] /= c[3];
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            out[i] = options.clamp_output
+                   ? std::min(std::max(c[i], 0.0), 1.0) : c[i];
+        }
+    }
+
+protected:
+    /**
+     * Random RGBA pixels with premultiplied, HDR colors.
+     */
+    std::vector<float> RandomPixels(int n) {
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::vector<float> pixels(4 * n);
+        for (int i = 0; i < n; ++i) {
+            const float a = uniform(random_) < 0.2f ? 0.0f : uniform(random_);
+            for (int c = 0; c < 3; ++c) {
+                pixels[4 * i + c] = a * 4.0f * uniform(random_) *
+                                    uniform(random_);
+            }
+            pixels[4 * i + 3] = a;
+        }
+        return pixels;
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(TonemapperTest, GoldenValues) {
+    // Linear inputs 0.18, 1 and 4 after each curve, in sRGB.
+    const image::ToneCurve curves[] = { image::ToneCurve::kIdentity,
+                                        image::ToneCurve::kACES,
+                                        image::ToneCurve::kHable };
+    const float inputs[] = { 0.18f, 1.0f, 4.0f };
+    const float expects[3][3] = {
+        { 0.461362f, 1.0f,      1.824779f },
+        { 0.410192f, 0.839687f, 0.970506f },
+        { 0.393477f, 0.730677f, 0.963067f }
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        image::Tonemapper::Options options;
+        options.curve = curves[i];
+        image::Tonemapper tonemapper(options);
+
+        // 9 pixels cover the SIMD and the scalar code.
+        for (int j = 0; j < 3; ++j) {
+            std::vector<float> pixels(4 * 9, inputs[j]), result(4 * 9);
+            tonemapper.Tonemap(9, 1, pixels.data(), result.data());
+            for (int k = 0; k < 9; ++k) {
+                for (int c = 0; c < 3; ++c) {
+                    ASSERT_EQ_NEAR(result[4 * k + c], expects[i][j], 1e-5f);
+                }
+                ASSERT_EQ(result[4 * k + 3], inputs[j]);
+            }
+        }
+    }
+
+    image::Tonemapper::Options options;
+    options.curve = image::ToneCurve::kReinhard;
+    image::Tonemapper tonemapper(options);
+    const float pixel[4] = { 0.18f, 0.5f, 1.0f, 1.0f };
+    const float expect[3] = { 0.385025f, 0.618517f, 0.844034f };
+    std::vector<float> pixels, result(4 * 9);
+    for (int k = 0; k < 9; ++k) {
+        pixels.insert(pixels.end(), pixel, pixel + 4);
+    }
+    tonemapper.Tonemap(9, 1, pixels.data(), result.data());
+    for (int k = 0; k < 9; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            ASSERT_EQ_NEAR(result[4 * k + c], expect[c], 1e-5f);
+        }
+    }
+
+    ASSERT_EQ_NEAR(image::SRGBToLinear(0.5f), 0.214041f, 1e-6f);
+    ASSERT_EQ_NEAR(image::LinearToSRGB(0.001f), 0.01292f, 1e-7f);
+}
+
+TEST_F(TonemapperTest, MatchesReference) {
+    const int w = 37, h = 5;
+    const std::vector<float> pixels = RandomPixels(w * h);
+    const image::ColorSpace spaces[] = { image::ColorSpace::kLinear,
+                                         image::ColorSpace::kSRGB };
+    const image::ToneCurve curves[] = { image::ToneCurve::kIdentity,
+                                        image::ToneCurve::kACES,
+                                        image::ToneCurve::kHable,
+                                        image::ToneCurve::kReinhard };
+
+    for (image::ColorSpace space : spaces) {
+        for (image::ColorSpace output_space : spaces) {
+            for (image::ToneCurve curve : curves) {
+                for (int flags = 0; flags < 4; ++flags) {
+                    image::Tonemapper::Options options;
+                    options.exposure = 0.7f;
+                    options.color_space = space;
+                    options.output_color_space = output_space;
+                    options.curve = curve;
+                    options.unmultiply_alpha = flags & 1;
+                    options.clamp_output = flags & 2;
+                    const float background[4] = { 0.2f, 0.5f, 0.9f, 0.6f };
+                    std::copy(background, background + 4, options.background);
+                    image::Tonemapper tonemapper(options);
+
+                    std::vector<float> result(4 * w * h);
+                    std::vector<Half> result_half(4 * w * h);
+                    std::vector<uint16_t> result16(4 * w * h);
+                    std::vector<uint8_t> result8(4 * w * h);
+                    tonemapper.Tonemap(w, h, pixels.data(), result.data());
+                    tonemapper.Tonemap(w, h, pixels.data(),
+                                       result_half.data());
+                    tonemapper.Tonemap(w, h, pixels.data(), result16.data());
+                    tonemapper.Tonemap(w, h, pixels.data(), result8.data());
+
+                    for (int i = 0; i < w * h; ++i) {
+                        double expect[4];
+                        ReferenceTonemap(options, &pixels[4 * i], expect);
+                        for (int c = 0; c < 4; ++c) {
+                            const int k = 4 * i + c;
+                            const double e = expect[c];
+                            const double tolerance = 1e-5 *
+                                                     std::max(1.0, e);
+                            const double value = result[k];
+                            ASSERT_EQ_NEAR(value, e, tolerance);
+                            const double half = static_cast<float>(
+                                result_half[k]);
+                            ASSERT_EQ_NEAR(half, e, 1e-3 * std::max(1.0, e));
+
+                            const double q = std::min(std::max(e, 0.0), 1.0);
+                            const double value16 = result16[k];
+                            const double value8 = result8[k];
+                            ASSERT_EQ_NEAR(value16, q * 65535.0, 1.0);
+                            ASSERT_EQ_NEAR(value8, q * 255.0, 0.51);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TonemapperTest, Accumulate) {
+    const int w = 21, h = 3, n_frames = 5;
+    const image::ColorSpace spaces[] = { image::ColorSpace::kLinear,
+                                         image::ColorSpace::kSRGB,
+                                         image::ColorSpace::kVisPosNeg };
+    for (image::ColorSpace space : spaces) {
+        std::vector<float> accumulation(4 * w * h, 0.0f);
+        std::vector<double> sum(4 * w * h, 0.0);
+        for (int frame = 0; frame < n_frames; ++frame) {
+            const std::vector<float> pixels = RandomPixels(w * h);
+            image::Accumulate(w, h, pixels.data(), frame, space,
+                              accumulation.data());
+            for (int i = 0; i < w * h; ++i) {
+                const float* p = &pixels[4 * i];
+                if (space == image::ColorSpace::kVisPosNeg) {
+                    sum[4 * i] += p[0] - p[1];
+                } else {
+                    for (int c = 0; c < 3; ++c) {
+                        sum[4 * i + c] += space == image::ColorSpace::kSRGB
+                                        ? image::LinearToSRGB(p[c]) : p[c];
+                    }
+                }
+                sum[4 * i + 3] += p[3];
+            }
+        }
+
+        for (int i = 0; i < w * h; ++i) {
+            const float* a = &accumulation[4 * i];
+            const double* s = &sum[4 * i];
+            if (space == image::ColorSpace::kVisPosNeg) {
+                const double mean = s[0] / n_frames;
+                ASSERT_EQ_NEAR(double(a[0]), std::max(mean, 0.0), 1e-5);
+                ASSERT_EQ_NEAR(double(a[1]), std::max(-mean, 0.0), 1e-5);
+            } else {
+                for (int c = 0; c < 3; ++c) {
+                    ASSERT_EQ_NEAR(double(a[c]), s[c] / n_frames, 1e-5);
+                }
+            }
+            ASSERT_EQ_NEAR(double(a[3]), s[3] / n_frames, 1e-5);
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_IMAGE_TONEMAPPER_TEST_H_
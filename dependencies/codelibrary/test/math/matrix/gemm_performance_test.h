@@ -0,0 +1,200 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_MATH_MATRIX_GEMM_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_MATH_MATRIX_GEMM_PERFORMANCE_TEST_H_
+
+#include <algorithm>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/math/matrix/gemm.h"
+#include "codelibrary/math/matrix/gemv.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Compare the GFLOP/s of the packed GEMM/GEMV kernels with the previous
+ * blocked triple-loop implementation.
+ */
+class GEMMPerformanceTest : public Test {
+protected:
+    /**
+     * The previous implementation of blas::GEMM: 128^3 blocks of a plain
+     * triple loop, parallel over row blocks.
+     */
+    template <typename T>
+    static void BlockedGEMM(int m, int n, int k, const T* a, const T* b, T* c) {
+        const int block_size = 128;
+
+        std::memset(c, 0, sizeof(T) * m * k);
+        #pragma omp parallel for
+        for (int ii = 0; ii < m; ii += block_size) {
+            for (int jj = 0; jj < k; jj += block_size) {
+                for (int pp = 0; pp < n; pp += block_size) {
+                    int block_m = std::min(block_size, m - ii);
+                    int block_n = std::min(block_size, n - pp);
+                    int block_k = std::min(block_size, k - jj);
+                    for (int i = ii; i < ii + block_m; ++i) {
+                        for (int j = jj; j < jj + block_k; ++j) {
+                            T sum = T(0);
+                            for (int p = pp; p < pp + block_n; ++p) {
+                                sum += a[i * n + p] * b[p * k + j];
+                            }
+                            c[i * k + j] += sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * The previous implementation of blas::GEMV.
+     */
+    template <typename T>
+    static void ScalarGEMV(int m, int n, const T* a, const T* b, T* c) {
+        for (int i = 0; i < m; ++i) {
+            T sum = T(0);
+            for (int j = 0; j < n; ++j) {
+                sum += a[i * n + j] * b[j];
+            }
+            c[i] = sum;
+        }
+    }
+
+    template <typename T>
+    void RandomArray(int n, Array<T>* a) {
+        std::uniform_real_distribution<T> uniform(-1, 1);
+        a->resize(n);
+        for (T& v : *a) {
+            v = uniform(random_);
+        }
+    }
+
+    static double GFlops(double flops, const Timer& timer, int n_times) {
+        return flops * n_times / timer.elapsed_seconds() * 1e-9;
+    }
+
+    template <typename T>
+    void RunGEMM(const char* type) {
+        const int sizes[] = { 16, 32, 64, 128, 256, 512, 1024 };
+        const int tests[] = { 10000, 2000, 500, 50, 10, 3, 1 };
+
+        printf("\n");
+        printf("  GEMM (%s)     n      Blocked (GFLOP/s)    Packed (GFLOP/s)\n",
+               type);
+        printf("------------------------------------------------------------\n");
+        for (int t = 0; t < 7; ++t) {
+            const int n = sizes[t];
+            Array<T> a, b, c(n * n);
+            RandomArray(n * n, &a);
+            RandomArray(n * n, &b);
+
+            Timer timer1, timer2;
+            timer1.Start();
+            for (int j = 0; j < tests[t]; ++j) {
+                BlockedGEMM(n, n, n, a.data(), b.data(), c.data());
+            }
+            timer1.Stop();
+
+            timer2.Start();
+            for (int j = 0; j < tests[t]; ++j) {
+                blas::GEMM(n, n, n, a.data(), b.data(), c.data());
+            }
+            timer2.Stop();
+
+            const double flops = 2.0 * n * n * n;
+            printf("%18d %18.2f %19.2f\n", n,
+                   GFlops(flops, timer1, tests[t]),
+                   GFlops(flops, timer2, tests[t]));
+        }
+        printf("------------------------------------------------------------\n");
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(GEMMPerformanceTest, GEMM) {
+    RunGEMM<float>("float");
+    RunGEMM<double>("double");
+    printf("\n");
+}
+
+TEST_F(GEMMPerformanceTest, GEMV) {
+    const int sizes[] = { 64, 256, 1024, 4096 };
+    const int tests[] = { 100000, 10000, 500, 20 };
+
+    printf("\n");
+    printf("  GEMV (float)     n      Scalar (GFLOP/s)    Blocked (GFLOP/s)\n");
+    printf("-------------------------------------------------------------\n");
+    for (int t = 0; t < 4; ++t) {
+        const int n = sizes[t];
+        Array<float> a, b, c(n);
+        RandomArray(n * n, &a);
+        RandomArray(n, &b);
+
+        Timer timer1, timer2;
+        timer1.Start();
+        for (int j = 0; j < tests[t]; ++j) {
+            ScalarGEMV(n, n, a.data(), b.data(), c.data());
+        }
+        timer1.Stop();
+
+        timer2.Start();
+        for (int j = 0; j < tests[t]; ++j) {
+            blas::GEMV(n, n, a.data(), b.data(), c.data());
+        }
+        timer2.Stop();
+
+        const double flops = 2.0 * n * n;
+        printf("%18d %18.2f %19.2f\n", n, GFlops(flops, timer1, tests[t]),
+               GFlops(flops, timer2, tests[t]));
+    }
+    printf("-------------------------------------------------------------\n");
+    printf("\n");
+}
+
+TEST_F(GEMMPerformanceTest, Batched) {
+    const int batch_size = 1000000;
+
+    printf("\n");
+    printf("  Batched GEMM (float)     Loop (GFLOP/s)    Batched (GFLOP/s)\n");
+    printf("-------------------------------------------------------------\n");
+    for (int d = 3; d <= 4; ++d) {
+        Array<float> a, b, c(batch_size * d * d);
+        RandomArray(batch_size * d * d, &a);
+        RandomArray(batch_size * d * d, &b);
+
+        Timer timer1, timer2;
+        timer1.Start();
+        for (int t = 0; t < batch_size; ++t) {
+            BlockedGEMM(d, d, d, a.data() + t * d * d, b.data() + t * d * d,
+                        c.data() + t * d * d);
+        }
+        timer1.Stop();
+
+        timer2.Start();
+        blas::GEMMBatched(batch_size, d, d, d, a.data(), b.data(), c.data());
+        timer2.Stop();
+
+        const double flops = 2.0 * d * d * d;
+        printf("%17dx%d %18.2f %19.2f\n", d, d,
+               GFlops(flops, timer1, batch_size),
+               GFlops(flops, timer2, batch_size));
+    }
+    printf("-------------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_MATH_MATRIX_GEMM_PERFORMANCE_TEST_H_
@@ -0,0 +1,147 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_MATH_MATRIX_GEMM_TEST_H_
+#define CODELIBRARY_TEST_MATH_MATRIX_GEMM_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/math/matrix/gemm.h"
+#include "codelibrary/math/matrix/gemv.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Compare the BLAS kernels against straightforward triple loops.
+ */
+class GEMMTest : public Test {
+protected:
+    template <typename T>
+    void RandomArray(int n, Array<T>* a) {
+        std::uniform_real_distribution<T> uniform(-1, 1);
+        a->resize(n);
+        for (T& v : *a) {
+            v = uniform(random_);
+        }
+    }
+
+    template <typename T>
+    static void ReferenceGEMM(int m, int n, int k, const T* a, const T* b,
+                              T* c) {
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < k; ++j) {
+                double sum = 0.0;
+                for (int p = 0; p < n; ++p) {
+                    sum += static_cast<double>(a[i * n + p]) * b[p * k + j];
+                }
+                c[i * k + j] = static_cast<T>(sum);
+            }
+        }
+    }
+
+    template <typename T>
+    bool CheckGEMM(int m, int n, int k, T tolerance) {
+        Array<T> a, b, c(m * k), c1(m * k);
+        RandomArray(m * n, &a);
+        RandomArray(n * k, &b);
+        blas::GEMM(m, n, k, a.data(), b.data(), c.data());
+        ReferenceGEMM(m, n, k, a.data(), b.data(), c1.data());
+        for (int i = 0; i < m * k; ++i) {
+            if (std::fabs(c[i] - c1[i]) > tolerance * std::sqrt(T(n) + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(GEMMTest, SmallAndOddSizes) {
+    const int sizes[] = { 1, 2, 3, 5, 7, 17, 33, 65 };
+    for (int m : sizes) {
+        for (int n : sizes) {
+            for (int k : sizes) {
+                ASSERT(CheckGEMM<double>(m, n, k, 1e-12)) << m << " "
+                                                          << n << " " << k;
+                ASSERT(CheckGEMM<float>(m, n, k, 1e-5f)) << m << " "
+                                                         << n << " " << k;
+            }
+        }
+    }
+}
+
+TEST_F(GEMMTest, LargeSizes) {
+    // Cover several KC/MC/NC blocks and partial micro-tiles.
+    ASSERT(CheckGEMM<double>(301, 517, 263, 1e-12));
+    ASSERT(CheckGEMM<float>(301, 517, 263, 1e-5f));
+    ASSERT(CheckGEMM<double>(7, 1000, 2300, 1e-12));
+    ASSERT(CheckGEMM<float>(1000, 3, 700, 1e-5f));
+}
+
+TEST_F(GEMMTest, GEMV) {
+    const int sizes[] = { 1, 3, 4, 9, 31, 130, 1025 };
+    for (int m : sizes) {
+        for (int n : sizes) {
+            Array<double> a, b, c(m), c1(m), b1, d(n), d1(n);
+            RandomArray(m * n, &a);
+            RandomArray(n, &b);
+            RandomArray(m, &b1);
+
+            blas::GEMV(m, n, a.data(), b.data(), c.data());
+            ReferenceGEMM(m, n, 1, a.data(), b.data(), c1.data());
+            for (int i = 0; i < m; ++i) {
+                ASSERT_EQ_NEAR(c[i], c1[i], 1e-10);
+            }
+
+            blas::GEMVTrans(m, n, a.data(), b1.data(), d.data());
+            ReferenceGEMM(1, m, n, b1.data(), a.data(), d1.data());
+            for (int i = 0; i < n; ++i) {
+                ASSERT_EQ_NEAR(d[i], d1[i], 1e-10);
+            }
+        }
+    }
+}
+
+TEST_F(GEMMTest, Batched) {
+    const int batch_size = 10000;
+    const int dims[] = { 3, 4, 5 };
+    for (int d : dims) {
+        Array<double> a, b, c(batch_size * d * d), c1(d * d);
+        RandomArray(batch_size * d * d, &a);
+        RandomArray(batch_size * d * d, &b);
+        blas::GEMMBatched(batch_size, d, d, d, a.data(), b.data(), c.data());
+        for (int t = 0; t < batch_size; ++t) {
+            ReferenceGEMM(d, d, d, a.data() + t * d * d, b.data() + t * d * d,
+                          c1.data());
+            for (int i = 0; i < d * d; ++i) {
+                ASSERT_EQ_NEAR(c[t * d * d + i], c1[i], 1e-12);
+            }
+        }
+    }
+
+    // Matrix-vector products.
+    Array<float> a, b, c(batch_size * 3), c1(3);
+    RandomArray(batch_size * 9, &a);
+    RandomArray(batch_size * 3, &b);
+    blas::GEMMBatched<3, 3, 1>(batch_size, a.data(), b.data(), c.data());
+    for (int t = 0; t < batch_size; ++t) {
+        ReferenceGEMM(3, 3, 1, a.data() + t * 9, b.data() + t * 3, c1.data());
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_EQ_NEAR(c[t * 3 + i], c1[i], 1e-6f);
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_MATH_MATRIX_GEMM_TEST_H_
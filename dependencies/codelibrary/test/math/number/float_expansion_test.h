@@ -0,0 +1,86 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_MATH_NUMBER_FLOAT_EXPANSION_TEST_H_
+#define CODELIBRARY_TEST_MATH_NUMBER_FLOAT_EXPANSION_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/math/number/exact_float.h"
+#include "codelibrary/math/number/float_expansion.h"
+
+namespace cl {
+namespace test {
+
+TEST(FloatExpansionTest, Basic) {
+    ASSERT_EQ(FloatExpansion().sign(), 0);
+    ASSERT_EQ(FloatExpansion(0.0).sign(), 0);
+    ASSERT_EQ(FloatExpansion(-3).sign(), -1);
+    ASSERT_EQ(FloatExpansion(2.5f).sign(), 1);
+
+    // (1 + 2^-60)^2 - 1 - 2^-59 = 2^-120.
+    const double e = std::ldexp(1.0, -60);
+    FloatExpansion a = FloatExpansion(1.0) + FloatExpansion(e);
+    FloatExpansion b = a * a;
+    b -= FloatExpansion(1.0);
+    b -= FloatExpansion(2.0 * e);
+    ASSERT_EQ(b.components().size(), 1);
+    ASSERT_EQ(b.components()[0], e * e);
+
+    b -= FloatExpansion(e) * FloatExpansion(e);
+    ASSERT_EQ(b.sign(), 0);
+    ASSERT(b.components().empty());
+
+    FloatExpansion c = -a;
+    ASSERT_EQ(c.sign(), -1);
+    c += a;
+    ASSERT_EQ(c.sign(), 0);
+}
+
+TEST(FloatExpansionTest, CompareWithExactFloat) {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-40, 40);
+
+    for (int t = 0; t < 2000; ++t) {
+        double v[6];
+        for (double& x : v) {
+            x = std::ldexp(uniform(random), exponent(random));
+        }
+
+        // a * b + c * d - e * f, where the terms nearly cancel every 2 tests.
+        if (t % 2 == 0) {
+            v[4] = v[0];
+            v[5] = v[1] * (1.0 + 1e-15);
+        }
+
+        FloatExpansion e = FloatExpansion(v[0]) * FloatExpansion(v[1]) +
+                           FloatExpansion(v[2]) * FloatExpansion(v[3]) -
+                           FloatExpansion(v[4]) * FloatExpansion(v[5]);
+        e *= FloatExpansion(v[2]) - FloatExpansion(v[3]);
+        ExactFloat f = ExactFloat(v[0]) * ExactFloat(v[1]) +
+                       ExactFloat(v[2]) * ExactFloat(v[3]) -
+                       ExactFloat(v[4]) * ExactFloat(v[5]);
+        f *= ExactFloat(v[2]) - ExactFloat(v[3]);
+        ASSERT_EQ(e.sign(), f.sign());
+
+        // The components are nonoverlapping, in increasing magnitude.
+        const Array<double>& c = e.components();
+        for (int i = 1; i < c.size(); ++i) {
+            ASSERT(std::fabs(c[i - 1]) < std::fabs(c[i]));
+            ASSERT(c[i - 1] != 0.0);
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_MATH_NUMBER_FLOAT_EXPANSION_TEST_H_
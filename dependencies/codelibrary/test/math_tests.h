@@ -14,11 +14,14 @@
 #include "codelibrary/test/math/factor/factor_test.h"
 #include "codelibrary/test/math/factor/pollard_rho_test.h"
 #include "codelibrary/test/math/fraction/farey_sequence_test.h"
+#include "codelibrary/test/math/matrix/gemm_performance_test.h"
+#include "codelibrary/test/math/matrix/gemm_test.h"
 #include "codelibrary/test/math/modular/modular_test.h"
 #include "codelibrary/test/math/modular/simultaneous_congruences_solver_test.h"
 #include "codelibrary/test/math/number/bigint_test.h"
 #include "codelibrary/test/math/number/common_factor_test.h"
 #include "codelibrary/test/math/number/decimal_test.h"
+#include "codelibrary/test/math/number/float_expansion_test.h"
 #include "codelibrary/test/math/prime/is_prime_test.h"
 #include "codelibrary/test/math/prime/wheel_sieve_test.h"
 
@@ -0,0 +1,123 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_BLOCK_ALIGNER_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_BLOCK_ALIGNER_PERFORMANCE_TEST_H_
+
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/point_cloud/block_aligner.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the alignment of up to 1k blocks of a street-view capture.
+ */
+class BlockAlignerPerformanceTest : public Test {
+protected:
+    using Aligner = point_cloud::BlockAligner<double>;
+    using Similarity = Aligner::Similarity;
+    using Observation = Aligner::Observation;
+
+    /**
+     * Generate n blocks of 60 frames along a closed loop, where neighboring
+     * blocks share 20 frames. If 'loop' is true, the last block also shares
+     * frames with the first one.
+     */
+    void Generate(int n_blocks, bool loop) {
+        std::mt19937 random(n_blocks);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        auto random_vector = [&](double sigma) {
+            return Vector3D<double>(sigma * normal(random),
+                                    sigma * normal(random),
+                                    sigma * normal(random));
+        };
+
+        Array<Similarity> inverses(n_blocks);
+        Similarity drift;
+        for (int b = 1; b < n_blocks; ++b) {
+            double scale = std::exp(0.01 * normal(random));
+            Matrix3<double> rotation =
+                    point_cloud::block_aligner_internal::RotationExp(
+                        random_vector(0.005));
+            drift.translation = drift.rotation * random_vector(0.1) *
+                                drift.scale + drift.translation;
+            drift.rotation = drift.rotation * rotation;
+            drift.scale *= scale;
+            inverses[b] = drift.Inverse();
+        }
+
+        const int n_frames = 40 * n_blocks;
+        const double radius = 4.0 * n_blocks / (2.0 * M_PI);
+        observations_.clear();
+        for (int b = 0; b < n_blocks; ++b) {
+            int end = loop || b + 1 < n_blocks ? 40 * b + 60 : 40 * b + 40;
+            for (int f = 40 * b; f < end; ++f) {
+                double angle = 2.0 * M_PI * (f % n_frames) / n_frames;
+                Point3D<double> center(radius * std::cos(angle),
+                                       radius * std::sin(angle),
+                                       0.5 * std::sin(10.0 * angle));
+                Matrix3<double> q =
+                        point_cloud::block_aligner_internal::RotationExp(
+                            Vector3D<double>(0.0, 0.0, angle));
+
+                Observation o;
+                o.block = b;
+                o.frame = f % n_frames;
+                o.center = inverses[b](center);
+                o.center += random_vector(0.002);
+                o.rotation = inverses[b].rotation *
+                        point_cloud::block_aligner_internal::RotationExp(
+                            random_vector(0.001)) * q;
+                observations_.push_back(o);
+            }
+        }
+    }
+
+    Array<Observation> observations_;
+};
+
+TEST_F(BlockAlignerPerformanceTest, Street) {
+    printf("\n");
+    printf("%-15s %7s %7s %11s %11s\n", "Blocks", "Iter", "RMSE0", "RMSE",
+           "Align");
+    printf("---------------------------------------------------------\n");
+    for (int n_blocks : { 100, 1000 }) {
+        for (bool loop : { false, true }) {
+            Generate(n_blocks, loop);
+
+            Aligner aligner;
+            Array<Similarity> transforms;
+            Aligner::Summary summary;
+            Timer timer;
+            timer.Start();
+            aligner.Align(n_blocks, observations_, &transforms, &summary);
+            timer.Stop();
+
+            std::string name = std::to_string(n_blocks) +
+                               (loop ? " (loop)" : " (chain)");
+            printf("%-15s %7d %7.3f %11.2e %11s\n", name.c_str(),
+                   summary.n_iterations, summary.initial_position_rmse,
+                   summary.final_position_rmse,
+                   timer.elapsed_time().c_str());
+        }
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_BLOCK_ALIGNER_PERFORMANCE_TEST_H_
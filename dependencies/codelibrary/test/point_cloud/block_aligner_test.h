@@ -0,0 +1,190 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_BLOCK_ALIGNER_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_BLOCK_ALIGNER_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/distance_3d.h"
+#include "codelibrary/point_cloud/block_aligner.h"
+
+namespace cl {
+namespace test {
+
+class BlockAlignerTest : public Test {
+protected:
+    using Aligner = point_cloud::BlockAligner<double>;
+    using Similarity = Aligner::Similarity;
+    using Observation = Aligner::Observation;
+
+    /**
+     * Generate a chain of n blocks along a curved street. Block b sees the
+     * frames [20b, 20b + 30), so that neighboring blocks share 10 frames, and
+     * refines them in its own world frame, which drifts from the previous one
+     * by a small random similarity. The first block has no drift.
+     */
+    void Generate(int n_blocks, double noise) {
+        std::mt19937 random(n_blocks);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        auto random_vector = [&](double sigma) {
+            return Vector3D<double>(sigma * normal(random),
+                                    sigma * normal(random),
+                                    sigma * normal(random));
+        };
+
+        drifts_.resize(n_blocks);
+        for (int b = 1; b < n_blocks; ++b) {
+            Similarity step;
+            step.scale = std::exp(0.02 * normal(random));
+            step.rotation = point_cloud::block_aligner_internal::RotationExp(
+                        random_vector(0.01));
+            step.translation = random_vector(0.2);
+            drifts_[b] = Compose(drifts_[b - 1], step);
+        }
+
+        observations_.clear();
+        for (int b = 0; b < n_blocks; ++b) {
+            Similarity inverse = drifts_[b].Inverse();
+            for (int f = 20 * b; f < 20 * b + 30; ++f) {
+                double t = 0.5 * f;
+                Point3D<double> center(t, 10.0 * std::sin(0.01 * t),
+                                       0.1 * std::cos(0.1 * t));
+                Matrix3<double> q =
+                        point_cloud::block_aligner_internal::RotationExp(
+                            Vector3D<double>(0.0, 0.0, 0.01 * t));
+
+                Observation o;
+                o.block = b;
+                o.frame = f;
+                o.center = inverse(center);
+                o.center += random_vector(noise);
+                o.rotation = inverse.rotation *
+                        point_cloud::block_aligner_internal::RotationExp(
+                            random_vector(0.1 * noise)) * q;
+                observations_.push_back(o);
+            }
+        }
+    }
+
+    /**
+     * Return a * b.
+     */
+    static Similarity Compose(const Similarity& a, const Similarity& b) {
+        Similarity s;
+        s.scale = a.scale * b.scale;
+        s.rotation = a.rotation * b.rotation;
+        s.translation = a.rotation * b.translation * a.scale + a.translation;
+        return s;
+    }
+
+    Array<Similarity> drifts_;
+    Array<Observation> observations_;
+};
+
+TEST_F(BlockAlignerTest, RecoverDrift) {
+    Generate(20, 0.001);
+
+    Aligner aligner;
+    Array<Similarity> transforms;
+    Aligner::Summary summary;
+    aligner.Align(20, observations_, &transforms, &summary);
+    ASSERT_EQ(transforms.size(), 20);
+    ASSERT_EQ(summary.n_constraints, 19 * 10);
+    ASSERT_EQ(summary.n_outliers, 0);
+    ASSERT(summary.initial_position_rmse > 1.0);
+    ASSERT(summary.final_position_rmse < 0.01);
+    ASSERT(summary.final_rotation_rmse < 0.01);
+
+    // The first block is fixed, and the others undo the drift.
+    ASSERT_EQ(transforms[0].scale, 1.0);
+    for (int b = 0; b < 20; ++b) {
+        ASSERT_EQ_NEAR(transforms[b].scale, drifts_[b].scale, 5e-3);
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                ASSERT_EQ_NEAR(transforms[b].rotation(i, j),
+                               drifts_[b].rotation(i, j), 1e-3);
+            }
+        }
+
+        // The street of the block lands where it should, up to the drift of
+        // the noise along the open chain.
+        Point3D<double> p = drifts_[b].Inverse()(Point3D<double>(10.0 * b,
+                                                                 0.0, 0.0));
+        ASSERT(Distance(transforms[b](p), drifts_[b](p)) < 0.01 + 0.01 * b);
+    }
+
+    // Without noise, the drift is recovered exactly.
+    Generate(20, 0.0);
+    aligner.Align(20, observations_, &transforms, &summary);
+    ASSERT(summary.final_position_rmse < 1e-8);
+    for (int b = 0; b < 20; ++b) {
+        ASSERT_EQ_NEAR(transforms[b].scale, drifts_[b].scale, 1e-9);
+        ASSERT_EQ_NEAR(transforms[b].translation.x,
+                       drifts_[b].translation.x, 1e-6);
+    }
+}
+
+TEST_F(BlockAlignerTest, Outliers) {
+    Generate(10, 0.001);
+
+    // A frame shared by blocks 4 and 5 is badly misregistered in block 5.
+    for (Observation& o : observations_) {
+        if (o.block == 5 && o.frame == 100) {
+            o.center.y += 5.0;
+        }
+    }
+
+    Aligner aligner;
+    Array<Similarity> transforms;
+    Aligner::Summary summary;
+    aligner.Align(10, observations_, &transforms, &summary);
+    ASSERT_EQ(summary.n_outliers, 1);
+    for (int b = 0; b < 10; ++b) {
+        ASSERT_EQ_NEAR(transforms[b].scale, drifts_[b].scale, 5e-3);
+    }
+}
+
+TEST_F(BlockAlignerTest, DisconnectedBlocks) {
+    Generate(6, 0.0);
+
+    // Blocks 2 and 3 no longer share frames, block 6 has no observation.
+    Array<Observation> observations;
+    for (const Observation& o : observations_) {
+        if (!(o.block == 2 && o.frame >= 60)) observations.push_back(o);
+    }
+
+    Aligner aligner;
+    Array<Similarity> transforms;
+    Aligner::Summary summary;
+    aligner.Align(7, observations, &transforms, &summary);
+    ASSERT(summary.final_position_rmse < 1e-8);
+
+    // Block 3 is the first of its group, so the group is aligned to it.
+    ASSERT_EQ(transforms[3].scale, 1.0);
+    ASSERT_EQ(transforms[6].scale, 1.0);
+    for (int b = 0; b < 3; ++b) {
+        ASSERT_EQ_NEAR(transforms[b].scale, drifts_[b].scale, 1e-9);
+    }
+    for (int b = 4; b < 6; ++b) {
+        ASSERT_EQ_NEAR(transforms[b].scale,
+                       drifts_[b].scale / drifts_[3].scale, 1e-9);
+    }
+
+    aligner.Align(0, Array<Observation>(), &transforms, &summary);
+    ASSERT(transforms.empty());
+    ASSERT_EQ(summary.n_constraints, 0);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_BLOCK_ALIGNER_TEST_H_
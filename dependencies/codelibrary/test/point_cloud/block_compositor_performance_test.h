@@ -0,0 +1,131 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_BLOCK_COMPOSITOR_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_BLOCK_COMPOSITOR_PERFORMANCE_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/point_cloud/block_compositor.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Play a 10k-frame camera path through a street of 500 blocks.
+ */
+class BlockCompositorPerformanceTest : public Test {
+protected:
+    using Compositor = point_cloud::BlockCompositor<double>;
+    using Block = Compositor::Block;
+    using Frame = Compositor::Frame;
+
+    static const int kBlocks = 500;
+    static const int kFrames = 10000;
+
+    BlockCompositorPerformanceTest() {
+        // A winding street with one block every 10 meters.
+        std::mt19937 random(kBlocks);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        for (int i = 0; i < kBlocks; ++i) {
+            RPoint3D c = Street(10.0 * i);
+            blocks_.emplace_back(RBox3D(c.x - 5.0, c.x + 5.0, c.y - 5.0,
+                                        c.y + 5.0, c.z - 1.0, c.z + 1.0),
+                                 RBox3D(c.x - 15.0, c.x + 15.0, c.y - 15.0,
+                                        c.y + 15.0, c.z - 10.0, c.z + 20.0),
+                                 0.5 + 0.5 * u(random));
+        }
+
+        // The camera drives along the street and sways across it.
+        for (int t = 0; t < kFrames; ++t) {
+            double s = 10.0 * (kBlocks - 1) * t / (kFrames - 1);
+            RPoint3D p = Street(s);
+            p.y += 2.0 * std::sin(0.3 * t);
+            path_.push_back(p);
+        }
+    }
+
+    static RPoint3D Street(double s) {
+        return RPoint3D(s, 200.0 * std::sin(s / 500.0), 1.5);
+    }
+
+    /**
+     * Return the weight of the block in the frame, or zero.
+     */
+    static double Weight(const Frame& frame, int block) {
+        for (int i = 0; i < frame.blocks.size(); ++i) {
+            if (frame.blocks[i] == block) return frame.weights[i];
+        }
+        return 0.0;
+    }
+
+    Array<Block> blocks_;
+    Array<RPoint3D> path_;
+};
+
+TEST_F(BlockCompositorPerformanceTest, Playback) {
+    printf("\n");
+    printf("%-15s %7s %7s %11s %11s\n", "Method", "Blocks", "Switch",
+           "Max jump", "Plan");
+    printf("---------------------------------------------------------\n");
+    for (int method = 0; method < 3; ++method) {
+        // Nearest block, blending without smoothing, the default planner.
+        Compositor::Options options;
+        if (method == 0) {
+            options.max_blocks = 1;
+            options.hysteresis = 0.0;
+        }
+        if (method <= 1) options.max_step = 1.0;
+        Compositor compositor(options);
+        compositor.Reset(blocks_);
+
+        Frame frame, last;
+        int n_rendered = 0, n_switches = 0;
+        double max_jump = 0.0;
+
+        Timer timer;
+        timer.Start();
+        for (int t = 0; t < kFrames; ++t) {
+            compositor.Plan(path_[t], &frame);
+
+            n_rendered += frame.blocks.size();
+            if (t == 0) {
+                last = frame;
+                continue;
+            }
+            if (frame.blocks[0] != last.blocks[0]) ++n_switches;
+            for (int b : frame.blocks) {
+                max_jump = std::max(max_jump, std::fabs(Weight(frame, b) -
+                                                        Weight(last, b)));
+            }
+            for (int b : last.blocks) {
+                max_jump = std::max(max_jump, Weight(last, b) -
+                                              Weight(frame, b));
+            }
+            last = frame;
+        }
+        timer.Stop();
+
+        const char* names[3] = { "Nearest", "Blend", "Blend+smooth" };
+        printf("%-15s %7.2f %7d %11.3f %11s\n", names[method],
+               static_cast<double>(n_rendered) / kFrames, n_switches,
+               max_jump, timer.elapsed_time().c_str());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_BLOCK_COMPOSITOR_PERFORMANCE_TEST_H_
@@ -0,0 +1,299 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_BLOCK_COMPOSITOR_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_BLOCK_COMPOSITOR_TEST_H_
+
+#include <cmath>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/point_cloud/block_compositor.h"
+
+namespace cl {
+namespace test {
+
+class BlockCompositorTest : public Test {
+protected:
+    using Compositor = point_cloud::BlockCompositor<double>;
+    using Block = Compositor::Block;
+    using Frame = Compositor::Frame;
+
+    /**
+     * Blocks along the x-axis with one origin every 10 meters. The cameras of
+     * block i are in [10i - 5, 10i + 5], and it renders [10i - 12, 10i + 12].
+     */
+    static Array<Block> Street(int n_blocks) {
+        Array<Block> blocks;
+        for (int i = 0; i < n_blocks; ++i) {
+            double x = 10.0 * i;
+            blocks.emplace_back(RBox3D(x - 5.0, x + 5.0, -1.0, 1.0, 0.0, 2.0),
+                                RBox3D(x - 12.0, x + 12.0, -20.0, 20.0,
+                                       -5.0, 20.0));
+        }
+        return blocks;
+    }
+
+    static void CheckFrame(const Compositor& compositor, const Frame& frame) {
+        const Compositor::Options& options = compositor.options();
+        ASSERT(!frame.blocks.empty());
+        ASSERT(frame.blocks.size() <= options.max_blocks);
+        ASSERT_EQ(frame.weights.size(), frame.blocks.size());
+        ASSERT_EQ(frame.budgets.size(), frame.blocks.size());
+
+        double sum = 0.0, budget = 0.0;
+        for (int i = 0; i < frame.blocks.size(); ++i) {
+            ASSERT(frame.weights[i] > 0.0);
+            if (i > 0) ASSERT(frame.weights[i] <= frame.weights[i - 1]);
+            ASSERT(frame.budgets[i] >= options.min_budget);
+            ASSERT(frame.budgets[i] <= 1.0);
+            sum += frame.weights[i];
+            budget += frame.budgets[i];
+        }
+        ASSERT_EQ_NEAR(sum, 1.0, 1e-12);
+        ASSERT(budget <= options.budget + 1e-12);
+    }
+
+    /**
+     * Return the weight of the block in the frame, or zero.
+     */
+    static double Weight(const Frame& frame, int block) {
+        for (int i = 0; i < frame.blocks.size(); ++i) {
+            if (frame.blocks[i] == block) return frame.weights[i];
+        }
+        return 0.0;
+    }
+};
+
+TEST_F(BlockCompositorTest, SingleBlock) {
+    Compositor compositor;
+    compositor.Reset(Street(1));
+
+    Frame frame;
+    compositor.Plan(RPoint3D(1.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks.size(), 1);
+    ASSERT_EQ(frame.blocks[0], 0);
+    ASSERT_EQ(frame.weights[0], 1.0);
+    ASSERT_EQ(frame.budgets[0], 1.0);
+
+    // Far away from all blocks, the nearest one is still rendered.
+    compositor.Reset(Street(3));
+    compositor.Plan(RPoint3D(100.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks.size(), 1);
+    ASSERT_EQ(frame.blocks[0], 2);
+
+    compositor.Reset(Array<Block>());
+    compositor.Plan(RPoint3D(0.0, 0.0, 0.0), &frame);
+    ASSERT(frame.blocks.empty());
+}
+
+TEST_F(BlockCompositorTest, SmoothTransition) {
+    Compositor compositor;
+    compositor.Reset(Street(10));
+
+    // Drive along the street, 0.1 meter per frame.
+    Frame frame, last;
+    int primary = 0, n_switches = 0;
+    for (int t = 0; t <= 900; ++t) {
+        compositor.Plan(RPoint3D(0.1 * t, 0.0, 1.0), &frame);
+        CheckFrame(compositor, frame);
+
+        // Each block is rendered where it can be.
+        for (int b : frame.blocks) {
+            ASSERT(std::fabs(0.1 * t - 10.0 * b) <= 12.0);
+        }
+
+        // No pop: the weights change gradually.
+        if (t > 0) {
+            for (int b = 0; b < 10; ++b) {
+                ASSERT(std::fabs(Weight(frame, b) - Weight(last, b)) < 0.2);
+            }
+        }
+        if (frame.blocks[0] != primary) {
+            ASSERT_EQ(frame.blocks[0], primary + 1);
+            primary = frame.blocks[0];
+            ++n_switches;
+        }
+        last = frame;
+    }
+    ASSERT_EQ(primary, 9);
+    ASSERT_EQ(n_switches, 9);
+
+    // Halfway between two origins, both blocks are blended evenly.
+    Compositor::Options options;
+    options.max_step = 1.0;
+    Compositor direct(options);
+    direct.Reset(Street(10));
+    direct.Plan(RPoint3D(45.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks.size(), 2);
+    ASSERT_EQ_NEAR(frame.weights[0], 0.5, 1e-12);
+    ASSERT_EQ(frame.blocks[0], 4);
+    ASSERT_EQ(frame.blocks[1], 5);
+}
+
+TEST_F(BlockCompositorTest, Hysteresis) {
+    Compositor::Options options;
+    options.max_blocks = 1;
+    options.max_step = 1.0;
+    options.hysteresis = 0.5;
+    Compositor compositor(options);
+    compositor.Reset(Street(3));
+
+    // Jitter around the middle of blocks 0 and 1 keeps block 0.
+    Frame frame;
+    for (int t = 0; t < 100; ++t) {
+        double x = t % 2 ? 5.2 : 4.8;
+        compositor.Plan(RPoint3D(x, 0.0, 1.0), &frame);
+        ASSERT_EQ(frame.blocks.size(), 1);
+        ASSERT_EQ(frame.blocks[0], 0);
+    }
+
+    // Block 1 takes over once it is clearly better, and keeps the jitter.
+    compositor.Plan(RPoint3D(6.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks[0], 1);
+    for (int t = 0; t < 100; ++t) {
+        double x = t % 2 ? 5.2 : 4.8;
+        compositor.Plan(RPoint3D(x, 0.0, 1.0), &frame);
+        ASSERT_EQ(frame.blocks[0], 1);
+    }
+
+    // Without hysteresis, the block follows the jitter.
+    options.hysteresis = 0.0;
+    Compositor jittery(options);
+    jittery.Reset(Street(3));
+    jittery.Plan(RPoint3D(5.2, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks[0], 1);
+    jittery.Plan(RPoint3D(4.8, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks[0], 0);
+}
+
+TEST_F(BlockCompositorTest, SingleSlot) {
+    Compositor::Options options;
+    options.max_blocks = 1;
+    Compositor compositor(options);
+    compositor.Reset(Street(3));
+
+    Frame frame;
+    compositor.Plan(RPoint3D(0.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks[0], 0);
+
+    // At x = 20, only block 2 is a target. Its slot is held by block 0,
+    // which is evicted.
+    for (int t = 0; t < 3; ++t) {
+        compositor.Plan(RPoint3D(20.0, 0.0, 1.0), &frame);
+        CheckFrame(compositor, frame);
+        ASSERT_EQ(frame.blocks.size(), 1);
+        ASSERT_EQ(frame.blocks[0], 2);
+    }
+}
+
+TEST_F(BlockCompositorTest, Jump) {
+    Compositor compositor;
+    compositor.Reset(Street(3));
+
+    // Halfway between blocks 0 and 1, both are blended evenly.
+    Frame frame, last;
+    for (int t = 0; t < 20; ++t) {
+        compositor.Plan(RPoint3D(5.0, 0.0, 1.0), &frame);
+    }
+    ASSERT_EQ(frame.blocks.size(), 2);
+    ASSERT_EQ_NEAR(frame.weights[0], 0.5, 1e-12);
+
+    // Jump to block 2 without a restart. Both slots are held by leaving
+    // blocks, so the lighter one is evicted, and the other one fades out.
+    last = frame;
+    for (int t = 0; t < 10; ++t) {
+        compositor.Plan(RPoint3D(20.0, 0.0, 1.0), &frame);
+        CheckFrame(compositor, frame);
+        ASSERT(Weight(frame, 2) > 0.0);
+        ASSERT(Weight(frame, 0) <= Weight(last, 0));
+        ASSERT(Weight(frame, 1) <= Weight(last, 1));
+        last = frame;
+    }
+    ASSERT_EQ(frame.blocks.size(), 1);
+    ASSERT_EQ(frame.blocks[0], 2);
+    ASSERT_EQ(frame.weights[0], 1.0);
+}
+
+TEST_F(BlockCompositorTest, Visibility) {
+    Compositor::Options options;
+    options.max_step = 1.0;
+    Compositor compositor(options);
+
+    // Block 1 is empty, and block 2 is half visible.
+    Array<Block> blocks = Street(3);
+    blocks[1].visibility = 0.0;
+    blocks[2].visibility = 0.5;
+    compositor.Reset(blocks);
+
+    Frame frame;
+    for (int t = 0; t <= 200; ++t) {
+        compositor.Plan(RPoint3D(0.1 * t, 0.0, 1.0), &frame);
+        ASSERT_EQ(Weight(frame, 1), 0.0);
+    }
+
+    compositor.Restart();
+    compositor.Plan(RPoint3D(10.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks.size(), 2);
+    ASSERT_EQ(frame.blocks[0], 0);
+    ASSERT_EQ(frame.blocks[1], 2);
+    ASSERT_EQ_NEAR(frame.weights[0], 2.0 / 3.0, 1e-12);
+}
+
+TEST_F(BlockCompositorTest, Budget) {
+    Compositor::Options options;
+    options.max_step = 1.0;
+    Compositor compositor(options);
+    compositor.Reset(Street(2));
+
+    // The weights are 0.9 and 0.1: the first block gets a full frame, and
+    // the rest goes to the second.
+    double x = 10.0 / (1.0 + std::pow(9.0, 0.25));
+    Frame frame;
+    compositor.Plan(RPoint3D(x, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks.size(), 2);
+    ASSERT_EQ_NEAR(frame.weights[0], 0.9, 1e-12);
+    ASSERT_EQ_NEAR(frame.budgets[0], 1.0, 1e-12);
+    ASSERT_EQ_NEAR(frame.budgets[1], 0.5, 1e-12);
+
+    // Light blocks are dropped.
+    compositor.Plan(RPoint3D(2.0, 0.0, 1.0), &frame);
+    ASSERT_EQ(frame.blocks.size(), 1);
+    ASSERT_EQ(frame.budgets[0], 1.0);
+}
+
+TEST_F(BlockCompositorTest, Deterministic) {
+    Compositor compositor;
+    compositor.Reset(Street(20));
+
+    Array<Frame> frames;
+    for (int pass = 0; pass < 2; ++pass) {
+        compositor.Restart();
+        for (int t = 0; t < 500; ++t) {
+            double x = 0.4 * t + 3.0 * std::sin(0.05 * t);
+            Frame frame;
+            compositor.Plan(RPoint3D(x, 0.5, 1.0), &frame);
+            if (pass == 0) {
+                frames.push_back(frame);
+            } else {
+                const Frame& f = frames[t];
+                ASSERT_EQ_RANGE(frame.blocks.begin(), frame.blocks.end(),
+                                f.blocks.begin(), f.blocks.end());
+                ASSERT_EQ_RANGE(frame.weights.begin(), frame.weights.end(),
+                                f.weights.begin(), f.weights.end());
+                ASSERT_EQ_RANGE(frame.budgets.begin(), frame.budgets.end(),
+                                f.budgets.begin(), f.budgets.end());
+            }
+        }
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_BLOCK_COMPOSITOR_TEST_H_
@@ -0,0 +1,107 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_NORMAL_ESTIMATION_3D_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_NORMAL_ESTIMATION_3D_PERFORMANCE_TEST_H_
+
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/point_cloud/normal_estimation_3d.h"
+#include "codelibrary/point_cloud/pca_normals_3d.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the normal estimation and orientation on 1M and 10M point clouds.
+ *
+ * The reference is the serial PCANormals() and is only measured on 1M points.
+ */
+class NormalEstimation3DPerformanceTest : public Test {
+protected:
+    /**
+     * Generate n points on a wavy terrain of 100m x 100m.
+     */
+    static void RandomTerrain(int n, Array<FPoint3D>* points) {
+        std::mt19937 random;
+        std::uniform_real_distribution<float> uniform(0.0f, 100.0f);
+        std::normal_distribution<float> noise(0.0f, 0.001f);
+
+        points->resize(n);
+        for (int i = 0; i < n; ++i) {
+            const float x = uniform(random), y = uniform(random);
+            (*points)[i] = FPoint3D(x, y, std::sin(0.3f * x) *
+                                          std::cos(0.3f * y) + noise(random));
+        }
+    }
+
+    /**
+     * Return the average time of 'f' over 'n' runs.
+     */
+    template <typename Function>
+    static std::string Time(int n, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return timer.average_time(n);
+    }
+};
+
+TEST_F(NormalEstimation3DPerformanceTest, Terrain) {
+    printf("\n");
+    printf("Normals of a terrain, k = 16       Reference         New\n");
+    printf("---------------------------------------------------------\n");
+    for (int n : { 1000000, 10000000 }) {
+        Array<FPoint3D> points;
+        RandomTerrain(n, &points);
+        KDTree<FPoint3D> kd_tree;
+        std::string t = Time(1, [&]() { kd_tree.SwapPoints(&points); });
+        printf("Build KD tree, %-8d points %28s\n", n, t.c_str());
+
+        Array<FVector3D> normals;
+        Array<float> curvatures, confidences;
+        std::string t1 = "-";
+        if (n <= 1000000) {
+            t1 = Time(1, [&]() {
+                point_cloud::PCANormals(kd_tree, 16, &normals);
+            });
+        }
+        std::string t2 = Time(1, [&]() {
+            point_cloud::ParallelPCANormals(kd_tree, 16, &normals, &curvatures,
+                                            &confidences);
+        });
+        printf("PCA normals, %-8d points %14s %11s\n", n, t1.c_str(),
+               t2.c_str());
+
+        t = Time(1, [&]() {
+            point_cloud::MSTOrientNormals(kd_tree, 8, &normals);
+        });
+        printf("MST orientation, %-8d points %26s\n", n, t.c_str());
+
+        t = Time(1, [&]() {
+            point_cloud::SensorOrientNormals(kd_tree.points(),
+                                             FPoint3D(50.0f, 50.0f, 10.0f),
+                                             &normals);
+        });
+        printf("Sensor orientation, %-8d points %23s\n", n, t.c_str());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_NORMAL_ESTIMATION_3D_PERFORMANCE_TEST_H_
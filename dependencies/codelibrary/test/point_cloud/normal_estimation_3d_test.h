@@ -0,0 +1,213 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_NORMAL_ESTIMATION_3D_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_NORMAL_ESTIMATION_3D_TEST_H_
+
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/point_cloud/normal_estimation_3d.h"
+#include "codelibrary/point_cloud/pca_normals_3d.h"
+
+namespace cl {
+namespace test {
+
+class NormalEstimation3DTest : public Test {
+protected:
+    /**
+     * Uniform random points on the sphere with the given center and radius.
+     */
+    void RandomSphere(const RPoint3D& center, double radius, int n,
+                      Array<RPoint3D>* points) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (int i = 0; i < n; ++i) {
+            const double z = 2.0 * uniform(random_) - 1.0;
+            const double phi = 2.0 * M_PI * uniform(random_);
+            const double r = std::sqrt(1.0 - z * z);
+            points->push_back(center + radius * RVector3D(r * std::cos(phi),
+                                                         r * std::sin(phi), z));
+        }
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(NormalEstimation3DTest, Eigen) {
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (int t = 0; t < 1000; ++t) {
+        // Random symmetric matrix, with a double eigenvalue every 4 tests.
+        double a[6];
+        for (double& v : a) v = uniform(random_);
+        if (t % 4 == 0) {
+            const RVector3D u = Normalize(RVector3D(uniform(random_),
+                                                    uniform(random_),
+                                                    uniform(random_)));
+            a[0] = u.x * u.x; a[1] = u.x * u.y; a[2] = u.x * u.z;
+            a[3] = u.y * u.y; a[4] = u.y * u.z; a[5] = u.z * u.z;
+        }
+
+        double w[3];
+        point_cloud::normal_estimation_internal::SymmetricEigenvalues(a, w);
+        ASSERT(w[0] <= w[1] + 1e-12 && w[1] <= w[2] + 1e-12);
+        ASSERT_EQ_NEAR(w[0] + w[1] + w[2], a[0] + a[3] + a[5], 1e-9);
+
+        for (int i = 0; i < 3; ++i) {
+            double v[3];
+            point_cloud::normal_estimation_internal::SymmetricEigenvector(
+                        a, w[i], v);
+            ASSERT_EQ_NEAR(v[0] * v[0] + v[1] * v[1] + v[2] * v[2], 1.0,
+                           1e-9);
+
+            // A v = lambda v.
+            const double av[3] = { a[0] * v[0] + a[1] * v[1] + a[2] * v[2],
+                                   a[1] * v[0] + a[3] * v[1] + a[4] * v[2],
+                                   a[2] * v[0] + a[4] * v[1] + a[5] * v[2] };
+            for (int j = 0; j < 3; ++j) {
+                ASSERT_EQ_NEAR(av[j], w[i] * v[j], 1e-6);
+            }
+        }
+
+        double w1[3], v1[3];
+        point_cloud::normal_estimation_internal::SymmetricEigensystem(a, w1,
+                                                                      v1);
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_EQ_NEAR(w1[i], w[i], 1e-6);
+        }
+        ASSERT_EQ_NEAR(v1[0] * v1[0] + v1[1] * v1[1] + v1[2] * v1[2], 1.0,
+                       1e-9);
+        const double av[3] = { a[0] * v1[0] + a[1] * v1[1] + a[2] * v1[2],
+                               a[1] * v1[0] + a[3] * v1[1] + a[4] * v1[2],
+                               a[2] * v1[0] + a[4] * v1[1] + a[5] * v1[2] };
+        for (int j = 0; j < 3; ++j) {
+            ASSERT_EQ_NEAR(av[j], w1[0] * v1[j], 1e-9);
+        }
+    }
+
+    // Zero matrix.
+    const double zero[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    double w[3], v[3];
+    point_cloud::normal_estimation_internal::SymmetricEigenvalues(zero, w);
+    point_cloud::normal_estimation_internal::SymmetricEigenvector(zero, w[0],
+                                                                  v);
+    ASSERT_EQ(v[0] * v[0] + v[1] * v[1] + v[2] * v[2], 1.0);
+}
+
+TEST_F(NormalEstimation3DTest, Plane) {
+    // A noisy tilted plane far from the origin.
+    std::uniform_real_distribution<double> uniform(0.0, 10.0);
+    std::normal_distribution<double> noise(0.0, 0.001);
+    const RVector3D normal = Normalize(RVector3D(1.0, 2.0, 3.0));
+    const RVector3D u = Normalize(RVector3D(2.0, -1.0, 0.0));
+    const RVector3D v = CrossProduct(normal, u);
+    const RPoint3D origin(1e4, 2e4, -3e3);
+    Array<RPoint3D> points;
+    for (int i = 0; i < 20000; ++i) {
+        points.push_back(origin + uniform(random_) * u + uniform(random_) * v +
+                         noise(random_) * normal);
+    }
+
+    KDTree<RPoint3D> kd_tree(points);
+    Array<RVector3D> normals, reference;
+    Array<double> curvatures, confidences;
+    point_cloud::ParallelPCANormals(kd_tree, 16, &normals, &curvatures,
+                                    &confidences);
+    point_cloud::PCANormals(kd_tree, 16, &reference);
+    ASSERT_EQ(normals.size(), points.size());
+
+    for (int i = 0; i < points.size(); ++i) {
+        ASSERT_EQ_NEAR(normals[i].norm(), 1.0, 1e-9);
+        ASSERT(std::fabs(DotProduct(normals[i], normal)) > 0.99);
+        ASSERT_EQ_NEAR(std::fabs(DotProduct(normals[i], reference[i])), 1.0,
+                       1e-6);
+        ASSERT(curvatures[i] >= 0.0 && curvatures[i] < 0.01);
+        ASSERT(confidences[i] > 0.9 && confidences[i] <= 1.0);
+    }
+
+    // Points on a line are not confident.
+    Array<RPoint3D> line;
+    for (int i = 0; i < 100; ++i) {
+        line.push_back(origin + (0.1 * i) * u);
+    }
+    point_cloud::ParallelPCANormals(line, 8, &normals, &curvatures,
+                                    &confidences);
+    for (int i = 0; i < line.size(); ++i) {
+        ASSERT_EQ_NEAR(normals[i].norm(), 1.0, 1e-9);
+        ASSERT(std::fabs(DotProduct(normals[i], u)) < 1e-6);
+        ASSERT(confidences[i] < 1e-6);
+    }
+}
+
+TEST_F(NormalEstimation3DTest, MSTOrientation) {
+    // Two spheres far apart form two components of the Riemannian graph.
+    const RPoint3D centers[2] = { { 0.0, 0.0, 0.0 }, { 10.0, 0.0, 0.0 } };
+    Array<RPoint3D> points;
+    RandomSphere(centers[0], 1.0, 10000, &points);
+    RandomSphere(centers[1], 2.0, 20000, &points);
+
+    KDTree<RPoint3D> kd_tree(points);
+    Array<RVector3D> normals;
+    Array<double> curvatures;
+    point_cloud::ParallelPCANormals(kd_tree, 16, &normals, &curvatures);
+
+    for (int i = 0; i < points.size(); ++i) {
+        const RVector3D r = points[i] - centers[i < 10000 ? 0 : 1];
+        ASSERT(std::fabs(DotProduct(normals[i], r)) > 0.98 * r.norm());
+        ASSERT(curvatures[i] < 0.05);
+    }
+
+    // The highest points face up, so all normals point outwards.
+    point_cloud::MSTOrientNormals(kd_tree, 8, &normals);
+    for (int i = 0; i < points.size(); ++i) {
+        const RVector3D r = points[i] - centers[i < 10000 ? 0 : 1];
+        ASSERT(DotProduct(normals[i], r) > 0.0);
+    }
+
+    // Sensors inside the spheres.
+    Array<RPoint3D> origins(points.size());
+    for (int i = 0; i < points.size(); ++i) {
+        origins[i] = centers[i < 10000 ? 0 : 1];
+    }
+    point_cloud::SensorOrientNormals(points, origins, &normals);
+    for (int i = 0; i < points.size(); ++i) {
+        ASSERT(DotProduct(normals[i], origins[i] - points[i]) > 0.0);
+    }
+    point_cloud::SensorOrientNormals(points, RPoint3D(5.0, 0.0, 100.0),
+                                     &normals);
+    for (int i = 0; i < points.size(); ++i) {
+        ASSERT(DotProduct(normals[i], RPoint3D(5.0, 0.0, 100.0) - points[i]) >=
+               0.0);
+    }
+}
+
+TEST_F(NormalEstimation3DTest, MSTOrientationOfTerrain) {
+    // A wavy terrain z = 0.2 sin(3x) cos(3y), whose normals all face up.
+    std::uniform_real_distribution<double> uniform(0.0, 3.0);
+    Array<RPoint3D> points;
+    Array<RVector3D> expect;
+    for (int i = 0; i < 50000; ++i) {
+        const double x = uniform(random_), y = uniform(random_);
+        points.emplace_back(x, y, 0.2 * std::sin(3.0 * x) * std::cos(3.0 * y));
+        expect.push_back(Normalize(RVector3D(
+                -0.6 * std::cos(3.0 * x) * std::cos(3.0 * y),
+                 0.6 * std::sin(3.0 * x) * std::sin(3.0 * y), 1.0)));
+    }
+
+    Array<RVector3D> normals;
+    point_cloud::ParallelPCANormals(points, 12, &normals);
+    point_cloud::MSTOrientNormals(points, 8, &normals);
+    for (int i = 0; i < points.size(); ++i) {
+        ASSERT(DotProduct(normals[i], expect[i]) > 0.95);
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_NORMAL_ESTIMATION_3D_TEST_H_
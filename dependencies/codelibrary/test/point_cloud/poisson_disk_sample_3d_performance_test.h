@@ -0,0 +1,101 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_PERFORMANCE_TEST_H_
+
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/point_cloud/poisson_disk_sample_3d.h"
+#include "codelibrary/point_cloud/sampling.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the throughput of Poisson-disk decimation on a 10M-point LiDAR-like
+ * cloud, compared with OctreeSample() at the same resolution.
+ */
+class PoissonDiskSample3DPerformanceTest : public Test {
+protected:
+    /**
+     * Generate n points on a 100m x 100m wavy ground with 1cm noise.
+     */
+    static void RandomGround(int n, Array<FPoint3D>* points) {
+        std::mt19937 random;
+        std::uniform_real_distribution<float> uniform(0.0f, 100.0f);
+        std::normal_distribution<float> noise(0.0f, 0.01f);
+
+        points->resize(n);
+        for (int i = 0; i < n; ++i) {
+            const float x = uniform(random), y = uniform(random);
+            (*points)[i] = FPoint3D(x, y, std::sin(0.3f * x) *
+                                          std::cos(0.3f * y) + noise(random));
+        }
+    }
+
+    /**
+     * Return the average time of 'f' over 'n' runs.
+     */
+    template <typename Function>
+    static std::string Time(int n, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return timer.average_time(n);
+    }
+};
+
+TEST_F(PoissonDiskSample3DPerformanceTest, Ground10M) {
+    const int n = 10000000;
+    Array<FPoint3D> points;
+    RandomGround(n, &points);
+
+    Array<float> importance(n);
+    for (int i = 0; i < n; ++i) {
+        importance[i] = points[i].x / 100.0f;
+    }
+
+    printf("\n");
+    printf("Decimate 10M points         Octree       Poisson  Samples\n");
+    printf("---------------------------------------------------------\n");
+    for (double r : { 0.05, 0.2, 1.0 }) {
+        Array<int> samples1, samples2;
+        std::string t1 = Time(1, [&]() {
+            point_cloud::OctreeSample(points, r, &samples1);
+        });
+        std::string t2 = Time(1, [&]() {
+            point_cloud::PoissonDiskSample3D(points, r, 0, &samples2);
+        });
+        printf("Radius %-10g %15s %13s %8d\n", r, t1.c_str(), t2.c_str(),
+               samples2.size());
+    }
+    {
+        Array<int> samples;
+        std::string t = Time(1, [&]() {
+            point_cloud::PoissonDiskSample3D(points, importance, 0.05, 1.0, 0,
+                                             &samples);
+        });
+        printf("Adaptive, 0.05 to 1.0 %25s %8d\n", t.c_str(),
+               samples.size());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_PERFORMANCE_TEST_H_
@@ -0,0 +1,145 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_TEST_H_
+
+#include <algorithm>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/geometry/distance_3d.h"
+#include "codelibrary/point_cloud/poisson_disk_sample_3d.h"
+
+namespace cl {
+namespace test {
+
+class PoissonDiskSample3DTest : public Test {
+protected:
+    /**
+     * Generate n random points in [0, 1]^3, half of them in a dense cluster.
+     */
+    static void RandomPoints(int n, Array<RPoint3D>* points) {
+        std::mt19937 random;
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::normal_distribution<double> normal(0.5, 0.05);
+
+        points->clear();
+        for (int i = 0; i < n; ++i) {
+            if (i % 2 == 0) {
+                points->emplace_back(uniform(random), uniform(random),
+                                     uniform(random));
+            } else {
+                points->emplace_back(normal(random), normal(random),
+                                     normal(random));
+            }
+        }
+    }
+
+    /**
+     * Check the minimum distance of the samples and the maximality by brute
+     * force.
+     */
+    static void Check(const Array<RPoint3D>& points, const Array<double>& radii,
+                      const Array<int>& samples) {
+        Array<bool> selected(points.size(), false);
+        for (int i = 0; i < samples.size(); ++i) {
+            ASSERT(i == 0 || samples[i - 1] < samples[i]);
+            selected[samples[i]] = true;
+        }
+
+        for (int i = 0; i < points.size(); ++i) {
+            bool covered = false;
+            for (int s : samples) {
+                if (s == i) continue;
+
+                const double r = std::max(radii[i], radii[s]);
+                const double d = Distance(points[i], points[s]);
+                if (selected[i]) {
+                    ASSERT(d >= r);
+                } else if (d < r) {
+                    covered = true;
+                }
+            }
+            ASSERT(selected[i] || covered);
+        }
+    }
+};
+
+TEST_F(PoissonDiskSample3DTest, Uniform) {
+    Array<RPoint3D> points;
+    RandomPoints(5000, &points);
+
+    for (double radius : { 0.01, 0.05, 0.2, 2.0 }) {
+        Array<int> samples;
+        point_cloud::PoissonDiskSample3D(points, radius, 1, &samples);
+        Check(points, Array<double>(points.size(), radius), samples);
+    }
+
+    // Zero radius keeps all points.
+    Array<int> samples;
+    point_cloud::PoissonDiskSample3D(points, 0.0, 1, &samples);
+    ASSERT_EQ(samples.size(), points.size());
+
+    // Duplicated points.
+    Array<RPoint3D> duplicates(100, RPoint3D(1.0, 2.0, 3.0));
+    point_cloud::PoissonDiskSample3D(duplicates, 0.1, 1, &samples);
+    ASSERT_EQ(samples.size(), 1);
+}
+
+TEST_F(PoissonDiskSample3DTest, Adaptive) {
+    Array<RPoint3D> points;
+    RandomPoints(5000, &points);
+
+    // Points with larger x are more important.
+    Array<double> importance(points.size());
+    for (int i = 0; i < points.size(); ++i) {
+        importance[i] = points[i].x;
+    }
+
+    Array<int> samples;
+    point_cloud::PoissonDiskSample3D(points, importance, 0.02, 0.2, 7,
+                                     &samples);
+    Array<double> radii(points.size());
+    for (int i = 0; i < points.size(); ++i) {
+        radii[i] = 0.2 - 0.18 * Clamp(importance[i], 0.0, 1.0);
+    }
+    Check(points, radii, samples);
+
+    int n_left = 0, n_right = 0;
+    for (int s : samples) {
+        if (points[s].x < 0.5) ++n_left; else ++n_right;
+    }
+    ASSERT(n_right > 2 * n_left);
+}
+
+TEST_F(PoissonDiskSample3DTest, Deterministic) {
+    Array<RPoint3D> points;
+    RandomPoints(20000, &points);
+
+    Array<int> samples1, samples2, samples3;
+    point_cloud::PoissonDiskSample3D(points, 0.03, 42, &samples1);
+    point_cloud::PoissonDiskSample3D(points, 0.03, 42, &samples2);
+    point_cloud::PoissonDiskSample3D(points, 0.03, 43, &samples3);
+    ASSERT_EQ_RANGE(samples1.begin(), samples1.end(),
+                    samples2.begin(), samples2.end());
+    ASSERT(samples1.size() != samples3.size() ||
+           !std::equal(samples1.begin(), samples1.end(), samples3.begin()));
+
+    Array<RPoint3D> sample_points;
+    point_cloud::PoissonDiskSample3D(points, 0.03, 42, &sample_points);
+    ASSERT_EQ(sample_points.size(), samples1.size());
+    for (int i = 0; i < samples1.size(); ++i) {
+        ASSERT(sample_points[i] == points[samples1[i]]);
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_POISSON_DISK_SAMPLE_3D_TEST_H_
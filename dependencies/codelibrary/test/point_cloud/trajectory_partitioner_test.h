@@ -0,0 +1,237 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_TRAJECTORY_PARTITIONER_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_TRAJECTORY_PARTITIONER_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/point_cloud/trajectory_partitioner.h"
+
+namespace cl {
+namespace test {
+
+using Partitioner = point_cloud::TrajectoryPartitioner<double>;
+
+/**
+ * A street along the x-axis with one station per meter, and building points
+ * on both sides. The street is 'density' times denser in [x0, x1).
+ */
+inline void CreateStreet(int n_stations, double x0, double x1, int density,
+                         Array<RPoint3D>* stations, Array<RPoint3D>* points) {
+    std::mt19937 random(n_stations);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    stations->clear();
+    points->clear();
+    for (int i = 0; i < n_stations; ++i) {
+        stations->emplace_back(i, 0.0, 1.5);
+        int n = (i >= x0 && i < x1) ? 20 * density : 20;
+        for (int j = 0; j < n; ++j) {
+            double side = j % 2 ? 8.0 : -8.0;
+            points->emplace_back(i + u(random) - 0.5, side + u(random),
+                                 10.0 * u(random));
+        }
+    }
+}
+
+/**
+ * Check the guarantees of the partition: the cores partition the stations in
+ * order, each block contains its core, the blocks of each piece overlap by the
+ * given stations around each cut, and the boxes bound stations and points.
+ */
+inline void CheckPartition(const Array<RPoint3D>& stations,
+                           const Array<RPoint3D>& points,
+                           const Partitioner& partitioner,
+                           const Array<Partitioner::Block>& blocks,
+                           const Array<int>& piece_firsts) {
+    const Partitioner::Options& options = partitioner.options();
+    int n = stations.size();
+
+    Array<int> covered(n, 0);
+    int next = 0;
+    for (int k = 0; k < blocks.size(); ++k) {
+        const Partitioner::Block& b = blocks[k];
+        ASSERT_EQ(b.core_first, next);
+        ASSERT(b.core_first < b.core_last);
+        ASSERT(b.first <= b.core_first && b.core_last <= b.last);
+        next = b.core_last;
+
+        // The piece of the block.
+        int piece = static_cast<int>(std::upper_bound(piece_firsts.begin(),
+                piece_firsts.end(), b.core_first) - piece_firsts.begin()) - 1;
+        int piece_first = piece_firsts[piece];
+        int piece_last = piece + 1 < piece_firsts.size()
+                         ? piece_firsts[piece + 1] : n;
+        ASSERT_EQ(b.first, std::max(piece_first,
+                                    b.core_first - options.overlap));
+        ASSERT_EQ(b.last, std::min(piece_last, b.core_last + options.overlap));
+
+        for (int i = b.first; i < b.last; ++i) {
+            ++covered[i];
+            ASSERT(stations[i].x >= b.box.x_min());
+            ASSERT(stations[i].x <= b.box.x_max());
+        }
+
+        // Overlap with the next block of the same piece.
+        if (k + 1 < blocks.size() && b.core_last < piece_last) {
+            const Partitioner::Block& c = blocks[k + 1];
+            int shared = std::min(b.last, c.last) -
+                         std::max(b.first, c.first);
+            int cut = b.core_last;
+            ASSERT_EQ(shared, std::min(options.overlap, cut - piece_first) +
+                              std::min(options.overlap, piece_last - cut));
+        } else if (k + 1 < blocks.size()) {
+            ASSERT(b.last <= blocks[k + 1].first);
+        }
+    }
+    ASSERT_EQ(next, n);
+    for (int i = 0; i < n; ++i) {
+        ASSERT(covered[i] >= 1);
+    }
+
+    // Every point lies in the box of the blocks of its station.
+    Array<int> owners;
+    partitioner.AssignPoints(stations, points, &owners);
+    for (int i = 0; i < points.size(); ++i) {
+        for (const Partitioner::Block& b : blocks) {
+            if (owners[i] < b.first || owners[i] >= b.last) continue;
+            const RPoint3D& q = points[i];
+            ASSERT(q.x >= b.box.x_min() && q.x <= b.box.x_max());
+            ASSERT(q.y >= b.box.y_min() && q.y <= b.box.y_max());
+            ASSERT(q.z >= b.box.z_min() && q.z <= b.box.z_max());
+        }
+    }
+}
+
+TEST(TrajectoryPartitionerTest, CoverageAndOverlap) {
+    Array<RPoint3D> stations, points;
+    CreateStreet(1000, 0.0, 0.0, 1, &stations, &points);
+
+    for (int overlap : { 0, 7, 40, 500 }) {
+        Partitioner::Options options;
+        options.target_size = 90;
+        options.overlap = overlap;
+        Partitioner partitioner(options);
+
+        Array<Partitioner::Block> blocks;
+        partitioner.Partition(stations, points, &blocks);
+        ASSERT_EQ(blocks.size(), 12);
+        CheckPartition(stations, points, partitioner, blocks,
+                       Array<int>(1, 0));
+
+        // Uniform density gives equal cores, up to rounding.
+        for (const Partitioner::Block& b : blocks) {
+            ASSERT(std::abs(b.core_last - b.core_first - 1000.0 / 12) <= 1.0);
+            ASSERT_EQ(b.center.x, (b.first + b.last) / 2);
+        }
+    }
+}
+
+TEST(TrajectoryPartitionerTest, BalanceDensity) {
+    Array<RPoint3D> stations, points;
+    CreateStreet(1000, 500.0, 1000.0, 5, &stations, &points);
+
+    Partitioner::Options options;
+    options.target_size = 100;
+    options.overlap = 10;
+    Partitioner partitioner(options);
+
+    Array<Partitioner::Block> blocks;
+    partitioner.Partition(stations, points, &blocks);
+    ASSERT_EQ(blocks.size(), 10);
+    CheckPartition(stations, points, partitioner, blocks, Array<int>(1, 0));
+
+    // Dense blocks are shorter, and the costs are balanced.
+    double max_cost = 0.0, min_cost = DBL_MAX;
+    for (const Partitioner::Block& b : blocks) {
+        max_cost = std::max(max_cost, b.cost);
+        min_cost = std::min(min_cost, b.cost);
+    }
+    ASSERT(max_cost - min_cost < 5.0);
+    ASSERT(blocks.front().core_last - blocks.front().core_first >
+           1.5 * (blocks.back().core_last - blocks.back().core_first));
+
+    // Without point weight, the station counts are balanced.
+    options.point_weight = 0.0;
+    Partitioner counter(options);
+    counter.Partition(stations, points, &blocks);
+    for (const Partitioner::Block& b : blocks) {
+        ASSERT_EQ(b.core_last - b.core_first, 100);
+    }
+}
+
+TEST(TrajectoryPartitionerTest, Gaps) {
+    // Three streets far from each other.
+    Array<RPoint3D> stations, points, s, p;
+    Array<int> piece_firsts;
+    const int sizes[] = { 250, 30, 171 };
+    for (int k = 0; k < 3; ++k) {
+        CreateStreet(sizes[k], 0.0, 0.0, 1, &s, &p);
+        piece_firsts.push_back(stations.size());
+        for (RPoint3D& q : s) {
+            q.y += 1000.0 * k;
+        }
+        for (RPoint3D& q : p) {
+            q.y += 1000.0 * k;
+        }
+        stations.insert(s);
+        points.insert(p);
+    }
+
+    Partitioner::Options options;
+    options.target_size = 50;
+    options.overlap = 20;
+    options.max_gap = 10.0;
+    options.point_radius = 20.0;
+    Partitioner partitioner(options);
+
+    Array<Partitioner::Block> blocks;
+    partitioner.Partition(stations, points, &blocks);
+    ASSERT_EQ(blocks.size(), 5 + 1 + 4);
+    CheckPartition(stations, points, partitioner, blocks, piece_firsts);
+
+    // Deterministic.
+    Array<Partitioner::Block> blocks2;
+    partitioner.Partition(stations, points, &blocks2);
+    ASSERT_EQ(blocks.size(), blocks2.size());
+    for (int i = 0; i < blocks.size(); ++i) {
+        ASSERT_EQ(blocks[i].first, blocks2[i].first);
+        ASSERT_EQ(blocks[i].last, blocks2[i].last);
+        ASSERT_EQ(blocks[i].core_first, blocks2[i].core_first);
+        ASSERT(blocks[i].box == blocks2[i].box);
+        ASSERT_EQ(blocks[i].n_points, blocks2[i].n_points);
+    }
+}
+
+TEST(TrajectoryPartitionerTest, SmallInputs) {
+    Partitioner partitioner;
+    Array<RPoint3D> stations, points;
+    Array<Partitioner::Block> blocks;
+    partitioner.Partition(stations, points, &blocks);
+    ASSERT(blocks.empty());
+
+    // Fewer stations than the target size, and no points.
+    stations.emplace_back(0.0, 0.0, 0.0);
+    stations.emplace_back(1.0, 0.0, 0.0);
+    partitioner.Partition(stations, points, &blocks);
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_EQ(blocks[0].first, 0);
+    ASSERT_EQ(blocks[0].last, 2);
+    ASSERT_EQ(blocks[0].n_points, 0);
+    ASSERT_EQ(blocks[0].box.x_max(), 1.0);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_TRAJECTORY_PARTITIONER_TEST_H_
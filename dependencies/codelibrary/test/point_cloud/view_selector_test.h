@@ -0,0 +1,196 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_POINT_CLOUD_VIEW_SELECTOR_TEST_H_
+#define CODELIBRARY_TEST_POINT_CLOUD_VIEW_SELECTOR_TEST_H_
+
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/point_cloud/view_selector.h"
+
+namespace cl {
+namespace test {
+
+using ViewSelector = point_cloud::ViewSelector<double>;
+
+/**
+ * A 100m street with walls at y = -8 and y = 8, captured by a rig of two
+ * cameras (looking at both walls) every 0.1m, i.e., a 30 fps video at 3 m/s.
+ */
+inline void CreateStreetCapture(Array<ViewSelector::View>* views,
+                                Array<RPoint3D>* points) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    points->clear();
+    for (int i = 0; i < 20000; ++i) {
+        double side = i % 2 ? 8.0 : -8.0;
+        points->emplace_back(100.0 * u(random), side, 10.0 * u(random));
+    }
+
+    views->clear();
+    const RVector3D up(0.0, 0.0, 1.0);
+    for (int i = 0; i <= 1000; ++i) {
+        RPoint3D p(0.1 * i, 0.0, 1.5);
+        for (double side : { -1.0, 1.0 }) {
+            RVector3D forward(0.0, side, 0.0);
+            RVector3D right(side, 0.0, 0.0);
+            views->emplace_back(p, right, up, forward, -1.0, 1.0, -0.5, 1.0,
+                                0.1, 30.0);
+        }
+    }
+}
+
+/**
+ * Check that the selection is sorted, unique and in range.
+ */
+inline void CheckSelection(const Array<int>& selected, int n_views) {
+    for (int i = 0; i < selected.size(); ++i) {
+        ASSERT(selected[i] >= 0 && selected[i] < n_views);
+        if (i > 0) ASSERT(selected[i - 1] < selected[i]);
+    }
+}
+
+TEST(ViewSelectorTest, View) {
+    ViewSelector::View view(RPoint3D(0.0, 0.0, 0.0), RVector3D(1.0, 0.0, 0.0),
+                            RVector3D(0.0, 0.0, 1.0), RVector3D(0.0, 1.0, 0.0),
+                            -1.0, 1.0, -0.5, 0.5, 1.0, 10.0);
+    ASSERT(view.frustum.Contains(RPoint3D(0.0, 5.0, 0.0)));
+    ASSERT(view.frustum.Contains(RPoint3D(4.0, 5.0, 2.0)));
+    ASSERT(!view.frustum.Contains(RPoint3D(6.0, 5.0, 0.0)));
+    ASSERT(!view.frustum.Contains(RPoint3D(0.0, 5.0, 3.0)));
+    ASSERT(!view.frustum.Contains(RPoint3D(0.0, -5.0, 0.0)));
+    ASSERT(!view.frustum.Contains(RPoint3D(0.0, 11.0, 0.0)));
+    ASSERT(!view.frustum.Contains(RPoint3D(0.0, 0.5, 0.0)));
+}
+
+TEST(ViewSelectorTest, RedundantCapture) {
+    Array<ViewSelector::View> views;
+    Array<RPoint3D> points;
+    CreateStreetCapture(&views, &points);
+
+    ViewSelector::Options options;
+    options.voxel_size = 1.0;
+    options.views_per_voxel = 2;
+    ViewSelector selector(options);
+
+    Array<int> selected;
+    selector.Select(views, points, &selected);
+    CheckSelection(selected, views.size());
+
+    // All seen voxels are kept with a small fraction of the frames.
+    ASSERT_EQ(selector.n_views(), views.size());
+    ASSERT(selector.n_voxels() > 0);
+    ASSERT_EQ(selector.n_visible_voxels(), selector.n_voxels());
+    ASSERT_EQ(selector.n_covered_voxels(), selector.n_visible_voxels());
+    ASSERT(selected.size() < views.size() / 10);
+
+    // A lower target coverage keeps fewer frames.
+    options.target_coverage = 0.9;
+    ViewSelector partial(options);
+    Array<int> fewer;
+    partial.Select(views, points, &fewer);
+    CheckSelection(fewer, views.size());
+    ASSERT(fewer.size() < selected.size());
+    ASSERT(partial.n_covered_voxels() >= 0.9 * partial.n_visible_voxels());
+}
+
+TEST(ViewSelectorTest, Budget) {
+    Array<ViewSelector::View> views;
+    Array<RPoint3D> points;
+    CreateStreetCapture(&views, &points);
+
+    int last_covered = 0;
+    for (int budget : { 1, 4, 16, 64 }) {
+        ViewSelector::Options options;
+        options.budget = budget;
+        ViewSelector selector(options);
+
+        Array<int> selected;
+        selector.Select(views, points, &selected);
+        CheckSelection(selected, views.size());
+        ASSERT(selected.size() <= budget);
+        ASSERT(selector.n_covered_voxels() >= last_covered);
+        last_covered = selector.n_covered_voxels();
+    }
+    ASSERT(last_covered > 0);
+}
+
+TEST(ViewSelectorTest, Sharpness) {
+    Array<ViewSelector::View> views, blurry_views;
+    Array<RPoint3D> points;
+    CreateStreetCapture(&views, &points);
+
+    // Every odd view is a blurry copy of the previous one.
+    for (const ViewSelector::View& view : views) {
+        blurry_views.push_back(view);
+        blurry_views.push_back(view);
+        blurry_views.back().sharpness = 0.1;
+    }
+
+    ViewSelector::Options options;
+    options.views_per_voxel = 1;
+    ViewSelector selector(options);
+
+    Array<int> selected;
+    selector.Select(blurry_views, points, &selected);
+    CheckSelection(selected, blurry_views.size());
+    ASSERT(!selected.empty());
+    for (int i : selected) {
+        ASSERT_EQ(i % 2, 0);
+    }
+    ASSERT_EQ(selector.n_covered_voxels(), selector.n_visible_voxels());
+}
+
+TEST(ViewSelectorTest, Novelty) {
+    // One camera per meter along a line, and no points.
+    Array<ViewSelector::View> views;
+    for (int i = 0; i <= 100; ++i) {
+        views.emplace_back(RPoint3D(i, 0.0, 0.0), RVector3D(1.0, 0.0, 0.0),
+                           RVector3D(0.0, 0.0, 1.0), RVector3D(0.0, 1.0, 0.0),
+                           -1.0, 1.0, -1.0, 1.0, 0.1, 10.0);
+    }
+
+    ViewSelector::Options options;
+    options.novelty_distance = 10.0;
+    options.min_novelty = 1.0;
+    ViewSelector selector(options);
+
+    Array<int> selected;
+    selector.Select(views, Array<RPoint3D>(), &selected);
+    ASSERT_EQ(selected.size(), 11);
+    for (int k = 0; k < selected.size(); ++k) {
+        ASSERT_EQ(selected[k], 10 * k);
+    }
+    ASSERT_EQ(selector.n_voxels(), 0);
+
+    // A rotated copy of each view is novel by its direction.
+    Array<ViewSelector::View> rotated = views;
+    for (const ViewSelector::View& v : views) {
+        rotated.emplace_back(v.position, RVector3D(0.0, 1.0, 0.0),
+                             RVector3D(0.0, 0.0, 1.0),
+                             RVector3D(-1.0, 0.0, 0.0),
+                             -1.0, 1.0, -1.0, 1.0, 0.1, 10.0);
+    }
+    options.novelty_angle = 1.0;
+    ViewSelector rotation_selector(options);
+    rotation_selector.Select(rotated, Array<RPoint3D>(), &selected);
+    ASSERT_EQ(selected.size(), 22);
+
+    // No views.
+    selector.Select(Array<ViewSelector::View>(), Array<RPoint3D>(),
+                    &selected);
+    ASSERT(selected.empty());
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_POINT_CLOUD_VIEW_SELECTOR_TEST_H_
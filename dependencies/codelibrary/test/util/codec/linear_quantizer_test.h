@@ -0,0 +1,84 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_CODEC_LINEAR_QUANTIZER_TEST_H_
+#define CODELIBRARY_TEST_UTIL_CODEC_LINEAR_QUANTIZER_TEST_H_
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/codec/linear_quantizer.h"
+
+namespace cl {
+namespace test {
+
+TEST(LinearQuantizerTest, RoundTripError) {
+    std::mt19937 random;
+    std::normal_distribution<float> normal(0.3f, 0.1f);
+
+    Array<float> data(10000);
+    for (float& v : data) {
+        v = normal(random);
+    }
+
+    for (int n_bits : { 1, 4, 8 }) {
+        LinearQuantizer quantizer(n_bits);
+        quantizer.Reset(data.data(), data.size());
+        ASSERT(quantizer.scale() > 0.0f);
+
+        Array<uint8_t> codes(data.size());
+        Array<float> decoded(data.size());
+        quantizer.Quantize(data.data(), data.size(), codes.data());
+        quantizer.Dequantize(codes.data(), codes.size(), decoded.data());
+        for (int i = 0; i < data.size(); ++i) {
+            ASSERT(codes[i] <= quantizer.max_code());
+            ASSERT(std::fabs(decoded[i] - data[i]) <=
+                   quantizer.scale() * 0.5001f);
+        }
+    }
+}
+
+TEST(LinearQuantizerTest, ExactZero) {
+    LinearQuantizer quantizer(4);
+    quantizer.Reset(-0.37f, 1.91f);
+    ASSERT_EQ(quantizer.Dequantize(quantizer.zero_code()), 0.0f);
+    ASSERT_EQ(quantizer.Quantize(0.0f), quantizer.zero_code());
+
+    // A positive range is extended to contain zero.
+    quantizer.Reset(2.0f, 3.0f);
+    ASSERT_EQ(quantizer.zero_code(), 0);
+    ASSERT_EQ(quantizer.Dequantize(quantizer.zero_code()), 0.0f);
+
+    // Restored from the parameters.
+    LinearQuantizer restored(4, quantizer.scale(), quantizer.offset());
+    ASSERT_EQ(restored.Dequantize(7), quantizer.Dequantize(7));
+
+    // Zero stays exact in a range whose offset is not a multiple of the
+    // scale in float.
+    quantizer.Reset(-0.123f, 0.877f);
+    restored = LinearQuantizer(4, quantizer.scale(), quantizer.offset());
+    ASSERT_EQ(restored.zero_code(), quantizer.zero_code());
+    ASSERT_EQ(restored.Dequantize(restored.zero_code()), 0.0f);
+}
+
+TEST(LinearQuantizerTest, ConstantData) {
+    LinearQuantizer quantizer(8);
+    Array<float> data(100, 0.0f);
+    quantizer.Reset(data.data(), data.size());
+    ASSERT_EQ(quantizer.scale(), 0.0f);
+    ASSERT_EQ(quantizer.Quantize(0.0f), 0);
+    ASSERT_EQ(quantizer.Dequantize(0), 0.0f);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_CODEC_LINEAR_QUANTIZER_TEST_H_
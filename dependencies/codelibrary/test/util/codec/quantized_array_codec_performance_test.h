@@ -0,0 +1,215 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_PERFORMANCE_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/util/codec/quantized_array_codec.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Compress the parameters of a synthetic multiresolution hash grid, and
+ * measure the PSNR of the opacity queried from the decoded grid.
+ *
+ * The grid mimics a trained NeRF encoding: L levels of T entries with two
+ * features, the entries touched by training hold normal values that shrink
+ * with the level, and the others keep their initial values in
+ * [-1e-4, 1e-4]. The density at a point is exp(4 s + 3), where s is the sum
+ * of the trilinearly interpolated first features over the levels, and the
+ * opacity of a step of 0.05 is 1 - exp(-0.05 density).
+ */
+class QuantizedArrayCodecPerformanceTest : public Test {
+protected:
+    static const int N_LEVELS = 16;
+    static const int N_FEATURES = 2;
+    static const int LOG2_TABLE_SIZE = 17;
+    static const int BASE_RESOLUTION = 16;
+
+    void SetUp() override {
+        std::mt19937 random;
+        std::uniform_real_distribution<float> init(-1e-4f, 1e-4f);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        int table_size = 1 << LOG2_TABLE_SIZE;
+        double resolution = BASE_RESOLUTION;
+        for (int l = 0; l < N_LEVELS; ++l) {
+            resolutions_[l] = static_cast<int>(resolution);
+            resolution *= 1.38;
+
+            double cells = std::pow(resolutions_[l] + 1.0, 3.0);
+            int n = static_cast<int>(std::min<double>(cells, table_size));
+            segment_sizes_.push_back(n * N_FEATURES);
+
+            // Fine levels are touched sparsely.
+            double touched = std::min(1.0, 4.0 / (l + 1));
+            float sigma = 0.6f * std::pow(0.8f, l);
+            for (int i = 0; i < n * N_FEATURES; ++i) {
+                params_.push_back(uniform(random) < touched
+                                  ? normal(random) * sigma : init(random));
+            }
+        }
+
+        for (int i = 0; i < 100000; ++i) {
+            queries_.push_back(uniform(random));
+            queries_.push_back(uniform(random));
+            queries_.push_back(uniform(random));
+        }
+    }
+
+    /**
+     * Return the opacity at (x, y, z) in [0, 1]^3.
+     */
+    double Opacity(const Array<float>& params, double x, double y,
+                   double z) const {
+        const uint32_t primes[3] = { 1u, 2654435761u, 805459861u };
+
+        double sum = 0.0;
+        int offset = 0;
+        for (int l = 0; l < N_LEVELS; ++l) {
+            int r = resolutions_[l];
+            int n = segment_sizes_[l] / N_FEATURES;
+            bool dense = std::pow(r + 1.0, 3.0) <= n;
+            double p[3] = { x * r, y * r, z * r };
+            int c[3];
+            double w[3];
+            for (int k = 0; k < 3; ++k) {
+                c[k] = std::min(static_cast<int>(p[k]), r - 1);
+                w[k] = p[k] - c[k];
+            }
+
+            for (int corner = 0; corner < 8; ++corner) {
+                uint32_t v[3];
+                double weight = 1.0;
+                for (int k = 0; k < 3; ++k) {
+                    int bit = (corner >> k) & 1;
+                    v[k] = c[k] + bit;
+                    weight *= bit ? w[k] : 1.0 - w[k];
+                }
+                uint32_t index = dense ? (v[2] * (r + 1) + v[1]) * (r + 1) +
+                                         v[0]
+                                       : (v[0] * primes[0] ^ v[1] * primes[1] ^
+                                          v[2] * primes[2]) % n;
+                sum += weight * params[offset + index * N_FEATURES];
+            }
+            offset += segment_sizes_[l];
+        }
+
+        double density = std::exp(4.0 * sum + 3.0);
+        return 1.0 - std::exp(-density * 0.05);
+    }
+
+    /**
+     * Return the PSNR of the opacity of 'decoded' w.r.t. the original.
+     */
+    double PSNR(const Array<float>& decoded) const {
+        double mse = 0.0;
+        int n = queries_.size() / 3;
+        for (int i = 0; i < n; ++i) {
+            const double* q = queries_.data() + 3 * i;
+            double d = Opacity(decoded, q[0], q[1], q[2]) -
+                       Opacity(params_, q[0], q[1], q[2]);
+            mse += d * d;
+        }
+        mse /= n;
+        return mse == 0.0 ? 999.0 : -10.0 * std::log10(mse);
+    }
+
+    int resolutions_[N_LEVELS];
+    Array<int> segment_sizes_;
+    Array<float> params_;
+    Array<double> queries_;
+};
+
+TEST_F(QuantizedArrayCodecPerformanceTest, DensityPSNR) {
+    QuantizedArrayCodec::Options options;
+    options.zero_threshold = 1e-4f;
+    QuantizedArrayCodec codec8(options);
+    options.n_bits = 4;
+    options.clip_ratio = 0.005;
+    QuantizedArrayCodec codec4(options);
+
+    Array<uint8_t> encoded8, encoded4;
+    Array<float> decoded8, decoded4;
+    codec8.Encode(params_, segment_sizes_, &encoded8);
+    codec4.Encode(params_, segment_sizes_, &encoded4);
+    ASSERT(QuantizedArrayCodec::Decode(encoded8, &decoded8));
+    ASSERT(QuantizedArrayCodec::Decode(encoded4, &decoded4));
+
+    // Half precision parameters take 2 bytes each.
+    ASSERT(encoded8.size() < params_.size());
+    ASSERT(encoded4.size() < encoded8.size());
+    ASSERT(PSNR(decoded8) > 40.0);
+    ASSERT(PSNR(decoded4) > 25.0);
+}
+
+TEST_F(QuantizedArrayCodecPerformanceTest, SizeAndSpeed) {
+    struct Setting {
+        const char* name;
+        int n_bits;
+        float zero_threshold;
+        double clip_ratio;
+    };
+    const Setting settings[] = {
+        { "int8",             8, 0.0f,  0.0   },
+        { "int8 + zeroing",   8, 1e-4f, 0.0   },
+        { "int4 + zeroing",   4, 1e-4f, 0.005 },
+    };
+
+    double fp16_size = 2.0 * params_.size();
+    printf("\n");
+    printf("%d parameters, %.2f MB in half precision.\n", params_.size(),
+           fp16_size / (1 << 20));
+    printf("          Codec    Size (MB)  Ratio  Encode (MB/s)  "
+           "Decode (MB/s)  PSNR (dB)\n");
+    printf("-----------------------------------------------------------"
+           "-------------------\n");
+    for (const Setting& setting : settings) {
+        QuantizedArrayCodec::Options options;
+        options.n_bits = setting.n_bits;
+        options.zero_threshold = setting.zero_threshold;
+        options.clip_ratio = setting.clip_ratio;
+        QuantizedArrayCodec codec(options);
+
+        Array<uint8_t> encoded;
+        Timer timer1;
+        timer1.Start();
+        codec.Encode(params_, segment_sizes_, &encoded);
+        timer1.Stop();
+
+        Array<float> decoded;
+        Timer timer2;
+        timer2.Start();
+        QuantizedArrayCodec::Decode(encoded, &decoded);
+        timer2.Stop();
+
+        double megabytes = fp16_size / (1 << 20);
+        printf("%15s %12.2f %6.1f %14.1f %14.1f %10.2f\n", setting.name,
+               encoded.size() / double(1 << 20), fp16_size / encoded.size(),
+               megabytes / timer1.elapsed_seconds(),
+               megabytes / timer2.elapsed_seconds(), PSNR(decoded));
+    }
+    printf("-----------------------------------------------------------"
+           "-------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_PERFORMANCE_TEST_H_
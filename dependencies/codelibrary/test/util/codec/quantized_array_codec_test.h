@@ -0,0 +1,118 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_TEST_H_
+#define CODELIBRARY_TEST_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_TEST_H_
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/codec/quantized_array_codec.h"
+
+namespace cl {
+namespace test {
+
+class QuantizedArrayCodecTest : public Test {
+protected:
+    /**
+     * Two segments with different scales, where about half of the values are
+     * tiny noise.
+     */
+    void SetUp() override {
+        std::mt19937 random;
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        std::uniform_real_distribution<float> noise(-1e-4f, 1e-4f);
+        std::bernoulli_distribution bernoulli(0.5);
+
+        segment_sizes_ = { 1000, 5000 };
+        for (int s = 0; s < segment_sizes_.size(); ++s) {
+            for (int i = 0; i < segment_sizes_[s]; ++i) {
+                data_.push_back(bernoulli(random) ? noise(random)
+                                                  : normal(random) * (s + 1));
+            }
+        }
+    }
+
+    Array<int> segment_sizes_;
+    Array<float> data_;
+};
+
+TEST_F(QuantizedArrayCodecTest, RoundTrip) {
+    QuantizedArrayCodec::Options options;
+    options.zero_threshold = 1e-4f;
+    options.chunk_size = 1024;
+    QuantizedArrayCodec codec(options);
+
+    Array<uint8_t> encoded;
+    codec.Encode(data_, segment_sizes_, &encoded);
+    ASSERT(encoded.size() < data_.size());
+
+    Array<float> decoded;
+    ASSERT(QuantizedArrayCodec::Decode(encoded, &decoded));
+    ASSERT_EQ(decoded.size(), data_.size());
+
+    int first = 0;
+    for (int s = 0; s < segment_sizes_.size(); ++s) {
+        float lo = 0.0f, hi = 0.0f;
+        for (int i = first; i < first + segment_sizes_[s]; ++i) {
+            lo = std::min(lo, data_[i]);
+            hi = std::max(hi, data_[i]);
+        }
+        float step = (hi - lo) / 255.0f;
+        for (int i = first; i < first + segment_sizes_[s]; ++i) {
+            if (std::fabs(data_[i]) <= options.zero_threshold) {
+                ASSERT_EQ(decoded[i], 0.0f);
+            } else {
+                ASSERT(std::fabs(decoded[i] - data_[i]) <= step * 0.5001f);
+            }
+        }
+        first += segment_sizes_[s];
+    }
+}
+
+TEST_F(QuantizedArrayCodecTest, Clipping) {
+    QuantizedArrayCodec::Options options;
+    options.n_bits = 4;
+    options.clip_ratio = 0.01;
+    QuantizedArrayCodec codec(options);
+
+    Array<uint8_t> encoded;
+    codec.Encode(data_, segment_sizes_, &encoded);
+    Array<float> decoded;
+    ASSERT(QuantizedArrayCodec::Decode(encoded, &decoded));
+    ASSERT_EQ(decoded.size(), data_.size());
+
+    // Only about 1% of the nonzero values at each tail are clamped.
+    int n_large_errors = 0;
+    for (int i = 0; i < data_.size(); ++i) {
+        if (std::fabs(decoded[i] - data_[i]) > 0.5f) ++n_large_errors;
+    }
+    ASSERT(n_large_errors < data_.size() / 40);
+}
+
+TEST_F(QuantizedArrayCodecTest, CorruptedStream) {
+    QuantizedArrayCodec codec;
+    Array<uint8_t> encoded;
+    codec.Encode(data_, segment_sizes_, &encoded);
+
+    Array<float> decoded;
+    ASSERT(!QuantizedArrayCodec::Decode(encoded.data(), encoded.size() - 1,
+                                        &decoded));
+    ASSERT(!QuantizedArrayCodec::Decode(encoded.data(), 10, &decoded));
+
+    encoded.push_back(0);
+    ASSERT(!QuantizedArrayCodec::Decode(encoded, &decoded));
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_TEST_H_
@@ -0,0 +1,125 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_CODEC_RANS_CODER_TEST_H_
+#define CODELIBRARY_TEST_UTIL_CODEC_RANS_CODER_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/codec/rans_coder.h"
+
+namespace cl {
+namespace test {
+
+class RANSCoderTest : public Test {
+protected:
+    /**
+     * Encode and decode 'data', and get the encoded size.
+     */
+    static void RoundTrip(const RANSCoder& coder, const Array<uint8_t>& data,
+                          int* size = nullptr) {
+        Array<uint8_t> encoded, decoded;
+        coder.Encode(data, &encoded);
+        ASSERT(coder.Decode(encoded, &decoded));
+        ASSERT_EQ_RANGE(decoded.begin(), decoded.end(),
+                        data.begin(), data.end());
+        if (size) *size = encoded.size();
+    }
+
+    /**
+     * Return the order-0 entropy of 'data' in bytes.
+     */
+    static double Entropy(const Array<uint8_t>& data) {
+        double counts[256] = {};
+        for (uint8_t c : data) {
+            ++counts[c];
+        }
+        double bits = 0.0;
+        for (double count : counts) {
+            if (count > 0.0) bits -= count * std::log2(count / data.size());
+        }
+        return bits / 8.0;
+    }
+};
+
+TEST_F(RANSCoderTest, Empty) {
+    RANSCoder coder;
+    Array<uint8_t> data;
+    RoundTrip(coder, data);
+}
+
+TEST_F(RANSCoderTest, SingleSymbol) {
+    RANSCoder coder(1000);
+    Array<uint8_t> data(100000, 7);
+    int size = 0;
+    RoundTrip(coder, data, &size);
+
+    // No bytes are emitted for a certain symbol, only the header and the
+    // sizes and final states of the chunks.
+    ASSERT_EQ(size, 8 + 512 + 100 * 8);
+}
+
+TEST_F(RANSCoderTest, AllSymbols) {
+    std::mt19937 random;
+    std::uniform_int_distribution<int> uniform(0, 255);
+
+    Array<uint8_t> data(100000);
+    for (uint8_t& c : data) {
+        c = static_cast<uint8_t>(uniform(random));
+    }
+    for (int chunk_size : { 1, 100, 1 << 18 }) {
+        RoundTrip(RANSCoder(chunk_size), data);
+    }
+}
+
+TEST_F(RANSCoderTest, SkewedDistribution) {
+    std::mt19937 random;
+    std::geometric_distribution<int> geometric(0.3);
+
+    Array<uint8_t> data(1 << 20);
+    for (uint8_t& c : data) {
+        c = static_cast<uint8_t>(std::min(geometric(random), 255));
+    }
+
+    RANSCoder coder(1 << 16);
+    int size = 0;
+    RoundTrip(coder, data, &size);
+    ASSERT(size < Entropy(data) * 1.01 + 1024);
+}
+
+TEST_F(RANSCoderTest, CorruptedStream) {
+    std::mt19937 random;
+    std::geometric_distribution<int> geometric(0.1);
+
+    Array<uint8_t> data(10000);
+    for (uint8_t& c : data) {
+        c = static_cast<uint8_t>(std::min(geometric(random), 255));
+    }
+
+    RANSCoder coder(1000);
+    Array<uint8_t> encoded, decoded;
+    coder.Encode(data, &encoded);
+
+    // Truncated.
+    ASSERT(!coder.Decode(encoded.data(), encoded.size() - 1, &decoded));
+    ASSERT(decoded.empty());
+    ASSERT(!coder.Decode(encoded.data(), 100, &decoded));
+
+    // Modified payload.
+    encoded.back() ^= 0x55;
+    ASSERT(!coder.Decode(encoded, &decoded));
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_CODEC_RANS_CODER_TEST_H_
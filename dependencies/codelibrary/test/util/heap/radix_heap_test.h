@@ -0,0 +1,79 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_HEAP_RADIX_HEAP_TEST_H_
+#define CODELIBRARY_TEST_UTIL_HEAP_RADIX_HEAP_TEST_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/heap/radix_heap.h"
+
+namespace cl {
+namespace test {
+
+TEST(RadixHeapTest, Sort) {
+    RadixHeap<uint32_t, int> heap;
+    Array<uint32_t> keys = {5, 3, 9, 3, 0, 100, 7};
+    for (int i = 0; i < keys.size(); ++i) {
+        heap.Push(keys[i], i);
+    }
+    ASSERT_EQ(heap.size(), 7);
+    ASSERT_EQ(heap.top_key(), 0u);
+
+    std::sort(keys.begin(), keys.end());
+    for (uint32_t k : keys) {
+        uint32_t key;
+        int value;
+        heap.Pop(&key, &value);
+        ASSERT_EQ(key, k);
+    }
+    ASSERT(heap.empty());
+}
+
+TEST(RadixHeapTest, CompareWithPriorityQueue) {
+    using Pair = std::pair<uint64_t, int>;
+    std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair>> queue;
+    RadixHeap<uint64_t, int> heap;
+
+    std::mt19937_64 random;
+    for (int round = 0; round < 2; ++round) {
+        uint64_t last = 0;
+        for (int i = 0; i < 10000; ++i) {
+            // Monotone pushes, interleaved with pops.
+            if (queue.empty() || random() % 3 != 0) {
+                uint64_t key = last + random() % (uint64_t(1) << (i % 40));
+                queue.push(Pair(key, i));
+                heap.Push(key, i);
+            } else {
+                uint64_t key;
+                int value;
+                heap.Pop(&key, &value);
+                ASSERT_EQ(key, queue.top().first);
+                queue.pop();
+                last = key;
+            }
+            ASSERT_EQ(heap.size(), static_cast<int>(queue.size()));
+        }
+
+        // Reuse the heap.
+        heap.clear();
+        queue = decltype(queue)();
+    }
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_HEAP_RADIX_HEAP_TEST_H_
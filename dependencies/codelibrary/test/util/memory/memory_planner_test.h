@@ -0,0 +1,210 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_MEMORY_MEMORY_PLANNER_TEST_H_
+#define CODELIBRARY_TEST_UTIL_MEMORY_MEMORY_PLANNER_TEST_H_
+
+#include <cstdint>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/memory/memory_planner.h"
+
+namespace cl {
+namespace test {
+
+class MemoryPlannerTest : public Test {
+protected:
+    using Planner = MemoryPlanner;
+    using Dataset = Planner::Dataset;
+    using Network = Planner::Network;
+    using Footprint = Planner::Footprint;
+
+    static Dataset Images(int n, int width, int height,
+                          int bytes_per_channel = 1) {
+        Dataset dataset;
+        dataset.bytes_per_channel = bytes_per_channel;
+        for (int i = 0; i < n; ++i) {
+            dataset.images.emplace_back(width, height);
+        }
+        return dataset;
+    }
+};
+
+TEST_F(MemoryPlannerTest, NetworkParams) {
+    // Two dense levels of 4^3 and 8^3 entries.
+    ASSERT_EQ(Planner::HashGridParams(2, 2, 10, 4, 2.0), (64 + 512) * 2);
+
+    // The second level is hashed into 2^8 entries.
+    ASSERT_EQ(Planner::HashGridParams(2, 2, 8, 4, 2.0), (64 + 256) * 2);
+
+    // A level of 24^3 entries, as the scale 1.5 * 16 - 1 is rounded up.
+    ASSERT_EQ(Planner::HashGridParams(2, 1, 22, 16, 1.5), 4096 + 13824);
+
+    // The MLPs of the default NeRF network.
+    ASSERT_EQ(Planner::MLPParams(32, 64, 1, 16), 32 * 64 + 64 * 16);
+    ASSERT_EQ(Planner::MLPParams(32, 64, 2, 3),
+              32 * 64 + 64 * 64 + 64 * 16);
+
+    // Levels of 16^3, 32^3, 64^3, and 13 levels of 2^19 entries.
+    Network network;
+    int64_t grid = (4096 + 32768 + 262144 + 13 * 524288) * 2;
+    ASSERT_EQ(grid, 14229504);
+    ASSERT_EQ(Planner::NumParams(network), grid + 3072 + 7168);
+}
+
+TEST_F(MemoryPlannerTest, Footprint) {
+    Planner planner;
+    Network network;
+    Dataset dataset = Images(100, 1920, 1080);
+    const int64_t n_params = Planner::NumParams(network);
+
+    Footprint f = planner.Estimate(dataset, network, 1, 1 << 18);
+    ASSERT_EQ(f.images, int64_t(100) * 1920 * 1080 * 4);
+    ASSERT_EQ(f.depths, 0);
+    ASSERT_EQ(f.rays, 0);
+    ASSERT_EQ(f.sharpness, int64_t(100) * 128 * 72 * 4);
+
+    // 128 * 2^18 / 100 samples per image give an 84 x 84 error map.
+    ASSERT_EQ(f.error_map, (2 * 84 * 84 + 84 + 1) * 100 * 4);
+
+    ASSERT_EQ(f.parameters, n_params * 8);
+    ASSERT_EQ(f.optimizer, n_params * 12);
+    ASSERT_EQ(f.density_grid, 67108864 + 2097152);
+    ASSERT_EQ(f.sharpness_grid, 0);
+    ASSERT_EQ(f.total(), f.dataset() + f.model() + f.batch);
+
+    // Half images with depths and rays, downscaled by 2.
+    dataset = Images(100, 1920, 1080, 2);
+    dataset.has_depth = true;
+    dataset.has_rays = true;
+    f = planner.Estimate(dataset, network, 2, 1 << 18);
+    ASSERT_EQ(f.images, int64_t(100) * 960 * 540 * 8);
+    ASSERT_EQ(f.depths, int64_t(100) * 960 * 540 * 16);
+    ASSERT_EQ(f.rays, int64_t(100) * 960 * 540 * 24);
+
+    // The batch scratch is linear in the batch size.
+    Footprint half = planner.Estimate(dataset, network, 2, 1 << 17);
+    ASSERT_EQ(f.batch - 4, 2 * (half.batch - 4));
+    ASSERT(f.batch > 0);
+
+    network.has_sharpness_grid = true;
+    f = planner.Estimate(dataset, network, 2, 1 << 18);
+    ASSERT_EQ(f.sharpness_grid, 67108864);
+}
+
+TEST_F(MemoryPlannerTest, Downscale) {
+    Network network;
+
+    // 16.6 GB of half images do not fit in 8 GB, but a quarter of them do.
+    Dataset dataset = Images(1000, 1920, 1080, 2);
+    Planner::Options options;
+    options.budget = int64_t(8) << 30;
+    Planner planner(options);
+
+    Planner::Settings settings;
+    planner.Plan(dataset, network, 10, &settings);
+    ASSERT(settings.fits);
+    ASSERT_EQ(settings.downscale, 2);
+    ASSERT_EQ(settings.batch_size, options.max_batch_size);
+    ASSERT_EQ(settings.n_resident_blocks, 10);
+
+    int64_t usable = static_cast<int64_t>(options.budget * 0.9);
+    ASSERT(settings.training.total() <= usable);
+    ASSERT(planner.Estimate(dataset, network, 1,
+                            options.min_batch_size).total() > usable);
+
+    // Without limit, nothing is downscaled.
+    options.budget = int64_t(64) << 30;
+    Planner unlimited(options);
+    unlimited.Plan(dataset, network, 10, &settings);
+    ASSERT(settings.fits);
+    ASSERT_EQ(settings.downscale, 1);
+    ASSERT_EQ(settings.batch_size, options.max_batch_size);
+}
+
+TEST_F(MemoryPlannerTest, BatchSize) {
+    Network network;
+    Dataset dataset = Images(300, 1920, 1080);
+
+    // A budget between the footprints of the batches of 2^16 and 2^17.
+    Planner planner;
+    int64_t small = planner.Estimate(dataset, network, 1, 1 << 16).total();
+    int64_t large = planner.Estimate(dataset, network, 1, 1 << 17).total();
+    ASSERT(small < large);
+
+    Planner::Options options;
+    options.budget = (small + large) / 2;
+    options.headroom = 0.0;
+    Planner tight(options);
+
+    Planner::Settings settings;
+    tight.Plan(dataset, network, 1, &settings);
+    ASSERT_EQ(settings.downscale, 1);
+    ASSERT_EQ(settings.batch_size, 1 << 16);
+    ASSERT_EQ(settings.training.total(), small);
+}
+
+TEST_F(MemoryPlannerTest, Residency) {
+    Network network;
+    Dataset dataset = Images(10, 64, 64);
+
+    // The density grid in use and three and a half blocks.
+    const int64_t grid = 67108864 + 2097152;
+    const int64_t block = Planner::ResidentBlockBytes(network);
+    ASSERT_EQ(block, Planner::NumParams(network) * 20 + 67108864);
+
+    Planner::Options options;
+    options.budget = grid + block * 7 / 2;
+    options.headroom = 0.0;
+    Planner planner(options);
+
+    Planner::Settings settings;
+    planner.Plan(dataset, network, 10, &settings);
+    ASSERT_EQ(settings.n_resident_blocks, 3);
+    ASSERT_EQ(settings.rendering, grid + 3 * block);
+    ASSERT(settings.fits);
+
+    // No more resident blocks than blocks.
+    planner.Plan(dataset, network, 2, &settings);
+    ASSERT_EQ(settings.n_resident_blocks, 2);
+
+    // One block can not render the street.
+    options.budget = grid + block * 3 / 2;
+    Planner single(options);
+    single.Plan(dataset, network, 10, &settings);
+    ASSERT_EQ(settings.n_resident_blocks, 1);
+    ASSERT(!settings.fits);
+}
+
+TEST_F(MemoryPlannerTest, Infeasible) {
+    Network network;
+    Dataset dataset = Images(100, 1920, 1080);
+
+    Planner::Options options;
+    options.budget = int64_t(256) << 20;
+    Planner planner(options);
+
+    // The smallest settings are returned.
+    Planner::Settings settings;
+    planner.Plan(dataset, network, 4, &settings);
+    ASSERT(!settings.fits);
+    ASSERT_EQ(settings.downscale, 8);
+    ASSERT_EQ(settings.batch_size, options.min_batch_size);
+    ASSERT_EQ(settings.n_resident_blocks, 0);
+    ASSERT(settings.training.total() > options.budget);
+
+    // No image.
+    planner.Plan(Dataset(), network, 0, &settings);
+    ASSERT_EQ(settings.training.images, 0);
+    ASSERT_EQ(settings.training.error_map, 0);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_MEMORY_MEMORY_PLANNER_TEST_H_
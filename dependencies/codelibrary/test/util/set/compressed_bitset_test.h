@@ -0,0 +1,100 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_SET_COMPRESSED_BITSET_TEST_H_
+#define CODELIBRARY_TEST_UTIL_SET_COMPRESSED_BITSET_TEST_H_
+
+#include <random>
+#include <vector>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/set/compressed_bitset.h"
+
+namespace cl {
+namespace test {
+
+class CompressedBitsetTest : public Test {
+protected:
+    /**
+     * Check a compressed copy of 'bitset' against the original.
+     */
+    template <typename CompressedBitset>
+    static void CheckCompressed(const DynamicBitset& bitset) {
+        CompressedBitset compressed(bitset);
+        ASSERT_EQ(compressed.size(), bitset.size());
+        ASSERT_EQ(compressed.Count(), bitset.Count());
+
+        for (int i = 0; i < bitset.size(); ++i) {
+            ASSERT_EQ(compressed.Test(i), bitset.Test(i));
+        }
+
+        std::vector<int> a, b;
+        bitset.ForEachSetBit([&](int pos) { a.push_back(pos); });
+        compressed.ForEachSetBit([&](int pos) { b.push_back(pos); });
+        ASSERT(a == b);
+
+        DynamicBitset decompressed;
+        compressed.ToDynamicBitset(&decompressed);
+        ASSERT(decompressed == bitset);
+    }
+
+    /**
+     * Check both compressed forms.
+     */
+    static void Check(const DynamicBitset& bitset) {
+        CheckCompressed<RunLengthBitset>(bitset);
+        CheckCompressed<RoaringBitset>(bitset);
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(CompressedBitsetTest, Empty) {
+    Check(DynamicBitset());
+    Check(DynamicBitset(100));
+}
+
+TEST_F(CompressedBitsetTest, Random) {
+    for (int n : {1, 63, 64, 65, 70000, 200000}) {
+        for (double p : {0.01, 0.2, 0.9}) {
+            std::bernoulli_distribution bernoulli(p);
+            DynamicBitset bitset(n);
+            for (int i = 0; i < n; ++i) {
+                if (bernoulli(random_)) bitset.Set(i);
+            }
+            Check(bitset);
+        }
+    }
+}
+
+TEST_F(CompressedBitsetTest, Runs) {
+    DynamicBitset bitset(200000);
+    bitset.SetRange(0, 1);
+    bitset.SetRange(63, 65);
+    bitset.SetRange(1000, 90000);
+    bitset.SetRange(131071, 131073);
+    bitset.SetRange(199990, 200000);
+    Check(bitset);
+
+    RunLengthBitset run_length(bitset);
+    ASSERT_EQ(run_length.n_runs(), 5);
+    ASSERT_EQ(run_length.firsts()[2], 1000);
+    ASSERT_EQ(run_length.lasts()[2], 90000);
+    ASSERT_EQ(run_length.lasts()[4], 200000);
+
+    RoaringBitset roaring(bitset);
+    ASSERT_EQ(roaring.n_containers(), 4);
+
+    bitset.Set();
+    Check(bitset);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_SET_COMPRESSED_BITSET_TEST_H_
@@ -0,0 +1,226 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_SET_DYNAMIC_BITSET_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_UTIL_SET_DYNAMIC_BITSET_PERFORMANCE_TEST_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/util/set/compressed_bitset.h"
+#include "codelibrary/util/set/dynamic_bitset.h"
+#include "codelibrary/util/set/rank_select.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure DynamicBitset, RankSelect and the compressed bitsets on 2^24 bits.
+ *
+ * The reference is a bit-at-a-time / 32-bit word loop, as DynamicBitset was
+ * implemented before.
+ */
+class DynamicBitsetPerformanceTest : public Test {
+protected:
+    static const int N_BITS = 1 << 24;
+
+    /**
+     * Generate a random bitset where each bit is set with probability p.
+     */
+    static void RandomBitset(double p, DynamicBitset* bitset) {
+        std::mt19937 random;
+        std::bernoulli_distribution bernoulli(p);
+
+        *bitset = DynamicBitset(N_BITS);
+        for (int i = 0; i < N_BITS; ++i) {
+            if (bernoulli(random)) bitset->Set(i);
+        }
+    }
+
+    /**
+     * Copy the bitset into 32-bit words.
+     */
+    static void ToWords(const DynamicBitset& bitset, Array<uint32_t>* words) {
+        words->resize(bitset.n_blocks() * 2);
+        for (int i = 0; i < bitset.n_blocks(); ++i) {
+            (*words)[2 * i] = static_cast<uint32_t>(bitset.data()[i]);
+            (*words)[2 * i + 1] = static_cast<uint32_t>(bitset.data()[i] >> 32);
+        }
+    }
+
+    /**
+     * Reference count, the SWAR population count of each 32-bit word.
+     */
+    static int ReferenceCount(const Array<uint32_t>& words) {
+        int count = 0;
+        for (uint32_t n : words) {
+            n -= (n >> 1) & 0x55555555;
+            n  = (n & 0x33333333) + ((n >> 2) & 0x33333333);
+            n  = (n + (n >> 4)) & 0x0f0f0f0f;
+            count += (n * 0x01010101) >> 24;
+        }
+        return count;
+    }
+
+    /**
+     * Return the average time of 'f' over 'n' runs.
+     */
+    template <typename Function>
+    static std::string Time(int n, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return timer.average_time(n);
+    }
+
+    // Prevents the compiler from dropping the measured work.
+    int64_t sink_ = 0;
+};
+
+TEST_F(DynamicBitsetPerformanceTest, BulkOperations) {
+    DynamicBitset a, b;
+    RandomBitset(0.5, &a);
+    RandomBitset(0.3, &b);
+    Array<uint32_t> wa, wb;
+    ToWords(a, &wa);
+    ToWords(b, &wb);
+
+    printf("\n");
+    printf("Operation on 2^24 bits             Reference         New\n");
+    printf("---------------------------------------------------------\n");
+    {
+        std::string t1 = Time(20, [&]() { sink_ += ReferenceCount(wa); });
+        std::string t2 = Time(20, [&]() { sink_ += a.Count(); });
+        printf("Count %38s %11s\n", t1.c_str(), t2.c_str());
+    }
+    {
+        std::string t1 = Time(20, [&]() {
+            for (int i = 0; i < wa.size(); ++i) wa[i] &= wb[i];
+        });
+        std::string t2 = Time(20, [&]() { a &= b; });
+        printf("AND %40s %11s\n", t1.c_str(), t2.c_str());
+    }
+    {
+        std::string t1 = Time(20, [&]() {
+            for (int i = 0; i < wa.size(); ++i) wa[i] |= wb[i];
+        });
+        std::string t2 = Time(20, [&]() { a |= b; });
+        printf("OR %41s %11s\n", t1.c_str(), t2.c_str());
+    }
+    {
+        std::string t1 = Time(20, [&]() {
+            for (int i = 0; i < wa.size(); ++i) wa[i] ^= wb[i];
+        });
+        std::string t2 = Time(20, [&]() { a ^= b; });
+        printf("XOR %40s %11s\n", t1.c_str(), t2.c_str());
+    }
+    {
+        std::string t1 = Time(20, [&]() {
+            for (int i = 0; i < wa.size(); ++i) wa[i] &= ~wb[i];
+        });
+        std::string t2 = Time(20, [&]() { a.AndNot(b); });
+        printf("ANDNOT %37s %11s\n", t1.c_str(), t2.c_str());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+
+    ASSERT_EQ(ReferenceCount(wa), a.Count());
+}
+
+TEST_F(DynamicBitsetPerformanceTest, Iteration) {
+    printf("\n");
+    printf("Visit set bits of 2^24 bits        Reference         New\n");
+    printf("---------------------------------------------------------\n");
+    for (double p : {0.001, 0.01, 0.5}) {
+        DynamicBitset a;
+        RandomBitset(p, &a);
+        std::string t1 = Time(3, [&]() {
+            for (int i = 0; i < a.size(); ++i) {
+                if (a[i]) sink_ += i;
+            }
+        });
+        std::string t2 = Time(3, [&]() {
+            a.ForEachSetBit([&](int i) { sink_ += i; });
+        });
+        printf("ForEachSetBit, density %-8g %12s %11s\n", p, t1.c_str(),
+               t2.c_str());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+TEST_F(DynamicBitsetPerformanceTest, RankSelect) {
+    DynamicBitset a;
+    RandomBitset(0.3, &a);
+
+    const int n_queries = 1 << 20;
+    std::mt19937 random;
+    std::uniform_int_distribution<int> uniform_pos(0, N_BITS);
+    std::uniform_int_distribution<int> uniform_rank(0, a.Count() - 1);
+    Array<int> positions(n_queries), ranks(n_queries);
+    for (int i = 0; i < n_queries; ++i) {
+        positions[i] = uniform_pos(random);
+        ranks[i] = uniform_rank(random);
+    }
+
+    RankSelect rank_select;
+    printf("\n");
+    printf("RankSelect on 2^24 bits, density 0.3                 Time\n");
+    printf("---------------------------------------------------------\n");
+    std::string t = Time(3, [&]() { rank_select.Reset(a); });
+    printf("Build index %45s\n", t.c_str());
+    t = Time(1, [&]() {
+        for (int p : positions) sink_ += rank_select.Rank(p);
+    });
+    printf("2^20 random Rank() %38s\n", t.c_str());
+    t = Time(1, [&]() {
+        for (int k : ranks) sink_ += rank_select.Select(k);
+    });
+    printf("2^20 random Select() %36s\n", t.c_str());
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+TEST_F(DynamicBitsetPerformanceTest, Compression) {
+    printf("\n");
+    printf("Compress 2^24 bits (2MB)           Build          Memory\n");
+    printf("---------------------------------------------------------\n");
+    DynamicBitset sparse, runs;
+    RandomBitset(0.001, &sparse);
+    runs = DynamicBitset(N_BITS);
+    for (int i = 0; i + 50000 < N_BITS; i += 100000) {
+        runs.SetRange(i, i + 50000);
+    }
+
+    const char* names[] = { "Sparse (0.1%)", "Runs" };
+    const DynamicBitset* bitsets[] = { &sparse, &runs };
+    for (int i = 0; i < 2; ++i) {
+        RunLengthBitset run_length;
+        RoaringBitset roaring;
+        std::string t1 = Time(3, [&]() { run_length.Reset(*bitsets[i]); });
+        std::string t2 = Time(3, [&]() { roaring.Reset(*bitsets[i]); });
+        printf("%-14s run-length %18s %12lldKB\n", names[i], t1.c_str(),
+               static_cast<long long>(run_length.memory_usage() / 1024));
+        printf("%-14s roaring %21s %12lldKB\n", names[i], t2.c_str(),
+               static_cast<long long>(roaring.memory_usage() / 1024));
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_SET_DYNAMIC_BITSET_PERFORMANCE_TEST_H_
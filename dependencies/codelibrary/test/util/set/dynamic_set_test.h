@@ -9,7 +9,9 @@
 #ifndef CODELIBRARY_TEST_UTIL_SET_DYNAMIC_SET_TEST_H_
 #define CODELIBRARY_TEST_UTIL_SET_DYNAMIC_SET_TEST_H_
 
+#include <random>
 #include <string>
+#include <vector>
 
 #include "codelibrary/base/testing.h"
 #include "codelibrary/util/set/dynamic_bitset.h"
@@ -114,6 +116,91 @@ TEST(DynamicBitsetTest, TestAccess) {
     ASSERT_EQ(foo.ToString(), "0110");
 }
 
+TEST(DynamicBitsetTest, TestTailBits) {
+    DynamicBitset foo(70);
+
+    foo.Flip();
+    ASSERT_EQ(foo.Count(), 70);
+    ASSERT(foo.All());
+
+    foo <<= 3;
+    ASSERT_EQ(foo.Count(), 67);
+    ASSERT_FALSE(foo.All());
+
+    foo.Set();
+    ASSERT_EQ(foo.Count(), 70);
+    ASSERT(foo == ~DynamicBitset(70));
+    ASSERT(foo != DynamicBitset(71).Set().Reset(70));
+}
+
+TEST(DynamicBitsetTest, TestResize) {
+    DynamicBitset foo("1011");
+
+    foo.Resize(130);
+    foo.Set(129);
+    ASSERT_EQ(foo.Count(), 4);
+    ASSERT(foo.Test(0) && foo.Test(1) && foo.Test(3) && foo.Test(129));
+
+    foo.Resize(2);
+    ASSERT_EQ(foo.ToString(), "11");
+    foo.Resize(64);
+    ASSERT_EQ(foo.Count(), 2);
+}
+
+TEST(DynamicBitsetTest, TestSetRange) {
+    for (int first = 0; first < 140; first += 7) {
+        for (int last = first; last <= 200; last += 13) {
+            DynamicBitset foo(200);
+            foo.SetRange(first, last);
+            ASSERT_EQ(foo.Count(), last - first);
+            ASSERT_EQ(foo.FindFirst(), first == last ? -1 : first);
+        }
+    }
+}
+
+TEST(DynamicBitsetTest, TestLargeOperations) {
+    std::mt19937 random;
+    std::bernoulli_distribution bernoulli(0.3);
+
+    // Sizes around word and AVX2 boundaries.
+    for (int n : {1, 63, 64, 65, 255, 256, 257, 511, 513, 10000}) {
+        std::vector<bool> a(n), b(n);
+        DynamicBitset x(n), y(n);
+        for (int i = 0; i < n; ++i) {
+            a[i] = bernoulli(random);
+            b[i] = bernoulli(random);
+            x.Set(i, a[i]);
+            y.Set(i, b[i]);
+        }
+
+        DynamicBitset x_and = x & y, x_or = x | y, x_xor = x ^ y;
+        DynamicBitset x_and_not = x;
+        x_and_not.AndNot(y);
+
+        int count = 0;
+        for (int i = 0; i < n; ++i) {
+            count += a[i];
+            ASSERT_EQ(x_and.Test(i), a[i] && b[i]);
+            ASSERT_EQ(x_or.Test(i), a[i] || b[i]);
+            ASSERT_EQ(x_xor.Test(i), a[i] != b[i]);
+            ASSERT_EQ(x_and_not.Test(i), a[i] && !b[i]);
+        }
+        ASSERT_EQ(x.Count(), count);
+
+        std::vector<int> positions;
+        x.ForEachSetBit([&](int pos) { positions.push_back(pos); });
+        ASSERT_EQ(static_cast<int>(positions.size()), count);
+        int k = 0;
+        for (int i = 0; i < n; ++i) {
+            int next = x.FindFirst(i);
+            ASSERT_EQ(next, k < count ? positions[k] : -1);
+            if (a[i]) {
+                ASSERT_EQ(positions[k++], i);
+            }
+        }
+    }
+}
+
 } // namespace test
 } // namespace cl
 
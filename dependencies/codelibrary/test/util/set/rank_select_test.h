@@ -0,0 +1,81 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_SET_RANK_SELECT_TEST_H_
+#define CODELIBRARY_TEST_UTIL_SET_RANK_SELECT_TEST_H_
+
+#include <random>
+#include <vector>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/set/rank_select.h"
+
+namespace cl {
+namespace test {
+
+class RankSelectTest : public Test {
+protected:
+    /**
+     * Check Rank() and Select() against a linear scan.
+     */
+    static void CheckRankSelect(const DynamicBitset& bitset) {
+        RankSelect rank_select(bitset);
+        ASSERT_EQ(rank_select.Count(), bitset.Count());
+
+        int rank = 0;
+        for (int i = 0; i < bitset.size(); ++i) {
+            ASSERT_EQ(rank_select.Rank(i), rank);
+            if (bitset.Test(i)) {
+                ASSERT_EQ(rank_select.Select(rank), i);
+                ++rank;
+            }
+        }
+        ASSERT_EQ(rank_select.Rank(bitset.size()), rank);
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(RankSelectTest, Empty) {
+    CheckRankSelect(DynamicBitset());
+    CheckRankSelect(DynamicBitset(1000));
+}
+
+TEST_F(RankSelectTest, Dense) {
+    DynamicBitset bitset(4096);
+    bitset.Set();
+    CheckRankSelect(bitset);
+}
+
+TEST_F(RankSelectTest, Random) {
+    // Sizes around word and superblock boundaries.
+    for (int n : {1, 64, 511, 512, 513, 4096, 100000}) {
+        for (double p : {0.001, 0.1, 0.5, 0.99}) {
+            std::bernoulli_distribution bernoulli(p);
+            DynamicBitset bitset(n);
+            for (int i = 0; i < n; ++i) {
+                if (bernoulli(random_)) bitset.Set(i);
+            }
+            CheckRankSelect(bitset);
+        }
+    }
+}
+
+TEST_F(RankSelectTest, Clustered) {
+    // Long empty gaps between dense clusters stress the select samples.
+    DynamicBitset bitset(300000);
+    for (int start = 0; start + 3000 < 300000; start += 70000) {
+        bitset.SetRange(start, start + 3000);
+    }
+    CheckRankSelect(bitset);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_SET_RANK_SELECT_TEST_H_
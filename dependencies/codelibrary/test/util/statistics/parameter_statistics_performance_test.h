@@ -0,0 +1,146 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_STATISTICS_PARAMETER_STATISTICS_PERFORMANCE_TEST_H_
+#define CODELIBRARY_TEST_UTIL_STATISTICS_PARAMETER_STATISTICS_PERFORMANCE_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+#include "codelibrary/util/statistics/parameter_statistics.h"
+
+namespace cl {
+namespace test {
+
+/**
+ * Measure the statistics of the levels of a synthetic hash grid.
+ *
+ * The reference is the serial loop of the testbed: the moments of every level
+ * and the histogram of one level, without the quantization error.
+ */
+class ParameterStatisticsPerformanceTest : public Test {
+protected:
+    static const int N_LEVELS = 16;
+    static const int N_FEATURES = 2;
+
+    /**
+     * Generate L levels of 2^log2_table_size entries, where the fine levels
+     * are touched sparsely by training, like in
+     * QuantizedArrayCodecPerformanceTest.
+     */
+    void Generate(int log2_table_size) {
+        std::mt19937 random;
+        std::uniform_real_distribution<float> init(-1e-4f, 1e-4f);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        level_size_ = N_FEATURES << log2_table_size;
+        data_.resize(N_LEVELS * level_size_);
+        for (int l = 0; l < N_LEVELS; ++l) {
+            double touched = std::min(1.0, 4.0 / (l + 1));
+            float sigma = 0.5f / (l + 1);
+            float* v = data_.data() + l * level_size_;
+            for (int i = 0; i < level_size_; ++i) {
+                v[i] = uniform(random) < touched ? sigma * normal(random)
+                                                 : init(random);
+            }
+        }
+    }
+
+    /**
+     * Return the average time of 'f' over 'n' runs.
+     */
+    template <typename Function>
+    static std::string Time(int n, const Function& f) {
+        Timer timer;
+        timer.Start();
+        for (int i = 0; i < n; ++i) {
+            f();
+        }
+        timer.Stop();
+        return timer.average_time(n);
+    }
+
+    /**
+     * The serial statistics of the testbed, for reference.
+     */
+    void SerialStats() {
+        for (int l = 0; l < N_LEVELS; ++l) {
+            const float* v = data_.data() + l * level_size_;
+            float x = 0.0f, xsquared = 0.0f, lo = 0.0f, hi = 0.0f;
+            int count = 0, numzero = 0;
+            for (int i = 0; i < level_size_; ++i) {
+                if (std::fabs(v[i]) < 0.00001f) {
+                    ++numzero;
+                } else {
+                    if (count == 0) lo = hi = v[i];
+                    ++count;
+                    x += v[i];
+                    xsquared += v[i] * v[i];
+                    lo = std::min(lo, v[i]);
+                    hi = std::max(hi, v[i]);
+                }
+            }
+            sink_ += x + xsquared + lo + hi + count + numzero;
+        }
+
+        int64_t histogram[257] = {};
+        for (int i = 0; i < level_size_; ++i) {
+            float v = data_[i];
+            if (v == 0.0f) continue;
+            int bin = static_cast<int>(std::floor(v * 128.0f + 128.5f));
+            if (bin >= 0 && bin <= 256) ++histogram[bin];
+        }
+        sink_ += histogram[128];
+    }
+
+    void ParallelStats(int quantization_bits) {
+        ParameterStatsOptions options;
+        options.quantization_bits = quantization_bits;
+        ParameterStats stats;
+        for (int l = 0; l < N_LEVELS; ++l) {
+            ComputeParameterStats(data_.data() + l * level_size_, level_size_,
+                                  options, &stats);
+            sink_ += stats.mean() + stats.histogram[128];
+        }
+    }
+
+    Array<float> data_;
+    int level_size_ = 0;
+
+    // Prevents the compiler from dropping the measured work.
+    double sink_ = 0.0;
+};
+
+TEST_F(ParameterStatisticsPerformanceTest, HashGridLevels) {
+    printf("\n");
+    printf("%-21s %11s %11s %11s\n", "16 levels", "Serial", "Stats",
+           "Stats+8bit");
+    printf("---------------------------------------------------------\n");
+    for (int log2_table_size : { 16, 19, 21 }) {
+        Generate(log2_table_size);
+        std::string t1 = Time(3, [&]() { SerialStats(); });
+        std::string t2 = Time(3, [&]() { ParallelStats(0); });
+        std::string t3 = Time(3, [&]() { ParallelStats(8); });
+        printf("T = 2^%-15d %11s %11s %11s\n", log2_table_size, t1.c_str(),
+               t2.c_str(), t3.c_str());
+    }
+    printf("---------------------------------------------------------\n");
+    printf("\n");
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_STATISTICS_PARAMETER_STATISTICS_PERFORMANCE_TEST_H_
@@ -0,0 +1,168 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_STATISTICS_PARAMETER_STATISTICS_TEST_H_
+#define CODELIBRARY_TEST_UTIL_STATISTICS_PARAMETER_STATISTICS_TEST_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/statistics/parameter_statistics.h"
+
+namespace cl {
+namespace test {
+
+TEST(ParameterStatisticsTest, Basic) {
+    const float data[] = { 0.0f, 1e-6f, -0.5f, 0.25f, 0.5f, 1.0f, -2.0f };
+
+    ParameterStatsOptions options;
+    options.n_bins = 5;
+    options.histogram_range = 1.0f;
+    ParameterStats s;
+    ComputeParameterStats(data, 7, options, &s);
+    ASSERT_EQ(s.count, int64_t(5));
+    ASSERT_EQ(s.n_zero, int64_t(2));
+    ASSERT_EQ(s.min, -2.0f);
+    ASSERT_EQ(s.max, 1.0f);
+    ASSERT_EQ_NEAR(s.mean(), -0.15, 1e-12);
+    ASSERT_EQ_NEAR(s.variance(), 5.5625 / 5 - 0.15 * 0.15, 1e-12);
+    ASSERT_EQ_NEAR(s.zero_fraction(), 2.0 / 7.0, 1e-12);
+
+    // Bins of width 0.5 centered at -1, -0.5, 0, 0.5, 1, closed on the left.
+    // The exact zero and -2 are not counted.
+    const int64_t histogram[] = { 0, 1, 1, 2, 1 };
+    ASSERT_EQ_RANGE(s.histogram.begin(), s.histogram.end(), histogram,
+                    histogram + 5);
+
+    // The values on the 8-bit grid of [-2, 1] (step 3 / 255) have error at
+    // most half a step, and 1e-6 snaps to zero but it is not counted.
+    ASSERT(s.quantization_error > 0.0);
+    ASSERT(s.quantization_error <= 1.5 / 255);
+    ASSERT_EQ(s.n_snapped, int64_t(0));
+
+    ComputeParameterStats(data, 0, options, &s);
+    ASSERT_EQ(s.count + s.n_zero, int64_t(0));
+    ASSERT_EQ(s.histogram.size(), 5);
+}
+
+TEST(ParameterStatisticsTest, CompareWithSerial) {
+    std::mt19937 random;
+    std::normal_distribution<float> normal(0.01f, 0.2f);
+    std::uniform_real_distribution<float> init(-1e-4f, 1e-4f);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Sparse data over several chunks: a third of the values are exact zeros,
+    // a third are small initial values, and the others are trained values.
+    Array<float> data(300001);
+    for (float& v : data) {
+        double u = uniform(random);
+        v = u < 1.0 / 3 ? 0.0f : (u < 2.0 / 3 ? init(random) : normal(random));
+    }
+
+    ParameterStatsOptions options;
+    options.quantization_bits = 4;
+    options.histogram_range = 0.5f;
+    ParameterStats s;
+    ComputeParameterStats(data.data(), data.size(), options, &s);
+
+    int64_t count = 0, n_zero = 0;
+    double sum = 0.0, sum_squared = 0.0;
+    float lo = INFINITY, hi = -INFINITY;
+    for (float v : data) {
+        if (std::fabs(v) < options.zero_threshold) {
+            ++n_zero;
+        } else {
+            ++count;
+            sum += v;
+            sum_squared += double(v) * v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+    ASSERT_EQ(s.count, count);
+    ASSERT_EQ(s.n_zero, n_zero);
+    ASSERT_EQ(s.min, lo);
+    ASSERT_EQ(s.max, hi);
+    ASSERT_EQ_NEAR(s.sum, sum, 1e-9 * count);
+    ASSERT_EQ_NEAR(s.sum_squared, sum_squared, 1e-9 * count);
+
+    LinearQuantizer quantizer(4);
+    quantizer.Reset(lo, hi);
+    Array<int64_t> histogram(options.n_bins, 0);
+    int64_t n_snapped = 0;
+    double squared_error = 0.0;
+    for (float v : data) {
+        if (v != 0.0f) {
+            int bin = static_cast<int>(std::floor(v * 256.0f + 128.5f));
+            if (bin >= 0 && bin <= 256) ++histogram[bin];
+        }
+        uint8_t code = quantizer.Quantize(v);
+        double error = double(quantizer.Dequantize(code)) - v;
+        squared_error += error * error;
+        if (code == quantizer.zero_code() &&
+            std::fabs(v) >= options.zero_threshold) {
+            ++n_snapped;
+        }
+    }
+    ASSERT_EQ_RANGE(s.histogram.begin(), s.histogram.end(), histogram.begin(),
+                    histogram.end());
+    ASSERT_EQ(s.n_snapped, n_snapped);
+    ASSERT(s.n_snapped > 0);
+    ASSERT_EQ_NEAR(s.quantization_error,
+                   std::sqrt(squared_error / data.size()), 1e-9);
+
+    // Fewer bits, larger error.
+    ParameterStats s8;
+    options.quantization_bits = 8;
+    ComputeParameterStats(data.data(), data.size(), options, &s8);
+    ASSERT(s8.quantization_error < s.quantization_error);
+    ASSERT(s8.n_snapped < s.n_snapped);
+}
+
+TEST(ParameterStatisticsTest, TimeSeries) {
+    const float data[] = { 0.0f, 0.5f, -0.25f, 1.0f };
+    ParameterStats s;
+    ComputeParameterStats(data, 4, ParameterStatsOptions(), &s);
+
+    const char* filename = "parameter_statistics_test.bin";
+    ParameterStatsWriter writer;
+    ASSERT(writer.Open(filename, ParameterStatsWriter::Format::kBinary));
+    for (int step = 0; step < 3; ++step) {
+        for (int block = 0; block < 2; ++block) {
+            writer.Write(100 * step, block, s);
+        }
+    }
+    writer.Close();
+
+    Array<ParameterStatsRecord> records;
+    ASSERT(ReadParameterStatsSeries(filename, &records));
+    ASSERT_EQ(records.size(), 6);
+    ASSERT_EQ(records[5].step, int64_t(200));
+    ASSERT_EQ(records[5].block, 1);
+    ASSERT_EQ(records[5].count, int64_t(3));
+    ASSERT_EQ(records[5].n_zero, int64_t(1));
+    ASSERT_EQ(records[5].min, -0.25f);
+    ASSERT_EQ(records[5].max, 1.0f);
+    ASSERT_EQ(records[5].mean, static_cast<float>(s.mean()));
+
+    // The CSV file is not a binary series.
+    ASSERT(writer.Open(filename, ParameterStatsWriter::Format::kCSV));
+    writer.Write(0, 0, s);
+    writer.Close();
+    ASSERT(!ReadParameterStatsSeries(filename, &records));
+    std::remove(filename);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_STATISTICS_PARAMETER_STATISTICS_TEST_H_
@@ -0,0 +1,188 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_TEST_UTIL_TREE_AABB_TREE_TEST_H_
+#define CODELIBRARY_TEST_UTIL_TREE_AABB_TREE_TEST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/util/tree/aabb_tree.h"
+
+namespace cl {
+namespace test {
+
+class AABBTreeTest : public Test {
+protected:
+    using Tree = AABBTree<double, int>;
+
+    /**
+     * Random box in [0, 100]^3 with size at most 'size'.
+     */
+    RBox3D RandomBox(double size) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        double x = uniform(random_) * 100.0, y = uniform(random_) * 100.0;
+        double z = uniform(random_) * 100.0;
+        return RBox3D(x, x + uniform(random_) * size,
+                      y, y + uniform(random_) * size,
+                      z, z + uniform(random_) * size);
+    }
+
+    static bool Contains(const RBox3D& a, const RBox3D& b) {
+        RBox3D c = a;
+        c.Join(b);
+        return c == a;
+    }
+
+    static bool Intersect(const RBox3D& a, const RBox3D& b) {
+        return a.x_min() <= b.x_max() && b.x_min() <= a.x_max() &&
+               a.y_min() <= b.y_max() && b.y_min() <= a.y_max() &&
+               a.z_min() <= b.z_max() && b.z_min() <= a.z_max();
+    }
+
+    /**
+     * Check the structure of the tree: links, heights and boxes.
+     */
+    void CheckTree(const Tree& tree) const {
+        if (tree.empty()) {
+            ASSERT_EQ(tree.root(), -1);
+            return;
+        }
+
+        ASSERT_EQ(tree.node(tree.root()).parent, -1);
+        int n_leaves = 0;
+        Array<int> stack = { tree.root() };
+        while (!stack.empty()) {
+            int id = stack.back();
+            const Tree::Node& node = tree.node(id);
+            stack.pop_back();
+            if (node.is_leaf()) {
+                ASSERT_EQ(node.height, 0);
+                ASSERT(Contains(node.box, node.object_box));
+                ++n_leaves;
+                continue;
+            }
+
+            for (int c : node.children) {
+                const Tree::Node& child = tree.node(c);
+                ASSERT_EQ(child.parent, id);
+                ASSERT(Contains(node.box, child.box));
+                stack.push_back(c);
+            }
+            const Tree::Node& a = tree.node(node.children[0]);
+            const Tree::Node& b = tree.node(node.children[1]);
+            ASSERT_EQ(node.height, 1 + std::max(a.height, b.height));
+        }
+        ASSERT_EQ(n_leaves, tree.size());
+    }
+
+    /**
+     * Check Query() against the brute force search.
+     */
+    void CheckQuery(const Tree& tree, const Array<RBox3D>& boxes,
+                    const Array<int>& ids) {
+        for (int k = 0; k < 20; ++k) {
+            RBox3D query = RandomBox(30.0);
+            Array<int> values;
+            tree.Query(query, &values);
+            std::sort(values.begin(), values.end());
+
+            Array<int> results;
+            for (int i = 0; i < boxes.size(); ++i) {
+                if (ids[i] != -1 && Intersect(boxes[i], query)) {
+                    results.push_back(i);
+                }
+            }
+            ASSERT_EQ_RANGE(values.begin(), values.end(),
+                            results.begin(), results.end());
+        }
+    }
+
+    std::mt19937 random_;
+};
+
+TEST_F(AABBTreeTest, InsertAndErase) {
+    Tree tree(0.5);
+    Array<RBox3D> boxes(2000);
+    Array<int> ids(boxes.size());
+    for (int i = 0; i < boxes.size(); ++i) {
+        boxes[i] = RandomBox(5.0);
+        ids[i] = tree.Insert(boxes[i], i);
+    }
+    CheckTree(tree);
+    CheckQuery(tree, boxes, ids);
+    ASSERT(tree.height() <= 2 * std::log2(tree.size()) + 2);
+
+    for (int i = 0; i < boxes.size(); i += 2) {
+        tree.Erase(ids[i]);
+        ids[i] = -1;
+    }
+    CheckTree(tree);
+    CheckQuery(tree, boxes, ids);
+
+    for (int i = 1; i < boxes.size(); i += 2) {
+        tree.Erase(ids[i]);
+    }
+    ASSERT(tree.empty());
+    CheckTree(tree);
+}
+
+TEST_F(AABBTreeTest, Update) {
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+    Tree tree(0.5);
+    Array<RBox3D> boxes(1000);
+    Array<int> ids(boxes.size());
+    for (int i = 0; i < boxes.size(); ++i) {
+        boxes[i] = RandomBox(5.0);
+        ids[i] = tree.Insert(boxes[i], i);
+    }
+
+    for (int frame = 0; frame < 20; ++frame) {
+        for (int i = 0; i < boxes.size(); ++i) {
+            if (i % 10 == 0) {
+                // Teleport.
+                boxes[i] = RandomBox(5.0);
+            } else {
+                // Small motion.
+                double dx = uniform(random_), dy = uniform(random_);
+                const RBox3D& b = boxes[i];
+                boxes[i] = RBox3D(b.x_min() + dx, b.x_max() + dx,
+                                  b.y_min() + dy, b.y_max() + dy,
+                                  b.z_min(), b.z_max());
+            }
+            tree.Update(ids[i], boxes[i]);
+            ASSERT(tree.box(ids[i]) == boxes[i]);
+        }
+        CheckTree(tree);
+        CheckQuery(tree, boxes, ids);
+    }
+
+    // A small motion inside the fat box does not change the tree.
+    const RBox3D& b = boxes[1];
+    ASSERT(!tree.Update(ids[1], RBox3D(b.x_min() + 0.1, b.x_max() + 0.1,
+                                       b.y_min(), b.y_max(),
+                                       b.z_min(), b.z_max())));
+    tree.Update(ids[1], b);
+
+    // Refit tightens the internal boxes.
+    tree.Refit();
+    CheckTree(tree);
+    CheckQuery(tree, boxes, ids);
+    const Tree::Node& root = tree.node(tree.root());
+    RBox3D box = tree.node(root.children[0]).box;
+    box.Join(tree.node(root.children[1]).box);
+    ASSERT(root.box == box);
+}
+
+} // namespace test
+} // namespace cl
+
+#endif // CODELIBRARY_TEST_UTIL_TREE_AABB_TREE_TEST_H_
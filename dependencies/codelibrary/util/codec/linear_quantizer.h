@@ -0,0 +1,187 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_CODEC_LINEAR_QUANTIZER_H_
+#define CODELIBRARY_UTIL_CODEC_LINEAR_QUANTIZER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+
+/**
+ * Uniform scalar quantizer of floats to n-bit codes (1 <= n <= 8):
+ *
+ *   v ~= scale * (code - zero_code) = offset + scale * code,
+ *   code in [0, 2^n - 1].
+ *
+ * The range always contains zero, and zero is exactly representable (by
+ * zero_code()), so that sparse data, e.g., hash tables whose unused entries
+ * are cleared, stay sparse after quantization. The codes are dequantized
+ * relative to the integer zero code, so the zero code gives 0 whether or
+ * not the compiler contracts offset + scale * code to a fused multiply-add. The error of the values inside
+ * the range is at most scale / 2; the values outside are clamped.
+ *
+ * Each code is stored in one byte. Codes with less than 8 bits are meant to be
+ * passed to an entropy coder (e.g., RANSCoder), which packs them to about their
+ * entropy.
+ */
+class LinearQuantizer {
+public:
+    explicit LinearQuantizer(int n_bits = 8)
+        : n_bits_(n_bits) {
+        CHECK(n_bits >= 1 && n_bits <= 8);
+    }
+
+    /**
+     * Construct from the stored parameters, e.g., for decoding.
+     */
+    LinearQuantizer(int n_bits, float scale, float offset)
+        : n_bits_(n_bits), scale_(scale), offset_(offset) {
+        CHECK(n_bits >= 1 && n_bits <= 8);
+        CHECK(scale >= 0.0f);
+
+        // The offset is -zero_code * scale, rounded to float.
+        if (scale_ > 0.0f) {
+            float zero = std::round(-offset_ / scale_);
+            zero_code_ = static_cast<int>(
+                std::min(std::max(zero, 0.0f),
+                         static_cast<float>(max_code())));
+        }
+    }
+
+    /**
+     * Fit the range [lo, hi], extended to contain zero.
+     */
+    void Reset(float lo, float hi) {
+        CHECK(std::isfinite(lo) && std::isfinite(hi) && lo <= hi);
+
+        lo = std::min(lo, 0.0f);
+        hi = std::max(hi, 0.0f);
+        if (lo == hi) {
+            scale_ = 0.0f;
+            offset_ = 0.0f;
+            zero_code_ = 0;
+            return;
+        }
+
+        // Shift the range by less than scale / 2 to put zero on a code.
+        scale_ = (hi - lo) / max_code();
+        zero_code_ = static_cast<int>(std::round(-lo / scale_));
+        offset_ = -zero_code_ * scale_;
+    }
+
+    /**
+     * Fit the range of the n values.
+     */
+    void Reset(const float* data, int n) {
+        CHECK(n >= 0);
+
+        float lo = 0.0f, hi = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            lo = std::min(lo, data[i]);
+            hi = std::max(hi, data[i]);
+        }
+        Reset(lo, hi);
+    }
+
+    /**
+     * Fit the range between the 'ratio' and the (1 - 'ratio') quantiles of
+     * the nonzero values, so that a few outliers do not waste the codes of
+     * low bit quantizers. The zeros are ignored since they are always exact.
+     */
+    void ResetByQuantiles(const float* data, int n, double ratio) {
+        CHECK(n >= 0);
+        CHECK(ratio >= 0.0 && ratio < 0.5);
+
+        Array<float> values;
+        values.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            if (data[i] != 0.0f) values.push_back(data[i]);
+        }
+        if (values.empty()) {
+            Reset(0.0f, 0.0f);
+            return;
+        }
+
+        int k = static_cast<int>(ratio * (values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        float lo = values[k];
+        std::nth_element(values.begin(), values.end() - 1 - k, values.end());
+        float hi = values[values.size() - 1 - k];
+        Reset(lo, hi);
+    }
+
+    uint8_t Quantize(float v) const {
+        if (scale_ == 0.0f) return 0;
+
+        float code = std::round(v / scale_) + zero_code_;
+        code = std::min(std::max(code, 0.0f), static_cast<float>(max_code()));
+        return static_cast<uint8_t>(code);
+    }
+
+    float Dequantize(uint8_t code) const {
+        return scale_ * static_cast<float>(static_cast<int>(code) -
+                                           zero_code_);
+    }
+
+    void Quantize(const float* data, int n, uint8_t* codes) const {
+        CHECK(n >= 0);
+
+        #pragma omp parallel for if (n > 65536)
+        for (int i = 0; i < n; ++i) {
+            codes[i] = Quantize(data[i]);
+        }
+    }
+
+    void Dequantize(const uint8_t* codes, int n, float* data) const {
+        CHECK(n >= 0);
+
+        #pragma omp parallel for if (n > 65536)
+        for (int i = 0; i < n; ++i) {
+            data[i] = Dequantize(codes[i]);
+        }
+    }
+
+    int n_bits() const {
+        return n_bits_;
+    }
+
+    int max_code() const {
+        return (1 << n_bits_) - 1;
+    }
+
+    float scale() const {
+        return scale_;
+    }
+
+    float offset() const {
+        return offset_;
+    }
+
+    /**
+     * Return the code of zero.
+     */
+    uint8_t zero_code() const {
+        return static_cast<uint8_t>(zero_code_);
+    }
+
+private:
+    int n_bits_;
+    float scale_ = 0.0f;
+    float offset_ = 0.0f;
+    int zero_code_ = 0;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_CODEC_LINEAR_QUANTIZER_H_
@@ -0,0 +1,200 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_H_
+#define CODELIBRARY_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/util/codec/linear_quantizer.h"
+#include "codelibrary/util/codec/rans_coder.h"
+
+namespace cl {
+
+/**
+ * Lossy codec for a float array made of segments with different statistics,
+ * e.g., the levels of a multiresolution hash grid.
+ *
+ * Each segment is
+ *  1) thresholded: the values with |v| <= zero_threshold are set to zero,
+ *     e.g., the untouched entries of a hash table that keep their tiny
+ *     initial values;
+ *  2) quantized by its own LinearQuantizer to n_bits, with scale and offset;
+ *  3) entropy coded by RANSCoder.
+ *
+ * Format (little-endian):
+ *   uint32 the number of segments
+ *   for each segment:
+ *     uint32  the number of values
+ *     uint8   the number of bits
+ *     float32 the scale and the offset
+ *     uint32  the encoded size, followed by the RANSCoder stream of codes.
+ */
+class QuantizedArrayCodec {
+public:
+    struct Options {
+        // Bits per code, 1 to 8.
+        int n_bits = 8;
+
+        // Values with absolute value up to it are set to zero.
+        float zero_threshold = 0.0f;
+
+        // Ratio of the nonzero values at each tail that may be clamped, see
+        // LinearQuantizer::ResetByQuantiles().
+        double clip_ratio = 0.0;
+
+        // Chunk size of the entropy coder.
+        int chunk_size = 1 << 18;
+    };
+
+    QuantizedArrayCodec() = default;
+
+    explicit QuantizedArrayCodec(const Options& options)
+        : options_(options) {
+        CHECK(options.n_bits >= 1 && options.n_bits <= 8);
+        CHECK(options.zero_threshold >= 0.0f);
+        CHECK(options.clip_ratio >= 0.0 && options.clip_ratio < 0.5);
+        CHECK(options.chunk_size > 0);
+    }
+
+    /**
+     * Encode 'data', split into segments of the given sizes.
+     */
+    void Encode(const float* data, const Array<int>& segment_sizes,
+                Array<uint8_t>* encoded) const {
+        CHECK(encoded);
+
+        encoded->clear();
+        Write(static_cast<uint32_t>(segment_sizes.size()), encoded);
+
+        RANSCoder coder(options_.chunk_size);
+        Array<float> values;
+        Array<uint8_t> codes, stream;
+        for (int n : segment_sizes) {
+            CHECK(n >= 0);
+
+            values.assign(data, data + n);
+            data += n;
+            for (float& v : values) {
+                CHECK(std::isfinite(v));
+                if (std::fabs(v) <= options_.zero_threshold) v = 0.0f;
+            }
+
+            LinearQuantizer quantizer(options_.n_bits);
+            if (options_.clip_ratio > 0.0) {
+                quantizer.ResetByQuantiles(values.data(), n,
+                                           options_.clip_ratio);
+            } else {
+                quantizer.Reset(values.data(), n);
+            }
+            codes.resize(n);
+            quantizer.Quantize(values.data(), n, codes.data());
+            coder.Encode(codes, &stream);
+
+            Write(static_cast<uint32_t>(n), encoded);
+            encoded->push_back(static_cast<uint8_t>(options_.n_bits));
+            Write(quantizer.scale(), encoded);
+            Write(quantizer.offset(), encoded);
+            Write(static_cast<uint32_t>(stream.size()), encoded);
+            int pos = encoded->size();
+            encoded->resize(pos + stream.size());
+            std::copy(stream.begin(), stream.end(), encoded->begin() + pos);
+        }
+    }
+
+    void Encode(const Array<float>& data, const Array<int>& segment_sizes,
+                Array<uint8_t>* encoded) const {
+        int n = 0;
+        for (int size : segment_sizes) {
+            n += size;
+        }
+        CHECK(n == data.size());
+
+        Encode(data.data(), segment_sizes, encoded);
+    }
+
+    /**
+     * Decode the stream written by Encode(). Return false if it is truncated
+     * or corrupted.
+     */
+    static bool Decode(const uint8_t* encoded, int size, Array<float>* data) {
+        CHECK(size >= 0);
+        CHECK(data);
+
+        data->clear();
+        const uint8_t* p = encoded;
+        const uint8_t* end = encoded + size;
+
+        uint32_t n_segments;
+        if (!Read(&p, end, &n_segments)) return false;
+
+        RANSCoder coder;
+        Array<uint8_t> codes;
+        for (uint32_t s = 0; s < n_segments; ++s) {
+            uint32_t n, stream_size;
+            float scale, offset;
+            if (!Read(&p, end, &n) || p == end) return false;
+            int n_bits = *p++;
+            if (!Read(&p, end, &scale) || !Read(&p, end, &offset) ||
+                !Read(&p, end, &stream_size)) {
+                return false;
+            }
+            if (n_bits < 1 || n_bits > 8 || !(scale >= 0.0f) ||
+                stream_size > static_cast<uint32_t>(end - p)) {
+                return false;
+            }
+            if (!coder.Decode(p, stream_size, &codes) ||
+                codes.size() != static_cast<int64_t>(n)) {
+                return false;
+            }
+            p += stream_size;
+
+            int first = data->size();
+            data->resize(first + codes.size());
+            LinearQuantizer quantizer(n_bits, scale, offset);
+            quantizer.Dequantize(codes.data(), codes.size(),
+                                 data->data() + first);
+        }
+        return p == end;
+    }
+
+    static bool Decode(const Array<uint8_t>& encoded, Array<float>* data) {
+        return Decode(encoded.data(), encoded.size(), data);
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+    template <typename T>
+    static void Write(T v, Array<uint8_t>* encoded) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &v, sizeof(T));
+        encoded->insert(bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    static bool Read(const uint8_t** p, const uint8_t* end, T* v) {
+        if (end - *p < static_cast<int64_t>(sizeof(T))) return false;
+        std::memcpy(v, *p, sizeof(T));
+        *p += sizeof(T);
+        return true;
+    }
+
+    Options options_;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_CODEC_QUANTIZED_ARRAY_CODEC_H_
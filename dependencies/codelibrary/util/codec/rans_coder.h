@@ -0,0 +1,316 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_CODEC_RANS_CODER_H_
+#define CODELIBRARY_UTIL_CODEC_RANS_CODER_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+
+/**
+ * Order-0 entropy coder for byte streams, based on range asymmetric numeral
+ * systems (rANS, Duda 2013), with the byte-wise renormalization of Giesen's
+ * ryg_rans.
+ *
+ * The input is split into chunks that are coded independently with one shared
+ * frequency table, so that both encoding and decoding run in parallel over the
+ * chunks (by OpenMP, if enabled). The cost is 4 bytes of final state and 4
+ * bytes of size per chunk.
+ *
+ * Format (little-endian):
+ *   uint32      the number of symbols
+ *   uint32      the chunk size
+ *   uint16[256] the normalized frequencies (sum to 1 << PROB_BITS)
+ *   uint32[]    the byte size of each chunk
+ *   uint8[]     the chunks
+ *
+ * Usage:
+ *
+ *   RANSCoder coder;
+ *   Array<uint8_t> encoded, decoded;
+ *   coder.Encode(data, &encoded);
+ *   CHECK(coder.Decode(encoded, &decoded));
+ */
+class RANSCoder {
+    // Precision of the frequencies.
+    static const int PROB_BITS = 12;
+    static const uint32_t PROB_SCALE = 1u << PROB_BITS;
+
+    // Lower bound of the normalized state interval [L, 256 * L).
+    static const uint32_t RANS_L = 1u << 23;
+
+    // Size of the header before the chunk sizes.
+    static const int HEADER_SIZE = 8 + 2 * 256;
+
+public:
+    /**
+     * 'chunk_size' is the number of symbols in each independent chunk.
+     */
+    explicit RANSCoder(int chunk_size = 1 << 18)
+        : chunk_size_(chunk_size) {
+        CHECK(chunk_size > 0);
+    }
+
+    /**
+     * Encode n bytes into 'encoded'.
+     */
+    void Encode(const uint8_t* data, int n, Array<uint8_t>* encoded) const {
+        CHECK(n >= 0);
+        CHECK(n == 0 || data);
+        CHECK(encoded);
+
+        // Build the frequency table.
+        uint32_t counts[256] = {};
+        for (int i = 0; i < n; ++i) {
+            ++counts[data[i]];
+        }
+        uint32_t freqs[256], starts[257];
+        NormalizeFrequencies(counts, freqs);
+        starts[0] = 0;
+        for (int s = 0; s < 256; ++s) {
+            starts[s + 1] = starts[s] + freqs[s];
+        }
+
+        // Encode the chunks.
+        int n_chunks = (n + chunk_size_ - 1) / chunk_size_;
+        Array<Array<uint8_t>> chunks(n_chunks);
+
+        #pragma omp parallel for schedule(dynamic) if (n_chunks > 1)
+        for (int c = 0; c < n_chunks; ++c) {
+            int first = c * chunk_size_;
+            int last = std::min(first + chunk_size_, n);
+            EncodeChunk(data + first, last - first, freqs, starts, &chunks[c]);
+        }
+
+        // Write the header, the chunk sizes and the chunks.
+        int size = HEADER_SIZE + 4 * n_chunks;
+        for (const Array<uint8_t>& chunk : chunks) {
+            size += chunk.size();
+        }
+        encoded->resize(size);
+        uint8_t* p = encoded->data();
+        p = Write32(n, p);
+        p = Write32(chunk_size_, p);
+        for (int s = 0; s < 256; ++s) {
+            *p++ = static_cast<uint8_t>(freqs[s]);
+            *p++ = static_cast<uint8_t>(freqs[s] >> 8);
+        }
+        for (const Array<uint8_t>& chunk : chunks) {
+            p = Write32(chunk.size(), p);
+        }
+        for (const Array<uint8_t>& chunk : chunks) {
+            std::copy(chunk.begin(), chunk.end(), p);
+            p += chunk.size();
+        }
+    }
+
+    void Encode(const Array<uint8_t>& data, Array<uint8_t>* encoded) const {
+        Encode(data.data(), data.size(), encoded);
+    }
+
+    /**
+     * Decode the stream written by Encode().
+     *
+     * Return false if the stream is truncated or corrupted. The chunk size is
+     * read from the stream, so it may differ from this coder's.
+     */
+    bool Decode(const uint8_t* encoded, int size,
+                Array<uint8_t>* data) const {
+        CHECK(size >= 0);
+        CHECK(size == 0 || encoded);
+        CHECK(data);
+
+        data->clear();
+        if (size < HEADER_SIZE) return false;
+
+        const uint8_t* p = encoded;
+        uint32_t n = Read32(p);
+        uint32_t chunk_size = Read32(p + 4);
+        p += 8;
+        if (n > static_cast<uint32_t>(INT32_MAX) || chunk_size == 0) {
+            return false;
+        }
+
+        uint32_t freqs[256], starts[257];
+        starts[0] = 0;
+        for (int s = 0; s < 256; ++s) {
+            freqs[s] = p[0] | (static_cast<uint32_t>(p[1]) << 8);
+            starts[s + 1] = starts[s] + freqs[s];
+            p += 2;
+        }
+        if (n > 0 && starts[256] != PROB_SCALE) return false;
+
+        // Map each slot of the probability range to its symbol.
+        Array<uint8_t> symbols(n > 0 ? PROB_SCALE : 0);
+        for (int s = 0; s < 256 && n > 0; ++s) {
+            std::fill(symbols.begin() + starts[s],
+                      symbols.begin() + starts[s + 1],
+                      static_cast<uint8_t>(s));
+        }
+
+        int n_chunks = static_cast<int>((n + chunk_size - 1) / chunk_size);
+        if (n_chunks > (size - HEADER_SIZE) / 4) return false;
+        Array<int64_t> offsets(n_chunks + 1);
+        offsets[0] = HEADER_SIZE + 4 * static_cast<int64_t>(n_chunks);
+        for (int c = 0; c < n_chunks; ++c) {
+            offsets[c + 1] = offsets[c] + Read32(p);
+            p += 4;
+        }
+        if (offsets[n_chunks] != size) return false;
+
+        data->resize(n);
+        Array<char> valid(n_chunks, 1);
+
+        #pragma omp parallel for schedule(dynamic) if (n_chunks > 1)
+        for (int c = 0; c < n_chunks; ++c) {
+            int first = static_cast<int>(c * chunk_size);
+            int last = static_cast<int>(std::min<uint32_t>(
+                    (c + 1) * chunk_size, n));
+            valid[c] = DecodeChunk(encoded + offsets[c],
+                                   encoded + offsets[c + 1], freqs, starts,
+                                   symbols.data(), data->data() + first,
+                                   last - first);
+        }
+
+        if (std::find(valid.begin(), valid.end(), 0) != valid.end()) {
+            data->clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool Decode(const Array<uint8_t>& encoded, Array<uint8_t>* data) const {
+        return Decode(encoded.data(), encoded.size(), data);
+    }
+
+    int chunk_size() const {
+        return chunk_size_;
+    }
+
+private:
+    static uint8_t* Write32(uint32_t v, uint8_t* p) {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+        p[3] = static_cast<uint8_t>(v >> 24);
+        return p + 4;
+    }
+
+    static uint32_t Read32(const uint8_t* p) {
+        return p[0] | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) |
+               (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    /**
+     * Scale the counts to frequencies that sum to PROB_SCALE, keeping every
+     * present symbol at least 1.
+     */
+    static void NormalizeFrequencies(const uint32_t* counts, uint32_t* freqs) {
+        uint64_t total = 0;
+        for (int s = 0; s < 256; ++s) {
+            total += counts[s];
+        }
+        if (total == 0) {
+            std::fill(freqs, freqs + 256, 0);
+            return;
+        }
+
+        uint32_t sum = 0;
+        for (int s = 0; s < 256; ++s) {
+            if (counts[s] == 0) {
+                freqs[s] = 0;
+            } else {
+                uint64_t f = counts[s] * uint64_t(PROB_SCALE) / total;
+                freqs[s] = std::max<uint32_t>(1, static_cast<uint32_t>(f));
+            }
+            sum += freqs[s];
+        }
+
+        // Rounding down loses at most 256, and the clamping to 1 adds at most
+        // 256. Give or take the difference from the most frequent symbols,
+        // where it costs the least.
+        while (sum != PROB_SCALE) {
+            int best = 0;
+            for (int s = 1; s < 256; ++s) {
+                if (freqs[s] > freqs[best]) best = s;
+            }
+            if (sum < PROB_SCALE) {
+                freqs[best] += PROB_SCALE - sum;
+                sum = PROB_SCALE;
+            } else {
+                uint32_t d = std::min(sum - PROB_SCALE, freqs[best] / 2);
+                freqs[best] -= d;
+                sum -= d;
+            }
+        }
+    }
+
+    /**
+     * Encode one chunk. The symbols are coded in reverse, so that the decoder
+     * reads the output forward.
+     */
+    static void EncodeChunk(const uint8_t* data, int n, const uint32_t* freqs,
+                            const uint32_t* starts, Array<uint8_t>* chunk) {
+        // A symbol emits at most 2 bytes, plus 4 bytes of the final state.
+        Array<uint8_t> buffer(2 * n + 4);
+        uint8_t* end = buffer.data() + buffer.size();
+        uint8_t* p = end;
+
+        uint32_t x = RANS_L;
+        for (int i = n - 1; i >= 0; --i) {
+            uint32_t freq = freqs[data[i]];
+            uint32_t x_max = ((RANS_L >> PROB_BITS) << 8) * freq;
+            while (x >= x_max) {
+                *--p = static_cast<uint8_t>(x);
+                x >>= 8;
+            }
+            x = ((x / freq) << PROB_BITS) + (x % freq) + starts[data[i]];
+        }
+        p -= 4;
+        Write32(x, p);
+
+        chunk->assign(p, end);
+    }
+
+    /**
+     * Decode one chunk of n symbols from [p, end). Return false if the bytes
+     * run out, or the chunk does not end at the initial state.
+     */
+    static bool DecodeChunk(const uint8_t* p, const uint8_t* end,
+                            const uint32_t* freqs, const uint32_t* starts,
+                            const uint8_t* symbols, uint8_t* data, int n) {
+        if (end - p < 4) return false;
+
+        uint32_t x = Read32(p);
+        p += 4;
+        for (int i = 0; i < n; ++i) {
+            uint32_t slot = x & (PROB_SCALE - 1);
+            uint8_t s = symbols[slot];
+            data[i] = s;
+            x = freqs[s] * (x >> PROB_BITS) + slot - starts[s];
+            while (x < RANS_L) {
+                if (p == end) return false;
+                x = (x << 8) | *p++;
+            }
+        }
+        return p == end && x == RANS_L;
+    }
+
+    // The number of symbols in each chunk.
+    int chunk_size_;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_CODEC_RANS_CODER_H_
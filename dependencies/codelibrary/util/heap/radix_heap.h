@@ -0,0 +1,151 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_HEAP_RADIX_HEAP_H_
+#define CODELIBRARY_UTIL_HEAP_RADIX_HEAP_H_
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/bits.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+
+/**
+ * Monotone priority queue for unsigned integer keys (Ahuja et al., 1990).
+ *
+ * The keys pushed must not be smaller than the last popped key, which holds
+ * for Dijkstra-like algorithms with non-negative weights. An item with key k
+ * is kept in bucket b(k) = 1 + floor(log2(k ^ last)) (bucket 0 if k == last),
+ * so push is O(1), and every item moves to a lower bucket at most
+ * sizeof(Key) * 8 times in total. Compared with a binary heap, there is no
+ * sift of a large array, only appends to small ones.
+ *
+ * The buckets keep their capacity after clear(), so a heap reused for many
+ * queries does not allocate again.
+ *
+ * Usage:
+ *
+ *   RadixHeap<uint64_t, int> heap;
+ *   heap.Push(0, source);
+ *   while (!heap.empty()) {
+ *       uint64_t key;
+ *       int v;
+ *       heap.Pop(&key, &v);
+ *       ...
+ *   }
+ */
+template <typename Key, typename Value>
+class RadixHeap {
+    static_assert(std::is_unsigned<Key>::value && sizeof(Key) <= 8, "");
+
+    // Bucket 0 holds the keys equal to last_, and bucket i > 0 holds the keys
+    // whose highest bit different from last_ is bit i - 1.
+    static const int N_BUCKETS = sizeof(Key) * 8 + 1;
+
+public:
+    using Item = std::pair<Key, Value>;
+
+    RadixHeap() = default;
+
+    /**
+     * Insert a value with the given key. The key must not be smaller than the
+     * last popped key.
+     */
+    void Push(Key key, const Value& value) {
+        CHECK(key >= last_) << "RadixHeap requires monotone keys.";
+
+        buckets_[Bucket(key)].emplace_back(key, value);
+        ++size_;
+    }
+
+    /**
+     * Remove an item with the minimal key.
+     */
+    void Pop(Key* key, Value* value) {
+        CHECK(key && value);
+        CHECK(size_ > 0);
+
+        if (buckets_[0].empty()) {
+            int i = 1;
+            while (buckets_[i].empty()) ++i;
+
+            // The new minimum comes from the first non-empty bucket, and all
+            // items of that bucket move to lower buckets.
+            Array<Item>& bucket = buckets_[i];
+            Key minimum = bucket[0].first;
+            for (const Item& item : bucket) {
+                if (item.first < minimum) minimum = item.first;
+            }
+            last_ = minimum;
+            for (const Item& item : bucket) {
+                buckets_[Bucket(item.first)].push_back(item);
+            }
+            bucket.clear();
+        }
+
+        Item& item = buckets_[0].back();
+        *key = item.first;
+        *value = item.second;
+        buckets_[0].pop_back();
+        --size_;
+    }
+
+    /**
+     * Return the minimal key, without removing it.
+     */
+    Key top_key() {
+        CHECK(size_ > 0);
+
+        if (!buckets_[0].empty()) return last_;
+
+        int i = 1;
+        while (buckets_[i].empty()) ++i;
+        Key minimum = buckets_[i][0].first;
+        for (const Item& item : buckets_[i]) {
+            if (item.first < minimum) minimum = item.first;
+        }
+        return minimum;
+    }
+
+    /**
+     * Remove all items and reset the last key to 0. The memory is kept.
+     */
+    void clear() {
+        for (Array<Item>& bucket : buckets_) {
+            bucket.clear();
+        }
+        last_ = 0;
+        size_ = 0;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    int size() const {
+        return size_;
+    }
+
+private:
+    int Bucket(Key key) const {
+        return key == last_ ? 0 : 64 - bits::CountLeadingZeros(
+                static_cast<uint64_t>(key ^ last_));
+    }
+
+    Array<Item> buckets_[N_BUCKETS];
+    Key last_ = 0;
+    int size_ = 0;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_HEAP_RADIX_HEAP_H_
@@ -0,0 +1,453 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_MEMORY_MEMORY_PLANNER_H_
+#define CODELIBRARY_UTIL_MEMORY_MEMORY_PLANNER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+
+namespace cl {
+
+/**
+ * Plan the GPU memory of the block NeRFs of a street before anything is
+ * allocated, so that a job does not run out of memory hours after it starts.
+ *
+ * The footprints are the byte sizes of the buffers that the testbed allocates
+ * for a block:
+ *  - the dataset: RGBA images, depths (stored as 4 floats per pixel), rays,
+ *    the sharpness maps and the error map with its CDFs;
+ *  - the model: the parameters in full precision, in network precision and
+ *    their gradients, the optimizer state, the density grid with its
+ *    occupancy bitfield, the scratch of a density grid update and the
+ *    optional sharpness grid;
+ *  - the batch: the ray and sample buffers of a training step, which assumes
+ *    at most 16 samples per ray like the testbed, plus the activations of the
+ *    networks and their gradients.
+ * The error map and the batch are upper bounds, because they depend on the
+ * number of rays per batch, which is at most the batch size.
+ *
+ * Plan() recommends, in this order of preference: the smallest image
+ * downscale and then the largest batch size for which a block can be
+ * trained, and the number of blocks that can be resident at once to render.
+ */
+class MemoryPlanner {
+public:
+    /**
+     * Resolution of a training image.
+     */
+    struct Image {
+        Image() = default;
+
+        Image(int width, int height)
+            : width(width), height(height) {}
+
+        int width = 0;
+        int height = 0;
+    };
+
+    /**
+     * Metadata of the training images of a block.
+     */
+    struct Dataset {
+        Array<Image> images;
+
+        // Bytes per channel of the RGBA pixels: 1, 2 or 4.
+        int bytes_per_channel = 1;
+
+        bool has_depth = false;
+        bool has_rays = false;
+
+        // Resolution of the sharpness map of each image.
+        int sharpness_width = 128;
+        int sharpness_height = 72;
+    };
+
+    /**
+     * Layout of the hash-grid NeRF network, and of the training state.
+     */
+    struct Network {
+        // Multiresolution hash grid encoding of the positions.
+        int n_levels = 16;
+        int n_features_per_level = 2;
+        int log2_hashmap_size = 19;
+        int base_resolution = 16;
+        double per_level_scale = 2.0;
+
+        // Spherical harmonics encoding of the directions.
+        int sh_degree = 4;
+
+        // Density and color MLPs.
+        int density_neurons = 64;
+        int density_hidden_layers = 1;
+        int density_output_width = 16;
+        int rgb_neurons = 64;
+        int rgb_hidden_layers = 2;
+
+        // Extra dims appended to the sample coordinates.
+        int n_extra_dims = 0;
+
+        // Bytes of a parameter in network precision.
+        int param_bytes = 2;
+
+        // Bytes of optimizer state per parameter, e.g., 12 for Adam (two
+        // moments and a step count).
+        int optimizer_bytes = 12;
+
+        // Density grid.
+        int64_t n_grid_cells = 128 * 128 * 128;
+        int n_cascades = 8;
+
+        bool has_sharpness_grid = false;
+
+        // Training steps between the updates of the error map.
+        int error_map_interval = 128;
+    };
+
+    /**
+     * Byte footprint of a block.
+     */
+    struct Footprint {
+        int64_t images = 0;
+        int64_t depths = 0;
+        int64_t rays = 0;
+        int64_t sharpness = 0;
+        int64_t error_map = 0;
+
+        int64_t parameters = 0;
+        int64_t optimizer = 0;
+        int64_t density_grid = 0;
+        int64_t grid_update = 0;
+        int64_t sharpness_grid = 0;
+
+        int64_t batch = 0;
+
+        int64_t dataset() const {
+            return images + depths + rays + sharpness + error_map;
+        }
+
+        int64_t model() const {
+            return parameters + optimizer + density_grid + grid_update +
+                   sharpness_grid;
+        }
+
+        int64_t total() const {
+            return dataset() + model() + batch;
+        }
+    };
+
+    struct Options {
+        // Memory budget in bytes.
+        int64_t budget = int64_t(8) << 30;
+
+        // Fraction of the budget left for the CUDA context, the render
+        // buffers and the fragmentation of the allocator.
+        double headroom = 0.1;
+
+        // Images are downscaled by powers of two up to it.
+        int max_downscale = 8;
+
+        // Batch sizes are powers of two in this range.
+        int min_batch_size = 1 << 14;
+        int max_batch_size = 1 << 18;
+
+        // Fewer resident blocks than it can not render the street, e.g., the
+        // number of blocks composited in a frame.
+        int min_resident_blocks = 2;
+    };
+
+    /**
+     * Recommended settings.
+     */
+    struct Settings {
+        int downscale = 1;
+        int batch_size = 0;
+        int n_resident_blocks = 0;
+
+        // Footprint of training a block with these settings.
+        Footprint training;
+
+        // Bytes of rendering with 'n_resident_blocks' blocks.
+        int64_t rendering = 0;
+
+        // True if both training and rendering fit the budget.
+        bool fits = false;
+    };
+
+    MemoryPlanner() = default;
+
+    explicit MemoryPlanner(const Options& options)
+        : options_(options) {
+        CHECK(options.budget > 0);
+        CHECK(options.headroom >= 0.0 && options.headroom < 1.0);
+        CHECK(options.max_downscale >= 1);
+        CHECK(options.min_batch_size > 0);
+        CHECK(options.min_batch_size <= options.max_batch_size);
+        CHECK(options.min_resident_blocks >= 0);
+    }
+
+    /**
+     * Return the number of parameters of a hash grid encoding of 3D
+     * positions, in the layout of tiny-cuda-nn.
+     */
+    static int64_t HashGridParams(int n_levels, int n_features_per_level,
+                                  int log2_hashmap_size, int base_resolution,
+                                  double per_level_scale) {
+        CHECK(n_levels > 0 && n_features_per_level > 0);
+        CHECK(log2_hashmap_size > 0 && log2_hashmap_size < 32);
+        CHECK(base_resolution > 0 && per_level_scale >= 1.0);
+
+        const int64_t hashmap_size = int64_t(1) << log2_hashmap_size;
+        int64_t n = 0;
+        for (int level = 0; level < n_levels; ++level) {
+            // The same as grid_scale() and grid_resolution() of tiny-cuda-nn.
+            float scale = std::exp2(level * std::log2(float(per_level_scale))) *
+                          base_resolution - 1.0f;
+            int64_t resolution = int64_t(std::ceil(scale)) + 1;
+            int64_t dense = resolution * resolution * resolution;
+            n += std::min(NextMultiple(dense, 8), hashmap_size);
+        }
+        return n * n_features_per_level;
+    }
+
+    /**
+     * Return the number of parameters of a fully fused MLP, whose output
+     * width is padded to a multiple of 16.
+     */
+    static int64_t MLPParams(int n_input, int n_neurons, int n_hidden_layers,
+                             int n_output) {
+        CHECK(n_input > 0 && n_neurons > 0 && n_hidden_layers > 0);
+        CHECK(n_output > 0);
+
+        return int64_t(n_input) * n_neurons +
+               int64_t(n_hidden_layers - 1) * n_neurons * n_neurons +
+               int64_t(n_neurons) * NextMultiple(n_output, 16);
+    }
+
+    /**
+     * Return the number of parameters of the network.
+     */
+    static int64_t NumParams(const Network& network) {
+        const Widths w = GetWidths(network);
+        return HashGridParams(network.n_levels, network.n_features_per_level,
+                              network.log2_hashmap_size,
+                              network.base_resolution,
+                              network.per_level_scale) +
+               MLPParams(w.encoding, network.density_neurons,
+                         network.density_hidden_layers,
+                         network.density_output_width) +
+               MLPParams(w.rgb_input, network.rgb_neurons,
+                         network.rgb_hidden_layers, 3);
+    }
+
+    /**
+     * Compute the footprint of training a block with the images downscaled by
+     * 'downscale', and batches of 'batch_size' samples.
+     */
+    Footprint Estimate(const Dataset& dataset, const Network& network,
+                       int downscale, int batch_size) const {
+        CHECK(downscale >= 1 && batch_size > 0);
+        CHECK(dataset.bytes_per_channel == 1 ||
+              dataset.bytes_per_channel == 2 ||
+              dataset.bytes_per_channel == 4);
+
+        Footprint f;
+        const int64_t n_images = dataset.images.size();
+        for (const Image& image : dataset.images) {
+            CHECK(image.width > 0 && image.height > 0);
+            int64_t n_pixels = Downscaled(image.width, downscale) *
+                               Downscaled(image.height, downscale);
+            f.images += n_pixels * 4 * dataset.bytes_per_channel;
+            if (dataset.has_depth) f.depths += n_pixels * 4 * sizeof(float);
+            if (dataset.has_rays) f.rays += n_pixels * kRayBytes;
+        }
+        f.sharpness = int64_t(dataset.sharpness_width) *
+                      dataset.sharpness_height * n_images * sizeof(float);
+
+        // The error map and its CDFs, at the resolution of the testbed.
+        if (n_images > 0) {
+            int64_t samples = int64_t(network.error_map_interval) *
+                              batch_size / n_images;
+            int r = static_cast<int>(std::sqrt(std::sqrt(float(samples))) *
+                                     3.5f);
+            const Image& image = dataset.images.front();
+            int64_t rx = std::min(r, Downscaled(image.width, downscale));
+            int64_t ry = std::min(r, Downscaled(image.height, downscale));
+            f.error_map = (2 * rx * ry + ry + 1) * n_images * sizeof(float);
+        }
+
+        const int64_t n_params = NumParams(network);
+        f.parameters = n_params * (sizeof(float) + 2 * network.param_bytes);
+        f.optimizer = n_params * network.optimizer_bytes;
+
+        const int64_t n_cells = network.n_grid_cells * network.n_cascades;
+        f.density_grid = n_cells * sizeof(float) + n_cells / 8;
+
+        // Positions, cell indices, new densities and the density outputs of
+        // at most one sample per cell.
+        const Widths w = GetWidths(network);
+        f.grid_update = n_cells * (3 * sizeof(float) + sizeof(uint32_t) +
+                                   sizeof(float) + int64_t(w.density_output) *
+                                                   network.param_bytes);
+        if (network.has_sharpness_grid) {
+            f.sharpness_grid = n_cells * sizeof(float);
+        }
+
+        f.batch = BatchBytes(network, batch_size);
+        return f;
+    }
+
+    /**
+     * Return the bytes of a block that is resident to be rendered: its
+     * trainer, optimizer and density grid.
+     */
+    static int64_t ResidentBlockBytes(const Network& network) {
+        const int64_t n_params = NumParams(network);
+        return n_params * (sizeof(float) + 2 * network.param_bytes +
+                           network.optimizer_bytes) +
+               network.n_grid_cells * network.n_cascades * sizeof(float);
+    }
+
+    /**
+     * Recommend the settings of training and rendering 'n_blocks' blocks
+     * whose largest dataset is 'dataset'.
+     */
+    void Plan(const Dataset& dataset, const Network& network, int n_blocks,
+              Settings* settings) const {
+        CHECK(n_blocks >= 0);
+        CHECK(settings);
+
+        const int64_t usable = static_cast<int64_t>(
+                static_cast<double>(options_.budget) *
+                (1.0 - options_.headroom));
+
+        // Training: the smallest downscale, then the largest batch.
+        *settings = Settings();
+        bool trainable = false;
+        for (int s = 1; s <= options_.max_downscale && !trainable; s *= 2) {
+            for (int b = options_.max_batch_size;
+                 b >= options_.min_batch_size; b /= 2) {
+                Footprint f = Estimate(dataset, network, s, b);
+                if (f.total() <= usable) {
+                    settings->downscale = s;
+                    settings->batch_size = b;
+                    settings->training = f;
+                    trainable = true;
+                    break;
+                }
+            }
+        }
+        if (!trainable) {
+            int s = 1;
+            while (s * 2 <= options_.max_downscale) s *= 2;
+            settings->downscale = s;
+            settings->batch_size = options_.min_batch_size;
+            settings->training = Estimate(dataset, network, s,
+                                          options_.min_batch_size);
+        }
+
+        // Rendering: the resident blocks and the density grid in use.
+        const int64_t n_cells = network.n_grid_cells * network.n_cascades;
+        const int64_t grid = n_cells * sizeof(float) + n_cells / 8;
+        const int64_t block = ResidentBlockBytes(network);
+        int64_t n = usable > grid ? (usable - grid) / block : 0;
+        settings->n_resident_blocks = static_cast<int>(
+                std::min<int64_t>(n, n_blocks));
+        settings->rendering = grid + block * settings->n_resident_blocks;
+
+        settings->fits = trainable && settings->n_resident_blocks >=
+                         std::min(options_.min_resident_blocks, n_blocks);
+    }
+
+    const Options& options() const {
+        return options_;
+    }
+
+private:
+    // Bytes of a ray: origin and direction.
+    static const int kRayBytes = 6 * sizeof(float);
+
+    // Padded output width of the network, (r, g, b, density).
+    static const int kOutputWidth = 16;
+
+    // Maximum samples per ray of a training batch.
+    static const int kMaxSamplesPerRay = 16;
+
+    /**
+     * Padded widths of the layers of the network.
+     */
+    struct Widths {
+        int encoding = 0;
+        int density_output = 0;
+        int rgb_input = 0;
+    };
+
+    static Widths GetWidths(const Network& network) {
+        CHECK(network.sh_degree >= 1 && network.sh_degree <= 4);
+
+        Widths w;
+        w.encoding = static_cast<int>(NextMultiple(
+                network.n_levels * network.n_features_per_level, 16));
+        w.density_output = static_cast<int>(NextMultiple(
+                network.density_output_width, 16));
+        int directions = static_cast<int>(NextMultiple(
+                network.sh_degree * network.sh_degree, 16));
+        w.rgb_input = static_cast<int>(NextMultiple(
+                w.density_output + directions, 16));
+        return w;
+    }
+
+    /**
+     * Return the scratch bytes of a training step, see train_nerf_step().
+     */
+    static int64_t BatchBytes(const Network& network, int batch_size) {
+        const int64_t b = batch_size;
+        const int64_t max_samples = b * kMaxSamplesPerRay;
+        const int64_t coord = (7 + network.n_extra_dims) * sizeof(float);
+        const int p = network.param_bytes;
+
+        // Ray indices, rays and steps of at most one ray per sample.
+        int64_t bytes = b * (sizeof(uint32_t) + kRayBytes +
+                             2 * sizeof(uint32_t));
+
+        // Coordinates and levels of the samples, before and after the
+        // compaction, the outputs and their gradients.
+        bytes += max_samples * (coord + sizeof(float));
+        bytes += max_samples * kOutputWidth * p;
+        bytes += b * kOutputWidth * p;
+        bytes += b * (2 * coord + sizeof(float)) + sizeof(uint32_t);
+
+        // The activations of the forward pass kept for the backward pass, and
+        // their gradients.
+        const Widths w = GetWidths(network);
+        int64_t activations = w.encoding + w.rgb_input +
+            int64_t(network.density_hidden_layers) * network.density_neurons +
+            int64_t(network.rgb_hidden_layers) * network.rgb_neurons;
+        bytes += 2 * b * activations * p;
+        return bytes;
+    }
+
+    static int Downscaled(int size, int downscale) {
+        return std::max(1, size / downscale);
+    }
+
+    static int64_t NextMultiple(int64_t value, int64_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    Options options_;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_MEMORY_MEMORY_PLANNER_H_
@@ -0,0 +1,343 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_SET_COMPRESSED_BITSET_H_
+#define CODELIBRARY_UTIL_SET_COMPRESSED_BITSET_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/bits.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/util/set/dynamic_bitset.h"
+
+namespace cl {
+
+/**
+ * Run-length compressed, read-only copy of a DynamicBitset.
+ *
+ * The set bits are stored as sorted, disjoint runs [first, last). It is the
+ * compact form for masks made of few long runs, such as occupancy masks of
+ * solid regions. Test() is a binary search over the runs.
+ */
+class RunLengthBitset {
+public:
+    RunLengthBitset() = default;
+
+    explicit RunLengthBitset(const DynamicBitset& bitset) {
+        Reset(bitset);
+    }
+
+    /**
+     * Compress 'bitset'. Runs are found word by word with
+     * count-trailing-zeros, so words inside a run or a gap cost one compare.
+     */
+    void Reset(const DynamicBitset& bitset) {
+        using Block = DynamicBitset::Block;
+
+        n_bits_ = bitset.size();
+        n_ones_ = 0;
+        firsts_.clear();
+        lasts_.clear();
+
+        const Block* words = bitset.data();
+        int n_words = bitset.n_blocks();
+        bool in_run = false;
+        for (int i = 0; i < n_words; ++i) {
+            // Bit t of 'edges' is set where bit t differs from bit t - 1.
+            Block word = words[i];
+            Block previous = (word << 1) | (in_run ? 1 : 0);
+            Block edges = word ^ previous;
+            while (edges != 0) {
+                int pos = i * 64 + bits::CountTrailingZeros(edges);
+                if (in_run) {
+                    lasts_.push_back(pos);
+                } else {
+                    firsts_.push_back(pos);
+                }
+                in_run = !in_run;
+                edges &= edges - 1;
+            }
+            in_run = (word >> 63) != 0;
+        }
+        if (in_run) lasts_.push_back(n_bits_);
+
+        for (int i = 0; i < firsts_.size(); ++i) {
+            n_ones_ += lasts_[i] - firsts_[i];
+        }
+    }
+
+    /**
+     * Return whether the bit at position pos is set.
+     */
+    bool Test(int pos) const {
+        CHECK(pos >= 0 && pos < n_bits_);
+
+        // The last run starting at or before pos.
+        auto i = std::upper_bound(firsts_.begin(), firsts_.end(), pos);
+        if (i == firsts_.begin()) return false;
+        return pos < lasts_[static_cast<int>(i - firsts_.begin()) - 1];
+    }
+
+    /**
+     * Call f(pos) for every set bit, in increasing order.
+     */
+    template <typename Function>
+    void ForEachSetBit(Function f) const {
+        for (int i = 0; i < firsts_.size(); ++i) {
+            for (int pos = firsts_[i]; pos < lasts_[i]; ++pos) {
+                f(pos);
+            }
+        }
+    }
+
+    /**
+     * Decompress to a DynamicBitset.
+     */
+    void ToDynamicBitset(DynamicBitset* bitset) const {
+        CHECK(bitset);
+
+        *bitset = DynamicBitset(n_bits_);
+        for (int i = 0; i < firsts_.size(); ++i) {
+            bitset->SetRange(firsts_[i], lasts_[i]);
+        }
+    }
+
+    /**
+     * Return the number of set bits.
+     */
+    int Count() const {
+        return n_ones_;
+    }
+
+    /**
+     * Return the number of bits.
+     */
+    int size() const {
+        return n_bits_;
+    }
+
+    /**
+     * Return the number of runs.
+     */
+    int n_runs() const {
+        return firsts_.size();
+    }
+
+    const Array<int>& firsts() const {
+        return firsts_;
+    }
+
+    const Array<int>& lasts() const {
+        return lasts_;
+    }
+
+    /**
+     * Return the number of bytes used by the runs.
+     */
+    int64_t memory_usage() const {
+        return static_cast<int64_t>(sizeof(int)) * 2 * firsts_.size();
+    }
+
+private:
+    int n_bits_ = 0;
+    int n_ones_ = 0;
+    Array<int> firsts_; // First bit of each run.
+    Array<int> lasts_;  // One past the last bit of each run.
+};
+
+/**
+ * Roaring compressed, read-only copy of a DynamicBitset (Chambi et al., 2016).
+ *
+ * The bits are cut into chunks of 2^16. Empty chunks are not stored, a chunk
+ * with at most 4096 set bits keeps their sorted low 16 bits (array
+ * container), and a denser chunk keeps its 1024 words (bitmap container). So
+ * every container is at most 8KB and never larger than the bitmap, while
+ * sparse sets cost about two bytes per set bit.
+ */
+class RoaringBitset {
+    using Block = DynamicBitset::Block;
+
+    // The number of bits in one chunk.
+    static const int CHUNK_SIZE = 1 << 16;
+
+    // The number of words in one chunk.
+    static const int WORDS_PER_CHUNK = CHUNK_SIZE / 64;
+
+    // Chunks with more set bits are stored as bitmaps.
+    static const int MAX_ARRAY_SIZE = 4096;
+
+    struct Container {
+        int key = 0;               // Chunk index, i.e., pos >> 16.
+        int cardinality = 0;       // Number of set bits.
+        Array<uint16_t> values;    // Sorted low bits, for array containers.
+        Array<Block> bitmap;       // Words, for bitmap containers.
+
+        bool is_bitmap() const {
+            return cardinality > MAX_ARRAY_SIZE;
+        }
+    };
+
+public:
+    RoaringBitset() = default;
+
+    explicit RoaringBitset(const DynamicBitset& bitset) {
+        Reset(bitset);
+    }
+
+    /**
+     * Compress 'bitset'.
+     */
+    void Reset(const DynamicBitset& bitset) {
+        n_bits_ = bitset.size();
+        n_ones_ = 0;
+        containers_.clear();
+
+        const Block* words = bitset.data();
+        int n_words = bitset.n_blocks();
+        for (int first = 0; first < n_words; first += WORDS_PER_CHUNK) {
+            int n = std::min(WORDS_PER_CHUNK, n_words - first);
+            int cardinality = 0;
+            for (int i = 0; i < n; ++i) {
+                cardinality += bits::CountOnes(words[first + i]);
+            }
+            if (cardinality == 0) continue;
+
+            Container c;
+            c.key = first / WORDS_PER_CHUNK;
+            c.cardinality = cardinality;
+            if (c.is_bitmap()) {
+                c.bitmap.resize(WORDS_PER_CHUNK, 0);
+                std::copy(words + first, words + first + n, c.bitmap.begin());
+            } else {
+                c.values.reserve(cardinality);
+                for (int i = 0; i < n; ++i) {
+                    Block b = words[first + i];
+                    while (b != 0) {
+                        int t = i * 64 + bits::CountTrailingZeros(b);
+                        c.values.push_back(static_cast<uint16_t>(t));
+                        b &= b - 1;
+                    }
+                }
+            }
+            n_ones_ += cardinality;
+            containers_.push_back(std::move(c));
+        }
+    }
+
+    /**
+     * Return whether the bit at position pos is set.
+     */
+    bool Test(int pos) const {
+        CHECK(pos >= 0 && pos < n_bits_);
+
+        int key = pos >> 16;
+        auto c = std::lower_bound(containers_.begin(), containers_.end(), key,
+                                  [](const Container& a, int k) {
+            return a.key < k;
+        });
+        if (c == containers_.end() || c->key != key) return false;
+
+        int low = pos & (CHUNK_SIZE - 1);
+        if (c->is_bitmap()) {
+            return ((c->bitmap[low / 64] >> (low % 64)) & 1) != 0;
+        }
+        return std::binary_search(c->values.begin(), c->values.end(),
+                                  static_cast<uint16_t>(low));
+    }
+
+    /**
+     * Call f(pos) for every set bit, in increasing order.
+     */
+    template <typename Function>
+    void ForEachSetBit(Function f) const {
+        for (const Container& c : containers_) {
+            int base = c.key << 16;
+            if (c.is_bitmap()) {
+                for (int i = 0; i < WORDS_PER_CHUNK; ++i) {
+                    Block b = c.bitmap[i];
+                    while (b != 0) {
+                        f(base + i * 64 + bits::CountTrailingZeros(b));
+                        b &= b - 1;
+                    }
+                }
+            } else {
+                for (uint16_t v : c.values) {
+                    f(base + v);
+                }
+            }
+        }
+    }
+
+    /**
+     * Decompress to a DynamicBitset.
+     */
+    void ToDynamicBitset(DynamicBitset* bitset) const {
+        CHECK(bitset);
+
+        *bitset = DynamicBitset(n_bits_);
+        Block* words = bitset->data();
+        int n_words = bitset->n_blocks();
+        for (const Container& c : containers_) {
+            int first = c.key * WORDS_PER_CHUNK;
+            if (c.is_bitmap()) {
+                int n = std::min(WORDS_PER_CHUNK, n_words - first);
+                std::copy(c.bitmap.begin(), c.bitmap.begin() + n,
+                          words + first);
+            } else {
+                for (uint16_t v : c.values) {
+                    words[first + v / 64] |= Block(1) << (v % 64);
+                }
+            }
+        }
+    }
+
+    /**
+     * Return the number of set bits.
+     */
+    int Count() const {
+        return n_ones_;
+    }
+
+    /**
+     * Return the number of bits.
+     */
+    int size() const {
+        return n_bits_;
+    }
+
+    /**
+     * Return the number of non-empty chunks.
+     */
+    int n_containers() const {
+        return containers_.size();
+    }
+
+    /**
+     * Return the number of bytes used by the containers.
+     */
+    int64_t memory_usage() const {
+        int64_t bytes = 0;
+        for (const Container& c : containers_) {
+            bytes += sizeof(Container);
+            bytes += static_cast<int64_t>(sizeof(uint16_t)) * c.values.size();
+            bytes += static_cast<int64_t>(sizeof(Block)) * c.bitmap.size();
+        }
+        return bytes;
+    }
+
+private:
+    int n_bits_ = 0;
+    int n_ones_ = 0;
+    Array<Container> containers_; // Non-empty chunks, sorted by key.
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_SET_COMPRESSED_BITSET_H_
@@ -10,14 +10,222 @@
 #define CODELIBRARY_UTIL_SET_DYNAMIC_BITSET_H_
 
 #include <algorithm>
+#include <climits>
 #include <cstdint>
 #include <cstring>
 #include <string>
 
 #include "codelibrary/base/array.h"
 #include "codelibrary/base/bits.h"
+#include "codelibrary/base/log.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CL_BITSET_X86_DISPATCH
+#include <immintrin.h>
+#define CL_BITSET_TARGET(isa) __attribute__((target(isa)))
+#endif
 
 namespace cl {
+namespace bitset_internal {
+
+/**
+ * Word-wise operations supported by BulkOperation().
+ */
+enum class BitOperation {
+    kAnd,
+    kOr,
+    kXor,
+    kAndNot
+};
+
+template <BitOperation op>
+inline uint64_t Apply(uint64_t a, uint64_t b) {
+    switch (op) {
+    case BitOperation::kAnd:    return a & b;
+    case BitOperation::kOr:     return a | b;
+    case BitOperation::kXor:    return a ^ b;
+    case BitOperation::kAndNot: return a & ~b;
+    }
+    return a;
+}
+
+/**
+ * a[i] = a[i] op b[i] for the first n words, in plain C++. The compiler
+ * vectorizes it for the baseline instruction set.
+ */
+template <BitOperation op>
+void GenericBulkOperation(uint64_t* a, const uint64_t* b, int n) {
+    for (int i = 0; i < n; ++i) {
+        a[i] = Apply<op>(a[i], b[i]);
+    }
+}
+
+/**
+ * Count the set bits of the first n words, one word at a time.
+ */
+inline int GenericCount(const uint64_t* a, int n) {
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        count += bits::CountOnes(a[i]);
+    }
+    return count;
+}
+
+#if defined(CL_BITSET_X86_DISPATCH)
+
+/**
+ * Return true if the running CPU supports AVX2 (detected once).
+ */
+inline bool HasAVX2() {
+    static const bool has_avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return has_avx2;
+}
+
+/**
+ * Return true if the running CPU has the POPCNT instruction (detected once).
+ */
+inline bool HasPOPCNT() {
+    static const bool has_popcnt = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("popcnt") != 0;
+    }();
+    return has_popcnt;
+}
+
+/**
+ * AVX2 version of GenericBulkOperation(), four words per instruction.
+ */
+template <BitOperation op>
+CL_BITSET_TARGET("avx2")
+void AVX2BulkOperation(uint64_t* a, const uint64_t* b, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* pa = reinterpret_cast<__m256i*>(a + i);
+        const __m256i* pb = reinterpret_cast<const __m256i*>(b + i);
+        __m256i x0 = _mm256_loadu_si256(pa);
+        __m256i x1 = _mm256_loadu_si256(pa + 1);
+        __m256i y0 = _mm256_loadu_si256(pb);
+        __m256i y1 = _mm256_loadu_si256(pb + 1);
+        switch (op) {
+        case BitOperation::kAnd:
+            x0 = _mm256_and_si256(x0, y0);
+            x1 = _mm256_and_si256(x1, y1);
+            break;
+        case BitOperation::kOr:
+            x0 = _mm256_or_si256(x0, y0);
+            x1 = _mm256_or_si256(x1, y1);
+            break;
+        case BitOperation::kXor:
+            x0 = _mm256_xor_si256(x0, y0);
+            x1 = _mm256_xor_si256(x1, y1);
+            break;
+        case BitOperation::kAndNot:
+            // _mm256_andnot_si256(y, x) computes ~y & x.
+            x0 = _mm256_andnot_si256(y0, x0);
+            x1 = _mm256_andnot_si256(y1, x1);
+            break;
+        }
+        _mm256_storeu_si256(pa, x0);
+        _mm256_storeu_si256(pa + 1, x1);
+    }
+    for (; i < n; ++i) {
+        a[i] = Apply<op>(a[i], b[i]);
+    }
+}
+
+/**
+ * AVX2 population count (Mula, Kurz and Lemire, 2018): the bits of every
+ * nibble are counted by a 16-entry table lookup (vpshufb), and the byte counts
+ * are summed by vpsadbw.
+ */
+CL_BITSET_TARGET("avx2")
+inline int AVX2Count(const uint64_t* a, int n) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                           1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3,
+                                           1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i total = zero;
+    int i = 0;
+    while (i + 4 <= n) {
+        // Byte counters hold at most 8 per step, so 31 steps cannot overflow.
+        __m256i local = zero;
+        for (int step = 0; step < 31 && i + 4 <= n; ++step, i += 4) {
+            __m256i v = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(a + i));
+            __m256i lo = _mm256_and_si256(v, low_mask);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+            local = _mm256_add_epi8(local, _mm256_shuffle_epi8(table, lo));
+            local = _mm256_add_epi8(local, _mm256_shuffle_epi8(table, hi));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(local, zero));
+    }
+
+    int64_t count = _mm256_extract_epi64(total, 0) +
+                    _mm256_extract_epi64(total, 1) +
+                    _mm256_extract_epi64(total, 2) +
+                    _mm256_extract_epi64(total, 3);
+    for (; i < n; ++i) {
+        count += __builtin_popcountll(a[i]);
+    }
+    return static_cast<int>(count);
+}
+
+/**
+ * GenericCount() compiled for the POPCNT instruction.
+ */
+CL_BITSET_TARGET("popcnt")
+inline int POPCNTCount(const uint64_t* a, int n) {
+    // Four independent sums hide the latency of POPCNT.
+    int64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += __builtin_popcountll(a[i]);
+        c1 += __builtin_popcountll(a[i + 1]);
+        c2 += __builtin_popcountll(a[i + 2]);
+        c3 += __builtin_popcountll(a[i + 3]);
+    }
+    for (; i < n; ++i) {
+        c0 += __builtin_popcountll(a[i]);
+    }
+    return static_cast<int>(c0 + c1 + c2 + c3);
+}
+
+#endif // CL_BITSET_X86_DISPATCH
+
+/**
+ * a[i] = a[i] op b[i] for the first n words, with the widest instruction set
+ * of the running CPU.
+ */
+template <BitOperation op>
+void BulkOperation(uint64_t* a, const uint64_t* b, int n) {
+#if defined(CL_BITSET_X86_DISPATCH)
+    if (HasAVX2()) {
+        AVX2BulkOperation<op>(a, b, n);
+        return;
+    }
+#endif
+    GenericBulkOperation<op>(a, b, n);
+}
+
+/**
+ * Count the set bits of the first n words with the fastest method of the
+ * running CPU.
+ */
+inline int Count(const uint64_t* a, int n) {
+#if defined(CL_BITSET_X86_DISPATCH)
+    if (HasAVX2()) return AVX2Count(a, n);
+    if (HasPOPCNT()) return POPCNTCount(a, n);
+#endif
+    return GenericCount(a, n);
+}
+
+} // namespace bitset_internal
 
 /**
  * Dynamic bitset.
@@ -33,16 +241,24 @@ namespace cl {
  * of the finite set is in the subset or not. As such the bitwise operations of
  * DynamicBitset, such as operator& and operator|, correspond to set operations,
  * such as intersection and union.
+ *
+ * Bits are stored in 64-bit words, bit i in word i / 64 at position i % 64,
+ * and the bits past size() in the last word are always zero. On little-endian
+ * machines this is the same memory layout as a byte bitfield (bit i in byte
+ * i / 8), so data() can be shared with occupancy bitfields directly. Count()
+ * and the bulk operators use AVX2 when the running CPU supports it.
  */
 class DynamicBitset {
-    using Block = uint32_t;
+public:
+    using Block = uint64_t;
 
     // The number of bits in one block.
-    static const int BITS_PER_BLOCK = 32;
+    static const int BITS_PER_BLOCK = 64;
 
     // The mask used to set the bits (to one).
-    static const Block MASK = 0xffffffffU;
+    static const Block MASK = ~Block(0);
 
+private:
     /**
      * Reference-like type.
      *
@@ -113,7 +329,7 @@ class DynamicBitset {
          * Assignment.
          */
         Reference& Assign(bool x) {
-            x ? *block_ |= mask_ : *block_ &= mask_;
+            x ? *block_ |= mask_ : *block_ &= ~mask_;
             return *this;
         }
 
@@ -125,10 +341,14 @@ public:
     /**
      * Construct DynamicBitset by specifing the size of bits.
      *
-     * Initialize the object with 'val'.
+     * Initialize the first block with 'value'.
      */
     explicit DynamicBitset(int size = 0, Block value = 0) {
-        Resize(size, value);
+        Resize(size);
+        if (n_blocks_ > 0) {
+            bits_[0] = value;
+            ClearTail();
+        }
     }
 
     /**
@@ -198,11 +418,7 @@ public:
      */
     DynamicBitset& Set() {
         std::fill(bits_.begin(), bits_.end(), MASK);
-
-        int t = n_bits_ % BITS_PER_BLOCK;
-        if (t != 0) {
-            bits_[n_blocks_ - 1] >>= BITS_PER_BLOCK - t;
-        }
+        ClearTail();
 
         return *this;
     }
@@ -222,12 +438,36 @@ public:
         return *this;
     }
 
+    /**
+     * Set (to one) all bits in the range [first, last).
+     */
+    DynamicBitset& SetRange(int first, int last) {
+        CHECK(0 <= first && first <= last && last <= n_bits_);
+
+        if (first == last) return *this;
+
+        int b1 = BlockIndex(first);
+        int b2 = BlockIndex(last - 1);
+        Block head = MASK << (first % BITS_PER_BLOCK);
+        Block tail = MASK >> (BITS_PER_BLOCK - 1 - (last - 1) % BITS_PER_BLOCK);
+        if (b1 == b2) {
+            bits_[b1] |= head & tail;
+        } else {
+            bits_[b1] |= head;
+            std::fill(bits_.begin() + b1 + 1, bits_.begin() + b2, MASK);
+            bits_[b2] |= tail;
+        }
+
+        return *this;
+    }
+
     /**
      * Flip all bits in the bitset.
      */
     DynamicBitset& Flip() {
         for (int i = 0; i < n_blocks_; ++i)
             bits_[i] = ~bits_[i];
+        ClearTail();
 
         return *this;
     }
@@ -267,8 +507,12 @@ public:
      * Return whether or not all bits in the bitset are set (to one).
      */
     bool All() const {
-        for (int i = 0; i < n_blocks_; ++i) {
-            if ((bits_[i] & MASK) != MASK) return false;
+        int n_full = n_bits_ / BITS_PER_BLOCK;
+        for (int i = 0; i < n_full; ++i) {
+            if (bits_[i] != MASK) return false;
+        }
+        if (n_full < n_blocks_) {
+            return bits_[n_full] == TailMask();
         }
         return true;
     }
@@ -278,13 +522,42 @@ public:
      * value of one).
      */
     int Count() const {
-        int n = 0;
+        return bitset_internal::Count(bits_.data(), n_blocks_);
+    }
 
-        for (int i = 0; i < n_blocks_; ++i) {
-            n += CountOne(bits_[i]);
+    /**
+     * Return the position of the first set bit at or after 'pos', or -1 if
+     * there is none.
+     */
+    int FindFirst(int pos = 0) const {
+        CHECK(pos >= 0);
+
+        if (pos >= n_bits_) return -1;
+
+        int i = BlockIndex(pos);
+        Block b = bits_[i] & (MASK << (pos % BITS_PER_BLOCK));
+        while (b == 0) {
+            if (++i == n_blocks_) return -1;
+            b = bits_[i];
         }
+        return i * BITS_PER_BLOCK + bits::CountTrailingZeros(b);
+    }
 
-        return n;
+    /**
+     * Call f(pos) for the position of every set bit, in increasing order.
+     *
+     * Every word is scanned with count-trailing-zeros, so the cost is
+     * proportional to the number of words plus the number of set bits.
+     */
+    template <typename Function>
+    void ForEachSetBit(Function f) const {
+        for (int i = 0; i < n_blocks_; ++i) {
+            Block b = bits_[i];
+            while (b != 0) {
+                f(i * BITS_PER_BLOCK + bits::CountTrailingZeros(b));
+                b &= b - 1;
+            }
+        }
     }
 
     /**
@@ -308,18 +581,30 @@ public:
         return n_blocks_;
     }
 
+    /**
+     * Return the underlying words. Callers writing through data() must keep
+     * the bits past size() zero.
+     */
+    const Block* data() const {
+        return bits_.data();
+    }
+    Block* data() {
+        return bits_.data();
+    }
+
     /**
      * Clear the dynamic bitset.
      */
     void clear() {
         n_bits_ = 0;
+        n_blocks_ = 0;
         bits_.clear();
     }
 
     /**
-     * Resize the bits.
+     * Resize the bits. Existing bits are kept and new bits are zero.
      */
-    void Resize(int size, Block value = 0) {
+    void Resize(int size) {
         CHECK(size >= 0);
 
         n_bits_ = size;
@@ -327,14 +612,8 @@ public:
                     static_cast<int>(n_bits_ % BITS_PER_BLOCK != 0);
         bits_.resize(n_blocks_, 0);
 
-        // Zero out all bits at pos >= num_bits, if any.
-        // Note that: num_bits == 0 implies value == 0.
-        if (n_bits_ < BITS_PER_BLOCK) {
-            Block mask = (Block(1) << n_bits_) - 1;
-            value &= mask;
-        }
-
-        if (n_bits_ > 0) bits_[0] = value;
+        // Zero out all bits at pos >= n_bits, if any.
+        ClearTail();
     }
 
     /**
@@ -357,9 +636,8 @@ public:
     DynamicBitset& operator &=(const DynamicBitset& rhs) {
         CHECK(n_bits_ == rhs.n_bits_);
 
-        for (int i = 0; i < n_blocks_; ++i) {
-            bits_[i] &= rhs.bits_[i];
-        }
+        bitset_internal::BulkOperation<bitset_internal::BitOperation::kAnd>(
+                    bits_.data(), rhs.bits_.data(), n_blocks_);
 
         return *this;
     }
@@ -370,9 +648,8 @@ public:
     DynamicBitset& operator |=(const DynamicBitset& rhs) {
         CHECK(n_bits_ == rhs.n_bits_);
 
-        for (int i = 0; i < n_blocks_; ++i) {
-            bits_[i] |= rhs.bits_[i];
-        }
+        bitset_internal::BulkOperation<bitset_internal::BitOperation::kOr>(
+                    bits_.data(), rhs.bits_.data(), n_blocks_);
 
         return *this;
     }
@@ -383,9 +660,20 @@ public:
     DynamicBitset& operator ^=(const DynamicBitset& rhs) {
         CHECK(n_bits_ == rhs.n_bits_);
 
-        for (int i = 0; i < n_blocks_; ++i) {
-            bits_[i] ^= rhs.bits_[i];
-        }
+        bitset_internal::BulkOperation<bitset_internal::BitOperation::kXor>(
+                    bits_.data(), rhs.bits_.data(), n_blocks_);
+
+        return *this;
+    }
+
+    /**
+     * This &= ~rhs, i.e., remove the elements of rhs from this set.
+     */
+    DynamicBitset& AndNot(const DynamicBitset& rhs) {
+        CHECK(n_bits_ == rhs.n_bits_);
+
+        bitset_internal::BulkOperation<bitset_internal::BitOperation::kAndNot>(
+                    bits_.data(), rhs.bits_.data(), n_blocks_);
 
         return *this;
     }
@@ -413,6 +701,7 @@ public:
             }
             bits_[0] <<= t2;
         }
+        ClearTail();
 
         return *this;
     }
@@ -447,7 +736,7 @@ public:
     bool operator ==(const DynamicBitset& rhs) const {
         if (rhs.n_bits_ != n_bits_) return false;
 
-        for (int i = 0; i < n_bits_; ++i) {
+        for (int i = 0; i < n_blocks_; ++i) {
             if (bits_[i] != rhs.bits_[i]) return false;
         }
 
@@ -533,17 +822,23 @@ private:
      * Return the bit at position pos.
      */
     int UncheckedTest(int pos) const {
-        return static_cast<int>(bits_[BlockIndex(pos)] & BitMask(pos));
+        return static_cast<int>((bits_[BlockIndex(pos)] >>
+                                 (pos % BITS_PER_BLOCK)) & 1);
+    }
+
+    /**
+     * Return the mask of the valid bits in the last block.
+     */
+    Block TailMask() const {
+        int t = n_bits_ % BITS_PER_BLOCK;
+        return t == 0 ? MASK : MASK >> (BITS_PER_BLOCK - t);
     }
 
     /**
-     * Count the number of one in the unsigned 32-bit integer.
+     * Zero out the bits past n_bits_ in the last block.
      */
-    static int CountOne(uint32_t n) {
-        n -= (n >> 1) & 0x55555555;
-        n  = (n & 0x33333333) + ((n >> 2) & 0x33333333);
-        n  = (n + (n >> 4)) & 0x0f0f0f0f;
-        return (n * 0x01010101) >> 24;
+    void ClearTail() {
+        if (n_blocks_ > 0) bits_[n_blocks_ - 1] &= TailMask();
     }
 
     int n_bits_ = 0;    // Number of bits.
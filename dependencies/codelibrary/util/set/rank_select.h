@@ -0,0 +1,185 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_SET_RANK_SELECT_H_
+#define CODELIBRARY_UTIL_SET_RANK_SELECT_H_
+
+#include <cstdint>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/bits.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/util/set/dynamic_bitset.h"
+
+namespace cl {
+
+/**
+ * Constant-time rank and fast select over a DynamicBitset.
+ *
+ * The index follows the rank9 layout (Vigna, 2008): for every superblock of
+ * 512 bits (eight words) it stores the number of set bits before the
+ * superblock, and the seven cumulative counts of its words packed as 9-bit
+ * fields into a second word. Rank is two lookups and one popcount, and the
+ * index costs 25% of the bitset.
+ *
+ * Select samples the superblock of every 512th set bit, binary searches the
+ * superblocks between two samples, then finds the word by the packed counts
+ * and the bit by bits::SelectBit().
+ *
+ * The index keeps a pointer to the words of the bitset. The bitset must
+ * outlive the index, and the index must be rebuilt by Reset() after the bitset
+ * is modified or resized.
+ *
+ * Usage:
+ *
+ *   DynamicBitset bitset(n);
+ *   ...
+ *   RankSelect rank_select(bitset);
+ *   int r = rank_select.Rank(pos);     // Number of set bits in [0, pos).
+ *   int p = rank_select.Select(k);     // Position of the k-th set bit.
+ */
+class RankSelect {
+    using Block = DynamicBitset::Block;
+
+    // The number of words in one superblock.
+    static const int WORDS_PER_SUPERBLOCK = 8;
+
+    // One select sample for every SELECT_SAMPLE_RATE set bits.
+    static const int SELECT_SAMPLE_RATE = 512;
+
+public:
+    RankSelect() = default;
+
+    explicit RankSelect(const DynamicBitset& bitset) {
+        Reset(bitset);
+    }
+
+    /**
+     * Build the index of 'bitset'.
+     */
+    void Reset(const DynamicBitset& bitset) {
+        words_ = bitset.data();
+        n_bits_ = bitset.size();
+        n_words_ = bitset.n_blocks();
+
+        int n_superblocks = (n_words_ + WORDS_PER_SUPERBLOCK - 1) /
+                            WORDS_PER_SUPERBLOCK;
+
+        // One more superblock entry, so that Rank(size()) needs no branch.
+        counts_.resize(2 * (n_superblocks + 1));
+        uint64_t total = 0;
+        for (int s = 0; s <= n_superblocks; ++s) {
+            counts_[2 * s] = total;
+
+            uint64_t packed = 0, local = 0;
+            for (int j = 0; j < WORDS_PER_SUPERBLOCK; ++j) {
+                int w = s * WORDS_PER_SUPERBLOCK + j;
+                if (j > 0) packed |= local << (9 * (j - 1));
+                if (w < n_words_) local += bits::CountOnes(words_[w]);
+            }
+            counts_[2 * s + 1] = packed;
+            total += local;
+        }
+        n_ones_ = static_cast<int>(total);
+
+        // samples_[i] is the superblock holding the (i * 512)-th set bit.
+        int n_samples = (n_ones_ + SELECT_SAMPLE_RATE - 1) / SELECT_SAMPLE_RATE;
+        samples_.resize(n_samples + 1);
+        int s = 0;
+        for (int i = 0; i < n_samples; ++i) {
+            uint64_t k = static_cast<uint64_t>(i) * SELECT_SAMPLE_RATE;
+            while (counts_[2 * (s + 1)] <= k) ++s;
+            samples_[i] = s;
+        }
+        samples_[n_samples] = n_superblocks - 1;
+    }
+
+    /**
+     * Return the number of set bits in [0, pos), 0 <= pos <= size().
+     */
+    int Rank(int pos) const {
+        CHECK(pos >= 0 && pos <= n_bits_);
+
+        int w = pos / 64;
+        int s = w / WORDS_PER_SUPERBLOCK;
+        int j = w % WORDS_PER_SUPERBLOCK;
+        uint64_t rank = counts_[2 * s];
+        if (j > 0) rank += (counts_[2 * s + 1] >> (9 * (j - 1))) & 0x1ff;
+        int t = pos % 64;
+        if (t > 0) {
+            rank += bits::CountOnes(words_[w] & (~Block(0) >> (64 - t)));
+        }
+        return static_cast<int>(rank);
+    }
+
+    /**
+     * Return the position of the k-th (0-based) set bit, 0 <= k < Count().
+     */
+    int Select(int k) const {
+        CHECK(k >= 0 && k < n_ones_);
+
+        uint64_t rank = static_cast<uint64_t>(k);
+
+        // Find the last superblock whose count before it is at most k.
+        int lo = samples_[k / SELECT_SAMPLE_RATE];
+        int hi = samples_[k / SELECT_SAMPLE_RATE + 1];
+        while (lo < hi) {
+            int mid = lo + (hi - lo + 1) / 2;
+            if (counts_[2 * mid] <= rank)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        rank -= counts_[2 * lo];
+
+        // Find the word by the packed cumulative counts.
+        uint64_t packed = counts_[2 * lo + 1];
+        int j = 0;
+        uint64_t before = 0;
+        for (; j + 1 < WORDS_PER_SUPERBLOCK; ++j) {
+            uint64_t c = (packed >> (9 * j)) & 0x1ff;
+            if (c > rank) break;
+            before = c;
+        }
+
+        int w = lo * WORDS_PER_SUPERBLOCK + j;
+        return w * 64 + bits::SelectBit(words_[w],
+                                        static_cast<int>(rank - before));
+    }
+
+    /**
+     * Return the number of set bits.
+     */
+    int Count() const {
+        return n_ones_;
+    }
+
+    /**
+     * Return the number of bits of the indexed bitset.
+     */
+    int size() const {
+        return n_bits_;
+    }
+
+private:
+    const Block* words_ = nullptr; // Words of the indexed bitset.
+    int n_bits_ = 0;               // Number of bits.
+    int n_words_ = 0;              // Number of words.
+    int n_ones_ = 0;               // Number of set bits.
+
+    // For superblock s, counts_[2s] is the number of set bits before it, and
+    // counts_[2s + 1] packs the counts before its words 1..7 in 9-bit fields.
+    Array<uint64_t> counts_;
+
+    // Superblock of every SELECT_SAMPLE_RATE-th set bit, plus the last one.
+    Array<int> samples_;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_SET_RANK_SELECT_H_
@@ -0,0 +1,380 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_STATISTICS_PARAMETER_STATISTICS_H_
+#define CODELIBRARY_UTIL_STATISTICS_PARAMETER_STATISTICS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/util/codec/linear_quantizer.h"
+
+namespace cl {
+
+/**
+ * Statistics of a block of trained parameters, e.g., a level of a hash grid
+ * encoding or a layer of a network.
+ */
+struct ParameterStats {
+    int64_t count = 0;         // Number of the nonzero values.
+    int64_t n_zero = 0;        // Number of the values below the threshold.
+    int64_t n_snapped = 0;     // Nonzero values quantized to the zero code.
+    double sum = 0.0;          // Sum of the nonzero values.
+    double sum_squared = 0.0;  // Sum of the squared nonzero values.
+    float min = 0.0f;          // Minimum of the nonzero values.
+    float max = 0.0f;          // Maximum of the nonzero values.
+
+    // Root mean squared error of all values after the n-bit quantization.
+    double quantization_error = 0.0;
+
+    // Histogram of the values that are not exactly zero, see
+    // ParameterStatsOptions.
+    Array<int64_t> histogram;
+
+    double mean() const {
+        return count == 0 ? 0.0 : sum / count;
+    }
+
+    double variance() const {
+        if (count == 0) return 0.0;
+        double m = mean();
+        return std::max(0.0, sum_squared / count - m * m);
+    }
+
+    double sigma() const {
+        return std::sqrt(variance());
+    }
+
+    /**
+     * Return the fraction of the zero values, i.e., the sparsity.
+     */
+    double zero_fraction() const {
+        return count + n_zero == 0 ? 0.0 : double(n_zero) / (count + n_zero);
+    }
+
+    /**
+     * Return the fraction of the nonzero values that become zero after the
+     * quantization.
+     */
+    double snapped_fraction() const {
+        return count == 0 ? 0.0 : double(n_snapped) / count;
+    }
+};
+
+struct ParameterStatsOptions {
+    // Values with |v| below it are counted as zeros.
+    float zero_threshold = 1e-5f;
+
+    // The histogram has 'n_bins' (odd) bins of the values in
+    // [-histogram_range, histogram_range]; the center bin holds zero.
+    int n_bins = 257;
+    float histogram_range = 1.0f;
+
+    // Bits of the LinearQuantizer fitted to the range of each block, used to
+    // estimate the quantization error. Zero disables the estimation.
+    int quantization_bits = 8;
+};
+
+namespace parameter_stats_internal {
+
+// Values per chunk, independent of the number of threads so that the sums are
+// reproducible.
+const int64_t CHUNK_SIZE = 65536;
+
+} // namespace parameter_stats_internal
+
+/**
+ * Compute the statistics of the n parameters in two parallel passes: the
+ * first one finds the moments and the range, and the second one bins the
+ * values and measures the error of the quantizer fitted to the range.
+ */
+inline void ComputeParameterStats(const float* data, int64_t n,
+                                  const ParameterStatsOptions& options,
+                                  ParameterStats* stats) {
+    using parameter_stats_internal::CHUNK_SIZE;
+
+    CHECK(n >= 0);
+    CHECK(options.n_bins > 0 && options.n_bins % 2 == 1);
+    CHECK(options.histogram_range > 0.0f);
+    CHECK(options.quantization_bits >= 0 && options.quantization_bits <= 8);
+    CHECK(stats);
+
+    *stats = ParameterStats();
+    stats->histogram.resize(options.n_bins, 0);
+    if (n == 0) return;
+
+    const int n_chunks = static_cast<int>((n + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    const float threshold = options.zero_threshold;
+    Array<ParameterStats> partial(n_chunks);
+
+    // The loops are branchless, since the zeros are scattered randomly in the
+    // hash tables.
+    #pragma omp parallel for if (n_chunks > 1)
+    for (int c = 0; c < n_chunks; ++c) {
+        const float* v = data + c * CHUNK_SIZE;
+        int64_t size = std::min(CHUNK_SIZE, n - c * CHUNK_SIZE);
+        int64_t count = 0;
+        double sum = 0.0, sum_squared = 0.0;
+        float lo = INFINITY, hi = -INFINITY;
+        for (int64_t i = 0; i < size; ++i) {
+            bool nonzero = std::fabs(v[i]) >= threshold;
+            double x = nonzero ? v[i] : 0.0;
+            count += nonzero;
+            sum += x;
+            sum_squared += x * x;
+            lo = std::min(lo, nonzero ? v[i] : INFINITY);
+            hi = std::max(hi, nonzero ? v[i] : -INFINITY);
+        }
+
+        ParameterStats& s = partial[c];
+        s.count = count;
+        s.n_zero = size - count;
+        s.sum = sum;
+        s.sum_squared = sum_squared;
+        s.min = lo;
+        s.max = hi;
+    }
+
+    float lo = INFINITY, hi = -INFINITY;
+    for (const ParameterStats& s : partial) {
+        stats->count += s.count;
+        stats->n_zero += s.n_zero;
+        stats->sum += s.sum;
+        stats->sum_squared += s.sum_squared;
+        lo = std::min(lo, s.min);
+        hi = std::max(hi, s.max);
+    }
+    if (stats->count > 0) {
+        stats->min = lo;
+        stats->max = hi;
+    }
+
+    // The codes of the LinearQuantizer fitted to the range, computed inline
+    // by a multiplication since the division and rounding of Quantize()
+    // would dominate the second pass.
+    const int bits = options.quantization_bits;
+    LinearQuantizer quantizer(bits == 0 ? 8 : bits);
+    quantizer.Reset(stats->min, stats->max);
+    const float q_offset = quantizer.offset();
+    const float q_scale = quantizer.scale();
+    const float q_inverse_scale = q_scale == 0.0f ? 0.0f : 1.0f / q_scale;
+    const int max_code = quantizer.max_code();
+    const int zero_code = quantizer.zero_code();
+
+    // Bin of v is the integer part of v * scale + h + 0.5, if it is in
+    // [0, n_bins).
+    const int n_bins = options.n_bins;
+    const float scale = (n_bins / 2) / options.histogram_range;
+    const float bias = n_bins / 2 + 0.5f;
+    Array<int64_t> histograms(n_chunks * n_bins, 0);
+
+    #pragma omp parallel for if (n_chunks > 1)
+    for (int c = 0; c < n_chunks; ++c) {
+        const float* v = data + c * CHUNK_SIZE;
+        int64_t size = std::min(CHUNK_SIZE, n - c * CHUNK_SIZE);
+        int64_t* histogram = histograms.data() + int64_t(c) * n_bins;
+        for (int64_t i = 0; i < size; ++i) {
+            float x = v[i] * scale + bias;
+            if (v[i] != 0.0f && x >= 0.0f && x < n_bins) {
+                ++histogram[static_cast<int>(x)];
+            }
+        }
+        if (bits == 0) continue;
+
+        int64_t n_snapped = 0;
+        double squared_error = 0.0;
+        for (int64_t i = 0; i < size; ++i) {
+            float x = (v[i] - q_offset) * q_inverse_scale + 0.5f;
+            int code = std::min(static_cast<int>(std::max(x, 0.0f)),
+                                max_code);
+            double error = double(q_offset + q_scale * code) - v[i];
+            squared_error += error * error;
+            n_snapped += code == zero_code && std::fabs(v[i]) >= threshold;
+        }
+        partial[c].n_snapped = n_snapped;
+        partial[c].quantization_error = squared_error;
+    }
+
+    double squared_error = 0.0;
+    for (int c = 0; c < n_chunks; ++c) {
+        stats->n_snapped += partial[c].n_snapped;
+        squared_error += partial[c].quantization_error;
+        const int64_t* histogram = histograms.data() + int64_t(c) * n_bins;
+        for (int i = 0; i < n_bins; ++i) {
+            stats->histogram[i] += histogram[i];
+        }
+    }
+    stats->quantization_error = std::sqrt(squared_error / n);
+}
+
+/**
+ * One row of the time series of ParameterStats, without the histogram.
+ */
+struct ParameterStatsRecord {
+    int64_t step = 0;
+    int32_t block = 0;
+    int32_t reserved = 0;
+    int64_t count = 0;
+    int64_t n_zero = 0;
+    int64_t n_snapped = 0;
+    float mean = 0.0f;
+    float sigma = 0.0f;
+    float min = 0.0f;
+    float max = 0.0f;
+    float quantization_error = 0.0f;
+    float padding = 0.0f;
+
+    ParameterStatsRecord() = default;
+
+    ParameterStatsRecord(int64_t step, int block, const ParameterStats& s)
+        : step(step),
+          block(block),
+          count(s.count),
+          n_zero(s.n_zero),
+          n_snapped(s.n_snapped),
+          mean(static_cast<float>(s.mean())),
+          sigma(static_cast<float>(s.sigma())),
+          min(s.min),
+          max(s.max),
+          quantization_error(static_cast<float>(s.quantization_error)) {}
+};
+
+static_assert(sizeof(ParameterStatsRecord) == 64, "");
+
+/**
+ * Append the statistics of the parameter blocks to a time series file.
+ *
+ * The CSV format has a header line and one line per record. The binary format
+ * is the 16-byte header {"CLPS", version, record size, 0} followed by the
+ * 64-byte records in native byte order, see ReadParameterStatsSeries().
+ */
+class ParameterStatsWriter {
+public:
+    enum class Format {
+        kCSV,
+        kBinary
+    };
+
+    static const uint32_t VERSION = 1;
+
+    ParameterStatsWriter() = default;
+
+    ParameterStatsWriter(const ParameterStatsWriter&) = delete;
+
+    ParameterStatsWriter& operator=(const ParameterStatsWriter&) = delete;
+
+    ~ParameterStatsWriter() {
+        Close();
+    }
+
+    /**
+     * Create the file, and write the header.
+     */
+    bool Open(const std::string& filename, Format format) {
+        Close();
+
+        file_ = std::fopen(filename.c_str(), "wb");
+        if (!file_) {
+            LOG(INFO) << "Cannot open file '" << filename << "' for writing.";
+            return false;
+        }
+
+        format_ = format;
+        if (format == Format::kCSV) {
+            std::fprintf(file_, "step,block,count,n_zero,n_snapped,mean,sigma,"
+                                "min,max,quantization_error\n");
+        } else {
+            uint32_t header[4] = { 0, VERSION, sizeof(ParameterStatsRecord),
+                                   0 };
+            std::memcpy(header, "CLPS", 4);
+            std::fwrite(header, sizeof(header), 1, file_);
+        }
+        return true;
+    }
+
+    void Write(const ParameterStatsRecord& r) {
+        CHECK(file_);
+
+        if (format_ == Format::kCSV) {
+            std::fprintf(file_, "%lld,%d,%lld,%lld,%lld,%.9g,%.9g,%.9g,%.9g,"
+                                "%.9g\n",
+                         static_cast<long long>(r.step), r.block,
+                         static_cast<long long>(r.count),
+                         static_cast<long long>(r.n_zero),
+                         static_cast<long long>(r.n_snapped), r.mean, r.sigma,
+                         r.min, r.max, r.quantization_error);
+        } else {
+            std::fwrite(&r, sizeof(r), 1, file_);
+        }
+    }
+
+    void Write(int64_t step, int block, const ParameterStats& stats) {
+        Write(ParameterStatsRecord(step, block, stats));
+    }
+
+    void Flush() {
+        if (file_) std::fflush(file_);
+    }
+
+    void Close() {
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    bool is_open() const {
+        return file_ != nullptr;
+    }
+
+private:
+    FILE* file_ = nullptr;
+    Format format_ = Format::kCSV;
+};
+
+/**
+ * Read the records of a binary file written by ParameterStatsWriter.
+ */
+inline bool ReadParameterStatsSeries(const std::string& filename,
+                                     Array<ParameterStatsRecord>* records) {
+    CHECK(records);
+
+    records->clear();
+    FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        LOG(INFO) << "Cannot open file '" << filename << "' for reading.";
+        return false;
+    }
+
+    uint32_t header[4];
+    if (std::fread(header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header, "CLPS", 4) != 0 ||
+        header[1] != ParameterStatsWriter::VERSION ||
+        header[2] != sizeof(ParameterStatsRecord)) {
+        LOG(INFO) << "Invalid parameter statistics file '" << filename << "'.";
+        std::fclose(file);
+        return false;
+    }
+
+    ParameterStatsRecord r;
+    while (std::fread(&r, sizeof(r), 1, file) == 1) {
+        records->push_back(r);
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_STATISTICS_PARAMETER_STATISTICS_H_
@@ -0,0 +1,421 @@
+//
+// Copyright 2023 Yangbin Lin. All Rights Reserved.
+//
+// Author: yblin@jmu.edu.cn (Yangbin Lin)
+//
+// This file is part of the Code Library.
+//
+
+#ifndef CODELIBRARY_UTIL_TREE_AABB_TREE_H_
+#define CODELIBRARY_UTIL_TREE_AABB_TREE_H_
+
+#include <algorithm>
+
+#include "codelibrary/base/array.h"
+#include "codelibrary/base/log.h"
+#include "codelibrary/geometry/box_3d.h"
+
+namespace cl {
+
+/**
+ * Dynamic AABB tree (bounding volume hierarchy of axis-aligned boxes).
+ *
+ * Each object is stored in a leaf with a value (e.g., a pointer to the
+ * object), and is identified by the leaf id returned by Insert(). The leaves
+ * store fat boxes, i.e., the boxes of the objects enlarged by a margin, so
+ * that the objects can move a little without changing the tree.
+ *
+ * The sibling of a new leaf is chosen by the surface area heuristic, and the
+ * tree is kept balanced by AVL rotations, as in Box2D's b2DynamicTree.
+ *
+ * Update() handles moving objects:
+ *  1) Nothing changes if the object is still inside its fat box.
+ *  2) For a small motion, the leaf is refit incrementally: the fat box is
+ *     moved and the ancestors are enlarged until one already contains it.
+ *  3) Otherwise, the leaf is removed and inserted again.
+ * The internal boxes may become loose after many refits; Refit() tightens
+ * all of them in O(N).
+ */
+template <typename T, typename Value>
+class AABBTree {
+public:
+    using Box = Box3D<T>;
+
+    /**
+     * Node of the tree. A leaf has no children (children[0] == -1).
+     */
+    struct Node {
+        Box box;         // Fat box for leaves, union of children otherwise.
+        Box object_box;  // The box of the object (leaves only).
+        int parent = -1;
+        int children[2] = { -1, -1 };
+        int height = -1; // 0 for leaves, -1 for free nodes.
+        Value value = Value();
+
+        bool is_leaf() const {
+            return children[0] == -1;
+        }
+    };
+
+    /**
+     * Construct the tree. 'margin' is the enlargement of the fat boxes.
+     */
+    explicit AABBTree(T margin = T(0))
+        : margin_(margin) {
+        CHECK(margin >= 0);
+    }
+
+    /**
+     * Insert an object, return its leaf id.
+     */
+    int Insert(const Box& box, const Value& value) {
+        CHECK(!box.empty());
+
+        int leaf = AllocateNode();
+        Node& node = nodes_[leaf];
+        node.box = Enlarge(box);
+        node.object_box = box;
+        node.height = 0;
+        node.value = value;
+        InsertLeaf(leaf);
+        ++size_;
+        return leaf;
+    }
+
+    /**
+     * Erase the object of the given leaf id.
+     */
+    void Erase(int id) {
+        CHECK(is_valid_leaf(id));
+
+        RemoveLeaf(id);
+        FreeNode(id);
+        --size_;
+    }
+
+    /**
+     * Update the box of the object. Return true if the tree is changed.
+     */
+    bool Update(int id, const Box& box) {
+        CHECK(is_valid_leaf(id));
+        CHECK(!box.empty());
+
+        Node& node = nodes_[id];
+        node.object_box = box;
+        if (Contains(node.box, box)) return false;
+
+        Box fat = Enlarge(box);
+        if (Intersect(fat, node.box)) {
+            // Incremental refit.
+            node.box = fat;
+            for (int i = node.parent; i != -1; i = nodes_[i].parent) {
+                if (Contains(nodes_[i].box, fat)) break;
+                nodes_[i].box.Join(fat);
+            }
+        } else {
+            RemoveLeaf(id);
+            node.box = fat;
+            InsertLeaf(id);
+        }
+        return true;
+    }
+
+    /**
+     * Recompute the boxes of all internal nodes, in O(N).
+     */
+    void Refit() {
+        if (root_ == -1) return;
+
+        // Children are visited after the parents in the preorder, so the
+        // reverse preorder is a valid bottom-up order.
+        Array<int> order, stack = { root_ };
+        while (!stack.empty()) {
+            int i = stack.back();
+            stack.pop_back();
+            if (nodes_[i].is_leaf()) continue;
+
+            order.push_back(i);
+            stack.push_back(nodes_[i].children[0]);
+            stack.push_back(nodes_[i].children[1]);
+        }
+        for (int k = order.size() - 1; k >= 0; --k) {
+            Refresh(order[k]);
+        }
+    }
+
+    /**
+     * Get the values of the objects whose boxes intersect 'box'.
+     */
+    void Query(const Box& box, Array<Value>* values) const {
+        CHECK(values);
+
+        values->clear();
+        if (root_ == -1) return;
+
+        Array<int> stack = { root_ };
+        while (!stack.empty()) {
+            const Node& node = nodes_[stack.back()];
+            stack.pop_back();
+            if (!Intersect(node.box, box)) continue;
+
+            if (node.is_leaf()) {
+                if (Intersect(node.object_box, box)) {
+                    values->push_back(node.value);
+                }
+            } else {
+                stack.push_back(node.children[0]);
+                stack.push_back(node.children[1]);
+            }
+        }
+    }
+
+    void clear() {
+        nodes_.clear();
+        free_nodes_.clear();
+        root_ = -1;
+        size_ = 0;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * Return the number of objects.
+     */
+    int size() const {
+        return size_;
+    }
+
+    /**
+     * Return the number of allocated nodes; node ids are less than it.
+     */
+    int capacity() const {
+        return nodes_.size();
+    }
+
+    /**
+     * Return the root id, or -1 if the tree is empty.
+     */
+    int root() const {
+        return root_;
+    }
+
+    int height() const {
+        return root_ == -1 ? 0 : nodes_[root_].height;
+    }
+
+    const Node& node(int id) const {
+        return nodes_[id];
+    }
+
+    const Value& value(int id) const {
+        CHECK(is_valid_leaf(id));
+        return nodes_[id].value;
+    }
+
+    const Box& box(int id) const {
+        CHECK(is_valid_leaf(id));
+        return nodes_[id].object_box;
+    }
+
+    T margin() const {
+        return margin_;
+    }
+
+    /**
+     * Return the surface area of the box, used by the insertion cost.
+     */
+    static T Area(const Box& box) {
+        T x = box.x_length(), y = box.y_length(), z = box.z_length();
+        return 2 * (x * y + y * z + z * x);
+    }
+
+private:
+    bool is_valid_leaf(int id) const {
+        return id >= 0 && id < nodes_.size() && nodes_[id].height == 0;
+    }
+
+    Box Enlarge(const Box& box) const {
+        return Box(box.x_min() - margin_, box.x_max() + margin_,
+                   box.y_min() - margin_, box.y_max() + margin_,
+                   box.z_min() - margin_, box.z_max() + margin_);
+    }
+
+    static Box Union(const Box& a, const Box& b) {
+        Box box = a;
+        box.Join(b);
+        return box;
+    }
+
+    static bool Contains(const Box& a, const Box& b) {
+        return a.x_min() <= b.x_min() && b.x_max() <= a.x_max() &&
+               a.y_min() <= b.y_min() && b.y_max() <= a.y_max() &&
+               a.z_min() <= b.z_min() && b.z_max() <= a.z_max();
+    }
+
+    static bool Intersect(const Box& a, const Box& b) {
+        return a.x_min() <= b.x_max() && b.x_min() <= a.x_max() &&
+               a.y_min() <= b.y_max() && b.y_min() <= a.y_max() &&
+               a.z_min() <= b.z_max() && b.z_min() <= a.z_max();
+    }
+
+    int AllocateNode() {
+        if (free_nodes_.empty()) {
+            nodes_.emplace_back();
+            return nodes_.size() - 1;
+        }
+        int id = free_nodes_.back();
+        free_nodes_.pop_back();
+        nodes_[id] = Node();
+        return id;
+    }
+
+    void FreeNode(int id) {
+        nodes_[id].height = -1;
+        free_nodes_.push_back(id);
+    }
+
+    /**
+     * Recompute the box and the height of an internal node from its children.
+     */
+    void Refresh(int id) {
+        Node& node = nodes_[id];
+        const Node& a = nodes_[node.children[0]];
+        const Node& b = nodes_[node.children[1]];
+        node.box = Union(a.box, b.box);
+        node.height = 1 + std::max(a.height, b.height);
+    }
+
+    /**
+     * Replace the child 'from' of 'parent' (or the root) by 'to'.
+     */
+    void ReplaceChild(int parent, int from, int to) {
+        if (parent == -1) {
+            root_ = to;
+        } else {
+            int* children = nodes_[parent].children;
+            children[children[0] == from ? 0 : 1] = to;
+        }
+        nodes_[to].parent = parent;
+    }
+
+    void InsertLeaf(int leaf) {
+        if (root_ == -1) {
+            root_ = leaf;
+            nodes_[leaf].parent = -1;
+            return;
+        }
+
+        // Find the best sibling by the surface area heuristic: the cost of a
+        // subtree is the area of the new parent plus the increased areas of
+        // the ancestors.
+        const Box& box = nodes_[leaf].box;
+        int index = root_;
+        while (!nodes_[index].is_leaf()) {
+            const Node& node = nodes_[index];
+            T area = Area(node.box);
+            T combined_area = Area(Union(node.box, box));
+
+            // Cost of creating a new parent for this node and the new leaf.
+            T cost = 2 * combined_area;
+
+            // Minimum cost of pushing the leaf further down.
+            T inheritance = 2 * (combined_area - area);
+
+            T costs[2];
+            for (int k = 0; k < 2; ++k) {
+                const Node& child = nodes_[node.children[k]];
+                T new_area = Area(Union(child.box, box));
+                costs[k] = child.is_leaf() ? new_area + inheritance
+                                           : new_area - Area(child.box) +
+                                             inheritance;
+            }
+
+            if (cost < costs[0] && cost < costs[1]) break;
+            index = node.children[costs[0] < costs[1] ? 0 : 1];
+        }
+
+        int sibling = index;
+        int old_parent = nodes_[sibling].parent;
+        int parent = AllocateNode();
+        nodes_[parent].children[0] = sibling;
+        nodes_[parent].children[1] = leaf;
+        ReplaceChild(old_parent, sibling, parent);
+        nodes_[sibling].parent = parent;
+        nodes_[leaf].parent = parent;
+
+        for (int i = parent; i != -1; i = nodes_[i].parent) {
+            i = Balance(i);
+            Refresh(i);
+        }
+    }
+
+    void RemoveLeaf(int leaf) {
+        if (leaf == root_) {
+            root_ = -1;
+            return;
+        }
+
+        int parent = nodes_[leaf].parent;
+        const int* children = nodes_[parent].children;
+        int sibling = children[0] == leaf ? children[1] : children[0];
+        int grand_parent = nodes_[parent].parent;
+        ReplaceChild(grand_parent, parent, sibling);
+        FreeNode(parent);
+
+        for (int i = grand_parent; i != -1; i = nodes_[i].parent) {
+            i = Balance(i);
+            Refresh(i);
+        }
+    }
+
+    /**
+     * If the subtree of 'a' is imbalanced, rotate its higher child up.
+     * Return the new root of the subtree.
+     */
+    int Balance(int a) {
+        Node& node = nodes_[a];
+        if (node.is_leaf() || node.height < 2) return a;
+
+        int b = node.children[0], c = node.children[1];
+        int balance = nodes_[c].height - nodes_[b].height;
+        if (balance > 1) return Rotate(a, 1);
+        if (balance < -1) return Rotate(a, 0);
+        return a;
+    }
+
+    /**
+     * Rotate the s-th child 'c' of 'a' up. The higher child of 'c' stays
+     * under 'c', and the other one replaces 'c' under 'a'.
+     */
+    int Rotate(int a, int s) {
+        int c = nodes_[a].children[s];
+        int f = nodes_[c].children[0], g = nodes_[c].children[1];
+        int high = nodes_[f].height > nodes_[g].height ? f : g;
+        int low = high == f ? g : f;
+
+        ReplaceChild(nodes_[a].parent, a, c);
+        nodes_[c].children[0] = a;
+        nodes_[c].children[1] = high;
+        nodes_[a].parent = c;
+        nodes_[a].children[s] = low;
+        nodes_[low].parent = a;
+
+        Refresh(a);
+        Refresh(c);
+        return c;
+    }
+
+    // Enlargement of the fat boxes.
+    T margin_;
+
+    Array<Node> nodes_;
+    Array<int> free_nodes_;
+    int root_ = -1;
+    int size_ = 0;
+};
+
+} // namespace cl
+
+#endif // CODELIBRARY_UTIL_TREE_AABB_TREE_H_
@@ -9,6 +9,7 @@
 #ifndef CODELIBRARY_WORLD_FRUSTUM_CULLER_H_
 #define CODELIBRARY_WORLD_FRUSTUM_CULLER_H_
 
+#include "codelibrary/geometry/frustum_3d.h"
 #include "codelibrary/opengl/camera.h"
 #include "codelibrary/world/node.h"
 
@@ -17,19 +18,12 @@ namespace world {
 
 /**
  * Frustum culling.
+ *
+ * Cull(node) tests the transformed bounding box of a single node. For a large
+ * number of nodes, use Scene::FrustumCull(), which culls the nodes
+ * hierarchically by a dynamic AABB tree (see geometry::FrustumCuller3D).
  */
 class FrustumCuller {
-    struct Plane {
-        double a, b, c, d;
-    };
-
-    /**
-     * Camera frustum for frustum culling.
-     */
-    struct Frustum {
-        Plane planes[6];
-    };
-
 public:
     /**
      * Get camera's frustum.
@@ -37,22 +31,7 @@ public:
     FrustumCuller(const gl::Camera& camera) {
         Array<FPoint3D> vertices;
         camera.GetFrustum(&vertices);
-        Array<FPlane3D> frustum_planes(6);
-        frustum_planes[0] = FPlane3D(vertices[0], vertices[2], vertices[1]);
-        frustum_planes[1] = FPlane3D(vertices[4], vertices[5], vertices[6]);
-        frustum_planes[2] = FPlane3D(vertices[1], vertices[2], vertices[5]);
-        frustum_planes[3] = FPlane3D(vertices[0], vertices[4], vertices[3]);
-        frustum_planes[4] = FPlane3D(vertices[0], vertices[1], vertices[5]);
-        frustum_planes[5] = FPlane3D(vertices[3], vertices[6], vertices[2]);
-        for (int i = 0; i < 6; ++i) {
-            const FPlane3D& plane = frustum_planes[i];
-            frustum_.planes[i].a = plane.normal().x;
-            frustum_.planes[i].b = plane.normal().y;
-            frustum_.planes[i].c = plane.normal().z;
-            frustum_.planes[i].d = -frustum_.planes[i].a * plane.point().x -
-                                    frustum_.planes[i].b * plane.point().y -
-                                    frustum_.planes[i].c * plane.point().z;
-        }
+        frustum_ = FFrustum3D(vertices);
     }
 
     /**
@@ -73,12 +52,15 @@ public:
             {box.x_max(), box.y_max(), box.z_min()},
             {box.x_max(), box.y_max(), box.z_max()}
         };
+        for (FPoint3D& v : vertices) {
+            v = node->global_transform()(v);
+        }
 
-        for (const Plane& p : frustum_.planes) {
+        for (int i = 0; i < 6; ++i) {
+            const float* p = frustum_.plane(i);
             bool is_forward = false;
-            for (FPoint3D v : vertices) {
-                v = node->global_transform()(v);
-                if (p.a * v.x + p.b * v.y + p.c * v.z + p.d > 0) {
+            for (const FPoint3D& v : vertices) {
+                if (p[0] * v.x + p[1] * v.y + p[2] * v.z + p[3] > 0) {
                     is_forward = true;
                     break;
                 }
@@ -101,8 +83,12 @@ public:
         nodes->resize(n);
     }
 
+    const FFrustum3D& frustum() const {
+        return frustum_;
+    }
+
 private:
-    Frustum frustum_;
+    FFrustum3D frustum_;
 };
 
 } // namespace world
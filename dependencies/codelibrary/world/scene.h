@@ -9,7 +9,13 @@
 #ifndef CODELIBRARY_WORLD_SCENE_H_
 #define CODELIBRARY_WORLD_SCENE_H_
 
+#include <cfloat>
+#include <unordered_map>
+#include <utility>
+
+#include "codelibrary/geometry/util/frustum_culler_3d.h"
 #include "codelibrary/opengl/camera.h"
+#include "codelibrary/util/tree/aabb_tree.h"
 #include "codelibrary/world/frustum_culler.h"
 #include "codelibrary/world/light/light_set.h"
 #include "codelibrary/world/node.h"
@@ -21,8 +27,13 @@ namespace world {
  * 3D world scene.
  *
  * It does not hold any node data but just organize them.
+ *
+ * The world bounding boxes of the cullable nodes are kept in a dynamic AABB
+ * tree, which is updated incrementally by Update() and used by FrustumCull().
  */
 class Scene : public Node {
+    using BVH = AABBTree<float, Node*>;
+
 public:
     /**
      * Construct the scene.
@@ -80,14 +91,39 @@ public:
         for (auto node : nodes_) {
             lights_.Add(node);
         }
+
+        UpdateBVH();
     }
 
     /**
      * Cull the current nodes.
      */
     void FrustumCull(const gl::Camera& camera) {
+        FrustumCull(camera, BVHCuller::NoOcclusion());
+    }
+
+    /**
+     * Cull the current nodes, with an occlusion hook. 'occluded(box)' returns
+     * true if the world box is fully occluded, then all nodes inside the box
+     * are culled.
+     */
+    template <typename Occlusion>
+    void FrustumCull(const gl::Camera& camera, const Occlusion& occluded) {
         FrustumCuller culler(camera);
-        culler.Cull(&nodes_);
+
+        // The non-cullable nodes are always kept.
+        int n = 0;
+        for (Node* node : nodes_) {
+            if (bvh_ids_.find(node) == bvh_ids_.end()) nodes_[n++] = node;
+        }
+        nodes_.resize(n);
+
+        // The BVH tests the world boxes, then the transformed boxes are
+        // tested as before.
+        bvh_culler_.Cull(bvh_, culler.frustum(), occluded, &visible_nodes_);
+        for (Node* node : visible_nodes_) {
+            if (!culler.Cull(node)) nodes_.push_back(node);
+        }
     }
 
     /**
@@ -144,6 +180,59 @@ public:
     }
 
 private:
+    using BVHCuller = geometry::FrustumCuller3D<float, Node*>;
+
+    /**
+     * Return the world bounding box of the node, or an empty box if the node
+     * has no bounding box.
+     */
+    static FBox3D WorldBoundingBox(const Node* node) {
+        FBox3D box = node->GetBoundingBox();
+        if (box.empty()) return box;
+
+        FBox3D world_box;
+        for (int i = 0; i < 8; ++i) {
+            FPoint3D p(i & 1 ? box.x_max() : box.x_min(),
+                       i & 2 ? box.y_max() : box.y_min(),
+                       i & 4 ? box.z_max() : box.z_min());
+            p = node->global_transform()(p);
+            world_box.Join(FBox3D(p.x, p.x, p.y, p.y, p.z, p.z));
+        }
+        return world_box;
+    }
+
+    /**
+     * Synchronize the BVH with the current nodes. Nodes that are not moved
+     * cost O(1), moved nodes are refit or reinserted.
+     */
+    void UpdateBVH() {
+        ++frame_;
+        for (Node* node : nodes_) {
+            if (!node->is_cullable()) continue;
+
+            FBox3D box = WorldBoundingBox(node);
+            if (box.empty() || !(box.x_length() < FLT_MAX)) continue;
+
+            auto iter = bvh_ids_.find(node);
+            if (iter == bvh_ids_.end()) {
+                bvh_ids_[node] = std::make_pair(bvh_.Insert(box, node), frame_);
+            } else {
+                bvh_.Update(iter->second.first, box);
+                iter->second.second = frame_;
+            }
+        }
+
+        // Erase the nodes that are removed or hidden.
+        for (auto iter = bvh_ids_.begin(); iter != bvh_ids_.end();) {
+            if (iter->second.second != frame_) {
+                bvh_.Erase(iter->second.first);
+                iter = bvh_ids_.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
     /**
      * Recursively update all nodes.
      */
@@ -168,6 +257,16 @@ private:
 
     // Show shadow or not.
     bool show_shadow_ = false;
+
+    // Dynamic AABB tree of the world boxes of the cullable nodes.
+    BVH bvh_;
+
+    // The leaf id in 'bvh_' and the last updated frame of each node.
+    std::unordered_map<Node*, std::pair<int, int>> bvh_ids_;
+
+    BVHCuller bvh_culler_;
+    Array<Node*> visible_nodes_;
+    int frame_ = 0;
 };
 
 } // namespace world
@@ -17,9 +17,12 @@
 #include <neural-graphics-primitives/common.h>
 #include <neural-graphics-primitives/common_device.cuh>
 #include <neural-graphics-primitives/json_binding.h>
+#include <neural-graphics-primitives/thread_pool.h>
 
 #include <json/json.hpp>
 
+#include <cstring>
+
 NGP_NAMESPACE_BEGIN
 
 class VarAdamOptimizer {
@@ -308,4 +311,296 @@ inline void from_json(const nlohmann::json& j, RotationAdamOptimizer& opt) {
 	opt.from_json(j);
 }
 
+// Steps many equally-sized Adam optimizers (e.g. one per training image) in a
+// single pass. The state of all optimizers is stored as a structure of arrays,
+// such that the moment updates are flat loops over `size() * dims()` floats.
+// Every optimizer keeps its own iteration counter and learning rate. Results
+// are bitwise identical to `AdamOptimizer<T>` / `VarAdamOptimizer`, or to
+// `RotationAdamOptimizer` when `rotation` is set (which requires dims == 3).
+class BatchedAdamOptimizer {
+public:
+	BatchedAdamOptimizer(size_t size = 0, uint32_t dims = 1, bool rotation = false, float learning_rate = 1e-3, float epsilon = 1e-08f, float beta1 = 0.9f, float beta2 = 0.99f) : m_dims{dims}, m_rotation{rotation} {
+		if (rotation && dims != 3) {
+			throw std::runtime_error{"BatchedAdamOptimizer: rotations require 3 dimensions."};
+		}
+
+		m_hparams = { learning_rate, epsilon, beta1, beta2 };
+		resize(size);
+	}
+
+	// Grows or shrinks the batch. Existing optimizers keep their state, new
+	// ones start from zero with the default learning rate.
+	void resize(size_t size) {
+		m_iter.resize(size, 0);
+		m_learning_rate.resize(size, m_hparams.learning_rate);
+		m_first_moment.resize(size * m_dims, 0.0f);
+		m_second_moment.resize(size * m_dims, 0.0f);
+		m_variable.resize(size * m_dims, 0.0f);
+		m_step_size.resize(size * m_dims, 0.0f);
+	}
+
+	size_t size() const {
+		return m_iter.size();
+	}
+
+	uint32_t dims() const {
+		return m_dims;
+	}
+
+	// Performs one step of the optimizers [begin, end). `gradient` holds
+	// `(end - begin) * dims()` floats, one contiguous row per optimizer. The
+	// effective gradient is `gradient * gradient_scale + variable * l2_reg`.
+	void step(const float* gradient, size_t begin, size_t end, float gradient_scale = 1.0f, float l2_reg = 0.0f, ThreadPool* pool = nullptr) {
+		static constexpr size_t CHUNK_SIZE = 4096;
+
+		end = std::min(end, size());
+		if (begin >= end) {
+			return;
+		}
+
+		size_t n_chunks = (end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		auto step_chunk = [&](size_t chunk) {
+			size_t chunk_begin = begin + chunk * CHUNK_SIZE;
+			size_t chunk_end = std::min(end, chunk_begin + CHUNK_SIZE);
+			step_range(gradient + (chunk_begin - begin) * m_dims, chunk_begin, chunk_end, gradient_scale, l2_reg);
+		};
+
+		if (pool && n_chunks > 1) {
+			pool->parallel_for<size_t>(0, n_chunks, step_chunk);
+		} else {
+			for (size_t chunk = 0; chunk < n_chunks; ++chunk) {
+				step_chunk(chunk);
+			}
+		}
+	}
+
+	uint32_t step(size_t i) const {
+		return m_iter[i];
+	}
+
+	void set_learning_rate(float lr) {
+		std::fill(m_learning_rate.begin(), m_learning_rate.end(), lr);
+	}
+
+	void set_learning_rate(size_t i, float lr) {
+		m_learning_rate[i] = lr;
+	}
+
+	float* variable(size_t i) {
+		return m_variable.data() + i * m_dims;
+	}
+
+	const float* variable(size_t i) const {
+		return m_variable.data() + i * m_dims;
+	}
+
+	// Views the variable of optimizer i as a glm vector of matching size.
+	template <typename T>
+	T& variable_as(size_t i) {
+		static_assert(std::is_trivially_copyable<T>::value, "Variable type must be trivially copyable.");
+		return *reinterpret_cast<T*>(variable(i));
+	}
+
+	template <typename T>
+	const T& variable_as(size_t i) const {
+		static_assert(std::is_trivially_copyable<T>::value, "Variable type must be trivially copyable.");
+		return *reinterpret_cast<const T*>(variable(i));
+	}
+
+	// All variables, laid out as `size()` rows of `dims()` floats.
+	const std::vector<float>& variables() const {
+		return m_variable;
+	}
+
+	const float* first_moment(size_t i) const {
+		return m_first_moment.data() + i * m_dims;
+	}
+
+	const float* second_moment(size_t i) const {
+		return m_second_moment.data() + i * m_dims;
+	}
+
+	void reset_state(size_t i) {
+		m_iter[i] = 0;
+		std::fill_n(m_first_moment.begin() + i * m_dims, m_dims, 0.0f);
+		std::fill_n(m_second_moment.begin() + i * m_dims, m_dims, 0.0f);
+		std::fill_n(m_variable.begin() + i * m_dims, m_dims, 0.0f);
+	}
+
+	void reset_state() {
+		std::fill(m_iter.begin(), m_iter.end(), 0);
+		std::fill(m_first_moment.begin(), m_first_moment.end(), 0.0f);
+		std::fill(m_second_moment.begin(), m_second_moment.end(), 0.0f);
+		std::fill(m_variable.begin(), m_variable.end(), 0.0f);
+	}
+
+	// The per-optimizer state is stored as raw binary blobs (msgpack `bin`),
+	// which is several times more compact than one JSON object per optimizer.
+	void to_json(nlohmann::json& j) const {
+		j["size"] = size();
+		j["dims"] = m_dims;
+		j["rotation"] = m_rotation;
+		j["iter"] = to_json_binary(m_iter);
+		j["learning_rate"] = to_json_binary(m_learning_rate);
+		j["first_moment"] = to_json_binary(m_first_moment);
+		j["second_moment"] = to_json_binary(m_second_moment);
+		j["variable"] = to_json_binary(m_variable);
+		j["epsilon"] = m_hparams.epsilon;
+		j["beta1"] = m_hparams.beta1;
+		j["beta2"] = m_hparams.beta2;
+	}
+
+	// Also accepts the legacy layout: an array with one serialized
+	// `AdamOptimizer<T>`, `VarAdamOptimizer` or `RotationAdamOptimizer` each.
+	void from_json(const nlohmann::json& j) {
+		if (j.is_array()) {
+			from_json_legacy(j);
+			return;
+		}
+
+		size_t n = j.at("size");
+		m_dims = j.at("dims");
+		m_rotation = j.at("rotation");
+		m_hparams.epsilon = j.at("epsilon");
+		m_hparams.beta1 = j.at("beta1");
+		m_hparams.beta2 = j.at("beta2");
+
+		from_json_binary(j.at("iter"), n, m_iter);
+		from_json_binary(j.at("learning_rate"), n, m_learning_rate);
+		from_json_binary(j.at("first_moment"), n * m_dims, m_first_moment);
+		from_json_binary(j.at("second_moment"), n * m_dims, m_second_moment);
+		from_json_binary(j.at("variable"), n * m_dims, m_variable);
+		m_step_size.resize(n * m_dims, 0.0f);
+	}
+
+private:
+	void step_range(const float* gradient, size_t begin, size_t end, float gradient_scale, float l2_reg) {
+		// Per-optimizer bias-corrected step sizes, expanded to one entry per
+		// element so that the update below is a single vectorizable loop.
+		for (size_t i = begin; i < end; ++i) {
+			uint32_t iter = ++m_iter[i];
+
+			float actual_learning_rate;
+			if (m_rotation) {
+				// Mirrors RotationAdamOptimizer, which evaluates in double precision.
+				actual_learning_rate = m_learning_rate[i] * std::sqrt(1 - std::pow(m_hparams.beta2, iter)) / (1 - std::pow(m_hparams.beta1, iter));
+			} else {
+				actual_learning_rate = m_learning_rate[i] * std::sqrt(1.0f - std::pow(m_hparams.beta2, (float)iter)) / (1.0f - std::pow(m_hparams.beta1, (float)iter));
+			}
+
+			std::fill_n(m_step_size.data() + i * m_dims, m_dims, actual_learning_rate);
+		}
+
+		const float beta1 = m_hparams.beta1;
+		const float beta2 = m_hparams.beta2;
+		const float epsilon = m_hparams.epsilon;
+		const size_t offset = begin * m_dims;
+		const size_t n_elements = (end - begin) * m_dims;
+
+		float* first_moment = m_first_moment.data() + offset;
+		float* second_moment = m_second_moment.data() + offset;
+		float* variable = m_variable.data() + offset;
+		float* step_size = m_step_size.data() + offset;
+
+		for (size_t k = 0; k < n_elements; ++k) {
+			float g = gradient[k] * gradient_scale;
+			if (l2_reg != 0.0f) {
+				g += variable[k] * l2_reg;
+			}
+
+			first_moment[k] = beta1 * first_moment[k] + (1.0f - beta1) * g;
+			second_moment[k] = beta2 * second_moment[k] + (1.0f - beta2) * g * g;
+
+			// The step is stored in place of the step size.
+			step_size[k] = step_size[k] * first_moment[k] / (std::sqrt(second_moment[k]) + epsilon);
+		}
+
+		if (!m_rotation) {
+			for (size_t k = 0; k < n_elements; ++k) {
+				variable[k] -= step_size[k];
+			}
+		} else {
+			for (size_t i = 0; i < end - begin; ++i) {
+				vec3& var = *reinterpret_cast<vec3*>(variable + i * 3);
+				const vec3& rot = *reinterpret_cast<const vec3*>(step_size + i * 3);
+				var = rotvec(rotmat(-rot) * rotmat(var));
+			}
+		}
+	}
+
+	template <typename T>
+	static nlohmann::json to_json_binary(const std::vector<T>& data) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+		return nlohmann::json::binary(std::vector<uint8_t>(bytes, bytes + data.size() * sizeof(T)));
+	}
+
+	template <typename T>
+	static void from_json_binary(const nlohmann::json& j, size_t n, std::vector<T>& data) {
+		const nlohmann::json::binary_t& bytes = j.get_binary();
+		if (bytes.size() != n * sizeof(T)) {
+			throw std::runtime_error{"BatchedAdamOptimizer: binary state has an unexpected size."};
+		}
+
+		data.resize(n);
+		if (n > 0) {
+			std::memcpy(data.data(), bytes.data(), bytes.size());
+		}
+	}
+
+	void from_json_legacy(const nlohmann::json& j) {
+		size_t n = j.size();
+		if (n > 0) {
+			m_dims = (uint32_t)j[0].at("variable").size();
+			m_hparams.epsilon = j[0].at("epsilon");
+			m_hparams.beta1 = j[0].at("beta1");
+			m_hparams.beta2 = j[0].at("beta2");
+		}
+
+		m_iter.resize(n);
+		m_learning_rate.resize(n);
+		m_first_moment.resize(n * m_dims);
+		m_second_moment.resize(n * m_dims);
+		m_variable.resize(n * m_dims);
+		m_step_size.resize(n * m_dims, 0.0f);
+
+		for (size_t i = 0; i < n; ++i) {
+			const nlohmann::json& opt = j[i];
+			m_iter[i] = opt.at("iter");
+			m_learning_rate[i] = opt.at("learning_rate");
+			for (uint32_t d = 0; d < m_dims; ++d) {
+				m_first_moment[i * m_dims + d] = opt.at("first_moment").at(d).get<float>();
+				m_second_moment[i * m_dims + d] = opt.at("second_moment").at(d).get<float>();
+				m_variable[i * m_dims + d] = opt.at("variable").at(d).get<float>();
+			}
+		}
+	}
+
+	uint32_t m_dims;
+	bool m_rotation;
+
+	std::vector<uint32_t> m_iter;
+	std::vector<float> m_learning_rate;
+	std::vector<float> m_first_moment;
+	std::vector<float> m_second_moment;
+	std::vector<float> m_variable;
+
+	// Scratch space, one entry per element.
+	std::vector<float> m_step_size;
+
+	struct Hyperparameters {
+		float learning_rate;
+		float epsilon;
+		float beta1;
+		float beta2;
+	} m_hparams;
+};
+
+inline void to_json(nlohmann::json& j, const BatchedAdamOptimizer& opt) {
+	opt.to_json(j);
+}
+
+inline void from_json(const nlohmann::json& j, BatchedAdamOptimizer& opt) {
+	opt.from_json(j);
+}
+
 NGP_NAMESPACE_END
@@ -407,6 +407,8 @@ struct Buffer2DView {
 uint8_t* load_stbi(const fs::path& path, int* width, int* height, int* comp, int req_comp);
 float* load_stbi_float(const fs::path& path, int* width, int* height, int* comp, int req_comp);
 uint16_t* load_stbi_16(const fs::path& path, int* width, int* height, int* comp, int req_comp);
+// Reads only the header of the image.
+bool info_stbi(const fs::path& path, int* width, int* height, int* comp);
 bool is_hdr_stbi(const fs::path& path);
 int write_stbi(const fs::path& path, int width, int height, int comp, const uint8_t* pixels, int quality = 100);
 
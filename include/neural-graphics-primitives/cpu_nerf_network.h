@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   cpu_nerf_network.h
+ *  @brief  Host-side evaluation of the hash-grid NeRF stored in snapshots,
+ *          for density and color queries on machines without a GPU.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/thread_pool.h>
+
+#include <json/json.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+enum class ECpuWeightPrecision : int {
+	Float,
+	Half,
+	Int8,
+};
+static constexpr const char* CpuWeightPrecisionStr = "Float\0Half\0Int8\0\0";
+
+// Evaluates the NerfNetwork of a snapshot on the CPU: the multiresolution
+// hash-grid encoding, the density MLP, the spherical-harmonics direction
+// encoding and the color MLP. Only the configurations that NerfNetwork builds
+// from a hash grid and FullyFusedMLPs are supported, and the constructor
+// throws for anything else (other encodings, extra dims, CutlassMLP).
+//
+// Points are processed in batches of `BATCH_SIZE` whose activations are stored
+// feature-major, so that each layer of an MLP is one (width x inputs) by
+// (inputs x batch) matrix product, done by the SIMD GEMM of the codelibrary.
+// Batches are distributed over a thread pool.
+//
+// With `ECpuWeightPrecision::Half` or `Int8`, the hash grid, which holds nearly
+// all parameters, is kept in fp16 or in 8 bits with a scale and offset per
+// level, halving or quartering the memory and bandwidth of the encoding. The
+// MLP weights are rounded to the same precision but multiplied in fp32.
+//
+// The GPU evaluates the network in fp16, so results match those of the GPU up
+// to fp16 rounding, see check_cpu_nerf_network().
+class CpuNerfNetwork {
+public:
+	static constexpr uint32_t BATCH_SIZE = 256;
+
+	// `config` is a network config that contains a "snapshot", as returned by
+	// load_network_config(). `n_threads` = 0 uses all hardware threads.
+	CpuNerfNetwork(const nlohmann::json& config, ECpuWeightPrecision precision = ECpuWeightPrecision::Float, size_t n_threads = 0);
+
+	// Reads a .ingp or .msgpack snapshot and decodes its snapshot codecs.
+	static nlohmann::json load_network_config(const fs::path& path);
+
+	// Raw density outputs (before the density activation), as returned by
+	// NerfNetwork::density(). `positions` holds n xyz triples of network
+	// inputs, i.e. the positions passed to the NerfNetwork.
+	void density(const float* positions, size_t n, float* density);
+
+	// Raw (r, g, b, density) outputs (before the activations), as returned by
+	// NerfNetwork::inference(). `directions` holds n unit-length xyz triples.
+	void inference(const float* positions, const float* directions, size_t n, float* rgbd);
+
+	// Same as inference(), but with the activations of the testbed applied:
+	// linear rgb and the volume density.
+	void query(const float* positions, const float* directions, size_t n, float* rgbd);
+
+	ENerfActivation rgb_activation = ENerfActivation::Exponential;
+	ENerfActivation density_activation = ENerfActivation::Exponential;
+
+	// Ratio of the grid levels in use, as set by Testbed::set_max_level().
+	float max_level = 1.0f;
+
+	ECpuWeightPrecision precision() const {
+		return m_precision;
+	}
+
+	uint32_t n_levels() const {
+		return m_n_levels;
+	}
+
+	size_t n_params() const {
+		return m_n_params;
+	}
+
+	// Bytes of the stored parameters.
+	size_t n_bytes() const;
+
+private:
+	enum class EActivation {
+		None,
+		ReLU,
+		LeakyReLU,
+		Exponential,
+		Sine,
+		Sigmoid,
+		Squareplus,
+		Softplus,
+		Tanh,
+	};
+
+	enum class EHashType {
+		Prime,
+		CoherentPrime,
+		ReversedPrime,
+	};
+
+	struct Mlp {
+		uint32_t input_width = 0;
+		uint32_t width = 0;
+		uint32_t padded_output_width = 0;
+		EActivation activation = EActivation::ReLU;
+		EActivation output_activation = EActivation::None;
+
+		// Row-major (output x input) matrices, from the input layer to the
+		// output layer.
+		std::vector<std::vector<float>> weights;
+
+		size_t n_params() const;
+	};
+
+	// Scratch buffers of one batch, feature-major.
+	struct Workspace {
+		std::vector<float> encoded;
+		std::vector<float> hidden[2];
+		std::vector<float> density_out;
+		std::vector<float> rgb_in;
+		std::vector<float> rgb_out;
+	};
+
+	static EActivation string_to_activation(const std::string& str);
+	static void apply(EActivation activation, float* values, size_t n);
+
+	void read_mlp(const nlohmann::json& config, uint32_t input_width, uint32_t output_width, const std::vector<float>& params, size_t* offset, Mlp* mlp) const;
+	void store_grid(const float* params);
+
+	template <typename FETCH>
+	void encode_level(uint32_t level, const float* positions, uint32_t n, FETCH fetch, float* out) const;
+	void encode_positions(const float* positions, uint32_t n, float* out) const;
+	void encode_directions(const float* directions, uint32_t n, float* out) const;
+
+	// Returns the padded output of the MLP in `ws.hidden`, or in `out` if given.
+	const float* run_mlp(const Mlp& mlp, const float* input, uint32_t n, Workspace& ws, float* out = nullptr) const;
+
+	void inference_batch(const float* positions, const float* directions, uint32_t n, float* rgbd, Workspace& ws) const;
+
+	template <typename F>
+	void for_each_batch(size_t n, F body);
+
+	ECpuWeightPrecision m_precision;
+	size_t m_n_params = 0;
+
+	// Hash grid.
+	uint32_t m_n_levels = 0;
+	uint32_t m_n_features_per_level = 2;
+	uint32_t m_base_resolution = 16;
+	float m_log2_per_level_scale = 1.0f;
+	bool m_hash = true;
+	EHashType m_hash_type = EHashType::CoherentPrime;
+	bool m_smoothstep = false;
+	bool m_nearest = false;
+	uint32_t m_encoding_width = 0;
+	std::vector<uint32_t> m_level_offsets;
+	std::vector<float> m_level_scales;
+	std::vector<uint32_t> m_level_resolutions;
+
+	std::vector<float> m_grid;
+	std::vector<uint16_t> m_grid_half;
+	std::vector<uint8_t> m_grid_int8;
+	std::vector<float> m_int8_scales;
+	std::vector<float> m_int8_offsets;
+
+	// Direction encoding.
+	uint32_t m_sh_degree = 4;
+	uint32_t m_dir_padding = 0;
+	uint32_t m_dir_width = 0;
+
+	Mlp m_density_network;
+	Mlp m_rgb_network;
+	uint32_t m_rgb_input_width = 0;
+
+	std::unique_ptr<ThreadPool> m_pool;
+};
+
+// Compares the CPU network with the GPU outputs stored in `reference` by
+// Testbed::save_query_reference() at all weight precisions, and reports the
+// errors and the throughput in points per second. Returns whether the errors
+// of all precisions are within their tolerances.
+bool check_cpu_nerf_network(const fs::path& reference, size_t n_threads = 0);
+
+NGP_NAMESPACE_END
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   cpu_tonemap.h
+ *  @brief  Host-side accumulation and tonemapping of RGBA render buffers,
+ *          with the semantics of CudaRenderBuffer::accumulate/tonemap.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+
+NGP_NAMESPACE_BEGIN
+
+enum class ECpuImageFormat : int {
+	Float,
+	Half,
+	UInt16,
+	UInt8,
+};
+static constexpr const char* CpuImageFormatStr = "Float\0Half\0UInt16\0UInt8\0\0";
+
+struct CpuTonemapSettings {
+	float exposure = 0.0f;
+	EColorSpace color_space = EColorSpace::Linear;
+	EColorSpace output_color_space = EColorSpace::SRGB;
+	ETonemapCurve tonemap_curve = ETonemapCurve::Identity;
+	// In sRGB, like the background color of the testbed.
+	vec4 background_color = vec4(0.0f);
+	bool unmultiply_alpha = false;
+	bool clamp_output_color = false;
+};
+
+// Blends `frame` into `accumulation` after `sample_count` previous frames, like
+// accumulate_kernel. Both hold resolution.x * resolution.y RGBA floats.
+void cpu_accumulate(const float* frame, const ivec2& resolution, int sample_count, EColorSpace color_space, float* accumulation);
+
+// Tonemaps the RGBA floats in `rgba` to `out`, which has the same layout and
+// the element type of `format` (fp16 for ECpuImageFormat::Half). Integer
+// formats are clamped to [0, 1]. Scanlines are processed in parallel with AVX2
+// where available, see codelibrary/image/tonemapper.h.
+void cpu_tonemap(const float* rgba, const ivec2& resolution, const CpuTonemapSettings& settings, ECpuImageFormat format, void* out);
+
+NGP_NAMESPACE_END
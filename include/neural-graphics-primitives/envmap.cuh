@@ -17,6 +17,7 @@
 
 #include <neural-graphics-primitives/common.h>
 #include <neural-graphics-primitives/common_device.cuh>
+#include <neural-graphics-primitives/envmap_sampler.h>
 
 #include <tiny-cuda-nn/common.h>
 
@@ -93,4 +94,56 @@ __device__ void deposit_envmap_gradient(const tcnn::vector_t<T, 4>& value, GRAD_
 	deposit_val(value, (weight.x) * (weight.y), {envmap_texel.x+1, envmap_texel.y+1});
 }
 
+// Device copy of the importance-sampling tables and the mip pyramid of an
+// EnvmapSampler. The views remain valid until the next upload().
+class GPUEnvmapSampler {
+public:
+	void upload(const EnvmapSampler& sampler) {
+		if (sampler.empty()) {
+			throw std::runtime_error{"GPUEnvmapSampler: the sampler has not been built."};
+		}
+
+		m_marginal_cdf.resize_and_copy_from_host(sampler.marginal_cdf());
+		m_conditional_cdf.resize_and_copy_from_host(sampler.conditional_cdf());
+		m_distribution_resolution = sampler.distribution_resolution();
+
+		m_levels.resize(sampler.n_levels());
+		m_level_resolutions.resize(sampler.n_levels());
+		for (uint32_t i = 0; i < sampler.n_levels(); ++i) {
+			m_levels[i].resize_and_copy_from_host(sampler.level(i));
+			m_level_resolutions[i] = sampler.level_resolution(i);
+		}
+	}
+
+	bool empty() const {
+		return m_levels.empty();
+	}
+
+	EnvmapDistribution distribution() const {
+		if (empty()) {
+			return {};
+		}
+
+		return {m_marginal_cdf.data(), m_conditional_cdf.data(), m_distribution_resolution};
+	}
+
+	EnvmapMipmap mipmap() const {
+		EnvmapMipmap result;
+		result.n_levels = (uint32_t)m_levels.size();
+		for (uint32_t i = 0; i < result.n_levels; ++i) {
+			result.levels[i] = {m_levels[i].data(), m_level_resolutions[i]};
+		}
+
+		return result;
+	}
+
+private:
+	tcnn::GPUMemory<float> m_marginal_cdf;
+	tcnn::GPUMemory<float> m_conditional_cdf;
+	ivec2 m_distribution_resolution = ivec2(0);
+
+	std::vector<tcnn::GPUMemory<vec4>> m_levels;
+	std::vector<ivec2> m_level_resolutions;
+};
+
 NGP_NAMESPACE_END
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   envmap_sampler.h
+ *  @brief  Importance sampling, prefiltering and cubemap conversion of
+ *          latitude-longitude envmaps. The tables are built on the host and
+ *          read through views that work on the host and on the device.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+// Parameterization of read_envmap(): u is the azimuth and v the polar angle of
+// {dir.z, -dir.x, dir.y}, both normalized to [0,1]. The texel (x,y) of a
+// (w x h) envmap lies at uv = (x / (w-1), y / (h-1)).
+inline NGP_HOST_DEVICE vec2 envmap_uv(const vec3& dir) {
+	const float cos_theta = fminf(fmaxf(dir.y, -1.0f), 1.0f);
+	const float phi = atan2f(-dir.x, dir.z);
+	return {phi / (2.0f * pi<float>()) + 0.5f, acosf(cos_theta) / pi<float>()};
+}
+
+inline NGP_HOST_DEVICE vec3 envmap_dir(const vec2& uv) {
+	const float theta = pi<float>() * uv.y;
+	const float phi = 2.0f * pi<float>() * (uv.x - 0.5f);
+	const float sin_theta = sinf(theta);
+	return {-sin_theta * sinf(phi), cosf(theta), sin_theta * cosf(phi)};
+}
+
+// Bilinear lookup, identical to read_envmap() but usable on the host.
+inline NGP_HOST_DEVICE vec4 read_envmap_uv(const Buffer2DView<const vec4>& envmap, const vec2& uv) {
+	auto envmap_float = vec2{uv.x * (envmap.resolution.x-1), uv.y * (envmap.resolution.y-1)};
+	ivec2 envmap_texel = envmap_float;
+
+	auto weight = envmap_float - vec2(envmap_texel);
+
+	auto read_val = [&](ivec2 pos) {
+		if (pos.x < 0) {
+			pos.x += envmap.resolution.x;
+		} else if (pos.x >= envmap.resolution.x) {
+			pos.x -= envmap.resolution.x;
+		}
+		pos.y = max(min(pos.y, envmap.resolution.y-1), 0);
+		return envmap.at(pos);
+	};
+
+	return (
+		(1 - weight.x) * (1 - weight.y) * read_val({envmap_texel.x, envmap_texel.y}) +
+		(weight.x) * (1 - weight.y) * read_val({envmap_texel.x+1, envmap_texel.y}) +
+		(1 - weight.x) * (weight.y) * read_val({envmap_texel.x, envmap_texel.y+1}) +
+		(weight.x) * (weight.y) * read_val({envmap_texel.x+1, envmap_texel.y+1})
+	);
+}
+
+// Piecewise-constant distribution of directions over a regular grid of cells
+// in envmap_uv() space, whose weights are the luminance of the envmap times
+// the solid angle of the cells. The CDFs have the layout of
+// cl::image::Distribution2D: `marginal_cdf` has resolution.y+1 entries and
+// `conditional_cdf` has resolution.x+1 entries per row.
+struct EnvmapDistribution {
+	const float* marginal_cdf = nullptr;
+	const float* conditional_cdf = nullptr;
+	ivec2 resolution = ivec2(0);
+
+	NGP_HOST_DEVICE bool empty() const {
+		return marginal_cdf == nullptr;
+	}
+
+	// Maps uniform random numbers in [0,1)^2 to a unit direction and returns
+	// its density with respect to the solid angle in `pdf`.
+	NGP_HOST_DEVICE vec3 sample(const vec2& rnd, float* pdf) const {
+		float dx, dy;
+		int y = sample_cdf(marginal_cdf, resolution.y, rnd.y, &dy);
+		const float* row = conditional_cdf + y * (resolution.x + 1);
+		int x = sample_cdf(row, resolution.x, rnd.x, &dx);
+
+		vec2 uv = {(x + dx) / resolution.x, (y + dy) / resolution.y};
+		vec3 dir = envmap_dir(uv);
+		*pdf = solid_angle_pdf(cell_pdf(x, y), dir);
+		return dir;
+	}
+
+	// Density of the unit direction `dir` with respect to the solid angle.
+	NGP_HOST_DEVICE float pdf(const vec3& dir) const {
+		vec2 uv = envmap_uv(dir);
+		int x = min(max((int)(uv.x * resolution.x), 0), resolution.x - 1);
+		int y = min(max((int)(uv.y * resolution.y), 0), resolution.y - 1);
+		return solid_angle_pdf(cell_pdf(x, y), dir);
+	}
+
+	NGP_HOST_DEVICE float cell_pdf(int x, int y) const {
+		const float* row = conditional_cdf + y * (resolution.x + 1);
+		return (marginal_cdf[y+1] - marginal_cdf[y]) * resolution.y * (row[x+1] - row[x]) * resolution.x;
+	}
+
+	// dw = sin(theta) * 2pi du * pi dv
+	static NGP_HOST_DEVICE float solid_angle_pdf(float pdf_uv, const vec3& dir) {
+		float sin_theta = sqrtf(dir.x * dir.x + dir.z * dir.z);
+		return sin_theta > 0.0f ? pdf_uv / (2.0f * pi<float>() * pi<float>() * sin_theta) : 0.0f;
+	}
+
+	// Binary search for the cell k with cdf[k] <= u < cdf[k+1].
+	static NGP_HOST_DEVICE int sample_cdf(const float* cdf, int n, float u, float* offset) {
+		u = fminf(fmaxf(u, 0.0f), 0.99999994f);
+		int lo = 0, hi = n;
+		while (hi - lo > 1) {
+			int mid = (lo + hi) / 2;
+			if (cdf[mid] <= u) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+
+		float width = cdf[lo+1] - cdf[lo];
+		*offset = width > 0.0f ? fminf((u - cdf[lo]) / width, 0.99999994f) : 0.5f;
+		return lo;
+	}
+};
+
+// Mip pyramid of an envmap for prefiltered lookups. Every level has the
+// parameterization of read_envmap() and halves the resolution of the previous
+// one, down to 2x2.
+struct EnvmapMipmap {
+	static constexpr uint32_t MAX_LEVELS = 16;
+
+	Buffer2DView<const vec4> levels[MAX_LEVELS];
+	uint32_t n_levels = 0;
+
+	// Trilinear lookup, level 0 is the envmap itself.
+	NGP_HOST_DEVICE vec4 read(const vec3& dir, float level) const {
+		level = fminf(fmaxf(level, 0.0f), (float)(n_levels - 1));
+		uint32_t l0 = (uint32_t)level;
+		uint32_t l1 = min(l0 + 1, n_levels - 1);
+		float t = level - (float)l0;
+
+		vec2 uv = envmap_uv(dir);
+		return (1.0f - t) * read_envmap_uv(levels[l0], uv) + t * read_envmap_uv(levels[l1], uv);
+	}
+
+	// Level whose texels at the horizon subtend `solid_angle`, e.g. the
+	// footprint of a pixel.
+	NGP_HOST_DEVICE float level_for_solid_angle(float solid_angle) const {
+		const ivec2 res = levels[0].resolution;
+		const float texel = 2.0f * pi<float>() * pi<float>() / ((float)(res.x - 1) * (float)(res.y - 1));
+		return solid_angle > texel ? 0.5f * log2f(solid_angle / texel) : 0.0f;
+	}
+};
+
+// Builds the importance-sampling tables and the mip pyramid of an envmap on
+// the host. The tables are rebuilt in parallel by build(), and can be read
+// directly through the host views or uploaded with GPUEnvmapSampler (envmap.cuh).
+class EnvmapSampler {
+public:
+	// `envmap` holds the resolution.x * resolution.y RGBA texels of the
+	// envmap in host memory, laid out like TrainableEnvmap. The distribution
+	// uses `distribution_resolution` cells, or one cell per texel if it is 0.
+	void build(const vec4* envmap, const ivec2& resolution, ivec2 distribution_resolution = ivec2(0));
+
+	bool empty() const {
+		return m_levels.empty();
+	}
+
+	EnvmapDistribution distribution() const;
+	EnvmapMipmap mipmap() const;
+
+	const std::vector<float>& marginal_cdf() const {
+		return m_marginal_cdf;
+	}
+
+	const std::vector<float>& conditional_cdf() const {
+		return m_conditional_cdf;
+	}
+
+	ivec2 distribution_resolution() const {
+		return m_distribution_resolution;
+	}
+
+	uint32_t n_levels() const {
+		return (uint32_t)m_levels.size();
+	}
+
+	const std::vector<vec4>& level(uint32_t i) const {
+		return m_levels.at(i);
+	}
+
+	ivec2 level_resolution(uint32_t i) const {
+		return m_level_resolutions.at(i);
+	}
+
+	// Renders the six (size x size) faces of a cubemap, in the order and
+	// orientation of OpenGL (+X, -X, +Y, -Y, +Z, -Z) as cl::world::Cubemap.
+	std::vector<vec4> to_cubemap(uint32_t size) const;
+
+	// Resamples a cubemap as returned by to_cubemap() to an envmap of the
+	// given resolution.
+	static std::vector<vec4> from_cubemap(const vec4* faces, uint32_t size, const ivec2& resolution);
+
+private:
+	ivec2 m_distribution_resolution = ivec2(0);
+	std::vector<float> m_marginal_cdf;
+	std::vector<float> m_conditional_cdf;
+
+	std::vector<std::vector<vec4>> m_levels;
+	std::vector<ivec2> m_level_resolutions;
+};
+
+NGP_NAMESPACE_END
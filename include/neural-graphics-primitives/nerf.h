@@ -29,6 +29,16 @@ inline constexpr __host__ __device__ uint32_t NERF_GRID_N_CELLS() {
     return NERF_GRIDSIZE() * NERF_GRIDSIZE() * NERF_GRIDSIZE();
 }
 
+// Number of nested density grids, each twice as large as the previous one.
+inline constexpr __host__ __device__ uint32_t NERF_CASCADES() {
+    return 8;
+}
+
+// Any alpha below this is considered "invisible" and is thus culled away.
+inline constexpr __host__ __device__ float NERF_MIN_OPTICAL_THICKNESS() {
+    return 0.01f;
+}
+
 struct NerfPayload {
     vec3 origin;
     vec3 dir;
@@ -20,6 +20,11 @@
 
 #include <filesystem/path.h>
 
+#include <json/json.hpp>
+
+#include "codelibrary/base/array.h"
+
+#include <array>
 #include <vector>
 
 NGP_NAMESPACE_BEGIN
@@ -188,9 +193,37 @@ struct NerfDataset {
 	}
 };
 
+// Reads the scene settings of a transforms file: scale, offset, aabb, up
+// vector, render aabb and learnable dimensions.
+void read_nerf_scene(const nlohmann::json& json, NerfDataset& result);
+// Reads the lens, principal point and rolling shutter shared by all frames of
+// a transforms file.
+TrainingImageMetadata read_nerf_lens(const nlohmann::json& json);
+// Reads the focal length, lens overrides, light direction and transforms of
+// image i_img from its frame object, on top of the settings of its file.
+// `start` and `end` are the first three rows of the transform matrices.
+void read_nerf_camera(const nlohmann::json& settings, const TrainingImageMetadata& lens, const nlohmann::json& frame, const std::array<float, 12>& start, const std::array<float, 12>& end, const ivec2& res, size_t i_img, NerfDataset& result);
+
 NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
                       float sharpen_amount = 0.f);
+
+// The frames of a block of a street view, read once for planning and loading.
+struct BlockNerfFrames {
+	std::string name;
+	nlohmann::json setting;
+	// The split rows of pose.csv, restricted to the keyframes, if selected.
+	cl::Array<cl::Array<std::string>> rows;
+	// The resolution of the image of each row.
+	std::vector<ivec2> resolutions;
+};
+
+BlockNerfFrames read_block_nerf_frames(const fs::path& data_path,
+                                       const std::string& block_name);
+NerfDataset load_block_nerf_data(const fs::path& data_path,
+                                 const std::string& block_name,
+                                 int downscale = 1);
 NerfDataset load_block_nerf_data(const fs::path& data_path,
-                                 const std::string& block_name);
+                                 const BlockNerfFrames& frames,
+                                 int downscale = 1);
 
 NGP_NAMESPACE_END
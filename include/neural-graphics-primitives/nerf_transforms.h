@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   nerf_transforms.h
+ *  @brief  Streaming parser of NeRF's transforms.json files, which extracts the
+ *          frames into a compact struct-of-arrays instead of a JSON DOM.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/thread_pool.h>
+
+#include <filesystem/path.h>
+
+#include <json/json.hpp>
+
+#include <natural_sort.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+// The contents of one transforms.json file.
+//
+// Large captures have 100k+ frames, and most of the time and memory of parsing
+// them into a DOM goes into the per-frame objects. Here, only the top-level
+// entries are kept as JSON; the frames are streamed into flat arrays, and the
+// rarely used per-frame entries (lens or focal length overrides, driver
+// parameters, ...) are kept as small JSON objects.
+struct NerfTransforms {
+	// All top-level entries but "frames".
+	nlohmann::json settings = nlohmann::json::object();
+	// Whether "frames" is an array.
+	bool has_frames = false;
+
+	std::vector<std::string> file_paths;
+	// Rows 0 to 2 of the 4x4 start and end matrices, row-major. The end matrix
+	// equals the start matrix if not given.
+	std::vector<std::array<float, 12>> xforms_start;
+	std::vector<std::array<float, 12>> xforms_end;
+	// 1 if not given, like frame.value("sharpness", 1.0).
+	std::vector<double> sharpness;
+	std::vector<uint8_t> has_sharpness;
+	// Empty if not given.
+	std::vector<std::string> depth_paths;
+	std::vector<uint8_t> has_depth_path;
+	// The remaining per-frame entries, an empty object if none.
+	std::vector<nlohmann::json> extras;
+
+	size_t n_frames() const {
+		return file_paths.size();
+	}
+
+	// Keeps the frames at the given indices, in the given order.
+	void select(const std::vector<size_t>& indices) {
+		auto pick = [&indices](auto& values) {
+			std::remove_reference_t<decltype(values)> picked;
+			picked.reserve(indices.size());
+			for (size_t i : indices) {
+				picked.emplace_back(std::move(values[i]));
+			}
+			values = std::move(picked);
+		};
+
+		pick(file_paths);
+		pick(xforms_start);
+		pick(xforms_end);
+		pick(sharpness);
+		pick(has_sharpness);
+		pick(depth_paths);
+		pick(has_depth_path);
+		pick(extras);
+	}
+
+	// Sorts the frames by the natural order of their paths, converts Windows
+	// path separators, keeps the first "n_frames" frames and discards the frames
+	// that are blurrier than their neighbors. `exists` tells whether the image
+	// of a (converted) path exists. Only indices are sorted and copied.
+	void sort_and_cull_frames(const std::function<bool(const std::string&)>& exists) {
+		std::vector<size_t> order(n_frames());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+			return SI::natural::compare<std::string>(file_paths[a], file_paths[b]);
+		});
+
+		for (auto& path : file_paths) {
+			// Compatibility with Windows paths on Linux. (Breaks linux filenames with "\\" in them, which is acceptable for us.)
+			path = replace_all(path, "\\", "/");
+		}
+
+		if (settings.contains("n_frames")) {
+			order.resize(std::min(order.size(), (size_t)settings["n_frames"]));
+		}
+
+		if (!order.empty() && has_sharpness[order[0]]) {
+			float sharpness_discard_threshold = settings.value("sharpness_discard_threshold", 0.0f); // Keep all by default
+
+			// Kill blurrier frames than their neighbors
+			const int neighborhood_size = 3;
+			std::vector<size_t> kept;
+			for (int i = 0; i < (int)order.size(); ++i) {
+				float mean_sharpness = 0.0f;
+				int mean_start = std::max(0, i-neighborhood_size);
+				int mean_end = std::min(i + neighborhood_size, (int)order.size() - 1);
+				for (int j = mean_start; j < mean_end; ++j) {
+					mean_sharpness += float(sharpness[order[j]]);
+				}
+
+				mean_sharpness /= (mean_end - mean_start);
+
+				if (exists(file_paths[order[i]]) && sharpness[order[i]] > sharpness_discard_threshold * mean_sharpness) {
+					kept.emplace_back(order[i]);
+				}
+			}
+			order = std::move(kept);
+		}
+
+		select(order);
+	}
+};
+
+// SAX handler of nlohmann::json::sax_parse that fills a NerfTransforms.
+//
+// Outside of the frames, values are rebuilt as JSON through a stack of open
+// containers. Inside a frame, the known entries are decoded directly.
+class NerfTransformsSax {
+public:
+	using json = nlohmann::json;
+
+	NerfTransformsSax(NerfTransforms& transforms, const fs::path& path) : m_transforms{transforms}, m_path{path} {}
+
+	bool null() { return scalar(nullptr); }
+	bool boolean(bool val) { return scalar(val); }
+	bool number_integer(json::number_integer_t val) { return number(val); }
+	bool number_unsigned(json::number_unsigned_t val) { return number(val); }
+	bool number_float(json::number_float_t val, const json::string_t&) { return number(val); }
+	bool binary(json::binary_t& val) { return scalar(std::move(val)); }
+
+	bool string(json::string_t& val) {
+		if (!capturing() && m_state == EState::Frame) {
+			switch (m_field) {
+				case EField::FilePath: m_frame_path = std::move(val); m_has_frame_path = true; break;
+				case EField::DepthPath: m_depth_path = std::move(val); m_has_depth_path = true; break;
+				default: error("has a frame entry of the wrong type");
+			}
+			m_field = EField::None;
+			return true;
+		}
+		return scalar(std::move(val));
+	}
+
+	bool start_object(size_t) {
+		if (m_state == EState::TopLevel && m_field == EField::Frames) {
+			// A "frames" entry that is not an array.
+			m_capture = &m_transforms.settings["frames"];
+			m_field = EField::None;
+		}
+
+		if (capturing()) {
+			json* slot = value_slot();
+			*slot = json::object();
+			m_dom.emplace_back(slot);
+			return true;
+		}
+
+		switch (m_state) {
+			case EState::Root: m_state = EState::TopLevel; break;
+			case EState::Frames: begin_frame(); m_state = EState::Frame; break;
+			default: error("is not a valid transforms file");
+		}
+		return true;
+	}
+
+	bool key(json::string_t& val) {
+		if (!m_dom.empty()) {
+			m_dom_slot = &(*m_dom.back())[val];
+			return true;
+		}
+
+		if (m_state == EState::TopLevel) {
+			if (val == "frames") {
+				// The last "frames" entry wins, as in a DOM.
+				m_field = EField::Frames;
+				m_transforms.has_frames = false;
+				m_transforms.settings.erase("frames");
+				m_transforms.select({});
+			} else {
+				m_capture = &m_transforms.settings[val];
+			}
+		} else if (m_state == EState::Frame) {
+			if (val == "file_path") {
+				m_field = EField::FilePath;
+			} else if (val == "transform_matrix") {
+				m_field = EField::Matrix;
+			} else if (val == "transform_matrix_start") {
+				m_field = EField::MatrixStart;
+			} else if (val == "transform_matrix_end") {
+				m_field = EField::MatrixEnd;
+			} else if (val == "sharpness") {
+				m_field = EField::Sharpness;
+			} else if (val == "depth_path") {
+				m_field = EField::DepthPath;
+			} else {
+				m_capture = &m_extras[val];
+			}
+		}
+		return true;
+	}
+
+	bool end_object() {
+		if (!m_dom.empty()) {
+			m_dom.pop_back();
+			return true;
+		}
+
+		switch (m_state) {
+			case EState::TopLevel: m_state = EState::Done; break;
+			case EState::Frame: end_frame(); m_state = EState::Frames; break;
+			default: error("is not a valid transforms file");
+		}
+		return true;
+	}
+
+	bool start_array(size_t) {
+		if (capturing()) {
+			json* slot = value_slot();
+			*slot = json::array();
+			m_dom.emplace_back(slot);
+			return true;
+		}
+
+		if (m_state == EState::TopLevel && m_field == EField::Frames) {
+			m_transforms.has_frames = true;
+			m_field = EField::None;
+			m_state = EState::Frames;
+		} else if (m_state == EState::Frame && is_matrix(m_field)) {
+			m_matrix = &m_matrices[(int)m_field - (int)EField::Matrix];
+			m_matrix_present[(int)m_field - (int)EField::Matrix] = true;
+			m_row = 0;
+			m_field = EField::None;
+			m_state = EState::Matrix;
+		} else if (m_state == EState::Matrix) {
+			m_col = 0;
+			m_state = EState::MatrixRow;
+		} else {
+			error("is not a valid transforms file");
+		}
+		return true;
+	}
+
+	bool end_array() {
+		if (!m_dom.empty()) {
+			m_dom.pop_back();
+			return true;
+		}
+
+		switch (m_state) {
+			case EState::Frames: m_state = EState::TopLevel; break;
+			case EState::Matrix:
+				if (m_row < 3) {
+					error("has a transform matrix with less than 3 rows");
+				}
+				m_state = EState::Frame;
+				break;
+			case EState::MatrixRow:
+				if (m_row < 3 && m_col < 4) {
+					error("has a transform matrix with less than 4 columns");
+				}
+				++m_row;
+				m_state = EState::Matrix;
+				break;
+			default: error("is not a valid transforms file");
+		}
+		return true;
+	}
+
+	bool parse_error(size_t, const std::string&, const nlohmann::detail::exception& ex) {
+		throw std::runtime_error{"Could not parse " + m_path.str() + ": " + ex.what()};
+	}
+
+private:
+	enum class EState {
+		Root,
+		TopLevel,
+		Frames,
+		Frame,
+		Matrix,
+		MatrixRow,
+		Done,
+	};
+
+	enum class EField {
+		None,
+		Frames,
+		FilePath,
+		Matrix,
+		MatrixStart,
+		MatrixEnd,
+		Sharpness,
+		DepthPath,
+	};
+
+	static bool is_matrix(EField field) {
+		return field == EField::Matrix || field == EField::MatrixStart || field == EField::MatrixEnd;
+	}
+
+	[[noreturn]] void error(const std::string& message) const {
+		throw std::runtime_error{m_path.str() + " " + message + "."};
+	}
+
+	// Whether the next value is rebuilt as JSON.
+	bool capturing() const {
+		return !m_dom.empty() || m_capture;
+	}
+
+	// Returns the JSON slot of the next value.
+	json* value_slot() {
+		if (m_dom.empty()) {
+			json* slot = m_capture;
+			m_capture = nullptr;
+			return slot;
+		}
+
+		json* top = m_dom.back();
+		if (top->is_array()) {
+			top->emplace_back();
+			return &top->back();
+		}
+		return m_dom_slot;
+	}
+
+	template <typename T>
+	bool scalar(T&& val) {
+		if (capturing()) {
+			*value_slot() = std::forward<T>(val);
+			return true;
+		}
+
+		if (m_state == EState::TopLevel && m_field == EField::Frames) {
+			// A "frames" entry that is not an array.
+			m_transforms.settings["frames"] = std::forward<T>(val);
+			m_field = EField::None;
+			return true;
+		}
+
+		error("has a frame entry of the wrong type");
+	}
+
+	template <typename T>
+	bool number(T val) {
+		if (!capturing()) {
+			if (m_state == EState::MatrixRow) {
+				if (m_row < 3 && m_col < 4) {
+					(*m_matrix)[m_row * 4 + m_col] = float(val);
+				}
+				++m_col;
+				return true;
+			}
+
+			if (m_state == EState::Frame && m_field == EField::Sharpness) {
+				m_sharpness = double(val);
+				m_has_sharpness = true;
+				m_field = EField::None;
+				return true;
+			}
+		}
+		return scalar(val);
+	}
+
+	void begin_frame() {
+		m_frame_path.clear();
+		m_has_frame_path = false;
+		m_depth_path.clear();
+		m_has_depth_path = false;
+		m_sharpness = 1.0;
+		m_has_sharpness = false;
+		m_matrix_present = {};
+		m_extras = json::object();
+		m_field = EField::None;
+	}
+
+	void end_frame() {
+		if (!m_has_frame_path) {
+			error("has a frame without file_path");
+		}
+		if (!m_matrix_present[1] && !m_matrix_present[0]) {
+			error("has a frame without transform_matrix");
+		}
+
+		const auto& start = m_matrix_present[1] ? m_matrices[1] : m_matrices[0];
+		const auto& end = m_matrix_present[2] ? m_matrices[2] : start;
+
+		NerfTransforms& t = m_transforms;
+		t.file_paths.emplace_back(std::move(m_frame_path));
+		t.xforms_start.emplace_back(start);
+		t.xforms_end.emplace_back(end);
+		t.sharpness.emplace_back(m_sharpness);
+		t.has_sharpness.emplace_back(m_has_sharpness);
+		t.depth_paths.emplace_back(std::move(m_depth_path));
+		t.has_depth_path.emplace_back(m_has_depth_path);
+		t.extras.emplace_back(std::move(m_extras));
+	}
+
+	NerfTransforms& m_transforms;
+	fs::path m_path;
+
+	EState m_state = EState::Root;
+	EField m_field = EField::None;
+
+	// Open JSON containers, the slot of the current object key, and the slot
+	// of the next value outside of any container.
+	std::vector<json*> m_dom;
+	json* m_dom_slot = nullptr;
+	json* m_capture = nullptr;
+
+	// The current frame.
+	std::string m_frame_path;
+	bool m_has_frame_path = false;
+	std::string m_depth_path;
+	bool m_has_depth_path = false;
+	double m_sharpness = 1.0;
+	bool m_has_sharpness = false;
+	std::array<std::array<float, 12>, 3> m_matrices;
+	std::array<bool, 3> m_matrix_present = {};
+	std::array<float, 12>* m_matrix = nullptr;
+	int m_row = 0, m_col = 0;
+	json m_extras;
+};
+
+// Parses one transforms file. Comments are allowed, as for nlohmann::json::parse.
+inline NerfTransforms parse_nerf_transforms(const fs::path& path) {
+	std::ifstream f{native_string(path), std::ios::in | std::ios::binary};
+	if (!f) {
+		throw std::runtime_error{"Could not open " + path.str() + "."};
+	}
+
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	std::string data = buffer.str();
+
+	NerfTransforms result;
+	NerfTransformsSax sax{result, path};
+	nlohmann::json::sax_parse(data, &sax, nlohmann::json::input_format_t::json, true, true);
+	return result;
+}
+
+// Parses the transforms files in parallel.
+inline std::vector<NerfTransforms> parse_nerf_transforms(const std::vector<fs::path>& paths, ThreadPool& pool) {
+	std::vector<NerfTransforms> result(paths.size());
+	pool.parallel_for<size_t>(0, paths.size(), [&](size_t i) {
+		result[i] = parse_nerf_transforms(paths[i]);
+	});
+	return result;
+}
+
+NGP_NAMESPACE_END
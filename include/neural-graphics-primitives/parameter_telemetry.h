@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   parameter_telemetry.h
+ *  @brief  Asynchronous statistics of the trained parameters: snapshots are
+ *          copied to pinned host memory on a side stream and analyzed on a
+ *          worker thread, without stalling the training loop.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/thread_pool.h>
+
+#include <tiny-cuda-nn/gpu_memory.h>
+#include <tiny-cuda-nn/multi_stream.h>
+
+#include "codelibrary/util/statistics/parameter_statistics.h"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+enum class ETelemetryFormat : int {
+	Csv,
+	Binary,
+};
+static constexpr const char* TelemetryFormatStr = "CSV\0Binary\0\0";
+
+// A contiguous range of the parameters, e.g. a level of a grid encoding.
+struct ParameterBlock {
+	std::string name;
+	size_t offset;
+	size_t size;
+};
+
+struct ParameterTelemetrySettings {
+	// Training steps between two snapshots. A snapshot is skipped while the
+	// previous one is still being analyzed.
+	uint32_t interval = 16;
+	// Histograms cover [-histogram_scale, histogram_scale] with 257 bins.
+	float histogram_scale = 1.0f;
+	// Bits of the quantization whose error is estimated (0 disables it).
+	int quantization_bits = 8;
+};
+
+struct ParameterTelemetryResult {
+	uint32_t training_step = 0;
+	std::vector<cl::ParameterStats> blocks;
+};
+
+class ParameterTelemetry {
+public:
+	ParameterTelemetry();
+	~ParameterTelemetry();
+
+	ParameterTelemetry(const ParameterTelemetry&) = delete;
+	ParameterTelemetry& operator=(const ParameterTelemetry&) = delete;
+
+	// Enqueues a snapshot of `blocks` of `params` after the work on `stream`,
+	// if the cadence allows it and no snapshot is in flight. `stream` only
+	// waits for a device-to-device copy; the host never blocks.
+	bool snapshot(cudaStream_t stream, const float* params, const std::vector<ParameterBlock>& blocks, uint32_t training_step);
+
+	// Advances the pipeline without blocking. Returns true and fills `result`
+	// when the statistics of a new snapshot are available; they are also
+	// appended to the time series, if one is open.
+	bool poll(ParameterTelemetryResult& result);
+
+	// Waits for the snapshot in flight, if any, and returns its statistics.
+	bool flush(ParameterTelemetryResult& result);
+
+	bool busy() const {
+		return m_state != EState::Idle;
+	}
+
+	void open_series(const fs::path& path, ETelemetryFormat format);
+	void close_series();
+
+	bool series_open() const {
+		return m_series.is_open();
+	}
+
+	ParameterTelemetrySettings settings;
+
+private:
+	enum class EState {
+		Idle,
+		Copying,
+		Analyzing,
+	};
+
+	void free_host_buffer();
+
+	EState m_state = EState::Idle;
+	bool m_has_snapshot = false;
+	uint32_t m_last_step = 0;
+
+	tcnn::StreamAndEvent m_stream;
+	cudaEvent_t m_copied = {};
+	tcnn::GPUMemory<float> m_staging;
+	float* m_host = nullptr;
+	size_t m_host_size = 0;
+
+	// State of the snapshot in flight.
+	std::vector<ParameterBlock> m_blocks;
+	uint32_t m_step = 0;
+	ParameterTelemetrySettings m_snapshot_settings;
+
+	ThreadPool m_worker{1};
+	std::future<ParameterTelemetryResult> m_analysis;
+
+	cl::ParameterStatsWriter m_series;
+};
+
+NGP_NAMESPACE_END
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   snapshot_codec.h
+ *  @brief  Optional lossy compression of the network parameters and the
+ *          density grid stored in snapshots.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+
+#include <json/json.hpp>
+
+#include "codelibrary/base/float.h"
+#include "codelibrary/util/codec/quantized_array_codec.h"
+#include "codelibrary/util/codec/rans_coder.h"
+#include "codelibrary/util/set/compressed_bitset.h"
+#include "codelibrary/util/set/dynamic_bitset.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+// Replaces the two largest entries of a snapshot by compact encodings:
+//
+// - "params_binary" becomes "params_codec". The hash-grid parameters are
+//   quantized per level to `grid_bits` bits with their own scale/offset, after
+//   zeroing entries with |v| <= `zero_threshold` (hash entries never visited
+//   by training keep their tiny initial values), and are rANS entropy coded.
+//   All other parameters (the MLPs) are stored losslessly.
+// - "density_grid_binary" becomes "density_grid_codec". Only the cells set in
+//   the occupancy bitfield keep their (fp16) values; the bitfield is stored as
+//   entropy-coded run lengths, and all other cells get one fill value that
+//   preserves the mean density, so that the bitfield recomputed on load is the
+//   same up to fp16 rounding.
+//
+// Both are decoded in parallel over independent chunks. Decoding replaces the
+// codec entries by the plain ones, so the rest of the loading code is
+// unchanged. The compression is meant for shipping trained models to render
+// nodes: to resume training, save uncompressed snapshots.
+struct SnapshotCodec {
+	// Bits per hash-grid parameter (1 to 8), or 0 to disable the codec.
+	int grid_bits = 0;
+	float zero_threshold = 1e-4f;
+	// Ratio of the values at each tail of a level that may be clamped, so
+	// that outliers do not waste the codes. Only used below 8 bits.
+	double clip_ratio = 0.005;
+
+	bool enabled() const {
+		return grid_bits > 0;
+	}
+
+	// `level_sizes` are the numbers of parameters of the hash-grid levels,
+	// which are stored contiguously from `grid_offset`.
+	void encode_params(nlohmann::json& snapshot, size_t grid_offset, const std::vector<size_t>& level_sizes) const {
+		std::vector<float> params = params_from_json(snapshot);
+
+		size_t grid_size = 0;
+		cl::Array<int> segment_sizes;
+		for (size_t size : level_sizes) {
+			grid_size += size;
+			segment_sizes.push_back((int)size);
+		}
+		if (grid_offset + grid_size > params.size()) {
+			throw std::runtime_error{"SnapshotCodec: hash grid levels exceed the parameters."};
+		}
+
+		cl::QuantizedArrayCodec::Options options;
+		options.n_bits = grid_bits;
+		options.zero_threshold = zero_threshold;
+		options.clip_ratio = grid_bits < 8 ? clip_ratio : 0.0;
+		cl::QuantizedArrayCodec codec{options};
+
+		cl::Array<uint8_t> grid;
+		codec.Encode(params.data() + grid_offset, segment_sizes, &grid);
+
+		// The MLP parameters before the grid and any parameters after it.
+		std::vector<float> other(params.begin(), params.begin() + grid_offset);
+		other.insert(other.end(), params.begin() + grid_offset + grid_size, params.end());
+
+		nlohmann::json& data = snapshot["params_codec"];
+		data["n_params"] = params.size();
+		data["grid_offset"] = grid_offset;
+		data["grid_size"] = grid_size;
+		data["grid_binary"] = to_json_binary(grid.data(), grid.size());
+		data["other_binary"] = to_json_binary(other.data(), other.size() * sizeof(float));
+		snapshot.erase("params_binary");
+	}
+
+	// `grid` is the density grid, and `bitfield` holds at least one bit per
+	// cell, of which the first `n_cells` (one cascade) are used by the mean
+	// density.
+	void encode_density_grid(nlohmann::json& snapshot, const std::vector<float>& grid, const std::vector<uint8_t>& bitfield, uint32_t n_cells) const {
+		if (bitfield.size() * 8 < grid.size() || n_cells > grid.size()) {
+			throw std::runtime_error{"SnapshotCodec: density grid bitfield is too small."};
+		}
+
+		cl::DynamicBitset occupied((int)grid.size());
+		std::memcpy(occupied.data(), bitfield.data(), (grid.size() + 7) / 8);
+
+		// The fill value keeps the mean density of the first cascade, which
+		// sets the occupancy threshold. It is not above the threshold, as the
+		// values it replaces are not.
+		double sum = 0.0;
+		uint32_t n_empty = 0;
+		for (uint32_t i = 0; i < n_cells; ++i) {
+			if (!occupied.Test(i)) {
+				sum += std::max(grid[i], 0.0f);
+				++n_empty;
+			}
+		}
+		float fill = n_empty > 0 ? (float)(sum / n_empty) : 0.0f;
+		cl::Half fill_fp16{fill};
+		if ((float)fill_fp16 > fill) {
+			fill_fp16 = cl::Half::FromBits(fill_fp16.bits() - 1);
+		}
+
+		// Run lengths as varints, alternating empty and occupied.
+		cl::RunLengthBitset runs{occupied};
+		cl::Array<uint8_t> lengths;
+		int last = 0;
+		for (int i = 0; i < runs.n_runs(); ++i) {
+			write_varint(runs.firsts()[i] - last, lengths);
+			write_varint(runs.lasts()[i] - runs.firsts()[i], lengths);
+			last = runs.lasts()[i];
+		}
+
+		// Low and high byte planes of the occupied values.
+		int n_occupied = runs.Count();
+		cl::Array<uint8_t> planes(2 * n_occupied);
+		int k = 0;
+		occupied.ForEachSetBit([&](int i) {
+			uint16_t bits = cl::Half{grid[i]}.bits();
+			planes[k] = (uint8_t)bits;
+			planes[n_occupied + k] = (uint8_t)(bits >> 8);
+			++k;
+		});
+
+		cl::RANSCoder coder;
+		cl::Array<uint8_t> encoded_lengths, encoded_planes;
+		coder.Encode(lengths, &encoded_lengths);
+		coder.Encode(planes, &encoded_planes);
+
+		nlohmann::json& data = snapshot["density_grid_codec"];
+		data["size"] = grid.size();
+		data["fill_fp16"] = fill_fp16.bits();
+		data["runs_binary"] = to_json_binary(encoded_lengths.data(), encoded_lengths.size());
+		data["values_binary"] = to_json_binary(encoded_planes.data(), encoded_planes.size());
+		snapshot.erase("density_grid_binary");
+	}
+
+	static nlohmann::json::binary_t to_json_binary(const void* data, size_t n_bytes) {
+		nlohmann::json::binary_t binary;
+		binary.resize(n_bytes);
+		if (n_bytes > 0) {
+			std::memcpy(binary.data(), data, n_bytes);
+		}
+		return binary;
+	}
+
+	// Returns the serialized trainer parameters as floats.
+	static std::vector<float> params_from_json(const nlohmann::json& snapshot) {
+		const nlohmann::json::binary_t& bytes = snapshot["params_binary"].get_binary();
+		std::string type = snapshot.value("params_type", "__half");
+
+		std::vector<float> params;
+		if (type == "float") {
+			params.resize(bytes.size() / sizeof(float));
+			std::memcpy(params.data(), bytes.data(), params.size() * sizeof(float));
+		} else if (type == "__half") {
+			params.resize(bytes.size() / sizeof(uint16_t));
+			for (size_t i = 0; i < params.size(); ++i) {
+				uint16_t bits = (uint16_t)(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+				params[i] = (float)cl::Half::FromBits(bits);
+			}
+		} else {
+			throw std::runtime_error{"SnapshotCodec: parameters must be of type float or __half."};
+		}
+		return params;
+	}
+
+	static void write_varint(uint32_t v, cl::Array<uint8_t>& bytes) {
+		while (v >= 0x80) {
+			bytes.push_back((uint8_t)(v | 0x80));
+			v >>= 7;
+		}
+		bytes.push_back((uint8_t)v);
+	}
+
+	static bool read_varint(const uint8_t** p, const uint8_t* end, uint32_t* v) {
+		*v = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			if (*p == end) {
+				return false;
+			}
+
+			uint8_t byte = *(*p)++;
+			*v |= (uint32_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+// Replaces the codec entries of a loaded snapshot by the plain entries.
+inline void decode_snapshot_codecs(nlohmann::json& snapshot) {
+	if (snapshot.contains("params_codec")) {
+		const nlohmann::json& data = snapshot["params_codec"];
+		size_t n_params = data["n_params"];
+		size_t grid_offset = data["grid_offset"];
+		size_t grid_size = data["grid_size"];
+
+		const nlohmann::json::binary_t& grid_binary = data["grid_binary"].get_binary();
+		const nlohmann::json::binary_t& other = data["other_binary"].get_binary();
+
+		cl::Array<float> grid;
+		if (!cl::QuantizedArrayCodec::Decode(grid_binary.data(), (int)grid_binary.size(), &grid) ||
+			(size_t)grid.size() != grid_size || other.size() != (n_params - grid_size) * sizeof(float)) {
+			throw std::runtime_error{"Snapshot has corrupted compressed parameters."};
+		}
+
+		nlohmann::json::binary_t params;
+		params.resize(n_params * sizeof(float));
+		uint8_t* p = params.data();
+		std::memcpy(p, other.data(), grid_offset * sizeof(float));
+		std::memcpy(p + grid_offset * sizeof(float), grid.data(), grid_size * sizeof(float));
+		std::memcpy(p + (grid_offset + grid_size) * sizeof(float), other.data() + grid_offset * sizeof(float), other.size() - grid_offset * sizeof(float));
+
+		snapshot["params_type"] = "float";
+		snapshot["params_binary"] = std::move(params);
+		snapshot.erase("params_codec");
+	}
+
+	if (snapshot.contains("density_grid_codec")) {
+		const nlohmann::json& data = snapshot["density_grid_codec"];
+		size_t size = data["size"];
+		uint16_t fill = data["fill_fp16"];
+		const nlohmann::json::binary_t& runs_binary = data["runs_binary"].get_binary();
+		const nlohmann::json::binary_t& values_binary = data["values_binary"].get_binary();
+
+		cl::RANSCoder coder;
+		cl::Array<uint8_t> lengths, planes;
+		if (!coder.Decode(runs_binary.data(), (int)runs_binary.size(), &lengths) ||
+			!coder.Decode(values_binary.data(), (int)values_binary.size(), &planes) ||
+			planes.size() % 2 != 0) {
+			throw std::runtime_error{"Snapshot has a corrupted compressed density grid."};
+		}
+
+		std::vector<uint16_t> grid(size, fill);
+		size_t n_occupied = planes.size() / 2, k = 0, pos = 0;
+		const uint8_t* p = lengths.data();
+		const uint8_t* end = p + lengths.size();
+		while (p != end) {
+			uint32_t empty, occupied;
+			if (!SnapshotCodec::read_varint(&p, end, &empty) || !SnapshotCodec::read_varint(&p, end, &occupied) ||
+				pos + empty + occupied > size || k + occupied > n_occupied) {
+				throw std::runtime_error{"Snapshot has a corrupted compressed density grid."};
+			}
+
+			pos += empty;
+			for (uint32_t i = 0; i < occupied; ++i, ++pos, ++k) {
+				grid[pos] = (uint16_t)(planes[k] | (planes[n_occupied + k] << 8));
+			}
+		}
+		if (k != n_occupied) {
+			throw std::runtime_error{"Snapshot has a corrupted compressed density grid."};
+		}
+
+		// Same layout as __half.
+		snapshot["density_grid_binary"] = SnapshotCodec::to_json_binary(grid.data(), grid.size() * sizeof(uint16_t));
+		snapshot.erase("density_grid_codec");
+	}
+}
+
+NGP_NAMESPACE_END
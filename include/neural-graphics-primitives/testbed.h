@@ -20,9 +20,11 @@
 #include <neural-graphics-primitives/discrete_distribution.h>
 #include <neural-graphics-primitives/nerf.h>
 #include <neural-graphics-primitives/nerf_loader.h>
+#include <neural-graphics-primitives/parameter_telemetry.h>
 #include <neural-graphics-primitives/render_buffer.h>
 #include <neural-graphics-primitives/sdf.h>
 #include <neural-graphics-primitives/shared_queue.h>
+#include <neural-graphics-primitives/snapshot_codec.h>
 #include <neural-graphics-primitives/thread_pool.h>
 #include <neural-graphics-primitives/trainable_buffer.cuh>
 
@@ -34,12 +36,15 @@
 #include "codelibrary/base/array.h"
 #include "codelibrary/geometry/point_3d.h"
 #include "codelibrary/geometry/bezier_curve_3d.h"
+#include "codelibrary/point_cloud/block_compositor.h"
+#include "codelibrary/util/memory/memory_planner.h"
 
 #ifdef NGP_PYTHON
 #  include <pybind11/pybind11.h>
 #  include <pybind11/numpy.h>
 #endif
 
+#include <map>
 #include <thread>
 
 struct GLFWwindow;
@@ -276,6 +281,11 @@ public:
         BoundingBox nerf_aabb;
         float data_scale;
         vec3 data_offset;
+        // Similarity from the world frame of the block, whose camera poses
+        // were refined independently, to the frame shared by all blocks.
+        float alignment_scale = 1.0f;
+        mat3 alignment_rotation = mat3(1.0f);
+        vec3 alignment_translation = vec3(0.0f);
         tcnn::GPUMemory<float> density_grid;
         std::shared_ptr<tcnn::Optimizer<precision_t>> optimizer;
         std::shared_ptr<NerfNetwork<precision_t>> network;
@@ -387,13 +397,26 @@ public:
     void reset_network(bool clear_density_grid = true);
     void reset_nerf_network(BlockNeRFModel& model);
     void set_block_nerf(BlockNeRFModel& model);
+    void reset_block_compositor();
     void load_nerf(const fs::path& data_path);
     void load_nerf_post();
-    void load_block_nerf_data(const fs::path& path, const std::string& block);
+    void load_block_nerf_data(const fs::path& path, const std::string& block,
+                              int downscale = 1);
+    void load_block_nerf_data(const fs::path& path,
+                              const BlockNerfFrames& frames,
+                              int downscale = 1);
     void load_mesh_for_density_grid(const fs::path& obj_path);
     void load_mesh(const fs::path& data_path);
     void load_point_cloud_for_density_grid(const fs::path& path);
+    void partition_street_view_nerf(const fs::path& path, int frames_per_block,
+                                    int overlap_frames);
+    cl::MemoryPlanner::Settings plan_street_view_memory(
+            const fs::path& path,
+            std::map<std::string, BlockNerfFrames>* block_frames = nullptr);
     void train_street_view_nerf(const fs::path& path);
+    void save_block_extrinsics(const fs::path& path);
+    void align_street_view_nerf(const fs::path& path);
+    void stitch_street_view_mesh(const fs::path& path);
     void save_block_nerf(const fs::path& path, bool compress);
     void load_block_nerf(const fs::path& path);
     void render_street_view_nerf(const fs::path& path);
@@ -487,6 +510,8 @@ public:
     bool begin_frame();
     void handle_user_input();
     void gather_histograms();
+    void record_parameter_telemetry(const fs::path& path);
+    void stop_parameter_telemetry();
     void draw_gui();
     bool frame();
     bool want_repl();
@@ -501,6 +526,9 @@ public:
     void set_fov_xy(const vec2& val);
     void save_snapshot(const fs::path& path, bool include_optimizer_state, bool compress);
     void load_snapshot(const fs::path& path);
+    void save_network_config(const fs::path& path, bool compress);
+    void compress_snapshot(nlohmann::json& snapshot);
+    void save_query_reference(const fs::path& path, uint32_t n_points);
     CameraKeyframe copy_camera_to_keyframe() const;
     void set_camera_from_keyframe(const CameraKeyframe& k);
     void set_camera_from_time(float t);
@@ -559,6 +587,9 @@ public:
 
     bool m_include_optimizer_state_in_snapshot = false;
     bool m_compress_snapshot = true;
+    // Quantizes and entropy codes the parameters and the density grid of
+    // saved snapshots, see snapshot_codec.h.
+    SnapshotCodec m_snapshot_codec;
     bool m_render_ground_truth = false;
     EGroundTruthRenderMode m_ground_truth_render_mode = EGroundTruthRenderMode::Shade;
     float m_ground_truth_alpha = 1.0f;
@@ -690,16 +721,17 @@ public:
             vec2 cam_focal_length_gradient = vec2(0.0f);
             tcnn::GPUMemory<vec2> cam_focal_length_gradient_gpu;
 
-            std::vector<AdamOptimizer<vec3>> cam_exposure;
-            std::vector<AdamOptimizer<vec3>> cam_pos_offset;
-            std::vector<RotationAdamOptimizer> cam_rot_offset;
+            // One optimizer per training image, stepped as a batch.
+            BatchedAdamOptimizer cam_exposure = BatchedAdamOptimizer(0, 3, false, 1e-3f);
+            BatchedAdamOptimizer cam_pos_offset = BatchedAdamOptimizer(0, 3, false, 1e-4f);
+            BatchedAdamOptimizer cam_rot_offset = BatchedAdamOptimizer(0, 3, true, 1e-4f);
             AdamOptimizer<vec2> cam_focal_length_offset = AdamOptimizer<vec2>(0.0f);
 
             // If the model demands a latent code per training image, we put
             // them in here.
             tcnn::GPUMemory<float> extra_dims_gpu;
             tcnn::GPUMemory<float> extra_dims_gradient_gpu;
-            std::vector<VarAdamOptimizer> extra_dims_opt;
+            BatchedAdamOptimizer extra_dims_opt;
 
             void reset_extra_dims(default_rng_t &rng);
 
@@ -971,6 +1003,7 @@ public:
         char extrinsics_path[MAX_PATH_LEN] = "extrinsics.json";
         char mesh_path[MAX_PATH_LEN] = "base.obj";
         char snapshot_path[MAX_PATH_LEN] = "base.ingp";
+        char telemetry_path[MAX_PATH_LEN] = "params.csv";
         char video_path[MAX_PATH_LEN] = "video.mp4";
     } m_imgui;
 
@@ -998,10 +1031,15 @@ public:
     float m_per_level_scale;
     float m_histo[257] = {};
     float m_histo_scale = 1.f;
+    // Snapshots of the levels and the first layer, analyzed asynchronously.
+    ParameterTelemetry m_parameter_telemetry;
+    ParameterTelemetryResult m_parameter_stats;
 
     uint32_t m_training_step = 0;
     int m_max_trainning_steps = 10000;
     uint32_t m_training_batch_size = 1 << 18;
+    // GPU memory budget of street views in bytes, 0 for no limit.
+    int64_t m_memory_budget = 0;
     Ema m_loss_scalar = {EEmaType::Time, 100};
     std::vector<float> m_loss_graph = std::vector<float>(256, 0.0f);
     size_t m_loss_graph_samples = 0;
@@ -1265,6 +1303,11 @@ public:
     int m_block_nerf_camera_speed = 5;
     cl::RPoint3D m_real_camera_pos;
     float m_block_blend_rate = 0.0f;
+    // Plans the blocks blended at each frame of the playback.
+    cl::point_cloud::BlockCompositor<double> m_block_compositor;
+    cl::point_cloud::BlockCompositor<double>::Frame m_block_frame;
+    // Share of a full-resolution frame given to the rendered block.
+    float m_block_render_budget = 1.0f;
 };
 
 NGP_NAMESPACE_END
@@ -219,6 +219,11 @@ uint16_t* load_stbi_16(const fs::path& path, int* width, int* height, int* comp,
 	return stbi_load_16_from_callbacks(&istream_stbi_callbacks, &f, width, height, comp, req_comp);
 }
 
+bool info_stbi(const fs::path& path, int* width, int* height, int* comp) {
+	std::ifstream f{native_string(path), std::ios::in | std::ios::binary};
+	return stbi_info_from_callbacks(&istream_stbi_callbacks, &f, width, height, comp);
+}
+
 bool is_hdr_stbi(const fs::path& path) {
 	std::ifstream f{native_string(path), std::ios::in | std::ios::binary};
 	return stbi_is_hdr_from_callbacks(&istream_stbi_callbacks, &f);
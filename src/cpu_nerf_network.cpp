@@ -0,0 +1,712 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   cpu_nerf_network.cpp
+ *  @brief  Host-side evaluation of the hash-grid NeRF stored in snapshots.
+ */
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/cpu_nerf_network.h>
+#include <neural-graphics-primitives/snapshot_codec.h>
+
+#include <fmt/core.h>
+
+#include "codelibrary/base/float.h"
+#include "codelibrary/math/matrix/gemm.h"
+
+#include <zstr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+using namespace nlohmann;
+
+NGP_NAMESPACE_BEGIN
+
+namespace {
+
+bool equals_ignore_case(const std::string& a, const std::string& b) {
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+		return std::tolower((unsigned char)x) == std::tolower((unsigned char)y);
+	});
+}
+
+uint32_t next_multiple(uint32_t value, uint32_t multiple) {
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+float half_to_float(uint16_t bits) {
+#if defined(__F16C__)
+	return _cvtsh_ss(bits);
+#else
+	return (float)cl::Half::FromBits(bits);
+#endif
+}
+
+float round_to_half(float value) {
+	return (float)cl::Half(value);
+}
+
+// Rounds each row of a row-major matrix to 8 bits with a symmetric scale.
+void round_rows_to_int8(std::vector<float>& matrix, uint32_t n_cols) {
+	for (size_t row = 0; row < matrix.size(); row += n_cols) {
+		float max_abs = 0.0f;
+		for (uint32_t i = 0; i < n_cols; ++i) {
+			max_abs = std::max(max_abs, std::abs(matrix[row + i]));
+		}
+		if (max_abs == 0.0f) {
+			continue;
+		}
+		float scale = max_abs / 127.0f;
+		for (uint32_t i = 0; i < n_cols; ++i) {
+			matrix[row + i] = std::round(matrix[row + i] / scale) * scale;
+		}
+	}
+}
+
+// The hidden and output layers of tcnn networks are stored with a width that
+// is a multiple of 16 (tensor-core tiles).
+constexpr uint32_t MLP_ALIGNMENT = 16;
+
+} // namespace
+
+size_t CpuNerfNetwork::Mlp::n_params() const {
+	size_t n = 0;
+	for (const auto& w : weights) {
+		n += w.size();
+	}
+	return n;
+}
+
+CpuNerfNetwork::EActivation CpuNerfNetwork::string_to_activation(const std::string& str) {
+	static const std::pair<const char*, EActivation> names[] = {
+		{"None", EActivation::None},
+		{"ReLU", EActivation::ReLU},
+		{"LeakyReLU", EActivation::LeakyReLU},
+		{"Exponential", EActivation::Exponential},
+		{"Sine", EActivation::Sine},
+		{"Sigmoid", EActivation::Sigmoid},
+		{"Squareplus", EActivation::Squareplus},
+		{"Softplus", EActivation::Softplus},
+		{"Tanh", EActivation::Tanh},
+	};
+	for (const auto& name : names) {
+		if (equals_ignore_case(str, name.first)) {
+			return name.second;
+		}
+	}
+	throw std::runtime_error{fmt::format("CpuNerfNetwork: invalid activation '{}'.", str)};
+}
+
+void CpuNerfNetwork::apply(EActivation activation, float* values, size_t n) {
+	// Same definitions as tcnn's activation().
+	switch (activation) {
+		case EActivation::None: break;
+		case EActivation::ReLU:
+			for (size_t i = 0; i < n; ++i) { values[i] = std::max(values[i], 0.0f); }
+			break;
+		case EActivation::LeakyReLU:
+			for (size_t i = 0; i < n; ++i) { values[i] = values[i] > 0.0f ? values[i] : values[i] * 0.01f; }
+			break;
+		case EActivation::Exponential:
+			for (size_t i = 0; i < n; ++i) { values[i] = std::exp(values[i]); }
+			break;
+		case EActivation::Sine:
+			for (size_t i = 0; i < n; ++i) { values[i] = std::sin(values[i]); }
+			break;
+		case EActivation::Sigmoid:
+			for (size_t i = 0; i < n; ++i) { values[i] = 1.0f / (1.0f + std::exp(-values[i])); }
+			break;
+		case EActivation::Squareplus:
+			for (size_t i = 0; i < n; ++i) {
+				float x = values[i] * 10.0f;
+				values[i] = 0.05f * (x + std::sqrt(x * x + 4.0f));
+			}
+			break;
+		case EActivation::Softplus:
+			for (size_t i = 0; i < n; ++i) { values[i] = std::log(std::exp(values[i] * 10.0f) + 1.0f) * 0.1f; }
+			break;
+		case EActivation::Tanh:
+			for (size_t i = 0; i < n; ++i) { values[i] = std::tanh(values[i]); }
+			break;
+	}
+}
+
+CpuNerfNetwork::CpuNerfNetwork(const json& config, ECpuWeightPrecision precision, size_t n_threads)
+: m_precision{precision} {
+	if (!config.contains("snapshot")) {
+		throw std::runtime_error{"CpuNerfNetwork: the network config does not contain a snapshot."};
+	}
+
+	const json& snapshot = config["snapshot"];
+	if (snapshot.contains("mode") && !equals_ignore_case(snapshot["mode"].get<std::string>(), "nerf")) {
+		throw std::runtime_error{"CpuNerfNetwork: the snapshot is not a NeRF."};
+	}
+	if (snapshot.contains("nerf") && snapshot["nerf"].contains("dataset")) {
+		const json& dataset = snapshot["nerf"]["dataset"];
+		if (dataset.value("n_extra_learnable_dims", 0) > 0 || dataset.value("has_light_dirs", false)) {
+			throw std::runtime_error{"CpuNerfNetwork: extra network dims are not supported."};
+		}
+	}
+
+	std::vector<float> params = SnapshotCodec::params_from_json(snapshot);
+
+	// Hash grid, with the defaults of Testbed::reset_network() and tcnn.
+	const json& encoding = config.value("encoding", json::object());
+	std::string encoding_type = encoding.value("otype", "HashGrid");
+	if (equals_ignore_case(encoding_type, "HashGrid") || equals_ignore_case(encoding_type, "Grid")) {
+		m_hash = equals_ignore_case(encoding.value("type", "Hash"), "Hash");
+		if (!m_hash && !equals_ignore_case(encoding.value("type", "Hash"), "Dense")) {
+			throw std::runtime_error{"CpuNerfNetwork: tiled grids are not supported."};
+		}
+	} else if (equals_ignore_case(encoding_type, "DenseGrid")) {
+		m_hash = false;
+	} else {
+		throw std::runtime_error{fmt::format("CpuNerfNetwork: encoding '{}' is not supported.", encoding_type)};
+	}
+
+	m_n_features_per_level = encoding.value("n_features_per_level", 2u);
+	if (encoding.contains("n_features") && encoding["n_features"] > 0) {
+		m_n_levels = (uint32_t)encoding["n_features"] / m_n_features_per_level;
+	} else {
+		m_n_levels = encoding.value("n_levels", 16u);
+	}
+
+	// The testbed derives a missing base resolution from a default table size
+	// of 2^15, while the encoding itself defaults to 2^19.
+	uint32_t log2_hashmap_size = encoding.value("log2_hashmap_size", 19u);
+	m_base_resolution = encoding.value("base_resolution", 0u);
+	if (m_base_resolution == 0) {
+		m_base_resolution = 1u << (encoding.value("log2_hashmap_size", 15u) / 3);
+	}
+	m_log2_per_level_scale = std::log2(encoding.value("per_level_scale", 2.0f));
+
+	std::string hash = encoding.value("hash", "CoherentPrime");
+	if (equals_ignore_case(hash, "Prime")) {
+		m_hash_type = EHashType::Prime;
+	} else if (equals_ignore_case(hash, "CoherentPrime")) {
+		m_hash_type = EHashType::CoherentPrime;
+	} else if (equals_ignore_case(hash, "ReversedPrime")) {
+		m_hash_type = EHashType::ReversedPrime;
+	} else {
+		throw std::runtime_error{fmt::format("CpuNerfNetwork: hash '{}' is not supported.", hash)};
+	}
+
+	std::string interpolation = encoding.value("interpolation", "Linear");
+	m_smoothstep = equals_ignore_case(interpolation, "Smoothstep");
+	m_nearest = equals_ignore_case(interpolation, "Nearest");
+
+	m_level_offsets.resize(m_n_levels + 1, 0);
+	m_level_scales.resize(m_n_levels);
+	m_level_resolutions.resize(m_n_levels);
+	for (uint32_t level = 0; level < m_n_levels; ++level) {
+		// Same as grid_scale() and grid_resolution() of tcnn.
+		float scale = std::exp2(level * m_log2_per_level_scale) * m_base_resolution - 1.0f;
+		uint32_t resolution = (uint32_t)std::ceil(scale) + 1;
+		m_level_scales[level] = scale;
+		m_level_resolutions[level] = resolution;
+
+		uint32_t max_params = std::numeric_limits<uint32_t>::max() / 2;
+		uint32_t params_in_level = std::pow((float)resolution, 3.0f) > (float)max_params ? max_params : resolution * resolution * resolution;
+		params_in_level = next_multiple(params_in_level, 8u);
+		if (m_hash) {
+			params_in_level = std::min(params_in_level, 1u << log2_hashmap_size);
+		}
+		m_level_offsets[level + 1] = m_level_offsets[level] + params_in_level;
+	}
+	m_encoding_width = next_multiple(m_n_levels * m_n_features_per_level, MLP_ALIGNMENT);
+
+	// Direction encoding: spherical harmonics, possibly nested in a composite
+	// encoding whose other members encode no dims.
+	json dir_encoding = config.value("dir_encoding", json::object());
+	bool composite = equals_ignore_case(dir_encoding.value("otype", ""), "Composite");
+	if (composite) {
+		const json& nested = dir_encoding.value("nested", json::array());
+		if (nested.empty()) {
+			throw std::runtime_error{"CpuNerfNetwork: empty composite direction encoding."};
+		}
+		for (size_t i = 1; i < nested.size(); ++i) {
+			if (nested[i].value("n_dims_to_encode", 0u) > 0) {
+				throw std::runtime_error{"CpuNerfNetwork: only spherical harmonics are supported as direction encoding."};
+			}
+		}
+		dir_encoding = nested[0];
+	}
+	if (!equals_ignore_case(dir_encoding.value("otype", ""), "SphericalHarmonics")) {
+		throw std::runtime_error{"CpuNerfNetwork: only spherical harmonics are supported as direction encoding."};
+	}
+	m_sh_degree = dir_encoding.value("degree", 4u);
+	if (m_sh_degree < 1 || m_sh_degree > 4) {
+		throw std::runtime_error{"CpuNerfNetwork: spherical harmonics degree must be 1 to 4."};
+	}
+	m_dir_width = next_multiple(m_sh_degree * m_sh_degree, MLP_ALIGNMENT);
+	m_dir_padding = m_dir_width - m_sh_degree * m_sh_degree;
+	if (composite && m_dir_padding > 0) {
+		throw std::runtime_error{"CpuNerfNetwork: padded composite direction encodings are not supported."};
+	}
+
+	// MLPs, in the order of NerfNetwork::set_params_impl(): density network,
+	// rgb network, position encoding (the direction encoding has no params).
+	const json& network = config.value("network", json::object());
+	uint32_t density_output_width = network.value("n_output_dims", 16u);
+
+	size_t offset = 0;
+	read_mlp(network, m_encoding_width, density_output_width, params, &offset, &m_density_network);
+	m_rgb_input_width = next_multiple(m_density_network.padded_output_width + m_dir_width, MLP_ALIGNMENT);
+	read_mlp(config.value("rgb_network", json::object()), m_rgb_input_width, 3, params, &offset, &m_rgb_network);
+
+	size_t n_grid_params = (size_t)m_level_offsets.back() * m_n_features_per_level;
+	if (offset + n_grid_params != params.size()) {
+		throw std::runtime_error{fmt::format(
+			"CpuNerfNetwork: the config describes {} params, but the snapshot has {}.",
+			offset + n_grid_params, params.size()
+		)};
+	}
+	m_n_params = params.size();
+	store_grid(params.data() + offset);
+
+	m_pool.reset(n_threads > 0 ? new ThreadPool{n_threads} : new ThreadPool{});
+}
+
+void CpuNerfNetwork::read_mlp(const json& config, uint32_t input_width, uint32_t output_width, const std::vector<float>& params, size_t* offset, Mlp* mlp) const {
+	std::string type = config.value("otype", "FullyFusedMLP");
+	if (!equals_ignore_case(type, "FullyFusedMLP")) {
+		throw std::runtime_error{fmt::format("CpuNerfNetwork: network '{}' is not supported.", type)};
+	}
+
+	mlp->input_width = input_width;
+	mlp->width = config.value("n_neurons", 128u);
+	mlp->padded_output_width = next_multiple(output_width, MLP_ALIGNMENT);
+	mlp->activation = string_to_activation(config.value("activation", "ReLU"));
+	mlp->output_activation = string_to_activation(config.value("output_activation", "None"));
+
+	uint32_t n_hidden_layers = config.value("n_hidden_layers", 5u);
+	if (n_hidden_layers == 0) {
+		throw std::runtime_error{"CpuNerfNetwork: FullyFusedMLP needs at least one hidden layer."};
+	}
+
+	// Same layout as FullyFusedMLP: one input matrix, n_hidden_layers - 1
+	// hidden matrices and one output matrix, all row-major.
+	std::vector<std::pair<uint32_t, uint32_t>> sizes;
+	sizes.emplace_back(mlp->width, input_width);
+	for (uint32_t i = 1; i < n_hidden_layers; ++i) {
+		sizes.emplace_back(mlp->width, mlp->width);
+	}
+	sizes.emplace_back(mlp->padded_output_width, mlp->width);
+
+	mlp->weights.clear();
+	for (const auto& size : sizes) {
+		size_t n = (size_t)size.first * size.second;
+		if (*offset + n > params.size()) {
+			throw std::runtime_error{"CpuNerfNetwork: the snapshot has fewer params than the config describes."};
+		}
+
+		std::vector<float> matrix(params.begin() + *offset, params.begin() + *offset + n);
+		if (m_precision == ECpuWeightPrecision::Half) {
+			for (float& w : matrix) {
+				w = round_to_half(w);
+			}
+		} else if (m_precision == ECpuWeightPrecision::Int8) {
+			round_rows_to_int8(matrix, size.second);
+		}
+		mlp->weights.emplace_back(std::move(matrix));
+		*offset += n;
+	}
+}
+
+void CpuNerfNetwork::store_grid(const float* params) {
+	size_t n = (size_t)m_level_offsets.back() * m_n_features_per_level;
+	switch (m_precision) {
+		case ECpuWeightPrecision::Float:
+			m_grid.assign(params, params + n);
+			break;
+		case ECpuWeightPrecision::Half:
+			m_grid_half.resize(n);
+			for (size_t i = 0; i < n; ++i) {
+				m_grid_half[i] = cl::Half(params[i]).bits();
+			}
+			break;
+		case ECpuWeightPrecision::Int8:
+			m_grid_int8.resize(n);
+			m_int8_scales.resize(m_n_levels);
+			m_int8_offsets.resize(m_n_levels);
+			for (uint32_t level = 0; level < m_n_levels; ++level) {
+				size_t begin = (size_t)m_level_offsets[level] * m_n_features_per_level;
+				size_t end = (size_t)m_level_offsets[level + 1] * m_n_features_per_level;
+				auto range = std::minmax_element(params + begin, params + end);
+				float min = *range.first, max = *range.second;
+				float scale = max > min ? (max - min) / 255.0f : 1.0f;
+				for (size_t i = begin; i < end; ++i) {
+					m_grid_int8[i] = (uint8_t)std::lround((params[i] - min) / scale);
+				}
+				m_int8_scales[level] = scale;
+				m_int8_offsets[level] = min;
+			}
+			break;
+	}
+}
+
+size_t CpuNerfNetwork::n_bytes() const {
+	size_t n = (m_density_network.n_params() + m_rgb_network.n_params()) * sizeof(float);
+	n += m_grid.size() * sizeof(float) + m_grid_half.size() * sizeof(uint16_t) + m_grid_int8.size();
+	return n;
+}
+
+template <typename FETCH>
+void CpuNerfNetwork::encode_level(uint32_t level, const float* positions, uint32_t n, FETCH fetch, float* out) const {
+	const uint32_t F = m_n_features_per_level;
+	const uint32_t hashmap_size = m_level_offsets[level + 1] - m_level_offsets[level];
+	const uint32_t resolution = m_level_resolutions[level];
+	const float scale = m_level_scales[level];
+	const size_t level_offset = (size_t)m_level_offsets[level] * F;
+
+	uint32_t primes[3];
+	switch (m_hash_type) {
+		case EHashType::Prime: primes[0] = 1958374283u; primes[1] = 2654435761u; primes[2] = 805459861u; break;
+		case EHashType::CoherentPrime: primes[0] = 1u; primes[1] = 2654435761u; primes[2] = 805459861u; break;
+		case EHashType::ReversedPrime: primes[0] = 2165219737u; primes[1] = 1434869437u; primes[2] = 2097192037u; break;
+	}
+
+	// Same as grid_index() of tcnn, including the uint32 wraparound. Both the
+	// dense index and the hash are sums (xors) of one term per dim, so the
+	// terms of the two neighbors along each dim are computed once per point.
+	const bool use_hash = m_hash && (uint64_t)resolution * resolution * resolution > hashmap_size;
+	const uint32_t mask = (hashmap_size & (hashmap_size - 1)) == 0 ? hashmap_size - 1 : 0;
+	const uint32_t strides[3] = {1, resolution, resolution * resolution};
+	auto index = [&](uint32_t x, uint32_t y, uint32_t z) {
+		uint32_t idx = use_hash ? (x ^ y ^ z) : (x + y + z);
+		idx = mask ? (idx & mask) : (idx % hashmap_size);
+		return level_offset + (size_t)idx * F;
+	};
+
+	float features[16];
+	for (uint32_t i = 0; i < n; ++i) {
+		float weights[3][2];
+		uint32_t terms[3][2];
+		for (uint32_t dim = 0; dim < 3; ++dim) {
+			float p = positions[i * 3 + dim] * scale + 0.5f;
+			float p_floor = std::floor(p);
+			uint32_t pos_grid = (uint32_t)(int)p_floor;
+			float t = p - p_floor;
+			if (m_smoothstep) {
+				t = t * t * (3.0f - 2.0f * t);
+			}
+			weights[dim][0] = 1.0f - t;
+			weights[dim][1] = t;
+			for (uint32_t k = 0; k < 2; ++k) {
+				terms[dim][k] = (pos_grid + k) * (use_hash ? primes[dim] : strides[dim]);
+			}
+		}
+
+		if (m_nearest) {
+			size_t idx = index(terms[0][0], terms[1][0], terms[2][0]);
+			for (uint32_t f = 0; f < F; ++f) {
+				out[f * n + i] = fetch(idx + f);
+			}
+			continue;
+		}
+
+		std::fill(features, features + F, 0.0f);
+		for (uint32_t corner = 0; corner < 8; ++corner) {
+			uint32_t cx = corner & 1, cy = (corner >> 1) & 1, cz = corner >> 2;
+			float weight = weights[0][cx] * weights[1][cy] * weights[2][cz];
+			size_t idx = index(terms[0][cx], terms[1][cy], terms[2][cz]);
+			for (uint32_t f = 0; f < F; ++f) {
+				features[f] += weight * fetch(idx + f);
+			}
+		}
+		for (uint32_t f = 0; f < F; ++f) {
+			out[f * n + i] = features[f];
+		}
+	}
+}
+
+void CpuNerfNetwork::encode_positions(const float* positions, uint32_t n, float* out) const {
+	const uint32_t F = m_n_features_per_level;
+	std::fill(out, out + (size_t)m_encoding_width * n, 0.0f);
+
+	for (uint32_t level = 0; level < m_n_levels; ++level) {
+		// Levels above the max level are zero, as in GridEncoding.
+		if (level >= max_level * m_n_levels + 1e-3f) {
+			break;
+		}
+
+		float* level_out = out + (size_t)level * F * n;
+		switch (m_precision) {
+			case ECpuWeightPrecision::Float: {
+				const float* grid = m_grid.data();
+				encode_level(level, positions, n, [grid](size_t i) { return grid[i]; }, level_out);
+			} break;
+			case ECpuWeightPrecision::Half: {
+				const uint16_t* grid = m_grid_half.data();
+				encode_level(level, positions, n, [grid](size_t i) { return half_to_float(grid[i]); }, level_out);
+			} break;
+			case ECpuWeightPrecision::Int8: {
+				// The interpolation weights sum to one, so the codes are
+				// interpolated and mapped back once per feature.
+				const uint8_t* grid = m_grid_int8.data();
+				encode_level(level, positions, n, [grid](size_t i) { return (float)grid[i]; }, level_out);
+				float scale = m_int8_scales[level], offset = m_int8_offsets[level];
+				for (size_t i = 0; i < (size_t)F * n; ++i) {
+					level_out[i] = offset + scale * level_out[i];
+				}
+			} break;
+		}
+	}
+}
+
+void CpuNerfNetwork::encode_directions(const float* directions, uint32_t n, float* out) const {
+	// Padding goes first and is one, as in tcnn's SphericalHarmonicsEncoding.
+	std::fill(out, out + (size_t)m_dir_padding * n, 1.0f);
+	float* sh = out + (size_t)m_dir_padding * n;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		float x = directions[i * 3], y = directions[i * 3 + 1], z = directions[i * 3 + 2];
+		float xy = x * y, xz = x * z, yz = y * z, x2 = x * x, y2 = y * y, z2 = z * z;
+
+		sh[0 * n + i] = 0.28209479177387814f;
+		if (m_sh_degree <= 1) { continue; }
+		sh[1 * n + i] = -0.48860251190291987f * y;
+		sh[2 * n + i] = 0.48860251190291987f * z;
+		sh[3 * n + i] = -0.48860251190291987f * x;
+		if (m_sh_degree <= 2) { continue; }
+		sh[4 * n + i] = 1.0925484305920792f * xy;
+		sh[5 * n + i] = -1.0925484305920792f * yz;
+		sh[6 * n + i] = 0.94617469575755997f * z2 - 0.31539156525251999f;
+		sh[7 * n + i] = -1.0925484305920792f * xz;
+		sh[8 * n + i] = 0.54627421529603959f * x2 - 0.54627421529603959f * y2;
+		if (m_sh_degree <= 3) { continue; }
+		sh[9 * n + i] = 0.59004358992664352f * y * (-3.0f * x2 + y2);
+		sh[10 * n + i] = 2.8906114426405538f * xy * z;
+		sh[11 * n + i] = 0.45704579946446572f * y * (1.0f - 5.0f * z2);
+		sh[12 * n + i] = 0.3731763325901154f * z * (5.0f * z2 - 3.0f);
+		sh[13 * n + i] = 0.45704579946446572f * x * (1.0f - 5.0f * z2);
+		sh[14 * n + i] = 1.4453057213202769f * z * (x2 - y2);
+		sh[15 * n + i] = 0.59004358992664352f * x * (-x2 + 3.0f * y2);
+	}
+}
+
+const float* CpuNerfNetwork::run_mlp(const Mlp& mlp, const float* input, uint32_t n, Workspace& ws, float* out) const {
+	const float* x = input;
+	uint32_t x_width = mlp.input_width;
+	for (size_t layer = 0; layer < mlp.weights.size(); ++layer) {
+		bool last = layer + 1 == mlp.weights.size();
+		uint32_t y_width = last ? mlp.padded_output_width : mlp.width;
+
+		float* y;
+		if (last && out) {
+			y = out;
+		} else {
+			auto& buffer = ws.hidden[layer % 2];
+			buffer.resize((size_t)y_width * n);
+			y = buffer.data();
+		}
+
+		cl::blas::GEMM((int)y_width, (int)x_width, (int)n, mlp.weights[layer].data(), x, y);
+		apply(last ? mlp.output_activation : mlp.activation, y, (size_t)y_width * n);
+
+		x = y;
+		x_width = y_width;
+	}
+	return x;
+}
+
+void CpuNerfNetwork::inference_batch(const float* positions, const float* directions, uint32_t n, float* rgbd, Workspace& ws) const {
+	ws.encoded.resize((size_t)m_encoding_width * n);
+	encode_positions(positions, n, ws.encoded.data());
+
+	// The density output is the first rows of the rgb network input.
+	ws.rgb_in.assign((size_t)m_rgb_input_width * n, 0.0f);
+	const float* density_out = run_mlp(m_density_network, ws.encoded.data(), n, ws, ws.rgb_in.data());
+
+	if (!directions) {
+		for (uint32_t i = 0; i < n; ++i) {
+			rgbd[i] = density_out[i];
+		}
+		return;
+	}
+
+	encode_directions(directions, n, ws.rgb_in.data() + (size_t)m_density_network.padded_output_width * n);
+
+	ws.rgb_out.resize((size_t)m_rgb_network.padded_output_width * n);
+	const float* rgb_out = run_mlp(m_rgb_network, ws.rgb_in.data(), n, ws, ws.rgb_out.data());
+
+	for (uint32_t i = 0; i < n; ++i) {
+		rgbd[i * 4 + 0] = rgb_out[0 * n + i];
+		rgbd[i * 4 + 1] = rgb_out[1 * n + i];
+		rgbd[i * 4 + 2] = rgb_out[2 * n + i];
+		rgbd[i * 4 + 3] = density_out[i];
+	}
+}
+
+template <typename F>
+void CpuNerfNetwork::for_each_batch(size_t n, F body) {
+	size_t n_batches = (n + BATCH_SIZE - 1) / BATCH_SIZE;
+	auto run = [&](size_t batch) {
+		thread_local Workspace ws;
+		size_t begin = batch * BATCH_SIZE;
+		body(begin, (uint32_t)std::min<size_t>(BATCH_SIZE, n - begin), ws);
+	};
+
+	if (n_batches <= 1) {
+		for (size_t batch = 0; batch < n_batches; ++batch) {
+			run(batch);
+		}
+	} else {
+		m_pool->parallel_for<size_t>(0, n_batches, run);
+	}
+}
+
+void CpuNerfNetwork::density(const float* positions, size_t n, float* density) {
+	for_each_batch(n, [&](size_t begin, uint32_t count, Workspace& ws) {
+		inference_batch(positions + begin * 3, nullptr, count, density + begin, ws);
+	});
+}
+
+void CpuNerfNetwork::inference(const float* positions, const float* directions, size_t n, float* rgbd) {
+	for_each_batch(n, [&](size_t begin, uint32_t count, Workspace& ws) {
+		inference_batch(positions + begin * 3, directions + begin * 3, count, rgbd + begin * 4, ws);
+	});
+}
+
+void CpuNerfNetwork::query(const float* positions, const float* directions, size_t n, float* rgbd) {
+	inference(positions, directions, n, rgbd);
+
+	// Same as network_to_rgb() and network_to_density().
+	auto activate = [](float v, ENerfActivation activation, bool clamp) {
+		switch (activation) {
+			case ENerfActivation::None: return v;
+			case ENerfActivation::ReLU: return std::max(v, 0.0f);
+			case ENerfActivation::Logistic: return 1.0f / (1.0f + std::exp(-v));
+			case ENerfActivation::Exponential: return std::exp(clamp ? std::min(std::max(v, -10.0f), 10.0f) : v);
+		}
+		return v;
+	};
+	for (size_t i = 0; i < n; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			rgbd[i * 4 + c] = activate(rgbd[i * 4 + c], rgb_activation, true);
+		}
+		rgbd[i * 4 + 3] = activate(rgbd[i * 4 + 3], density_activation, false);
+	}
+}
+
+json CpuNerfNetwork::load_network_config(const fs::path& path) {
+	if (!path.exists()) {
+		throw std::runtime_error{fmt::format("Snapshot '{}' does not exist.", path.str())};
+	}
+
+	json result;
+	std::ifstream f{native_string(path), std::ios::in | std::ios::binary};
+	if (equals_ignore_case(path.extension(), "ingp")) {
+		// zstr::ifstream applies zlib compression.
+		zstr::istream zf{f};
+		result = json::from_msgpack(zf);
+	} else {
+		result = json::from_msgpack(f);
+	}
+	if (result.contains("snapshot")) {
+		decode_snapshot_codecs(result["snapshot"]);
+	}
+	return result;
+}
+
+bool check_cpu_nerf_network(const fs::path& reference, size_t n_threads) {
+	json config = CpuNerfNetwork::load_network_config(reference);
+	if (!config.contains("query_reference")) {
+		throw std::runtime_error{fmt::format("'{}' does not contain query references.", reference.str())};
+	}
+
+	const json& queries = config["query_reference"];
+	auto read_floats = [&](const char* key) {
+		const auto& bytes = queries[key].get_binary();
+		std::vector<float> values(bytes.size() / sizeof(float));
+		std::memcpy(values.data(), bytes.data(), values.size() * sizeof(float));
+		return values;
+	};
+	std::vector<float> positions = read_floats("positions");
+	std::vector<float> directions = read_floats("directions");
+	std::vector<float> expected = read_floats("rgbd");
+	size_t n = positions.size() / 3;
+	if (directions.size() != n * 3 || expected.size() != n * 4) {
+		throw std::runtime_error{"Query references have inconsistent sizes."};
+	}
+
+	// The GPU evaluates the network in fp16. Rounding the weights to 8 bits
+	// moves the outputs by a few percent of their range.
+	struct Tolerance {
+		ECpuWeightPrecision precision;
+		float absolute, relative;
+	};
+	const Tolerance tolerances[] = {
+		{ECpuWeightPrecision::Float, 0.05f, 0.02f},
+		{ECpuWeightPrecision::Half, 0.05f, 0.02f},
+		{ECpuWeightPrecision::Int8, 0.5f, 0.1f},
+	};
+
+	bool passed = true;
+	for (const auto& tolerance : tolerances) {
+		CpuNerfNetwork network{config, tolerance.precision, n_threads};
+		network.max_level = queries.value("max_level", 1.0f);
+
+		std::vector<float> rgbd(n * 4);
+		auto start = std::chrono::steady_clock::now();
+		network.inference(positions.data(), directions.data(), n, rgbd.data());
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		float max_error = 0.0f;
+		size_t n_failed = 0;
+		for (size_t i = 0; i < rgbd.size(); ++i) {
+			float error = std::abs(rgbd[i] - expected[i]);
+			max_error = std::max(max_error, error);
+			if (!(error <= tolerance.absolute + tolerance.relative * std::abs(expected[i]))) {
+				++n_failed;
+			}
+		}
+
+		// Throughput on a larger set of queries, reusing the reference points.
+		const size_t n_benchmark = std::max<size_t>(n, 1 << 20);
+		std::vector<float> bench_positions(n_benchmark * 3), bench_directions(n_benchmark * 3);
+		for (size_t i = 0; i < n_benchmark * 3; ++i) {
+			bench_positions[i] = positions[i % (n * 3)];
+			bench_directions[i] = directions[i % (n * 3)];
+		}
+		std::vector<float> bench_rgbd(n_benchmark * 4), bench_density(n_benchmark);
+		start = std::chrono::steady_clock::now();
+		network.inference(bench_positions.data(), bench_directions.data(), n_benchmark, bench_rgbd.data());
+		double inference_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		start = std::chrono::steady_clock::now();
+		network.density(bench_positions.data(), n_benchmark, bench_density.data());
+		double density_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const char* name = tolerance.precision == ECpuWeightPrecision::Float ? "float" : (tolerance.precision == ECpuWeightPrecision::Half ? "half" : "int8");
+		tlog::info() << fmt::format(
+			"CPU network ({}, {:.1f} MB): max error {:.4f}, {} of {} outputs out of tolerance, {:.2f}M points/s (color), {:.2f}M points/s (density), {:.1f} ms for the references",
+			name, network.n_bytes() / 1e6, max_error, n_failed, rgbd.size(),
+			n_benchmark / inference_seconds / 1e6, n_benchmark / density_seconds / 1e6, seconds * 1e3
+		);
+
+		if (n_failed > 0) {
+			tlog::error() << fmt::format("CPU network ({}) does not match the GPU references.", name);
+			passed = false;
+		}
+	}
+
+	return passed;
+}
+
+NGP_NAMESPACE_END
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   cpu_tonemap.cpp
+ *  @brief  Host-side accumulation and tonemapping of RGBA render buffers.
+ */
+
+#include <neural-graphics-primitives/cpu_tonemap.h>
+
+#include "codelibrary/image/tonemapper.h"
+
+#include <cstdint>
+
+NGP_NAMESPACE_BEGIN
+
+namespace {
+
+// The codelibrary enums have the same order as the ones of the testbed.
+cl::image::ColorSpace to_cl(EColorSpace color_space) {
+	return (cl::image::ColorSpace)color_space;
+}
+
+cl::image::ToneCurve to_cl(ETonemapCurve curve) {
+	return (cl::image::ToneCurve)curve;
+}
+
+}
+
+void cpu_accumulate(const float* frame, const ivec2& resolution, int sample_count, EColorSpace color_space, float* accumulation) {
+	cl::image::Accumulate(resolution.x, resolution.y, frame, sample_count, to_cl(color_space), accumulation);
+}
+
+void cpu_tonemap(const float* rgba, const ivec2& resolution, const CpuTonemapSettings& settings, ECpuImageFormat format, void* out) {
+	cl::image::Tonemapper::Options options;
+	options.exposure = settings.exposure;
+	options.color_space = to_cl(settings.color_space);
+	options.output_color_space = to_cl(settings.output_color_space);
+	options.curve = to_cl(settings.tonemap_curve);
+	for (int i = 0; i < 4; ++i) {
+		options.background[i] = settings.background_color[i];
+	}
+	options.unmultiply_alpha = settings.unmultiply_alpha;
+	options.clamp_output = settings.clamp_output_color;
+
+	cl::image::Tonemapper tonemapper{options};
+	switch (format) {
+		case ECpuImageFormat::Float: tonemapper.Tonemap(resolution.x, resolution.y, rgba, (float*)out); break;
+		case ECpuImageFormat::Half: tonemapper.Tonemap(resolution.x, resolution.y, rgba, (cl::Half*)out); break;
+		case ECpuImageFormat::UInt16: tonemapper.Tonemap(resolution.x, resolution.y, rgba, (uint16_t*)out); break;
+		case ECpuImageFormat::UInt8: tonemapper.Tonemap(resolution.x, resolution.y, rgba, (uint8_t*)out); break;
+		default: throw std::runtime_error{"cpu_tonemap: unknown image format."};
+	}
+}
+
+NGP_NAMESPACE_END
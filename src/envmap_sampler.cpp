@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   envmap_sampler.cpp
+ *  @brief  Host-side construction of envmap importance-sampling tables, mip
+ *          pyramids and cubemaps.
+ */
+
+#include <neural-graphics-primitives/envmap_sampler.h>
+#include <neural-graphics-primitives/thread_pool.h>
+
+#include <fmt/core.h>
+
+#include "codelibrary/image/environment_map.h"
+
+NGP_NAMESPACE_BEGIN
+
+namespace {
+
+float luminance(const vec4& rgba) {
+	return fmaxf(0.2126f * rgba.r + 0.7152f * rgba.g + 0.0722f * rgba.b, 0.0f);
+}
+
+// Texels of the envmap closer to the poles cover a smaller solid angle.
+float solid_angle_weight(float v) {
+	return sinf(pi<float>() * fminf(fmaxf(v, 0.0f), 1.0f));
+}
+
+vec3 to_ngp(const cl::FVector3D& d) {
+	return {d.x, d.y, d.z};
+}
+
+cl::FVector3D to_cl(const vec3& d) {
+	return {d.x, d.y, d.z};
+}
+
+}
+
+void EnvmapSampler::build(const vec4* envmap, const ivec2& resolution, ivec2 distribution_resolution) {
+	if (resolution.x < 2 || resolution.y < 2) {
+		throw std::runtime_error{fmt::format("EnvmapSampler: envmap resolution must be at least 2x2, but is {}x{}.", resolution.x, resolution.y)};
+	}
+
+	if (distribution_resolution.x <= 0 || distribution_resolution.y <= 0) {
+		distribution_resolution = resolution;
+	}
+
+	ThreadPool pool;
+
+	// Mip pyramid. Every texel of a level averages 2x2 bilinear lookups into
+	// the previous one, weighted by their solid angle.
+	m_levels.clear();
+	m_level_resolutions.clear();
+	m_levels.emplace_back(envmap, envmap + compMul(resolution));
+	m_level_resolutions.emplace_back(resolution);
+
+	while (m_levels.size() < EnvmapMipmap::MAX_LEVELS && (m_level_resolutions.back().x > 2 || m_level_resolutions.back().y > 2)) {
+		const ivec2 prev_res = m_level_resolutions.back();
+		const ivec2 res = max(prev_res / 2, ivec2(2));
+		const Buffer2DView<const vec4> prev = {m_levels.back().data(), prev_res};
+
+		std::vector<vec4> level(compMul(res));
+		const vec2 offset = 0.25f / vec2(res - 1);
+		pool.parallel_for<int>(0, res.y, [&](int y) {
+			for (int x = 0; x < res.x; ++x) {
+				const vec2 uv = vec2(x, y) / vec2(res - 1);
+				vec4 sum = vec4(0.0f);
+				float weight_sum = 0.0f;
+				for (int dy = -1; dy <= 1; dy += 2) {
+					const float v = fminf(fmaxf(uv.y + dy * offset.y, 0.0f), 1.0f);
+					const float weight = solid_angle_weight(v) + 1e-6f;
+					for (int dx = -1; dx <= 1; dx += 2) {
+						float u = uv.x + dx * offset.x;
+						u -= floorf(u);
+						sum += weight * read_envmap_uv(prev, {u, v});
+						weight_sum += weight;
+					}
+				}
+				level[x + y * res.x] = sum / weight_sum;
+			}
+		});
+
+		m_levels.emplace_back(std::move(level));
+		m_level_resolutions.emplace_back(res);
+	}
+
+	// Importance-sampling tables over the distribution cells, weighted by the
+	// luminance of the envmap at their centers and their solid angle.
+	const Buffer2DView<const vec4> view = {envmap, resolution};
+	std::vector<float> weights(compMul(distribution_resolution));
+	pool.parallel_for<int>(0, distribution_resolution.y, [&](int y) {
+		for (int x = 0; x < distribution_resolution.x; ++x) {
+			const vec2 uv = (vec2(x, y) + 0.5f) / vec2(distribution_resolution);
+			weights[x + y * distribution_resolution.x] = luminance(read_envmap_uv(view, uv)) * solid_angle_weight(uv.y);
+		}
+	});
+
+	cl::image::Distribution2D distribution{distribution_resolution.x, distribution_resolution.y, weights.data()};
+	m_marginal_cdf.assign(distribution.marginal_cdf().begin(), distribution.marginal_cdf().end());
+	m_conditional_cdf.assign(distribution.conditional_cdf().begin(), distribution.conditional_cdf().end());
+	m_distribution_resolution = distribution_resolution;
+}
+
+EnvmapDistribution EnvmapSampler::distribution() const {
+	if (empty()) {
+		return {};
+	}
+
+	return {m_marginal_cdf.data(), m_conditional_cdf.data(), m_distribution_resolution};
+}
+
+EnvmapMipmap EnvmapSampler::mipmap() const {
+	EnvmapMipmap result;
+	result.n_levels = n_levels();
+	for (uint32_t i = 0; i < result.n_levels; ++i) {
+		result.levels[i] = {m_levels[i].data(), m_level_resolutions[i]};
+	}
+
+	return result;
+}
+
+std::vector<vec4> EnvmapSampler::to_cubemap(uint32_t size) const {
+	if (empty()) {
+		throw std::runtime_error{"EnvmapSampler: to_cubemap() requires build() to be called first."};
+	}
+
+	if (size == 0) {
+		throw std::runtime_error{"EnvmapSampler: cubemap faces must not be empty."};
+	}
+
+	// Supersample the faces when the envmap has more texels than them.
+	const ivec2 resolution = m_level_resolutions.front();
+	const float texels_per_face_texel = (float)resolution.x / (4.0f * (float)size);
+	const int n_samples = clamp((int)ceilf(texels_per_face_texel), 1, 8);
+
+	const Buffer2DView<const vec4> view = {m_levels.front().data(), resolution};
+	cl::Array<cl::ImageF> faces;
+	cl::image::RenderCubemap((int)size, 4, n_samples, [&](const cl::FVector3D& d, float* out) {
+		const vec4 rgba = read_envmap_uv(view, envmap_uv(to_ngp(d)));
+		for (int i = 0; i < 4; ++i) {
+			out[i] = rgba[i];
+		}
+	}, &faces);
+
+	std::vector<vec4> result(6 * (size_t)size * size);
+	for (uint32_t f = 0; f < 6; ++f) {
+		for (uint32_t y = 0; y < size; ++y) {
+			for (uint32_t x = 0; x < size; ++x) {
+				vec4& rgba = result[((size_t)f * size + y) * size + x];
+				for (int i = 0; i < 4; ++i) {
+					rgba[i] = faces[f](y, x, i);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+std::vector<vec4> EnvmapSampler::from_cubemap(const vec4* faces, uint32_t size, const ivec2& resolution) {
+	if (size == 0 || resolution.x < 2 || resolution.y < 2) {
+		throw std::runtime_error{"EnvmapSampler: from_cubemap() requires non-empty faces and an envmap of at least 2x2."};
+	}
+
+	cl::Array<cl::ImageF> cl_faces(6);
+	for (uint32_t f = 0; f < 6; ++f) {
+		cl_faces[f].Reset(size, size, 4);
+		for (uint32_t y = 0; y < size; ++y) {
+			for (uint32_t x = 0; x < size; ++x) {
+				const vec4& rgba = faces[((size_t)f * size + y) * size + x];
+				for (int i = 0; i < 4; ++i) {
+					cl_faces[f](y, x, i) = rgba[i];
+				}
+			}
+		}
+	}
+
+	std::vector<vec4> result(compMul(resolution));
+	ThreadPool{}.parallel_for<int>(0, resolution.y, [&](int y) {
+		for (int x = 0; x < resolution.x; ++x) {
+			const vec2 uv = vec2(x, y) / vec2(resolution - 1);
+			float rgba[4];
+			cl::image::SampleCubemap(cl_faces, to_cl(envmap_dir(uv)), rgba);
+			result[x + y * resolution.x] = {rgba[0], rgba[1], rgba[2], rgba[3]};
+		}
+	});
+
+	return result;
+}
+
+NGP_NAMESPACE_END
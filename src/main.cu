@@ -12,6 +12,7 @@
  *  @author Thomas Müller, NVIDIA
  */
 
+#include <neural-graphics-primitives/cpu_nerf_network.h>
 #include <neural-graphics-primitives/testbed.h>
 
 #include <tiny-cuda-nn/common.h>
@@ -67,6 +68,20 @@ int main_func(const std::vector<std::string>& arguments) {
         {'t', "train"},
     };
 
+    Flag align_flag{
+        parser,
+        "ALIGN",
+        "Align the trained blocks of street views to each other.",
+        {"align"},
+    };
+
+    Flag stitch_flag{
+        parser,
+        "STITCH",
+        "Stitch the meshes of the blocks of street views into a single mesh.",
+        {"stitch"},
+    };
+
     Flag render_flag{
         parser,
         "RENDER",
@@ -74,6 +89,38 @@ int main_func(const std::vector<std::string>& arguments) {
         {'r', "render"},
     };
 
+    ValueFlag<uint32_t> partition_flag{
+        parser,
+        "FRAMES",
+        "Split street views into blocks of about FRAMES frames before "
+        "training.",
+        {"partition"},
+    };
+
+    ValueFlag<float> memory_budget_flag{
+        parser,
+        "GB",
+        "Plan the image downscale, batch size and resident blocks of street "
+        "views to fit in GB gigabytes of GPU memory.",
+        {"memory-budget"},
+    };
+
+    ValueFlag<string> query_reference_flag{
+        parser,
+        "REFERENCE",
+        "Save the outputs of the loaded network at random points to "
+        "REFERENCE, for checking the CPU network.",
+        {"query-reference"},
+    };
+
+    ValueFlag<string> cpu_check_flag{
+        parser,
+        "REFERENCE",
+        "Check the CPU network against the GPU outputs in REFERENCE and "
+        "report its throughput.",
+        {"cpu-check"},
+    };
+
 	ValueFlag<string> snapshot_flag{
 		parser,
 		"SNAPSHOT",
@@ -137,23 +184,60 @@ int main_func(const std::vector<std::string>& arguments) {
 		return 0;
 	}
 
+    if (cpu_check_flag) {
+        // The CPU network needs no GPU, so no testbed is created.
+        return check_cpu_nerf_network(get(cpu_check_flag)) ? 0 : 1;
+    }
+
 	Testbed testbed;
 
+    if (memory_budget_flag) {
+        testbed.m_memory_budget =
+                (int64_t)(get(memory_budget_flag) * (1 << 30));
+    }
+
+    if (partition_flag) {
+        uint32_t frames = get(partition_flag);
+        for (auto file : get(files)) {
+            testbed.partition_street_view_nerf(file, frames, frames / 10);
+        }
+    }
+
     if (train_flag) {
         for (auto file : get(files)) {
             testbed.train_street_view_nerf(file);
         }
-    } else if (render_flag) {
+    }
+
+    if (align_flag) {
+        for (auto file : get(files)) {
+            testbed.align_street_view_nerf(file);
+        }
+    }
+
+    if (stitch_flag) {
+        for (auto file : get(files)) {
+            testbed.stitch_street_view_mesh(file);
+        }
+    }
+
+    if (render_flag && !train_flag) {
         for (auto file : get(files)) {
             testbed.render_street_view_nerf(file);
         }
-    } else {
+    } else if (!train_flag && !partition_flag && !align_flag &&
+               !stitch_flag) {
         // No train and render flags, do traditional instant-NGP.
         for (auto file : get(files)) {
             testbed.load_file(file);
         }
     }
 
+    if (query_reference_flag) {
+        testbed.save_query_reference(get(query_reference_flag), 1 << 16);
+        return 0;
+    }
+
 //	if (snapshot_flag) {
 //		testbed.load_snapshot(get(snapshot_flag));
 //	} else if (network_config_flag) {
@@ -16,6 +16,7 @@
 #include <neural-graphics-primitives/common_device.cuh>
 #include <neural-graphics-primitives/common.h>
 #include <neural-graphics-primitives/nerf_loader.h>
+#include <neural-graphics-primitives/nerf_transforms.h>
 #include <neural-graphics-primitives/thread_pool.h>
 #include <neural-graphics-primitives/tinyexr_wrapper.h>
 
@@ -23,8 +24,6 @@
 
 #include <json/json.hpp>
 
-#include <natural_sort.hpp>
-
 #include <stb_image/stb_image.h>
 
 #define _USE_MATH_DEFINES
@@ -38,6 +37,10 @@
 #include "codelibrary/base/array.h"
 #include "codelibrary/base/clamp.h"
 #include "codelibrary/base/log.h"
+#include "codelibrary/geometry/angle.h"
+#include "codelibrary/geometry/intersect_3d.h"
+#include "codelibrary/point_cloud/view_selector.h"
+#include "codelibrary/point_cloud/xyz_io.h"
 #include "codelibrary/string/string_split.h"
 #include "codelibrary/util/io/line_reader.h"
 
@@ -256,6 +259,101 @@ bool read_focal_length(const nlohmann::json &json, vec2 &focal_length, const ive
 	return true;
 }
 
+void read_nerf_scene(const nlohmann::json& json, NerfDataset& result) {
+	if (json.contains("normal_mts_args")) {
+		result.from_mitsuba = true;
+	}
+
+	if (result.from_mitsuba) {
+		result.scale = 0.66f;
+		result.offset = {0.25f * result.scale, 0.25f * result.scale, 0.25f * result.scale};
+	}
+
+	if (json.contains("render_aabb")) {
+		result.render_aabb.min={float(json["render_aabb"][0][0]),float(json["render_aabb"][0][1]),float(json["render_aabb"][0][2])};
+		result.render_aabb.max={float(json["render_aabb"][1][0]),float(json["render_aabb"][1][1]),float(json["render_aabb"][1][2])};
+	}
+
+	if (json.contains("importance_sampling")) {
+		result.wants_importance_sampling = json["importance_sampling"];
+	}
+
+	if (json.contains("n_extra_learnable_dims")) {
+		result.n_extra_learnable_dims = json["n_extra_learnable_dims"];
+	}
+
+	if (json.contains("aabb_scale")) {
+		result.aabb_scale = json["aabb_scale"];
+	}
+	if (json.contains("scale")) {
+		result.scale = json["scale"];
+	}
+
+	if (json.contains("offset")) {
+		result.offset =
+			json["offset"].is_array() ?
+			vec3{float(json["offset"][0]), float(json["offset"][1]), float(json["offset"][2])} :
+			vec3{float(json["offset"]), float(json["offset"]), float(json["offset"])};
+	}
+
+	if (json.contains("aabb")) {
+		// map the given aabb of the form [[minx,miny,minz],[maxx,maxy,maxz]] via an isotropic scale and translate to fit in the (0,0,0)-(1,1,1) cube, with the given center at 0.5,0.5,0.5
+		const auto& aabb=json["aabb"];
+		float length = std::max(0.000001f,std::max(std::max(std::abs(float(aabb[1][0])-float(aabb[0][0])),std::abs(float(aabb[1][1])-float(aabb[0][1]))),std::abs(float(aabb[1][2])-float(aabb[0][2]))));
+		result.scale = 1.f/length;
+		result.offset = { ((float(aabb[1][0])+float(aabb[0][0]))*0.5f)*-result.scale + 0.5f , ((float(aabb[1][1])+float(aabb[0][1]))*0.5f)*-result.scale + 0.5f,((float(aabb[1][2])+float(aabb[0][2]))*0.5f)*-result.scale + 0.5f};
+	}
+
+	if (json.contains("up")) {
+		// axes are permuted as for the xforms below
+		result.up[0] = float(json["up"][1]);
+		result.up[1] = float(json["up"][2]);
+		result.up[2] = float(json["up"][0]);
+	}
+}
+
+TrainingImageMetadata read_nerf_lens(const nlohmann::json& json) {
+	TrainingImageMetadata metadata;
+	read_lens(json, metadata.lens, metadata.principal_point, metadata.rolling_shutter);
+	return metadata;
+}
+
+void read_nerf_camera(const nlohmann::json& settings, const TrainingImageMetadata& lens, const nlohmann::json& frame, const std::array<float, 12>& start, const std::array<float, 12>& end, const ivec2& res, size_t i_img, NerfDataset& result) {
+	if (frame.contains("driver_parameters")) {
+		vec3 light_dir(
+			frame["driver_parameters"].value("LightX", 0.f),
+			frame["driver_parameters"].value("LightY", 0.f),
+			frame["driver_parameters"].value("LightZ", 0.f)
+		);
+		result.metadata[i_img].light_dir = result.nerf_direction_to_ngp(normalize(light_dir));
+		result.has_light_dirs = true;
+		result.n_extra_learnable_dims = 0;
+	}
+
+	bool got_fl = read_focal_length(settings, result.metadata[i_img].focal_length, res);
+	got_fl |= read_focal_length(frame, result.metadata[i_img].focal_length, res);
+	if (!got_fl) {
+		throw std::runtime_error{"Couldn't read fov."};
+	}
+
+	for (int m = 0; m < 3; ++m) {
+		for (int n = 0; n < 4; ++n) {
+			result.xforms[i_img].start[n][m] = start[m * 4 + n];
+			result.xforms[i_img].end[n][m] = end[m * 4 + n];
+		}
+	}
+
+	// set these from the base settings
+	result.metadata[i_img].rolling_shutter = lens.rolling_shutter;
+	result.metadata[i_img].principal_point = lens.principal_point;
+	result.metadata[i_img].lens = lens.lens;
+	// see if there is a per-frame override
+	read_lens(frame, result.metadata[i_img].lens, result.metadata[i_img].principal_point, result.metadata[i_img].rolling_shutter);
+
+	result.xforms[i_img].start = result.nerf_matrix_to_ngp(result.xforms[i_img].start);
+	result.xforms[i_img].end = result.nerf_matrix_to_ngp(result.xforms[i_img].end);
+}
+
 NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
                       float sharpen_amount) {
 	if (jsonpaths.empty()) {
@@ -267,9 +365,6 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 
 	NerfDataset result{};
 
-	std::ifstream f{native_string(jsonpaths.front())};
-    nlohmann::json transforms = nlohmann::json::parse(f, nullptr, true, true);
-
 	ThreadPool pool;
 
 	struct LoadedImageInfo {
@@ -287,19 +382,15 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 	std::vector<LoadedImageInfo> images;
 	LoadedImageInfo info = {};
 
-	if (transforms["camera"].is_array()) {
+	// nerf original format. The files are parsed in parallel, and their frames
+	// are streamed into compact records instead of JSON objects.
+	std::vector<NerfTransforms> transforms = parse_nerf_transforms(jsonpaths, pool);
+
+	const nlohmann::json& first_settings = transforms.front().settings;
+	if (first_settings.contains("camera") && first_settings["camera"].is_array()) {
 		throw std::runtime_error{"hdf5 is no longer supported. please use the hdf52nerf.py conversion script"};
 	}
 
-	// nerf original format
-	std::vector<nlohmann::json> jsons;
-	std::transform(
-		jsonpaths.begin(), jsonpaths.end(),
-		std::back_inserter(jsons), [](const auto& path) {
-			return nlohmann::json::parse(std::ifstream{native_string(path)}, nullptr, true, true);
-		}
-	);
-
 	std::vector<std::string> supported_image_formats = {
 		"png", "jpg", "jpeg", "bmp", "gif", "tga", "pic", "pnm", "psd", "exr",
 	};
@@ -318,64 +409,25 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 	};
 
 	result.n_images = 0;
-	for (size_t i = 0; i < jsons.size(); ++i) {
-		auto& json = jsons[i];
+	for (size_t i = 0; i < transforms.size(); ++i) {
+		auto& frames = transforms[i];
 		fs::path base_path = jsonpaths[i].parent_path();
 
-
-		if (!json.contains("frames") || !json["frames"].is_array()) {
+		if (!frames.has_frames) {
 			tlog::warning() << "  " << jsonpaths[i] << " does not contain any frames. Skipping.";
 			continue;
 		}
 		tlog::info() << "  " << jsonpaths[i];
-		auto& frames = json["frames"];
-
-		float sharpness_discard_threshold = json.value("sharpness_discard_threshold", 0.0f); // Keep all by default
 
-		std::sort(frames.begin(), frames.end(), [](const auto& frame1, const auto& frame2) {
-			return SI::natural::compare<std::string>(frame1["file_path"], frame2["file_path"]);
+		frames.sort_and_cull_frames([&resolve_path, &base_path](const std::string& path) {
+			return resolve_path(base_path, path).exists();
 		});
 
-		for (auto&& frame : frames) {
-			// Compatibility with Windows paths on Linux. (Breaks linux filenames with "\\" in them, which is acceptable for us.)
-			frame["file_path"] = replace_all(frame["file_path"], "\\", "/");
+		for (size_t j = 0; j < frames.n_frames(); ++j) {
+			result.paths.emplace_back(frames.file_paths[j]);
 		}
 
-		if (json.contains("n_frames")) {
-			size_t cull_idx = std::min(frames.size(), (size_t)json["n_frames"]);
-			frames.get_ptr<nlohmann::json::array_t*>()->resize(cull_idx);
-		}
-
-		if (frames[0].contains("sharpness")) {
-			auto frames_copy = frames;
-			frames.clear();
-
-			// Kill blurrier frames than their neighbors
-			const int neighborhood_size = 3;
-			for (int i = 0; i < (int)frames_copy.size(); ++i) {
-				float mean_sharpness = 0.0f;
-				int mean_start = std::max(0, i-neighborhood_size);
-				int mean_end = std::min(i + neighborhood_size, (int)frames_copy.size() - 1);
-				for (int j = mean_start; j < mean_end; ++j) {
-					mean_sharpness += float(frames_copy[j].value("sharpness", 1.0));
-				}
-
-				mean_sharpness /= (mean_end - mean_start);
-
-				if (resolve_path(base_path, frames_copy[i]["file_path"]).exists() && frames_copy[i].value("sharpness", 1.0) > sharpness_discard_threshold * mean_sharpness) {
-					frames.emplace_back(frames_copy[i]);
-				} else {
-					// tlog::info() << "discarding frame " << frames_copy[i]["file_path"];
-					// fs::remove(resolve_path(base_path, frames_copy[i]["file_path"]));
-				}
-			}
-		}
-
-		for (size_t i = 0; i < frames.size(); ++i) {
-			result.paths.emplace_back(frames[i]["file_path"]);
-		}
-
-		result.n_images += frames.size();
+		result.n_images += frames.n_frames();
 	}
 
 	images.resize(result.n_images);
@@ -404,8 +456,9 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 	bool enable_depth_loading = true;
 	std::atomic<int> n_loaded{0};
 	BoundingBox cam_aabb;
-	for (size_t i = 0; i < jsons.size(); ++i) {
-		auto& json = jsons[i];
+	for (size_t i = 0; i < transforms.size(); ++i) {
+		const auto& frames = transforms[i];
+		const nlohmann::json& json = frames.settings;
 
 		fs::path base_path = jsonpaths[i].parent_path();
 		std::string jp = jsonpaths[i].str();
@@ -422,24 +475,10 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 			tlog::info() << "enable_depth_loading is " << enable_depth_loading;
 		}
 
-		if (json.contains("normal_mts_args")) {
-			result.from_mitsuba = true;
-		}
-
 		if (json.contains("fix_premult")) {
 			fix_premult = (bool)json["fix_premult"];
 		}
 
-		if (result.from_mitsuba) {
-			result.scale = 0.66f;
-			result.offset = {0.25f * result.scale, 0.25f * result.scale, 0.25f * result.scale};
-		}
-
-		if (json.contains("render_aabb")) {
-			result.render_aabb.min={float(json["render_aabb"][0][0]),float(json["render_aabb"][0][1]),float(json["render_aabb"][0][2])};
-			result.render_aabb.max={float(json["render_aabb"][1][0]),float(json["render_aabb"][1][1]),float(json["render_aabb"][1][2])};
-		}
-
 		if (json.contains("sharpen")) {
 			sharpen_amount = json["sharpen"];
 		}
@@ -452,64 +491,21 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 			info.black_transparent = bool(json["black_transparent"]);
 		}
 
-		if (json.contains("importance_sampling")) {
-			result.wants_importance_sampling = json["importance_sampling"];
-		}
-
-		if (json.contains("n_extra_learnable_dims")) {
-			result.n_extra_learnable_dims = json["n_extra_learnable_dims"];
-		}
-
-		Lens lens = {};
-		vec2 principal_point = vec2(0.5f);
-		vec4 rolling_shutter = vec4(0.0f);
-
 		if (json.contains("integer_depth_scale")) {
 			info.depth_scale = json["integer_depth_scale"];
 		}
 
-		// Lens parameters
-		read_lens(json, lens, principal_point, rolling_shutter);
-
-		if (json.contains("aabb_scale")) {
-			result.aabb_scale = json["aabb_scale"];
-        }
-        if (json.contains("scale")) {
-            result.scale = json["scale"];
-        }
-
-		if (json.contains("offset")) {
-			result.offset =
-				json["offset"].is_array() ?
-				vec3{float(json["offset"][0]), float(json["offset"][1]), float(json["offset"][2])} :
-				vec3{float(json["offset"]), float(json["offset"]), float(json["offset"])};
-		}
-
-		if (json.contains("aabb")) {
-			// map the given aabb of the form [[minx,miny,minz],[maxx,maxy,maxz]] via an isotropic scale and translate to fit in the (0,0,0)-(1,1,1) cube, with the given center at 0.5,0.5,0.5
-			const auto& aabb=json["aabb"];
-			float length = std::max(0.000001f,std::max(std::max(std::abs(float(aabb[1][0])-float(aabb[0][0])),std::abs(float(aabb[1][1])-float(aabb[0][1]))),std::abs(float(aabb[1][2])-float(aabb[0][2]))));
-			result.scale = 1.f/length;
-			result.offset = { ((float(aabb[1][0])+float(aabb[0][0]))*0.5f)*-result.scale + 0.5f , ((float(aabb[1][1])+float(aabb[0][1]))*0.5f)*-result.scale + 0.5f,((float(aabb[1][2])+float(aabb[0][2]))*0.5f)*-result.scale + 0.5f};
-		}
-
-		if (json.contains("frames") && json["frames"].is_array()) {
-			for (int j = 0; j < json["frames"].size(); ++j) {
-				auto& frame = json["frames"][j];
-				nlohmann::json& jsonmatrix_start = frame.contains("transform_matrix_start") ? frame["transform_matrix_start"] : frame["transform_matrix"];
-				nlohmann::json& jsonmatrix_end = frame.contains("transform_matrix_end") ? frame["transform_matrix_end"] : jsonmatrix_start;
-				const vec3 p = vec3{float(jsonmatrix_start[0][3]), float(jsonmatrix_start[1][3]), float(jsonmatrix_start[2][3])} * result.scale + result.offset;
-				const vec3 q = vec3{float(jsonmatrix_end[0][3]), float(jsonmatrix_end[1][3]), float(jsonmatrix_end[2][3])} * result.scale + result.offset;
-				cam_aabb.enlarge(p);
-				cam_aabb.enlarge(q);
-			}
-		}
-
-		if (json.contains("up")) {
-			// axes are permuted as for the xforms below
-			result.up[0] = float(json["up"][1]);
-			result.up[1] = float(json["up"][2]);
-			result.up[2] = float(json["up"][0]);
+		// Scale, offset, AABB and up vector, and the lens parameters.
+		read_nerf_scene(json, result);
+		const TrainingImageMetadata lens = read_nerf_lens(json);
+
+		for (size_t j = 0; j < frames.n_frames(); ++j) {
+			const auto& start = frames.xforms_start[j];
+			const auto& end = frames.xforms_end[j];
+			const vec3 p = vec3{start[3], start[7], start[11]} * result.scale + result.offset;
+			const vec3 q = vec3{end[3], end[7], end[11]} * result.scale + result.offset;
+			cam_aabb.enlarge(p);
+			cam_aabb.enlarge(q);
 		}
 
 		if (json.contains("envmap") && !any(equal(result.envmap_resolution, ivec2(0)))) {
@@ -526,13 +522,13 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 			}
 		}
 
-		if (json.contains("frames") && json["frames"].is_array()) pool.parallel_for_async<size_t>(0, json["frames"].size(), [&progress, &n_loaded, &result, &images, &json, &resolve_path, &supported_image_formats, base_path, image_idx, info, rolling_shutter, principal_point, lens, part_after_underscore, fix_premult, enable_depth_loading, enable_ray_loading](size_t i) {
+		if (frames.has_frames) pool.parallel_for_async<size_t>(0, frames.n_frames(), [&progress, &n_loaded, &result, &images, &json, &frames, &resolve_path, &supported_image_formats, base_path, image_idx, info, lens, part_after_underscore, fix_premult, enable_depth_loading, enable_ray_loading](size_t i) {
 			size_t i_img = i + image_idx;
-			auto& frame = json["frames"][i];
+			const nlohmann::json& frame = frames.extras[i];
 			LoadedImageInfo& dst = images[i_img];
 			dst = info; // copy defaults
 
-			std::string json_provided_path = frame["file_path"];
+			std::string json_provided_path = frames.file_paths[i];
 			if (json_provided_path == "") {
 				char buf[256];
 				snprintf(buf, 256, "%s_%03d/rgba.png", part_after_underscore.c_str(), (int)i);
@@ -557,7 +553,7 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 					throw std::runtime_error{"Could not open image file: "s + std::string{stbi_failure_reason()}};
 				}
 
-				fs::path alphapath = resolve_path(base_path, fmt::format("{}.alpha.{}", frame["file_path"], path.extension()));
+				fs::path alphapath = resolve_path(base_path, fmt::format("{}.alpha.{}", frames.file_paths[i], path.extension()));
 				if (alphapath.exists()) {
 					int wa = 0, ha = 0;
 					uint8_t* alpha_img = load_stbi(alphapath, &wa, &ha, &comp, 4);
@@ -605,8 +601,8 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 				throw std::runtime_error{fmt::format("Could not load image file '{}'.", path.str())};
 			}
 
-			if (enable_depth_loading && info.depth_scale > 0.f && frame.contains("depth_path")) {
-				fs::path depthpath = resolve_path(base_path, frame["depth_path"]);
+			if (enable_depth_loading && info.depth_scale > 0.f && frames.has_depth_path[i]) {
+				fs::path depthpath = resolve_path(base_path, frames.depth_paths[i]);
 				if (depthpath.exists()) {
 					int wa = 0, ha = 0;
 					dst.depth_pixels = load_stbi_16(depthpath, &wa, &ha, &comp, 1);
@@ -644,49 +640,12 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 				result.has_rays = true;
 			}
 
-			nlohmann::json& jsonmatrix_start = frame.contains("transform_matrix_start") ? frame["transform_matrix_start"] : frame["transform_matrix"];
-			nlohmann::json& jsonmatrix_end = frame.contains("transform_matrix_end") ? frame["transform_matrix_end"] : jsonmatrix_start;
-
-			if (frame.contains("driver_parameters")) {
-				vec3 light_dir(
-					frame["driver_parameters"].value("LightX", 0.f),
-					frame["driver_parameters"].value("LightY", 0.f),
-					frame["driver_parameters"].value("LightZ", 0.f)
-				);
-				result.metadata[i_img].light_dir = result.nerf_direction_to_ngp(normalize(light_dir));
-				result.has_light_dirs = true;
-				result.n_extra_learnable_dims = 0;
-			}
-
-			bool got_fl = read_focal_length(json, result.metadata[i_img].focal_length, dst.res);
-			got_fl |= read_focal_length(frame, result.metadata[i_img].focal_length, dst.res);
-			if (!got_fl) {
-				throw std::runtime_error{"Couldn't read fov."};
-			}
-
-			for (int m = 0; m < 3; ++m) {
-				for (int n = 0; n < 4; ++n) {
-					result.xforms[i_img].start[n][m] = float(jsonmatrix_start[m][n]);
-					result.xforms[i_img].end[n][m] = float(jsonmatrix_end[m][n]);
-				}
-			}
-
-			// set these from the base settings
-			result.metadata[i_img].rolling_shutter = rolling_shutter;
-			result.metadata[i_img].principal_point = principal_point;
-			result.metadata[i_img].lens = lens;
-			// see if there is a per-frame override
-			read_lens(frame, result.metadata[i_img].lens, result.metadata[i_img].principal_point, result.metadata[i_img].rolling_shutter);
-
-			result.xforms[i_img].start = result.nerf_matrix_to_ngp(result.xforms[i_img].start);
-			result.xforms[i_img].end = result.nerf_matrix_to_ngp(result.xforms[i_img].end);
+			read_nerf_camera(json, lens, frame, frames.xforms_start[i], frames.xforms_end[i], dst.res, i_img, result);
 
             progress.update(++n_loaded);
 		}, futures);
 
-		if (json.contains("frames")) {
-			image_idx += json["frames"].size();
-		}
+		image_idx += frames.n_frames();
 	}
 
 	wait_all(futures);
@@ -728,15 +687,225 @@ NerfDataset load_nerf(const std::vector<fs::path>& jsonpaths,
 }
 
 /**
- * Load NeRF data from one single block.
+ * Keep the keyframes of a block, selected by cl::point_cloud::ViewSelector:
+ * the frames that cover the point cloud of the capture, without near-duplicate
+ * frames of the video. The options are read from setting["keyframes"], in
+ * world units. The images are not decoded, only their headers are read, and
+ * the resolutions of the keyframes are returned.
  */
-NerfDataset load_block_nerf_data(const fs::path& path,
-                                 const std::string& block_name) {
-    LOG(INFO) << "Loading block: " << block_name;
+static void select_block_keyframes(const fs::path& path,
+                                   const nlohmann::json& setting,
+                                   const std::string& header,
+                                   cl::Array<cl::Array<std::string>>* rows,
+                                   std::vector<ivec2>* resolutions) {
+    using Selector = cl::point_cloud::ViewSelector<double>;
+
+    const nlohmann::json& keyframes = setting["keyframes"];
+    Selector::Options options;
+    options.voxel_size = keyframes.value("voxel_size", 0.5);
+    options.budget = keyframes.value("budget", 0);
+    options.target_coverage = keyframes.value("coverage", 0.99);
+    options.views_per_voxel = keyframes.value("views_per_voxel", 3);
+    options.novelty_distance = keyframes.value("novelty_distance", 0.5);
+    options.novelty_angle = cl::DegreeToRadian(
+            keyframes.value("novelty_angle", 10.0));
+    options.min_novelty = keyframes.value("min_novelty", 0.2);
+    options.sharpness_weight = keyframes.value("sharpness_weight", 1.0);
+    double far = keyframes.value("far", 50.0);
+
+    // The optional sharpness column.
+    cl::Array<std::string> columns;
+    cl::StringSplit(header, ',', &columns);
+    int sharpness_column = -1;
+    for (int i = 0; i < columns.size(); ++i) {
+        if (columns[i] == "sharpness") sharpness_column = i;
+    }
+
+    int n = rows->size();
+    cl::Array<Selector::View> views(n);
+    std::vector<ivec2> all_resolutions(n);
+    ThreadPool pool;
+    pool.parallel_for<int>(0, n, [&](int i) {
+        const cl::Array<std::string>& row = (*rows)[i];
+        fs::path image_path = path / "images" / row[0];
+        int width, height, comp;
+        CHECK(info_stbi(image_path, &width, &height, &comp))
+                << "Could not read image header: " << image_path;
+        all_resolutions[i] = ivec2(width, height);
+
+        double fx = std::stod(row[1]), fy = std::stod(row[2]);
+        double cx = std::stod(row[3]), cy = std::stod(row[4]);
+        cl::RVector3D axes[4];
+        for (int m = 0; m < 3; ++m) {
+            for (int k = 0; k < 4; ++k) {
+                axes[k][m] = std::stod(row[m * 4 + k + 5]);
+            }
+        }
+        double sharpness = sharpness_column >= 0 &&
+                           sharpness_column < row.size()
+                           ? std::stod(row[sharpness_column]) : 1.0;
+
+        // The camera looks at +z, with x right and y down.
+        cl::RPoint3D position(axes[3].x, axes[3].y, axes[3].z);
+        views[i] = Selector::View(position, axes[0], -axes[1], axes[2],
+                                  -cx / fx, (width - cx) / fx,
+                                  (cy - height) / fy, cy / fy,
+                                  1e-3 * far, far, sharpness);
+    });
+
+    // The point cloud of the capture, cropped to the block.
+    cl::Array<cl::RPoint3D> points;
+    fs::path point_cloud_path = path / fs::path(path.basename() + ".xyz");
+    cl::point_cloud::XYZLoader loader(point_cloud_path.str());
+    if (loader.is_open()) {
+        loader.Load(&points);
+    } else {
+        tlog::warning() << "No point cloud " << point_cloud_path
+                        << ", selecting keyframes by their poses only.";
+    }
+    if (setting.contains("aabb")) {
+        const nlohmann::json& aabb = setting["aabb"];
+        cl::RBox3D box(aabb[0][0], aabb[1][0], aabb[0][1], aabb[1][1],
+                       aabb[0][2], aabb[1][2]);
+        int n_inside = 0;
+        for (const cl::RPoint3D& p : points) {
+            if (cl::geometry::Intersect(box, p)) points[n_inside++] = p;
+        }
+        points.resize(n_inside);
+    }
+
+    Selector selector(options);
+    cl::Array<int> selected;
+    selector.Select(views, points, &selected);
 
+    cl::Array<cl::Array<std::string>> kept;
+    resolutions->clear();
+    for (int i : selected) {
+        kept.push_back(std::move((*rows)[i]));
+        resolutions->push_back(all_resolutions[i]);
+    }
+    rows->swap(kept);
+
+    LOG(INFO) << "Kept " << selected.size() << " of " << n << " frames ("
+              << 100.0 * selected.size() / n << "%), covering "
+              << selector.n_covered_voxels() << " of "
+              << selector.n_visible_voxels() << " voxels ("
+              << 100.0 * selector.n_covered_voxels() /
+                 std::max(1, selector.n_visible_voxels()) << "%).";
+}
+
+/**
+ * Read the setting of a block, and the rows of its pose.csv, restricted to the
+ * keyframes if the setting selects them. The resolutions of the images are
+ * read from their headers, without decoding the images.
+ */
+BlockNerfFrames read_block_nerf_frames(const fs::path& path,
+                                       const std::string& block_name) {
     fs::path block_path = path / "blocks" / block_name;
     CHECK(block_path.exists()) << block_path;
 
+    BlockNerfFrames frames;
+    frames.name = block_name;
+    std::ifstream f{native_string(block_path / "setting.json")};
+    if (!f.is_open()) {
+        f.open(native_string(path / "blocks" / "setting.json"));
+    }
+    CHECK(f.is_open()) << "No setting.json";
+    frames.setting = nlohmann::json::parse(f, nullptr, true, true);
+
+    cl::io::LineReader line_reader;
+    CHECK(line_reader.Open((block_path / "pose.csv").str()));
+    std::string header;
+    cl::Array<cl::Array<std::string>>& rows = frames.rows;
+    while (char* line = line_reader.ReadLine()) {
+        if (line_reader.n_line() == 1) {
+            header = line;
+            continue;
+        }
+        cl::Array<std::string> parse;
+        cl::StringSplit(line, ',', &parse);
+        if (parse.empty()) continue;
+//        if (parse[0][0] == '1' || parse[0][0] == '4') continue;
+        CHECK(parse.size() >= 21) << parse;
+        rows.push_back(std::move(parse));
+    }
+
+    if (frames.setting.contains("keyframes")) {
+        select_block_keyframes(path, frames.setting, header, &rows,
+                               &frames.resolutions);
+        return frames;
+    }
+
+    // The image headers only, without decoding the images.
+    frames.resolutions.resize(rows.size());
+    ThreadPool pool;
+    pool.parallel_for<int>(0, rows.size(), [&](int i) {
+        fs::path image_path = path / "images" / rows[i][0];
+        ivec2& res = frames.resolutions[i];
+        int comp;
+        CHECK(info_stbi(image_path, &res.x, &res.y, &comp))
+                << "Could not read image header: " << image_path;
+    });
+    return frames;
+}
+
+/**
+ * Shrink the RGBA bytes of an image by the integer factor 'downscale', by
+ * averaging each downscale x downscale box. The pixels are reallocated.
+ */
+static void downscale_image(int downscale, ivec2* res, uint8_t** pixels) {
+    ivec2 out_res = max(*res / downscale, ivec2(1));
+    uint8_t* out = (uint8_t*)malloc((size_t)compMul(out_res) * 4);
+    CHECK(out);
+
+    const uint8_t* in = *pixels;
+    for (int y = 0; y < out_res.y; ++y) {
+        int y1 = std::min(y * downscale + downscale, res->y);
+        for (int x = 0; x < out_res.x; ++x) {
+            int x1 = std::min(x * downscale + downscale, res->x);
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            int n = 0;
+            for (int v = y * downscale; v < y1; ++v) {
+                for (int u = x * downscale; u < x1; ++u) {
+                    const uint8_t* p = in + ((size_t)v * res->x + u) * 4;
+                    for (int c = 0; c < 4; ++c) {
+                        sum[c] += p[c];
+                    }
+                    ++n;
+                }
+            }
+            uint8_t* q = out + ((size_t)y * out_res.x + x) * 4;
+            for (int c = 0; c < 4; ++c) {
+                q[c] = (uint8_t)((sum[c] + n / 2) / n);
+            }
+        }
+    }
+
+    free(*pixels);
+    *pixels = out;
+    *res = out_res;
+}
+
+/**
+ * Load NeRF data from one single block. The images are downscaled by the
+ * integer factor 'downscale' while they are loaded.
+ */
+NerfDataset load_block_nerf_data(const fs::path& path,
+                                 const std::string& block_name,
+                                 int downscale) {
+    return load_block_nerf_data(path, read_block_nerf_frames(path, block_name),
+                                downscale);
+}
+
+NerfDataset load_block_nerf_data(const fs::path& path,
+                                 const BlockNerfFrames& frames,
+                                 int downscale) {
+    LOG(INFO) << "Loading block: " << frames.name;
+    CHECK(downscale >= 1) << downscale;
+
+    const nlohmann::json& setting = frames.setting;
+    const cl::Array<cl::Array<std::string>>& rows = frames.rows;
+
     struct LoadedImageInfo {
         ivec2 res = ivec2(0);
         bool image_data_on_gpu = false;
@@ -753,10 +922,6 @@ NerfDataset load_block_nerf_data(const fs::path& path,
     NerfDataset result{};
     ThreadPool pool;
 
-    cl::io::LineReader line_reader;
-    CHECK(line_reader.Open((block_path / "pose.csv").str()));
-    cl::Array<std::string> parse;
-    bool first_line = true;
     BoundingBox cam_aabb;
 
     // Find the middle camera.
@@ -765,19 +930,10 @@ NerfDataset load_block_nerf_data(const fs::path& path,
     std::unique_ptr<uint8_t> pixels;
 
     result.from_mitsuba = false;
-    while (char* line = line_reader.ReadLine()) {
-        if (first_line) {
-            first_line = false;
-            continue;
-        }
-        cl::StringSplit(line, ',', &parse);
-        if (parse.empty()) continue;
-//        if (parse[0][0] == '1' || parse[0][0] == '4') continue;
+    for (const cl::Array<std::string>& parse : rows) {
         fs::path image_path = path / "images" / parse[0];
         result.paths.emplace_back(image_path.str());
 
-        CHECK(parse.size() >= 21) << parse;
-
         // Load image data.
         LoadedImageInfo image{};
         image.image_data_on_gpu = false;
@@ -790,6 +946,18 @@ NerfDataset load_block_nerf_data(const fs::path& path,
                          << stbi_failure_reason();
         }
         image.image_type = EImageDataType::Byte;
+
+        // Principal points are relative, but focal lengths are in pixels.
+        vec2 principal_point(std::stof(parse[3]) / image.res.x,
+                             std::stof(parse[4]) / image.res.y);
+        vec2 focal_length(std::stof(parse[1]), std::stof(parse[2]));
+        if (downscale > 1) {
+            ivec2 full_res = image.res;
+            uint8_t* pixels = (uint8_t*)image.pixels;
+            downscale_image(downscale, &image.res, &pixels);
+            image.pixels = pixels;
+            focal_length *= vec2(image.res) / vec2(full_res);
+        }
         images.push_back(image);
 
         // Load camera transformation matrices.
@@ -810,10 +978,9 @@ NerfDataset load_block_nerf_data(const fs::path& path,
 
         // Load metadata.
         TrainingImageMetadata metadata;
-        metadata.focal_length = vec2(std::stof(parse[1]), std::stof(parse[2]));
+        metadata.focal_length = focal_length;
         metadata.rolling_shutter = vec4(0.0f);
-        metadata.principal_point = vec2(std::stof(parse[3]) / image.res.x,
-                                        std::stof(parse[4]) / image.res.y);
+        metadata.principal_point = principal_point;
         metadata.lens = {};
         result.metadata.push_back(metadata);
     }
@@ -829,15 +996,10 @@ NerfDataset load_block_nerf_data(const fs::path& path,
         CHECK(false) << "No training images were found for NeRF training!";
     }
 
-    LOG(INFO) << "Loaded " << images.size() << " images.";
-
-    std::ifstream f{native_string(block_path / "setting.json")};
-    if (!f.is_open()) {
-        f.open(native_string(path / "blocks" / "setting.json"));
-    }
-    CHECK(f.is_open()) << "No setting.json";
+    LOG(INFO) << "Loaded " << images.size() << " images"
+              << (downscale > 1 ? ", downscaled by " +
+                                  std::to_string(downscale) : "") << ".";
 
-    nlohmann::json setting = nlohmann::json::parse(f, nullptr, true, true);
     if (setting.contains("scale")) {
         result.scale = setting["scale"];
     } else {
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   parameter_telemetry.cu
+ *  @brief  Asynchronous statistics of the trained parameters.
+ */
+
+#include <neural-graphics-primitives/parameter_telemetry.h>
+
+#include <tiny-cuda-nn/common.h>
+
+#include <chrono>
+
+NGP_NAMESPACE_BEGIN
+
+ParameterTelemetry::ParameterTelemetry() {
+	CUDA_CHECK_THROW(cudaEventCreateWithFlags(&m_copied, cudaEventDisableTiming));
+}
+
+ParameterTelemetry::~ParameterTelemetry() {
+	if (m_state == EState::Copying) {
+		cudaEventSynchronize(m_copied);
+	} else if (m_state == EState::Analyzing) {
+		m_analysis.wait();
+	}
+
+	free_host_buffer();
+	cudaEventDestroy(m_copied);
+}
+
+void ParameterTelemetry::free_host_buffer() {
+	if (m_host) {
+		cudaFreeHost(m_host);
+		m_host = nullptr;
+		m_host_size = 0;
+	}
+}
+
+bool ParameterTelemetry::snapshot(cudaStream_t stream, const float* params, const std::vector<ParameterBlock>& blocks, uint32_t training_step) {
+	if (busy() || !params || blocks.empty()) {
+		return false;
+	}
+
+	// Besides the cadence, changed settings call for a new snapshot, so that
+	// the statistics follow the GUI also when the training is paused.
+	bool same_settings = settings.histogram_scale == m_snapshot_settings.histogram_scale && settings.quantization_bits == m_snapshot_settings.quantization_bits;
+	if (m_has_snapshot && same_settings && training_step >= m_last_step && training_step - m_last_step < settings.interval) {
+		return false;
+	}
+
+	size_t n_values = 0;
+	for (const auto& block : blocks) {
+		n_values += block.size;
+	}
+
+	m_staging.enlarge(n_values);
+	if (m_host_size < n_values) {
+		free_host_buffer();
+		CUDA_CHECK_THROW(cudaMallocHost(&m_host, n_values * sizeof(float)));
+		m_host_size = n_values;
+	}
+
+	// The training stream only waits for the fast device-to-device copy of
+	// the blocks, before it updates the parameters again. The transfer to the
+	// host overlaps with the following training steps.
+	m_stream.wait_for(stream);
+	size_t offset = 0;
+	for (const auto& block : blocks) {
+		CUDA_CHECK_THROW(cudaMemcpyAsync(m_staging.data() + offset, params + block.offset, block.size * sizeof(float), cudaMemcpyDeviceToDevice, m_stream.get()));
+		offset += block.size;
+	}
+	m_stream.signal(stream);
+
+	CUDA_CHECK_THROW(cudaMemcpyAsync(m_host, m_staging.data(), n_values * sizeof(float), cudaMemcpyDeviceToHost, m_stream.get()));
+	CUDA_CHECK_THROW(cudaEventRecord(m_copied, m_stream.get()));
+
+	m_blocks = blocks;
+	m_step = training_step;
+	m_snapshot_settings = settings;
+	m_has_snapshot = true;
+	m_last_step = training_step;
+	m_state = EState::Copying;
+	return true;
+}
+
+bool ParameterTelemetry::poll(ParameterTelemetryResult& result) {
+	if (m_state == EState::Copying) {
+		cudaError_t status = cudaEventQuery(m_copied);
+		if (status == cudaErrorNotReady) {
+			return false;
+		}
+
+		CUDA_CHECK_THROW(status);
+
+		// The blocks are analyzed one after the other on the worker, each of
+		// them in parallel by codelibrary (OpenMP).
+		m_analysis = m_worker.enqueue_task([host=m_host, blocks=m_blocks, step=m_step, s=m_snapshot_settings]() {
+			cl::ParameterStatsOptions options;
+			options.histogram_range = s.histogram_scale;
+			options.quantization_bits = s.quantization_bits;
+
+			ParameterTelemetryResult result;
+			result.training_step = step;
+			result.blocks.resize(blocks.size());
+
+			size_t offset = 0;
+			for (size_t i = 0; i < blocks.size(); ++i) {
+				cl::ComputeParameterStats(host + offset, blocks[i].size, options, &result.blocks[i]);
+				offset += blocks[i].size;
+			}
+
+			return result;
+		});
+		m_state = EState::Analyzing;
+	}
+
+	if (m_state == EState::Analyzing) {
+		if (m_analysis.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+			return false;
+		}
+
+		result = m_analysis.get();
+		m_state = EState::Idle;
+
+		if (m_series.is_open()) {
+			for (size_t i = 0; i < result.blocks.size(); ++i) {
+				m_series.Write(result.training_step, (int)i, result.blocks[i]);
+			}
+			m_series.Flush();
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+bool ParameterTelemetry::flush(ParameterTelemetryResult& result) {
+	if (m_state == EState::Idle) {
+		return false;
+	}
+
+	if (m_state == EState::Copying) {
+		CUDA_CHECK_THROW(cudaEventSynchronize(m_copied));
+	}
+
+	if (poll(result)) {
+		return true;
+	}
+
+	m_analysis.wait();
+	return poll(result);
+}
+
+void ParameterTelemetry::open_series(const fs::path& path, ETelemetryFormat format) {
+	auto cl_format = format == ETelemetryFormat::Csv ? cl::ParameterStatsWriter::Format::kCSV : cl::ParameterStatsWriter::Format::kBinary;
+	if (!m_series.Open(path.str(), cl_format)) {
+		throw std::runtime_error{fmt::format("Could not open parameter telemetry file {}.", path.str())};
+	}
+}
+
+void ParameterTelemetry::close_series() {
+	m_series.Close();
+}
+
+NGP_NAMESPACE_END
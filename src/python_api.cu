@@ -13,6 +13,7 @@
  */
 
 #include <neural-graphics-primitives/common_device.cuh>
+#include <neural-graphics-primitives/cpu_tonemap.h>
 #include <neural-graphics-primitives/testbed.h>
 #include <neural-graphics-primitives/thread_pool.h>
 
@@ -263,6 +264,47 @@ py::array_t<float> Testbed::screenshot(bool linear, bool front_buffer) const {
 }
 #endif
 
+ivec2 rgba_array_resolution(const py::buffer_info& buf) {
+	if (buf.ndim != 3 || buf.shape[2] != 4) {
+		throw std::runtime_error{"Expected an array of shape (height, width, 4)."};
+	}
+	return {(int)buf.shape[1], (int)buf.shape[0]};
+}
+
+py::array tonemap_on_cpu(py::array_t<float, py::array::c_style | py::array::forcecast> image, const CpuTonemapSettings& settings, ECpuImageFormat format) {
+	py::buffer_info buf = image.request();
+	ivec2 res = rgba_array_resolution(buf);
+
+	py::dtype dtype;
+	switch (format) {
+		case ECpuImageFormat::Float: dtype = py::dtype::of<float>(); break;
+		case ECpuImageFormat::Half: dtype = py::dtype("float16"); break;
+		case ECpuImageFormat::UInt16: dtype = py::dtype::of<uint16_t>(); break;
+		case ECpuImageFormat::UInt8: dtype = py::dtype::of<uint8_t>(); break;
+		default: throw std::runtime_error{"Unknown image format."};
+	}
+
+	py::array result(dtype, {res.y, res.x, 4});
+	void* out = result.mutable_data();
+	{
+		py::gil_scoped_release release;
+		cpu_tonemap((const float*)buf.ptr, res, settings, format, out);
+	}
+	return result;
+}
+
+void accumulate_on_cpu(py::array_t<float, py::array::c_style> accumulation, py::array_t<float, py::array::c_style | py::array::forcecast> frame, int sample_count, EColorSpace color_space) {
+	py::buffer_info acc_buf = accumulation.request(true);
+	py::buffer_info frame_buf = frame.request();
+	ivec2 res = rgba_array_resolution(acc_buf);
+	if (rgba_array_resolution(frame_buf) != res) {
+		throw std::runtime_error{"The frame and the accumulation buffer must have the same shape."};
+	}
+
+	py::gil_scoped_release release;
+	cpu_accumulate((const float*)frame_buf.ptr, res, sample_count, color_space, (float*)acc_buf.ptr);
+}
+
 PYBIND11_MODULE(pyngp, m) {
 	m.doc() = "Instant neural graphics primitives";
 
@@ -346,6 +388,44 @@ PYBIND11_MODULE(pyngp, m) {
 		.value("Reinhard", ETonemapCurve::Reinhard)
 		.export_values();
 
+	py::enum_<ECpuImageFormat>(m, "ImageFormat")
+		.value("Float", ECpuImageFormat::Float)
+		.value("Half", ECpuImageFormat::Half)
+		.value("UInt16", ECpuImageFormat::UInt16)
+		.value("UInt8", ECpuImageFormat::UInt8)
+		.export_values();
+
+	m.def("tonemap",
+		[](py::array_t<float, py::array::c_style | py::array::forcecast> image, float exposure, ETonemapCurve tonemap_curve, EColorSpace color_space, EColorSpace output_color_space, const vec4& background_color, bool unmultiply_alpha, bool clamp_output_color, ECpuImageFormat format) {
+			CpuTonemapSettings settings;
+			settings.exposure = exposure;
+			settings.tonemap_curve = tonemap_curve;
+			settings.color_space = color_space;
+			settings.output_color_space = output_color_space;
+			settings.background_color = background_color;
+			settings.unmultiply_alpha = unmultiply_alpha;
+			settings.clamp_output_color = clamp_output_color;
+			return tonemap_on_cpu(image, settings, format);
+		},
+		"Tonemaps a (height, width, 4) float image on the CPU like the testbed does on the GPU, and returns it in the requested format. Integer formats are clamped to [0, 1].",
+		py::arg("image"),
+		py::arg("exposure") = 0.0f,
+		py::arg("tonemap_curve") = ETonemapCurve::Identity,
+		py::arg("color_space") = EColorSpace::Linear,
+		py::arg("output_color_space") = EColorSpace::SRGB,
+		py::arg("background_color") = vec4(0.0f),
+		py::arg("unmultiply_alpha") = false,
+		py::arg("clamp_output_color") = false,
+		py::arg("format") = ECpuImageFormat::UInt8
+	);
+	m.def("accumulate", &accumulate_on_cpu,
+		"Blends a (height, width, 4) float frame into an accumulation buffer of the same shape, in place, after `sample_count` previous frames.",
+		py::arg("accumulation").noconvert(),
+		py::arg("frame"),
+		py::arg("sample_count"),
+		py::arg("color_space") = EColorSpace::Linear
+	);
+
 	py::enum_<ELensMode>(m, "LensMode")
 		.value("Perspective", ELensMode::Perspective)
 		.value("OpenCV", ELensMode::OpenCV)
@@ -444,10 +524,22 @@ PYBIND11_MODULE(pyngp, m) {
 		.def("n_params", &Testbed::n_params, "Number of trainable parameters")
 		.def("n_encoding_params", &Testbed::n_encoding_params, "Number of trainable parameters in the encoding")
 		.def("save_snapshot", &Testbed::save_snapshot, py::arg("path"), py::arg("include_optimizer_state")=false, py::arg("compress")=true, "Save a snapshot of the currently trained model. Optionally compressed (only when saving '.ingp' files).")
+		.def("record_parameter_telemetry", &Testbed::record_parameter_telemetry, py::arg("path"), "Append the statistics of the grid levels and the first layer to a time series, as CSV if the path ends in '.csv' and as binary records otherwise.")
+		.def("stop_parameter_telemetry", &Testbed::stop_parameter_telemetry, "Finish the pending statistics and close the time series.")
 		.def("load_snapshot", &Testbed::load_snapshot, py::arg("path"), "Load a previously saved snapshot")
 		.def("load_camera_path", &Testbed::load_camera_path, py::arg("path"), "Load a camera path")
 		.def("load_file", &Testbed::load_file, py::arg("path"), "Load a file and automatically determine how to handle it. Can be a snapshot, dataset, network config, or camera path.")
 		.def_property("loop_animation", &Testbed::loop_animation, &Testbed::set_loop_animation)
+		.def_property("snapshot_quantization_bits",
+			[](const Testbed& testbed) { return testbed.m_snapshot_codec.grid_bits; },
+			[](Testbed& testbed, int bits) {
+				if (bits < 0 || bits > 8) {
+					throw std::runtime_error{"Snapshot quantization bits must be in [0, 8]."};
+				}
+				testbed.m_snapshot_codec.grid_bits = bits;
+			},
+			"Bits per hash-grid parameter when saving snapshots (0 disables the lossy codec)."
+		)
 		// Interesting members.
 		.def_readwrite("dynamic_res", &Testbed::m_dynamic_res)
 		.def_readwrite("dynamic_res_target_fps", &Testbed::m_dynamic_res_target_fps)
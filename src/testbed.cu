@@ -41,6 +41,7 @@
 
 #include <fstream>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 
 #ifdef NGP_GUI
@@ -68,6 +69,9 @@
 #include "codelibrary/base/log.h"
 #include "codelibrary/base/index_sort.h"
 #include "codelibrary/geometry/distance_3d.h"
+#include "codelibrary/geometry/mesh/block_mesh_stitcher.h"
+#include "codelibrary/point_cloud/block_aligner.h"
+#include "codelibrary/point_cloud/trajectory_partitioner.h"
 #include "codelibrary/point_cloud/xyz_io.h"
 
 using namespace std::literals::chrono_literals;
@@ -262,6 +266,9 @@ json Testbed::load_network_config(const fs::path& network_config_path) {
         } else {
             result = json::from_msgpack(f);
         }
+        if (result.contains("snapshot")) {
+            decode_snapshot_codecs(result["snapshot"]);
+        }
         // we assume parent pointers are already resolved in snapshots.
     } else if (equals_case_insensitive(network_config_path.extension(), "json")) {
         std::ifstream f{native_string(network_config_path)};
@@ -374,6 +381,342 @@ void Testbed::load_file(const fs::path& path) {
     }
 }
 
+void Testbed::partition_street_view_nerf(const fs::path& path,
+                                         int frames_per_block,
+                                         int overlap_frames) {
+    if (path.empty()) return;
+    CHECK(path.exists());
+    CHECK(frames_per_block > 0);
+    CHECK(overlap_frames >= 0);
+
+    // Each station of the capture is a rig of 6 cameras, as in
+    // render_street_view_nerf().
+    const int n_rig_cameras = 6;
+
+    LOG(INFO) << "Loading street view camera poses...";
+    fs::path camera_pose_path = path / "full_poses.csv";
+    CHECK(camera_pose_path.exists()) << camera_pose_path;
+
+    cl::io::LineReader line_reader;
+    CHECK(line_reader.Open(camera_pose_path.str()));
+    std::string header;
+    cl::Array<std::string> rows;
+    cl::Array<cl::RPoint3D> stations;
+    cl::Array<std::string> parse;
+    cl::RVector3D sum(0.0, 0.0, 0.0);
+    while (char* line = line_reader.ReadLine()) {
+        if (line_reader.n_line() == 1) {
+            header = line;
+            continue;
+        }
+        std::string row = line;
+        cl::StringSplit(line, ',', &parse);
+        if (parse.empty()) continue;
+
+        CHECK(parse.size() >= 21) << parse;
+
+        // The translation of the 3x4 camera matrix after the 5 intrinsics.
+        sum += cl::RVector3D(std::stod(parse[8]), std::stod(parse[12]),
+                             std::stod(parse[16]));
+        rows.push_back(row);
+        if (rows.size() % n_rig_cameras == 0) {
+            stations.emplace_back(sum.x / n_rig_cameras, sum.y / n_rig_cameras,
+                                  sum.z / n_rig_cameras);
+            sum = cl::RVector3D(0.0, 0.0, 0.0);
+        }
+    }
+    CHECK(rows.size() % n_rig_cameras == 0);
+    CHECK(!stations.empty()) << "No camera poses in " << camera_pose_path;
+
+    LOG(INFO) << "Loading point cloud...";
+    cl::Array<cl::RPoint3D> points;
+    fs::path point_cloud_path = path / fs::path(path.basename() + ".xyz");
+    cl::point_cloud::XYZLoader loader(point_cloud_path.str());
+    if (loader.is_open()) {
+        loader.Load(&points);
+    } else {
+        tlog::warning() << "No point cloud " << point_cloud_path
+                        << ", balancing the number of frames only.";
+    }
+
+    // Cut the trajectory where the spacing of the stations is much larger
+    // than usual, i.e., between different streets.
+    cl::Array<double> spacings;
+    for (int i = 1; i < stations.size(); ++i) {
+        spacings.push_back(cl::Distance(stations[i - 1], stations[i]));
+    }
+    double median_spacing = 0.0;
+    if (!spacings.empty()) {
+        std::nth_element(spacings.begin(),
+                         spacings.begin() + spacings.size() / 2,
+                         spacings.end());
+        median_spacing = spacings[spacings.size() / 2];
+    }
+
+    using Partitioner = cl::point_cloud::TrajectoryPartitioner<double>;
+    Partitioner::Options options;
+    options.target_size = std::max(1, frames_per_block / n_rig_cameras);
+    options.overlap = (overlap_frames + n_rig_cameras - 1) / n_rig_cameras;
+    options.max_gap = 10.0 * median_spacing;
+    Partitioner partitioner(options);
+
+    cl::Array<Partitioner::Block> blocks;
+    partitioner.Partition(stations, points, &blocks);
+
+    // Shared settings of the blocks, if any.
+    fs::path blocks_path = path / "blocks";
+    nlohmann::json setting = nlohmann::json::object();
+    if ((blocks_path / "setting.json").exists()) {
+        std::ifstream f{native_string(blocks_path / "setting.json")};
+        setting = nlohmann::json::parse(f, nullptr, true, true);
+    } else if (!blocks_path.exists()) {
+        CHECK(fs::create_directory(blocks_path)) << blocks_path;
+    }
+    double scale = setting.value("scale", 0.02);
+
+    // Training and rendering take every "b*" directory as a block, so higher
+    // blocks of an earlier partition must not survive. They may hold trained
+    // networks, hence they are not removed here.
+    bool overwrite = false;
+    cl::Array<std::string> stale_blocks;
+    for (const auto& block_path : fs::directory(blocks_path)) {
+        std::string block = block_path.basename();
+        if (block.size() < 2 || block[0] != 'b' ||
+            !std::all_of(block.begin() + 1, block.end(),
+                         [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        if (std::stoi(block.substr(1)) < blocks.size()) {
+            overwrite = true;
+        } else {
+            stale_blocks.push_back(block);
+        }
+    }
+    if (!stale_blocks.empty()) {
+        std::sort(stale_blocks.begin(), stale_blocks.end());
+        std::string names;
+        for (const std::string& block : stale_blocks) {
+            names += " " + block;
+        }
+        throw std::runtime_error{fmt::format(
+                "Partitioning into {} blocks would leave the blocks{} of an "
+                "earlier partition in {}. Remove them first.",
+                blocks.size(), names, blocks_path.str())};
+    }
+    if (overwrite) {
+        tlog::warning() << "Overwriting existing blocks in " << blocks_path;
+    }
+
+    // Write the blocks in the layout of load_block_nerf_data().
+    m_thread_pool.parallel_for<int>(0, blocks.size(), [&](int k) {
+        const Partitioner::Block& b = blocks[k];
+        fs::path block_path = blocks_path / fmt::format("b{}", k);
+        if (!block_path.exists()) {
+            CHECK(fs::create_directory(block_path)) << block_path;
+        }
+
+        std::ofstream pose_file{native_string(block_path / "pose.csv")};
+        pose_file << header << "\n";
+        for (int i = b.first * n_rig_cameras;
+             i < b.last * n_rig_cameras; ++i) {
+            pose_file << rows[i] << "\n";
+        }
+        CHECK(pose_file.good()) << block_path / "pose.csv";
+
+        // The unit cube around the middle camera must contain the block.
+        double extent = 0.0;
+        for (int d = 0; d < 3; ++d) {
+            extent = std::max(extent, std::abs(b.box.min(d) - b.center[d]));
+            extent = std::max(extent, std::abs(b.box.max(d) - b.center[d]));
+        }
+        int aabb_scale = 1;
+        while (aabb_scale < 128 && aabb_scale < 2.0 * extent * scale) {
+            aabb_scale *= 2;
+        }
+
+        nlohmann::json block_setting = setting;
+        block_setting["scale"] = scale;
+        block_setting["aabb_scale"] = aabb_scale;
+        block_setting["center"] = {b.center.x, b.center.y, b.center.z};
+        block_setting["aabb"] = {
+            {b.box.x_min(), b.box.y_min(), b.box.z_min()},
+            {b.box.x_max(), b.box.y_max(), b.box.z_max()}
+        };
+        block_setting["core_frames"] = {b.core_first * n_rig_cameras,
+                                        b.core_last * n_rig_cameras};
+        std::ofstream setting_file{native_string(block_path /
+                                                 "setting.json")};
+        setting_file << block_setting.dump(4);
+        CHECK(setting_file.good()) << block_path / "setting.json";
+    });
+
+    for (int k = 0; k < blocks.size(); ++k) {
+        const Partitioner::Block& b = blocks[k];
+        LOG(INFO) << "Block b" << k << ": "
+                  << (b.last - b.first) * n_rig_cameras << " frames, "
+                  << b.n_points << " points, cost " << b.cost;
+    }
+    tlog::success() << "Partitioned " << rows.size() << " frames into "
+                    << blocks.size() << " blocks.";
+}
+
+/**
+ * Plan the GPU memory of the blocks of a street view in m_memory_budget bytes:
+ * the downscale of the training images and the training batch size that fit
+ * every block, and the number of block NeRFs that can be resident together
+ * when rendering. The frames of the blocks are returned in 'block_frames', if
+ * given, so that training does not select the keyframes again.
+ */
+cl::MemoryPlanner::Settings Testbed::plan_street_view_memory(
+        const fs::path& path,
+        std::map<std::string, BlockNerfFrames>* block_frames) {
+    using Planner = cl::MemoryPlanner;
+
+    cl::Array<std::string> blocks;
+    for (const auto& block_path : fs::directory(path / "blocks")) {
+        std::string block = block_path.basename();
+        if (block.empty() || block[0] != 'b') continue;
+        blocks.push_back(block);
+    }
+    const int n_blocks = blocks.size();
+
+    // The network of reset_nerf_network(), with the same defaults.
+    const json& config = m_network_config;
+    const json encoding = config.value("encoding", json::object());
+    const json density_network = config.value("network", json::object());
+    const json rgb_network = config.value("rgb_network", density_network);
+    Planner::Network network;
+    network.n_features_per_level = encoding.value("n_features_per_level", 2);
+    network.n_levels = encoding.value("n_levels", 16);
+    network.log2_hashmap_size = encoding.value("log2_hashmap_size", 15);
+    network.base_resolution = encoding.value("base_resolution", 0);
+    if (network.base_resolution == 0) {
+        network.base_resolution = 1 << (network.log2_hashmap_size / 3);
+    }
+    network.per_level_scale = encoding.value("per_level_scale", 0.0);
+    network.density_neurons = density_network.value("n_neurons", 64);
+    network.density_hidden_layers =
+            density_network.value("n_hidden_layers", 1);
+    network.density_output_width =
+            density_network.value("n_output_dims", 16);
+    network.rgb_neurons = rgb_network.value("n_neurons", 64);
+    network.rgb_hidden_layers = rgb_network.value("n_hidden_layers", 2);
+
+    // Spherical harmonics of the view direction, possibly nested.
+    const json dir_encoding = config.value("dir_encoding", json::object());
+    network.sh_degree = dir_encoding.value("degree", 4);
+    if (dir_encoding.contains("nested")) {
+        for (const json& nested : dir_encoding["nested"]) {
+            network.sh_degree = nested.value("degree", network.sh_degree);
+        }
+    }
+
+    // Full precision weights and their Adam moments, plus an EMA copy.
+    network.param_bytes = sizeof(precision_t);
+    network.optimizer_bytes = 0;
+    const json optimizer_config = config.value("optimizer", json::object());
+    for (const json* optimizer = &optimizer_config; ;
+         optimizer = &(*optimizer)["nested"]) {
+        std::string type = to_lower(optimizer->value("otype", "Adam"));
+        if (type == "ema") {
+            network.optimizer_bytes += sizeof(precision_t) + sizeof(float);
+        } else if (type == "adam") {
+            network.optimizer_bytes += 3 * sizeof(float);
+        }
+        if (!optimizer->contains("nested")) break;
+    }
+    network.n_grid_cells = NERF_GRID_N_CELLS();
+    network.n_cascades = NERF_CASCADES();
+    network.has_sharpness_grid = m_nerf.training.include_sharpness_in_error;
+
+    Planner::Options options;
+    options.budget = m_memory_budget;
+    options.max_batch_size = std::max(m_training_batch_size,
+                                      (uint32_t)options.min_batch_size);
+    Planner planner(options);
+
+    // Every block is planned with its own images and grid resolution. The
+    // block with the largest footprint, i.e., the one that needs the largest
+    // downscale and then the smallest batch, bounds the training of all
+    // blocks, and the block with the largest network bounds the rendering.
+    Planner::Settings settings;
+    std::string largest;
+    int n_images = 0;
+    int n_resident_blocks = n_blocks;
+    int64_t rendering = 0;
+    bool fits = true;
+    for (const std::string& block : blocks) {
+        BlockNerfFrames frames = ngp::read_block_nerf_frames(path, block);
+        Planner::Dataset dataset;
+        for (const ivec2& res : frames.resolutions) {
+            dataset.images.emplace_back(res.x, res.y);
+        }
+
+        // The AABB scale of the block, as in load_block_nerf_data().
+        Planner::Network block_network = network;
+        if (block_network.per_level_scale <= 0.0 &&
+            block_network.n_levels > 1) {
+            double aabb_scale = frames.setting.value("aabb_scale", 1.0);
+            block_network.per_level_scale = std::exp(std::log(
+                    2048.0 * aabb_scale / block_network.base_resolution) /
+                    (block_network.n_levels - 1));
+        }
+        block_network.per_level_scale =
+                std::max(block_network.per_level_scale, 1.0);
+
+        Planner::Settings s;
+        planner.Plan(dataset, block_network, n_blocks, &s);
+        if (largest.empty() || s.downscale > settings.downscale ||
+            (s.downscale == settings.downscale &&
+             (s.batch_size < settings.batch_size ||
+              (s.batch_size == settings.batch_size &&
+               s.training.total() > settings.training.total())))) {
+            settings = s;
+            largest = block;
+            n_images = dataset.images.size();
+        }
+        if (s.n_resident_blocks < n_resident_blocks || rendering == 0) {
+            n_resident_blocks = s.n_resident_blocks;
+            rendering = s.rendering;
+        }
+        fits = fits && s.fits;
+
+        if (block_frames) {
+            (*block_frames)[block] = std::move(frames);
+        }
+    }
+    settings.n_resident_blocks = n_resident_blocks;
+    settings.rendering = rendering;
+    settings.fits = fits;
+
+    const Planner::Footprint& f = settings.training;
+    auto mb = [](int64_t bytes) { return bytes / (1 << 20); };
+    tlog::info() << "Memory of block " << largest << " ("
+                 << n_images << " images): dataset "
+                 << mb(f.dataset()) << " MB (images " << mb(f.images)
+                 << ", error map " << mb(f.error_map) << "), model "
+                 << mb(f.model()) << " MB (parameters " << mb(f.parameters)
+                 << ", optimizer " << mb(f.optimizer) << ", density grid "
+                 << mb(f.density_grid) << "), batch " << mb(f.batch)
+                 << " MB.";
+    if (settings.fits) {
+        tlog::success() << "Planned " << mb(f.total()) << " of "
+                        << mb(m_memory_budget) << " MB: downscale "
+                        << settings.downscale << ", batch size "
+                        << settings.batch_size << ", "
+                        << settings.n_resident_blocks << " of " << n_blocks
+                        << " resident blocks.";
+    } else {
+        tlog::warning() << "The street view does not fit in "
+                        << mb(m_memory_budget) << " MB, using downscale "
+                        << settings.downscale << ", batch size "
+                        << settings.batch_size << " (" << mb(f.total())
+                        << " MB), " << settings.n_resident_blocks << " of "
+                        << n_blocks << " resident blocks.";
+    }
+    return settings;
+}
+
 void Testbed::train_street_view_nerf(const fs::path& path) {
     if (path.empty()) return;
     CHECK(path.exists());
@@ -390,11 +733,28 @@ void Testbed::train_street_view_nerf(const fs::path& path) {
         loader.Load(&m_point_cloud);
     }
 
+    // Fit the largest block in the memory budget, if any. The frames read by
+    // the planner are loaded as they are.
+    int downscale = 1;
+    std::map<std::string, BlockNerfFrames> block_frames;
+    if (m_memory_budget > 0) {
+        cl::MemoryPlanner::Settings settings =
+                plan_street_view_memory(path, &block_frames);
+        downscale = settings.downscale;
+        m_training_batch_size = settings.batch_size;
+    }
+
     // Find all blocks.
     for (const auto& block_path : fs::directory(path / "blocks")) {
         std::string block = block_path.basename();
         if (block.empty() || block[0] != 'b') continue;
-        load_block_nerf_data(path, block);
+        auto frames = block_frames.find(block);
+        if (frames != block_frames.end()) {
+            load_block_nerf_data(path, frames->second, downscale);
+            block_frames.erase(frames);
+        } else {
+            load_block_nerf_data(path, block, downscale);
+        }
         m_training_data_available = true;
 
         LOG(INFO) << "Training block: " << block;
@@ -412,11 +772,247 @@ void Testbed::train_street_view_nerf(const fs::path& path) {
 
         m_train = false;
         this->save_block_nerf(block_path / "nerf.ingp", true);
+        this->save_block_extrinsics(block_path / "extrinsics.json");
     }
 
     LOG(INFO) << "Done.";
 }
 
+void Testbed::save_block_extrinsics(const fs::path& path) {
+    auto& training = m_nerf.training;
+
+    // The camera-to-world matrices of the block in world units, refined if
+    // the extrinsics were optimized. The images identify the frames shared
+    // with the other blocks.
+    nlohmann::json frames = nlohmann::json::array();
+    for (int i = 0; i < (int)training.dataset.n_images; ++i) {
+        frames.push_back({
+            {"image", training.dataset.paths[i]},
+            {"transform_matrix", training.get_camera_extrinsics(i)},
+        });
+    }
+
+    std::ofstream f{native_string(path)};
+    f << nlohmann::json{{"frames", frames}}.dump(4);
+    CHECK(f.good()) << path;
+}
+
+void Testbed::align_street_view_nerf(const fs::path& path) {
+    if (path.empty()) return;
+    CHECK(path.exists());
+
+    // Find all trained blocks, sorted by index.
+    cl::Array<fs::path> block_paths;
+    cl::Array<int> blocks;
+    for (const auto& block_path : fs::directory(path / "blocks")) {
+        std::string block = block_path.basename();
+        if (block.empty() || block[0] != 'b') continue;
+        if (!(block_path / "extrinsics.json").exists()) {
+            tlog::warning() << "No extrinsics in " << block_path
+                            << ", the block is not aligned.";
+            continue;
+        }
+        block_paths.push_back(block_path);
+        blocks.push_back(std::atoi(block.substr(1).c_str()));
+    }
+    cl::Array<int> seq;
+    cl::IndexSort(blocks.begin(), blocks.end(), &seq);
+
+    using Aligner = cl::point_cloud::BlockAligner<double>;
+    cl::Array<Aligner::Observation> observations;
+    std::unordered_map<std::string, int> frames;
+    for (int k = 0; k < seq.size(); ++k) {
+        fs::path extrinsics_path = block_paths[seq[k]] / "extrinsics.json";
+        std::ifstream f{native_string(extrinsics_path)};
+        nlohmann::json extrinsics = nlohmann::json::parse(f, nullptr, true,
+                                                          true);
+        for (const auto& frame : extrinsics["frames"]) {
+            std::string image = frame["image"];
+            mat4x3 m = frame["transform_matrix"];
+
+            Aligner::Observation o;
+            o.block = k;
+            o.frame = frames.emplace(image, (int)frames.size()).first->second;
+            o.center = cl::RPoint3D(m[3].x, m[3].y, m[3].z);
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    o.rotation(r, c) = m[c][r];
+                }
+            }
+            observations.push_back(o);
+        }
+    }
+
+    Aligner aligner;
+    Aligner::Summary summary;
+    cl::Array<Aligner::Similarity> transforms;
+    aligner.Align(seq.size(), observations, &transforms, &summary);
+
+    // Written next to the snapshots, for load_block_nerf().
+    for (int k = 0; k < seq.size(); ++k) {
+        const Aligner::Similarity& t = transforms[k];
+        mat3 rotation;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                rotation[c][r] = (float)t.rotation(r, c);
+            }
+        }
+        nlohmann::json alignment = {
+            {"scale", t.scale},
+            {"rotation", rotation},
+            {"translation", vec3(t.translation.x, t.translation.y,
+                                 t.translation.z)},
+        };
+
+        fs::path alignment_path = block_paths[seq[k]] / "alignment.json";
+        std::ofstream f{native_string(alignment_path)};
+        f << alignment.dump(4);
+        CHECK(f.good()) << alignment_path;
+    }
+
+    tlog::success() << "Aligned " << seq.size() << " blocks with "
+                    << summary.n_constraints << " shared frames in "
+                    << summary.n_iterations << " iterations: position RMSE "
+                    << summary.initial_position_rmse << " -> "
+                    << summary.final_position_rmse << ", rotation RMSE "
+                    << summary.initial_rotation_rmse << " -> "
+                    << summary.final_rotation_rmse << ", "
+                    << summary.n_outliers << " outliers.";
+}
+
+/**
+ * Stitch the meshes of the blocks of a street view into 'path/mesh.obj'.
+ *
+ * Each block needs 'blocks/bN/mesh.obj', as written by save_mesh() from the
+ * density of its NeRF, and its snapshot 'nerf.ingp'. The blocks are placed by
+ * their 'alignment.json' if any, and the stitched mesh is in the aligned NeRF
+ * frame, i.e., the frame of the camera poses.
+ */
+void Testbed::stitch_street_view_mesh(const fs::path& path) {
+    if (path.empty()) return;
+    CHECK(path.exists());
+
+    // Find all blocks with a mesh, sorted by index.
+    cl::Array<fs::path> block_paths;
+    cl::Array<int> blocks;
+    for (const auto& block_path : fs::directory(path / "blocks")) {
+        std::string block = block_path.basename();
+        if (block.empty() || block[0] != 'b') continue;
+        if (!(block_path / "mesh.obj").exists()) {
+            tlog::warning() << "No mesh in " << block_path
+                            << ", the block is not stitched.";
+            continue;
+        }
+        block_paths.push_back(block_path);
+        blocks.push_back(std::atoi(block.substr(1).c_str()));
+    }
+    cl::Array<int> seq;
+    cl::IndexSort(blocks.begin(), blocks.end(), &seq);
+
+    using Stitcher = cl::geometry::BlockMeshStitcher<double>;
+    cl::Array<Stitcher::BlockMesh> meshes(seq.size());
+    for (int k = 0; k < seq.size(); ++k) {
+        const fs::path& block_path = block_paths[seq[k]];
+        Stitcher::BlockMesh& mesh = meshes[k];
+
+        // The frame of the block, as in load_block_nerf().
+        auto config = load_network_config(block_path / "nerf.ingp");
+        CHECK(config.contains("snapshot")) << block_path;
+        const auto& snapshot = config["snapshot"];
+        float data_scale = snapshot["nerf"]["scale"];
+        vec3 data_offset = snapshot["nerf"]["offset"];
+        BoundingBox camera_aabb = snapshot["camera_aabb"];
+
+        float alignment_scale = 1.0f;
+        mat3 alignment_rotation = mat3(1.0f);
+        vec3 alignment_translation = vec3(0.0f);
+        fs::path alignment_path = block_path / "alignment.json";
+        if (alignment_path.exists()) {
+            std::ifstream f{native_string(alignment_path)};
+            nlohmann::json alignment = nlohmann::json::parse(f, nullptr, true,
+                                                             true);
+            alignment_scale = alignment["scale"];
+            alignment_rotation = alignment["rotation"];
+            alignment_translation = alignment["translation"];
+        }
+
+        // The block owns the space nearest to its cameras.
+        vec3 site = alignment_rotation * camera_aabb.center() *
+                    alignment_scale + alignment_translation;
+        mesh.site = cl::RPoint3D(site.x, site.y, site.z);
+        mesh.scale = data_scale;
+        mesh.offset = cl::RVector3D(data_offset.x, data_offset.y,
+                                    data_offset.z);
+
+        // The mesh is written by save_mesh() with the scale and offset of the
+        // block: a vertex is (p - offset) / scale for a position p in the
+        // cycled (y, z, x) axes of ngp. It is mapped back to p, then to the
+        // NeRF frame of the block as ngp_position_to_nerf() and
+        // set_block_nerf() do, then to the aligned frame of the sites. The
+        // stitcher takes it normalized by the scale and offset of the block.
+        fs::path mesh_path = block_path / "mesh.obj";
+        cl::io::LineReader line_reader;
+        CHECK(line_reader.Open(mesh_path.str()));
+        cl::Array<std::string> parse;
+        cl::Array<int> face;
+        while (char* line = line_reader.ReadLine()) {
+            cl::StringSplit(std::string(line), &parse);
+            if (parse.empty()) continue;
+
+            if (parse[0] == "v") {
+                CHECK(parse.size() >= 4) << parse;
+                vec3 v(std::stof(parse[1]), std::stof(parse[2]),
+                       std::stof(parse[3]));
+                v = v * data_scale + data_offset;
+                v = (vec3(v.z, v.x, v.y) - data_offset) / data_scale;
+                v = alignment_rotation * v * alignment_scale +
+                    alignment_translation;
+                v = v * data_scale + data_offset;
+                mesh.vertices.emplace_back(v.x, v.y, v.z);
+            } else if (parse[0] == "f") {
+                // Faces are 'v', 'v/vt' or 'v//vn', fanned. The indices are
+                // 1-based, or relative to the last vertex if negative.
+                face.clear();
+                for (int i = 1; i < parse.size(); ++i) {
+                    int index = std::atoi(parse[i].c_str());
+                    index += index < 0 ? mesh.vertices.size() : -1;
+                    CHECK(index >= 0 && index < mesh.vertices.size())
+                        << mesh_path << ":" << line_reader.n_line()
+                        << ": vertex " << parse[i] << " is not defined.";
+                    face.push_back(index);
+                }
+                CHECK(face.size() >= 3) << parse;
+                for (int i = 1; i + 1 < face.size(); ++i) {
+                    mesh.triangles.insert({ face[0], face[i], face[i + 1] });
+                }
+            }
+        }
+    }
+
+    Stitcher stitcher;
+    Stitcher::Mesh mesh;
+    Stitcher::Summary summary;
+    stitcher.Stitch(meshes, &mesh, &summary);
+
+    fs::path mesh_path = path / "mesh.obj";
+    std::ofstream f{native_string(mesh_path)};
+    for (const cl::RPoint3D& v : mesh.vertices) {
+        f << "v " << v.x << " " << v.y << " " << v.z << "\n";
+    }
+    for (int i = 0; i < mesh.triangles.size(); i += 3) {
+        f << "f " << mesh.triangles[i] + 1 << " " << mesh.triangles[i + 1] + 1
+          << " " << mesh.triangles[i + 2] + 1 << "\n";
+    }
+    CHECK(f.good()) << mesh_path;
+
+    tlog::success() << "Stitched " << seq.size() << " block meshes into '"
+                    << mesh_path.str() << "': " << summary.n_input_triangles
+                    << " -> " << mesh.triangles.size() / 3 << " triangles, "
+                    << summary.n_cut_triangles << " cut, "
+                    << summary.n_split_edges << " seam edges split, "
+                    << summary.n_welded_vertices << " vertices welded.";
+}
+
 void Testbed::render_street_view_nerf(const fs::path& path) {
     if (path.empty()) return;
     CHECK(path.exists());
@@ -436,6 +1032,16 @@ void Testbed::render_street_view_nerf(const fs::path& path) {
     cl::Array<int> seq;
     cl::IndexSort(blocks.begin(), blocks.end(), &seq);
 
+    // All blocks are loaded, which may not fit in the memory budget.
+    if (m_memory_budget > 0) {
+        cl::MemoryPlanner::Settings settings = plan_street_view_memory(path);
+        if (settings.n_resident_blocks < blocks.size()) {
+            tlog::warning() << "Only " << settings.n_resident_blocks
+                            << " of " << blocks.size()
+                            << " blocks fit in the memory budget.";
+        }
+    }
+
     m_block_nerfs.clear();
     for (int i : seq) {
         // Load trained NeRF.
@@ -498,6 +1104,7 @@ void Testbed::render_street_view_nerf(const fs::path& path) {
 
     CHECK(!m_block_nerfs.empty());
     m_current_block_nerf = &m_block_nerfs.front();
+    reset_block_compositor();
 
     tlog::success() << "Done.";
 }
@@ -530,16 +1137,7 @@ void Testbed::save_block_nerf(const fs::path& path, bool compress) {
     snapshot["nerf_aabb"] = BoundingBox(v1, v2);
 
     m_network_config_path = path;
-    std::ofstream f{native_string(m_network_config_path),
-                    std::ios::out | std::ios::binary};
-    if (equals_case_insensitive(m_network_config_path.extension(), "ingp")) {
-        // zstr::ofstream applies zlib compression.
-        zstr::ostream zf{f, zstr::default_buff_size,
-                         compress ? Z_DEFAULT_COMPRESSION : Z_NO_COMPRESSION};
-        json::to_msgpack(m_network_config, zf);
-    } else {
-        json::to_msgpack(m_network_config, f);
-    }
+    save_network_config(path, compress);
 
     tlog::success() << "Saved block NeRF '" << path.str() << "'";
 }
@@ -576,6 +1174,17 @@ void Testbed::load_block_nerf(const fs::path& path) {
     model.camera_aabb = snapshot["camera_aabb"];
     model.nerf_aabb = snapshot["nerf_aabb"];
 
+    // The alignment of align_street_view_nerf(), if any.
+    fs::path alignment_path = path.parent_path() / "alignment.json";
+    if (alignment_path.exists()) {
+        std::ifstream f{native_string(alignment_path)};
+        nlohmann::json alignment = nlohmann::json::parse(f, nullptr, true,
+                                                         true);
+        model.alignment_scale = alignment["scale"];
+        model.alignment_rotation = alignment["rotation"];
+        model.alignment_translation = alignment["translation"];
+    }
+
     load_nerf_post();
 
     GPUMemory<__half> density_grid_fp16 = snapshot["density_grid_binary"];
@@ -719,6 +1328,60 @@ void Testbed::reset_nerf_network(BlockNeRFModel& model) {
     set_all_devices_dirty();
 }
 
+/**
+ * Set the blocks of the compositor from the loaded block NeRFs: the boxes are
+ * mapped to the frame shared by the aligned blocks, and the visibility is the
+ * occupancy of the finest cascade of the density grid, relative to the most
+ * occupied block.
+ */
+void Testbed::reset_block_compositor() {
+    auto aligned_box = [](const BlockNeRFModel& model, const BoundingBox& box) {
+        cl::Array<cl::RPoint3D> corners;
+        for (int i = 0; i < 8; ++i) {
+            vec3 v(i & 1 ? box.max.x : box.min.x,
+                   i & 2 ? box.max.y : box.min.y,
+                   i & 4 ? box.max.z : box.min.z);
+            v = model.alignment_rotation * v * model.alignment_scale +
+                model.alignment_translation;
+            corners.emplace_back(v.x, v.y, v.z);
+        }
+        return cl::RBox3D(corners.begin(), corners.end());
+    };
+
+    using Compositor = cl::point_cloud::BlockCompositor<double>;
+    cl::Array<Compositor::Block> blocks;
+    std::vector<float> density_grid;
+    double max_occupancy = 0.0;
+    for (const BlockNeRFModel& model : m_block_nerfs) {
+        density_grid.resize(model.density_grid.size());
+        model.density_grid.copy_to_host(density_grid);
+
+        // The threshold of the density grid bitfield.
+        const uint32_t n_cells = NERF_GRID_N_CELLS();
+        double mean = 0.0;
+        for (uint32_t i = 0; i < n_cells; ++i) {
+            mean += std::max(density_grid[i], 0.0f);
+        }
+        mean /= n_cells;
+        float threshold = std::min(NERF_MIN_OPTICAL_THICKNESS(), (float)mean);
+        int n_occupied = 0;
+        for (uint32_t i = 0; i < n_cells; ++i) {
+            if (density_grid[i] > threshold) ++n_occupied;
+        }
+
+        double occupancy = (double)n_occupied / n_cells;
+        max_occupancy = std::max(max_occupancy, occupancy);
+        blocks.emplace_back(aligned_box(model, model.camera_aabb),
+                            aligned_box(model, model.nerf_aabb), occupancy);
+    }
+    for (Compositor::Block& block : blocks) {
+        block.visibility = max_occupancy > 0.0
+                         ? block.visibility / max_occupancy : 1.0;
+    }
+
+    m_block_compositor.Reset(blocks);
+}
+
 /**
  * Set current block nerf for rendering.
  */
@@ -734,11 +1397,30 @@ void Testbed::set_block_nerf(BlockNeRFModel& model) {
     std::swap(camera_pos[0], camera_pos[1]);
     camera_pos = (camera_pos - m_nerf.training.dataset.offset) /
                  m_nerf.training.dataset.scale;
+
+    // Pass through the frame shared by the aligned blocks.
+    mat3 rotation = mat3(1.0f);
+    if (m_current_block_nerf) {
+        const BlockNeRFModel& current = *m_current_block_nerf;
+        camera_pos = current.alignment_rotation * camera_pos *
+                     current.alignment_scale + current.alignment_translation;
+        rotation = current.alignment_rotation;
+    }
+    camera_pos = transpose(model.alignment_rotation) *
+                 (camera_pos - model.alignment_translation) /
+                 model.alignment_scale;
+    rotation = transpose(model.alignment_rotation) * rotation;
+
     camera_pos = camera_pos * model.data_scale + model.data_offset;
     std::swap(camera_pos[0], camera_pos[1]);
     std::swap(camera_pos[1], camera_pos[2]);
 
     // Set camera to current block nerf.
+    for (int i = 0; i < 3; ++i) {
+        vec3 axis = m_camera[i];
+        axis = rotation * vec3(axis.z, axis.x, axis.y);
+        m_camera[i] = vec3(axis.y, axis.z, axis.x);
+    }
     m_camera[3] = camera_pos;
     m_nerf.training.dataset.offset = model.data_offset;
     m_nerf.training.dataset.scale = model.data_scale;
@@ -918,13 +1600,15 @@ void Testbed::dump_parameters_as_images(const T* params, const std::string& file
     size_t n_params = m_network->n_params();
     size_t n_non_layer_params = n_params - layer_params;
 
-    std::vector<T> params_cpu_network_precision(layer_params + next_multiple(n_non_layer_params, non_layer_params_width));
-    std::vector<float> params_cpu(params_cpu_network_precision.size(), 0.0f);
-    CUDA_CHECK_THROW(cudaMemcpy(params_cpu_network_precision.data(), params, n_params * sizeof(T), cudaMemcpyDeviceToHost));
+    // Converts on the GPU, so that a single copy brings the floats to the host.
+    GPUMemory<float> params_fp32(n_params);
+    parallel_for_gpu(m_stream.get(), n_params, [params, params_fp32=params_fp32.data()] __device__ (size_t i) {
+        params_fp32[i] = (float)params[i];
+    });
 
-    for (size_t i = 0; i < n_params; ++i) {
-        params_cpu[i] = (float)params_cpu_network_precision[i];
-    }
+    std::vector<float> params_cpu(layer_params + next_multiple(n_non_layer_params, non_layer_params_width), 0.0f);
+    CUDA_CHECK_THROW(cudaMemcpyAsync(params_cpu.data(), params_fp32.data(), n_params * sizeof(float), cudaMemcpyDeviceToHost, m_stream.get()));
+    CUDA_CHECK_THROW(cudaStreamSynchronize(m_stream.get()));
 
     size_t offset = 0;
     size_t layer_id = 0;
@@ -1157,14 +1841,15 @@ void Testbed::imgui() {
             float norm = 1.0f / n;
             for (uint32_t i = 0; i < n; ++i) {
                 for (uint32_t j = 0; j < n_extra_dims; ++j) {
-                    mean[j] += m_nerf.training.extra_dims_opt[i].variable()[j] * norm;
+                    mean[j] += m_nerf.training.extra_dims_opt.variable(i)[j] * norm;
                 }
             }
 
             std::vector<float> cov(n_extra_dims * n_extra_dims, 0.0f);
             float scale = 0.001f;	// compute scale
             for (uint32_t i = 0; i < n; ++i) {
-                std::vector<float> v = m_nerf.training.extra_dims_opt[i].variable();
+                const float* var = m_nerf.training.extra_dims_opt.variable(i);
+                std::vector<float> v(var, var + n_extra_dims);
                 for (uint32_t j = 0; j < n_extra_dims; ++j) {
                     v[j] -= mean[j];
                 }
@@ -1235,7 +1920,8 @@ void Testbed::imgui() {
             for (uint32_t i = 0; i < n; ++i) {
                 vec2 p = vec2(0.0f);
 
-                std::vector<float> v = m_nerf.training.extra_dims_opt[i].variable();
+                const float* var = m_nerf.training.extra_dims_opt.variable(i);
+                std::vector<float> v(var, var + n_extra_dims);
                 for (uint32_t j = 0; j < n_extra_dims; ++j) {
                     p.x += (v[j] - mean[j]) * X[j] / scale;
                     p.y += (v[j] - mean[j]) * Y[j] / scale;
@@ -1719,7 +2405,7 @@ void Testbed::imgui() {
                 if (m_nerf.training.optimize_exposure) {
                     std::vector<float> exposures(m_nerf.training.dataset.n_images);
                     for (uint32_t i = 0; i < m_nerf.training.dataset.n_images; ++i) {
-                        exposures[i] = m_nerf.training.cam_exposure[i].variable().x;
+                        exposures[i] = m_nerf.training.cam_exposure.variable(i)[0];
                     }
 
                     ImGui::PlotLines("Training view exposures", exposures.data(), exposures.size(), 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 60.f));
@@ -1761,6 +2447,7 @@ void Testbed::imgui() {
                     if (ImGui::Button("Play block NeRF")) {
                         m_current_camera_path_distance = 0.0;
                         m_play_block_nerf = 1;
+                        m_block_compositor.Restart();
                         set_block_nerf(m_block_nerfs.front());
                     }
                     ImGui::SameLine();
@@ -1916,6 +2603,7 @@ void Testbed::imgui() {
         }
         ImGui::Checkbox("Compress", &m_compress_snapshot);
         if (!can_compress) ImGui::EndDisabled();
+        ImGui::SliderInt("Quantization bits (0: off)", &m_snapshot_codec.grid_bits, 0, 8);
     }
 
     if (m_testbed_mode == ETestbedMode::Sdf) {
@@ -1943,6 +2631,28 @@ void Testbed::imgui() {
         ImGui::SameLine();
         ImGui::Text("%0.1f%% values snapped to 0", m_quant_percent);
 
+        auto& telemetry = m_parameter_telemetry;
+        int interval = (int)telemetry.settings.interval;
+        if (ImGui::SliderInt("Snapshot interval (steps)", &interval, 1, 1000, "%d", ImGuiSliderFlags_Logarithmic)) {
+            telemetry.settings.interval = (uint32_t)interval;
+        }
+        ImGui::SliderInt("Quantization bits##Telemetry", &telemetry.settings.quantization_bits, 1, 8);
+        ImGui::InputText("File##Telemetry file path", m_imgui.telemetry_path, sizeof(m_imgui.telemetry_path));
+        ImGui::SameLine();
+        if (!telemetry.series_open()) {
+            if (ImGui::Button("Record")) {
+                try {
+                    record_parameter_telemetry(m_imgui.telemetry_path);
+                } catch (std::exception& e) {
+                    imgui_error_string = fmt::format("Failed to record parameter telemetry: {}", e.what());
+                    ImGui::OpenPopup("Error");
+                }
+            }
+        } else if (ImGui::Button("Stop")) {
+            stop_parameter_telemetry();
+        }
+        ImGui::Text("Statistics of step %u, recorded as CSV or binary (by extension)", m_parameter_stats.training_step);
+
         std::vector<float> f(m_n_levels);
 
 
@@ -2643,7 +3353,7 @@ void Testbed::blit_textures(const Foveation& foveation,
     glUniform1i(glGetUniformLocation(m_blit_program, "depth_texture"), 1);
     glUniform1i(glGetUniformLocation(m_blit_program, "rgba_texture1"), 2);
     glUniform1i(glGetUniformLocation(m_blit_program, "depth_texture1"), 3);
-    glUniform1i(glGetUniformLocation(m_blit_program, "blend_rate"), m_block_blend_rate);
+    glUniform1f(glGetUniformLocation(m_blit_program, "blend_rate"), m_block_blend_rate);
 
     auto bind_warp = [&](const FoveationPiecewiseQuadratic& warp, const std::string& uniform_name) {
         glUniform1f(glGetUniformLocation(m_blit_program, (uniform_name + ".al").c_str()), warp.al);
@@ -3217,7 +3927,9 @@ void Testbed::render_block_nerf(bool skip_rendering) {
             factor = 8.f / (float)m_fixed_res_factor;
         }
 
-        factor = tcnn::clamp(factor, 1.0f / 16.0f, 1.0f);
+        // The share of the frame given to this block by the compositor.
+        factor = tcnn::clamp(factor * std::sqrt(m_block_render_budget),
+                             1.0f / 16.0f, 1.0f);
 
         m_view.render_buffer->disable_dlss();
 
@@ -3616,61 +4328,32 @@ bool Testbed::frame() {
         m_fps_camera = true;
         cl::RPoint3D p = m_block_camera_path.GetCurvePoint(cl::Clamp(rate, 0.0, 1.0));
 
-        BlockNeRFModel* current_block_nerf = m_current_block_nerf;
-        int next = m_current_block_nerf->id + 1;
-        if (next == m_block_nerfs.size()) {
-            m_play_block_nerf = 0;
-        } else {
-            // Find the current block.
-            BlockNeRFModel* next_block_nerf = &m_block_nerfs[next];
-            vec3 v1 = current_block_nerf->camera_aabb.center();
-            cl::RPoint3D c1(v1.x, v1.y, v1.z);
-            vec3 v2 = next_block_nerf->camera_aabb.center();
-            cl::RPoint3D c2(v2.x, v2.y, v2.z);
-            if (cl::Distance(p, c1) > cl::Distance(p, c2)) {
-                current_block_nerf = next_block_nerf;
-            }
-
-            this->set_block_nerf(*current_block_nerf);
-            this->reset_accumulation(true);
-
-            cl::RPoint3D q = p * m_current_block_nerf->data_scale +
-                    cl::RVector3D(m_current_block_nerf->data_offset.x,
-                                  m_current_block_nerf->data_offset.y,
-                                  m_current_block_nerf->data_offset.z);
-            m_camera[3] = vec3(q.y, q.z, q.x);
-            m_current_camera_path_distance = dis;
-
-            // Find all blocks that overlap the current camera.
-            int next = m_current_block_nerf->id + 1;
-            if (next == m_block_nerfs.size()) {
-                m_play_block_nerf = 0;
-            } else {
-//                BlockNeRFModel* next_block_nerf = &m_block_nerfs[next];
-                m_current_block_nerfs.clear();
-                m_current_block_nerfs.push_back(m_current_block_nerf);
-//                m_current_block_nerfs.push_back(next_block_nerf);
-
-//                while (m_rgba_render_textures.size() < m_current_block_nerfs.size()) {
-//                    m_rgba_render_textures.emplace_back(std::make_shared<GLTexture>());
-//                    m_depth_render_textures.emplace_back(std::make_shared<GLTexture>());
-//                }
-
-//                vec3 v1 = m_current_block_nerf->nerf_aabb.center();
-//                vec3 v2 = next_block_nerf->nerf_aabb.center();
-//                cl::RPoint3D q1(v1.x, v1.y, v1.z);
-//                cl::RPoint3D q2(v2.x, v2.y, v2.z);
-//                double dis1 = cl::Distance(q1, q2);
-//                double dis2 = cl::Distance(p, q1);
-//                double dis3 = cl::Distance(p, q2);
-//                if (dis3 > dis1)
-//                    m_block_blend_rate = 0.0f;
-//                else if (dis2 > dis1)
-//                    m_block_blend_rate = 1.0f;
-//                else
-//                    m_block_blend_rate = dis2 / dis1;
-            }
-        }
+        // Plan the blocks composited at this frame.
+        m_block_compositor.Plan(p, &m_block_frame);
+        m_current_block_nerfs.clear();
+        for (int b : m_block_frame.blocks) {
+            m_current_block_nerfs.push_back(&m_block_nerfs[b]);
+        }
+        while (m_rgba_render_textures.size() < m_current_block_nerfs.size()) {
+            m_rgba_render_textures.emplace_back(std::make_shared<GLTexture>());
+            m_depth_render_textures.emplace_back(std::make_shared<GLTexture>());
+        }
+        m_rgba_render_textures.resize(m_current_block_nerfs.size());
+        m_depth_render_textures.resize(m_current_block_nerfs.size());
+
+        // The blit shader mixes the second block into the primary one.
+        m_block_blend_rate = m_block_frame.weights.size() > 1
+                           ? (float)m_block_frame.weights[1] : 0.0f;
+
+        // Move the camera in the frame of the primary block.
+        BlockNeRFModel& primary = *m_current_block_nerfs.front();
+        this->set_block_nerf(primary);
+        vec3 v = transpose(primary.alignment_rotation) *
+                 (vec3(p.x, p.y, p.z) - primary.alignment_translation) /
+                 primary.alignment_scale;
+        v = v * primary.data_scale + primary.data_offset;
+        m_camera[3] = vec3(v.y, v.z, v.x);
+        m_current_camera_path_distance = dis;
     } else if (m_play_block_nerf == 0) {
         m_current_block_nerfs.resize(1);
         m_rgba_render_textures.resize(1);
@@ -3730,8 +4413,11 @@ bool Testbed::frame() {
                                                                       m_depth_render_textures[i]);
             m_view.render_buffer->disable_dlss();
             m_view.render_buffer->resize(render_res);
+            m_block_render_budget = i >= m_block_frame.budgets.size()
+                                  ? 1.0f : (float)m_block_frame.budgets[i];
             render_block_nerf(skip_rendering);
         }
+        m_block_render_budget = 1.0f;
     }
     //--------------------------------------------------------------------------
 
@@ -3741,13 +4427,14 @@ bool Testbed::frame() {
         m_sdf.iou_decay = 0.f;
     }
 
+    // Non-blocking: snapshots and results are pipelined over the frames.
+    if (m_gather_histograms || m_parameter_telemetry.series_open()) {
+        gather_histograms();
+    }
+
 #ifdef NGP_GUI
     if (m_render_window) {
         if (m_gui_redraw) {
-            if (m_gather_histograms) {
-                gather_histograms();
-            }
-
             draw_gui();
             m_gui_redraw = false;
 
@@ -4012,12 +4699,9 @@ void Testbed::reset_network(bool clear_density_grid) {
 
     size_t n_encoding_params = 0;
     if (m_testbed_mode == ETestbedMode::Nerf) {
-        m_nerf.training.cam_exposure.resize(m_nerf.training.dataset.n_images,
-                                            AdamOptimizer<vec3>(1e-3f));
-        m_nerf.training.cam_pos_offset.resize(m_nerf.training.dataset.n_images,
-                                              AdamOptimizer<vec3>(1e-4f));
-        m_nerf.training.cam_rot_offset.resize(m_nerf.training.dataset.n_images,
-                                              RotationAdamOptimizer(1e-4f));
+        m_nerf.training.cam_exposure.resize(m_nerf.training.dataset.n_images);
+        m_nerf.training.cam_pos_offset.resize(m_nerf.training.dataset.n_images);
+        m_nerf.training.cam_rot_offset.resize(m_nerf.training.dataset.n_images);
         m_nerf.training.cam_focal_length_offset = AdamOptimizer<vec2>(1e-5f);
 
         m_nerf.training.reset_extra_dims(m_rng);
@@ -4732,7 +5416,7 @@ void Testbed::render_frame_epilogue(
             if (m_ground_truth_render_mode == EGroundTruthRenderMode::Shade) {
                 render_buffer.overlay_image(
                     m_ground_truth_alpha,
-                    vec3(m_exposure) + m_nerf.training.cam_exposure[m_nerf.training.view].variable(),
+                    vec3(m_exposure) + m_nerf.training.cam_exposure.variable_as<vec3>(m_nerf.training.view),
                     m_background_color,
                     output_color_space,
                     metadata.pixels,
@@ -4810,22 +5494,15 @@ void Testbed::autofocus() {
     }
 }
 
-Testbed::LevelStats compute_level_stats(const float* params, size_t n_params) {
+Testbed::LevelStats to_level_stats(const cl::ParameterStats& stats) {
     Testbed::LevelStats s = {};
-    for (size_t i = 0; i < n_params; ++i) {
-        float v = params[i];
-        float av = fabsf(v);
-        if (av < 0.00001f) {
-            s.numzero++;
-        } else {
-            if (s.count == 0) s.min = s.max = v;
-            s.count++;
-            s.x += v;
-            s.xsquared += v * v;
-            s.min = min(s.min, v);
-            s.max = max(s.max, v);
-        }
-    }
+    s.x = (float)stats.sum;
+    s.xsquared = (float)stats.sum_squared;
+    s.min = stats.min;
+    s.max = stats.max;
+    s.numzero = (int)stats.n_zero;
+    s.numquant = (int)stats.n_snapped;
+    s.count = (int)stats.count;
     return s;
 }
 
@@ -4834,48 +5511,67 @@ void Testbed::gather_histograms() {
         return;
     }
 
-    int n_params = (int)m_network->n_params();
-    int first_encoder = first_encoder_param();
-    int n_encoding_params = n_params - first_encoder;
-
     auto hg_enc = dynamic_cast<GridEncoding<network_precision_t>*>(m_encoding.get());
-    if (hg_enc && m_trainer->params()) {
-        std::vector<float> grid(n_encoding_params);
+    if (!hg_enc || !m_trainer->params()) {
+        return;
+    }
 
-        uint32_t m = m_network->layer_sizes().front().first;
-        uint32_t n = m_network->layer_sizes().front().second;
-        std::vector<float> first_layer_rm(m * n);
+    // The statistics are computed off the training loop, so they lag behind
+    // it by the few frames of the copy and the analysis.
+    ParameterTelemetryResult result;
+    if (m_parameter_telemetry.poll(result)) {
+        m_parameter_stats = std::move(result);
+    }
 
-        CUDA_CHECK_THROW(cudaMemcpyAsync(grid.data(), m_trainer->params() + first_encoder, grid.size() * sizeof(float), cudaMemcpyDeviceToHost, m_stream.get()));
-        CUDA_CHECK_THROW(cudaMemcpyAsync(first_layer_rm.data(), m_trainer->params(), first_layer_rm.size() * sizeof(float), cudaMemcpyDeviceToHost, m_stream.get()));
-        CUDA_CHECK_THROW(cudaStreamSynchronize(m_stream.get()));
+    size_t first_encoder = first_encoder_param();
+    std::vector<ParameterBlock> blocks;
+    for (int l = 0; l < m_n_levels; ++l) {
+        blocks.push_back({fmt::format("level-{}", l), first_encoder + hg_enc->level_params_offset(l), hg_enc->level_n_params(l)});
+    }
 
+    uint32_t m = m_network->layer_sizes().front().first;
+    uint32_t n = m_network->layer_sizes().front().second;
+    blocks.push_back({"first-layer", 0, (size_t)m * n});
 
-        for (int l = 0; l < m_n_levels; ++l) {
-            m_level_stats[l] = compute_level_stats(grid.data() + hg_enc->level_params_offset(l), hg_enc->level_n_params(l));
-        }
+    // Fixed histogram scale to make it more comparable between levels.
+    m_parameter_telemetry.settings.histogram_scale = m_histo_scale;
+    m_parameter_telemetry.snapshot(m_stream.get(), m_trainer->params(), blocks, m_training_step);
 
-        int numquant = 0;
-        m_quant_percent = float(numquant * 100) / (float)n_encoding_params;
-        if (m_histo_level < m_n_levels) {
-            size_t nperlevel = hg_enc->level_n_params(m_histo_level);
-            const float* d = grid.data() + hg_enc->level_params_offset(m_histo_level);
-            float scale = 128.f / (m_histo_scale); // fixed scale for now to make it more comparable between levels
-            memset(m_histo, 0, sizeof(m_histo));
-            for (int i = 0; i < nperlevel; ++i) {
-                float v = *d++;
-                if (v == 0.f) {
-                    continue;
-                }
-                int bin = (int)floor(v * scale + 128.5f);
-                if (bin >= 0 && bin <= 256) {
-                    m_histo[bin]++;
-                }
-            }
+    if (m_parameter_stats.blocks.size() != blocks.size()) {
+        return;
+    }
+
+    size_t numquant = 0, n_encoding_params = 0;
+    for (int l = 0; l < m_n_levels; ++l) {
+        const cl::ParameterStats& stats = m_parameter_stats.blocks[l];
+        m_level_stats[l] = to_level_stats(stats);
+        numquant += stats.n_snapped;
+        n_encoding_params += stats.count + stats.n_zero;
+    }
+
+    m_quant_percent = n_encoding_params ? float(numquant * 100) / (float)n_encoding_params : 0.f;
+    if (m_histo_level < m_n_levels) {
+        const cl::Array<int64_t>& histogram = m_parameter_stats.blocks[m_histo_level].histogram;
+        for (int i = 0; i < 257; ++i) {
+            m_histo[i] = (float)histogram[i];
         }
     }
 }
 
+void Testbed::record_parameter_telemetry(const fs::path& path) {
+    auto format = equals_case_insensitive(path.extension(), "csv") ? ETelemetryFormat::Csv : ETelemetryFormat::Binary;
+    m_parameter_telemetry.open_series(path, format);
+}
+
+void Testbed::stop_parameter_telemetry() {
+    ParameterTelemetryResult result;
+    if (m_parameter_telemetry.flush(result)) {
+        m_parameter_stats = std::move(result);
+    }
+
+    m_parameter_telemetry.close_series();
+}
+
 void Testbed::save_snapshot(const fs::path& path, bool include_optimizer_state, bool compress) {
     m_network_config["snapshot"] = m_trainer->serialize(include_optimizer_state);
 
@@ -4930,16 +5626,56 @@ void Testbed::save_snapshot(const fs::path& path, bool include_optimizer_state,
     }
 
     m_network_config_path = path;
-    std::ofstream f{native_string(m_network_config_path), std::ios::out | std::ios::binary};
-    if (equals_case_insensitive(m_network_config_path.extension(), "ingp")) {
+    save_network_config(path, compress);
+
+    tlog::success() << "Saved snapshot '" << path.str() << "'";
+}
+
+void Testbed::save_network_config(const fs::path& path, bool compress) {
+    // The codec is applied to a copy, so that the snapshot in memory can still
+    // be used to reset the network.
+    json compressed_config;
+    const json* config = &m_network_config;
+    if (m_snapshot_codec.enabled() && m_network_config.contains("snapshot")) {
+        compressed_config = m_network_config;
+        compress_snapshot(compressed_config["snapshot"]);
+        config = &compressed_config;
+    }
+
+    std::ofstream f{native_string(path), std::ios::out | std::ios::binary};
+    if (equals_case_insensitive(path.extension(), "ingp")) {
         // zstr::ofstream applies zlib compression.
         zstr::ostream zf{f, zstr::default_buff_size, compress ? Z_DEFAULT_COMPRESSION : Z_NO_COMPRESSION};
-        json::to_msgpack(m_network_config, zf);
+        json::to_msgpack(*config, zf);
     } else {
-        json::to_msgpack(m_network_config, f);
+        json::to_msgpack(*config, f);
     }
+}
 
-    tlog::success() << "Saved snapshot '" << path.str() << "'";
+void Testbed::compress_snapshot(json& snapshot) {
+    auto hg_enc = dynamic_cast<GridEncoding<network_precision_t>*>(m_encoding.get());
+    if (hg_enc) {
+        std::vector<size_t> level_sizes(m_n_levels);
+        for (uint32_t l = 0; l < m_n_levels; ++l) {
+            level_sizes[l] = hg_enc->level_n_params(l);
+        }
+        m_snapshot_codec.encode_params(snapshot, first_encoder_param(), level_sizes);
+    } else {
+        tlog::warning() << "Snapshot codec: parameters are only compressed for hash-grid encodings.";
+    }
+
+    if (m_testbed_mode == ETestbedMode::Nerf && m_nerf.density_grid.size() == NERF_GRID_N_CELLS() * (m_nerf.max_cascade + 1)) {
+        // Bring the bitfield up to date with the grid, as it is done on load.
+        update_density_grid_mean_and_bitfield(m_stream.get());
+
+        std::vector<float> grid(m_nerf.density_grid.size());
+        std::vector<uint8_t> bitfield(grid.size() / 8);
+        CUDA_CHECK_THROW(cudaMemcpyAsync(grid.data(), m_nerf.density_grid.data(), grid.size() * sizeof(float), cudaMemcpyDeviceToHost, m_stream.get()));
+        CUDA_CHECK_THROW(cudaMemcpyAsync(bitfield.data(), m_nerf.density_grid_bitfield.data(), bitfield.size(), cudaMemcpyDeviceToHost, m_stream.get()));
+        CUDA_CHECK_THROW(cudaStreamSynchronize(m_stream.get()));
+
+        m_snapshot_codec.encode_density_grid(snapshot, grid, bitfield, NERF_GRID_N_CELLS());
+    }
 }
 
 void Testbed::load_snapshot(const fs::path& path) {
@@ -5051,9 +5787,9 @@ void Testbed::load_snapshot(const fs::path& path) {
         // in the first place), load dataset-specific optimized quantities, such as
         // extrinsics, exposure, latents.
         if (snapshot["nerf"].contains("dataset") && m_nerf.training.dataset.is_same(snapshot["nerf"]["dataset"])) {
-            if (snapshot["nerf"].contains("cam_pos_offset")) m_nerf.training.cam_pos_offset = snapshot["nerf"].at("cam_pos_offset").get<std::vector<AdamOptimizer<vec3>>>();
-            if (snapshot["nerf"].contains("cam_rot_offset")) m_nerf.training.cam_rot_offset = snapshot["nerf"].at("cam_rot_offset").get<std::vector<RotationAdamOptimizer>>();
-            if (snapshot["nerf"].contains("extra_dims_opt")) m_nerf.training.extra_dims_opt = snapshot["nerf"].at("extra_dims_opt").get<std::vector<VarAdamOptimizer>>();
+            if (snapshot["nerf"].contains("cam_pos_offset")) m_nerf.training.cam_pos_offset.from_json(snapshot["nerf"].at("cam_pos_offset"));
+            if (snapshot["nerf"].contains("cam_rot_offset")) m_nerf.training.cam_rot_offset.from_json(snapshot["nerf"].at("cam_rot_offset"));
+            if (snapshot["nerf"].contains("extra_dims_opt")) m_nerf.training.extra_dims_opt.from_json(snapshot["nerf"].at("extra_dims_opt"));
             m_nerf.training.update_transforms();
             m_nerf.training.update_extra_dims();
         }
@@ -54,7 +54,6 @@ NGP_NAMESPACE_BEGIN
 
 // Finest number of steps per unit length.
 inline constexpr __host__ __device__ uint32_t NERF_STEPS()    { return 1024; }
-inline constexpr __host__ __device__ uint32_t NERF_CASCADES() { return 8;    }
 inline constexpr __device__ float SQRT3() { return 1.73205080757f; }
 
 /**
@@ -84,13 +83,6 @@ inline constexpr __device__ uint32_t N_MAX_RANDOM_SAMPLES_PER_RAY() {
     return 16;
 }
 
-/**
- * Any alpha below this is considered "invisible" and is thus culled away.
- */
-inline constexpr __host__ __device__ float NERF_MIN_OPTICAL_THICKNESS() {
-    return 0.01f;
-}
-
 static constexpr uint32_t MARCH_ITER = 10000;
 static constexpr uint32_t MIN_STEPS_INBETWEEN_COMPACTION = 1;
 static constexpr uint32_t MAX_STEPS_INBETWEEN_COMPACTION = 8;
@@ -2720,11 +2712,10 @@ void Testbed::Nerf::Training::reset_extra_dims(default_rng_t& rng) {
     uint32_t n_extra_dims = dataset.n_extra_dims();
     std::vector<float> extra_dims_cpu(n_extra_dims * (dataset.n_images + 1)); // n_images + 1 since we use an extra 'slot' for the inference latent code
     float* dst = extra_dims_cpu.data();
-    extra_dims_opt = std::vector<VarAdamOptimizer>(dataset.n_images, VarAdamOptimizer(n_extra_dims, 1e-4f));
+    extra_dims_opt = BatchedAdamOptimizer(dataset.n_images, n_extra_dims, false, 1e-4f);
     for (uint32_t i = 0; i < dataset.n_images; ++i) {
         vec3 light_dir = warp_direction(normalize(dataset.metadata[i].light_dir));
-        extra_dims_opt[i].reset_state();
-        std::vector<float>& optimzer_value = extra_dims_opt[i].variable();
+        float* optimzer_value = extra_dims_opt.variable(i);
         for (uint32_t j = 0; j < n_extra_dims; ++j) {
             if (dataset.has_light_dirs && j < 3) {
                 dst[j] = light_dir[j];
@@ -2740,15 +2731,7 @@ void Testbed::Nerf::Training::reset_extra_dims(default_rng_t& rng) {
 
 void Testbed::Nerf::Training::update_extra_dims() {
     uint32_t n_extra_dims = dataset.n_extra_dims();
-    std::vector<float> extra_dims_cpu(extra_dims_gpu.size());
-    for (uint32_t i = 0; i < extra_dims_opt.size(); ++i) {
-        const std::vector<float>& value = extra_dims_opt[i].variable();
-        for (uint32_t j = 0; j < n_extra_dims; ++j) {
-            extra_dims_cpu[i * n_extra_dims + j] = value[j];
-        }
-    }
-
-    CUDA_CHECK_THROW(cudaMemcpyAsync(extra_dims_gpu.data(), extra_dims_cpu.data(), extra_dims_opt.size() * n_extra_dims * sizeof(float), cudaMemcpyHostToDevice));
+    CUDA_CHECK_THROW(cudaMemcpyAsync(extra_dims_gpu.data(), extra_dims_opt.variables().data(), extra_dims_opt.size() * n_extra_dims * sizeof(float), cudaMemcpyHostToDevice));
 }
 
 const float* Testbed::get_inference_extra_dims(cudaStream_t stream) const {
@@ -2931,9 +2914,9 @@ void Testbed::Nerf::Training::set_camera_extrinsics_rolling_shutter(int frame_id
     dataset.metadata[frame_idx].rolling_shutter = rolling_shutter;
     dataset.update_metadata(frame_idx, frame_idx + 1);
 
-    cam_rot_offset[frame_idx].reset_state();
-    cam_pos_offset[frame_idx].reset_state();
-    cam_exposure[frame_idx].reset_state();
+    cam_rot_offset.reset_state(frame_idx);
+    cam_pos_offset.reset_state(frame_idx);
+    cam_exposure.reset_state(frame_idx);
     update_transforms(frame_idx, frame_idx + 1);
 }
 
@@ -2942,17 +2925,9 @@ void Testbed::Nerf::Training::set_camera_extrinsics(int frame_idx, mat4x3 camera
 }
 
 void Testbed::Nerf::Training::reset_camera_extrinsics() {
-    for (auto&& opt : cam_rot_offset) {
-        opt.reset_state();
-    }
-
-    for (auto&& opt : cam_pos_offset) {
-        opt.reset_state();
-    }
-
-    for (auto&& opt : cam_exposure) {
-        opt.reset_state();
-    }
+    cam_rot_offset.reset_state();
+    cam_pos_offset.reset_state();
+    cam_exposure.reset_state();
 }
 
 void Testbed::Nerf::Training::export_camera_extrinsics(const fs::path& path, bool export_extrinsics_in_quat_format) {
@@ -3031,14 +3006,14 @@ void Testbed::Nerf::Training::update_transforms(int first, int last) {
             dataset.xforms[i + first] = xform;
         }
 
-        mat3 rot = rotmat(cam_rot_offset[i + first].variable());
+        mat3 rot = rotmat(cam_rot_offset.variable_as<vec3>(i + first));
         auto rot_start = rot * mat3(xform.start);
         auto rot_end = rot * mat3(xform.end);
         xform.start = mat4x3(rot_start[0], rot_start[1], rot_start[2], xform.start[3]);
         xform.end = mat4x3(rot_end[0], rot_end[1], rot_end[2], xform.end[3]);
 
-        xform.start[3] += cam_pos_offset[i + first].variable();
-        xform.end[3] += cam_pos_offset[i + first].variable();
+        xform.start[3] += cam_pos_offset.variable_as<vec3>(i + first);
+        xform.end[3] += cam_pos_offset.variable_as<vec3>(i + first);
         transforms[i + first] = xform;
     }
 
@@ -3056,9 +3031,9 @@ void Testbed::load_nerf_post() { // moved the second half of load_nerf here
     m_nerf.training.cam_pos_gradient.resize(m_nerf.training.dataset.n_images, vec3(0.0f));
     m_nerf.training.cam_pos_gradient_gpu.resize_and_copy_from_host(m_nerf.training.cam_pos_gradient);
 
-    m_nerf.training.cam_exposure.resize(m_nerf.training.dataset.n_images, AdamOptimizer<vec3>(1e-3f));
-    m_nerf.training.cam_pos_offset.resize(m_nerf.training.dataset.n_images, AdamOptimizer<vec3>(1e-4f));
-    m_nerf.training.cam_rot_offset.resize(m_nerf.training.dataset.n_images, RotationAdamOptimizer(1e-4f));
+    m_nerf.training.cam_exposure.resize(m_nerf.training.dataset.n_images);
+    m_nerf.training.cam_pos_offset.resize(m_nerf.training.dataset.n_images);
+    m_nerf.training.cam_rot_offset.resize(m_nerf.training.dataset.n_images);
     m_nerf.training.cam_focal_length_offset = AdamOptimizer<vec2>(1e-5f);
 
     m_nerf.training.cam_rot_gradient.resize(m_nerf.training.dataset.n_images, vec3(0.0f));
@@ -3187,8 +3162,16 @@ void Testbed::load_nerf(const fs::path& data_path) {
 }
 
 void Testbed::load_block_nerf_data(const fs::path& path,
-                                   const std::string& block) {
-    m_nerf.training.dataset = ngp::load_block_nerf_data(path, block);
+                                   const std::string& block, int downscale) {
+    load_block_nerf_data(path, ngp::read_block_nerf_frames(path, block),
+                         downscale);
+}
+
+void Testbed::load_block_nerf_data(const fs::path& path,
+                                   const BlockNerfFrames& frames,
+                                   int downscale) {
+    m_nerf.training.dataset = ngp::load_block_nerf_data(path, frames,
+                                                        downscale);
     if (m_nerf_network) {
         // The AABB scale affects network size indirectly. If it changed
         // after loading, we need to reset the previously configured
@@ -3810,19 +3793,10 @@ void Testbed::train_nerf(uint32_t target_batch_size, bool get_loss_scalar,
         std::vector<float> extra_dims_gradient(m_nerf.training.extra_dims_gradient_gpu.size());
         m_nerf.training.extra_dims_gradient_gpu.copy_to_host(extra_dims_gradient);
 
-        // Optimization step
-        for (uint32_t i = 0; i < m_nerf.training.n_images_for_training; ++i) {
-            std::vector<float> gradient(n_extra_dims);
-            for (uint32_t j = 0; j < n_extra_dims; ++j) {
-                gradient[j] = extra_dims_gradient[i * n_extra_dims + j] / LOSS_SCALE;
-            }
-
-            //float l2_reg = 1e-4f;
-            //gradient += m_nerf.training.extra_dims_opt[i].variable() * l2_reg;
-
-            m_nerf.training.extra_dims_opt[i].set_learning_rate(m_optimizer->learning_rate());
-            m_nerf.training.extra_dims_opt[i].step(gradient);
-        }
+        // Optimization step. LOSS_SCALE is a power of two, so scaling by its
+        // reciprocal is exact.
+        m_nerf.training.extra_dims_opt.set_learning_rate(m_optimizer->learning_rate());
+        m_nerf.training.extra_dims_opt.step(extra_dims_gradient.data(), 0, m_nerf.training.n_images_for_training, 1.0f / LOSS_SCALE, 0.0f, &m_thread_pool);
 
         m_nerf.training.update_extra_dims();
     }
@@ -3843,20 +3817,14 @@ void Testbed::train_nerf(uint32_t target_batch_size, bool get_loss_scalar,
 
             // Optimization step
             for (uint32_t i = 0; i < m_nerf.training.n_images_for_training; ++i) {
-                vec3 pos_gradient = m_nerf.training.cam_pos_gradient[i] * per_camera_loss_scale;
-                vec3 rot_gradient = m_nerf.training.cam_rot_gradient[i] * per_camera_loss_scale;
-
-                float l2_reg = m_nerf.training.extrinsic_l2_reg;
-                pos_gradient += m_nerf.training.cam_pos_offset[i].variable() * l2_reg;
-                rot_gradient += m_nerf.training.cam_rot_offset[i].variable() * l2_reg;
-
-                m_nerf.training.cam_pos_offset[i].set_learning_rate(std::max(m_nerf.training.extrinsic_learning_rate * std::pow(0.33f, (float)(m_nerf.training.cam_pos_offset[i].step() / 128)), m_optimizer->learning_rate()/1000.0f));
-                m_nerf.training.cam_rot_offset[i].set_learning_rate(std::max(m_nerf.training.extrinsic_learning_rate * std::pow(0.33f, (float)(m_nerf.training.cam_rot_offset[i].step() / 128)), m_optimizer->learning_rate()/1000.0f));
-
-                m_nerf.training.cam_pos_offset[i].step(pos_gradient);
-                m_nerf.training.cam_rot_offset[i].step(rot_gradient);
+                m_nerf.training.cam_pos_offset.set_learning_rate(i, std::max(m_nerf.training.extrinsic_learning_rate * std::pow(0.33f, (float)(m_nerf.training.cam_pos_offset.step(i) / 128)), m_optimizer->learning_rate()/1000.0f));
+                m_nerf.training.cam_rot_offset.set_learning_rate(i, std::max(m_nerf.training.extrinsic_learning_rate * std::pow(0.33f, (float)(m_nerf.training.cam_rot_offset.step(i) / 128)), m_optimizer->learning_rate()/1000.0f));
             }
 
+            float l2_reg = m_nerf.training.extrinsic_l2_reg;
+            m_nerf.training.cam_pos_offset.step((const float*)m_nerf.training.cam_pos_gradient.data(), 0, m_nerf.training.n_images_for_training, per_camera_loss_scale, l2_reg, &m_thread_pool);
+            m_nerf.training.cam_rot_offset.step((const float*)m_nerf.training.cam_rot_gradient.data(), 0, m_nerf.training.n_images_for_training, per_camera_loss_scale, l2_reg, &m_thread_pool);
+
             m_nerf.training.update_transforms();
         }
 
@@ -3886,16 +3854,11 @@ void Testbed::train_nerf(uint32_t target_batch_size, bool get_loss_scalar,
             vec3 mean_exposure = vec3(0.0f);
 
             // Optimization step
-            for (uint32_t i = 0; i < m_nerf.training.n_images_for_training; ++i) {
-                vec3 gradient = m_nerf.training.cam_exposure_gradient[i] * per_camera_loss_scale;
+            m_nerf.training.cam_exposure.set_learning_rate(m_optimizer->learning_rate());
+            m_nerf.training.cam_exposure.step((const float*)m_nerf.training.cam_exposure_gradient.data(), 0, m_nerf.training.n_images_for_training, per_camera_loss_scale, m_nerf.training.exposure_l2_reg, &m_thread_pool);
 
-                float l2_reg = m_nerf.training.exposure_l2_reg;
-                gradient += m_nerf.training.cam_exposure[i].variable() * l2_reg;
-
-                m_nerf.training.cam_exposure[i].set_learning_rate(m_optimizer->learning_rate());
-                m_nerf.training.cam_exposure[i].step(gradient);
-
-                mean_exposure += m_nerf.training.cam_exposure[i].variable();
+            for (uint32_t i = 0; i < m_nerf.training.n_images_for_training; ++i) {
+                mean_exposure += m_nerf.training.cam_exposure.variable_as<vec3>(i);
             }
 
             mean_exposure /= m_nerf.training.n_images_for_training;
@@ -3903,7 +3866,7 @@ void Testbed::train_nerf(uint32_t target_batch_size, bool get_loss_scalar,
             // Renormalize
             std::vector<vec3> cam_exposures(m_nerf.training.n_images_for_training);
             for (uint32_t i = 0; i < m_nerf.training.n_images_for_training; ++i) {
-                cam_exposures[i] = m_nerf.training.cam_exposure[i].variable() -= mean_exposure;
+                cam_exposures[i] = m_nerf.training.cam_exposure.variable_as<vec3>(i) -= mean_exposure;
             }
 
             CUDA_CHECK_THROW(cudaMemcpyAsync(m_nerf.training.cam_exposure_gpu.data(), cam_exposures.data(), m_nerf.training.n_images_for_training * sizeof(vec3), cudaMemcpyHostToDevice, stream));
@@ -4239,4 +4202,82 @@ int Testbed::find_best_training_view(int default_view) {
     return bestimage;
 }
 
+/**
+ * Saves the network with its outputs at random positions in the scene and
+ * random directions, as references for the CPU network.
+ */
+void Testbed::save_query_reference(const fs::path& path, uint32_t n_points) {
+    if (!m_nerf_network) {
+        throw std::runtime_error{"No NeRF network to query."};
+    }
+    if (m_nerf_network->n_extra_dims() > 0) {
+        throw std::runtime_error{"The CPU network has no extra dims."};
+    }
+
+    uint32_t n = next_multiple(n_points, tcnn::batch_size_granularity);
+    default_rng_t rng{m_seed};
+    std::vector<NerfCoordinate> coords_cpu;
+    std::vector<float> positions, directions;
+    coords_cpu.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        vec3 pos = m_aabb.min + m_aabb.diag() * vec3(rng.next_float(),
+                                                     rng.next_float(),
+                                                     rng.next_float());
+        vec3 dir;
+        do {
+            dir = vec3(rng.next_float(), rng.next_float(), rng.next_float());
+            dir = dir * 2.0f - vec3(1.0f);
+        } while (length2(dir) > 1.0f || length2(dir) < 1e-4f);
+        dir = normalize(dir);
+
+        coords_cpu.emplace_back(pos, warp_direction(dir), 0.0f);
+        positions.insert(positions.end(), { pos.x, pos.y, pos.z });
+        directions.insert(directions.end(), { dir.x, dir.y, dir.z });
+    }
+
+    uint32_t padded_output_width = m_nerf_network->padded_output_width();
+    GPUMemory<NerfCoordinate> coords(n);
+    GPUMemory<network_precision_t> rgbsigma(padded_output_width * n);
+    coords.copy_from_host(coords_cpu);
+    GPUMatrix<float> coords_matrix((float*)coords.data(),
+                                   sizeof(NerfCoordinate) / sizeof(float), n);
+    GPUMatrix<network_precision_t> rgbsigma_matrix(rgbsigma.data(),
+                                                   padded_output_width, n);
+    m_nerf_network->inference_mixed_precision(m_stream.get(), coords_matrix,
+                                              rgbsigma_matrix);
+    CUDA_CHECK_THROW(cudaStreamSynchronize(m_stream.get()));
+
+    std::vector<network_precision_t> rgbsigma_cpu(rgbsigma.size());
+    rgbsigma.copy_to_host(rgbsigma_cpu);
+    std::vector<float> rgbd(n * 4);
+    for (uint32_t i = 0; i < n; ++i) {
+        for (uint32_t j = 0; j < 4; ++j) {
+            rgbd[i * 4 + j] = (float)rgbsigma_cpu[i * padded_output_width + j];
+        }
+    }
+
+    auto hg_enc = dynamic_cast<GridEncoding<network_precision_t>*>(
+            m_encoding.get());
+
+    nlohmann::json reference = m_network_config;
+    reference["snapshot"] = m_trainer->serialize(false);
+    reference["snapshot"]["mode"] = to_string(m_testbed_mode);
+    reference["snapshot"]["nerf"]["dataset"] = m_nerf.training.dataset;
+
+    nlohmann::json& queries = reference["query_reference"];
+    queries["positions"] = SnapshotCodec::to_json_binary(
+            positions.data(), positions.size() * sizeof(float));
+    queries["directions"] = SnapshotCodec::to_json_binary(
+            directions.data(), directions.size() * sizeof(float));
+    queries["rgbd"] = SnapshotCodec::to_json_binary(
+            rgbd.data(), rgbd.size() * sizeof(float));
+    queries["max_level"] = hg_enc ? hg_enc->max_level() : 1.0f;
+
+    std::ofstream f{native_string(path), std::ios::out | std::ios::binary};
+    nlohmann::json::to_msgpack(reference, f);
+
+    LOG(INFO) << "Saved " << n << " query references to '" << path.str()
+              << "'.";
+}
+
 NGP_NAMESPACE_END
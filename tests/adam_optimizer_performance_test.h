@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   adam_optimizer_performance_test.h
+ *  @brief  Measures one camera update step of 100k cameras with per-camera
+ *          optimizers and with BatchedAdamOptimizer.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/adam_optimizer.h>
+#include <neural-graphics-primitives/thread_pool.h>
+
+#include <json/json.hpp>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+class AdamOptimizerPerformanceTest : public cl::Test {
+protected:
+	static constexpr size_t N_CAMERAS = 100000;
+	static constexpr int N_STEPS = 20;
+
+	// Returns the milliseconds per step of `f`.
+	template <typename F>
+	static double milliseconds_per_step(const F& f) {
+		cl::Timer timer;
+		timer.Start();
+		for (int step = 0; step < N_STEPS; ++step) {
+			f();
+		}
+		timer.Stop();
+		return 1e3 * timer.elapsed_seconds() / N_STEPS;
+	}
+};
+
+TEST_F(AdamOptimizerPerformanceTest, HundredThousandCameras) {
+	const float scale = 0.37f, l2_reg = 1e-4f;
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> uniform{-1.0f, 1.0f};
+	std::vector<vec3> gradient(N_CAMERAS);
+	for (vec3& g : gradient) {
+		g = vec3(uniform(rng), uniform(rng), uniform(rng));
+	}
+
+	std::vector<AdamOptimizer<vec3>> positions(N_CAMERAS, AdamOptimizer<vec3>(1e-4f));
+	std::vector<RotationAdamOptimizer> rotations(N_CAMERAS, RotationAdamOptimizer(1e-4f));
+	BatchedAdamOptimizer batched_positions(N_CAMERAS, 3, false, 1e-4f);
+	BatchedAdamOptimizer batched_rotations(N_CAMERAS, 3, true, 1e-4f);
+	ThreadPool pool;
+
+	// The update of the extrinsics as done before BatchedAdamOptimizer.
+	auto per_camera_positions = [&]() {
+		for (size_t i = 0; i < N_CAMERAS; ++i) {
+			positions[i].step(gradient[i] * scale + positions[i].variable() * l2_reg);
+		}
+	};
+	auto per_camera_rotations = [&]() {
+		for (size_t i = 0; i < N_CAMERAS; ++i) {
+			rotations[i].step(gradient[i] * scale + rotations[i].variable() * l2_reg);
+		}
+	};
+	auto batched = [&](BatchedAdamOptimizer& optimizer, ThreadPool* p) {
+		return [&optimizer, &gradient, p, scale, l2_reg]() {
+			optimizer.step(&gradient[0].x, 0, N_CAMERAS, scale, l2_reg, p);
+		};
+	};
+
+	const double p1 = milliseconds_per_step(per_camera_positions);
+	const double p2 = milliseconds_per_step(batched(batched_positions, nullptr));
+	const double p3 = milliseconds_per_step(batched(batched_positions, &pool));
+	const double r1 = milliseconds_per_step(per_camera_rotations);
+	const double r2 = milliseconds_per_step(batched(batched_rotations, nullptr));
+	const double r3 = milliseconds_per_step(batched(batched_rotations, &pool));
+
+	// Snapshot size of the position offsets, as msgpack.
+	nlohmann::json legacy = positions, binary = batched_positions;
+	const size_t legacy_bytes = nlohmann::json::to_msgpack(legacy).size();
+	const size_t binary_bytes = nlohmann::json::to_msgpack(binary).size();
+
+	printf("\n");
+	printf("100k cameras, ms/step             Positions   Rotations\n");
+	printf("-----------------------------------------------------------\n");
+	printf("Per-camera optimizers              %10.2f  %10.2f\n", p1, r1);
+	printf("BatchedAdamOptimizer, 1 thread     %10.2f  %10.2f\n", p2, r2);
+	printf("BatchedAdamOptimizer, thread pool  %10.2f  %10.2f\n", p3, r3);
+	printf("-----------------------------------------------------------\n");
+	printf("Position state, per-camera JSON    %10.2f MB\n", legacy_bytes / 1e6);
+	printf("Position state, binary             %10.2f MB\n", binary_bytes / 1e6);
+	printf("-----------------------------------------------------------\n");
+	printf("\n");
+}
+
+NGP_NAMESPACE_END
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   adam_optimizer_test.h
+ *  @brief  Checks that BatchedAdamOptimizer is bitwise equivalent to stepping
+ *          one AdamOptimizer, VarAdamOptimizer or RotationAdamOptimizer per
+ *          camera.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/adam_optimizer.h>
+#include <neural-graphics-primitives/thread_pool.h>
+
+#include <json/json.hpp>
+
+#include "codelibrary/base/testing.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+class AdamOptimizerTest : public cl::Test {
+protected:
+	// More cameras than one chunk of BatchedAdamOptimizer::step.
+	static constexpr size_t N_CAMERAS = 10000;
+	static constexpr int N_STEPS = 20;
+
+	// Uniform gradients in [-1, 1], `dims` floats per camera.
+	static std::vector<float> random_gradient(std::mt19937& rng, size_t n, uint32_t dims) {
+		std::uniform_real_distribution<float> uniform{-1.0f, 1.0f};
+		std::vector<float> gradient(n * dims);
+		for (float& g : gradient) {
+			g = uniform(rng);
+		}
+		return gradient;
+	}
+
+	// The learning rate schedule of the camera extrinsics, which differs
+	// between cameras as soon as they were stepped a different number of times.
+	static float learning_rate(uint32_t step) {
+		return std::max(1e-3f * std::pow(0.33f, (float)(step / 8)), 1e-6f);
+	}
+
+	static bool bitwise_equal(const float* a, const float* b, uint32_t n) {
+		return std::memcmp(a, b, n * sizeof(float)) == 0;
+	}
+
+	// Compares the state of a scalar optimizer, read from its JSON, to the
+	// state of optimizer i of the batch.
+	template <typename Optimizer>
+	static bool same_state(const Optimizer& scalar, const BatchedAdamOptimizer& batched, size_t i) {
+		nlohmann::json j;
+		scalar.to_json(j);
+		if (j.at("iter").get<uint32_t>() != batched.step(i)) {
+			return false;
+		}
+
+		uint32_t dims = batched.dims();
+		std::vector<float> first(dims), second(dims), variable(dims);
+		for (uint32_t d = 0; d < dims; ++d) {
+			first[d] = j.at("first_moment").at(d).get<float>();
+			second[d] = j.at("second_moment").at(d).get<float>();
+			variable[d] = j.at("variable").at(d).get<float>();
+		}
+		return bitwise_equal(first.data(), batched.first_moment(i), dims) &&
+		       bitwise_equal(second.data(), batched.second_moment(i), dims) &&
+		       bitwise_equal(variable.data(), batched.variable(i), dims);
+	}
+
+	// The range of cameras stepped at `step`: all of them, except every third
+	// step, which only steps a window, so that the iteration counters differ.
+	static void step_range(int step, size_t* begin, size_t* end) {
+		*begin = 0;
+		*end = N_CAMERAS;
+		if (step % 3 == 2) {
+			*begin = N_CAMERAS / 4 + step;
+			*end = N_CAMERAS / 2 + 7 * step;
+		}
+	}
+
+	ThreadPool m_pool;
+};
+
+TEST_F(AdamOptimizerTest, Vec3) {
+	// The update of the exposure and of the position offsets: scaled gradients
+	// with L2 regularization, stepped on the thread pool.
+	const float scale = 0.37f, l2_reg = 1e-4f;
+
+	std::vector<AdamOptimizer<vec3>> scalar(N_CAMERAS, AdamOptimizer<vec3>(1e-4f));
+	BatchedAdamOptimizer batched(N_CAMERAS, 3, false, 1e-4f);
+
+	std::mt19937 rng;
+	for (int step = 0; step < N_STEPS; ++step) {
+		size_t begin, end;
+		step_range(step, &begin, &end);
+		std::vector<float> gradient = random_gradient(rng, end - begin, 3);
+
+		for (size_t i = begin; i < end; ++i) {
+			const float* g = gradient.data() + (i - begin) * 3;
+			vec3 scalar_gradient = vec3(g[0], g[1], g[2]) * scale;
+			scalar_gradient += scalar[i].variable() * l2_reg;
+			scalar[i].set_learning_rate(learning_rate(scalar[i].step()));
+			scalar[i].step(scalar_gradient);
+
+			batched.set_learning_rate(i, learning_rate(batched.step(i)));
+		}
+		batched.step(gradient.data(), begin, end, scale, l2_reg, &m_pool);
+	}
+
+	for (size_t i = 0; i < N_CAMERAS; ++i) {
+		ASSERT(same_state(scalar[i], batched, i));
+		ASSERT(bitwise_equal(&scalar[i].variable()[0], &batched.variable_as<vec3>(i)[0], 3));
+	}
+}
+
+TEST_F(AdamOptimizerTest, Rotation) {
+	const float scale = 2.5f, l2_reg = 1e-3f;
+
+	std::vector<RotationAdamOptimizer> scalar(N_CAMERAS, RotationAdamOptimizer(1e-4f));
+	BatchedAdamOptimizer batched(N_CAMERAS, 3, true, 1e-4f);
+
+	std::mt19937 rng;
+	for (int step = 0; step < N_STEPS; ++step) {
+		size_t begin, end;
+		step_range(step, &begin, &end);
+		std::vector<float> gradient = random_gradient(rng, end - begin, 3);
+
+		for (size_t i = begin; i < end; ++i) {
+			const float* g = gradient.data() + (i - begin) * 3;
+			vec3 scalar_gradient = vec3(g[0], g[1], g[2]) * scale;
+			scalar_gradient += scalar[i].variable() * l2_reg;
+			scalar[i].set_learning_rate(learning_rate(scalar[i].step()));
+			scalar[i].step(scalar_gradient);
+
+			batched.set_learning_rate(i, learning_rate(batched.step(i)));
+		}
+		batched.step(gradient.data(), begin, end, scale, l2_reg, &m_pool);
+	}
+
+	for (size_t i = 0; i < N_CAMERAS; ++i) {
+		ASSERT(same_state(scalar[i], batched, i));
+	}
+}
+
+TEST_F(AdamOptimizerTest, Var) {
+	// The update of the latent codes, without regularization and on a single
+	// thread.
+	const uint32_t dims = 5;
+	const float scale = 1.0f / 128.0f;
+
+	std::vector<VarAdamOptimizer> scalar(N_CAMERAS, VarAdamOptimizer(dims, 1e-4f));
+	BatchedAdamOptimizer batched(N_CAMERAS, dims, false, 1e-4f);
+
+	std::mt19937 rng;
+	for (int step = 0; step < N_STEPS; ++step) {
+		std::vector<float> gradient = random_gradient(rng, N_CAMERAS, dims);
+
+		for (size_t i = 0; i < N_CAMERAS; ++i) {
+			std::vector<float> scalar_gradient(dims);
+			for (uint32_t d = 0; d < dims; ++d) {
+				scalar_gradient[d] = gradient[i * dims + d] / 128.0f;
+			}
+			scalar[i].set_learning_rate(1e-3f);
+			scalar[i].step(scalar_gradient);
+		}
+		batched.set_learning_rate(1e-3f);
+		batched.step(gradient.data(), 0, N_CAMERAS, scale);
+	}
+
+	for (size_t i = 0; i < N_CAMERAS; ++i) {
+		ASSERT(same_state(scalar[i], batched, i));
+	}
+}
+
+TEST_F(AdamOptimizerTest, Serialization) {
+	std::vector<AdamOptimizer<vec3>> scalar(100, AdamOptimizer<vec3>(1e-3f));
+	BatchedAdamOptimizer batched(100, 3, false, 1e-3f);
+
+	std::mt19937 rng;
+	for (int step = 0; step < 5; ++step) {
+		std::vector<float> gradient = random_gradient(rng, 100, 3);
+		for (size_t i = 0; i < 100; ++i) {
+			const float* g = gradient.data() + i * 3;
+			scalar[i].step(vec3(g[0], g[1], g[2]));
+		}
+		batched.step(gradient.data(), 0, 100);
+	}
+
+	// The binary state survives a msgpack round trip.
+	nlohmann::json j;
+	batched.to_json(j);
+	BatchedAdamOptimizer loaded;
+	loaded.from_json(nlohmann::json::from_msgpack(nlohmann::json::to_msgpack(j)));
+	ASSERT_EQ(loaded.size(), 100);
+	ASSERT_EQ(loaded.dims(), 3);
+	for (size_t i = 0; i < 100; ++i) {
+		ASSERT(same_state(scalar[i], loaded, i));
+	}
+
+	// Snapshots of the per-camera optimizers still load.
+	nlohmann::json legacy = nlohmann::json::array();
+	for (const auto& opt : scalar) {
+		nlohmann::json o;
+		opt.to_json(o);
+		legacy.push_back(o);
+	}
+	BatchedAdamOptimizer converted;
+	converted.from_json(legacy);
+	ASSERT_EQ(converted.size(), 100);
+	for (size_t i = 0; i < 100; ++i) {
+		ASSERT(same_state(scalar[i], converted, i));
+	}
+}
+
+NGP_NAMESPACE_END
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   all_tests.h
+ *  @brief  All tests of instant-ngp, run by tests/main.cu.
+ */
+
+#pragma once
+
+#include "adam_optimizer_performance_test.h"
+#include "adam_optimizer_test.h"
+#include "cpu_nerf_network_performance_test.h"
+#include "cpu_nerf_network_test.h"
+#include "nerf_transforms_test.h"
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   cpu_nerf_network_performance_test.h
+ *  @brief  Measures the points per second of CpuNerfNetwork for color and
+ *          density queries, per weight precision.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/cpu_nerf_network.h>
+
+#include <filesystem/path.h>
+
+#include <json/json.hpp>
+
+#include "codelibrary/base/testing.h"
+#include "codelibrary/base/timer.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+class CpuNerfNetworkPerformanceTest : public cl::Test {
+protected:
+	static constexpr size_t N_POINTS = 1 << 18;
+
+	// Returns the million points per second of `f`, which queries N_POINTS.
+	// Color queries run both networks, density queries only the first one.
+	template <typename F>
+	static double million_points_per_second(const F& f) {
+		cl::Timer timer;
+		timer.Start();
+		f();
+		timer.Stop();
+		return N_POINTS / timer.elapsed_seconds() / 1e6;
+	}
+};
+
+TEST_F(CpuNerfNetworkPerformanceTest, Throughput) {
+	nlohmann::json config = CpuNerfNetwork::load_network_config(
+		fs::path{NGP_TEST_DATA_DIR} / "cpu_nerf_network" / "reference.msgpack"
+	);
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+	std::normal_distribution<float> normal;
+	std::vector<float> positions(N_POINTS * 3), directions(N_POINTS * 3);
+	for (size_t i = 0; i < N_POINTS; ++i) {
+		vec3 dir = normalize(vec3(normal(rng), normal(rng), normal(rng)));
+		for (int d = 0; d < 3; ++d) {
+			positions[i * 3 + d] = uniform(rng);
+			directions[i * 3 + d] = dir[d];
+		}
+	}
+	std::vector<float> rgbd(N_POINTS * 4), density(N_POINTS);
+
+	printf("\n");
+	printf("2^18 points, M points/s  Color, 1 thread  Color  Density   MB\n");
+	printf("-----------------------------------------------------------------\n");
+	const std::pair<ECpuWeightPrecision, const char*> precisions[] = {
+		{ECpuWeightPrecision::Float, "fp32"},
+		{ECpuWeightPrecision::Half, "fp16"},
+		{ECpuWeightPrecision::Int8, "int8"},
+	};
+	for (const auto& precision : precisions) {
+		CpuNerfNetwork single{config, precision.first, 1};
+		CpuNerfNetwork network{config, precision.first};
+
+		const double c1 = million_points_per_second([&]() {
+			single.inference(positions.data(), directions.data(), N_POINTS, rgbd.data());
+		});
+		const double c2 = million_points_per_second([&]() {
+			network.inference(positions.data(), directions.data(), N_POINTS, rgbd.data());
+		});
+		const double d2 = million_points_per_second([&]() {
+			network.density(positions.data(), N_POINTS, density.data());
+		});
+		printf("%-22s %15.2f %6.2f %8.2f %6.2f\n", precision.second, c1, c2, d2, network.n_bytes() / 1e6);
+	}
+	printf("-----------------------------------------------------------------\n");
+	printf("\n");
+}
+
+NGP_NAMESPACE_END
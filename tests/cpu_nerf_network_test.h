@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   cpu_nerf_network_test.h
+ *  @brief  Checks the outputs of CpuNerfNetwork against the query references
+ *          of a small synthetic snapshot, for fp32, fp16 and int8 weights.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/cpu_nerf_network.h>
+
+#include <filesystem/path.h>
+
+#include <json/json.hpp>
+
+#include "codelibrary/base/testing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+class CpuNerfNetworkTest : public cl::Test {
+protected:
+	// A hash-grid NeRF in the format of Testbed::save_query_reference(): 8
+	// levels of 2 features with a table size of 2^10 (the coarse levels are
+	// dense), a density network of one hidden layer and an rgb network of two,
+	// 16 neurons wide, with fp32 params. The references of its 512 points are
+	// the raw network outputs, evaluated in double precision. A snapshot saved
+	// with --query-reference on a GPU has the same layout.
+	static fs::path reference() {
+		return fs::path{NGP_TEST_DATA_DIR} / "cpu_nerf_network" / "reference.msgpack";
+	}
+
+	static std::vector<float> read_floats(const nlohmann::json& queries, const char* key) {
+		const auto& bytes = queries[key].get_binary();
+		std::vector<float> values(bytes.size() / sizeof(float));
+		std::memcpy(values.data(), bytes.data(), values.size() * sizeof(float));
+		return values;
+	}
+
+	// Evaluates the reference points with `precision` and returns the number
+	// of outputs farther than `absolute + relative * |expected|` from the
+	// references. The points are split over several batches and threads.
+	static size_t n_failed(ECpuWeightPrecision precision, float absolute, float relative, float* max_error) {
+		nlohmann::json config = CpuNerfNetwork::load_network_config(reference());
+		const nlohmann::json& queries = config["query_reference"];
+		std::vector<float> positions = read_floats(queries, "positions");
+		std::vector<float> directions = read_floats(queries, "directions");
+		std::vector<float> expected = read_floats(queries, "rgbd");
+		size_t n = positions.size() / 3;
+
+		CpuNerfNetwork network{config, precision, 4};
+		network.max_level = queries.value("max_level", 1.0f);
+
+		std::vector<float> rgbd(n * 4), density(n);
+		network.inference(positions.data(), directions.data(), n, rgbd.data());
+		network.density(positions.data(), n, density.data());
+
+		size_t n_failed = 0;
+		*max_error = 0.0f;
+		for (size_t i = 0; i < rgbd.size(); ++i) {
+			float error = std::abs(rgbd[i] - expected[i]);
+			*max_error = std::max(*max_error, error);
+			if (!(error <= absolute + relative * std::abs(expected[i]))) {
+				++n_failed;
+			}
+		}
+		// The density-only path runs the same density network.
+		for (size_t i = 0; i < n; ++i) {
+			if (density[i] != rgbd[i * 4 + 3]) {
+				++n_failed;
+			}
+		}
+		return n_failed;
+	}
+};
+
+TEST_F(CpuNerfNetworkTest, Float) {
+	// Only the summation order and the float arithmetic differ from the
+	// references, by up to about 5e-7.
+	float max_error;
+	ASSERT_EQ(n_failed(ECpuWeightPrecision::Float, 1e-5f, 1e-5f, &max_error), 0);
+}
+
+TEST_F(CpuNerfNetworkTest, Half) {
+	// Rounding the weights and the grid to fp16 moves the outputs by up to
+	// about 2e-4 on this snapshot.
+	float max_error;
+	ASSERT_EQ(n_failed(ECpuWeightPrecision::Half, 2e-3f, 2e-3f, &max_error), 0);
+	ASSERT(max_error > 0.0f);
+}
+
+TEST_F(CpuNerfNetworkTest, Int8) {
+	// The grid codes of a level step by 1/255 of its range (about 4e-3 here,
+	// as the features are in [-0.5, 0.5]), and the weights of a matrix row
+	// by 1/127 of its largest weight. This moves the outputs by up to about
+	// 3e-3. A grid decoded without its level minimum moves them by 0.36, and
+	// one decoded with a 5% wrong scale by 0.04.
+	float max_error;
+	ASSERT_EQ(n_failed(ECpuWeightPrecision::Int8, 1e-2f, 1e-2f, &max_error), 0);
+	ASSERT(max_error > 0.0f);
+}
+
+NGP_NAMESPACE_END
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   main.cu
+ *  @brief  Runs the tests of instant-ngp. The tests that need data read it
+ *          from NGP_TEST_DATA_DIR, tests/data in the source tree.
+ */
+
+#include "all_tests.h"
+
+int main() {
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2020-2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+/** @file   nerf_transforms_test.h
+ *  @brief  Checks that streaming a transforms.json file with
+ *          parse_nerf_transforms reads the same cameras as parsing it into a
+ *          JSON DOM, as load_nerf did before.
+ */
+
+#pragma once
+
+#include <neural-graphics-primitives/common.h>
+#include <neural-graphics-primitives/nerf_loader.h>
+#include <neural-graphics-primitives/nerf_transforms.h>
+
+#include <filesystem/path.h>
+
+#include <json/json.hpp>
+
+#include <natural_sort.hpp>
+
+#include "codelibrary/base/testing.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+NGP_NAMESPACE_BEGIN
+
+class NerfTransformsTest : public cl::Test {
+protected:
+	// The fixtures have no images; the culling of blurry frames sees all images
+	// but those named "*missing*".
+	static bool exists(const std::string& path) {
+		return path.find("missing") == std::string::npos;
+	}
+
+	// A fixed resolution for the field of view entries.
+	static ivec2 resolution() {
+		return {1920, 1080};
+	}
+
+	static fs::path fixture(const std::string& name) {
+		return fs::path{NGP_TEST_DATA_DIR} / "nerf_transforms" / name;
+	}
+
+	static NerfDataset new_dataset(size_t n_images) {
+		NerfDataset dataset{};
+		dataset.scale = NERF_SCALE;
+		dataset.offset = {0.5f, 0.5f, 0.5f};
+		dataset.from_mitsuba = false;
+		dataset.n_images = n_images;
+		dataset.xforms.resize(n_images);
+		dataset.metadata.resize(n_images);
+		return dataset;
+	}
+
+	static std::array<float, 12> rows(const nlohmann::json& matrix) {
+		std::array<float, 12> result;
+		for (int m = 0; m < 3; ++m) {
+			for (int n = 0; n < 4; ++n) {
+				result[m * 4 + n] = float(matrix[m][n]);
+			}
+		}
+		return result;
+	}
+
+	// The cameras of a transforms file, read from a JSON DOM like load_nerf
+	// did before the streaming parser.
+	static NerfDataset load_dom(const fs::path& path, std::vector<std::string>* depth_paths) {
+		std::ifstream f{native_string(path)};
+		nlohmann::json json = nlohmann::json::parse(f, nullptr, true, true);
+		auto& frames = json["frames"];
+
+		float sharpness_discard_threshold = json.value("sharpness_discard_threshold", 0.0f);
+
+		std::sort(frames.begin(), frames.end(), [](const auto& frame1, const auto& frame2) {
+			return SI::natural::compare<std::string>(frame1["file_path"], frame2["file_path"]);
+		});
+
+		for (auto&& frame : frames) {
+			frame["file_path"] = replace_all(frame["file_path"], "\\", "/");
+		}
+
+		if (json.contains("n_frames")) {
+			size_t cull_idx = std::min(frames.size(), (size_t)json["n_frames"]);
+			frames.get_ptr<nlohmann::json::array_t*>()->resize(cull_idx);
+		}
+
+		if (frames[0].contains("sharpness")) {
+			auto frames_copy = frames;
+			frames.clear();
+
+			const int neighborhood_size = 3;
+			for (int i = 0; i < (int)frames_copy.size(); ++i) {
+				float mean_sharpness = 0.0f;
+				int mean_start = std::max(0, i-neighborhood_size);
+				int mean_end = std::min(i + neighborhood_size, (int)frames_copy.size() - 1);
+				for (int j = mean_start; j < mean_end; ++j) {
+					mean_sharpness += float(frames_copy[j].value("sharpness", 1.0));
+				}
+
+				mean_sharpness /= (mean_end - mean_start);
+
+				if (exists(frames_copy[i]["file_path"]) && frames_copy[i].value("sharpness", 1.0) > sharpness_discard_threshold * mean_sharpness) {
+					frames.emplace_back(frames_copy[i]);
+				}
+			}
+		}
+
+		NerfDataset dataset = new_dataset(frames.size());
+		read_nerf_scene(json, dataset);
+		const TrainingImageMetadata lens = read_nerf_lens(json);
+		for (size_t i = 0; i < frames.size(); ++i) {
+			const auto& frame = frames[i];
+			dataset.paths.emplace_back(frame["file_path"]);
+			depth_paths->emplace_back(frame.contains("depth_path") ? frame["depth_path"] : "");
+
+			const nlohmann::json& jsonmatrix_start = frame.contains("transform_matrix_start") ? frame["transform_matrix_start"] : frame["transform_matrix"];
+			const nlohmann::json& jsonmatrix_end = frame.contains("transform_matrix_end") ? frame["transform_matrix_end"] : jsonmatrix_start;
+			read_nerf_camera(json, lens, frame, rows(jsonmatrix_start), rows(jsonmatrix_end), resolution(), i, dataset);
+		}
+		return dataset;
+	}
+
+	// The cameras of a transforms file, streamed like load_nerf does.
+	static NerfDataset load_sax(const fs::path& path, std::vector<std::string>* depth_paths) {
+		NerfTransforms frames = parse_nerf_transforms(path);
+		frames.sort_and_cull_frames(exists);
+
+		NerfDataset dataset = new_dataset(frames.n_frames());
+		read_nerf_scene(frames.settings, dataset);
+		const TrainingImageMetadata lens = read_nerf_lens(frames.settings);
+		for (size_t i = 0; i < frames.n_frames(); ++i) {
+			dataset.paths.emplace_back(frames.file_paths[i]);
+			depth_paths->emplace_back(frames.has_depth_path[i] ? frames.depth_paths[i] : "");
+			read_nerf_camera(frames.settings, lens, frames.extras[i], frames.xforms_start[i], frames.xforms_end[i], resolution(), i, dataset);
+		}
+		return dataset;
+	}
+
+	template <typename T>
+	static bool bitwise_equal(const T& a, const T& b) {
+		return std::memcmp(&a, &b, sizeof(T)) == 0;
+	}
+
+	// Loads a fixture both ways and compares every camera and scene setting.
+	void check_fixture(const std::string& name, size_t n_frames) {
+		std::vector<std::string> dom_depth_paths, sax_depth_paths;
+		NerfDataset dom = load_dom(fixture(name), &dom_depth_paths);
+		NerfDataset sax = load_sax(fixture(name), &sax_depth_paths);
+
+		ASSERT_EQ(dom.n_images, n_frames);
+		ASSERT_EQ(sax.n_images, n_frames);
+		ASSERT(dom.paths == sax.paths);
+		ASSERT(dom_depth_paths == sax_depth_paths);
+
+		for (size_t i = 0; i < n_frames; ++i) {
+			const TrainingImageMetadata& a = dom.metadata[i];
+			const TrainingImageMetadata& b = sax.metadata[i];
+			ASSERT(bitwise_equal(dom.xforms[i].start, sax.xforms[i].start));
+			ASSERT(bitwise_equal(dom.xforms[i].end, sax.xforms[i].end));
+			ASSERT(bitwise_equal(a.focal_length, b.focal_length));
+			ASSERT(bitwise_equal(a.principal_point, b.principal_point));
+			ASSERT(bitwise_equal(a.rolling_shutter, b.rolling_shutter));
+			ASSERT(a.lens.mode == b.lens.mode);
+			ASSERT(bitwise_equal(a.lens.params, b.lens.params));
+			ASSERT(bitwise_equal(a.light_dir, b.light_dir));
+		}
+
+		ASSERT_EQ(dom.aabb_scale, sax.aabb_scale);
+		ASSERT(bitwise_equal(dom.scale, sax.scale));
+		ASSERT(bitwise_equal(dom.offset, sax.offset));
+		ASSERT(bitwise_equal(dom.up, sax.up));
+		ASSERT(bitwise_equal(dom.render_aabb, sax.render_aabb));
+		ASSERT_EQ(dom.has_light_dirs, sax.has_light_dirs);
+		ASSERT_EQ(dom.n_extra_learnable_dims, sax.n_extra_learnable_dims);
+		ASSERT_EQ(dom.wants_importance_sampling, sax.wants_importance_sampling);
+	}
+};
+
+TEST_F(NerfTransformsTest, Perspective) {
+	// Comments, Windows separators, natural order, "n_frames", culling of
+	// blurry and missing frames, OpenCV distortion, rolling shutter, offsets,
+	// and per-frame focal length, distortion and principal point overrides.
+	check_fixture("perspective.json", 5);
+
+	std::vector<std::string> depth_paths;
+	NerfDataset sax = load_sax(fixture("perspective.json"), &depth_paths);
+	ASSERT_EQ(sax.paths.front(), "images/frame_1.png");
+	ASSERT_EQ(sax.metadata[1].focal_length.x, 1170.0f);
+	ASSERT_EQ(sax.metadata[1].lens.params[0], -0.02f);
+	ASSERT(sax.metadata[1].lens.mode == ELensMode::OpenCV);
+}
+
+TEST_F(NerfTransformsTest, Fisheye) {
+	// Field of view entries, fisheye, equirectangular and f-theta lenses,
+	// motion blur matrices, depth paths, light directions and an aabb.
+	check_fixture("fisheye.json", 3);
+
+	std::vector<std::string> depth_paths;
+	NerfDataset sax = load_sax(fixture("fisheye.json"), &depth_paths);
+	ASSERT(sax.metadata[0].lens.mode == ELensMode::Equirectangular);
+	ASSERT(sax.metadata[1].lens.mode == ELensMode::OpenCVFisheye);
+	ASSERT(sax.metadata[2].lens.mode == ELensMode::FTheta);
+	ASSERT_EQ(depth_paths[0], "./depth/a.png");
+	ASSERT(sax.has_light_dirs);
+	ASSERT(!bitwise_equal(sax.xforms[1].start, sax.xforms[1].end));
+}
+
+NGP_NAMESPACE_END